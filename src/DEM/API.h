@@ -43,6 +43,10 @@ class DEMTracker;
 //            10. Recover sph--mesh contact pairs in restarted sim by mesh name
 //            11. A dry-run to map contact pair file with current clump batch based on cnt points location
 //                  (this is done by fake an initialization with this batch)
+//            12. CPU backend for machines without a GPU: host dT (force calc, collection, integration), host memory
+//                  rather than managed, backend chosen at construction (UseHostContactDetection is its kT part)
+//            13. Compact the kT-to-dT contact buffers (e.g. contact type packed with the geometry IDs, or the IDs sent
+//                  as offsets), as the contact storage policy does for dT's contact arrays
 //////////////////////////////////////////////////////////////
 
 /// Main DEM-Engine solver.
@@ -69,6 +73,16 @@ class DEMSolver {
                                     const std::pair<float, float>& z,
                                     const std::string& dir_exact = "none");
 
+    /// @brief Make the simulation `world' periodic in some directions (by default no direction is periodic).
+    /// @details In a periodic direction, the period is the span of the box instructed with InstructBoxDomainDimension:
+    /// an owner leaving the box from one end re-enters from the other, and spheres near one end are in contact with
+    /// the spheres near the other end. Only sphere--sphere contacts are made across the period; meshes and analytical
+    /// objects have no periodic images. The box should be longer than 4 times the largest sphere radius in a periodic
+    /// direction. InstructBoxDomainBoundingBC adds no walls in periodic directions. Hierarchical and incremental
+    /// binning do not support it yet; host contact detection does. Must be called before initialization.
+    /// @param dirs The periodic directions, any combination of "X", "Y" and "Z" (such as "XY"), or "none".
+    void InstructBoxDomainPeriodic(const std::string& dirs);
+
     /// Instruct if and how we should add boundaries to the simulation world upon initialization. Choose between `none',
     /// `all' (add 6 boundary planes) and `top_open' (add 5 boundary planes and leave the z-directon top open). Also
     /// specifies the material that should be assigned to those bounding boundaries.
@@ -91,8 +105,8 @@ class DEMSolver {
     /// @brief Get the number of kT-reported potential contact pairs.
     /// @return Number of potential contact pairs.
     size_t GetNumContacts() const { return dT->getNumContacts(); }
-    /// Get the current time step size in simulation.
-    double GetTimeStepSize() const { return m_ts_size; }
+    /// Get the current time step size in simulation (with adaptive time stepping, the one in use right now).
+    double GetTimeStepSize() const;
     /// Get the current expand factor in simulation.
     float GetExpandFactor() const;
     /// Set the number of dT steps before it waits for a contact-pair info update from kT.
@@ -107,10 +121,34 @@ class DEMSolver {
     double GetSimTime() const;
     /// Set the simulation time manually.
     void SetSimTime(double time);
-    /// @brief Set the strategy for auto-adapting time step size (NOT implemented, no effect yet).
-    /// @param type "none" or "max_vel" or "int_diff".
+    /// @brief Set the strategy for auto-adapting time step size. The step size starts from the one given by
+    /// SetInitTimeStep, and is re-picked at each kT update: a smaller step takes effect right away, and a larger one at
+    /// the next kT update (so contact margins stay valid).
+    /// @param type "none" (default, constant step size); "max_vel": limit how far the fastest entity travels in a step
+    /// (see SetAdaptiveTimeStepCriteria); "int_diff": same as "max_vel", but also shrink the step when the deepest
+    /// interpenetration (overlap) exceeds a target.
     void SetAdaptiveTimeStepType(const std::string& type);
 
+    /// @brief Set the bounds of the adaptive time step size. The upper bound is further limited by a fraction of the
+    /// Rayleigh critical time step of the clumps' spheres (see SetAdaptiveTimeStepCriteria), if their materials have E
+    /// and nu.
+    /// @param min_ts The smallest step size to use. 0 by default.
+    /// @param max_ts The largest step size to use. Unlimited by default.
+    void SetAdaptiveTimeStepLimits(double min_ts, double max_ts = DEME_HUGE_FLOAT);
+
+    /// @brief Set the criteria the adaptive time step size is picked by.
+    /// @param max_travel_ratio The farthest the fastest entity may travel in a step, as a fraction of the smallest
+    /// sphere radius. Default 0.01.
+    /// @param max_overlap_ratio The deepest overlap allowed, as a fraction of the sphere radius ("int_diff" only).
+    /// Default 0.01.
+    /// @param rayleigh_fraction The step size never exceeds this fraction of the Rayleigh critical time step. Default
+    /// 0.2.
+    /// @param max_growth The most the step size can grow by at a kT update. Default 1.1.
+    void SetAdaptiveTimeStepCriteria(float max_travel_ratio,
+                                     float max_overlap_ratio = 0.01,
+                                     float rayleigh_fraction = 0.2,
+                                     float max_growth = 1.1);
+
     /// @brief Set the time integrator for this simulator.
     /// @param intg "forward_euler" or "extended_taylor" or "centered_difference".
     void SetIntegrator(const std::string& intg);
@@ -143,9 +181,11 @@ class DEMSolver {
 
     /// Explicitly instruct the sizes for the arrays at initialization time. This is useful when the number of owners
     /// tends to change (especially gradually increase) frequently in the simulation, by reducing the need for
-    /// reallocation. Note however, whatever instruction the user gives here it won't affect the correctness of the
-    /// simulation, since if the arrays are not long enough they will always be auto-resized. This is not implemented
-    /// yet :/
+    /// reallocation. The owner arrays are reserved for numOwners entries, and the sphere and contact arrays for a
+    /// proportional number (estimated from the clumps in the system at initialization), so calling UpdateClumps below
+    /// this capacity only appends the new clumps. Note however, whatever instruction the user gives here it won't
+    /// affect the correctness of the simulation, since if the arrays are not long enough they will always be
+    /// auto-resized (and they grow geometrically, so that happens rarely anyway).
     void InstructNumOwners(size_t numOwners) { m_instructed_num_owners = numOwners; }
 
     /// Instruct the solver to use frictonal (history-based) Hertzian contact force model.
@@ -178,8 +218,11 @@ class DEMSolver {
     /// them it into GPU kernels.
     void DisableJitifyMassProperties() { jitify_mass_moi = false; }
 
-    // NOTE: compact force calculation (in the hope to use shared memory) is not implemented
-    void UseCompactForceKernel(bool use_compact);
+    /// Collect contact forces to owners block by block: each block sums its contacts' contributions per owner in
+    /// shared memory, then adds each sum to its owner with one set of atomic operations. As the contact array is sorted
+    /// by (the sphere of) body A, this cuts the atomic operations for clumps and for walls that many spheres touch. It
+    /// has no effect if UseCubForceCollection or SetCollectAccRightAfterForceCalc is used.
+    void UseCompactForceKernel(bool use_compact = true) { use_compact_force_collect = use_compact; }
 
     /// (Explicitly) set the amount by which the radii of the spheres (and the thickness of the boundaries) are expanded
     /// for the purpose of contact detection (safe, and creates false positives). If fix is set to true, then this
@@ -214,6 +257,13 @@ class DEMSolver {
     /// significantly in one kT update cycle.
     void SetExpandSafetyAdder(float vel) { m_expand_base_vel = vel; }
 
+    /// @brief Let kT reuse its contact candidates across contact detection steps, Verlet list-style. Candidates are
+    /// found with an extra skin added to the contact margins; at later steps, kT only refilters them, until some owner
+    /// may have moved (or its margin may have grown) by more than half the skin since they were found. Then it bins
+    /// again. Default is 0, meaning kT bins at every step.
+    /// @param skin Thickness of the skin. A larger one means fewer re-binning steps but more candidates to refilter.
+    void SetCDVerletSkin(float skin);
+
     /// @brief Used to force the solver to error out when there are too many spheres in a bin. A huge number can be used
     /// to discourage this error type.
     /// @param max_sph Max number of spheres in a bin.
@@ -234,6 +284,27 @@ class DEMSolver {
     /// @param num_cnts Error-out contact number.
     void SetErrorOutAvgContacts(float num_cnts) { threshold_error_out_num_cnts = num_cnts; }
 
+    /// @brief Let owners that have been quiescent for a while sleep. A sleeping owner is not integrated, and contacts
+    /// between two sleeping owners are not evaluated (their force is recorded as zero, and their contact history is
+    /// kept). A sleeping owner wakes up when an awake contact partner moves faster than the thresholds, when a contact
+    /// force on it exceeds wake_force_thres, when it changes family, or when its state is set through this API. Owners
+    /// of families with prescribed motions never sleep.
+    /// @param lin_vel_thres An owner is quiescent if its velocity magnitude is below this...
+    /// @param ang_vel_thres ...and its angular velocity magnitude is below this.
+    /// @param n_steps The number of consecutive quiescent time steps before an owner falls asleep.
+    /// @param wake_force_thres A contact force larger than this wakes a sleeping owner up. Infinite by default.
+    void EnableSleeping(float lin_vel_thres,
+                        float ang_vel_thres,
+                        unsigned int n_steps,
+                        float wake_force_thres = DEME_HUGE_FLOAT);
+
+    /// Disable sleeping (it is disabled by default), and wake all owners up.
+    void DisableSleeping();
+
+    /// @brief Get the number of owners that are asleep.
+    /// @return Number of sleeping owners.
+    size_t GetNumSleepingOwners() const { return dT->getNumSleepingOwners(); }
+
     /// @brief Get the current number of contacts each sphere has.
     /// @return Number of contacts.
     float GetAvgSphContacts() const { return kT->stateParams.avgCntsPerSphere; }
@@ -281,6 +352,41 @@ class DEMSolver {
     /// @brief Get the current number of bins (for contact detection). Must be called from synchronized stance.
     /// @return Number of bins.
     size_t GetBinNum() { return kT->stateParams.numBins; }
+    /// @brief Enable or disable incremental binning (by default it is off).
+    /// @details With it, kT keeps the sorted bin--sphere pairs of the last binning, and at a CD step re-bins only the
+    /// spheres whose range of touched bins changed, merging their pairs into the kept ones rather than sorting all
+    /// pairs again. It pays off when particles move slowly compared to the bin size. The contact pairs found are the
+    /// same either way.
+    /// @param use Enable or disable.
+    void UseIncrementalBinning(bool use = true) { use_incremental_binning = use; }
+    /// @brief Get the number of spheres kT re-binned in the last CD step. Without incremental binning, or if it could
+    /// not be used (first step, bin size changed, or too many spheres moved), this is all spheres. Must be called from
+    /// synchronized stance.
+    /// @return Number of spheres re-binned.
+    size_t GetNumSpheresRebinned() { return kT->stateParams.numSpheresRebinned; }
+
+    /// @brief Enable or disable hierarchical binning (by default it is off).
+    /// @details With it, bins come in levels: the bins of level l are 2^l times as large as the base bins, and each
+    /// sphere is binned in the finest level whose bins are no smaller than its diameter, so it touches at most 8 bins
+    /// whatever the size ratio of the spheres. Spheres look for contacts with the spheres of the coarser levels by
+    /// querying those levels. Use it for highly polydisperse systems (such as boulders in fines), where a single bin
+    /// size leaves the large spheres touching a great many bins. The contact pairs found are the same either way.
+    /// @param use Enable or disable.
+    void UseHierarchicalBinning(bool use = true) { use_hierarchical_binning = use; }
+
+    /// @brief Run kT's contact detection on host CPU threads rather than on its GPU (by default it is off).
+    /// @details The contact pairs, and the contact history map, are the same as the GPU ones, so dT (which stays on
+    /// its GPU) cannot tell the difference. This frees kT's GPU, and on a machine with many cores and a weak or shared
+    /// GPU it can keep up with dT. Meshes and SetCDVerletSkin are not supported with it yet; incremental and
+    /// hierarchical binning have no effect on it. Must be called before initialization.
+    /// This is not a CPU backend: dT's force calculation, force collection and integration still run on the GPU, the
+    /// arrays are still in managed memory, and the solver still needs a CUDA device.
+    /// @param use Enable or disable.
+    /// @param nThreads Number of host threads to use. 0 means as many as the hardware has.
+    void UseHostContactDetection(bool use = true, unsigned int nThreads = 0) {
+        use_host_contact_detection = use;
+        m_host_cd_num_threads = nThreads;
+    }
 
     /// @brief Set the upper bound of kT update frequency (when it is adjusted automatically).
     /// @details This only affects when the update freq is updated automatically. To manually control the freq, use
@@ -423,6 +529,15 @@ class DEMSolver {
     float3 GetOwnerAcc(bodyID_t ownerID) const;
     /// Get the angular acceleration of a owner
     float3 GetOwnerAngAcc(bodyID_t ownerID) const;
+    /// @brief Get the sum of the forces (in global frame) that an owner got in the last time step from its contacts
+    /// recorded as aggregates (see SetFamilyPairForceRecord).
+    float3 GetOwnerContactForceSum(bodyID_t ownerID) const;
+    /// @brief Get the sum of the torques (about the owner's CoM, in global frame) that an owner got in the last time
+    /// step from its contacts recorded as aggregates (see SetFamilyPairForceRecord).
+    float3 GetOwnerContactTorqueSum(bodyID_t ownerID) const;
+    /// @brief Get the number of an owner's contacts recorded as aggregates (see SetFamilyPairForceRecord) in the last
+    /// time step.
+    unsigned int GetOwnerNumAggregatedContacts(bodyID_t ownerID) const;
     /// @brief Get the family number of a owner.
     /// @param ownerID The owner's ID.
     /// @return The family number.
@@ -451,6 +566,11 @@ class DEMSolver {
     void SetTriNodeRelPos(size_t owner, size_t triID, const std::vector<float3>& new_nodes);
     /// @brief Update the relative positions of the flattened triangle soup.
     void UpdateTriNodeRelPos(size_t owner, size_t triID, const std::vector<float3>& updates);
+    /// @brief Set the relative positions of some nodes of a mesh; only the facets using them are re-sent.
+    void SetTriNodeRelPos(size_t owner,
+                          size_t triID,
+                          const std::vector<size_t>& node_ids,
+                          const std::vector<float3>& new_nodes);
     /// @brief Get a handle for the mesh this tracker is tracking.
     /// @return Pointer to the mesh.
     std::shared_ptr<DEMMeshConnected>& GetCachedMesh(bodyID_t ownerID);
@@ -529,7 +649,7 @@ class DEMSolver {
         return AddClumps(input_type, loc_xyz);
     }
 
-    /// Load a mesh-represented object
+    /// Load a mesh-represented object, from a Wavefront .obj file or a binary .stl file (chosen by file extension)
     std::shared_ptr<DEMMeshConnected> AddWavefrontMeshObject(const std::string& filename,
                                                              const std::shared_ptr<DEMMaterial>& mat,
                                                              bool load_normals = true,
@@ -748,6 +868,18 @@ class DEMSolver {
     /// @param extra_size The thickness of the extra contact margin.
     void SetFamilyExtraMargin(unsigned int N, float extra_size);
 
+    /// @brief Let the owners in a family take a number of substeps per time step (subcycling).
+    /// @details Use it for families that are much stiffer or lighter than the rest, which would otherwise dictate the
+    /// step size of the whole system. Owners in subcycled families are integrated with step size h/n_substeps, and the
+    /// forces of the contacts that involve them are re-calculated at each substep; the other owners advance with step
+    /// size h, feeling the contact forces from the first substep. So the extra cost scales with the number of
+    /// subcycled owners and their contacts. All subcycled families take the same number of substeps. Subcycling can
+    /// not be used with UseCubForceCollection, SetCollectAccRightAfterForceCalc, or a force record policy
+    /// (SetFamilyPairForceRecord or SetDefaultForceRecord), which collects forces in the force calculation kernel.
+    /// @param N Family number.
+    /// @param n_substeps Number of substeps per time step; 1 means the family is not subcycled.
+    void SetFamilySubsteps(unsigned int N, unsigned int n_substeps);
+
     /// @brief Get the owner wildcard's values of a owner.
     /// @param ownerID Owner's ID.
     /// @param name Wildcard's name.
@@ -819,6 +951,31 @@ class DEMSolver {
     /// performance boost if you have only polydisperse spheres, no clumps.
     void SetCollectAccRightAfterForceCalc(bool flag = true) { collect_force_in_force_kernel = flag; }
 
+    /// Calculate contact forces with one kernel per contact type (sphere--sphere, sphere--mesh, sphere--plane etc.),
+    /// each compiled for its type, so that threads in a warp do not diverge on contact types. The contact array is
+    /// split into same-type runs each time it is updated, so this needs contact pairs to be sorted by type (see
+    /// SetSortContactPairs). It may help when there are many contacts of more than one type.
+    void UseContactTypeSpecializedForceKernels(bool flag = true) { use_type_specialized_force_kernels = flag; }
+
+    /// @brief Set how the per-contact torque-only forces and contact points are stored.
+    /// @param policy "full" (default): as float3. "compact": the torque-only forces and the contact points on body A
+    /// (always a clump's sphere) are kept as 16-bit mantissas with a shared exponent, 8 bytes instead of 12 each. Each
+    /// component's error is then at most 2^-15 of the vector's largest component, so a contact point is off by at most
+    /// about 3e-5 of its distance from the clump's CoM. Contact points on body B, which may be a large mesh or
+    /// analytical object, and contact forces are always kept as float3, and the force calculation is in float/double
+    /// either way. "compact" cannot be used with UseCubForceCollection. See SetContactWildcardPrecision for the contact
+    /// wildcards.
+    void SetContactStoragePolicy(const std::string& policy);
+
+    /// @brief Set the precision the contact wildcards (contact history arrays) are stored in.
+    /// @param precision "float" (default), or "bf16": bfloat16, 2 bytes instead of 4 per contact and wildcard. bfloat16
+    /// keeps the range of float but only 8 significant bits, so each value stored is off by up to 2^-8 of itself. The
+    /// force model still reads and writes them as floats, and they are output, loaded with contact pairs, and set by
+    /// the Set*ContactWildcardValue calls as floats. A wildcard that accumulates small increments step by step (such as
+    /// the tangential displacement history of the built-in Hertzian model) loses the increments that are smaller than
+    /// its rounding, so use "bf16" for wildcards that tolerate that.
+    void SetContactWildcardPrecision(const std::string& precision);
+
     /// Instruct the solver that there is no need to record the contact force (and contact point location etc.) in an
     /// array. If set to true, the contact forces must be reduced to accelerations right in the force calculation kernel
     /// (meaning SetCollectAccRightAfterForceCalc is effectively called too). Calling this method could reduce some
@@ -829,6 +986,20 @@ class DEMSolver {
             collect_force_in_force_kernel = flag;
     }
 
+    /// @brief Set how the contacts between two families are recorded. Calling this means the contact forces are reduced
+    /// to accelerations right in the force calculation kernel (SetCollectAccRightAfterForceCalc is effectively called
+    /// too), so it can not be used with subcycling (SetFamilySubsteps). If no family pair is recorded in full, the
+    /// per-contact arrays are not allocated at all.
+    /// @param ID1 One family number.
+    /// @param ID2 The other family number (it can be the same as ID1).
+    /// @param policy "full": each contact's force, torque and contact points are recorded, for contact output and
+    /// GetOwnerContactForces. "aggregate": only each owner's sums of contact force and torque and its number of
+    /// contacts are kept (see GetOwnerContactForceSum). "none": nothing is recorded.
+    void SetFamilyPairForceRecord(unsigned int ID1, unsigned int ID2, const std::string& policy);
+    /// @brief Set how the contacts between the family pairs not given to SetFamilyPairForceRecord are recorded ("full"
+    /// if this is not called). See SetFamilyPairForceRecord.
+    void SetDefaultForceRecord(const std::string& policy);
+
     /// Add an (analytical or clump-represented) external object to the simulation system.
     std::shared_ptr<DEMExternObj> AddExternalObject();
     /// @brief Add an analytical plane to the simulation.
@@ -1010,7 +1181,12 @@ class DEMSolver {
     /// initialization.
     void UpdateSimParams();
 
-    /// @brief TTransfer newly loaded clumps to the GPU-side in mid-simulation.
+    /// @brief Transfer newly loaded clumps and meshed objects to the GPU-side in mid-simulation, without
+    /// re-initializing the system.
+    /// @details New clump templates can be used if clump templates and mass properties are not jitified (see
+    /// SetJitifyClumpTemplates and SetJitifyMassProperties), and so can new meshes if mass properties are not jitified.
+    /// New materials can always be used, but they make the solver re-compile its force calculation kernels. New
+    /// analytical objects and family prescriptions still require a re-initialization.
     void UpdateClumps();
 
     /// @brief Update the time step size. Used after system initialization.
@@ -1024,6 +1200,12 @@ class DEMSolver {
     /// Show the wall time and percentages of wall time spend on various solver tasks.
     void ShowTimingStats();
 
+    /// @brief Get the wall time spent on various solver tasks, as ShowTimingStats shows them.
+    /// @param names Names of the tasks.
+    /// @param vals Wall time spent on each task, in seconds.
+    /// @param of_kT If true, get kT's tasks; otherwise dT's.
+    void GetTimingStats(std::vector<std::string>& names, std::vector<double>& vals, bool of_kT = false);
+
     /// Show potential anomalies that may have been there in the simulation, then clear the anomaly log.
     void ShowAnomalies();
 
@@ -1035,6 +1217,83 @@ class DEMSolver {
     /// Reset the recordings of the wall time and percentages of wall time spend on various solver tasks.
     void ClearTimingStats();
 
+    /// @brief Record the begin and end of each solver phase (and of the sub-steps of contact detection) of kT and dT,
+    /// so the overlap of the two threads can be inspected with WriteProfilingTrace. When disabled, the instrumentation
+    /// costs a branch per phase. Call it between DoDynamics calls, not during one.
+    /// @param use Whether to record.
+    /// @param events_per_thread Size of the ring buffer of each thread; when full, the oldest events are overwritten.
+    void EnableProfiling(bool use = true, size_t events_per_thread = Profiler::DEFAULT_CAPACITY);
+
+    /// Write the recorded phases of kT and dT as a Chrome trace JSON file (viewable in chrome://tracing or Perfetto).
+    void WriteProfilingTrace(const std::string& outfilename) const;
+
+    /// Discard the phases recorded so far (recording continues if it is enabled).
+    void ClearProfilingTrace();
+
+    /// @brief Record a time series of runtime metrics (contact count, bin stats, future drift, kT lag, dT wait time,
+    /// max velocity and number of sleeping owners): one sample at each kT update, plus optionally one every N dT steps.
+    /// The latest samples can be queried with GetRecentMetrics; if a file name is given, samples are also written to it
+    /// from a background thread. Call it between DoDynamics calls, not during one.
+    /// @param outfilename File to stream samples into (overwritten). Empty means in-memory only.
+    /// @param format OUTPUT_FORMAT::CSV or OUTPUT_FORMAT::BINARY (see MetricsSink for the binary layout).
+    /// @param sample_every_n_steps Also take a sample every this many dT steps. 0 means only at kT updates.
+    /// @param ring_capacity How many of the latest samples are kept in memory.
+    void EnableMetrics(const std::string& outfilename = "",
+                       OUTPUT_FORMAT format = OUTPUT_FORMAT::CSV,
+                       unsigned int sample_every_n_steps = 0,
+                       size_t ring_capacity = MetricsSink<SolverMetrics>::DEFAULT_CAPACITY);
+
+    /// Stop recording metrics, and finish writing and close the metrics file, if any. Samples in memory are kept.
+    void DisableMetrics();
+
+    /// Block until all metrics samples taken so far are written to the metrics file.
+    void FlushMetrics();
+
+    /// Get the latest `n' metrics samples that are still in memory (all of them if n is 0), oldest first.
+    std::vector<SolverMetrics> GetRecentMetrics(size_t n = 0) const;
+
+    /// Show the usage and hit rate of the memory pools that serve the solver's managed and device arrays.
+    void ShowMemoryPoolStats();
+
+    /// Get the statistics of the memory pool that serves managed memory.
+    MemoryPoolStats GetManagedMemoryPoolStats() const;
+
+    /// Get the statistics of the memory pool that serves device memory on this device.
+    MemoryPoolStats GetDeviceMemoryPoolStats(int device) const;
+
+    /// @brief Release the memory that the pools cached (but is not in use) back to the system. The pools keep at most
+    /// as much cached memory as the peak usage, so this is only needed if you want that memory for something else.
+    /// @param keep_bytes Each pool is allowed to keep this many bytes cached.
+    /// @return The number of bytes released.
+    size_t TrimMemoryPools(size_t keep_bytes = 0);
+
+    /// @brief Get a breakdown of the memory held by the solver: every managed array, device buffer, scratch space and
+    /// temp array of kT and dT, with its current and peak size.
+    /// @return The memory report. It also carries the memory pool stats and the free/total memory of dT's device.
+    MemoryReport GetMemoryReport() const;
+
+    /// Print the memory report (see GetMemoryReport). Records smaller than min_bytes are summed into one line.
+    void ShowMemoryReport(size_t min_bytes = 1024 * 1024);
+
+    /// @brief Predict how much memory a simulation of this size would take, using the current solver settings (force
+    /// model wildcards, jitification, contact recording...) and the clump templates and analytical objects loaded so
+    /// far. Can be called before Initialize, so a job that will not fit can be rejected before spending GPU time on it.
+    /// It runs the same sizing code that kT and dT allocate their arrays with, without allocating anything. Scratch
+    /// space and temp arrays are only sized at run time, so they are included (extrapolated from the peaks measured so
+    /// far) only if the solver has been initialized and run. With a force record policy (see SetFamilyPairForceRecord),
+    /// the per-contact force arrays only hold the contacts recorded in full, whose share is only known after the
+    /// solver has run; before that, these arrays are predicted empty.
+    /// @param n_owners Number of owners (clumps, meshes and analytical objects).
+    /// @param n_spheres Number of sphere components.
+    /// @param n_triangles Number of mesh facets.
+    /// @param n_contacts Expected number of contact pairs. If 0, the initial estimate that the solver allocates for is
+    /// used (a few contacts per sphere). Contact arrays may grow past this number during the simulation.
+    /// @return The predicted memory report, with the free/total memory of dT's device filled in for comparison.
+    MemoryReport PredictMemoryUsage(size_t n_owners,
+                                    size_t n_spheres,
+                                    size_t n_triangles = 0,
+                                    size_t n_contacts = 0) const;
+
     /// Removes all entities associated with a family from the arrays (to save memory space).
     void PurgeFamily(unsigned int family_num);
 
@@ -1137,6 +1396,13 @@ class DEMSolver {
     // Whether to auto-adjust the bin size and the max update frequency
     bool auto_adjust_bin_size = true;
     bool auto_adjust_update_freq = true;
+    // Whether kT re-bins only the spheres that moved to other bins
+    bool use_incremental_binning = false;
+    // Whether kT bins spheres in levels of bins that suit their sizes
+    bool use_hierarchical_binning = false;
+    // Whether kT runs contact detection on host threads, and with how many (0 means all the hardware has)
+    bool use_host_contact_detection = false;
+    unsigned int m_host_cd_num_threads = 0;
     // User-instructed initial bin size as a multiple of smallest sphere radius
     float m_binSize_as_multiple = 8.0;
     // Target initial bin number
@@ -1169,6 +1435,10 @@ class DEMSolver {
     // the edge of the world.
     float3 m_target_box_min = make_float3(-DEFAULT_BOX_DOMAIN_SIZE * (1. + DEFAULT_BOX_DOMAIN_ENLARGE_RATIO) / 2.);
     float3 m_target_box_max = make_float3(DEFAULT_BOX_DOMAIN_SIZE * (1. + DEFAULT_BOX_DOMAIN_ENLARGE_RATIO) / 2.);
+    // Whether the user-instructed box is periodic in the X, Y and Z directions
+    bool m_box_periodic_x = false;
+    bool m_box_periodic_y = false;
+    bool m_box_periodic_z = false;
 
     // Exact `World' size along X dir (determined at init time)
     float m_boxX = -1.f;
@@ -1212,6 +1482,9 @@ class DEMSolver {
     // The `base' velocity we always consider entities to have, when determining the thickness of the margin to add for
     // contact detection.
     float m_expand_base_vel = 3.f;
+    // The skin added to the contact margins when kT finds contact candidates it may reuse. If 0, kT does not reuse
+    // them.
+    float m_cd_verlet_skin = 0.f;
 
     // The method of determining the thickness of the margin added to CD
     // Default is using a max_vel inspector of the clumps to decide it
@@ -1230,6 +1503,8 @@ class DEMSolver {
     bool sys_initialized = false;
     // Smallest sphere radius (used to let the user know whether the expand factor is sufficient)
     float m_smallest_radius = FLT_MAX;
+    // Largest sphere radius (used to decide the levels of bins in hierarchical binning)
+    float m_largest_radius = 0.f;
 
     // The number of dT steps before it waits for a kT update. The default value means every dT step will wait for a
     // newly produced contact-pair info (from kT) before proceeding.
@@ -1275,10 +1550,31 @@ class DEMSolver {
     bool no_recording_contact_forces = false;
     // See SetCollectAccRightAfterForceCalc
     bool collect_force_in_force_kernel = false;
+    // See UseContactTypeSpecializedForceKernels
+    bool use_type_specialized_force_kernels = false;
+    // See UseCompactForceKernel
+    bool use_compact_force_collect = false;
+    // See SetContactStoragePolicy
+    CNT_STORAGE_POLICY cnt_storage_policy = CNT_STORAGE_POLICY::FULL;
+    // See SetContactWildcardPrecision
+    bool use_bf16_contact_wildcards = false;
+    // See SetFamilyPairForceRecord and SetDefaultForceRecord
+    bool use_force_record_policy = false;
+    notStupidBool_t m_default_force_record = CNT_RECORD_FULL;
+    std::vector<std::pair<familyPair_t, notStupidBool_t>> m_input_force_record_pairs;
 
     // Error-out avg num contacts
     float threshold_error_out_num_cnts = 100.;
 
+    // Sleeping settings, see EnableSleeping. 0 steps means sleeping is disabled.
+    unsigned int m_sleep_steps = 0;
+    float m_sleep_lin_vel = 0.;
+    float m_sleep_ang_vel = 0.;
+    float m_wake_force = DEME_HUGE_FLOAT;
+
+    // Number of substeps that subcycled families take, see SetFamilySubsteps. 1 means no family is subcycled.
+    unsigned int m_num_substeps = 1;
+
     // Integrator type
     TIME_INTEGRATOR m_integrator = TIME_INTEGRATOR::EXTENDED_TAYLOR;
 
@@ -1288,6 +1584,13 @@ class DEMSolver {
 
     // Strategy for auto-adapting time steps size
     ADAPT_TS_TYPE adapt_ts_type = ADAPT_TS_TYPE::NONE;
+    // Adaptive time step size bounds and criteria, see SetAdaptiveTimeStepLimits and SetAdaptiveTimeStepCriteria
+    double m_adapt_ts_min = 0.;
+    double m_adapt_ts_max = DEME_HUGE_FLOAT;
+    float m_adapt_ts_travel_ratio = 0.01;
+    float m_adapt_ts_overlap_ratio = 0.01;
+    float m_adapt_ts_rayleigh_fraction = 0.2;
+    float m_adapt_ts_max_growth = 1.1;
 
     ////////////////////////////////////////////////////////////////////////////////
     // No user method is provided to modify the following key quantities, even if
@@ -1392,6 +1695,9 @@ class DEMSolver {
     std::vector<std::shared_ptr<DEMMeshConnected>> m_meshes;
     // A map between the owner of mesh, and the offset this mesh lives in m_meshes array.
     std::unordered_map<bodyID_t, unsigned int> m_owner_mesh_map;
+    // Node arrays and node-to-facet maps of the meshes that have been deformed, by owner. They hold the node positions
+    // that dT currently has, so a node update can tell which facets it actually changes.
+    std::unordered_map<bodyID_t, MeshNodeIndex> m_mesh_node_indices;
 
     ////////////////////////////////////////////////////////////////////////////////
     // Cached user's direct (raw) inputs concerning the actual physics objects
@@ -1566,8 +1872,12 @@ class DEMSolver {
     void updateTotalEntityNum();
     /// Jitify GPU kernels, based on pre-processed user inputs
     void jitifyKernels();
+    /// Re-jitify only what depends on newly added (flattened) clump templates and/or materials, in UpdateClumps
+    void updateJitifiedData(bool new_templates, bool new_materials);
     /// Figure out the unit length l and numbers of voxels along each direction, based on domain size X, Y, Z
     void figureOutNV();
+    /// Widen m_smallest_radius and m_largest_radius to cover the radii of the clump templates in m_template_sp_radii
+    void updateSphereRadiusRange();
     /// Set the default bin (for contact detection) size to be the same of the smallest sphere
     void decideBinSize();
     /// The method of deciding the thickness of contact margin (user-specified max vel; or a custom inspector)
@@ -1576,9 +1886,21 @@ class DEMSolver {
     void addWorldBoundingBox();
     /// Transfer cached solver preferences/instructions to dT and kT.
     void transferSolverParams();
+    /// Derive, from the cached instructions, the solver flags that decide which of kT's and dT's arrays exist
+    void deriveArrayFlags(ManagedArraySizes& n) const;
+    /// The force record policy of each family pair (flattened like the family mask matrix), per the cached instructions
+    std::vector<notStupidBool_t> familyForceRecordTable() const;
     /// Transfer (CPU-side) cached simulation data (about sim world) to the GPU-side. It is called automatically during
     /// system initialization.
     void transferSimParams();
+    /// Transfer the sleeping settings to dT, and wake all owners up (so they fall asleep under the new settings)
+    void transferSleepParams();
+    /// The smallest Rayleigh critical time step of the clumps' spheres whose materials have E and nu (huge if none)
+    double deriveRayleighTimeStep() const;
+    /// Error out if subcycling is used together with a force collection strategy that it does not support
+    void assertSubcyclingCompatible() const;
+    /// Convert a force record policy name ("full" etc.) to CNT_RECORD_FULL etc.
+    notStupidBool_t forceRecordPolicyFromName(const std::string& policy) const;
     /// Transfer cached clump templates info etc. to GPU-side arrays
     void initializeGPUArrays();
     /// Allocate memory space for GPU-side arrays
@@ -1596,6 +1918,12 @@ class DEMSolver {
     void preprocessTriangleObjs();
     /// Report simulation stats at initialization
     void reportInitStats() const;
+    /// Fill in the free and total memory of dT's device in a memory report
+    void queryDeviceMemory(MemoryReport& report) const;
+    /// Get the node index of the mesh of this owner, creating it on first use
+    MeshNodeIndex& getMeshNodeIndex(size_t owner);
+    /// Write the facets that node updates made dirty to dT (which passes them on to kT)
+    void sendMeshNodeUpdates(size_t owner, size_t triID);
     /// Based on user input, prepare family_mask_matrix (family contact map matrix)
     void figureOutFamilyMasks();
     /// Reset kT and dT back to a status like when the simulation system is constructed. I decided to make this a
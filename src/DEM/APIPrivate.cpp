@@ -15,6 +15,7 @@
 #include <cstring>
 #include <limits>
 #include <algorithm>
+#include <cmath>
 
 namespace deme {
 
@@ -230,6 +231,24 @@ void DEMSolver::jitifyKernels() {
     dT->approxMaxVelFunc = m_approx_max_vel_func;
 }
 
+void DEMSolver::updateJitifiedData(bool new_templates, bool new_materials) {
+    // Clump volumes are always jitified (used by void ratio inspectors), so new templates mean new volume definitions
+    if (new_templates) {
+        equipMassMoiVolume(m_subs);
+    }
+    // Material properties only appear in the force calculation kernels
+    if (new_materials) {
+        equipMaterials(m_subs);
+        equipSimParams(m_subs);
+        dT->jitifyForceKernels(m_subs);
+    }
+    // Inspectors are jitified with the substitutions at their first use, so let them be re-built the next time they are
+    // used. The max vel inspector used by the solver itself does not use either kind of data.
+    for (auto& insp : m_inspectors) {
+        insp->initialized = false;
+    }
+}
+
 bodyID_t DEMSolver::getGeoOwnerID(const bodyID_t& geoID, const contact_t& cnt_type) const {
     switch (cnt_type) {
         case NOT_A_CONTACT:
@@ -390,15 +409,34 @@ void DEMSolver::figureOutNV() {
     m_boxZ = m_voxelSize * (double)((size_t)1 << nvZp2);
 }
 
-void DEMSolver::decideBinSize() {
-    // find the smallest radius
-    for (auto elem : m_template_sp_radii) {
+void DEMSolver::updateSphereRadiusRange() {
+    // Templates only ever get added, so the range is widened by those loaded now
+    for (const auto& elem : m_template_sp_radii) {
         for (auto radius : elem) {
             if (radius < m_smallest_radius) {
                 m_smallest_radius = radius;
             }
+            if (radius > m_largest_radius) {
+                m_largest_radius = radius;
+            }
         }
     }
+}
+
+void DEMSolver::decideBinSize() {
+    // find the smallest (and largest) radius
+    updateSphereRadiusRange();
+    // The number of bins a bin size gives, counting those of the coarser levels with hierarchical binning
+    auto count_bins = [&]() {
+        size_t num_bins = hostCalcBinNum(nbX, nbY, nbZ, m_voxelSize, m_binSize, nvXp2, nvYp2, nvZp2);
+        if (use_hierarchical_binning) {
+            binID_t nbXLevel[DEME_MAX_BIN_LEVELS], nbYLevel[DEME_MAX_BIN_LEVELS], nbZLevel[DEME_MAX_BIN_LEVELS];
+            binID_t binLevelOffset[DEME_MAX_BIN_LEVELS];
+            num_bins = hostCalcBinLevels(nbXLevel, nbYLevel, nbZLevel, binLevelOffset, nbX, nbY, nbZ,
+                                         hostNumBinLevels(m_binSize, m_largest_radius, DEME_MAX_BIN_LEVELS));
+        }
+        return num_bins;
+    };
 
     // use_user_defined_bin_size records whether the user explicitly gave a number for bin size
     if (m_smallest_radius > DEME_TINY_FLOAT) {
@@ -420,7 +458,7 @@ void DEMSolver::decideBinSize() {
         }
     }
 
-    m_num_bins = hostCalcBinNum(nbX, nbY, nbZ, m_voxelSize, m_binSize, nvXp2, nvYp2, nvZp2);
+    m_num_bins = count_bins();
     // It's better to compute num of bins this way, rather than...
     // (uint64_t)(m_boxX / m_binSize + 1) * (uint64_t)(m_boxY / m_binSize + 1) * (uint64_t)(m_boxZ / m_binSize + 1);
     // because the space bins and voxels can cover may be larger than the user-defined sim domain
@@ -434,7 +472,7 @@ void DEMSolver::decideBinSize() {
             } else {
                 m_binSize *= 1.2;
             }
-            m_num_bins = hostCalcBinNum(nbX, nbY, nbZ, m_voxelSize, m_binSize, nvXp2, nvYp2, nvZp2);
+            m_num_bins = count_bins();
             // If changed size relationship, good enough.
             if ((prev_num < m_target_init_bin_num && m_num_bins >= m_target_init_bin_num) ||
                 (prev_num >= m_target_init_bin_num && m_num_bins < m_target_init_bin_num)) {
@@ -452,7 +490,7 @@ void DEMSolver::decideBinSize() {
                 m_num_bins, m_binSize, (size_t)(std::numeric_limits<binID_t>::max() - 1));
             while (m_num_bins > std::numeric_limits<binID_t>::max() - 1) {
                 m_binSize *= 1.5;
-                m_num_bins = hostCalcBinNum(nbX, nbY, nbZ, m_voxelSize, m_binSize, nvXp2, nvYp2, nvZp2);
+                m_num_bins = count_bins();
             }
             DEME_WARNING(
                 "Bin size auto-adjusted to %.6g, now we have %zu initial bins. Note this number may be large and it "
@@ -553,6 +591,35 @@ void DEMSolver::reportInitStats() const {
                          : m_meshes) { printf("{%zu, %u}, ", (size_t)mesh->owner, mesh->cache_offset); } printf("\n"););
 }
 
+void DEMSolver::queryDeviceMemory(MemoryReport& report) const {
+    int prev_device;
+    DEME_GPU_CALL(cudaGetDevice(&prev_device));
+    DEME_GPU_CALL(cudaSetDevice(dT->streamInfo.device));
+    DEME_GPU_CALL(cudaMemGetInfo(&report.deviceFreeBytes, &report.deviceTotalBytes));
+    DEME_GPU_CALL(cudaSetDevice(prev_device));
+}
+
+MeshNodeIndex& DEMSolver::getMeshNodeIndex(size_t owner) {
+    auto it = m_mesh_node_indices.find(owner);
+    if (it == m_mesh_node_indices.end()) {
+        const auto& mesh = m_meshes.at(m_owner_mesh_map.at(owner));
+        it = m_mesh_node_indices.emplace(owner, MeshNodeIndex(mesh->m_vertices, mesh->m_face_v_indices)).first;
+        // The cached mesh's nodes may have been modified through a handle since initialization, so we can't be sure
+        // they match what dT has. The first update rewrites all facets.
+        it->second.MarkAllDirty();
+    }
+    return it->second;
+}
+
+void DEMSolver::sendMeshNodeUpdates(size_t owner, size_t triID) {
+    DirtyRanges facets;
+    m_mesh_node_indices.at(owner).TakeDirtyFacets(facets);
+    if (facets.Empty())
+        return;
+    dT->setTriNodeRelPos(triID, m_mesh_node_indices.at(owner), facets);
+    dT->solverFlags.willMeshDeform = true;
+}
+
 void DEMSolver::preprocessAnalyticalObjs() {
     // nExtObj can increase in mid-simulation if the user re-initialize using an `Add' flavor
     nExtObj += cached_extern_objs.size();
@@ -700,6 +767,12 @@ void DEMSolver::preprocessTriangleObjs() {
                     float3 tmp = tri.p2;
                     tri.p2 = tri.p3;
                     tri.p3 = tmp;
+                    // The cached mesh's facet is flipped as well, so facets derived from its nodes later on (when it
+                    // deforms) keep this orientation
+                    std::swap(mesh_obj->m_face_v_indices.at(i).y, mesh_obj->m_face_v_indices.at(i).z);
+                    std::swap(mesh_obj->m_face_n_indices.at(i).y, mesh_obj->m_face_n_indices.at(i).z);
+                    if (i < mesh_obj->m_face_uv_indices.size())
+                        std::swap(mesh_obj->m_face_uv_indices.at(i).y, mesh_obj->m_face_uv_indices.at(i).z);
                 }
             }
             m_mesh_facets.push_back(tri);
@@ -865,6 +938,12 @@ void DEMSolver::addWorldBoundingBox() {
             DEME_ERROR("Domain bounding BC instruction %s is unknown.", m_user_add_bounding_box.c_str());
     }
 
+    // No walls in a periodic direction
+    if (m_box_periodic_z) {
+        bottom = false;
+        top = false;
+    }
+
     auto box = this->AddExternalObject();
     if (bottom) {
         float3 bottom_loc = (m_user_box_min + m_user_box_max) / 2.;
@@ -875,21 +954,25 @@ void DEMSolver::addWorldBoundingBox() {
     if (sides) {
         float3 center = (m_user_box_min + m_user_box_max) / 2.;
 
-        float3 left = center;
-        left.x = m_user_box_min.x;
-        box->AddPlane(left, host_make_float3(1, 0, 0), m_bounding_box_material);
+        if (!m_box_periodic_x) {
+            float3 left = center;
+            left.x = m_user_box_min.x;
+            box->AddPlane(left, host_make_float3(1, 0, 0), m_bounding_box_material);
 
-        float3 right = center;
-        right.x = m_user_box_max.x;
-        box->AddPlane(right, host_make_float3(-1, 0, 0), m_bounding_box_material);
+            float3 right = center;
+            right.x = m_user_box_max.x;
+            box->AddPlane(right, host_make_float3(-1, 0, 0), m_bounding_box_material);
+        }
 
-        float3 front = center;
-        front.y = m_user_box_min.y;
-        box->AddPlane(front, host_make_float3(0, 1, 0), m_bounding_box_material);
+        if (!m_box_periodic_y) {
+            float3 front = center;
+            front.y = m_user_box_min.y;
+            box->AddPlane(front, host_make_float3(0, 1, 0), m_bounding_box_material);
 
-        float3 the_back = center;
-        the_back.y = m_user_box_max.y;
-        box->AddPlane(the_back, host_make_float3(0, -1, 0), m_bounding_box_material);
+            float3 the_back = center;
+            the_back.y = m_user_box_max.y;
+            box->AddPlane(the_back, host_make_float3(0, -1, 0), m_bounding_box_material);
+        }
     }
 
     if (top) {
@@ -899,6 +982,37 @@ void DEMSolver::addWorldBoundingBox() {
     }
 }
 
+std::vector<notStupidBool_t> DEMSolver::familyForceRecordTable() const {
+    std::vector<notStupidBool_t> table((NUM_AVAL_FAMILIES + 1) * NUM_AVAL_FAMILIES / 2, m_default_force_record);
+    for (const auto& a_pair : m_input_force_record_pairs) {
+        unsigned int posInMat = locateMaskPair<unsigned int>(a_pair.first.ID1, a_pair.first.ID2);
+        table.at(posInMat) = a_pair.second;
+    }
+    return table;
+}
+
+void DEMSolver::deriveArrayFlags(ManagedArraySizes& n) const {
+    n.isHistoryless = (m_force_model->m_contact_wildcards.size() == 0);
+    n.useVerletSkin = (m_cd_verlet_skin > 0.);
+    n.canFamilyChange = famnum_can_change_conditionally;
+    n.useClumpJitify = jitify_clump_templates;
+    n.useMassJitify = jitify_mass_moi;
+    // With a force record policy, the per-contact arrays are only needed if some family pair is recorded in full
+    bool any_full_record = true, any_aggregate_record = false;
+    if (use_force_record_policy) {
+        const auto table = familyForceRecordTable();
+        any_full_record = std::any_of(table.begin(), table.end(),
+                                      [](notStupidBool_t policy) { return policy == CNT_RECORD_FULL; });
+        any_aggregate_record = std::any_of(table.begin(), table.end(),
+                                           [](notStupidBool_t policy) { return policy == CNT_RECORD_AGGREGATE; });
+    }
+    n.useForceRecordPolicy = use_force_record_policy;
+    n.useOwnerCntAggregates = any_aggregate_record;
+    n.useNoContactRecord = no_recording_contact_forces || !any_full_record;
+    n.useCompactContactStorage = (cnt_storage_policy == CNT_STORAGE_POLICY::COMPACT);
+    n.useBF16ContactWildcards = use_bf16_contact_wildcards;
+}
+
 // This is generally used to pass individual instructions on how the solver should behave
 void DEMSolver::transferSolverParams() {
     // Verbosity
@@ -962,8 +1076,37 @@ void DEMSolver::transferSolverParams() {
     // Force reduction strategy
     kT->solverFlags.useCubForceCollect = use_cub_to_reduce_force;
     dT->solverFlags.useCubForceCollect = use_cub_to_reduce_force;
-    dT->solverFlags.useNoContactRecord = no_recording_contact_forces;
+    // The flags that decide which arrays exist are derived in one place, shared with the memory prediction
+    ManagedArraySizes array_flags;
+    deriveArrayFlags(array_flags);
+    if (use_force_record_policy) {
+        const auto record_table = familyForceRecordTable();
+        std::copy(record_table.begin(), record_table.end(), dT->familyForceRecord.begin());
+    }
+    dT->solverFlags.useForceRecordPolicy = array_flags.useForceRecordPolicy;
+    dT->solverFlags.useOwnerCntAggregates = array_flags.useOwnerCntAggregates;
+    dT->solverFlags.useNoContactRecord = array_flags.useNoContactRecord;
     dT->solverFlags.useForceCollectInPlace = collect_force_in_force_kernel;
+    assertSubcyclingCompatible();
+    if (use_type_specialized_force_kernels && !should_sort_contacts) {
+        DEME_WARNING(
+            "Contact type-specialized force kernels need contact pairs to be sorted by type, but SetSortContactPairs "
+            "was called with false.\nThe force calculation will use the generic kernel.");
+    }
+    dT->solverFlags.useTypeSpecializedForceCalc = use_type_specialized_force_kernels && should_sort_contacts;
+    if (use_compact_force_collect && (use_cub_to_reduce_force || collect_force_in_force_kernel)) {
+        DEME_WARNING(
+            "UseCompactForceKernel has no effect when UseCubForceCollection or SetCollectAccRightAfterForceCalc is "
+            "used.");
+    }
+    dT->solverFlags.useCompactForceCollect = use_compact_force_collect && !use_cub_to_reduce_force;
+    if (cnt_storage_policy == CNT_STORAGE_POLICY::COMPACT && use_cub_to_reduce_force) {
+        DEME_ERROR(
+            "The compact contact storage policy cannot be used with UseCubForceCollection.\nPlease use the default "
+            "force collection, or SetContactStoragePolicy(\"full\").");
+    }
+    dT->solverFlags.useCompactContactStorage = array_flags.useCompactContactStorage;
+    dT->solverFlags.useBF16ContactWildcards = array_flags.useBF16ContactWildcards;
 
     // Whether sorts contact before using them (not implemented)
     kT->solverFlags.should_sort_pairs = should_sort_contacts;
@@ -979,8 +1122,91 @@ void DEMSolver::transferSolverParams() {
     kT->solverFlags.errOutAvgSphCnts = threshold_error_out_num_cnts;
     dT->solverFlags.errOutAvgSphCnts = threshold_error_out_num_cnts;
 
+    // Verlet-style contact candidate reuse
+    kT->simParams->verletSkin = m_cd_verlet_skin;
+    dT->simParams->verletSkin = m_cd_verlet_skin;
+
     // Whether the solver should auto-update bin sizes
     kT->solverFlags.autoBinSize = auto_adjust_bin_size;
+    kT->solverFlags.useIncrementalBinning = use_incremental_binning;
+    kT->solverFlags.useHierarchicalBinning = use_hierarchical_binning;
+    kT->solverFlags.useHostContactDetection = use_host_contact_detection;
+    kT->solverFlags.hostCDNumThreads = m_host_cd_num_threads;
+    if (use_host_contact_detection) {
+        if (nTriObjLoad > 0) {
+            DEME_ERROR(
+                "Contact detection on host threads does not support meshed objects yet, but %zu mesh(es) are "
+                "loaded.\nPlease call UseHostContactDetection(false), or remove the meshes.",
+                (size_t)nTriObjLoad);
+        }
+        if (m_cd_verlet_skin > 0.f) {
+            DEME_ERROR(
+                "Contact detection on host threads does not support SetCDVerletSkin yet.\nPlease call "
+                "UseHostContactDetection(false), or SetCDVerletSkin(0).");
+        }
+        if (use_incremental_binning || use_hierarchical_binning) {
+            DEME_WARNING(
+                "UseIncrementalBinning and UseHierarchicalBinning have no effect when contact detection runs on host "
+                "threads.");
+        }
+    }
+    if (m_box_periodic_x || m_box_periodic_y || m_box_periodic_z) {
+        // (Host contact detection ignores these two, and supports periodic boundaries)
+        if ((use_incremental_binning || use_hierarchical_binning) && !use_host_contact_detection) {
+            DEME_ERROR(
+                "Periodic boundaries are not supported with UseIncrementalBinning or UseHierarchicalBinning "
+                "yet.\nPlease disable them, or call InstructBoxDomainPeriodic(\"none\").");
+        }
+        float3 box_size = m_user_box_max - m_user_box_min;
+        if ((m_box_periodic_x && box_size.x <= 4. * m_largest_radius) ||
+            (m_box_periodic_y && box_size.y <= 4. * m_largest_radius) ||
+            (m_box_periodic_z && box_size.z <= 4. * m_largest_radius)) {
+            DEME_ERROR(
+                "In a periodic direction, the box instructed with InstructBoxDomainDimension should be longer than 4 "
+                "times the largest sphere radius (%.7g), but it is %.7g by %.7g by %.7g.",
+                m_largest_radius, box_size.x, box_size.y, box_size.z);
+        }
+    }
+    // Adaptive time stepping
+    switch (adapt_ts_type) {
+        case (ADAPT_TS_TYPE::MAX_VEL):
+            dT->solverFlags.stepSizeStrat = VAR_TS_STRAT::MAX_VEL;
+            break;
+        case (ADAPT_TS_TYPE::INT_DIFF):
+            dT->solverFlags.stepSizeStrat = VAR_TS_STRAT::INT_GAP;
+            break;
+        default:
+            dT->solverFlags.stepSizeStrat = VAR_TS_STRAT::DEME_CONST;
+    }
+    if (!ts_size_is_const) {
+        TimeStepController& controller = dT->stepController;
+        controller.strat = dT->solverFlags.stepSizeStrat;
+        controller.minRadius = m_smallest_radius;
+        controller.maxTravelRatio = m_adapt_ts_travel_ratio;
+        controller.maxOverlapRatio = m_adapt_ts_overlap_ratio;
+        controller.maxGrowth = m_adapt_ts_max_growth;
+        controller.minStep = m_adapt_ts_min;
+        double rayleigh_ts = deriveRayleighTimeStep();
+        controller.maxStep = std::min(m_adapt_ts_max, (double)m_adapt_ts_rayleigh_fraction * rayleigh_ts);
+        if (controller.maxStep >= DEME_HUGE_FLOAT) {
+            DEME_ERROR(
+                "Adaptive time stepping needs an upper bound of the step size, but no clump sphere has a material with "
+                "E and nu to derive the Rayleigh time step from.\nPlease set one with SetAdaptiveTimeStepLimits.");
+        }
+        if (controller.minStep > controller.maxStep) {
+            DEME_ERROR("The lower bound of the adaptive time step size (%.7g) is larger than the upper bound (%.7g).",
+                       controller.minStep, controller.maxStep);
+        }
+        if (m_ts_size > controller.maxStep) {
+            DEME_WARNING(
+                "The initial time step size %.7g is larger than the upper bound of the adaptive time step size %.7g, "
+                "and it will be used until the first contact detection.",
+                m_ts_size, controller.maxStep);
+        }
+        DEME_INFO("Adaptive time step size is between %.7g and %.7g (Rayleigh time step is %.7g)", controller.minStep,
+                  controller.maxStep, rayleigh_ts);
+    }
+    kT->stateParams.maxSphereRadius = m_largest_radius;
     {
         kT->stateParams.binChangeObserveSteps = auto_adjust_observe_steps;
         kT->stateParams.binTopChangeRate = auto_adjust_max_rate;
@@ -1043,9 +1269,101 @@ void DEMSolver::transferSimParams() {
                      m_user_box_max, G, m_ts_size, m_expand_factor, m_approx_max_vel, m_expand_safety_multi,
                      m_expand_base_vel, m_force_model->m_contact_wildcards, m_force_model->m_owner_wildcards,
                      m_force_model->m_geo_wildcards);
+
+    // Periodic directions. The period starts at the user box's lower end, relative to the LBF point.
+    for (DEMSimParams* simParams : {dT->simParams, kT->simParams}) {
+        simParams->periodicX = m_box_periodic_x;
+        simParams->periodicY = m_box_periodic_y;
+        simParams->periodicZ = m_box_periodic_z;
+        simParams->periodStartX = (double)m_user_box_min.x - m_boxLBF.x;
+        simParams->periodStartY = (double)m_user_box_min.y - m_boxLBF.y;
+        simParams->periodStartZ = (double)m_user_box_min.z - m_boxLBF.z;
+        simParams->periodX = (double)m_user_box_max.x - m_user_box_min.x;
+        simParams->periodY = (double)m_user_box_max.y - m_user_box_min.y;
+        simParams->periodZ = (double)m_user_box_max.z - m_user_box_min.z;
+    }
+
+    transferSleepParams();
+    dT->simParams->nSubsteps = m_num_substeps;
+
+    // Adaptive time stepping starts from the initial step size
+    dT->simParams->trackMaxOverlap = (dT->solverFlags.stepSizeStrat == VAR_TS_STRAT::INT_GAP);
+    dT->granData->maxOverlapRatio = 0;
+    dT->stepController.Reset(m_ts_size);
+}
+
+double DEMSolver::deriveRayleighTimeStep() const {
+    double rayleigh_ts = DEME_HUGE_FLOAT;
+    for (size_t i = 0; i < m_template_clump_mass.size(); i++) {
+        if (m_template_clump_volume.at(i) <= 0.) {
+            continue;
+        }
+        const double density = m_template_clump_mass.at(i) / m_template_clump_volume.at(i);
+        for (size_t j = 0; j < m_template_sp_radii.at(i).size(); j++) {
+            const auto& mat_prop = m_loaded_materials.at(m_template_sp_mat_ids.at(i).at(j))->mat_prop;
+            if (mat_prop.find("E") == mat_prop.end() || mat_prop.find("nu") == mat_prop.end()) {
+                continue;
+            }
+            rayleigh_ts = std::min(rayleigh_ts, TimeStepController::RayleighTimeStep(m_template_sp_radii.at(i).at(j),
+                                                                                      density, mat_prop.at("E"),
+                                                                                      mat_prop.at("nu")));
+        }
+    }
+    return rayleigh_ts;
+}
+
+notStupidBool_t DEMSolver::forceRecordPolicyFromName(const std::string& policy) const {
+    switch (hash_charr(policy.c_str())) {
+        case ("full"_):
+            return CNT_RECORD_FULL;
+        case ("aggregate"_):
+            return CNT_RECORD_AGGREGATE;
+        case ("none"_):
+            return CNT_RECORD_NONE;
+        default:
+            DEME_ERROR("Force record policy %s is unknown. It should be \"full\", \"aggregate\" or \"none\".",
+                       policy.c_str());
+    }
+    return CNT_RECORD_FULL;
+}
+
+void DEMSolver::assertSubcyclingCompatible() const {
+    // Substeps re-collect the forces of a subset of contacts into a subset of owners, which only the default force
+    // collection strategy does. A force record policy collects the forces in the force kernel too.
+    if (m_num_substeps > 1 && (use_cub_to_reduce_force || collect_force_in_force_kernel || use_force_record_policy)) {
+        DEME_ERROR(
+            "Some families are subcycled (see SetFamilySubsteps), but subcycling can not be used with "
+            "UseCubForceCollection, SetCollectAccRightAfterForceCalc or SetNoForceRecord, or with a force record "
+            "policy (SetFamilyPairForceRecord or SetDefaultForceRecord), which collects the forces in the force "
+            "calculation kernel.");
+    }
+}
+
+void DEMSolver::transferSleepParams() {
+    // Only dT integrates and computes forces, so kT does not need these
+    dT->simParams->sleepSteps = m_sleep_steps;
+    dT->simParams->sleepLinVel = m_sleep_lin_vel;
+    dT->simParams->sleepAngVel = m_sleep_ang_vel;
+    dT->simParams->wakeForce = m_wake_force;
+    dT->wakeAllOwners();
 }
 
 void DEMSolver::allocateGPUArrays() {
+    // If the user instructed the number of owners to expect, reserve that much capacity in the owner arrays, and
+    // proportionally in the sphere and contact arrays, assuming clumps added later look like the ones we have now
+    if (m_instructed_num_owners > nOwnerBodies) {
+        size_t n_more_owners = m_instructed_num_owners - nOwnerBodies;
+        double sph_per_clump = (nOwnerClumps > 0) ? (double)nSpheresGM / (double)nOwnerClumps : 1.0;
+        size_t reserved_spheres = nSpheresGM + (size_t)std::ceil(sph_per_clump * n_more_owners);
+        size_t reserved_contacts = reserved_spheres * DEME_INIT_CNT_MULTIPLIER;
+        dT->reservedOwners = m_instructed_num_owners;
+        dT->reservedSpheres = reserved_spheres;
+        dT->reservedContacts = reserved_contacts;
+        kT->reservedOwners = m_instructed_num_owners;
+        kT->reservedSpheres = reserved_spheres;
+        kT->reservedContacts = reserved_contacts;
+    }
+
     // Resize managed arrays based on the statistical data we had from the previous step
     std::thread dThread = std::move(std::thread([this]() {
         this->dT->allocateManagedArrays(
@@ -1106,8 +1424,8 @@ void DEMSolver::initializeGPUArrays() {
 }
 
 /// When more clumps/meshed objects got loaded, this method should be called to transfer them to the GPU-side in
-/// mid-simulation. This method cannot handle the addition of extra templates or analytical entities, which require
-/// re-compilation.
+/// mid-simulation. This method can handle the addition of flattened clump templates, but not analytical entities, which
+/// require re-compilation.
 void DEMSolver::updateClumpMeshArrays(size_t nOwners,
                                       size_t nClumps,
                                       size_t nSpheres,
@@ -1127,6 +1445,8 @@ void DEMSolver::updateClumpMeshArrays(size_t nOwners,
         // Meshed objects' initial stats
         cached_mesh_objs, m_input_mesh_obj_xyz, m_input_mesh_obj_rot, m_input_mesh_obj_family, m_mesh_facet_owner,
         m_mesh_facet_materials, m_mesh_facets,
+        // Clump template name mapping
+        m_template_number_name_map,
         // Clump template info (mass, sphere components, materials etc.)
         flattened_clump_templates,
         // Analytical obj `template' properties
@@ -1240,179 +1560,22 @@ bool DEMSolver::goThroughWorkerAnomalies() {
 // }
 
 inline void DEMSolver::equipForceModel(std::unordered_map<std::string, std::string>& strMap) {
-    // Empty ingr list
-    auto added_ingredients = force_kernel_ingredient_stats;
-    //// TODO: Reassemble geo and owner wildcards here again in a set is not needed... Since set is ordered.
-    std::set<std::string> added_owner_wildcards, added_geo_wildcards;
-    // Analyze this model... what does it require?
-    std::string model = m_force_model->m_force_model;
-    const std::set<std::string> contact_wildcard_names = m_force_model->m_contact_wildcards;
-    const std::set<std::string> owner_wildcard_names = m_force_model->m_owner_wildcards;
-    const std::set<std::string> geo_wildcard_names = m_force_model->m_geo_wildcards;
-    m_owner_wc_num.clear();
-    m_geo_wc_num.clear();
-    m_cnt_wc_num.clear();
-    // If we spot that the force model requires an ingredient, we make sure that order goes to the ingredient
-    // acquisition module
-    std::string ingredient_definition = " ", cnt_wildcard_acquisition = " ", ingredient_acquisition_A = " ",
-                ingredient_acquisition_B = " ", owner_geo_wildcard_write_back = " ", cnt_wildcard_write_back = " ",
-                cnt_wildcard_destroy_record = " ", geo_wc_acquisition_B_sph = " ", geo_wc_acquisition_B_tri = " ",
-                geo_wc_acquisition_B_anal = " ";
-    scan_force_model_ingr(added_ingredients, model);
-    // As our numerical method stands now, AOwnerFamily and BOwnerFamily are always needed.
-    add_force_model_ingr(added_ingredients, "AOwnerFamily");
-    add_force_model_ingr(added_ingredients, "BOwnerFamily");
-    // If we collect force in force-calc kernel, these are needed...
-    if (collect_force_in_force_kernel) {
-        add_force_model_ingr(added_ingredients, "AOwner");
-        add_force_model_ingr(added_ingredients, "BOwner");
-        add_force_model_ingr(added_ingredients, "AOwnerMOI");
-        add_force_model_ingr(added_ingredients, "BOwnerMOI");
-    }
-    // Then, owner/geo wildcards should be added to the ingredient list too. But first we check whether a wildcard
-    // shares name with existing ingredients. If not, we add them to the list.
-    unsigned int owner_wc_num = 0, geo_wc_num = 0, cnt_wc_num = 0;
-    for (const auto& owner_wildcard_name : owner_wildcard_names) {
-        if (added_ingredients.find(owner_wildcard_name) != added_ingredients.end()) {
-            DEME_ERROR(
-                "Owner wildcard %s shares its name with a reserved contact force model ingredient.\nPlease select a "
-                "different name for this wildcard and try again.",
-                owner_wildcard_name.c_str());
-        }
-        added_owner_wildcards.insert(owner_wildcard_name);
-        // Finally, owner wildcards are subject to user modification, so it is better to keep tab of their numbering for
-        // later use.
-        m_owner_wc_num[owner_wildcard_name] = owner_wc_num;
-        owner_wc_num++;
-    }
-    for (const auto& geo_wildcard_name : geo_wildcard_names) {
-        if (added_ingredients.find(geo_wildcard_name) != added_ingredients.end()) {
-            DEME_ERROR(
-                "Geometry wildcard %s shares its name with a reserved contact force model ingredient.\nPlease select a "
-                "different name for this wildcard and try again.",
-                geo_wildcard_name.c_str());
-        }
-        added_geo_wildcards.insert(geo_wildcard_name);
-        // Finally, owner wildcards are subject to user modification, so it is better to keep tab of their numbering for
-        // later use.
-        m_geo_wc_num[geo_wildcard_name] = geo_wc_num;
-        geo_wc_num++;
-    }
-    for (const auto& contact_wildcard_name : contact_wildcard_names) {
-        if (added_ingredients.find(contact_wildcard_name) != added_ingredients.end()) {
-            DEME_ERROR(
-                "Contact wildcard %s shares its name with a reserved contact force model ingredient.\nPlease select a "
-                "different name for this wildcard and try again.",
-                contact_wildcard_name.c_str());
-        }
-        m_cnt_wc_num[contact_wildcard_name] = cnt_wc_num;
-        cnt_wc_num++;
-    }
-
-    // Owner write-back needs ABOwner number
-    if (owner_wildcard_names.size() > 0) {
-        add_force_model_ingr(added_ingredients, "AOwner");
-        add_force_model_ingr(added_ingredients, "BOwner");
-    }
-    // Geo wildcard write-back needs ABGeo number
-    if (geo_wildcard_names.size() > 0) {
-        add_force_model_ingr(added_ingredients, "AGeo");
-        add_force_model_ingr(added_ingredients, "BGeo");
-    }
-
-    // Equip those acquisition strategies that need to be there
-    equip_force_model_ingr_acq(ingredient_definition, ingredient_acquisition_A, ingredient_acquisition_B,
-                               added_ingredients);
-    // Then equip acquisition strategies for owner wildcards
-    equip_owner_wildcards(ingredient_definition, ingredient_acquisition_A, ingredient_acquisition_B,
-                          owner_geo_wildcard_write_back, added_owner_wildcards);
-    // Then equip acquisition strategies for geo wildcards.
-    // geo_wc_acquisition_B_sph, geo_wc_acquisition_B_tri, geo_wc_acquisition_B_anal cannot be incorporated into
-    // ingredient_acquisition_B, since they are different for the 3 cases...
-    equip_geo_wildcards(ingredient_definition, ingredient_acquisition_A, geo_wc_acquisition_B_sph,
-                        geo_wc_acquisition_B_tri, geo_wc_acquisition_B_anal, added_geo_wildcards);
-    // Currently, owner_wildcard_write_back and geo_wildcard_write_back might be blank, since give the write-back
-    // control to the user, and they may need to use atomic operations (atomicExch or atomicAdd) to update the
-    // wildcards.
-
-    // Acq strategies may have moi acq strategy in them that needs to be replaced first...
-    ingredient_acquisition_A = replace_patterns(ingredient_acquisition_A, strMap);
-    ingredient_acquisition_B = replace_patterns(ingredient_acquisition_B, strMap);
-
-    // Check if force, and wildcards are all defined in the model
-    std::string non_match;
-    if (!all_whole_word_match(model, contact_wildcard_names, non_match))
-        DEME_WARNING(
-            "Contact wildcard(s) %s are not used/set in your custom force model. "
-            "Your force model will probably not produce what you expect.",
-            non_match.c_str());
-    if (!all_whole_word_match(model, owner_wildcard_names, non_match))
-        DEME_WARNING(
-            "Owner wildcard(s) %s are not used/set in your custom force model. "
-            "Your force model will probably not produce what you expect.",
-            non_match.c_str());
-    if (!all_whole_word_match(model, geo_wildcard_names, non_match))
-        DEME_WARNING(
-            "Geometry wildcard(s) %s are not used/set in your custom force model. "
-            "Your force model will probably not produce what you expect.",
-            non_match.c_str());
-    if (!all_whole_word_match(model, {"force"}, non_match)) {
-        DEME_WARNING(
-            "Your custom force model does not set the %s variable at all. "
-            "You probably will not see any contact in the simulation.",
-            non_match.c_str());
-    }
-
-    // For contact wildcards, it needs to be brought from the global memory, and we expect the user's force model to use
-    // and modify them, and in the end we will write them back to global mem.
-    equip_contact_wildcards(cnt_wildcard_acquisition, cnt_wildcard_write_back, cnt_wildcard_destroy_record,
-                            contact_wildcard_names);
-
-    // If the user wants to reduce force in the calculation kernel...
-    std::string whether_reduce_in_kernel = " ";
-    if (collect_force_in_force_kernel) {
-        whether_reduce_in_kernel = FORCE_REDUCTION_RIGHT_AFTER_CALC_STRAT();
+    equip_force_model(strMap, force_kernel_ingredient_stats, m_force_model->m_force_model,
+                      m_force_model->m_contact_wildcards, m_force_model->m_owner_wildcards,
+                      m_force_model->m_geo_wildcards, collect_force_in_force_kernel, !no_recording_contact_forces,
+                      ensure_kernel_line_num, m_owner_wc_num, m_geo_wc_num, m_cnt_wc_num, verbosity);
+
+    // A force record policy decides per family pair what to write back
+    if (use_force_record_policy && !no_recording_contact_forces) {
+        std::string contact_info_write_strat = FORCE_INFO_WRITE_BY_FAMILY_PAIR_STRAT();
+        if (ensure_kernel_line_num) {
+            contact_info_write_strat = compact_code(contact_info_write_strat);
+        }
+        strMap["_contactInfoWrite_"] = contact_info_write_strat;
     }
 
-    // If the user doesn't want to keep tab of contact forces...
-    std::string contact_info_write_strat = " ";
-    if (!no_recording_contact_forces) {
-        contact_info_write_strat = FORCE_INFO_WRITE_BACK_STRAT();
-    }
+    DEME_DEBUG_PRINTF("Model ingredient definition:\n%s", strMap["_forceModelIngredientDefinition_"].c_str());
 
-    if (ensure_kernel_line_num) {
-        model = compact_code(model);
-        ingredient_definition = compact_code(ingredient_definition);
-        ingredient_acquisition_A = compact_code(ingredient_acquisition_A);
-        ingredient_acquisition_B = compact_code(ingredient_acquisition_B);
-        whether_reduce_in_kernel = compact_code(whether_reduce_in_kernel);
-        contact_info_write_strat = compact_code(contact_info_write_strat);
-    }
-    strMap["_DEMForceModel_"] = model;
-    strMap["_forceModelIngredientDefinition_"] = ingredient_definition;
-    strMap["_forceModelIngredientAcqForA_"] = ingredient_acquisition_A;
-    strMap["_forceModelIngredientAcqForB_"] = ingredient_acquisition_B;
-    // Geo wildcard acquisition is contact type-dependent.
-    strMap["_forceModelGeoWildcardAcqForSph_"] = geo_wc_acquisition_B_sph;
-    strMap["_forceModelGeoWildcardAcqForTri_"] = geo_wc_acquisition_B_tri;
-    strMap["_forceModelGeoWildcardAcqForAnal_"] = geo_wc_acquisition_B_anal;
-
-    // This should be empty as of now...
-    strMap["_forceModelOwnerWildcardWrite_"] = owner_geo_wildcard_write_back;
-
-    strMap["_forceModelContactWildcardAcq_"] = cnt_wildcard_acquisition;
-    strMap["_forceModelContactWildcardWrite_"] = cnt_wildcard_write_back;
-    strMap["_forceModelContactWildcardDestroy_"] = cnt_wildcard_destroy_record;
-
-    strMap["_forceCollectInPlaceStrat_"] = whether_reduce_in_kernel;
-    strMap["_contactInfoWrite_"] = contact_info_write_strat;
-
-    DEME_DEBUG_PRINTF("Model ingredient definition:\n%s", ingredient_definition.c_str());
-
-    // DEME_DEBUG_PRINTF("Wildcard acquisition:\n%s", cnt_wildcard_acquisition.c_str());
-    // DEME_DEBUG_PRINTF("Wildcard write-back:\n%s", cnt_wildcard_write_back.c_str());
-    // DEME_DEBUG_PRINTF("Wildcard destroy inactive contacts:\n%s", cnt_wildcard_destroy_record.c_str());
-    // DEME_DEBUG_PRINTF("Contact info writing strategy:\n%s", contact_info_write_strat.c_str());
 }
 
 inline void DEMSolver::equipFamilyOnFlyChanges(std::unordered_map<std::string, std::string>& strMap) {
@@ -1441,11 +1604,12 @@ inline void DEMSolver::equipFamilyOnFlyChanges(std::unordered_map<std::string, s
 }
 
 inline void DEMSolver::equipFamilyPrescribedMotions(std::unordered_map<std::string, std::string>& strMap) {
-    std::string velStr = " ", posStr = " ", accStr = " ";
+    std::string velStr = " ", posStr = " ", accStr = " ", prescribedStr = " ";
     for (const auto& preInfo : m_unique_family_prescription) {
         if (!preInfo.used) {
             continue;
         }
+        prescribedStr += "case " + std::to_string(preInfo.family) + ": return true;";
         velStr += "case " + std::to_string(preInfo.family) + ": {";
         posStr += "case " + std::to_string(preInfo.family) + ": {";
         accStr += "case " + std::to_string(preInfo.family) + ": {";
@@ -1510,6 +1674,8 @@ inline void DEMSolver::equipFamilyPrescribedMotions(std::unordered_map<std::stri
     strMap["_velPrescriptionStrategy_"] = velStr;
     strMap["_posPrescriptionStrategy_"] = posStr;
     strMap["_accPrescriptionStrategy_"] = accStr;
+    // Used by the integrator to keep owners of these families awake
+    strMap["_prescribedFamilyCases_"] = prescribedStr;
 }
 
 // Family mask is no longer jitified... but stored in global array
@@ -1530,9 +1696,20 @@ inline void DEMSolver::equipAnalGeoTemplates(std::unordered_map<std::string, std
     // Some sim systems can have 0 boundary entities in them. In this case, we have to ensure jitification does not fail
     std::string objOwner, objType, objMat, objNormal, objRelPosX, objRelPosY, objRelPosZ, objRotX, objRotY, objRotZ,
         objSize1, objSize2, objSize3, objMass;
+    // kT keeps a host copy of what is jitified here, in case it runs contact detection on host threads
+    HostAnalyticalEntities& hostAnal = kT->hostAnalEntities;
+    hostAnal = HostAnalyticalEntities();
     for (unsigned int i = 0; i < nAnalGM; i++) {
         // External objects will be owners, and their IDs are following template-loaded simulation clumps
         bodyID_t myOwner = nOwnerClumps + m_anal_owner.at(i);
+        hostAnal.owner.push_back(myOwner);
+        hostAnal.type.push_back(m_anal_types.at(i));
+        hostAnal.relPos.push_back(m_anal_comp_pos.at(i));
+        hostAnal.rot.push_back(m_anal_comp_rot.at(i));
+        hostAnal.size1.push_back(m_anal_size_1.at(i));
+        hostAnal.size2.push_back(m_anal_size_2.at(i));
+        hostAnal.size3.push_back(m_anal_size_3.at(i));
+        hostAnal.normal.push_back(m_anal_normals.at(i));
         objOwner += std::to_string(myOwner) + ",";
         objType += std::to_string(m_anal_types.at(i)) + ",";
         objMat += std::to_string(m_anal_materials.at(i)) + ",";
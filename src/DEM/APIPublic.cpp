@@ -376,35 +376,51 @@ float3 DEMSolver::GetOwnerAcc(bodyID_t ownerID) const {
 float3 DEMSolver::GetOwnerAngAcc(bodyID_t ownerID) const {
     return dT->getOwnerAngAcc(ownerID);
 }
+float3 DEMSolver::GetOwnerContactForceSum(bodyID_t ownerID) const {
+    return dT->getOwnerCntForceSum(ownerID);
+}
+float3 DEMSolver::GetOwnerContactTorqueSum(bodyID_t ownerID) const {
+    return dT->getOwnerCntTorqueSum(ownerID);
+}
+unsigned int DEMSolver::GetOwnerNumAggregatedContacts(bodyID_t ownerID) const {
+    return dT->getOwnerCntNum(ownerID);
+}
 unsigned int DEMSolver::GetOwnerFamily(bodyID_t ownerID) const {
     return (unsigned int)(+(dT->familyID.at(ownerID)));
 }
 
 void DEMSolver::AddOwnerNextStepAcc(bodyID_t ownerID, float3 acc) {
+    dT->wakeOwner(ownerID);
     dT->accSpecified[ownerID] = 1;
     dT->aX[ownerID] = acc.x;
     dT->aY[ownerID] = acc.y;
     dT->aZ[ownerID] = acc.z;
 }
 void DEMSolver::AddOwnerNextStepAngAcc(bodyID_t ownerID, float3 angAcc) {
+    dT->wakeOwner(ownerID);
     dT->angAccSpecified[ownerID] = 1;
     dT->alphaX[ownerID] = angAcc.x;
     dT->alphaY[ownerID] = angAcc.y;
     dT->alphaZ[ownerID] = angAcc.z;
 }
 void DEMSolver::SetOwnerPosition(bodyID_t ownerID, float3 pos) {
+    dT->wakeOwner(ownerID);
     dT->setOwnerPos(ownerID, pos);
 }
 void DEMSolver::SetOwnerAngVel(bodyID_t ownerID, float3 angVel) {
+    dT->wakeOwner(ownerID);
     dT->setOwnerAngVel(ownerID, angVel);
 }
 void DEMSolver::SetOwnerVelocity(bodyID_t ownerID, float3 vel) {
+    dT->wakeOwner(ownerID);
     dT->setOwnerVel(ownerID, vel);
 }
 void DEMSolver::SetOwnerOriQ(bodyID_t ownerID, float4 oriQ) {
+    dT->wakeOwner(ownerID);
     dT->setOwnerOriQ(ownerID, oriQ);
 }
 void DEMSolver::SetOwnerFamily(bodyID_t ownerID, family_t fam) {
+    dT->wakeOwner(ownerID);
     kT->familyID.at(ownerID) = fam;
     dT->familyID.at(ownerID) = fam;
 }
@@ -442,18 +458,13 @@ void DEMSolver::SetTriNodeRelPos(size_t owner, size_t triID, const std::vector<f
             mesh->GetNumNodes(), new_nodes.size());
     }
     // We actually modify the cached mesh... since it has implications in output
-    for (size_t i = 0; i < mesh->GetNumNodes(); i++) {
-        mesh->m_vertices[i] = new_nodes[i];
+    mesh->m_vertices = new_nodes;
+    // Only the facets around the nodes that moved will be rewritten and sent
+    MeshNodeIndex& index = getMeshNodeIndex(owner);
+    for (size_t i = 0; i < new_nodes.size(); i++) {
+        index.SetNode(i, new_nodes[i]);
     }
-    std::vector<DEMTriangle> new_triangles(mesh->GetNumTriangles());
-    for (size_t i = 0; i < mesh->GetNumTriangles(); i++) {
-        new_triangles[i] = mesh->GetTriangle(i);
-    }
-    dT->setTriNodeRelPos(triID, new_triangles);
-    dT->solverFlags.willMeshDeform = true;
-
-    // kT just received update from dT, to avoid mem hazards
-    // kT->setTriNodeRelPos(triID, new_triangles);
+    sendMeshNodeUpdates(owner, triID);
 }
 void DEMSolver::UpdateTriNodeRelPos(size_t owner, size_t triID, const std::vector<float3>& updates) {
     auto& mesh = m_meshes.at(m_owner_mesh_map.at(owner));
@@ -463,21 +474,35 @@ void DEMSolver::UpdateTriNodeRelPos(size_t owner, size_t triID, const std::vecto
             "%zu nodes, yet the provided vector has length %zu.",
             mesh->GetNumNodes(), updates.size());
     }
-    // We actually modify the cached mesh... since it has implications in output
-    for (size_t i = 0; i < mesh->GetNumNodes(); i++) {
-        mesh->m_vertices[i] += updates[i];
-    }
     // No need to worry about RHR: that's taken care of at init
-    std::vector<DEMTriangle> new_triangles(mesh->GetNumTriangles());
-    for (size_t i = 0; i < mesh->GetNumTriangles(); i++) {
-        new_triangles[i] = mesh->GetTriangle(i);
+    MeshNodeIndex& index = getMeshNodeIndex(owner);
+    for (size_t i = 0; i < updates.size(); i++) {
+        index.SetNode(i, index.GetNodes()[i] + updates[i]);
+        // We actually modify the cached mesh... since it has implications in output
+        mesh->m_vertices[i] = index.GetNodes()[i];
+    }
+    sendMeshNodeUpdates(owner, triID);
+}
+void DEMSolver::SetTriNodeRelPos(size_t owner,
+                                 size_t triID,
+                                 const std::vector<size_t>& node_ids,
+                                 const std::vector<float3>& new_nodes) {
+    auto& mesh = m_meshes.at(m_owner_mesh_map.at(owner));
+    if (node_ids.size() != new_nodes.size()) {
+        DEME_ERROR("To move mesh nodes, %zu node IDs and %zu new node locations were given; they must be the same.",
+                   node_ids.size(), new_nodes.size());
+    }
+    MeshNodeIndex& index = getMeshNodeIndex(owner);
+    for (size_t i = 0; i < node_ids.size(); i++) {
+        if (node_ids[i] >= index.GetNumNodes()) {
+            DEME_ERROR("Node %zu does not exist: the mesh has %zu nodes.", node_ids[i], index.GetNumNodes());
+        }
+        index.SetNode(node_ids[i], new_nodes[i]);
+        mesh->m_vertices[node_ids[i]] = new_nodes[i];
     }
-    dT->setTriNodeRelPos(triID, new_triangles);
-    dT->solverFlags.willMeshDeform = true;
-
-    // kT just received update from dT, to avoid mem hazards
-    // kT->setTriNodeRelPos(triID, new_triangles);
+    sendMeshNodeUpdates(owner, triID);
 }
+
 std::shared_ptr<DEMMeshConnected>& DEMSolver::GetCachedMesh(bodyID_t ownerID) {
     if (m_owner_mesh_map.find(ownerID) == m_owner_mesh_map.end()) {
         DEME_ERROR("Owner %zu is not a mesh, you therefore cannot retrive a handle to mesh using it.", (size_t)ownerID);
@@ -497,6 +522,13 @@ std::vector<float3> DEMSolver::GetMeshNodesGlobal(bodyID_t ownerID) {
     return nodes;
 }
 
+double DEMSolver::GetTimeStepSize() const {
+    if (sys_initialized) {
+        return dT->simParams->h;
+    }
+    return m_ts_size;
+}
+
 double DEMSolver::GetSimTime() const {
     return dT->getSimTime();
 }
@@ -526,9 +558,62 @@ void DEMSolver::SetIntegrator(const std::string& intg) {
     }
 }
 
+void DEMSolver::SetFamilyPairForceRecord(unsigned int ID1, unsigned int ID2, const std::string& policy) {
+    assertSysNotInit("SetFamilyPairForceRecord");
+    if (ID1 > std::numeric_limits<family_t>::max() || ID2 > std::numeric_limits<family_t>::max()) {
+        DEME_ERROR(
+            "You tried to set the force record policy between family number %u and %u, but family number should not "
+            "be larger than %u.",
+            ID1, ID2, std::numeric_limits<family_t>::max());
+    }
+    familyPair_t a_pair;
+    a_pair.ID1 = ID1;
+    a_pair.ID2 = ID2;
+    m_input_force_record_pairs.push_back(std::make_pair(a_pair, forceRecordPolicyFromName(policy)));
+    use_force_record_policy = true;
+    collect_force_in_force_kernel = true;
+}
+
+void DEMSolver::SetDefaultForceRecord(const std::string& policy) {
+    assertSysNotInit("SetDefaultForceRecord");
+    m_default_force_record = forceRecordPolicyFromName(policy);
+    use_force_record_policy = true;
+    collect_force_in_force_kernel = true;
+}
+
+void DEMSolver::SetContactStoragePolicy(const std::string& policy) {
+    assertSysNotInit("SetContactStoragePolicy");
+    switch (hash_charr(policy.c_str())) {
+        case ("full"_):
+            cnt_storage_policy = CNT_STORAGE_POLICY::FULL;
+            break;
+        case ("compact"_):
+            cnt_storage_policy = CNT_STORAGE_POLICY::COMPACT;
+            break;
+        default:
+            DEME_ERROR("Contact storage policy %s is unknown. Please select another via SetContactStoragePolicy.",
+                       policy.c_str());
+    }
+}
+
+void DEMSolver::SetContactWildcardPrecision(const std::string& precision) {
+    assertSysNotInit("SetContactWildcardPrecision");
+    switch (hash_charr(precision.c_str())) {
+        case ("float"_):
+            use_bf16_contact_wildcards = false;
+            break;
+        case ("bf16"_):
+            use_bf16_contact_wildcards = true;
+            break;
+        default:
+            DEME_ERROR(
+                "Contact wildcard precision %s is unknown. Please select another via SetContactWildcardPrecision.",
+                precision.c_str());
+    }
+}
+
 void DEMSolver::SetAdaptiveTimeStepType(const std::string& type) {
-    DEME_WARNING(
-        "SetAdaptiveTimeStepType is currently not implemented and has no effect, time step size is still fixed.");
+    assertSysNotInit("SetAdaptiveTimeStepType");
     switch (hash_charr(type.c_str())) {
         case ("none"_):
             adapt_ts_type = ADAPT_TS_TYPE::NONE;
@@ -543,6 +628,32 @@ void DEMSolver::SetAdaptiveTimeStepType(const std::string& type) {
             DEME_ERROR("Adaptive time step type %s is unknown. Please select another via SetAdaptiveTimeStepType.",
                        type.c_str());
     }
+    ts_size_is_const = (adapt_ts_type == ADAPT_TS_TYPE::NONE);
+}
+
+void DEMSolver::SetAdaptiveTimeStepLimits(double min_ts, double max_ts) {
+    assertSysNotInit("SetAdaptiveTimeStepLimits");
+    if (min_ts < 0. || max_ts <= 0. || min_ts > max_ts) {
+        DEME_ERROR("SetAdaptiveTimeStepLimits needs 0 <= min_ts <= max_ts and a positive max_ts.");
+    }
+    m_adapt_ts_min = min_ts;
+    m_adapt_ts_max = max_ts;
+}
+
+void DEMSolver::SetAdaptiveTimeStepCriteria(float max_travel_ratio,
+                                            float max_overlap_ratio,
+                                            float rayleigh_fraction,
+                                            float max_growth) {
+    assertSysNotInit("SetAdaptiveTimeStepCriteria");
+    if (max_travel_ratio <= 0. || max_overlap_ratio <= 0. || rayleigh_fraction <= 0. || max_growth < 1.) {
+        DEME_ERROR(
+            "SetAdaptiveTimeStepCriteria needs positive travel ratio, overlap ratio and Rayleigh fraction, and a max "
+            "growth no less than 1.");
+    }
+    m_adapt_ts_travel_ratio = max_travel_ratio;
+    m_adapt_ts_overlap_ratio = max_overlap_ratio;
+    m_adapt_ts_rayleigh_fraction = rayleigh_fraction;
+    m_adapt_ts_max_growth = max_growth;
 }
 
 void DEMSolver::SetCDNumStepsMaxDriftHistorySize(unsigned int n) {
@@ -568,6 +679,38 @@ void DEMSolver::SetExpandSafetyType(const std::string& insp_type) {
     }
 }
 
+void DEMSolver::SetCDVerletSkin(float skin) {
+    assertSysNotInit("SetCDVerletSkin");
+    if (skin < 0.) {
+        DEME_ERROR("SetCDVerletSkin is called with a skin of %.7g, but the skin should not be smaller than 0.", skin);
+    }
+    m_cd_verlet_skin = skin;
+}
+
+void DEMSolver::InstructBoxDomainPeriodic(const std::string& dirs) {
+    assertSysNotInit("InstructBoxDomainPeriodic");
+    std::string upper_dirs = str_to_upper(dirs);
+    m_box_periodic_x = false;
+    m_box_periodic_y = false;
+    m_box_periodic_z = false;
+    if (upper_dirs == "NONE") {
+        return;
+    }
+    for (const char& dir : upper_dirs) {
+        if (dir == 'X') {
+            m_box_periodic_x = true;
+        } else if (dir == 'Y') {
+            m_box_periodic_y = true;
+        } else if (dir == 'Z') {
+            m_box_periodic_z = true;
+        } else {
+            DEME_ERROR("Unknown '%s' parameter in InstructBoxDomainPeriodic call.\nPlease pick a combination of X, Y "
+                       "and Z, or none.",
+                       dirs.c_str());
+        }
+    }
+}
+
 void DEMSolver::InstructBoxDomainDimension(float x, float y, float z, const std::string& dir_exact) {
     m_user_box_min = host_make_float3(-x / 2., -y / 2., -z / 2.);
     m_user_box_max = host_make_float3(x / 2., y / 2., z / 2.);
@@ -1336,6 +1479,7 @@ void DEMSolver::DisableContactBetweenFamilies(unsigned int ID1, unsigned int ID2
         unsigned int posInMat = locateMaskPair<unsigned int>(ID1, ID2);
         kT->familyMaskMatrix.at(posInMat) = PREVENT_CONTACT;
         dT->familyMaskMatrix.at(posInMat) = PREVENT_CONTACT;
+        kT->invalidateContactCandidates();
     }
 }
 
@@ -1355,6 +1499,7 @@ void DEMSolver::EnableContactBetweenFamilies(unsigned int ID1, unsigned int ID2)
         unsigned int posInMat = locateMaskPair<unsigned int>(ID1, ID2);
         kT->familyMaskMatrix.at(posInMat) = DONT_PREVENT_CONTACT;
         dT->familyMaskMatrix.at(posInMat) = DONT_PREVENT_CONTACT;
+        kT->invalidateContactCandidates();
     }
 }
 
@@ -1369,6 +1514,36 @@ void DEMSolver::SetFamilyExtraMargin(unsigned int N, float extra_size) {
     }
     kT->familyExtraMarginSize.at(N) = extra_size;
     dT->familyExtraMarginSize.at(N) = extra_size;
+    kT->invalidateContactCandidates();
+}
+
+void DEMSolver::SetFamilySubsteps(unsigned int N, unsigned int n_substeps) {
+    if (N > std::numeric_limits<family_t>::max()) {
+        DEME_ERROR("You are subcycling family %u, but family number should not be larger than %u.", N,
+                   std::numeric_limits<family_t>::max());
+    }
+    if (n_substeps == 0) {
+        DEME_ERROR("Family %u is set to take 0 substeps per time step, but it should take at least 1.", N);
+    }
+    dT->familySubcycled.at(N) = 0;
+    bool any_subcycled = std::any_of(dT->familySubcycled.begin(), dT->familySubcycled.end(),
+                                     [](notStupidBool_t subcycled) { return subcycled != 0; });
+    if (n_substeps > 1) {
+        if (any_subcycled && n_substeps != m_num_substeps) {
+            DEME_ERROR(
+                "Family %u is set to take %u substeps per time step, but other subcycled families take %u.\nAll "
+                "subcycled families should take the same number of substeps.",
+                N, n_substeps, m_num_substeps);
+        }
+        dT->familySubcycled.at(N) = 1;
+        m_num_substeps = n_substeps;
+    } else if (!any_subcycled) {
+        m_num_substeps = 1;
+    }
+    if (sys_initialized) {
+        assertSubcyclingCompatible();
+        dT->simParams->nSubsteps = m_num_substeps;
+    }
 }
 
 void DEMSolver::ClearCache() {
@@ -1441,7 +1616,7 @@ std::shared_ptr<DEMMeshConnected> DEMSolver::AddWavefrontMeshObject(const std::s
                                                                     bool load_normals,
                                                                     bool load_uv) {
     DEMMeshConnected mesh;
-    bool flag = mesh.LoadWavefrontMesh(filename, load_normals, load_uv);
+    bool flag = mesh.LoadMeshFile(filename, load_normals, load_uv);
     if (!flag) {
         DEME_ERROR("Failed to load in mesh file %s.", filename.c_str());
     }
@@ -1453,7 +1628,7 @@ std::shared_ptr<DEMMeshConnected> DEMSolver::AddWavefrontMeshObject(const std::s
                                                                     bool load_normals,
                                                                     bool load_uv) {
     DEMMeshConnected mesh;
-    bool flag = mesh.LoadWavefrontMesh(filename, load_normals, load_uv);
+    bool flag = mesh.LoadMeshFile(filename, load_normals, load_uv);
     if (!flag) {
         DEME_ERROR("Failed to load in mesh file %s.", filename.c_str());
     }
@@ -1517,7 +1692,7 @@ void DEMSolver::WriteClumpFile(const std::string& outfilename, unsigned int accu
 }
 
 void DEMSolver::WriteContactFile(const std::string& outfilename, float force_thres) const {
-    if (no_recording_contact_forces) {
+    if (no_recording_contact_forces || dT->solverFlags.useNoContactRecord) {
         DEME_WARNING(
             "The solver is instructed to not record contact force info, so no work is done in a WriteContactFile "
             "call.");
@@ -1668,11 +1843,104 @@ void DEMSolver::ShowTimingStats() {
     DEME_PRINTF("--------------------------\n");
 }
 
+void DEMSolver::GetTimingStats(std::vector<std::string>& names, std::vector<double>& vals, bool of_kT) {
+    if (of_kT) {
+        kT->getTiming(names, vals);
+    } else {
+        dT->getTiming(names, vals);
+    }
+}
+
 void DEMSolver::ClearTimingStats() {
     kT->resetTimers();
     dT->resetTimers();
 }
 
+void DEMSolver::EnableProfiling(bool use, size_t events_per_thread) {
+    if (use) {
+        kT->timers.GetProfiler().Enable(events_per_thread);
+        dT->timers.GetProfiler().Enable(events_per_thread);
+    } else {
+        kT->timers.GetProfiler().Disable();
+        dT->timers.GetProfiler().Disable();
+    }
+}
+
+void DEMSolver::WriteProfilingTrace(const std::string& outfilename) const {
+    const Profiler& kT_prof = kT->timers.GetProfiler();
+    const Profiler& dT_prof = dT->timers.GetProfiler();
+    if (kT_prof.GetNumDropped() + dT_prof.GetNumDropped() > 0) {
+        DEME_WARNING(
+            "The profiler ring buffers were full, and %zu (kT) and %zu (dT) of the oldest events were overwritten.\n"
+            "You can make the buffers larger via EnableProfiling, or write out traces more often.",
+            kT_prof.GetNumDropped(), dT_prof.GetNumDropped());
+    }
+    std::ofstream traceFile(outfilename, std::ios::out);
+    Profiler::WriteChromeTrace(traceFile, {&kT_prof, &dT_prof});
+}
+
+void DEMSolver::ClearProfilingTrace() {
+    kT->timers.GetProfiler().Clear();
+    dT->timers.GetProfiler().Clear();
+}
+
+void DEMSolver::EnableSleeping(float lin_vel_thres,
+                               float ang_vel_thres,
+                               unsigned int n_steps,
+                               float wake_force_thres) {
+    if (n_steps == 0) {
+        DEME_ERROR("EnableSleeping needs a positive number of quiescent steps before an owner falls asleep.");
+    }
+    if (lin_vel_thres < 0. || ang_vel_thres < 0. || wake_force_thres < 0.) {
+        DEME_ERROR("EnableSleeping needs non-negative velocity and force thresholds.");
+    }
+    m_sleep_steps = n_steps;
+    m_sleep_lin_vel = lin_vel_thres;
+    m_sleep_ang_vel = ang_vel_thres;
+    m_wake_force = wake_force_thres;
+    if (sys_initialized) {
+        transferSleepParams();
+    }
+}
+
+void DEMSolver::DisableSleeping() {
+    m_sleep_steps = 0;
+    if (sys_initialized) {
+        transferSleepParams();
+    }
+}
+
+void DEMSolver::EnableMetrics(const std::string& outfilename,
+                              OUTPUT_FORMAT format,
+                              unsigned int sample_every_n_steps,
+                              size_t ring_capacity) {
+    if (format != OUTPUT_FORMAT::CSV && format != OUTPUT_FORMAT::BINARY) {
+        DEME_ERROR("Metrics can only be written in OUTPUT_FORMAT::CSV or OUTPUT_FORMAT::BINARY.");
+    }
+    dT->metricsEnabled = false;
+    dT->metricsSink.Close();
+    dT->metricsSink.SetCapacity(ring_capacity);
+    if (!outfilename.empty() && !dT->metricsSink.Open(outfilename, format == OUTPUT_FORMAT::BINARY)) {
+        DEME_ERROR("Failed to open %s for writing metrics.", outfilename.c_str());
+    }
+    dT->metricsSampleEvery = sample_every_n_steps;
+    dT->metricsAccountedWaitSeconds = dT->timers.GetTimer(DT_WAIT_FOR_KT).GetTimeSeconds();
+    dT->metricsEnabled = true;
+}
+
+void DEMSolver::DisableMetrics() {
+    dT->metricsEnabled = false;
+    dT->metricsSink.Close();
+}
+
+void DEMSolver::FlushMetrics() {
+    dT->metricsSink.Flush();
+}
+
+std::vector<SolverMetrics> DEMSolver::GetRecentMetrics(size_t n) const {
+    return dT->metricsSink.GetRecent(n);
+}
+
 void DEMSolver::ReleaseFlattenedArrays() {
     deallocate_array(m_family_mask_matrix);
 
@@ -1763,6 +2031,8 @@ void DEMSolver::UpdateStepSize(float ts) {
         kT->simParams->h = ts;
         dT->simParams->h = ts;
     }
+    // With adaptive time stepping, this is where the step size adapts from
+    dT->stepController.Reset(dT->simParams->h);
 }
 
 void DEMSolver::UpdateClumps() {
@@ -1777,16 +2047,36 @@ void DEMSolver::UpdateClumps() {
             "point.\nNumber of analytical objects at last initialization: %u\nNumber of analytical objects now: %u",
             nLastTimeExtObjLoad, nExtObjLoad);
     }
-    if (nLastTimeClumpTemplateLoad != nClumpTemplateLoad) {
+    // Family prescriptions live in the kernels, so they can only come with a re-initialization
+    if (nLastTimeFamilyPreNum != m_input_family_prescription.size()) {
+        DEME_ERROR(
+            "UpdateClumps should not be used if you introduce new family prescription (which will need "
+            "re-jitification).\nWe used to have %u family prescription, now we have %zu.",
+            nLastTimeFamilyPreNum, m_input_family_prescription.size());
+    }
+    // New clump templates are fine as long as they are flattened: then existing clumps keep their template numbers,
+    // and the kernels bring the components and mass properties of the new ones from global memory. Jitified templates
+    // are sorted by size and their mass properties are laid out before those of analytical objects and meshes, so new
+    // templates would shift existing offsets.
+    const bool new_templates = (nLastTimeClumpTemplateLoad != nClumpTemplateLoad);
+    if (new_templates && (jitify_clump_templates || jitify_mass_moi)) {
         DEME_ERROR(
-            "UpdateClumps cannot be used after loading new clump templates. Consider re-initializing at this "
-            "point.\nNumber of clump templates at last initialization: %zu\nNumber of clump templates now: %zu",
+            "UpdateClumps can take new clump templates only if clump templates and mass properties are not "
+            "jitified.\nNumber of clump templates at last initialization: %zu\nNumber of clump templates now: "
+            "%zu\nConsider calling SetJitifyClumpTemplates(false) and SetJitifyMassProperties(false) before "
+            "initialization, or re-initializing at this point.",
             nLastTimeClumpTemplateLoad, nClumpTemplateLoad);
     }
-    // DEME_WARNING(
-    //     "UpdateClumps will add all currently cached clumps to the simulation.\nYou may want to ClearCache first,"
-    //     "then AddClumps, then call this method, so the clumps cached earlier are forgotten before this method takes"
-    //     "place.");
+    // Likewise, new meshes need their mass properties in global memory
+    const bool new_meshes = (cached_mesh_objs.size() > 0);
+    if (new_meshes && jitify_mass_moi) {
+        DEME_ERROR(
+            "UpdateClumps can take new meshed objects only if mass properties are not jitified.\nConsider calling "
+            "SetJitifyMassProperties(false) before initialization, or re-initializing at this point.");
+    }
+    // Material properties are always jitified, but only the force calculation kernels use them, so new materials just
+    // mean re-compiling those
+    const bool new_materials = (nLastTimeMatNum != m_loaded_materials.size());
 
     // This method requires kT and dT are sync-ed
     // resetWorkerThreads();
@@ -1802,24 +2092,28 @@ void DEMSolver::UpdateClumps() {
 
     preprocessClumps();
     preprocessClumpTemplates();
-    //// TODO: This method should also work on newly added meshes
+    preprocessTriangleObjs();
     updateTotalEntityNum();
+    // New templates may have bigger spheres, which need more bin levels in hierarchical binning
+    updateSphereRadiusRange();
+    kT->stateParams.maxSphereRadius = m_largest_radius;
     allocateGPUArrays();
     // `Update' method needs to know the number of existing clumps and spheres (before this addition)
     updateClumpMeshArrays(nOwners_old, nClumps_old, nSpheres_old, nTriMesh_old, nFacets_old, nExtObj_old, nAnalGM_old);
     packDataPointers();
+    // Only the pieces of jitified data that changed are re-compiled
+    if (new_templates || new_materials) {
+        updateJitifiedData(new_templates, new_materials);
+    }
     ReleaseFlattenedArrays();
     // Updating clumps is very critical
     dT->announceCritical();
 
-    // This method should not introduce new material or clump template or family prescription, let's check that
-    if (nLastTimeMatNum != m_loaded_materials.size() || nLastTimeFamilyPreNum != m_input_family_prescription.size()) {
-        DEME_ERROR(
-            "UpdateClumps should not be used if you introduce new material types or family prescription (which will "
-            "need re-jitification).\nWe used to have %u materials, now we have %zu.\nWe used to have %u family "
-            "prescription, now we have %zu.",
-            nLastTimeMatNum, m_loaded_materials.size(), nLastTimeFamilyPreNum, m_input_family_prescription.size());
-    }
+    nLastTimeClumpTemplateLoad = nClumpTemplateLoad;
+    nLastTimeClumpTemplateNum = m_templates.size();
+    nLastTimeBatchClumpsLoad = nBatchClumpsLoad;
+    nLastTimeTriObjLoad = nTriObjLoad;
+    nLastTimeMatNum = m_loaded_materials.size();
 
     // After Initialize or UpdateClumps, we should clear host-side initialization object cache
     ClearCache();
@@ -1840,6 +2134,14 @@ void DEMSolver::ChangeClumpSizes(const std::vector<bodyID_t>& IDs, const std::ve
     // This method requires kT and dT are sync-ed
     // resetWorkerThreads();
 
+    // The largest sphere may have grown. It is not worth finding the actual new largest sphere: the bound given by
+    // the largest factor at most adds a bin level in hierarchical binning.
+    float max_factor = 1.f;
+    for (const auto factor : factors)
+        max_factor = DEME_MAX(max_factor, factor);
+    m_largest_radius *= max_factor;
+    kT->stateParams.maxSphereRadius = m_largest_radius;
+
     std::thread dThread = std::move(std::thread([this, IDs, factors]() { this->dT->changeOwnerSizes(IDs, factors); }));
     std::thread kThread = std::move(std::thread([this, IDs, factors]() { this->kT->changeOwnerSizes(IDs, factors); }));
     dThread.join();
@@ -1889,6 +2191,153 @@ void DEMSolver::DoDynamicsThenSync(double thisCallDuration) {
     resetWorkerThreads();
 }
 
+void DEMSolver::ShowMemoryPoolStats() {
+    auto show_pool = [&](const char* name, const MemoryPoolStats& stats) {
+        DEME_PRINTF("%s: %s in use (peak %s), %s cached, %s reserved at peak\n", name,
+                    pretty_format_bytes(stats.bytesInUse).c_str(), pretty_format_bytes(stats.peakBytesInUse).c_str(),
+                    pretty_format_bytes(stats.bytesCached).c_str(),
+                    pretty_format_bytes(stats.peakBytesReserved).c_str());
+        DEME_PRINTF("%s: %zu requests, %zu served from cache, %zu backend allocations, %zu backend frees\n", name,
+                    stats.numRequests, stats.numCacheHits, stats.numBackendAllocs, stats.numBackendFrees);
+    };
+    DEME_PRINTF("\n~~ MEMORY POOL STATISTICS ~~\n");
+    show_pool("Managed memory pool", GetManagedMemoryPoolStats());
+    int n_devices = 0;
+    DEME_GPU_CALL(cudaGetDeviceCount(&n_devices));
+    for (int i = 0; i < n_devices; i++) {
+        MemoryPoolStats stats = GetDeviceMemoryPoolStats(i);
+        if (stats.numRequests == 0)
+            continue;
+        std::string name = "Device " + std::to_string(i) + " memory pool";
+        show_pool(name.c_str(), stats);
+    }
+    DEME_PRINTF("--------------------------\n");
+}
+
+MemoryPoolStats DEMSolver::GetManagedMemoryPoolStats() const {
+    return ManagedMemoryPool().GetStats();
+}
+
+MemoryPoolStats DEMSolver::GetDeviceMemoryPoolStats(int device) const {
+    return DeviceMemoryPool(device).GetStats();
+}
+
+size_t DEMSolver::TrimMemoryPools(size_t keep_bytes) {
+    size_t released = ManagedMemoryPool().Trim(keep_bytes);
+    int n_devices = 0;
+    DEME_GPU_CALL(cudaGetDeviceCount(&n_devices));
+    for (int i = 0; i < n_devices; i++) {
+        released += DeviceMemoryPool(i).Trim(keep_bytes);
+    }
+    DEME_INFO("Memory pools released %s back to the system.", pretty_format_bytes(released).c_str());
+    return released;
+}
+
+MemoryReport DEMSolver::GetMemoryReport() const {
+    MemoryReport report;
+    for (const auto& rec : kT->memRegistry.GetRecords())
+        report.addRecord(rec);
+    for (const auto& rec : dT->memRegistry.GetRecords())
+        report.addRecord(rec);
+    report.managedPool = ManagedMemoryPool().GetStats();
+    report.devicePool = DeviceMemoryPool(dT->streamInfo.device).GetStats();
+    queryDeviceMemory(report);
+    return report;
+}
+
+void DEMSolver::ShowMemoryReport(size_t min_bytes) {
+    MemoryReport report = GetMemoryReport();
+    std::sort(report.records.begin(), report.records.end(),
+              [](const MemoryRecord& a, const MemoryRecord& b) { return a.bytes > b.bytes; });
+    for (const std::string owner : {"kT", "dT"}) {
+        DEME_PRINTF("\n~~ %s MEMORY USAGE ~~\n", owner.c_str());
+        size_t small_bytes = 0, n_small = 0;
+        for (const auto& rec : report.records) {
+            if (rec.owner != owner)
+                continue;
+            if (rec.bytes < min_bytes) {
+                small_bytes += rec.bytes;
+                n_small++;
+                continue;
+            }
+            DEME_PRINTF("%s (%s): %s, peak %s\n", rec.name.c_str(), rec.onDevice ? "device" : "managed",
+                        pretty_format_bytes(rec.bytes).c_str(), pretty_format_bytes(rec.peakBytes).c_str());
+        }
+        if (n_small > 0) {
+            DEME_PRINTF("%zu other arrays: %s\n", n_small, pretty_format_bytes(small_bytes).c_str());
+        }
+        DEME_PRINTF("%s total: %s\n", owner.c_str(),
+                    pretty_format_bytes(owner == "kT" ? report.kTBytes : report.dTBytes).c_str());
+    }
+    DEME_PRINTF("\nTotal: %s (%s managed, %s device), sum of peaks %s\n",
+                pretty_format_bytes(report.totalBytes).c_str(), pretty_format_bytes(report.managedBytes).c_str(),
+                pretty_format_bytes(report.deviceBytes).c_str(), pretty_format_bytes(report.peakBytes).c_str());
+    DEME_PRINTF("Cached by memory pools on top of that: %s managed, %s device\n",
+                pretty_format_bytes(report.managedPool.bytesCached).c_str(),
+                pretty_format_bytes(report.devicePool.bytesCached).c_str());
+    DEME_PRINTF("Device %d: %s free of %s\n", dT->streamInfo.device,
+                pretty_format_bytes(report.deviceFreeBytes).c_str(),
+                pretty_format_bytes(report.deviceTotalBytes).c_str());
+    DEME_PRINTF("--------------------------\n");
+}
+
+MemoryReport DEMSolver::PredictMemoryUsage(size_t n_owners,
+                                           size_t n_spheres,
+                                           size_t n_triangles,
+                                           size_t n_contacts) const {
+    // Templates and analytical objects that are loaded, including those not yet initialized. The flags deciding which
+    // arrays exist are derived from the cached instructions, as before Initialize they are not transferred yet.
+    ManagedArraySizes n;
+    deriveArrayFlags(n);
+    n.nOwnerBodies = n_owners;
+    n.nSpheresGM = n_spheres;
+    n.nTriGM = n_triangles;
+    n.nAnalGM = nAnalGM;
+    for (const auto& ext_obj : cached_extern_objs)
+        n.nAnalGM += ext_obj->entity_params.size();
+    n.nMassProperties = m_templates.size() + nExtObj + cached_extern_objs.size() + nTriMeshes + cached_mesh_objs.size();
+    for (const auto& clump_template : m_templates)
+        n.nClumpComponents += clump_template->nComp;
+    n.nContacts = (n_contacts > 0) ? n_contacts : n_spheres * DEME_INIT_CNT_MULTIPLIER;
+    n.nFullRecordContacts = dT->fullRecordArraySize(n.nContacts, n.useForceRecordPolicy);
+    n.nContactWildcards = m_force_model->m_contact_wildcards.size();
+    n.nOwnerWildcards = m_force_model->m_owner_wildcards.size();
+    n.nGeoWildcards = m_force_model->m_geo_wildcards.size();
+
+    // Run the allocation code of kT and dT in sizing mode, so the prediction is exactly what they would allocate
+    MemoryRegistry kT_sizes("kT"), dT_sizes("dT");
+    kT->sizeManagedArrays(n, kT_sizes, dT_sizes);
+    dT->sizeManagedArrays(n, dT_sizes);
+    MemoryReport report;
+    for (const auto& rec : kT_sizes.GetRecords())
+        report.addRecord(rec);
+    for (const auto& rec : dT_sizes.GetRecords())
+        report.addRecord(rec);
+
+    // Scratch space and temp arrays are sized by contact detection and force collection at run time. If this solver
+    // has run, their peaks are extrapolated: kT's by the number of spheres, dT's by the number of contacts.
+    auto extrapolate_scratch = [&](const MemoryRegistry& registry, size_t measured_n, size_t predicted_n) {
+        if (measured_n == 0)
+            return;
+        for (auto rec : registry.GetRecords()) {
+            if (rec.name != "cubScratchSpace" && rec.name.rfind("threadTempVectors", 0) != 0)
+                continue;
+            rec.bytes = (size_t)((double)rec.peakBytes * predicted_n / measured_n);
+            rec.peakBytes = rec.bytes;
+            report.addRecord(rec);
+        }
+    };
+    if (sys_initialized) {
+        extrapolate_scratch(kT->memRegistry, nSpheresGM, n.nSpheresGM);
+        extrapolate_scratch(dT->memRegistry, *dT->stateOfSolver_resources.pNumContacts, n.nContacts);
+    }
+
+    report.managedPool = ManagedMemoryPool().GetStats();
+    report.devicePool = DeviceMemoryPool(dT->streamInfo.device).GetStats();
+    queryDeviceMemory(report);
+    return report;
+}
+
 void DEMSolver::ShowThreadCollaborationStats() {
     DEME_PRINTF("\n~~ kT--dT CO-OP STATISTICS ~~\n");
     DEME_PRINTF("Number of steps dynamic executed: %zu\n", dT->nTotalSteps);
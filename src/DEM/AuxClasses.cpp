@@ -583,6 +583,11 @@ void DEMTracker::UpdateMesh(const std::vector<std::vector<float>>& new_nodes) {
     UpdateMesh(float3_nodes);
 }
 
+void DEMTracker::UpdateMeshNodes(const std::vector<size_t>& node_ids, const std::vector<float3>& new_nodes) {
+    assertMesh("UpdateMeshNodes");
+    sys->SetTriNodeRelPos(obj->ownerID, obj->geoID, node_ids, new_nodes);
+}
+
 // Deformation is per-node, yet UpdateTriNodeRelPos need per-triangle info.
 void DEMTracker::UpdateMeshByIncrement(const std::vector<float3>& deformation) {
     assertMesh("UpdateMeshByIncrement");
@@ -220,6 +220,11 @@ class DEMTracker {
     /// nodes in the tracked mesh.
     void UpdateMeshByIncrement(const std::vector<float3>& deformation);
     void UpdateMeshByIncrement(const std::vector<std::vector<float>>& deformation);
+    /// @brief Move only some of the mesh nodes. Only the facets that use these nodes are re-sent to the solver, so
+    /// this is the cheap way to apply localized deformation to a large mesh.
+    /// @param node_ids The nodes to move.
+    /// @param new_nodes New locations (relative to the mesh CoM, like in UpdateMesh) of these nodes.
+    void UpdateMeshNodes(const std::vector<size_t>& node_ids, const std::vector<float3>& new_nodes);
     /// @brief Get a handle for the mesh this tracker is tracking.
     /// @return Pointer to the mesh.
     std::shared_ptr<DEMMeshConnected>& GetMesh();
@@ -329,6 +334,7 @@ class DEMForceModel {
 
   public:
     friend class DEMSolver;
+    friend class DEMForceModelHarness;
 
     DEMForceModel(FORCE_MODEL model_type = FORCE_MODEL::CUSTOM) { SetForceModelType(model_type); }
     ~DEMForceModel() {}
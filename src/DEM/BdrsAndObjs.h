@@ -227,6 +227,66 @@ class DEMExternObj : public DEMInitializer {
     }
 };
 
+/// Settings of DEMMeshConnected::Decimate
+struct MeshDecimationSettings {
+    /// Edges shorter than this get collapsed. For boundary meshes, something like the smallest sphere radius in the
+    /// simulation is a good choice, since finer facets do not make contacts with the spheres more accurate.
+    float target_edge_length = 0.f;
+    /// Max distance that the decimated surface may move away from the original one
+    float max_deviation = 0.f;
+    /// Collapse edges of any length if the collapse does not change the geometry (it happens inside coplanar patches),
+    /// so flat regions end up with as few facets as possible
+    bool merge_coplanar = true;
+    /// Two adjacent facets whose normals differ by less than this angle (in degrees) belong to the same coplanar patch
+    float coplanar_angle_tol = 0.5f;
+    /// A collapse is rejected if it turns the normal of a remaining facet by more than this angle (in degrees)
+    float max_normal_change = 45.f;
+};
+
+/// What DEMMeshConnected::Decimate did
+struct MeshDecimationReport {
+    size_t original_num_triangles = 0;
+    size_t num_triangles = 0;
+    size_t num_removed = 0;
+    /// Max distance between the original and the decimated surface (measured from the nodes of either to the other)
+    double max_deviation = 0.;
+    /// Coplanar patches (of more than one facet) of the decimated mesh, as finite plates
+    std::vector<DEMPlateParams_t> coplanar_patches;
+    /// The facets of the decimated mesh that make up each coplanar patch
+    std::vector<std::vector<size_t>> patch_facets;
+};
+
+/// What DEMMeshConnected::ComputeMassProperties found, at unit density (multiply volume and inertia by the density to
+/// get the real mass properties)
+struct MeshMassProperties {
+    double volume = 0.;
+    /// Volume centroid, in the mesh's own frame
+    float3 center = make_float3(0.f);
+    /// Inertia tensor about the centroid, in the mesh's own axes: Ixx, Iyy, Izz, Ixy, Iyz, Izx (products of inertia
+    /// are the tensor's off-diagonal entries, so Ixy = -integral of xy)
+    double inertia[6] = {0., 0., 0., 0., 0., 0.};
+    /// Principal moments of inertia, in ascending order
+    float3 principal_inertia = make_float3(0.f);
+    /// Orientation of the principal frame in the mesh's own frame. Call InformCentroidPrincipal(center, principal_Q)
+    /// to bring the mesh to its centroid and principal system.
+    float4 principal_Q = host_make_float4(0, 0, 0, 1);
+
+    /// If false, the mesh has open or non-manifold edges, and the numbers above are those of the closed-up mesh
+    bool watertight = true;
+    /// Edges used by only one facet (after nodes at identical locations are merged)
+    size_t num_boundary_edges = 0;
+    /// Edges used by more than two facets
+    size_t num_nonmanifold_edges = 0;
+    /// Boundary loops that got closed with a fan of facets for the computation
+    size_t num_holes_closed = 0;
+    /// Facets whose winding disagreed with their neighbors, and were counted as flipped
+    size_t num_flipped_facets = 0;
+    /// Connected parts of the mesh that were inside out (negative volume), and were counted as flipped
+    size_t num_inverted_shells = 0;
+    /// Facets with zero area, which are ignored
+    size_t num_degenerate_facets = 0;
+};
+
 // DEM mesh object
 class DEMMeshConnected : public DEMInitializer {
   private:
@@ -319,19 +379,27 @@ class DEMMeshConnected : public DEMInitializer {
 
     DEMMeshConnected() { obj_type = OWNER_TYPE::MESH; }
     DEMMeshConnected(std::string input_file) {
-        LoadWavefrontMesh(input_file);
+        LoadMeshFile(input_file);
         obj_type = OWNER_TYPE::MESH;
     }
     DEMMeshConnected(std::string input_file, const std::shared_ptr<DEMMaterial>& mat) {
-        LoadWavefrontMesh(input_file);
+        LoadMeshFile(input_file);
         SetMaterial(mat);
         obj_type = OWNER_TYPE::MESH;
     }
     ~DEMMeshConnected() {}
 
-    /// Load a triangle mesh saved as a Wavefront .obj file
+    /// Load a triangle mesh saved as a Wavefront .obj file. Polygon faces are triangulated as fans, and negative
+    /// (relative) indices are supported.
     bool LoadWavefrontMesh(std::string input_file, bool load_normals = true, bool load_uv = false);
 
+    /// Load a triangle mesh saved as a binary .stl file. Vertices shared by facets are merged, and facet normals are
+    /// loaded as per-face normals.
+    bool LoadSTLMesh(std::string input_file, bool load_normals = true);
+
+    /// Load a triangle mesh from a file, using the STL loader for .stl files and the Wavefront loader otherwise.
+    bool LoadMeshFile(std::string input_file, bool load_normals = true, bool load_uv = false);
+
     /// Write the specified meshes in a Wavefront .obj file
     static void WriteWavefront(const std::string& filename, std::vector<DEMMeshConnected>& meshes);
 
@@ -390,10 +458,32 @@ class DEMMeshConnected : public DEMInitializer {
         SetMaterial(std::vector<std::shared_ptr<DEMMaterial>>(nTri, input));
     }
 
-    /*
-    /// Compute barycenter, mass and MOI in CoM frame
-    void ComputeMassProperties(double& mass, float3& center, float3& inertia);
+    /// Compute the volume, the volume centroid and the diagonal of the inertia tensor (about the centroid, in the
+    /// mesh's own axes) of this mesh, assuming unit density. Multiply mass and inertia by the density to get the real
+    /// mass properties.
+    void ComputeMassProperties(double& mass, float3& center, float3& inertia) const;
+    /// Compute the mass properties of this mesh at unit density, including its principal frame, using num_threads
+    /// threads (0 means all hardware threads). The mesh does not have to be clean: nodes at identical locations are
+    /// merged, inconsistently wound facets and inside-out parts are flipped, and holes are closed for the computation
+    /// (the mesh itself is not changed), and what was fixed is reported. The result does not depend on num_threads.
+    MeshMassProperties ComputeMassProperties(unsigned int num_threads = 0) const;
+
+    /// Decimate this mesh with quadric error edge collapses: edges shorter than settings.target_edge_length (and, if
+    /// settings.merge_coplanar, edges inside flat regions) are collapsed, while the surface stays within
+    /// settings.max_deviation of the original one. Open boundaries are preserved, and facets of different materials
+    /// are not merged. Per-facet materials and geometry wildcards follow the remaining facets; per-vertex normals, UV
+    /// and colors are dropped. Call it before the mesh is added to a simulation.
+    MeshDecimationReport Decimate(const MeshDecimationSettings& settings);
+    /// Decimate this mesh for a simulation whose smallest sphere has radius min_sphere_radius: the target edge length
+    /// is that radius and the max deviation is 5% of it.
+    MeshDecimationReport Decimate(float min_sphere_radius) {
+        MeshDecimationSettings settings;
+        settings.target_edge_length = min_sphere_radius;
+        settings.max_deviation = 0.05 * min_sphere_radius;
+        return Decimate(settings);
+    }
 
+    /*
     /// Create a map of neighboring triangles, vector of:
     /// [Ti TieA TieB TieC]
     /// (the free sides have triangle id = -1).
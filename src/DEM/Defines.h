@@ -30,6 +30,8 @@ namespace deme {
 #define DEME_BITS_PER_BYTE 8
 #define DEME_CUDA_WARP_SIZE 32
 #define DEME_MAX_WILDCARD_NUM 8
+// Max number of levels of bins in hierarchical binning. The bins of level l are 2^l times as large as the base bins.
+#define DEME_MAX_BIN_LEVELS 8
 // In bin--triangle intersection scan, all bins are enlarged by a factor of this following constant, so that no triangle
 // lies in between bins and not picked up by any bins.
 #define DEME_BIN_ENLARGE_RATIO_FOR_FACETS 0.001
@@ -49,7 +51,12 @@ constexpr int64_t MAX_SUBVOXEL = (int64_t)1 << VOXEL_RES_POWER2;
 #define DEME_NUM_BODIES_PER_BLOCK 1024
 #define DEME_NUM_TRIANGLE_PER_BLOCK 512
 #define DEME_MAX_THREADS_PER_BLOCK 1024
+// Number of threads per block in the owner-blocked force collection kernel, which holds one entry per thread in shared
+// memory
+#define DEME_COMPACT_COLLECT_NTHREADS_PER_BLOCK 256
 #define DEME_INIT_CNT_MULTIPLIER 2
+// When a contact-based buffer or a temp array must grow, it grows to at least this multiple of its old capacity
+#define DEME_BUFFER_GROWTH_FACTOR 1.5
 // If there are more than this number of analytical geometry, we may have difficulty jitify them all
 #define DEME_THRESHOLD_TOO_MANY_ANAL_GEO 64
 // If a clump has more than this number of sphere components, it is automatically considered a non-jitifiable big clump
@@ -80,6 +87,10 @@ const contact_t SPHERE_CONE_CONTACT = 14;
 
 const notStupidBool_t DONT_PREVENT_CONTACT = 0;
 const notStupidBool_t PREVENT_CONTACT = 1;
+// How the contacts between a pair of families are recorded (see SetFamilyPairForceRecord)
+const notStupidBool_t CNT_RECORD_NONE = 0;
+const notStupidBool_t CNT_RECORD_AGGREGATE = 1;
+const notStupidBool_t CNT_RECORD_FULL = 2;
 
 // Codes for owner types. We just have a handful of types...
 const ownerType_t OWNER_T_CLUMP = 1;
@@ -195,6 +206,15 @@ struct DEMSimParams {
     double voxelSize;
     // The edge length of a bin (for contact detection)
     double binSize;
+    // Number of levels of bins (1 unless hierarchical binning is in use). The bins of level l have edge length
+    // binSize * 2^l, and level 0 is the nbX by nbY by nbZ grid.
+    unsigned int nBinLevels;
+    // Number of bins of each level in the X, Y and Z directions
+    binID_t nbXLevel[DEME_MAX_BIN_LEVELS];
+    binID_t nbYLevel[DEME_MAX_BIN_LEVELS];
+    binID_t nbZLevel[DEME_MAX_BIN_LEVELS];
+    // ID of the first bin of each level: the bins of a level are numbered after those of the finer levels
+    binID_t binLevelOffset[DEME_MAX_BIN_LEVELS];
     // Number of clumps, spheres, triangles, mesh-represented objects, analytical components, external objs...
     bodyID_t nSpheresGM;
     bodyID_t nTriGM;
@@ -221,6 +241,18 @@ struct DEMSimParams {
     // User's box size
     float3 userBoxMin;
     float3 userBoxMax;
+    // Whether the X, Y and Z directions are periodic. In a periodic direction, positions are wrapped into [periodStart,
+    // periodStart + period) (relative to the LBF point, like all kernel-side positions), which is the span of the
+    // user's box in that direction.
+    bool periodicX = false;
+    bool periodicY = false;
+    bool periodicZ = false;
+    double periodStartX = 0;
+    double periodStartY = 0;
+    double periodStartZ = 0;
+    double periodX = 0;
+    double periodY = 0;
+    double periodZ = 0;
     // Time step size
     float h;
     // Time elappsed since start of simulation
@@ -233,8 +265,21 @@ struct DEMSimParams {
     float expSafetyMulti;
     // Expand safety parameter (adder for the max vel)
     float expSafetyAdder;
+    // Extra thickness (skin) of the Verlet-style contact candidate list; 0 means candidates are not reused
+    float verletSkin = 0;
     // Stepping method
     TIME_INTEGRATOR stepping = TIME_INTEGRATOR::FORWARD_EULER;
+    // An owner whose speed and angular speed stay below sleepLinVel and sleepAngVel for sleepSteps consecutive steps
+    // goes to sleep; 0 means owners never sleep. A sleeping owner is woken by a contact force larger than wakeForce, or
+    // by an awake contact partner that is moving.
+    unsigned int sleepSteps = 0;
+    float sleepLinVel = 0;
+    float sleepAngVel = 0;
+    float wakeForce = DEME_HUGE_FLOAT;
+    // Whether the force kernel records the deepest overlap, for adaptive time stepping
+    bool trackMaxOverlap = false;
+    // Owners of subcycled families take nSubsteps substeps per step; 1 means no subcycling
+    unsigned int nSubsteps = 1;
 
     // Number of wildcards (extra property) arrays associated with contacts and owners and geometries
     unsigned int nContactWildcards;
@@ -288,6 +333,15 @@ struct DEMDataDT {
     notStupidBool_t* accSpecified;
     notStupidBool_t* angAccSpecified;
 
+    // Number of consecutive steps each owner has been quiescent; it sleeps once this reaches simParams->sleepSteps
+    unsigned int* sleepCounter;
+
+    // Sums of contact force and torque (about the CoM, in global), and the number of contacts, of each owner's contacts
+    // that are recorded as aggregates in this step
+    float3* ownerCntForceSum;
+    float3* ownerCntTorqueSum;
+    unsigned int* ownerCntNum;
+
     bodyID_t* idGeometryA;
     bodyID_t* idGeometryB;
     contact_t* contactType;
@@ -297,12 +351,23 @@ struct DEMDataDT {
     notStupidBool_t* familyMasks;
     // Extra margin size
     float* familyExtraMarginSize;
+    // Whether a family is subcycled
+    notStupidBool_t* familySubcycled;
+    // How the contacts between each pair of families are recorded (flattened like familyMasks)
+    notStupidBool_t* familyForceRecord;
+    // With a force record policy, where each contact's force, torque and points are in the record arrays below, or
+    // NULL_MAPPING_PARTNER if the contact is not recorded in full
+    contactPairs_t* fullRecordSlot;
 
     // Some dT's own work array pointers
     float3* contactForces;
     float3* contactTorque_convToForce;
     float3* contactPointGeometryA;
     float3* contactPointGeometryB;
+    // With the compact contact storage policy, torque-only forces and contact points on A are kept in these instead
+    notStupidBool_t useCompactContactStorage = 0;
+    compactFloat3_t* compactTorque_convToForce;
+    compactFloat3_t* compactPointGeometryA;
     // float3* contactHistory;
     // float* contactDuration;
 
@@ -357,6 +422,9 @@ struct DEMDataDT {
     // typically, contact history info in Hertzian model in this DEM tool is a wildcard, and electric charges can be
     // registered on spheres (clump components) with wildcards.
     float* contactWildcards[DEME_MAX_WILDCARD_NUM] = {NULL};
+    // If contact wildcards are stored in bfloat16 (see SetContactWildcardPrecision), they are in these instead
+    notStupidBool_t useBF16ContactWildcards = 0;
+    bf16_t* contactWildcardsBF16[DEME_MAX_WILDCARD_NUM] = {NULL};
     float* ownerWildcards[DEME_MAX_WILDCARD_NUM] = {NULL};
     float* sphereWildcards[DEME_MAX_WILDCARD_NUM] = {NULL};
     float* analWildcards[DEME_MAX_WILDCARD_NUM] = {NULL};
@@ -364,6 +432,11 @@ struct DEMDataDT {
 
     // dT believes this amount of future drift is ideal
     unsigned int perhapsIdealFutureDrift = 0;
+    // The deepest overlap, as a fraction of the smaller radius of the pair, since it was last reset (only recorded if
+    // trackMaxOverlap)
+    float maxOverlapRatio = 0;
+    // Number of sleeping owners, kept up to date as owners fall asleep and wake up
+    unsigned int nSleepingOwners = 0;
 };
 
 // A struct that holds pointers to data arrays that kT uses
@@ -438,6 +511,27 @@ struct DEMDataKT {
     contact_t* previous_contactType;
     contactPairs_t* contactMapping;
 
+    // Verlet-style contact candidates, found with the skin added to the margins and sorted by idA, and the owner states
+    // at the time they were found
+    bodyID_t* verletIdGeometryA;
+    bodyID_t* verletIdGeometryB;
+    contact_t* verletContactType;
+    voxelID_t* verletVoxelID;
+    subVoxelPos_t* verletLocX;
+    subVoxelPos_t* verletLocY;
+    subVoxelPos_t* verletLocZ;
+    oriQ_t* verletOriQw;
+    oriQ_t* verletOriQx;
+    oriQ_t* verletOriQy;
+    oriQ_t* verletOriQz;
+    float* verletMarginSize;
+    family_t* verletFamilyID;
+    // Max distance from an owner's CoM to any point of its geometries
+    float* verletOwnerExtent;
+
+    // The level of bins each sphere is binned in (always 0 unless hierarchical binning is in use)
+    unsigned char* sphereBinLevel;
+
     // data pointers that is kT's transfer destination
     size_t* pDTOwnedBuffer_nContactPairs = NULL;
     bodyID_t* pDTOwnedBuffer_idGeometryA = NULL;
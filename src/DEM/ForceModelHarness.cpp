@@ -0,0 +1,359 @@
+//  Copyright (c) 2021, SBEL GPU Development Team
+//  Copyright (c) 2021, University of Wisconsin - Madison
+//
+//	SPDX-License-Identifier: BSD-3-Clause
+
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <random>
+
+#if !defined(_WIN32) && !defined(_WIN64)
+    #include <dlfcn.h>
+    #include <unistd.h>
+#endif
+
+#include <DEM/ForceModelHarness.h>
+#include <DEM/HostSideHelpers.hpp>
+#include <DEM/Models.h>
+#include <core/utils/RuntimeData.h>
+
+namespace deme {
+
+void HostContactBatch::Resize(size_t n) {
+    nContacts = n;
+    type.resize(n, SPHERE_SPHERE_CONTACT);
+    overlap.resize(n);
+    normal.resize(n);
+    contactPnt.resize(n);
+    force.resize(n);
+    torque_only_force.resize(n);
+    locCPA.resize(n);
+    locCPB.resize(n);
+    pos.resize(2 * n);
+    oriQw.resize(2 * n, 1);
+    oriQx.resize(2 * n, 0);
+    oriQy.resize(2 * n, 0);
+    oriQz.resize(2 * n, 0);
+    vX.resize(2 * n, 0);
+    vY.resize(2 * n, 0);
+    vZ.resize(2 * n, 0);
+    omgBarX.resize(2 * n, 0);
+    omgBarY.resize(2 * n, 0);
+    omgBarZ.resize(2 * n, 0);
+    mass.resize(2 * n, 1);
+    mmiXX.resize(2 * n, 1);
+    mmiYY.resize(2 * n, 1);
+    mmiZZ.resize(2 * n, 1);
+    radius.resize(2 * n, 1);
+    material.resize(2 * n, 0);
+    family.resize(2 * n, 0);
+}
+
+DEMForceModelHarness::~DEMForceModelHarness() {
+#if !defined(_WIN32) && !defined(_WIN64)
+    if (m_lib)
+        dlclose(m_lib);
+#endif
+}
+
+std::shared_ptr<DEMMaterial> DEMForceModelHarness::LoadMaterial(
+    const std::unordered_map<std::string, float>& mat_prop) {
+    for (const auto& a_pair : mat_prop) {
+        m_material_prop_names.insert(a_pair.first);
+    }
+    std::shared_ptr<DEMMaterial> ptr = std::make_shared<DEMMaterial>(mat_prop);
+    ptr->load_order = m_loaded_materials.size();
+    m_loaded_materials.push_back(ptr);
+    return ptr;
+}
+
+void DEMForceModelHarness::SetMaterialPropertyPair(const std::string& name,
+                                                   const std::shared_ptr<DEMMaterial>& mat1,
+                                                   const std::shared_ptr<DEMMaterial>& mat2,
+                                                   float val) {
+    m_pairwise_material_prop_names.insert(name);
+    m_pairwise_matprop[name].push_back(
+        std::pair<std::pair<unsigned int, unsigned int>, float>({mat1->load_order, mat2->load_order}, val));
+}
+
+std::string DEMForceModelHarness::makeMaterialDefs() {
+    // Same rules as the solver's equipMaterials: the force model tells which properties are pair-wise, and a pair-wise
+    // property not given for a pair is the average of the 2 materials'
+    m_pairwise_material_prop_names.insert(m_model->m_pairwise_mat_props.begin(), m_model->m_pairwise_mat_props.end());
+    m_material_prop_names.insert(m_model->m_must_have_mat_props.begin(), m_model->m_must_have_mat_props.end());
+    m_material_prop_names.insert(m_pairwise_material_prop_names.begin(), m_pairwise_material_prop_names.end());
+
+    std::string materialDefs = " ";
+    const unsigned int num_mats = m_loaded_materials.size();
+    const std::string line_header = "static const float ";
+    for (const auto& prop_name : m_material_prop_names) {
+        std::vector<std::vector<float>> pair_mat(num_mats, std::vector<float>(num_mats, 0.0));
+        for (const auto& a_mat : m_loaded_materials) {
+            unsigned int i = a_mat->load_order;
+            if (check_exist(a_mat->mat_prop, prop_name)) {
+                pair_mat[i][i] = a_mat->mat_prop.at(prop_name);
+            } else {
+                DEME_WARNING("Material property %s is not defined for material %u, so it is defaulted to 0.",
+                             prop_name.c_str(), i);
+            }
+        }
+        if (!check_exist(m_pairwise_material_prop_names, prop_name)) {
+            materialDefs += line_header + prop_name + "[] = {";
+            for (unsigned int i = 0; i < num_mats; i++) {
+                materialDefs += to_string_with_precision(pair_mat[i][i]) + ",";
+            }
+            if (num_mats == 0) {
+                materialDefs += "0";
+            }
+            materialDefs += "};\n";
+        } else {
+            for (unsigned int i = 0; i < num_mats; i++) {
+                for (unsigned int j = 0; j < num_mats; j++) {
+                    if (i != j)
+                        pair_mat[i][j] = (pair_mat[i][i] + pair_mat[j][j]) / 2.;
+                }
+            }
+            if (check_exist(m_pairwise_matprop, prop_name)) {
+                for (const auto& pair_prop : m_pairwise_matprop.at(prop_name)) {
+                    pair_mat[pair_prop.first.first][pair_prop.first.second] = pair_prop.second;
+                    pair_mat[pair_prop.first.second][pair_prop.first.first] = pair_prop.second;
+                }
+            }
+            materialDefs += line_header + prop_name + "[][" + std::to_string(num_mats) + "] = {";
+            for (unsigned int i = 0; i < num_mats; i++) {
+                materialDefs += "{";
+                for (unsigned int j = 0; j < num_mats; j++) {
+                    materialDefs += to_string_with_precision(pair_mat[i][j]) + ",";
+                }
+                materialDefs += "},";
+            }
+            if (num_mats == 0) {
+                materialDefs += "{0}";
+            }
+            materialDefs += "};\n";
+        }
+    }
+    return materialDefs;
+}
+
+void DEMForceModelHarness::Compile() {
+#if defined(_WIN32) || defined(_WIN64)
+    DEME_ERROR("The force model harness is not supported on Windows.");
+#else
+    std::unordered_map<std::string, std::string> strMap;
+    // The harness keeps mass properties in flattened arrays, and records the force of every contact
+    strMap["_massAcqStrat_"] = MASS_ACQUISITION_FLATTENED();
+    strMap["_moiAcqStrat_"] = MOI_ACQUISITION_FLATTENED();
+    equip_force_model(strMap, force_kernel_ingredient_stats, m_model->m_force_model, m_model->m_contact_wildcards,
+                      m_model->m_owner_wildcards, m_model->m_geo_wildcards, false, true, false, m_owner_wc_num,
+                      m_geo_wc_num, m_cnt_wc_num, verbosity);
+    strMap["_materialDefs_"] = makeMaterialDefs();
+
+    std::filesystem::path sourcefile = RuntimeDataHelper::data_path / "kernel" / "DEMCalcForceKernels_Host.cu";
+    if (!std::filesystem::exists(sourcefile)) {
+        DEME_ERROR("The host force kernel file %s is not found.", sourcefile.string().c_str());
+    }
+    m_source = replace_patterns(read_file_to_string(sourcefile), strMap);
+
+    // Each compilation gets its own directory, since the loaded library must not be overwritten
+    static unsigned int num_compiled = 0;
+    std::filesystem::path dir =
+        std::filesystem::temp_directory_path() /
+        ("deme_force_model_" + std::to_string(getpid()) + "_" + std::to_string(num_compiled++));
+    std::filesystem::create_directories(dir);
+    std::filesystem::path src = dir / "force_model.cpp", lib = dir / "force_model.so", log = dir / "compile.log";
+    {
+        std::ofstream out(src);
+        out << m_source;
+    }
+    std::string cmd = m_compiler + " " + m_compile_flags + " -std=c++17 -shared -fPIC -Wno-attributes -x c++ -I\"" +
+                      RuntimeDataHelper::include_path.string() + "\" -I\"" +
+                      (RuntimeDataHelper::data_path / "kernel").string() + "\"";
+    #ifdef DEME_CUDA_INCLUDE_DIR
+    cmd += " -I\"" + std::string(DEME_CUDA_INCLUDE_DIR) + "\"";
+    #endif
+    cmd += " \"" + src.string() + "\" -o \"" + lib.string() + "\" > \"" + log.string() + "\" 2>&1";
+    DEME_DEBUG_PRINTF("Compiling the force model for the host:\n%s", cmd.c_str());
+    if (std::system(cmd.c_str()) != 0) {
+        DEME_ERROR("Failed to compile the force model for the host. The source is %s, and the compiler says:\n%s",
+                   src.string().c_str(), read_file_to_string(log).c_str());
+    }
+
+    if (m_lib)
+        dlclose(m_lib);
+    m_lib = dlopen(lib.string().c_str(), RTLD_NOW | RTLD_LOCAL);
+    if (!m_lib) {
+        DEME_ERROR("Failed to load the compiled force model %s: %s", lib.string().c_str(), dlerror());
+    }
+    m_kernel = (HostForceKernel)dlsym(m_lib, "calculateContactForcesHost");
+    if (!m_kernel) {
+        DEME_ERROR("The compiled force model %s does not have the host force kernel in it.", lib.string().c_str());
+    }
+#endif
+}
+
+HostContactBatch DEMForceModelHarness::MakeSyntheticBatch(size_t n,
+                                                          const SyntheticContactRanges& ranges,
+                                                          unsigned int seed) const {
+    HostContactBatch batch;
+    batch.Resize(n);
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<double> uni(0., 1.);
+    auto inRange = [&](double lo, double hi) { return lo + (hi - lo) * uni(rng); };
+    auto unitVector = [&]() {
+        double z = inRange(-1., 1.), phi = inRange(0., 2. * PI), r = std::sqrt(1. - z * z);
+        return host_make_float3(r * std::cos(phi), r * std::sin(phi), z);
+    };
+    const unsigned int num_mats = (m_loaded_materials.size() > 0) ? m_loaded_materials.size() : 1;
+    for (size_t i = 0; i < n; i++) {
+        const size_t a = 2 * i, b = 2 * i + 1;
+        const bool is_plane = uni(rng) < ranges.planeFraction;
+        batch.type[i] = is_plane ? SPHERE_PLANE_CONTACT : SPHERE_SPHERE_CONTACT;
+        for (size_t body : {a, b}) {
+            const double r = inRange(ranges.minRadius, ranges.maxRadius);
+            batch.radius[body] = r;
+            batch.mass[body] = ranges.density * 4. / 3. * PI * r * r * r;
+            batch.mmiXX[body] = batch.mmiYY[body] = batch.mmiZZ[body] = 0.4 * batch.mass[body] * r * r;
+            batch.vX[body] = inRange(-ranges.maxLinVel, ranges.maxLinVel);
+            batch.vY[body] = inRange(-ranges.maxLinVel, ranges.maxLinVel);
+            batch.vZ[body] = inRange(-ranges.maxLinVel, ranges.maxLinVel);
+            batch.omgBarX[body] = inRange(-ranges.maxRotVel, ranges.maxRotVel);
+            batch.omgBarY[body] = inRange(-ranges.maxRotVel, ranges.maxRotVel);
+            batch.omgBarZ[body] = inRange(-ranges.maxRotVel, ranges.maxRotVel);
+            float3 axis = unitVector();
+            const double half_angle = inRange(0., PI);
+            batch.oriQw[body] = std::cos(half_angle);
+            batch.oriQx[body] = axis.x * std::sin(half_angle);
+            batch.oriQy[body] = axis.y * std::sin(half_angle);
+            batch.oriQz[body] = axis.z * std::sin(half_angle);
+            batch.material[body] = (materialsOffset_t)(uni(rng) * num_mats) % num_mats;
+        }
+        // A plane has no size; its owner (B) just sits at the contact point
+        if (is_plane) {
+            batch.radius[b] = DEME_HUGE_FLOAT;
+            batch.omgBarX[b] = batch.omgBarY[b] = batch.omgBarZ[b] = 0;
+        }
+        const double small_r = is_plane ? batch.radius[a] : std::min(batch.radius[a], batch.radius[b]);
+        const double overlap = small_r * inRange(ranges.minOverlapRatio, ranges.maxOverlapRatio);
+        const float3 B2A = unitVector();
+        batch.overlap[i] = overlap;
+        batch.normal[i] = B2A;
+        batch.pos[a] = make_double3(inRange(-1., 1.), inRange(-1., 1.), inRange(-1., 1.));
+        // The contact point is in the middle of the overlapping part
+        const double to_cp = batch.radius[a] - overlap / 2.;
+        batch.contactPnt[i] = make_double3(batch.pos[a].x - to_cp * B2A.x, batch.pos[a].y - to_cp * B2A.y,
+                                           batch.pos[a].z - to_cp * B2A.z);
+        const double to_b = is_plane ? to_cp : batch.radius[a] + batch.radius[b] - overlap;
+        batch.pos[b] = make_double3(batch.pos[a].x - to_b * B2A.x, batch.pos[a].y - to_b * B2A.y,
+                                    batch.pos[a].z - to_b * B2A.z);
+    }
+    return batch;
+}
+
+void DEMForceModelHarness::bindBatch(HostContactBatch& batch, DEMDataDT& granData) {
+    const size_t n = batch.nContacts;
+    m_idGeometryA.resize(n);
+    m_idGeometryB.resize(n);
+    m_ownerClumpBody.resize(2 * n);
+    for (size_t i = 0; i < n; i++) {
+        m_idGeometryA[i] = 2 * i;
+        m_idGeometryB[i] = 2 * i + 1;
+    }
+    for (size_t i = 0; i < 2 * n; i++) {
+        m_ownerClumpBody[i] = i;
+    }
+    granData.idGeometryA = m_idGeometryA.data();
+    granData.idGeometryB = m_idGeometryB.data();
+    granData.ownerClumpBody = m_ownerClumpBody.data();
+    granData.contactType = batch.type.data();
+    granData.familyID = batch.family.data();
+    granData.oriQw = batch.oriQw.data();
+    granData.oriQx = batch.oriQx.data();
+    granData.oriQy = batch.oriQy.data();
+    granData.oriQz = batch.oriQz.data();
+    granData.vX = batch.vX.data();
+    granData.vY = batch.vY.data();
+    granData.vZ = batch.vZ.data();
+    granData.omgBarX = batch.omgBarX.data();
+    granData.omgBarY = batch.omgBarY.data();
+    granData.omgBarZ = batch.omgBarZ.data();
+    granData.massOwnerBody = batch.mass.data();
+    granData.mmiXX = batch.mmiXX.data();
+    granData.mmiYY = batch.mmiYY.data();
+    granData.mmiZZ = batch.mmiZZ.data();
+    granData.radiiSphere = batch.radius.data();
+    granData.sphereMaterialOffset = batch.material.data();
+    granData.contactForces = batch.force.data();
+    granData.contactTorque_convToForce = batch.torque_only_force.data();
+    granData.contactPointGeometryA = batch.locCPA.data();
+    granData.contactPointGeometryB = batch.locCPB.data();
+    for (const auto& wc : m_cnt_wc_num) {
+        std::vector<float>& arr = batch.contactWildcards[wc.first];
+        arr.resize(n, 0);
+        granData.contactWildcards[wc.second] = arr.data();
+    }
+    for (const auto& wc : m_owner_wc_num) {
+        std::vector<float>& arr = batch.ownerWildcards[wc.first];
+        arr.resize(2 * n, 0);
+        granData.ownerWildcards[wc.second] = arr.data();
+    }
+    for (const auto& wc : m_geo_wc_num) {
+        std::vector<float>& arr = batch.geoWildcards[wc.first];
+        arr.resize(2 * n, 0);
+        granData.sphereWildcards[wc.second] = arr.data();
+    }
+}
+
+void DEMForceModelHarness::Evaluate(HostContactBatch& batch) {
+    if (!m_kernel) {
+        DEME_ERROR("Please call Compile() before evaluating the force model with the harness.");
+    }
+    DEMSimParams simParams{};
+    simParams.h = m_ts;
+    simParams.timeElapsed = m_time;
+    DEMDataDT granData{};
+    bindBatch(batch, granData);
+    m_kernel(&simParams, &granData, batch.pos.data(), batch.contactPnt.data(), batch.normal.data(),
+             batch.overlap.data(), batch.nContacts);
+}
+
+double DEMForceModelHarness::Benchmark(HostContactBatch& batch, unsigned int n_reps) {
+    // Once to warm up
+    Evaluate(batch);
+    auto start = std::chrono::high_resolution_clock::now();
+    for (unsigned int i = 0; i < n_reps; i++) {
+        Evaluate(batch);
+    }
+    double elapsed = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+    double rate = (double)batch.nContacts * n_reps / elapsed;
+    DEME_PRINTF("Force model harness: %zu contacts x %u runs in %.4g s, %.4g contacts/s\n", batch.nContacts, n_reps,
+                elapsed, rate);
+    return rate;
+}
+
+double DEMForceModelHarness::CompareWith(HostContactBatch& batch, const ReferenceModel& reference) {
+    // The reference sees the same inputs (contact wildcards included) the force model does
+    HostContactBatch before = batch;
+    Evaluate(batch);
+    std::vector<float3> ref_force(batch.nContacts), ref_torque(batch.nContacts);
+    double max_ref = 0.;
+    for (size_t i = 0; i < batch.nContacts; i++) {
+        reference(before, i, ref_force[i], ref_torque[i]);
+        max_ref = std::max(max_ref, (double)length(ref_force[i]));
+    }
+    // Differences are relative to the reference value, but those near zero are judged against the largest force in
+    // the batch, so that round-off on a vanishing component does not count as an error
+    const double floor = 1e-6 * max_ref + DEME_TINY_FLOAT;
+    double max_err = 0.;
+    for (size_t i = 0; i < batch.nContacts; i++) {
+        max_err = std::max(max_err, length(batch.force[i] - ref_force[i]) / (length(ref_force[i]) + floor));
+        max_err = std::max(max_err,
+                           length(batch.torque_only_force[i] - ref_torque[i]) / (length(ref_torque[i]) + floor));
+    }
+    return max_err;
+}
+
+}  // namespace deme
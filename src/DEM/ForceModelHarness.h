@@ -0,0 +1,155 @@
+//  Copyright (c) 2021, SBEL GPU Development Team
+//  Copyright (c) 2021, University of Wisconsin - Madison
+//
+//	SPDX-License-Identifier: BSD-3-Clause
+
+#ifndef DEME_FORCE_MODEL_HARNESS_H
+#define DEME_FORCE_MODEL_HARNESS_H
+
+#include <functional>
+#include <memory>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <DEM/Defines.h>
+#include <DEM/Structs.h>
+#include <DEM/BdrsAndObjs.h>
+#include <DEM/AuxClasses.h>
+
+namespace deme {
+
+/// A batch of contacts to drive a force model with on the host. Contact i is between body 2i (A) and body 2i+1 (B);
+/// each body is an owner with one sphere in it, so the per-body arrays are indexed by both owner and geometry ID.
+struct HostContactBatch {
+    size_t nContacts = 0;
+
+    // Per contact
+    std::vector<contact_t> type;
+    std::vector<double> overlap;
+    // Unit vector pointing from B to A
+    std::vector<float3> normal;
+    std::vector<double3> contactPnt;
+
+    // Per body
+    std::vector<double3> pos;
+    std::vector<oriQ_t> oriQw, oriQx, oriQy, oriQz;
+    std::vector<float> vX, vY, vZ;
+    std::vector<float> omgBarX, omgBarY, omgBarZ;
+    std::vector<float> mass, mmiXX, mmiYY, mmiZZ;
+    std::vector<float> radius;
+    std::vector<materialsOffset_t> material;
+    std::vector<family_t> family;
+
+    // Wildcards by name; those not given are zero-initialized at the first evaluation
+    std::unordered_map<std::string, std::vector<float>> contactWildcards;
+    std::unordered_map<std::string, std::vector<float>> ownerWildcards;
+    std::unordered_map<std::string, std::vector<float>> geoWildcards;
+
+    // Outputs, in the global frame
+    std::vector<float3> force;
+    std::vector<float3> torque_only_force;
+    // Contact points in A's and B's local frames
+    std::vector<float3> locCPA, locCPB;
+
+    /// Resize the per-contact and per-body arrays to hold n contacts.
+    void Resize(size_t n);
+};
+
+/// The ranges synthetic contacts are drawn from.
+struct SyntheticContactRanges {
+    float minRadius = 0.005;
+    float maxRadius = 0.01;
+    /// Overlap, as a fraction of the smaller radius of the pair
+    float minOverlapRatio = 1e-4;
+    float maxOverlapRatio = 0.05;
+    float maxLinVel = 1.;
+    float maxRotVel = 10.;
+    float density = 2.6e3;
+    /// The fraction of contacts that are sphere--plane ones
+    float planeFraction = 0.;
+};
+
+/// A host-side harness for a contact force model. It makes the force model (with the same ingredient and wildcard
+/// substitutions that the solver uses) into a host function, then drives it over contact batches, so that a custom
+/// model can be benchmarked and validated against a reference implementation without a simulation.
+class DEMForceModelHarness {
+  public:
+    /// A reference implementation: given a batch and a contact in it, produce the force and the torque-only force.
+    typedef std::function<void(const HostContactBatch&, size_t, float3&, float3&)> ReferenceModel;
+
+    DEMForceModelHarness(const std::shared_ptr<DEMForceModel>& model) : m_model(model) {}
+    ~DEMForceModelHarness();
+
+    /// Load a material, the same way as with the solver.
+    std::shared_ptr<DEMMaterial> LoadMaterial(const std::unordered_map<std::string, float>& mat_prop);
+    /// Set a material property that is associated with a pair of materials.
+    void SetMaterialPropertyPair(const std::string& name,
+                                 const std::shared_ptr<DEMMaterial>& mat1,
+                                 const std::shared_ptr<DEMMaterial>& mat2,
+                                 float val);
+
+    /// Set the host compiler command (default `c++').
+    void SetCompiler(const std::string& compiler) { m_compiler = compiler; }
+    /// Set the flags the host compiler uses (default `-O3 -march=native').
+    void SetCompileFlags(const std::string& flags) { m_compile_flags = flags; }
+    /// Set the time step size (ts) and the time (time) that the force model sees.
+    void SetTimeStepSize(double ts) { m_ts = ts; }
+    void SetTime(double time) { m_time = time; }
+    /// Set the verbosity level of the harness.
+    void SetVerbosity(VERBOSITY verbose) { verbosity = verbose; }
+
+    /// Make the force model into a host function and load it. Must be called after all materials are loaded.
+    void Compile();
+    /// The source that Compile() compiled.
+    const std::string& GetSource() const { return m_source; }
+
+    /// Make a batch of n random contacts in the given ranges, with materials drawn from the loaded ones.
+    HostContactBatch MakeSyntheticBatch(size_t n, const SyntheticContactRanges& ranges, unsigned int seed = 0) const;
+    /// Evaluate the force model for all contacts in a batch. Contact wildcards in the batch are updated, like in a
+    /// time step.
+    void Evaluate(HostContactBatch& batch);
+    /// Evaluate a batch n_reps times and return the number of contacts processed per second.
+    double Benchmark(HostContactBatch& batch, unsigned int n_reps = 10);
+    /// Evaluate a batch, then return the largest relative difference between the force model's force (and
+    /// torque-only force) and those from a reference implementation.
+    double CompareWith(HostContactBatch& batch, const ReferenceModel& reference);
+
+  private:
+    typedef void (*HostForceKernel)(DEMSimParams*, DEMDataDT*, const double3*, const double3*, const float3*,
+                                    const double*, size_t);
+
+    std::shared_ptr<DEMForceModel> m_model;
+    std::vector<std::shared_ptr<DEMMaterial>> m_loaded_materials;
+    std::set<std::string> m_material_prop_names;
+    std::set<std::string> m_pairwise_material_prop_names;
+    std::unordered_map<std::string, std::vector<std::pair<std::pair<unsigned int, unsigned int>, float>>>
+        m_pairwise_matprop;
+
+    std::string m_compiler = "c++";
+    std::string m_compile_flags = "-O3 -march=native";
+    double m_ts = 1e-5;
+    double m_time = 0.;
+    VERBOSITY verbosity = INFO;
+
+    // Wildcard name--number maps, as the solver numbers them
+    std::unordered_map<std::string, unsigned int> m_owner_wc_num;
+    std::unordered_map<std::string, unsigned int> m_geo_wc_num;
+    std::unordered_map<std::string, unsigned int> m_cnt_wc_num;
+
+    std::string m_source;
+    void* m_lib = nullptr;
+    HostForceKernel m_kernel = nullptr;
+    // Geometry--owner arrays of the batch being evaluated
+    std::vector<bodyID_t> m_idGeometryA, m_idGeometryB, m_ownerClumpBody;
+
+    // The material arrays, as host definitions
+    std::string makeMaterialDefs();
+    // Point a DEMDataDT to the arrays of a batch
+    void bindBatch(HostContactBatch& batch, DEMDataDT& granData);
+};
+
+}  // namespace deme
+
+#endif
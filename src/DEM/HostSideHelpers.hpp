@@ -10,6 +10,7 @@
 #include <sstream>
 #include <list>
 #include <cmath>
+#include <cstring>
 #include <set>
 #include <vector>
 #include <numeric>
@@ -149,6 +150,27 @@ inline float3 host_make_float3(float a, float b, float c) {
     f.z = c;
     return f;
 }
+// Unpack a vector stored as 16-bit mantissas with a shared exponent (see packCompactFloat3 in DEMHelperKernels.cu)
+inline float3 hostUnpackCompactFloat3(const compactFloat3_t& c) {
+    return host_make_float3(std::ldexp((float)c.x, c.exp - 15), std::ldexp((float)c.y, c.exp - 15),
+                            std::ldexp((float)c.z, c.exp - 15));
+}
+// Round a float to bfloat16, and back (see packBF16 in DEMHelperKernels.cu)
+inline bf16_t hostPackBF16(float v) {
+    uint32_t bits;
+    std::memcpy(&bits, &v, sizeof(bits));
+    if ((bits & 0x7fffffffu) > 0x7f800000u) {
+        return (bf16_t)((bits >> 16) | 0x40u);
+    }
+    bits += 0x7fffu + ((bits >> 16) & 1u);
+    return (bf16_t)(bits >> 16);
+}
+inline float hostUnpackBF16(bf16_t b) {
+    uint32_t bits = (uint32_t)b << 16;
+    float v;
+    std::memcpy(&v, &bits, sizeof(v));
+    return v;
+}
 inline float4 host_make_float4(float x, float y, float z, float w) {
     float4 f;
     f.x = x;
@@ -172,6 +194,155 @@ inline size_t hostCalcBinNum(binID_t& nbX,
     return (size_t)nbX * (size_t)nbY * (size_t)nbZ;
 }
 
+/// Number of levels of bins hierarchical binning uses: enough for the bins of the coarsest level (2^(n-1) times the
+/// base bin size) to be no smaller than the largest sphere diameter, but no more than maxLevels
+inline unsigned int hostNumBinLevels(double binSize, double maxRadius, unsigned int maxLevels) {
+    unsigned int nLevels = 1;
+    while (nLevels < maxLevels && 2. * maxRadius > binSize * (double)((size_t)1 << (nLevels - 1)))
+        nLevels++;
+    return nLevels;
+}
+
+/// Host version of sphereBinLevel: the finest level whose bins are no smaller than the sphere's diameter
+inline unsigned int hostSphereBinLevel(double radius, double binSize, unsigned int nLevels) {
+    unsigned int lvl = 0;
+    while (lvl + 1 < nLevels && 2. * radius > binSize * (double)((size_t)1 << lvl))
+        lvl++;
+    return lvl;
+}
+
+/// Number of bins in each direction of each level, given those of level 0, and the ID of the first bin of each level.
+/// The bins of level l are 2^l times as large, so the level has about 1/8^l as many. Returns the total number of bins.
+inline size_t hostCalcBinLevels(binID_t* nbXLevel,
+                                binID_t* nbYLevel,
+                                binID_t* nbZLevel,
+                                binID_t* binLevelOffset,
+                                binID_t nbX,
+                                binID_t nbY,
+                                binID_t nbZ,
+                                unsigned int nLevels) {
+    size_t total = 0;
+    for (unsigned int lvl = 0; lvl < nLevels; lvl++) {
+        // Round up, so each level covers at least what level 0 covers
+        const size_t factor = (size_t)1 << lvl;
+        nbXLevel[lvl] = (binID_t)(((size_t)nbX + factor - 1) / factor);
+        nbYLevel[lvl] = (binID_t)(((size_t)nbY + factor - 1) / factor);
+        nbZLevel[lvl] = (binID_t)(((size_t)nbZ + factor - 1) / factor);
+        binLevelOffset[lvl] = (binID_t)total;
+        total += (size_t)nbXLevel[lvl] * (size_t)nbYLevel[lvl] * (size_t)nbZLevel[lvl];
+    }
+    return total;
+}
+
+/// Host version of sphereBinRange1D: the lowest and highest indices of the bins a sphere touches along one direction,
+/// given its center and radius in units of bin size
+inline void hostSphereBinRange1D(binID_t& lo, binID_t& hi, double myBin, double myRadiusSpan, binID_t nb) {
+    lo = (binID_t)((myBin - myRadiusSpan > 0.0) ? myBin - myRadiusSpan : 0.0);
+    hi = (myBin + myRadiusSpan < (double)nb) ? (binID_t)(myBin + myRadiusSpan) : nb - 1;
+}
+
+/// Host version of wrapIntoPeriod: wrap a coordinate into the period [start, start + length) of a direction, if that
+/// direction is periodic
+inline void hostWrapIntoPeriod(double& X, bool periodic, double start, double length) {
+    if (periodic) {
+        X -= length * std::floor((X - start) / length);
+    }
+}
+
+/// Host version of periodicImageShift: the shift to add to coordinate difference dX to make it that of the closest
+/// periodic images
+inline double hostPeriodicImageShift(double dX, bool periodic, double length) {
+    return periodic ? -length * std::round(dX / length) : 0.;
+}
+
+/// Host version of periodicSphereBinRanges1D: the ranges of bin indices a sphere touches along one direction, counting
+/// those its periodic image touches. Returns the number of ranges (1 or 2); no bin is in both.
+inline unsigned int hostPeriodicSphereBinRanges1D(binID_t* lo,
+                                                  binID_t* hi,
+                                                  double myBin,
+                                                  double myRadiusSpan,
+                                                  binID_t nb,
+                                                  bool periodic,
+                                                  double startSpan,
+                                                  double lengthSpan) {
+    hostSphereBinRange1D(lo[0], hi[0], myBin, myRadiusSpan, nb);
+    if (!periodic) {
+        return 1;
+    }
+    double imageBin;
+    if (myBin - myRadiusSpan < startSpan) {
+        imageBin = myBin + lengthSpan;
+    } else if (myBin + myRadiusSpan >= startSpan + lengthSpan) {
+        imageBin = myBin - lengthSpan;
+    } else {
+        return 1;
+    }
+    binID_t imageLo, imageHi;
+    hostSphereBinRange1D(imageLo, imageHi, imageBin, myRadiusSpan, nb);
+    if (imageLo > imageHi) {
+        return 1;
+    }
+    if (imageLo > hi[0] + 1 || imageHi + 1 < lo[0]) {
+        lo[1] = imageLo;
+        hi[1] = imageHi;
+        return 2;
+    }
+    lo[0] = (imageLo < lo[0]) ? imageLo : lo[0];
+    hi[0] = (imageHi > hi[0]) ? imageHi : hi[0];
+    return 1;
+}
+
+/// Host version of countBinSpherePairsBefore: number of the pairs in a list sorted by bin ID then sphere ID that come
+/// before the pair (bin, sphere)
+inline size_t hostCountBinSpherePairsBefore(const binID_t* bins,
+                                            const bodyID_t* spheres,
+                                            size_t n,
+                                            binID_t bin,
+                                            bodyID_t sphere) {
+    size_t lo = 0, hi = n;
+    while (lo < hi) {
+        size_t mid = (lo + hi) / 2;
+        if (bins[mid] < bin || (bins[mid] == bin && spheres[mid] < sphere)) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+/// Host version of the incremental binning merge (markKeptBinSpherePairs then mergeBinSpherePairs): drop the recorded
+/// pairs of the re-binned spheres, and merge in their new pairs. Both lists are sorted by bin ID then sphere ID, and so
+/// is the output. numBinsRebinned is non-zero for (and only for) the re-binned spheres. Returns the number of pairs.
+inline size_t hostMergeBinSpherePairs(const binID_t* oldBins,
+                                      const bodyID_t* oldSpheres,
+                                      size_t nOld,
+                                      const binsSphereTouches_t* numBinsRebinned,
+                                      const binID_t* newBins,
+                                      const bodyID_t* newSpheres,
+                                      size_t nNew,
+                                      binID_t* bins,
+                                      bodyID_t* spheres) {
+    std::vector<size_t> keptScan(nOld + 1, 0);
+    for (size_t i = 0; i < nOld; i++)
+        keptScan[i + 1] = keptScan[i] + ((numBinsRebinned[oldSpheres[i]] == 0) ? 1 : 0);
+    for (size_t i = 0; i < nOld; i++) {
+        if (numBinsRebinned[oldSpheres[i]] == 0) {
+            size_t place =
+                keptScan[i] + hostCountBinSpherePairsBefore(newBins, newSpheres, nNew, oldBins[i], oldSpheres[i]);
+            bins[place] = oldBins[i];
+            spheres[place] = oldSpheres[i];
+        }
+    }
+    for (size_t j = 0; j < nNew; j++) {
+        size_t place =
+            j + keptScan[hostCountBinSpherePairsBefore(oldBins, oldSpheres, nOld, newBins[j], newSpheres[j])];
+        bins[place] = newBins[j];
+        spheres[place] = newSpheres[j];
+    }
+    return keptScan[nOld] + nNew;
+}
+
 /// @brief  Check if the string has only spaces.
 inline bool is_all_spaces(const std::string& str) {
     return str.find_first_not_of(' ') == str.npos;
@@ -540,6 +711,63 @@ inline void hostApplyOriQToVector3(T1& X, T1& Y, T1& Z, const T2& Qw, const T2&
         ((T2)2.0 * (Qw * Qw + Qz * Qz) - (T2)1.0) * oldZ;
 }
 
+/// Host version of ownerDriftBound: an upper bound on how far any point of an owner has moved since a reference
+/// state, given the displacement of its CoM, its orientations now and then, and its extent (max distance from the CoM
+/// to any of its points)
+template <typename T1, typename T2>
+inline T1 hostOwnerDriftBound(const T1& dX,
+                              const T1& dY,
+                              const T1& dZ,
+                              const T2& Qw,
+                              const T2& Qx,
+                              const T2& Qy,
+                              const T2& Qz,
+                              const T2& refQw,
+                              const T2& refQx,
+                              const T2& refQy,
+                              const T2& refQz,
+                              const float& extent) {
+    T2 dQ2 = (Qw - refQw) * (Qw - refQw) + (Qx - refQx) * (Qx - refQx) + (Qy - refQy) * (Qy - refQy) +
+             (Qz - refQz) * (Qz - refQz);
+    T2 dQ2Flip = (Qw + refQw) * (Qw + refQw) + (Qx + refQx) * (Qx + refQx) + (Qy + refQy) * (Qy + refQy) +
+                 (Qz + refQz) * (Qz + refQz);
+    T2 dQ = std::sqrt((dQ2 < dQ2Flip) ? dQ2 : dQ2Flip);
+    return std::sqrt(dX * dX + dY * dY + dZ * dZ) + (T1)2 * (T1)extent * (T1)dQ;
+}
+
+/// Host version of isContactCandidateExpired: whether the contact candidates found with a skin may now miss a contact
+/// of this owner
+template <typename T1>
+inline bool hostIsContactCandidateExpired(const T1& drift,
+                                          const float& margin,
+                                          const float& refMargin,
+                                          const family_t& family,
+                                          const family_t& refFamily,
+                                          const float& skin) {
+    T1 marginGrowth = (margin > refMargin) ? (T1)(margin - refMargin) : (T1)0;
+    return (family != refFamily) || (drift + marginGrowth > (T1)skin / (T1)2);
+}
+
+/// Host version of the sphere--sphere contact test kT runs at a CD step (radii include the margins), which is also how
+/// it refilters the sphere--sphere contact candidates
+template <typename T1>
+inline bool hostIsSphSphInContact(const T1& XA,
+                                  const T1& YA,
+                                  const T1& ZA,
+                                  const float& rA,
+                                  const T1& XB,
+                                  const T1& YB,
+                                  const T1& ZB,
+                                  const float& rB,
+                                  const float& artificialMarginA,
+                                  const float& artificialMarginB) {
+    T1 centerDist2 = (XA - XB) * (XA - XB) + (YA - YB) * (YA - YB) + (ZA - ZB) * (ZA - ZB);
+    T1 radSum = (T1)rA + (T1)rB;
+    T1 overlapDepth = radSum - std::sqrt(centerDist2);
+    float artificialMargin = (artificialMarginA < artificialMarginB) ? artificialMarginA : artificialMarginB;
+    return (centerDist2 <= radSum * radSum) && (overlapDepth > (T1)artificialMargin);
+}
+
 /// Host version of applying a local rotation then a translation.
 template <typename T1, typename T2, typename T3>
 inline void applyFrameTransformLocalToGlobal(T1& pos, const T2& vec, const T3& rot_Q) {
@@ -28,19 +28,24 @@
 // OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include <algorithm>
+#include <cctype>
 #include <cstdio>
+#include <cstring>
+#include <filesystem>
 #include <fstream>
+#include <limits>
 #include <map>
+#include <queue>
+#include <set>
+#include <thread>
 #include <unordered_map>
 
 #include <nvmath/helper_math.cuh>
 #include <DEM/BdrsAndObjs.h>
-#include <core/utils/WavefrontMeshLoader.hpp>
+#include <core/utils/FastMeshLoader.hpp>
 
 namespace deme {
 
-using namespace WAVEFRONT;
-
 std::vector<std::vector<float>> DEMMeshConnected::GetCoordsVerticesAsVectorOfVectors() {
     auto vec = GetCoordsVertices();
     std::vector<std::vector<float>> res(vec.size());
@@ -59,6 +64,24 @@ std::vector<std::vector<int>> DEMMeshConnected::GetIndicesVertexesAsVectorOfVect
     return res;
 }
 
+// Move what a mesh file loader produced into this mesh
+static void adoptMeshFileData(DEMMeshConnected& mesh,
+                              MeshFileData<float3, int3>& data,
+                              bool load_normals,
+                              bool load_uv) {
+    mesh.m_vertices = std::move(data.vertices);
+    mesh.m_face_v_indices = std::move(data.faceVIndices);
+    if (load_normals) {
+        mesh.m_normals = std::move(data.normals);
+        mesh.m_face_n_indices = std::move(data.faceNIndices);
+    }
+    if (load_uv) {
+        mesh.m_UV = std::move(data.UV);
+        mesh.m_face_uv_indices = std::move(data.faceUVIndices);
+    }
+    mesh.nTri = mesh.m_face_v_indices.size();
+}
+
 bool DEMMeshConnected::LoadWavefrontMesh(std::string input_file, bool load_normals, bool load_uv) {
     this->m_vertices.clear();
     this->m_normals.clear();
@@ -67,70 +90,1123 @@ bool DEMMeshConnected::LoadWavefrontMesh(std::string input_file, bool load_norma
     this->m_face_n_indices.clear();
     this->m_face_uv_indices.clear();
 
-    GeometryInterface emptybm;  // BuildMesh bm;
-
     filename = input_file;
 
-    OBJ obj;
+    MeshFileData<float3, int3> data;
+    if (!LoadObjFile(filename, data)) {
+        std::cerr << "Error loading OBJ file " << filename << ": " << data.error << std::endl;
+        return false;
+    }
+    adoptMeshFileData(*this, data, load_normals, load_uv);
+
+    return true;
+}
 
-    int ret = obj.LoadMesh(filename.c_str(), &emptybm, true);
-    if (ret == -1) {
-        std::cerr << "Error loading OBJ file " << filename << std::endl;
+bool DEMMeshConnected::LoadSTLMesh(std::string input_file, bool load_normals) {
+    this->m_vertices.clear();
+    this->m_normals.clear();
+    this->m_UV.clear();
+    this->m_face_v_indices.clear();
+    this->m_face_n_indices.clear();
+    this->m_face_uv_indices.clear();
+
+    filename = input_file;
+
+    MeshFileData<float3, int3> data;
+    if (!LoadBinaryStlFile(filename, data)) {
+        std::cerr << "Error loading STL file " << filename << ": " << data.error << std::endl;
         return false;
     }
+    adoptMeshFileData(*this, data, load_normals, false);
+
+    return true;
+}
+
+bool DEMMeshConnected::LoadMeshFile(std::string input_file, bool load_normals, bool load_uv) {
+    std::string ext = std::filesystem::path(input_file).extension().string();
+    std::transform(ext.begin(), ext.end(), ext.begin(), [](unsigned char c) { return std::tolower(c); });
+    if (ext == ".stl") {
+        return LoadSTLMesh(input_file, load_normals);
+    }
+    return LoadWavefrontMesh(input_file, load_normals, load_uv);
+}
+
+// Polyhedral mass properties (D. Eberly), using the divergence theorem over the facets of a closed mesh
+// Contribution of one facet, wound so its normal points outward, to the volume integrals of 1, x, y, z, x^2, y^2, z^2,
+// xy, yz, zx of a closed mesh (Eberly, Polyhedral Mass Properties), before meshIntgMult is applied
+static void meshFacetIntegrals(const float3& v0, const float3& v1, const float3& v2, double* intg) {
+    auto subexpressions = [](double w0, double w1, double w2, double& f1, double& f2, double& f3, double& g0,
+                             double& g1, double& g2) {
+        double temp0 = w0 + w1;
+        f1 = temp0 + w2;
+        double temp1 = w0 * w0;
+        double temp2 = temp1 + w1 * temp0;
+        f2 = temp2 + w2 * f1;
+        f3 = w0 * temp1 + w1 * temp2 + w2 * f2;
+        g0 = f2 + w0 * (f1 + w0);
+        g1 = f2 + w1 * (f1 + w1);
+        g2 = f2 + w2 * (f1 + w2);
+    };
+
+    double x0 = v0.x, y0 = v0.y, z0 = v0.z;
+    double x1 = v1.x, y1 = v1.y, z1 = v1.z;
+    double x2 = v2.x, y2 = v2.y, z2 = v2.z;
+
+    // Edges and cross product of edges
+    double a1 = x1 - x0, b1 = y1 - y0, c1 = z1 - z0;
+    double a2 = x2 - x0, b2 = y2 - y0, c2 = z2 - z0;
+    double d0 = b1 * c2 - b2 * c1;
+    double d1 = a2 * c1 - a1 * c2;
+    double d2 = a1 * b2 - a2 * b1;
+
+    double f1x, f2x, f3x, g0x, g1x, g2x;
+    double f1y, f2y, f3y, g0y, g1y, g2y;
+    double f1z, f2z, f3z, g0z, g1z, g2z;
+    subexpressions(x0, x1, x2, f1x, f2x, f3x, g0x, g1x, g2x);
+    subexpressions(y0, y1, y2, f1y, f2y, f3y, g0y, g1y, g2y);
+    subexpressions(z0, z1, z2, f1z, f2z, f3z, g0z, g1z, g2z);
+
+    intg[0] = d0 * f1x;
+    intg[1] = d0 * f2x;
+    intg[2] = d1 * f2y;
+    intg[3] = d2 * f2z;
+    intg[4] = d0 * f3x;
+    intg[5] = d1 * f3y;
+    intg[6] = d2 * f3z;
+    intg[7] = d0 * (y0 * g0x + y1 * g1x + y2 * g2x);
+    intg[8] = d1 * (z0 * g0y + z1 * g1y + z2 * g2y);
+    intg[9] = d2 * (x0 * g0z + x1 * g1z + x2 * g2z);
+}
+// Order: 1, x, y, z, x^2, y^2, z^2, xy, yz, zx
+static const double meshIntgMult[10] = {1. / 6.,  1. / 24., 1. / 24.,  1. / 24.,  1. / 60.,
+                                        1. / 60., 1. / 60., 1. / 120., 1. / 120., 1. / 120.};
+
+// a . (b x c), in double
+static double meshTripleProduct(const float3& a, const float3& b, const float3& c) {
+    return (double)a.x * ((double)b.y * c.z - (double)b.z * c.y) +
+           (double)a.y * ((double)b.z * c.x - (double)b.x * c.z) +
+           (double)a.z * ((double)b.x * c.y - (double)b.y * c.x);
+}
+
+// Compensated (Neumaier) summation, so 1e6+ facet contributions of mixed signs do not lose digits
+struct MeshNeumaierSum {
+    double sum = 0.;
+    double comp = 0.;
+    void Add(double x) {
+        double t = sum + x;
+        if (std::abs(sum) >= std::abs(x))
+            comp += (sum - t) + x;
+        else
+            comp += (x - t) + sum;
+        sum = t;
+    }
+    double Value() const { return sum + comp; }
+};
+
+// Run fn(begin, end) on num_threads static slices of [0, n)
+template <typename Func>
+static void meshParallelFor(size_t n, unsigned int num_threads, Func&& fn) {
+    size_t n_slices = std::max<size_t>(1, std::min<size_t>(num_threads, n));
+    if (n_slices == 1) {
+        fn((size_t)0, n);
+        return;
+    }
+    std::vector<std::thread> workers;
+    for (size_t i = 0; i < n_slices; i++)
+        workers.emplace_back([&fn, i, n, n_slices]() { fn(n * i / n_slices, n * (i + 1) / n_slices); });
+    for (auto& w : workers)
+        w.join();
+}
+
+// Eigen decomposition of a symmetric 3x3 matrix with cyclic Jacobi rotations: A = V diag(evals) V^T
+static void symmetricEigen3(double A[3][3], double evals[3], double V[3][3]) {
+    for (int i = 0; i < 3; i++)
+        for (int j = 0; j < 3; j++)
+            V[i][j] = (i == j) ? 1. : 0.;
+    for (int sweep = 0; sweep < 50; sweep++) {
+        double off = A[0][1] * A[0][1] + A[1][2] * A[1][2] + A[0][2] * A[0][2];
+        double diag = A[0][0] * A[0][0] + A[1][1] * A[1][1] + A[2][2] * A[2][2];
+        if (off <= 1e-30 * diag || off == 0.)
+            break;
+        for (int p = 0; p < 2; p++) {
+            for (int q = p + 1; q < 3; q++) {
+                if (A[p][q] == 0.)
+                    continue;
+                double theta = (A[q][q] - A[p][p]) / (2. * A[p][q]);
+                double t = (theta >= 0. ? 1. : -1.) / (std::abs(theta) + std::sqrt(theta * theta + 1.));
+                double c = 1. / std::sqrt(t * t + 1.), s = t * c;
+                for (int k = 0; k < 3; k++) {
+                    double akp = A[k][p], akq = A[k][q];
+                    A[k][p] = c * akp - s * akq;
+                    A[k][q] = s * akp + c * akq;
+                }
+                for (int k = 0; k < 3; k++) {
+                    double apk = A[p][k], aqk = A[q][k];
+                    A[p][k] = c * apk - s * aqk;
+                    A[q][k] = s * apk + c * aqk;
+                }
+                for (int k = 0; k < 3; k++) {
+                    double vkp = V[k][p], vkq = V[k][q];
+                    V[k][p] = c * vkp - s * vkq;
+                    V[k][q] = s * vkp + c * vkq;
+                }
+            }
+        }
+    }
+    for (int i = 0; i < 3; i++)
+        evals[i] = A[i][i];
+}
 
-    float3 tmp_f3;
-    int3 tmp_i3;
-    for (unsigned int iv = 0; iv < obj.mVerts.size(); iv += 3) {
-        tmp_f3.x = obj.mVerts[iv];
-        tmp_f3.y = obj.mVerts[iv + 1];
-        tmp_f3.z = obj.mVerts[iv + 2];
-        this->m_vertices.push_back(tmp_f3);
+MeshMassProperties DEMMeshConnected::ComputeMassProperties(unsigned int num_threads) const {
+    if (num_threads == 0)
+        num_threads = std::max(1u, std::thread::hardware_concurrency());
+    MeshMassProperties props;
+    const size_t n_facets = m_face_v_indices.size();
+    const size_t n_nodes = m_vertices.size();
+
+    // Merge nodes at identical locations first, since STL files (and many exporters) repeat the nodes for each facet.
+    // A merged node is known by the smallest index among its copies. The nodes are hashed by their bits, in an open
+    // addressing table.
+    std::vector<unsigned int> node_id(n_nodes);
+    {
+        auto bits = [](float v) -> uint64_t {
+            uint32_t b;
+            v = (v == 0.f) ? 0.f : v;  // -0 and 0 are the same location
+            std::memcpy(&b, &v, sizeof(b));
+            return b;
+        };
+        size_t table_size = 16;
+        while (table_size < 2 * n_nodes)
+            table_size *= 2;
+        const unsigned int EMPTY = std::numeric_limits<unsigned int>::max();
+        std::vector<unsigned int> table(table_size, EMPTY);
+        for (size_t i = 0; i < n_nodes; i++) {
+            const float3& p = m_vertices[i];
+            uint64_t h = (bits(p.x) << 32 | bits(p.y)) ^ (bits(p.z) * 0x9E3779B97F4A7C15ull);
+            h ^= h >> 31;
+            h *= 0xBF58476D1CE4E5B9ull;
+            h ^= h >> 29;
+            size_t slot = h & (table_size - 1);
+            while (true) {
+                unsigned int other = table[slot];
+                if (other == EMPTY) {
+                    table[slot] = i;
+                    node_id[i] = i;
+                    break;
+                }
+                const float3& q = m_vertices[other];
+                if (p.x == q.x && p.y == q.y && p.z == q.z) {
+                    node_id[i] = other;
+                    break;
+                }
+                slot = (slot + 1) & (table_size - 1);
+            }
+        }
     }
-    for (unsigned int in = 0; in < obj.mNormals.size(); in += 3) {
-        tmp_f3.x = obj.mNormals[in];
-        tmp_f3.y = obj.mNormals[in + 1];
-        tmp_f3.z = obj.mNormals[in + 2];
-        this->m_normals.push_back(tmp_f3);
+    auto facetNode = [&](size_t f, int k) -> unsigned int {
+        const int3& t = m_face_v_indices[f];
+        return node_id[k == 0 ? t.x : (k == 1 ? t.y : t.z)];
+    };
+
+    // Facets with zero area do not count in the topology, nor in the integrals. Also get (6 times) the signed volume
+    // of the tetrahedron made by each facet and the origin, to tell which shells are inside out later.
+    std::vector<char> degenerate(n_facets, 0);
+    std::vector<double> facet_volume(n_facets, 0.);
+    meshParallelFor(n_facets, num_threads, [&](size_t begin, size_t end) {
+        for (size_t f = begin; f < end; f++) {
+            unsigned int a = facetNode(f, 0), b = facetNode(f, 1), c = facetNode(f, 2);
+            const int3& t = m_face_v_indices[f];
+            const float3& v0 = m_vertices[t.x];
+            const float3& v1 = m_vertices[t.y];
+            const float3& v2 = m_vertices[t.z];
+            float3 n = cross(v1 - v0, v2 - v0);
+            degenerate[f] = (a == b || b == c || c == a || (n.x == 0.f && n.y == 0.f && n.z == 0.f));
+            facet_volume[f] = meshTripleProduct(v0, v1, v2);
+        }
+    });
+
+    // Bucket the edges (as facet * 3 + local edge index) by their smaller node, then sort each bucket by the larger
+    // node, so the facets sharing an edge come together
+    auto edgeLow = [&](size_t slot) {
+        return std::min(facetNode(slot / 3, slot % 3), facetNode(slot / 3, (slot + 1) % 3));
+    };
+    auto edgeHigh = [&](size_t slot) {
+        return std::max(facetNode(slot / 3, slot % 3), facetNode(slot / 3, (slot + 1) % 3));
+    };
+    std::vector<size_t> bucket_start(n_nodes + 1, 0);
+    for (size_t f = 0; f < n_facets; f++) {
+        if (degenerate[f]) {
+            props.num_degenerate_facets++;
+            continue;
+        }
+        for (int k = 0; k < 3; k++)
+            bucket_start[edgeLow(3 * f + k) + 1]++;
     }
-    for (unsigned int it = 0; it < obj.mTexels.size(); it += 2)  // +2 because only u,v each texel
+    for (size_t i = 0; i < n_nodes; i++)
+        bucket_start[i + 1] += bucket_start[i];
+    std::vector<size_t> edges(bucket_start[n_nodes]);
     {
-        tmp_f3.x = obj.mTexels[it];
-        tmp_f3.y = obj.mTexels[it + 1];
-        tmp_f3.z = 0;
-        this->m_UV.push_back(tmp_f3);
+        std::vector<size_t> fill(bucket_start.begin(), bucket_start.end() - 1);
+        for (size_t f = 0; f < n_facets; f++) {
+            if (degenerate[f])
+                continue;
+            for (int k = 0; k < 3; k++)
+                edges[fill[edgeLow(3 * f + k)]++] = 3 * f + k;
+        }
     }
-    for (unsigned int iiv = 0; iiv < obj.mIndexesVerts.size(); iiv += 3) {
-        tmp_i3.x = obj.mIndexesVerts[iiv];
-        tmp_i3.y = obj.mIndexesVerts[iiv + 1];
-        tmp_i3.z = obj.mIndexesVerts[iiv + 2];
-        this->m_face_v_indices.push_back(tmp_i3);
+    meshParallelFor(n_nodes, num_threads, [&](size_t begin, size_t end) {
+        for (size_t n = begin; n < end; n++) {
+            std::sort(edges.begin() + bucket_start[n], edges.begin() + bucket_start[n + 1], [&](size_t a, size_t b) {
+                unsigned int ha = edgeHigh(a), hb = edgeHigh(b);
+                return ha != hb ? ha < hb : a < b;
+            });
+        }
+    });
+    // Whether a facet runs through its local edge k from the smaller node to the larger one
+    auto edgeForward = [&](size_t slot) { return facetNode(slot / 3, slot % 3) < facetNode(slot / 3, (slot + 1) % 3); };
+
+    // Across each manifold edge, the neighbor facet and whether the two run through the edge in the same direction
+    // (which means one of them is flipped)
+    const size_t NO_NEIGHBOR = std::numeric_limits<size_t>::max();
+    std::vector<size_t> neighbor(3 * n_facets, NO_NEIGHBOR);
+    std::vector<char> same_dir(3 * n_facets, 0);
+    std::vector<size_t> boundary_slots;
+    for (size_t n = 0; n < n_nodes; n++) {
+        for (size_t i = bucket_start[n]; i < bucket_start[n + 1];) {
+            size_t j = i + 1;
+            while (j < bucket_start[n + 1] && edgeHigh(edges[j]) == edgeHigh(edges[i]))
+                j++;
+            if (j - i == 1) {
+                boundary_slots.push_back(edges[i]);
+            } else if (j - i == 2) {
+                size_t s0 = edges[i], s1 = edges[i + 1];
+                bool same = (edgeForward(s0) == edgeForward(s1));
+                neighbor[s0] = s1 / 3;
+                neighbor[s1] = s0 / 3;
+                same_dir[s0] = same_dir[s1] = same;
+            } else {
+                props.num_nonmanifold_edges++;
+            }
+            i = j;
+        }
     }
-    for (unsigned int iin = 0; iin < obj.mIndexesNormals.size(); iin += 3) {
-        tmp_i3.x = obj.mIndexesNormals[iin];
-        tmp_i3.y = obj.mIndexesNormals[iin + 1];
-        tmp_i3.z = obj.mIndexesNormals[iin + 2];
-        this->m_face_n_indices.push_back(tmp_i3);
+    props.num_boundary_edges = boundary_slots.size();
+    deallocate_array(edges);
+
+    // Make the winding consistent in each connected shell, keeping the winding of the majority of its facets
+    std::vector<char> flip(n_facets, 0);
+    std::vector<size_t> shell_of(n_facets, NO_NEIGHBOR);
+    std::vector<std::vector<size_t>> shells;
+    for (size_t seed = 0; seed < n_facets; seed++) {
+        if (degenerate[seed] || shell_of[seed] != NO_NEIGHBOR)
+            continue;
+        std::vector<size_t> members;
+        std::queue<size_t> to_visit;
+        shell_of[seed] = shells.size();
+        to_visit.push(seed);
+        size_t num_flipped = 0;
+        while (!to_visit.empty()) {
+            size_t f = to_visit.front();
+            to_visit.pop();
+            members.push_back(f);
+            num_flipped += flip[f];
+            for (int k = 0; k < 3; k++) {
+                size_t nb = neighbor[3 * f + k];
+                if (nb == NO_NEIGHBOR || shell_of[nb] != NO_NEIGHBOR)
+                    continue;
+                shell_of[nb] = shells.size();
+                flip[nb] = flip[f] ^ same_dir[3 * f + k];
+                to_visit.push(nb);
+            }
+        }
+        if (2 * num_flipped > members.size()) {
+            for (size_t f : members)
+                flip[f] = !flip[f];
+            num_flipped = members.size() - num_flipped;
+        }
+        props.num_flipped_facets += num_flipped;
+        shells.push_back(std::move(members));
     }
-    for (unsigned int iit = 0; iit < obj.mIndexesTexels.size(); iit += 3) {
-        tmp_i3.x = obj.mIndexesTexels[iit];
-        tmp_i3.y = obj.mIndexesTexels[iit + 1];
-        tmp_i3.z = obj.mIndexesTexels[iit + 2];
-        this->m_face_uv_indices.push_back(tmp_i3);
+    deallocate_array(neighbor);
+    deallocate_array(same_dir);
+
+    // Close each boundary loop with a fan around its centroid. Walk the boundary edges in the direction the (fixed)
+    // facets run through them, so the fan facets are wound the same way as the shell.
+    std::vector<std::array<float3, 3>> caps;
+    std::vector<size_t> cap_shell;
+    {
+        std::unordered_multimap<unsigned int, size_t> starting_at;
+        auto edgeFrom = [&](size_t slot) {
+            return facetNode(slot / 3, flip[slot / 3] ? (slot + 1) % 3 : slot % 3);
+        };
+        auto edgeTo = [&](size_t slot) {
+            return facetNode(slot / 3, flip[slot / 3] ? slot % 3 : (slot + 1) % 3);
+        };
+        // A representative location for each merged node
+        std::vector<float3> node_loc(n_nodes);
+        for (size_t i = 0; i < n_nodes; i++)
+            node_loc[node_id[i]] = m_vertices[i];
+        for (size_t slot : boundary_slots)
+            starting_at.insert({edgeFrom(slot), slot});
+        std::vector<char> used_slot;
+        std::unordered_map<size_t, size_t> slot_index;
+        for (size_t i = 0; i < boundary_slots.size(); i++)
+            slot_index[boundary_slots[i]] = i;
+        used_slot.assign(boundary_slots.size(), 0);
+        for (size_t i = 0; i < boundary_slots.size(); i++) {
+            if (used_slot[i])
+                continue;
+            std::vector<size_t> loop;
+            size_t slot = boundary_slots[i];
+            unsigned int start = edgeFrom(slot);
+            while (true) {
+                used_slot[slot_index[slot]] = 1;
+                loop.push_back(slot);
+                unsigned int next_node = edgeTo(slot);
+                if (next_node == start)
+                    break;
+                size_t next_slot = NO_NEIGHBOR;
+                auto range = starting_at.equal_range(next_node);
+                for (auto it = range.first; it != range.second; it++) {
+                    if (!used_slot[slot_index[it->second]]) {
+                        next_slot = it->second;
+                        break;
+                    }
+                }
+                // An open chain (around non-manifold nodes) is closed by the fan all the same
+                if (next_slot == NO_NEIGHBOR)
+                    break;
+                slot = next_slot;
+            }
+            float3 centroid = make_float3(0.f);
+            for (size_t s : loop)
+                centroid += node_loc[edgeFrom(s)];
+            centroid /= (float)loop.size();
+            // A loop may touch several shells when the mesh is non-manifold; the fan goes with the first one
+            size_t shell = shell_of[loop[0] / 3];
+            for (size_t s : loop) {
+                caps.push_back({node_loc[edgeTo(s)], node_loc[edgeFrom(s)], centroid});
+                cap_shell.push_back(shell);
+            }
+            props.num_holes_closed++;
+        }
+    }
+    props.watertight = (props.num_boundary_edges == 0 && props.num_nonmanifold_edges == 0);
+
+    // Shells with negative volume are inside out
+    auto facetSign = [&](size_t f) { return flip[f] ? -1. : 1.; };
+    std::vector<MeshNeumaierSum> shell_volume(shells.size());
+    for (size_t s = 0; s < shells.size(); s++) {
+        for (size_t f : shells[s])
+            shell_volume[s].Add(facetSign(f) * facet_volume[f]);
+    }
+    for (size_t c = 0; c < caps.size(); c++)
+        shell_volume[cap_shell[c]].Add(meshTripleProduct(caps[c][0], caps[c][1], caps[c][2]));
+    std::vector<char> shell_inverted(shells.size(), 0);
+    for (size_t s = 0; s < shells.size(); s++) {
+        if (shell_volume[s].Value() < 0.) {
+            shell_inverted[s] = 1;
+            props.num_inverted_shells++;
+        }
     }
 
-    if (!load_normals) {
-        this->m_normals.clear();
-        this->m_face_n_indices.clear();
+    // The integrals. Facets are summed in fixed-size chunks, then the chunks are added up pairwise, so the result does
+    // not depend on the number of threads.
+    const size_t CHUNK = 4096;
+    size_t n_chunks = (n_facets + CHUNK - 1) / CHUNK;
+    std::vector<std::array<double, 10>> chunk_sums(n_chunks + 1);
+    meshParallelFor(n_chunks, num_threads, [&](size_t begin, size_t end) {
+        double intg[10];
+        for (size_t c = begin; c < end; c++) {
+            MeshNeumaierSum sums[10];
+            for (size_t f = c * CHUNK; f < std::min(n_facets, (c + 1) * CHUNK); f++) {
+                if (degenerate[f])
+                    continue;
+                const int3& t = m_face_v_indices[f];
+                meshFacetIntegrals(m_vertices[t.x], m_vertices[t.y], m_vertices[t.z], intg);
+                double sign = shell_inverted[shell_of[f]] ? -facetSign(f) : facetSign(f);
+                for (int i = 0; i < 10; i++)
+                    sums[i].Add(sign * intg[i]);
+            }
+            for (int i = 0; i < 10; i++)
+                chunk_sums[c][i] = sums[i].Value();
+        }
+    });
+    {
+        double intg[10];
+        MeshNeumaierSum sums[10];
+        for (size_t c = 0; c < caps.size(); c++) {
+            meshFacetIntegrals(caps[c][0], caps[c][1], caps[c][2], intg);
+            double sign = shell_inverted[cap_shell[c]] ? -1. : 1.;
+            for (int i = 0; i < 10; i++)
+                sums[i].Add(sign * intg[i]);
+        }
+        for (int i = 0; i < 10; i++)
+            chunk_sums[n_chunks][i] = sums[i].Value();
     }
-    if (!load_uv) {
-        this->m_UV.clear();
-        this->m_face_uv_indices.clear();
+    for (size_t width = 1; width < chunk_sums.size(); width *= 2) {
+        for (size_t c = 0; c + width < chunk_sums.size(); c += 2 * width) {
+            for (int i = 0; i < 10; i++)
+                chunk_sums[c][i] += chunk_sums[c + width][i];
+        }
     }
+    double intg[10];
+    for (int i = 0; i < 10; i++)
+        intg[i] = chunk_sums[0][i] * meshIntgMult[i];
 
-    this->nTri = m_face_v_indices.size();
+    props.volume = intg[0];
+    if (props.volume <= 0.)
+        return props;
+    double cx = intg[1] / props.volume;
+    double cy = intg[2] / props.volume;
+    double cz = intg[3] / props.volume;
+    props.center = host_make_float3(cx, cy, cz);
+    // Inertia relative to the center of mass
+    double V = props.volume;
+    props.inertia[0] = intg[5] + intg[6] - V * (cy * cy + cz * cz);
+    props.inertia[1] = intg[4] + intg[6] - V * (cz * cz + cx * cx);
+    props.inertia[2] = intg[4] + intg[5] - V * (cx * cx + cy * cy);
+    props.inertia[3] = -(intg[7] - V * cx * cy);
+    props.inertia[4] = -(intg[8] - V * cy * cz);
+    props.inertia[5] = -(intg[9] - V * cz * cx);
 
-    return true;
+    // Principal frame: the columns of R are the principal axes, in ascending order of moments, forming a right-handed
+    // frame
+    double A[3][3] = {{props.inertia[0], props.inertia[3], props.inertia[5]},
+                      {props.inertia[3], props.inertia[1], props.inertia[4]},
+                      {props.inertia[5], props.inertia[4], props.inertia[2]}};
+    double evals[3], evecs[3][3];
+    symmetricEigen3(A, evals, evecs);
+    int idx[3] = {0, 1, 2};
+    std::sort(idx, idx + 3, [&](int a, int b) { return evals[a] < evals[b]; });
+    double R[3][3];
+    for (int i = 0; i < 3; i++)
+        for (int j = 0; j < 3; j++)
+            R[i][j] = evecs[i][idx[j]];
+    double det = R[0][0] * (R[1][1] * R[2][2] - R[1][2] * R[2][1]) - R[0][1] * (R[1][0] * R[2][2] - R[1][2] * R[2][0]) +
+                 R[0][2] * (R[1][0] * R[2][1] - R[1][1] * R[2][0]);
+    if (det < 0.) {
+        for (int i = 0; i < 3; i++)
+            R[i][2] = -R[i][2];
+    }
+    props.principal_inertia = host_make_float3(evals[idx[0]], evals[idx[1]], evals[idx[2]]);
+
+    // Rotation matrix to quaternion (Shepperd)
+    double qw, qx, qy, qz;
+    double trace = R[0][0] + R[1][1] + R[2][2];
+    if (trace > 0.) {
+        double s = 2. * std::sqrt(trace + 1.);
+        qw = 0.25 * s;
+        qx = (R[2][1] - R[1][2]) / s;
+        qy = (R[0][2] - R[2][0]) / s;
+        qz = (R[1][0] - R[0][1]) / s;
+    } else if (R[0][0] > R[1][1] && R[0][0] > R[2][2]) {
+        double s = 2. * std::sqrt(1. + R[0][0] - R[1][1] - R[2][2]);
+        qw = (R[2][1] - R[1][2]) / s;
+        qx = 0.25 * s;
+        qy = (R[0][1] + R[1][0]) / s;
+        qz = (R[0][2] + R[2][0]) / s;
+    } else if (R[1][1] > R[2][2]) {
+        double s = 2. * std::sqrt(1. + R[1][1] - R[0][0] - R[2][2]);
+        qw = (R[0][2] - R[2][0]) / s;
+        qx = (R[0][1] + R[1][0]) / s;
+        qy = 0.25 * s;
+        qz = (R[1][2] + R[2][1]) / s;
+    } else {
+        double s = 2. * std::sqrt(1. + R[2][2] - R[0][0] - R[1][1]);
+        qw = (R[1][0] - R[0][1]) / s;
+        qx = (R[0][2] + R[2][0]) / s;
+        qy = (R[1][2] + R[2][1]) / s;
+        qz = 0.25 * s;
+    }
+    double qn = std::sqrt(qw * qw + qx * qx + qy * qy + qz * qz);
+    props.principal_Q = host_make_float4(qx / qn, qy / qn, qz / qn, qw / qn);
+    return props;
+}
+
+void DEMMeshConnected::ComputeMassProperties(double& mass, float3& center, float3& inertia) const {
+    MeshMassProperties props = ComputeMassProperties();
+    mass = props.volume;
+    center = props.center;
+    inertia = host_make_float3(props.inertia[0], props.inertia[1], props.inertia[2]);
+}
+
+// Symmetric 4x4 quadric that sums the squared distances to a set of planes (Garland and Heckbert)
+struct MeshQuadric {
+    // xx, xy, xz, xw, yy, yz, yw, zz, zw, ww
+    double a[10] = {0., 0., 0., 0., 0., 0., 0., 0., 0., 0.};
+
+    void AddPlane(const float3& n, double d) {
+        double x = n.x, y = n.y, z = n.z;
+        a[0] += x * x;
+        a[1] += x * y;
+        a[2] += x * z;
+        a[3] += x * d;
+        a[4] += y * y;
+        a[5] += y * z;
+        a[6] += y * d;
+        a[7] += z * z;
+        a[8] += z * d;
+        a[9] += d * d;
+    }
+    void operator+=(const MeshQuadric& other) {
+        for (int i = 0; i < 10; i++)
+            a[i] += other.a[i];
+    }
+    double Eval(const float3& p) const {
+        double x = p.x, y = p.y, z = p.z;
+        return a[0] * x * x + 2. * a[1] * x * y + 2. * a[2] * x * z + 2. * a[3] * x + a[4] * y * y +
+               2. * a[5] * y * z + 2. * a[6] * y + a[7] * z * z + 2. * a[8] * z + a[9];
+    }
+    // The point of min error, if the quadric is well-conditioned
+    bool Optimum(float3& p) const {
+        double det = a[0] * (a[4] * a[7] - a[5] * a[5]) - a[1] * (a[1] * a[7] - a[5] * a[2]) +
+                     a[2] * (a[1] * a[5] - a[4] * a[2]);
+        double scale = a[0] + a[4] + a[7];
+        if (std::abs(det) <= 1e-9 * scale * scale * scale)
+            return false;
+        double bx = -a[3], by = -a[6], bz = -a[8];
+        double x = (bx * (a[4] * a[7] - a[5] * a[5]) - a[1] * (by * a[7] - a[5] * bz) + a[2] * (by * a[5] - a[4] * bz));
+        double y = (a[0] * (by * a[7] - a[5] * bz) - bx * (a[1] * a[7] - a[5] * a[2]) + a[2] * (a[1] * bz - by * a[2]));
+        double z = (a[0] * (a[4] * bz - by * a[5]) - a[1] * (a[1] * bz - by * a[2]) + bx * (a[1] * a[5] - a[4] * a[2]));
+        p = host_make_float3(x / det, y / det, z / det);
+        return true;
+    }
+};
+
+// Squared distance from a point to a triangle (closest point by Voronoi regions, as in Ericson's book)
+static double pointTriangleDist2(const float3& p, const float3& a, const float3& b, const float3& c) {
+    float3 ab = b - a, ac = c - a, ap = p - a;
+    float d1 = dot(ab, ap), d2 = dot(ac, ap);
+    float3 closest;
+    if (d1 <= 0.f && d2 <= 0.f) {
+        closest = a;
+    } else {
+        float3 bp = p - b;
+        float d3 = dot(ab, bp), d4 = dot(ac, bp);
+        float3 cp = p - c;
+        float d5 = dot(ab, cp), d6 = dot(ac, cp);
+        float vc = d1 * d4 - d3 * d2, vb = d5 * d2 - d1 * d6, va = d3 * d6 - d5 * d4;
+        if (d3 >= 0.f && d4 <= d3) {
+            closest = b;
+        } else if (d6 >= 0.f && d5 <= d6) {
+            closest = c;
+        } else if (vc <= 0.f && d1 >= 0.f && d3 <= 0.f) {
+            closest = a + (d1 / (d1 - d3)) * ab;
+        } else if (vb <= 0.f && d2 >= 0.f && d6 <= 0.f) {
+            closest = a + (d2 / (d2 - d6)) * ac;
+        } else if (va <= 0.f && (d4 - d3) >= 0.f && (d5 - d6) >= 0.f) {
+            closest = b + ((d4 - d3) / ((d4 - d3) + (d5 - d6))) * (c - b);
+        } else {
+            float denom = 1.f / (va + vb + vc);
+            closest = a + (vb * denom) * ab + (vc * denom) * ac;
+        }
+    }
+    float3 diff = p - closest;
+    return (double)dot(diff, diff);
+}
+
+// Uniform grid of triangles, for nearest-facet distance queries
+class MeshTriangleGrid {
+  public:
+    MeshTriangleGrid(const std::vector<float3>& nodes, const std::vector<int3>& faces)
+        : m_nodes(nodes), m_faces(faces) {
+        m_lo = nodes[0];
+        m_hi = nodes[0];
+        for (const auto& p : nodes) {
+            m_lo = fminf(m_lo, p);
+            m_hi = fmaxf(m_hi, p);
+        }
+        float3 ext = m_hi - m_lo;
+        double max_ext = std::max(ext.x, std::max(ext.y, ext.z));
+        int res = std::max(1, std::min(128, (int)std::cbrt((double)faces.size())));
+        m_h = std::max(max_ext / res, 1e-12);
+        m_n[0] = (int)(ext.x / m_h) + 1;
+        m_n[1] = (int)(ext.y / m_h) + 1;
+        m_n[2] = (int)(ext.z / m_h) + 1;
+        m_cells.resize((size_t)m_n[0] * m_n[1] * m_n[2]);
+        for (size_t f = 0; f < faces.size(); f++) {
+            const float3& a = nodes[faces[f].x];
+            const float3& b = nodes[faces[f].y];
+            const float3& c = nodes[faces[f].z];
+            int lo[3], hi[3];
+            cellRange(fminf(a, fminf(b, c)), fmaxf(a, fmaxf(b, c)), lo, hi);
+            for (int z = lo[2]; z <= hi[2]; z++)
+                for (int y = lo[1]; y <= hi[1]; y++)
+                    for (int x = lo[0]; x <= hi[0]; x++)
+                        m_cells[cellID(x, y, z)].push_back(f);
+        }
+    }
+
+    // Distance from p to the closest triangle, searching in growing boxes around p
+    double Distance(const float3& p) const {
+        double best = std::numeric_limits<double>::infinity();
+        float3 ext = m_hi - m_lo;
+        double max_r = length(ext) + length(p - m_lo);
+        for (double r = m_h; ; r *= 2.) {
+            int lo[3], hi[3];
+            cellRange(p - (float)r, p + (float)r, lo, hi);
+            for (int z = lo[2]; z <= hi[2]; z++)
+                for (int y = lo[1]; y <= hi[1]; y++)
+                    for (int x = lo[0]; x <= hi[0]; x++)
+                        for (size_t f : m_cells[cellID(x, y, z)])
+                            best = std::min(best, pointTriangleDist2(p, m_nodes[m_faces[f].x], m_nodes[m_faces[f].y],
+                                                                     m_nodes[m_faces[f].z]));
+            // Any triangle closer than r overlaps the searched box, so it has been looked at
+            if (best <= r * r || r > max_r)
+                break;
+        }
+        return std::sqrt(best);
+    }
+
+  private:
+    const std::vector<float3>& m_nodes;
+    const std::vector<int3>& m_faces;
+    float3 m_lo, m_hi;
+    double m_h;
+    int m_n[3];
+    std::vector<std::vector<size_t>> m_cells;
+
+    size_t cellID(int x, int y, int z) const { return (size_t)x + (size_t)m_n[0] * ((size_t)y + (size_t)m_n[1] * z); }
+    void cellRange(const float3& lo, const float3& hi, int* cell_lo, int* cell_hi) const {
+        const float lo_c[3] = {lo.x - m_lo.x, lo.y - m_lo.y, lo.z - m_lo.z};
+        const float hi_c[3] = {hi.x - m_lo.x, hi.y - m_lo.y, hi.z - m_lo.z};
+        for (int d = 0; d < 3; d++) {
+            cell_lo[d] = std::min(m_n[d] - 1, std::max(0, (int)std::floor(lo_c[d] / m_h)));
+            cell_hi[d] = std::min(m_n[d] - 1, std::max(0, (int)std::floor(hi_c[d] / m_h)));
+        }
+    }
+};
+
+static float3 facetNormal(const float3& a, const float3& b, const float3& c) {
+    return cross(b - a, c - a);
+}
+
+MeshDecimationReport DEMMeshConnected::Decimate(const MeshDecimationSettings& settings) {
+    MeshDecimationReport report;
+    const size_t nV = m_vertices.size();
+    const size_t nF = m_face_v_indices.size();
+    report.original_num_triangles = nF;
+    report.num_triangles = nF;
+    if (nF == 0)
+        return report;
+
+    std::vector<float3> pos(m_vertices);
+    std::vector<int3> faces(m_face_v_indices);
+    std::vector<char> face_alive(nF, 1), vert_alive(nV, 1), locked(nV, 0), on_boundary(nV, 0);
+    std::vector<unsigned int> stamp(nV, 0);
+    std::vector<std::vector<size_t>> vert_faces(nV);
+    for (size_t f = 0; f < nF; f++) {
+        const int3& t = faces[f];
+        if (t.x == t.y || t.y == t.z || t.z == t.x) {
+            face_alive[f] = 0;
+            continue;
+        }
+        vert_faces[t.x].push_back(f);
+        vert_faces[t.y].push_back(f);
+        vert_faces[t.z].push_back(f);
+    }
+    const std::vector<std::vector<size_t>> orig_vert_faces(vert_faces);
+    float3 lo = pos[0], hi = pos[0];
+    for (const auto& p : pos) {
+        lo = fminf(lo, p);
+        hi = fmaxf(hi, p);
+    }
+    const double diag = length(hi - lo);
+
+    // Facets of different materials are not merged, so the nodes they share stay where they are
+    const bool per_facet_mat = isMaterialSet && materials.size() == nF;
+    if (per_facet_mat) {
+        for (size_t v = 0; v < nV; v++) {
+            for (size_t f : vert_faces[v]) {
+                if (materials[f] != materials[vert_faces[v][0]])
+                    locked[v] = 1;
+            }
+        }
+    }
+
+    // Quadrics of the facet planes, plus planes perpendicular to open boundaries so boundaries keep their shape
+    std::vector<MeshQuadric> quad(nV);
+    std::map<std::pair<int, int>, std::vector<size_t>> edge_faces;
+    for (size_t f = 0; f < nF; f++) {
+        if (!face_alive[f])
+            continue;
+        const int v[3] = {faces[f].x, faces[f].y, faces[f].z};
+        float3 n = facetNormal(pos[v[0]], pos[v[1]], pos[v[2]]);
+        if (length(n) > 0.f) {
+            n = normalize(n);
+            for (int k = 0; k < 3; k++)
+                quad[v[k]].AddPlane(n, -dot(n, pos[v[0]]));
+        }
+        for (int k = 0; k < 3; k++)
+            edge_faces[std::minmax(v[k], v[(k + 1) % 3])].push_back(f);
+    }
+    for (const auto& e : edge_faces) {
+        int a = e.first.first, b = e.first.second;
+        if (e.second.size() == 1) {
+            const int3& t = faces[e.second[0]];
+            float3 n = facetNormal(pos[t.x], pos[t.y], pos[t.z]);
+            float3 m = cross(pos[b] - pos[a], n);
+            if (length(m) > 0.f) {
+                m = normalize(m);
+                quad[a].AddPlane(m, -dot(m, pos[a]));
+                quad[b].AddPlane(m, -dot(m, pos[a]));
+            }
+            on_boundary[a] = on_boundary[b] = 1;
+        } else if (e.second.size() > 2) {
+            // Non-manifold edge: leave it alone
+            locked[a] = locked[b] = 1;
+        }
+    }
+
+    const double cos_coplanar = std::cos(settings.coplanar_angle_tol * PI / 180.);
+    const double cos_max_turn = std::cos(settings.max_normal_change * PI / 180.);
+    // Candidates are ordered by error, plus a small term in the edge length so that in flat regions (where the error is
+    // 0) short edges go first and the mesh coarsens evenly, instead of everything collapsing into one big fan
+    struct Candidate {
+        double cost, err;
+        int v0, v1;
+        unsigned int stamp0, stamp1;
+        float3 target = make_float3(0.f);
+    };
+    auto later = [](const Candidate& a, const Candidate& b) {
+        if (a.cost != b.cost)
+            return a.cost > b.cost;
+        return (a.v0 != b.v0) ? (a.v0 > b.v0) : (a.v1 > b.v1);
+    };
+    std::priority_queue<Candidate, std::vector<Candidate>, decltype(later)> heap(later);
+
+    // Whether all alive facets around v0 and v1 lie in one plane
+    auto is_flat = [&](int v0, int v1) {
+        float3 ref = make_float3(0.f);
+        for (int v : {v0, v1}) {
+            for (size_t f : vert_faces[v]) {
+                if (!face_alive[f])
+                    continue;
+                float3 n = facetNormal(pos[faces[f].x], pos[faces[f].y], pos[faces[f].z]);
+                if (length(n) == 0.f)
+                    continue;
+                n = normalize(n);
+                if (length(ref) == 0.f)
+                    ref = n;
+                else if (dot(ref, n) < cos_coplanar)
+                    return false;
+            }
+        }
+        return true;
+    };
+
+    // Price the collapse of edge (v0, v1) and queue it, if it is allowed at all
+    auto evaluate = [&](int v0, int v1) {
+        if (v0 > v1)
+            std::swap(v0, v1);
+        if (locked[v0] || locked[v1])
+            return;
+        MeshQuadric q = quad[v0];
+        q += quad[v1];
+        // A boundary node must stay on the boundary, so an inner node goes to it
+        std::vector<float3> options;
+        if (on_boundary[v0] && !on_boundary[v1]) {
+            options.push_back(pos[v0]);
+        } else if (on_boundary[v1] && !on_boundary[v0]) {
+            options.push_back(pos[v1]);
+        } else {
+            float3 opt;
+            if (q.Optimum(opt))
+                options.push_back(opt);
+            options.push_back(pos[v0]);
+            options.push_back(pos[v1]);
+            options.push_back((pos[v0] + pos[v1]) * 0.5f);
+        }
+        Candidate c;
+        c.err = std::numeric_limits<double>::infinity();
+        for (const auto& p : options) {
+            double err = std::max(0., q.Eval(p));
+            if (err < c.err) {
+                c.err = err;
+                c.target = p;
+            }
+        }
+        // The sum of squared distances to the planes bounds the largest of these distances
+        if (std::sqrt(c.err) > settings.max_deviation + 1e-6 * diag)
+            return;
+        double edge_len = length(pos[v1] - pos[v0]);
+        c.cost = c.err + 1e-3 * edge_len * edge_len;
+        bool short_edge = edge_len < settings.target_edge_length;
+        if (!short_edge && !(settings.merge_coplanar && is_flat(v0, v1)))
+            return;
+        c.v0 = v0;
+        c.v1 = v1;
+        c.stamp0 = stamp[v0];
+        c.stamp1 = stamp[v1];
+        heap.push(c);
+    };
+    for (const auto& e : edge_faces)
+        evaluate(e.first.first, e.first.second);
+
+    size_t n_alive = std::count(face_alive.begin(), face_alive.end(), 1);
+    std::set<int> ring0, ring1;
+    std::vector<size_t> shared;
+    while (!heap.empty()) {
+        Candidate c = heap.top();
+        heap.pop();
+        int v0 = c.v0, v1 = c.v1;
+        if (!vert_alive[v0] || !vert_alive[v1] || stamp[v0] != c.stamp0 || stamp[v1] != c.stamp1)
+            continue;
+
+        // Link condition: the only common neighbors of v0 and v1 are the tips of the facets on the edge, so the
+        // collapse keeps the mesh manifold
+        ring0.clear();
+        ring1.clear();
+        shared.clear();
+        for (size_t f : vert_faces[v0]) {
+            if (!face_alive[f])
+                continue;
+            const int t[3] = {faces[f].x, faces[f].y, faces[f].z};
+            bool has_v1 = (t[0] == v1 || t[1] == v1 || t[2] == v1);
+            if (has_v1)
+                shared.push_back(f);
+            for (int k = 0; k < 3; k++) {
+                if (t[k] != v0)
+                    ring0.insert(t[k]);
+            }
+        }
+        if (shared.empty())
+            continue;
+        for (size_t f : vert_faces[v1]) {
+            if (!face_alive[f])
+                continue;
+            const int t[3] = {faces[f].x, faces[f].y, faces[f].z};
+            for (int k = 0; k < 3; k++) {
+                if (t[k] != v1)
+                    ring1.insert(t[k]);
+            }
+        }
+        size_t n_common = 0;
+        for (int v : ring0) {
+            if (v != v1 && ring1.count(v))
+                n_common++;
+        }
+        if (n_common != shared.size())
+            continue;
+        // Two boundary nodes may only be merged along a boundary edge
+        if (on_boundary[v0] && on_boundary[v1] && shared.size() != 1)
+            continue;
+
+        // No remaining facet may flip or turn too much
+        bool ok = true;
+        for (int v : {v0, v1}) {
+            for (size_t f : vert_faces[v]) {
+                if (!face_alive[f] || std::find(shared.begin(), shared.end(), f) != shared.end())
+                    continue;
+                float3 p[3] = {pos[faces[f].x], pos[faces[f].y], pos[faces[f].z]};
+                float3 n_old = facetNormal(p[0], p[1], p[2]);
+                const int t[3] = {faces[f].x, faces[f].y, faces[f].z};
+                for (int k = 0; k < 3; k++) {
+                    if (t[k] == v)
+                        p[k] = c.target;
+                }
+                float3 n_new = facetNormal(p[0], p[1], p[2]);
+                if (length(n_new) <= 1e-12 * diag * diag ||
+                    dot(n_old, n_new) < cos_max_turn * length(n_old) * length(n_new)) {
+                    ok = false;
+                    break;
+                }
+            }
+            if (!ok)
+                break;
+        }
+        if (!ok)
+            continue;
+
+        // Collapse v1 into v0
+        for (size_t f : shared)
+            face_alive[f] = 0;
+        n_alive -= shared.size();
+        for (size_t f : vert_faces[v1]) {
+            if (!face_alive[f])
+                continue;
+            int3& t = faces[f];
+            if (t.x == v1)
+                t.x = v0;
+            if (t.y == v1)
+                t.y = v0;
+            if (t.z == v1)
+                t.z = v0;
+            vert_faces[v0].push_back(f);
+        }
+        vert_faces[v1].clear();
+        vert_faces[v0].erase(std::remove_if(vert_faces[v0].begin(), vert_faces[v0].end(),
+                                            [&](size_t f) { return !face_alive[f]; }),
+                             vert_faces[v0].end());
+        pos[v0] = c.target;
+        quad[v0] += quad[v1];
+        on_boundary[v0] = on_boundary[v0] || on_boundary[v1];
+        vert_alive[v1] = 0;
+        stamp[v0]++;
+        stamp[v1]++;
+
+        std::set<int> ring;
+        for (size_t f : vert_faces[v0]) {
+            for (int v : {faces[f].x, faces[f].y, faces[f].z}) {
+                if (v != v0)
+                    ring.insert(v);
+            }
+        }
+        for (int v : ring)
+            evaluate(v0, v);
+    }
+
+    // Compact the mesh; per-facet data follow the remaining facets
+    std::vector<int> new_vid(nV, -1);
+    std::vector<float3> new_nodes;
+    for (size_t v = 0; v < nV; v++) {
+        if (vert_alive[v] &&
+            std::any_of(vert_faces[v].begin(), vert_faces[v].end(), [&](size_t f) { return face_alive[f]; })) {
+            new_vid[v] = (int)new_nodes.size();
+            new_nodes.push_back(pos[v]);
+        }
+    }
+    std::vector<int3> new_faces;
+    std::vector<size_t> kept;
+    new_faces.reserve(n_alive);
+    for (size_t f = 0; f < nF; f++) {
+        if (!face_alive[f])
+            continue;
+        int3 t;
+        t.x = new_vid[faces[f].x];
+        t.y = new_vid[faces[f].y];
+        t.z = new_vid[faces[f].z];
+        new_faces.push_back(t);
+        kept.push_back(f);
+    }
+    if (per_facet_mat) {
+        std::vector<std::shared_ptr<DEMMaterial>> new_mat(kept.size());
+        for (size_t i = 0; i < kept.size(); i++)
+            new_mat[i] = materials[kept[i]];
+        materials = std::move(new_mat);
+    }
+    for (auto& wc : geo_wildcards) {
+        if (wc.second.size() != nF)
+            continue;
+        std::vector<float> new_wc(kept.size());
+        for (size_t i = 0; i < kept.size(); i++)
+            new_wc[i] = wc.second[kept[i]];
+        wc.second = std::move(new_wc);
+    }
+
+    // Deviation: from the original nodes to the new surface, and from the new nodes to the original surface
+    if (!new_faces.empty()) {
+        MeshTriangleGrid new_grid(new_nodes, new_faces);
+        MeshTriangleGrid old_grid(m_vertices, m_face_v_indices);
+        for (size_t v = 0; v < nV; v++) {
+            if (!orig_vert_faces[v].empty())
+                report.max_deviation = std::max(report.max_deviation, new_grid.Distance(m_vertices[v]));
+        }
+        for (const auto& p : new_nodes)
+            report.max_deviation = std::max(report.max_deviation, old_grid.Distance(p));
+    }
+
+    m_vertices = std::move(new_nodes);
+    m_face_v_indices = std::move(new_faces);
+    m_normals.clear();
+    m_UV.clear();
+    m_colors.clear();
+    m_face_n_indices.clear();
+    m_face_uv_indices.clear();
+    m_face_col_indices.clear();
+    nTri = m_face_v_indices.size();
+    report.num_triangles = nTri;
+    report.num_removed = report.original_num_triangles - nTri;
+
+    // Coplanar patches, by flood fill across edges shared by facets of (nearly) the same normal as the seed facet,
+    // whose nodes are on the seed facet's plane
+    {
+        const double plane_tol = settings.max_deviation + 1e-6 * diag;
+        std::map<std::pair<int, int>, std::vector<size_t>> adj;
+        std::vector<float3> normals(nTri);
+        std::vector<float> areas(nTri);
+        for (size_t f = 0; f < nTri; f++) {
+            const int v[3] = {m_face_v_indices[f].x, m_face_v_indices[f].y, m_face_v_indices[f].z};
+            float3 n = facetNormal(m_vertices[v[0]], m_vertices[v[1]], m_vertices[v[2]]);
+            areas[f] = 0.5f * length(n);
+            normals[f] = (areas[f] > 0.f) ? normalize(n) : n;
+            for (int k = 0; k < 3; k++)
+                adj[std::minmax(v[k], v[(k + 1) % 3])].push_back(f);
+        }
+        std::vector<char> visited(nTri, 0);
+        for (size_t seed = 0; seed < nTri; seed++) {
+            if (visited[seed] || areas[seed] == 0.f)
+                continue;
+            std::vector<size_t> patch = {seed}, stack = {seed};
+            visited[seed] = 1;
+            while (!stack.empty()) {
+                size_t f = stack.back();
+                stack.pop_back();
+                const int v[3] = {m_face_v_indices[f].x, m_face_v_indices[f].y, m_face_v_indices[f].z};
+                for (int k = 0; k < 3; k++) {
+                    for (size_t g : adj[std::minmax(v[k], v[(k + 1) % 3])]) {
+                        if (visited[g] || areas[g] == 0.f || dot(normals[g], normals[seed]) < cos_coplanar)
+                            continue;
+                        const float3& seed_node = m_vertices[m_face_v_indices[seed].x];
+                        bool on_plane = true;
+                        for (int w : {m_face_v_indices[g].x, m_face_v_indices[g].y, m_face_v_indices[g].z}) {
+                            if (std::abs(dot(m_vertices[w] - seed_node, normals[seed])) > plane_tol)
+                                on_plane = false;
+                        }
+                        if (on_plane) {
+                            visited[g] = 1;
+                            patch.push_back(g);
+                            stack.push_back(g);
+                        }
+                    }
+                }
+            }
+            // Only patches bigger than a facet of the target size are worth reporting
+            double patch_area = 0.;
+            float3 n = make_float3(0.f);
+            for (size_t f : patch) {
+                patch_area += areas[f];
+                n += areas[f] * normals[f];
+            }
+            if (patch.size() < 2 || patch_area < settings.target_edge_length * settings.target_edge_length)
+                continue;
+            std::sort(patch.begin(), patch.end());
+            n = normalize(n);
+            // In-plane axes: x is perpendicular to n and to the global axis that n is least aligned with
+            float3 axis = host_make_float3(0, 0, 1);
+            if (std::abs(n.x) <= std::abs(n.y) && std::abs(n.x) <= std::abs(n.z))
+                axis = host_make_float3(1, 0, 0);
+            else if (std::abs(n.y) <= std::abs(n.z))
+                axis = host_make_float3(0, 1, 0);
+            float3 x_dir = normalize(cross(axis, n));
+            float3 y_dir = cross(n, x_dir);
+            float3 origin = m_vertices[m_face_v_indices[patch[0]].x];
+            float min_x = 0.f, max_x = 0.f, min_y = 0.f, max_y = 0.f;
+            double offset = 0.;
+            size_t n_pts = 0;
+            for (size_t f : patch) {
+                for (int v : {m_face_v_indices[f].x, m_face_v_indices[f].y, m_face_v_indices[f].z}) {
+                    float3 d = m_vertices[v] - origin;
+                    min_x = std::min(min_x, dot(d, x_dir));
+                    max_x = std::max(max_x, dot(d, x_dir));
+                    min_y = std::min(min_y, dot(d, y_dir));
+                    max_y = std::max(max_y, dot(d, y_dir));
+                    offset += dot(d, n);
+                    n_pts++;
+                }
+            }
+            DEMPlateParams_t plate;
+            plate.normal = n;
+            plate.center = origin + (0.5f * (min_x + max_x)) * x_dir + (0.5f * (min_y + max_y)) * y_dir +
+                           (float)(offset / n_pts) * n;
+            plate.h_dim_x = 0.5f * (max_x - min_x);
+            plate.h_dim_y = 0.5f * (max_y - min_y);
+            report.coplanar_patches.push_back(plate);
+            report.patch_facets.push_back(std::move(patch));
+        }
+    }
+    return report;
 }
 
 // Write the specified meshes in a Wavefront .obj file
@@ -59,6 +59,15 @@ inline std::string FORCE_INFO_WRITE_BACK_STRAT() {
     return read_file_to_string(sourcefile);
 }
 
+inline std::string FORCE_INFO_WRITE_BY_FAMILY_PAIR_STRAT() {
+    std::filesystem::path sourcefile =
+        RuntimeDataHelper::data_path / "kernel" / "DEMCustomizablePolicies" / "ContactInfoWriteByFamilyPair.cu";
+    if (!std::filesystem::exists(sourcefile)) {
+        DEME_ERROR("A strategy file %s is not found.", sourcefile.string().c_str());
+    }
+    return read_file_to_string(sourcefile);
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 // Clump template definition and acquisition strategy files
 ////////////////////////////////////////////////////////////////////////////////
@@ -366,17 +375,194 @@ inline void equip_contact_wildcards(std::string& acquisition,
                                     const std::set<std::string>& names) {
     unsigned int i = 0;
     for (const auto& name : names) {
-        // Rigth now, supports float arrays only...
+        // The force model sees floats; they may be kept in lower precision (see loadContactWildcard)
         // Getting it from global mem
-        acquisition += "float " + name + " = granData->contactWildcards[" + std::to_string(i) + "][myContactID];\n";
+        acquisition +=
+            "float " + name + " = loadContactWildcard(granData, " + std::to_string(i) + ", myContactID);\n";
         // Write it back to global mem
-        write_back += "granData->contactWildcards[" + std::to_string(i) + "][myContactID] = " + name + ";\n";
+        write_back += "storeContactWildcard(granData, " + std::to_string(i) + ", myContactID, " + name + ");\n";
         // Destroy it (set to 0) if it is a fake contact
         destroy_record += name + " = 0;\n";
         i++;
     }
 }
 
+// Analyze a force model, and produce the substitutions that make it into the force kernel. Both the solver and the
+// host-side force model harness use it, so that what the harness runs is exactly what dT runs.
+inline void equip_force_model(std::unordered_map<std::string, std::string>& strMap,
+                              std::unordered_map<std::string, bool> added_ingredients,
+                              std::string model,
+                              const std::set<std::string>& contact_wildcard_names,
+                              const std::set<std::string>& owner_wildcard_names,
+                              const std::set<std::string>& geo_wildcard_names,
+                              bool collect_force_in_force_kernel,
+                              bool record_contact_info,
+                              bool compact,
+                              std::unordered_map<std::string, unsigned int>& owner_wc_nums,
+                              std::unordered_map<std::string, unsigned int>& geo_wc_nums,
+                              std::unordered_map<std::string, unsigned int>& cnt_wc_nums,
+                              VERBOSITY verbosity) {
+    //// TODO: Reassemble geo and owner wildcards here again in a set is not needed... Since set is ordered.
+    std::set<std::string> added_owner_wildcards, added_geo_wildcards;
+    owner_wc_nums.clear();
+    geo_wc_nums.clear();
+    cnt_wc_nums.clear();
+    // If we spot that the force model requires an ingredient, we make sure that order goes to the ingredient
+    // acquisition module
+    std::string ingredient_definition = " ", cnt_wildcard_acquisition = " ", ingredient_acquisition_A = " ",
+                ingredient_acquisition_B = " ", owner_geo_wildcard_write_back = " ", cnt_wildcard_write_back = " ",
+                cnt_wildcard_destroy_record = " ", geo_wc_acquisition_B_sph = " ", geo_wc_acquisition_B_tri = " ",
+                geo_wc_acquisition_B_anal = " ";
+    scan_force_model_ingr(added_ingredients, model);
+    // As our numerical method stands now, AOwnerFamily and BOwnerFamily are always needed.
+    add_force_model_ingr(added_ingredients, "AOwnerFamily");
+    add_force_model_ingr(added_ingredients, "BOwnerFamily");
+    // If we collect force in force-calc kernel, these are needed...
+    if (collect_force_in_force_kernel) {
+        add_force_model_ingr(added_ingredients, "AOwner");
+        add_force_model_ingr(added_ingredients, "BOwner");
+        add_force_model_ingr(added_ingredients, "AOwnerMOI");
+        add_force_model_ingr(added_ingredients, "BOwnerMOI");
+    }
+    // Then, owner/geo wildcards should be added to the ingredient list too. But first we check whether a wildcard
+    // shares name with existing ingredients. If not, we add them to the list.
+    unsigned int owner_wc_num = 0, geo_wc_num = 0, cnt_wc_num = 0;
+    for (const auto& owner_wildcard_name : owner_wildcard_names) {
+        if (added_ingredients.find(owner_wildcard_name) != added_ingredients.end()) {
+            DEME_ERROR(
+                "Owner wildcard %s shares its name with a reserved contact force model ingredient.\nPlease select a "
+                "different name for this wildcard and try again.",
+                owner_wildcard_name.c_str());
+        }
+        added_owner_wildcards.insert(owner_wildcard_name);
+        // Finally, owner wildcards are subject to user modification, so it is better to keep tab of their numbering for
+        // later use.
+        owner_wc_nums[owner_wildcard_name] = owner_wc_num;
+        owner_wc_num++;
+    }
+    for (const auto& geo_wildcard_name : geo_wildcard_names) {
+        if (added_ingredients.find(geo_wildcard_name) != added_ingredients.end()) {
+            DEME_ERROR(
+                "Geometry wildcard %s shares its name with a reserved contact force model ingredient.\nPlease select a "
+                "different name for this wildcard and try again.",
+                geo_wildcard_name.c_str());
+        }
+        added_geo_wildcards.insert(geo_wildcard_name);
+        // Finally, owner wildcards are subject to user modification, so it is better to keep tab of their numbering for
+        // later use.
+        geo_wc_nums[geo_wildcard_name] = geo_wc_num;
+        geo_wc_num++;
+    }
+    for (const auto& contact_wildcard_name : contact_wildcard_names) {
+        if (added_ingredients.find(contact_wildcard_name) != added_ingredients.end()) {
+            DEME_ERROR(
+                "Contact wildcard %s shares its name with a reserved contact force model ingredient.\nPlease select a "
+                "different name for this wildcard and try again.",
+                contact_wildcard_name.c_str());
+        }
+        cnt_wc_nums[contact_wildcard_name] = cnt_wc_num;
+        cnt_wc_num++;
+    }
+
+    // Owner write-back needs ABOwner number
+    if (owner_wildcard_names.size() > 0) {
+        add_force_model_ingr(added_ingredients, "AOwner");
+        add_force_model_ingr(added_ingredients, "BOwner");
+    }
+    // Geo wildcard write-back needs ABGeo number
+    if (geo_wildcard_names.size() > 0) {
+        add_force_model_ingr(added_ingredients, "AGeo");
+        add_force_model_ingr(added_ingredients, "BGeo");
+    }
+
+    // Equip those acquisition strategies that need to be there
+    equip_force_model_ingr_acq(ingredient_definition, ingredient_acquisition_A, ingredient_acquisition_B,
+                               added_ingredients);
+    // Then equip acquisition strategies for owner wildcards
+    equip_owner_wildcards(ingredient_definition, ingredient_acquisition_A, ingredient_acquisition_B,
+                          owner_geo_wildcard_write_back, added_owner_wildcards);
+    // Then equip acquisition strategies for geo wildcards.
+    // geo_wc_acquisition_B_sph, geo_wc_acquisition_B_tri, geo_wc_acquisition_B_anal cannot be incorporated into
+    // ingredient_acquisition_B, since they are different for the 3 cases...
+    equip_geo_wildcards(ingredient_definition, ingredient_acquisition_A, geo_wc_acquisition_B_sph,
+                        geo_wc_acquisition_B_tri, geo_wc_acquisition_B_anal, added_geo_wildcards);
+    // Currently, owner_wildcard_write_back and geo_wildcard_write_back might be blank, since give the write-back
+    // control to the user, and they may need to use atomic operations (atomicExch or atomicAdd) to update the
+    // wildcards.
+
+    // Acq strategies may have moi acq strategy in them that needs to be replaced first...
+    ingredient_acquisition_A = replace_patterns(ingredient_acquisition_A, strMap);
+    ingredient_acquisition_B = replace_patterns(ingredient_acquisition_B, strMap);
+
+    // Check if force, and wildcards are all defined in the model
+    std::string non_match;
+    if (!all_whole_word_match(model, contact_wildcard_names, non_match))
+        DEME_WARNING(
+            "Contact wildcard(s) %s are not used/set in your custom force model. "
+            "Your force model will probably not produce what you expect.",
+            non_match.c_str());
+    if (!all_whole_word_match(model, owner_wildcard_names, non_match))
+        DEME_WARNING(
+            "Owner wildcard(s) %s are not used/set in your custom force model. "
+            "Your force model will probably not produce what you expect.",
+            non_match.c_str());
+    if (!all_whole_word_match(model, geo_wildcard_names, non_match))
+        DEME_WARNING(
+            "Geometry wildcard(s) %s are not used/set in your custom force model. "
+            "Your force model will probably not produce what you expect.",
+            non_match.c_str());
+    if (!all_whole_word_match(model, {"force"}, non_match)) {
+        DEME_WARNING(
+            "Your custom force model does not set the %s variable at all. "
+            "You probably will not see any contact in the simulation.",
+            non_match.c_str());
+    }
+
+    // For contact wildcards, it needs to be brought from the global memory, and we expect the user's force model to use
+    // and modify them, and in the end we will write them back to global mem.
+    equip_contact_wildcards(cnt_wildcard_acquisition, cnt_wildcard_write_back, cnt_wildcard_destroy_record,
+                            contact_wildcard_names);
+
+    // If the user wants to reduce force in the calculation kernel...
+    std::string whether_reduce_in_kernel = " ";
+    if (collect_force_in_force_kernel) {
+        whether_reduce_in_kernel = FORCE_REDUCTION_RIGHT_AFTER_CALC_STRAT();
+    }
+
+    // If the user doesn't want to keep tab of contact forces...
+    std::string contact_info_write_strat = " ";
+    if (record_contact_info) {
+        contact_info_write_strat = FORCE_INFO_WRITE_BACK_STRAT();
+    }
+
+    if (compact) {
+        model = compact_code(model);
+        ingredient_definition = compact_code(ingredient_definition);
+        ingredient_acquisition_A = compact_code(ingredient_acquisition_A);
+        ingredient_acquisition_B = compact_code(ingredient_acquisition_B);
+        whether_reduce_in_kernel = compact_code(whether_reduce_in_kernel);
+        contact_info_write_strat = compact_code(contact_info_write_strat);
+    }
+    strMap["_DEMForceModel_"] = model;
+    strMap["_forceModelIngredientDefinition_"] = ingredient_definition;
+    strMap["_forceModelIngredientAcqForA_"] = ingredient_acquisition_A;
+    strMap["_forceModelIngredientAcqForB_"] = ingredient_acquisition_B;
+    // Geo wildcard acquisition is contact type-dependent.
+    strMap["_forceModelGeoWildcardAcqForSph_"] = geo_wc_acquisition_B_sph;
+    strMap["_forceModelGeoWildcardAcqForTri_"] = geo_wc_acquisition_B_tri;
+    strMap["_forceModelGeoWildcardAcqForAnal_"] = geo_wc_acquisition_B_anal;
+
+    // This should be empty as of now...
+    strMap["_forceModelOwnerWildcardWrite_"] = owner_geo_wildcard_write_back;
+
+    strMap["_forceModelContactWildcardAcq_"] = cnt_wildcard_acquisition;
+    strMap["_forceModelContactWildcardWrite_"] = cnt_wildcard_write_back;
+    strMap["_forceModelContactWildcardDestroy_"] = cnt_wildcard_destroy_record;
+
+    strMap["_forceCollectInPlaceStrat_"] = whether_reduce_in_kernel;
+    strMap["_contactInfoWrite_"] = contact_info_write_strat;
+}
+
 }  // namespace deme
 
 #endif
@@ -12,18 +12,23 @@
 #include <core/utils/csv.hpp>
 #include <core/utils/GpuError.h>
 #include <core/utils/Timer.hpp>
+#include <core/utils/Profiler.hpp>
+#include <core/utils/MetricsSink.hpp>
 #include <core/utils/RuntimeData.h>
 
 #include <sstream>
 #include <exception>
+#include <stdexcept>
 #include <atomic>
 #include <condition_variable>
+#include <map>
 #include <mutex>
 #include <unordered_map>
 #include <nvmath/helper_math.cuh>
 #include <DEM/HostSideHelpers.hpp>
 #include <filesystem>
 #include <cstring>
+#include <cstddef>
 #include <cassert>
 
 namespace deme {
@@ -100,6 +105,166 @@ const std::unordered_map<std::string, bool> force_kernel_ingredient_stats = {
 // NOTE: Data structs here need to be those complex ones (such as needing to include ManagedAllocator.hpp), which may
 // not be jitifiable.
 
+/// One named array (or a group of arrays sharing a name) that a worker thread holds.
+struct MemoryRecord {
+    std::string name;
+    // Which thread holds it ("kT" or "dT")
+    std::string owner;
+    // Whether it is a cudaMalloc-ed device buffer (otherwise it is managed memory)
+    bool onDevice = false;
+    size_t bytes = 0;
+    size_t peakBytes = 0;
+};
+
+/// A structured breakdown of the memory the solver uses, as returned by DEMSolver::GetMemoryReport. It can also be a
+/// prediction (DEMSolver::PredictMemoryUsage), in which case all peaks equal the sizes.
+struct MemoryReport {
+    std::vector<MemoryRecord> records;
+    // Sums over the records
+    size_t kTBytes = 0;
+    size_t dTBytes = 0;
+    size_t managedBytes = 0;
+    size_t deviceBytes = 0;
+    size_t totalBytes = 0;
+    // Sum of the per-record peaks (an upper bound of the actual combined peak)
+    size_t peakBytes = 0;
+    // What the memory pools hold on top of what the records account for is the cached part of the pool stats
+    MemoryPoolStats managedPool;
+    MemoryPoolStats devicePool;
+    // Free and total device memory at the time of the report (0 if not queried)
+    size_t deviceFreeBytes = 0;
+    size_t deviceTotalBytes = 0;
+
+    void addRecord(const MemoryRecord& rec) {
+        records.push_back(rec);
+        if (rec.owner == "kT")
+            kTBytes += rec.bytes;
+        else
+            dTBytes += rec.bytes;
+        if (rec.onDevice)
+            deviceBytes += rec.bytes;
+        else
+            managedBytes += rec.bytes;
+        totalBytes += rec.bytes;
+        peakBytes += rec.peakBytes;
+    }
+};
+
+/// Each worker thread owns a MemoryRegistry where all its managed arrays, device buffers, scratch space and temp arrays
+/// register their sizes, by name. It is what estimateMemUsage and DEMSolver::GetMemoryReport read from.
+class MemoryRegistry {
+  public:
+    explicit MemoryRegistry(const std::string& owner) : m_owner(owner) {}
+    MemoryRegistry(const MemoryRegistry&) = delete;
+    MemoryRegistry& operator=(const MemoryRegistry&) = delete;
+
+    /// Record that the array `name' now takes `bytes' bytes.
+    void Set(const std::string& name, size_t bytes, bool on_device = false) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        MemoryRecord& rec = getRecord_impl(name, on_device);
+        rec.bytes = bytes;
+        rec.peakBytes = DEME_MAX(rec.peakBytes, rec.bytes);
+    }
+
+    /// Record that the array (or array group) `name' changed its size by `byte_delta' bytes.
+    void Adjust(const std::string& name, long long byte_delta, bool on_device = false) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        MemoryRecord& rec = getRecord_impl(name, on_device);
+        rec.bytes = (byte_delta < 0 && (size_t)(-byte_delta) > rec.bytes) ? 0 : rec.bytes + byte_delta;
+        rec.peakBytes = DEME_MAX(rec.peakBytes, rec.bytes);
+    }
+
+    size_t GetTotalBytes() const {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        size_t total = 0;
+        for (const auto& rec : m_records)
+            total += rec.second.bytes;
+        return total;
+    }
+
+    std::vector<MemoryRecord> GetRecords() const {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        std::vector<MemoryRecord> res;
+        res.reserve(m_records.size());
+        for (const auto& rec : m_records)
+            res.push_back(rec.second);
+        return res;
+    }
+
+    /// Forget the peaks, so they are measured from now on.
+    void ResetPeaks() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (auto& rec : m_records)
+            rec.second.peakBytes = rec.second.bytes;
+    }
+
+  private:
+    const std::string m_owner;
+    std::map<std::string, MemoryRecord> m_records;
+    mutable std::mutex m_mutex;
+
+    MemoryRecord& getRecord_impl(const std::string& name, bool on_device) {
+        auto it = m_records.find(name);
+        if (it == m_records.end()) {
+            MemoryRecord rec;
+            rec.name = name;
+            rec.owner = m_owner;
+            rec.onDevice = on_device;
+            it = m_records.emplace(name, rec).first;
+        }
+        return it->second;
+    }
+};
+
+// While this is set, the tracked resize/reserve macros and the tracked device buffer allocation on the calling thread
+// do not touch any array: they record in this registry the bytes that a fresh allocation of that size would take. This
+// is how the memory prediction runs the very sizing code the worker threads allocate with. It is thread-local, so the
+// worker threads are never affected.
+inline thread_local MemoryRegistry* memSizingRegistry = nullptr;
+
+/// Set memSizingRegistry for as long as this object lives.
+class MemorySizingScope {
+  public:
+    explicit MemorySizingScope(MemoryRegistry& registry) : m_prev(memSizingRegistry) { memSizingRegistry = &registry; }
+    ~MemorySizingScope() { memSizingRegistry = m_prev; }
+    MemorySizingScope(const MemorySizingScope&) = delete;
+    MemorySizingScope& operator=(const MemorySizingScope&) = delete;
+
+  private:
+    MemoryRegistry* m_prev;
+};
+
+/// The numbers of entities that the managed arrays of kT and dT are sized by.
+struct ManagedArraySizes {
+    size_t nOwnerBodies = 0;
+    size_t nSpheresGM = 0;
+    size_t nTriGM = 0;
+    size_t nAnalGM = 0;
+    size_t nMassProperties = 0;
+    size_t nClumpComponents = 0;
+    // Length of the contact arrays
+    size_t nContacts = 0;
+    // Length of the per-contact force record arrays (contactForces etc.). It is nContacts unless a force record policy
+    // keeps only the contacts recorded in full in them.
+    size_t nFullRecordContacts = 0;
+    unsigned int nContactWildcards = 0;
+    unsigned int nOwnerWildcards = 0;
+    unsigned int nGeoWildcards = 0;
+
+    // The solver settings that decide which arrays exist. kT and dT copy them from their own solverFlags; a memory
+    // prediction derives them from the solver's settings, without transferring anything to kT and dT.
+    bool isHistoryless = false;
+    bool useVerletSkin = false;
+    bool canFamilyChange = false;
+    bool useClumpJitify = false;
+    bool useMassJitify = false;
+    bool useOwnerCntAggregates = false;
+    bool useNoContactRecord = false;
+    bool useForceRecordPolicy = false;
+    bool useCompactContactStorage = false;
+    bool useBF16ContactWildcards = false;
+};
+
 /// <summary>
 /// DEMSolverStateData contains information that pertains the DEM solver worker threads, at a certain point in time. It
 /// also contains space allocated as system scratch pad and as thread temporary arrays.
@@ -107,18 +272,45 @@ const std::unordered_map<std::string, bool> force_kernel_ingredient_stats = {
 class DEMSolverStateData {
   private:
     const unsigned int numTempArrays;
-    // The vector used by CUB or by anybody else that needs scratch space.
-    // Please pay attention to the type the vector stores.
-    std::vector<scratch_t, ManagedAllocator<scratch_t>> cubScratchSpace;
+    // The space used by CUB or by anybody else that needs scratch space.
+    // Please pay attention to the type it stores.
+    scratch_t* cubScratchSpace = nullptr;
+    size_t cubScratchBytes = 0;
 
-    // The vectors used by threads when they need temporary arrays (very typically, for storing arrays outputted by cub
+    // The arrays used by threads when they need temporary arrays (very typically, for storing arrays outputted by cub
     // scan or reduce operations).
-    std::vector<std::vector<scratch_t, ManagedAllocator<scratch_t>>,
-                ManagedAllocator<std::vector<scratch_t, ManagedAllocator<scratch_t>>>>
-        threadTempVectors;
+    std::vector<scratch_t*> threadTempVectors;
+    std::vector<size_t> threadTempBytes;
     // You can keep more temp arrays if you construct this class with a different initializer
 
+    // Make sure buf is at least sizeNeeded bytes. If it has to grow and keep_content is set, the old content is copied
+    // over: temp arrays may be asked for again (with a larger size) while their content is still in use.
+    inline scratch_t* growBuffer(scratch_t*& buf,
+                                 size_t& capacity,
+                                 size_t sizeNeeded,
+                                 const char* name,
+                                 bool keep_content) {
+        if (capacity < sizeNeeded) {
+            size_t new_capacity = DEME_MAX(sizeNeeded, (size_t)(DEME_BUFFER_GROWTH_FACTOR * capacity));
+            // Take whatever rounding slack the pool gives us anyway
+            new_capacity = MemoryPool<CudaManagedBackend>::SizeClassOf(new_capacity);
+            scratch_t* new_buf = (scratch_t*)ManagedMemoryPool().Allocate(new_capacity);
+            if (buf && keep_content) {
+                DEME_GPU_CALL(cudaMemcpy(new_buf, buf, capacity, cudaMemcpyDefault));
+            }
+            ManagedMemoryPool().Deallocate(buf);
+            buf = new_buf;
+            capacity = new_capacity;
+            if (memRegistry)
+                memRegistry->Set(name, capacity);
+        }
+        return buf;
+    }
+
   public:
+    // Where the scratch space and temp arrays report their sizes; set by the owner thread, can be null
+    MemoryRegistry* memRegistry = nullptr;
+
     // Temp size_t variables that can be reused
     size_t* pTempSizeVar1;
     size_t* pTempSizeVar2;
@@ -141,7 +333,8 @@ class DEMSolverStateData {
         *pNumContacts = 0;
         *pNumPrevContacts = 0;
         *pNumPrevSpheres = 0;
-        threadTempVectors.resize(numTempArrays);
+        threadTempVectors.resize(numTempArrays, nullptr);
+        threadTempBytes.resize(numTempArrays, 0);
     }
     ~DEMSolverStateData() {
         DEME_GPU_CALL(cudaFree(pNumContacts));
@@ -151,26 +344,31 @@ class DEMSolverStateData {
         DEME_GPU_CALL(cudaFree(pNumPrevContacts));
         DEME_GPU_CALL(cudaFree(pNumPrevSpheres));
 
-        cubScratchSpace.clear();
+        ManagedMemoryPool().Deallocate(cubScratchSpace);
         for (unsigned int i = 0; i < numTempArrays; i++) {
-            threadTempVectors.at(i).clear();
+            ManagedMemoryPool().Deallocate(threadTempVectors.at(i));
         }
         threadTempVectors.clear();
+        threadTempBytes.clear();
     }
 
-    // Return raw pointer to swath of device memory that is at least "sizeNeeded" large
+    // Return raw pointer to swath of device memory that is at least "sizeNeeded" large. CUB does not expect anything
+    // in its scratch space, so it is not copied over when it grows.
     inline scratch_t* allocateScratchSpace(size_t sizeNeeded) {
-        if (cubScratchSpace.size() < sizeNeeded) {
-            cubScratchSpace.resize(sizeNeeded);
-        }
-        return cubScratchSpace.data();
+        return growBuffer(cubScratchSpace, cubScratchBytes, sizeNeeded, "cubScratchSpace", false);
     }
 
     inline scratch_t* allocateTempVector(unsigned int i, size_t sizeNeeded) {
-        if (threadTempVectors.at(i).size() < sizeNeeded) {
-            threadTempVectors.at(i).resize(sizeNeeded);
-        }
-        return threadTempVectors.at(i).data();
+        return growBuffer(threadTempVectors.at(i), threadTempBytes.at(i), sizeNeeded,
+                          ("threadTempVectors[" + std::to_string(i) + "]").c_str(), true);
+    }
+
+    // Total bytes held as scratch space and temp arrays
+    inline size_t getScratchBytes() const {
+        size_t total = cubScratchBytes;
+        for (const auto bytes : threadTempBytes)
+            total += bytes;
+        return total;
     }
 };
 
@@ -191,14 +389,49 @@ struct kTStateParams {
     float binChangeLowerSafety = 0.3;
 
     // The max num of geometries in a bin that appeared in the CD process
-    size_t maxSphFoundInBin;
-    size_t maxTriFoundInBin;
+    size_t maxSphFoundInBin = 0;
+    size_t maxTriFoundInBin = 0;
 
-    // Num of bins, currently
+    // Num of bins, currently (of all levels, with hierarchical binning)
     size_t numBins = 0;
 
+    // Largest sphere radius in the clump templates, which decides how many levels of bins hierarchical binning needs
+    double maxSphereRadius = 0.;
+
     // Current average num of contacts per sphere has.
     float avgCntsPerSphere = 0.;
+
+    // Num of spheres re-binned in the last CD step (all of them, unless incremental binning could be used)
+    size_t numSpheresRebinned = 0;
+};
+
+// What kT keeps from the last sphere binning, so that with incremental binning, the next CD step re-bins only those
+// spheres that now touch a different range of bins
+struct SphereBinningRecord {
+    // The IDs of the lowest and the highest bins each sphere touched
+    std::vector<binID_t, ManagedAllocator<binID_t>> sphereBinLo;
+    std::vector<binID_t, ManagedAllocator<binID_t>> sphereBinHi;
+    // All bin--sphere touching pairs, sorted by bin ID then sphere ID
+    std::vector<binID_t, ManagedAllocator<binID_t>> binIDs;
+    std::vector<bodyID_t, ManagedAllocator<bodyID_t>> sphereIDs;
+    // The bin size the record is made with. If it changed, the record is of no use.
+    double binSize = 0.;
+    bool valid = false;
+};
+
+// A host copy of the analytical entities' definitions, which on the device exist only as jitified arrays. Contact
+// detection on host threads reads them from here.
+struct HostAnalyticalEntities {
+    // Owner IDs, in the global owner numbering
+    std::vector<bodyID_t> owner;
+    std::vector<objType_t> type;
+    // Locations relative to the owner's CoM, and the representative directions (such as plane normals)
+    std::vector<float3> relPos;
+    std::vector<float3> rot;
+    std::vector<float> size1;
+    std::vector<float> size2;
+    std::vector<float> size3;
+    std::vector<float> normal;
 };
 
 inline std::string pretty_format_bytes(size_t bytes) {
@@ -237,6 +470,8 @@ enum class MESH_FORMAT { VTK, OBJ };
 // Adaptive time step size methods
 enum class ADAPT_TS_TYPE { NONE, MAX_VEL, INT_DIFF };
 
+enum class CNT_STORAGE_POLICY { FULL, COMPACT };
+
 // =============================================================================
 // NOW DEFINING MACRO COMMANDS USED BY THE DEM MODULE
 // =============================================================================
@@ -338,58 +573,108 @@ enum class ADAPT_TS_TYPE { NONE, MAX_VEL, INT_DIFF };
             "-diag-suppress=550", "-diag-suppress=177"                                            \
     }
 
+// Make sure vec can hold newsize elements without re-allocating. When it has to re-allocate, it grows to at least
+// DEME_BUFFER_GROWTH_FACTOR times its old capacity, so arrays that keep getting a bit longer (say, clumps poured in
+// batch by batch) are re-allocated and copied only a logarithmic number of times. A first allocation is exact.
+template <typename Vec>
+inline void reserveGeometric(Vec& vec, size_t newsize) {
+    size_t cap = vec.capacity();
+    if (newsize > cap) {
+        vec.reserve(DEME_MAX(newsize, (size_t)(DEME_BUFFER_GROWTH_FACTOR * cap)));
+    }
+}
+
+// Reserve capacity for n elements up front (without changing the size), and register what the allocator now holds. A
+// memory prediction is for the sizes it is given, so it ignores the reserved capacity (see memSizingRegistry).
+#define DEME_TRACKED_RESERVE(vec, n, name)                                             \
+    {                                                                                  \
+        if (!memSizingRegistry && (size_t)(n) > vec.capacity()) {                      \
+            vec.reserve(n);                                                            \
+            memRegistry.Set(name, sizeof(decltype(vec)::value_type) * vec.capacity()); \
+        }                                                                              \
+    }
+
 // I wasn't able to resolve a decltype problem with vector of vectors, so I have to create another macro for this kind
-// of tracked resize... not ideal.
-#define DEME_TRACKED_RESIZE_FLOAT(vec, newsize, val)               \
-    {                                                              \
-        size_t old_size = vec.size();                              \
-        vec.resize(newsize, val);                                  \
-        size_t new_size = vec.size();                              \
-        size_t byte_delta = sizeof(float) * (new_size - old_size); \
-        m_approx_bytes_used += byte_delta;                         \
-    }
-
-#define DEME_TRACKED_RESIZE(vec, newsize, val)                 \
-    {                                                          \
-        size_t item_size = sizeof(decltype(vec)::value_type);  \
-        size_t old_size = vec.size();                          \
-        vec.resize(newsize, val);                              \
-        size_t new_size = vec.size();                          \
-        size_t byte_delta = item_size * (new_size - old_size); \
-        m_approx_bytes_used += byte_delta;                     \
-    }
-
-#define DEME_TRACKED_RESIZE_DEBUGPRINT(vec, newsize, name, val)                                                      \
-    {                                                                                                                \
-        size_t item_size = sizeof(decltype(vec)::value_type);                                                        \
-        size_t old_size = vec.size();                                                                                \
-        vec.resize(newsize, val);                                                                                    \
-        size_t new_size = vec.size();                                                                                \
-        size_t byte_delta = item_size * (new_size - old_size);                                                       \
-        m_approx_bytes_used += byte_delta;                                                                           \
-        DEME_DEBUG_PRINTF("Resizing vector %s, old size %zu, new size %zu, byte delta %s", name, old_size, new_size, \
-                          pretty_format_bytes(byte_delta).c_str());                                                  \
-    }
-
-//// TODO: this is currently not tracked...
+// of tracked resize... not ideal. Sizes are registered by capacity, since that is what the allocator actually holds.
+#define DEME_TRACKED_RESIZE_FLOAT(vec, newsize, val)                                                        \
+    {                                                                                                       \
+        if (memSizingRegistry) {                                                                            \
+            memSizingRegistry->Adjust(#vec, (long long)(sizeof(float) * (size_t)(newsize)));                \
+        } else {                                                                                            \
+            size_t old_cap = vec.capacity();                                                                \
+            reserveGeometric(vec, newsize);                                                                 \
+            vec.resize(newsize, val);                                                                       \
+            size_t new_cap = vec.capacity();                                                                \
+            memRegistry.Adjust(#vec, (long long)sizeof(float) * ((long long)new_cap - (long long)old_cap)); \
+        }                                                                                                   \
+    }
+
+#define DEME_TRACKED_RESIZE(vec, newsize, val)                           \
+    {                                                                    \
+        size_t item_size = sizeof(decltype(vec)::value_type);            \
+        if (memSizingRegistry) {                                         \
+            memSizingRegistry->Set(#vec, item_size * (size_t)(newsize)); \
+        } else {                                                         \
+            reserveGeometric(vec, newsize);                              \
+            vec.resize(newsize, val);                                    \
+            memRegistry.Set(#vec, item_size * vec.capacity());           \
+        }                                                                \
+    }
+
+#define DEME_TRACKED_RESIZE_DEBUGPRINT(vec, newsize, name, val)                                                \
+    {                                                                                                          \
+        size_t item_size = sizeof(decltype(vec)::value_type);                                                  \
+        if (memSizingRegistry) {                                                                               \
+            memSizingRegistry->Set(name, item_size * (size_t)(newsize));                                       \
+        } else {                                                                                               \
+            size_t old_size = vec.size();                                                                      \
+            reserveGeometric(vec, newsize);                                                                    \
+            vec.resize(newsize, val);                                                                          \
+            size_t new_size = vec.size();                                                                      \
+            memRegistry.Set(name, item_size * vec.capacity());                                                 \
+            DEME_DEBUG_PRINTF("Resizing vector %s, old size %zu, new size %zu, byte delta %s", name, old_size, \
+                              new_size, pretty_format_bytes(item_size * (new_size - old_size)).c_str());       \
+        }                                                                                                      \
+    }
+
+// Device buffers are served by the device memory pool of the current device, so re-allocating them after a size change
+// usually just swaps blocks in the pool instead of doing cudaFree + cudaMalloc (both synchronize the device).
+template <typename T>
+inline void DEME_DEVICE_PTR_DEALLOC(T*& ptr) {
+    if (!ptr)
+        return;
+    if (!DeviceMemoryPoolsRelease(ptr)) {
+        // Not from the pools; then it is either cudaMalloc-ed elsewhere or garbage
+        cudaPointerAttributes attrib;
+        DEME_GPU_CALL(cudaPointerGetAttributes(&attrib, ptr));
+        if (attrib.type != cudaMemoryType::cudaMemoryTypeUnregistered)
+            DEME_GPU_CALL(cudaFree(ptr));
+    }
+    ptr = nullptr;
+}
+
 // ptr being a reference to a pointer is crucial
 template <typename T>
 inline void DEME_DEVICE_PTR_ALLOC(T*& ptr, size_t size) {
-    cudaPointerAttributes attrib;
-    DEME_GPU_CALL(cudaPointerGetAttributes(&attrib, ptr));
-
-    if (attrib.type != cudaMemoryType::cudaMemoryTypeUnregistered)
-        DEME_GPU_CALL(cudaFree(ptr));
-    DEME_GPU_CALL(cudaMalloc((void**)&ptr, size * sizeof(T)));
+    DEME_DEVICE_PTR_DEALLOC(ptr);
+    ptr = (T*)DeviceMemoryPool().Allocate(size * sizeof(T));
 }
 
+// The same as above, but the buffer is registered under this name, so it shows up in the memory report
 template <typename T>
-inline void DEME_DEVICE_PTR_DEALLOC(T*& ptr) {
-    cudaPointerAttributes attrib;
-    DEME_GPU_CALL(cudaPointerGetAttributes(&attrib, ptr));
-
-    if (attrib.type != cudaMemoryType::cudaMemoryTypeUnregistered)
-        DEME_GPU_CALL(cudaFree(ptr));
+inline void DEME_DEVICE_PTR_DEALLOC(T*& ptr, MemoryRegistry& registry, const char* name) {
+    DEME_DEVICE_PTR_DEALLOC(ptr);
+    registry.Set(name, 0, true);
+}
+// While sizing (see memSizingRegistry), only the size is recorded
+template <typename T>
+inline void DEME_DEVICE_PTR_ALLOC(T*& ptr, size_t size, MemoryRegistry& registry, const char* name) {
+    if (memSizingRegistry) {
+        memSizingRegistry->Set(name, size * sizeof(T), true);
+        return;
+    }
+    DEME_DEVICE_PTR_ALLOC(ptr, size);
+    registry.Set(name, size * sizeof(T), true);
 }
 
 // Managed advise doesn't seem to do anything...
@@ -419,20 +704,159 @@ class WorkerAnomalies {
 };
 
 // Timers used by kT and dT
+// IDs of kT's timers. The first NUM_KT_TIMERS are the ones reported in timing stats; the rest are finer-grained scopes
+// nested in them, which only show up in the profiler trace. The order matches the names kT registers.
+enum KT_TIMER : unsigned int {
+    KT_DISCRETIZE_DOMAIN = 0,
+    KT_FIND_CONTACT_PAIRS,
+    KT_BUILD_HISTORY_MAP,
+    KT_UNPACK_FROM_DT,
+    KT_SEND_TO_DT,
+    KT_WAIT_FOR_DT,
+    NUM_KT_TIMERS,
+    KT_BIN_SPHERES = NUM_KT_TIMERS,
+    KT_SORT_BIN_SPHERE_PAIRS,
+    KT_BIN_TRIANGLES,
+    KT_SORT_CONTACTS_BY_OWNER,
+    KT_PERSISTENT_CONTACT_MAP,
+    KT_SORT_CONTACTS_BY_TYPE,
+    NUM_KT_SCOPES
+};
+
+// IDs of dT's timers, the same arrangement as kT's
+enum DT_TIMER : unsigned int {
+    DT_CLEAR_FORCE_ARRAY = 0,
+    DT_CALC_CONTACT_FORCES,
+    DT_COLLECT_CONTACT_FORCES,
+    DT_INTEGRATION,
+    DT_UNPACK_FROM_KT,
+    DT_SEND_TO_KT,
+    DT_WAIT_FOR_KT,
+    NUM_DT_TIMERS,
+    DT_ROUTINE_CHECKS = NUM_DT_TIMERS,
+    DT_CALIBRATE_PARAMS,
+    NUM_DT_SCOPES
+};
+
+/// Timers of a worker thread, looked up by integer ID in the hot loop. Each timer accumulates its total time, and if
+/// profiling is enabled, each start--stop pair is also recorded as a scope in the thread's Profiler.
 class SolverTimers {
   private:
+    // Names of all scopes; only the first num_timers are reported in timing stats
+    const std::vector<std::string> m_names;
     const unsigned int num_timers;
-    std::unordered_map<std::string, Timer<double>> m_timers;
+    std::vector<Timer<double>> m_timers;
+    Profiler m_profiler;
+
+    static std::vector<std::string> joinNames(const std::vector<std::string>& a, const std::vector<std::string>& b) {
+        std::vector<std::string> res = a;
+        res.insert(res.end(), b.begin(), b.end());
+        return res;
+    }
 
   public:
-    SolverTimers(const std::vector<std::string>& names) : num_timers(names.size()) {
-        for (unsigned int i = 0; i < num_timers; i++) {
-            m_timers[names.at(i)] = Timer<double>();
+    SolverTimers(const std::string& thread_name,
+                 const std::vector<std::string>& timer_names,
+                 const std::vector<std::string>& scope_names = {})
+        : m_names(joinNames(timer_names, scope_names)),
+          num_timers(timer_names.size()),
+          m_timers(m_names.size()),
+          m_profiler(thread_name, m_names) {}
+
+    inline void Start(unsigned int id) {
+        m_timers[id].start();
+        m_profiler.Begin(id);
+    }
+    inline void Stop(unsigned int id) {
+        m_timers[id].stop();
+        m_profiler.End(id);
+    }
+
+    Timer<double>& GetTimer(unsigned int id) { return m_timers.at(id); }
+    Timer<double>& GetTimer(const std::string& name) {
+        for (unsigned int i = 0; i < m_names.size(); i++) {
+            if (m_names[i] == name)
+                return m_timers[i];
         }
+        throw std::out_of_range("No timer named " + name);
+    }
+
+    /// Names and accumulated times (in seconds) of the reported timers
+    void GetTiming(std::vector<std::string>& names, std::vector<double>& vals) const {
+        names.assign(m_names.begin(), m_names.begin() + num_timers);
+        vals.clear();
+        for (unsigned int i = 0; i < num_timers; i++)
+            vals.push_back(m_timers[i].GetTimeSeconds());
+    }
+
+    void Reset() {
+        for (auto& timer : m_timers)
+            timer.reset();
     }
-    Timer<double>& GetTimer(const std::string& name) { return m_timers.at(name); }
+
+    Profiler& GetProfiler() { return m_profiler; }
+    const Profiler& GetProfiler() const { return m_profiler; }
 };
 
+/// One sample of the solver's runtime metrics, as recorded by the metrics stream (see DEMSolver::EnableMetrics). A
+/// sample is taken each time dT receives a kT update, and, optionally, every N dT steps in between; the kT-side
+/// quantities of an in-between sample are those of the latest kT update.
+struct SolverMetrics {
+    // The 8-byte fields come first and the 4-byte ones last, so the record has no padding
+    // Simulation time and dT's step count (since the last time the collaboration stats were cleared)
+    double time = 0;
+    uint64_t step = 0;
+    // Number of contacts in the contact array that dT currently uses
+    uint64_t nContacts = 0;
+    double binSize = 0;
+    uint64_t numBins = 0;
+    uint64_t maxSphFoundInBin = 0;
+    uint64_t maxTriFoundInBin = 0;
+    // How many steps stale the latest kT update was when dT received it
+    int64_t kTLagSteps = 0;
+    // Time dT spent waiting for kT since the previous sample, in seconds
+    double dTWaitSeconds = 0;
+    // Number of sleeping owners (0 unless sleeping is enabled)
+    uint64_t nSleepingOwners = 0;
+    // 1 if taken at a kT update, 0 if it is an every-N-steps dT sample
+    uint32_t isKTUpdate = 0;
+    float avgCntsPerSphere = 0;
+    // Max velocity kT derived the contact margin from
+    float maxVel = 0;
+    // The future drift dT currently aims for, and its upper bound
+    uint32_t currentDrift = 0;
+    uint32_t maxDrift = 0;
+    // The time step size dT uses
+    float stepSize = 0;
+
+    // The fields in CSV column order
+    static std::vector<MetricsField> GetFields() {
+        return {MakeMetricsField<double>("time", offsetof(SolverMetrics, time)),
+                MakeMetricsField<uint64_t>("step", offsetof(SolverMetrics, step)),
+                MakeMetricsField<uint32_t>("is_kT_update", offsetof(SolverMetrics, isKTUpdate)),
+                MakeMetricsField<uint64_t>("num_contacts", offsetof(SolverMetrics, nContacts)),
+                MakeMetricsField<float>("avg_cnts_per_sphere", offsetof(SolverMetrics, avgCntsPerSphere)),
+                MakeMetricsField<float>("max_vel", offsetof(SolverMetrics, maxVel)),
+                MakeMetricsField<double>("bin_size", offsetof(SolverMetrics, binSize)),
+                MakeMetricsField<uint64_t>("num_bins", offsetof(SolverMetrics, numBins)),
+                MakeMetricsField<uint64_t>("max_sph_in_bin", offsetof(SolverMetrics, maxSphFoundInBin)),
+                MakeMetricsField<uint64_t>("max_tri_in_bin", offsetof(SolverMetrics, maxTriFoundInBin)),
+                MakeMetricsField<uint32_t>("current_drift", offsetof(SolverMetrics, currentDrift)),
+                MakeMetricsField<uint32_t>("max_drift", offsetof(SolverMetrics, maxDrift)),
+                MakeMetricsField<int64_t>("kT_lag_steps", offsetof(SolverMetrics, kTLagSteps)),
+                MakeMetricsField<double>("dT_wait_s", offsetof(SolverMetrics, dTWaitSeconds)),
+                MakeMetricsField<uint64_t>("num_sleeping_owners", offsetof(SolverMetrics, nSleepingOwners)),
+                MakeMetricsField<float>("step_size", offsetof(SolverMetrics, stepSize))};
+    }
+    void WriteCsvRow(std::ostream& out) const {
+        out << time << "," << step << "," << isKTUpdate << "," << nContacts << "," << avgCntsPerSphere << ","
+            << maxVel << "," << binSize << "," << numBins << "," << maxSphFoundInBin << "," << maxTriFoundInBin << ","
+            << currentDrift << "," << maxDrift << "," << kTLagSteps << "," << dTWaitSeconds << "," << nSleepingOwners
+            << "," << stepSize;
+    }
+};
+static_assert(sizeof(SolverMetrics) == 10 * 8 + 6 * 4, "SolverMetrics should not have padding");
+
 // Manager of the collabortation between the main thread and worker threads
 class WorkerReportChannel {
   public:
@@ -484,6 +908,70 @@ struct familyPair_t {
 
 enum class VAR_TS_STRAT { DEME_CONST, MAX_VEL, INT_GAP };
 
+// Picks the time step size in adaptive time stepping. It is updated at each kT update, with the max velocity of the
+// system and (for INT_GAP) the deepest overlap seen since the last update. A smaller step takes effect right away. A
+// larger one takes effect only at the next update, because the contact list dT is about to use was made with a margin
+// that only accounts for the current step size; the step size kT makes the next contact list with accounts for both.
+class TimeStepController {
+  public:
+    VAR_TS_STRAT strat = VAR_TS_STRAT::DEME_CONST;
+    double minStep = 0.;
+    double maxStep = DEME_HUGE_FLOAT;
+    // The smallest sphere radius in the system
+    double minRadius = DEME_HUGE_FLOAT;
+    // The farthest an entity may travel in one step, as a fraction of minRadius
+    double maxTravelRatio = 0.01;
+    // The deepest overlap allowed, as a fraction of the sphere radius (INT_GAP only)
+    double maxOverlapRatio = 0.01;
+    // The most the step size can grow by at one update
+    double maxGrowth = 1.1;
+
+    TimeStepController() {}
+
+    // Start over from a given step size
+    void Reset(double h) {
+        current = h;
+        pending = h;
+    }
+
+    // Given the max velocity and the deepest overlap (as a fraction of the sphere radius) seen since the last update,
+    // return the step size to use from now on
+    double Update(double maxVel, double overlapRatio) {
+        // The larger step proposed at the last update now takes effect
+        current = pending;
+        double target = maxStep;
+        if (maxVel > 0.) {
+            target = std::min(target, maxTravelRatio * minRadius / maxVel);
+        }
+        // Too deep an overlap means the contacts are not resolved finely enough in time; shrink the step in proportion
+        if (strat == VAR_TS_STRAT::INT_GAP && overlapRatio > maxOverlapRatio) {
+            target = std::min(target, current * maxOverlapRatio / overlapRatio);
+        }
+        target = std::min(target, current * maxGrowth);
+        target = std::max(std::min(target, maxStep), minStep);
+        if (target < current) {
+            current = target;
+        }
+        pending = target;
+        return current;
+    }
+
+    // The Rayleigh critical time step of a sphere: the time a Rayleigh surface wave takes to travel across it
+    static double RayleighTimeStep(double radius, double density, double E, double nu) {
+        const double G = E / (2. * (1. + nu));
+        return PI * radius * std::sqrt(density / G) / (0.1631 * nu + 0.8766);
+    }
+
+    // The step size in use
+    double GetStep() const { return current; }
+    // The largest step size that may be used before the next update, which kT should make contact margins with
+    double GetStepForMargin() const { return std::max(current, pending); }
+
+  private:
+    double current = 0.;
+    double pending = 0.;
+};
+
 class ClumpTemplateFlatten {
   public:
     std::vector<float>& mass;
@@ -539,6 +1027,19 @@ struct SolverFlags {
     bool useNoContactRecord = false;
     // Collect force (reduce to acc) right in the force calculation kernel
     bool useForceCollectInPlace = false;
+    // Collect force by summing each block's contributions per owner in shared memory first
+    bool useCompactForceCollect = false;
+    // Keep torque-only forces and contact points in compactFloat3_t, not float3
+    bool useCompactContactStorage = false;
+    // Keep contact wildcards in bf16_t, not float
+    bool useBF16ContactWildcards = false;
+    // Record contacts by family pair, as familyForceRecord says
+    bool useForceRecordPolicy = false;
+    // Some family pairs' contacts are recorded as per-owner aggregates
+    bool useOwnerCntAggregates = false;
+    // Calculate the forces of each run of same-type contacts (in the type-sorted contact array) with a kernel
+    // specialized for that type
+    bool useTypeSpecializedForceCalc = false;
     // Max number of steps dT is allowed to be ahead of kT, even when auto-adapt is enabled
     unsigned int upperBoundFutureDrift = 5000;
     // (targetDriftMoreThanAvg + targetDriftMultipleOfAvg * actual_dT_steps_per_kT_step) is used to calculate contact
@@ -548,6 +1049,14 @@ struct SolverFlags {
 
     // Whether the solver auto-update those sim params
     bool autoBinSize = true;
+    // Re-bin only the spheres that moved to other bins, rather than all spheres, at each CD step
+    bool useIncrementalBinning = false;
+    // Bin each sphere in a level of bins that suits its size, rather than all in the same bins
+    bool useHierarchicalBinning = false;
+    // Run kT's contact detection on host threads rather than on the device, with this many threads (0 means as many
+    // as the hardware has)
+    bool useHostContactDetection = false;
+    unsigned int hostCDNumThreads = 0;
     bool autoUpdateFreq = true;
 
     // The max number of average contacts per sphere has before the solver errors out. The reason why I didn't use the
@@ -583,6 +1092,150 @@ class DEMTriangle {
     float3 p3;
 };
 
+/// Sorted, disjoint [begin, end) ranges of the elements of an array that were modified and need to be re-sent. Ranges
+/// less than MERGE_GAP elements apart are merged (one larger copy is cheaper than two small ones), and if there are
+/// still more than MAX_RANGES of them, they collapse into one.
+class DirtyRanges {
+  public:
+    static constexpr size_t MERGE_GAP = 64;
+    static constexpr size_t MAX_RANGES = 32;
+
+    void Add(size_t begin, size_t end) {
+        if (end <= begin)
+            return;
+        m_ranges.emplace_back(begin, end);
+        m_normalized = false;
+    }
+    void Add(const DirtyRanges& other) {
+        for (const auto& range : other.m_ranges)
+            Add(range.first, range.second);
+    }
+
+    const std::vector<std::pair<size_t, size_t>>& Get() {
+        normalize();
+        return m_ranges;
+    }
+    size_t GetNumElements() {
+        normalize();
+        size_t n = 0;
+        for (const auto& range : m_ranges)
+            n += range.second - range.first;
+        return n;
+    }
+    bool Empty() const { return m_ranges.empty(); }
+    void Clear() {
+        m_ranges.clear();
+        m_normalized = true;
+    }
+
+  private:
+    std::vector<std::pair<size_t, size_t>> m_ranges;
+    bool m_normalized = true;
+
+    void normalize() {
+        if (m_normalized)
+            return;
+        std::sort(m_ranges.begin(), m_ranges.end());
+        size_t n = 0;
+        for (size_t i = 1; i < m_ranges.size(); i++) {
+            if (m_ranges[i].first <= m_ranges[n].second + MERGE_GAP) {
+                m_ranges[n].second = std::max(m_ranges[n].second, m_ranges[i].second);
+            } else {
+                m_ranges[++n] = m_ranges[i];
+            }
+        }
+        m_ranges.resize(n + 1);
+        if (m_ranges.size() > MAX_RANGES) {
+            m_ranges.front().second = m_ranges.back().second;
+            m_ranges.resize(1);
+        }
+        m_normalized = true;
+    }
+};
+
+/// The solver-side copy of a deformable mesh: its nodes, and the nodes of each facet in the order the simulation
+/// stores them. It also knows which facets each node belongs to, so that a node update only marks (and later re-sends)
+/// the facets it affects.
+class MeshNodeIndex {
+  public:
+    MeshNodeIndex(const std::vector<float3>& nodes, const std::vector<int3>& facet_nodes)
+        : m_nodes(nodes), m_facetNodes(facet_nodes), m_facetDirty(facet_nodes.size(), 0) {
+        // Node-to-facet map, in CSR form
+        m_nodeFacetOffsets.assign(nodes.size() + 1, 0);
+        for (const auto& f : facet_nodes) {
+            m_nodeFacetOffsets[f.x + 1]++;
+            m_nodeFacetOffsets[f.y + 1]++;
+            m_nodeFacetOffsets[f.z + 1]++;
+        }
+        for (size_t i = 0; i < nodes.size(); i++)
+            m_nodeFacetOffsets[i + 1] += m_nodeFacetOffsets[i];
+        m_nodeFacets.resize(m_nodeFacetOffsets.back());
+        std::vector<size_t> fill(m_nodeFacetOffsets.begin(), m_nodeFacetOffsets.end() - 1);
+        for (size_t i = 0; i < facet_nodes.size(); i++) {
+            m_nodeFacets[fill[facet_nodes[i].x]++] = i;
+            m_nodeFacets[fill[facet_nodes[i].y]++] = i;
+            m_nodeFacets[fill[facet_nodes[i].z]++] = i;
+        }
+    }
+
+    size_t GetNumNodes() const { return m_nodes.size(); }
+    size_t GetNumFacets() const { return m_facetNodes.size(); }
+    const std::vector<float3>& GetNodes() const { return m_nodes; }
+    DEMTriangle GetFacet(size_t i) const {
+        const int3& f = m_facetNodes[i];
+        return DEMTriangle(m_nodes[f.x], m_nodes[f.y], m_nodes[f.z]);
+    }
+
+    /// Move a node; the facets using it are marked dirty, unless it did not actually move.
+    void SetNode(size_t i, const float3& pos) {
+        float3& node = m_nodes[i];
+        if (node.x == pos.x && node.y == pos.y && node.z == pos.z)
+            return;
+        node = pos;
+        for (size_t j = m_nodeFacetOffsets[i]; j < m_nodeFacetOffsets[i + 1]; j++) {
+            const size_t facet = m_nodeFacets[j];
+            if (!m_facetDirty[facet]) {
+                m_facetDirty[facet] = 1;
+                m_dirtyFacets.push_back(facet);
+            }
+        }
+    }
+
+    /// Mark every facet dirty, such as when the simulation's copy of this mesh is not known to match this one.
+    void MarkAllDirty() { m_allDirty = true; }
+
+    /// Append the dirty facets, as ranges, to `ranges', then mark all facets clean.
+    void TakeDirtyFacets(DirtyRanges& ranges) {
+        if (m_allDirty) {
+            ranges.Add(0, m_facetNodes.size());
+        } else {
+            std::sort(m_dirtyFacets.begin(), m_dirtyFacets.end());
+            size_t i = 0;
+            while (i < m_dirtyFacets.size()) {
+                size_t j = i + 1;
+                while (j < m_dirtyFacets.size() && m_dirtyFacets[j] == m_dirtyFacets[j - 1] + 1)
+                    j++;
+                ranges.Add(m_dirtyFacets[i], m_dirtyFacets[j - 1] + 1);
+                i = j;
+            }
+        }
+        for (const auto facet : m_dirtyFacets)
+            m_facetDirty[facet] = 0;
+        m_dirtyFacets.clear();
+        m_allDirty = false;
+    }
+
+  private:
+    std::vector<float3> m_nodes;
+    std::vector<int3> m_facetNodes;
+    // Facets of node i are m_nodeFacets[m_nodeFacetOffsets[i]] to m_nodeFacets[m_nodeFacetOffsets[i + 1] - 1]
+    std::vector<size_t> m_nodeFacetOffsets;
+    std::vector<size_t> m_nodeFacets;
+    std::vector<notStupidBool_t> m_facetDirty;
+    std::vector<size_t> m_dirtyFacets;
+    bool m_allDirty = false;
+};
+
 // A struct that defines a `clump' (one of the core concepts of this solver). A clump is typically small which consists
 // of several sphere components, but it can be as large as having thousands of spheres.
 class DEMClumpTemplate {
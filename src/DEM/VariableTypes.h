@@ -56,6 +56,19 @@ typedef uint8_t ownerType_t;      ///< The type of a owner entity
 
 typedef uint8_t objType_t;
 typedef bool objNormal_t;
+
+// A 3-vector stored in 8 bytes: 16-bit mantissas sharing a power-of-two exponent. It keeps about 4 to 5 significant
+// digits of the largest component, over the range of float.
+struct compactFloat3_t {
+    int16_t x;
+    int16_t y;
+    int16_t z;
+    int16_t exp;
+};
+
+// A float stored as its top 16 bits (bfloat16): the range of float, with 8 significant bits, so a relative error of
+// at most 2^-8 once rounded
+typedef uint16_t bf16_t;
 }  // namespace deme
 
 #endif
@@ -3,6 +3,7 @@
 //
 //	SPDX-License-Identifier: BSD-3-Clause
 
+#include <cmath>
 #include <cstring>
 #include <iostream>
 #include <thread>
@@ -48,11 +49,18 @@ void DEMDynamicThread::packDataPointers() {
     granData->alphaZ = alphaZ.data();
     granData->accSpecified = accSpecified.data();
     granData->angAccSpecified = angAccSpecified.data();
+    granData->sleepCounter = sleepCounter.data();
+    granData->ownerCntForceSum = ownerCntForceSum.data();
+    granData->ownerCntTorqueSum = ownerCntTorqueSum.data();
+    granData->ownerCntNum = ownerCntNum.data();
     granData->idGeometryA = idGeometryA.data();
     granData->idGeometryB = idGeometryB.data();
     granData->contactType = contactType.data();
     granData->familyMasks = familyMaskMatrix.data();
     granData->familyExtraMarginSize = familyExtraMarginSize.data();
+    granData->familySubcycled = familySubcycled.data();
+    granData->familyForceRecord = familyForceRecord.data();
+    granData->fullRecordSlot = fullRecordSlot.data();
 
     // granData->idGeometryA_buffer = idGeometryA_buffer.data();
     // granData->idGeometryB_buffer = idGeometryB_buffer.data();
@@ -63,10 +71,15 @@ void DEMDynamicThread::packDataPointers() {
     granData->contactTorque_convToForce = contactTorque_convToForce.data();
     granData->contactPointGeometryA = contactPointGeometryA.data();
     granData->contactPointGeometryB = contactPointGeometryB.data();
+    granData->useCompactContactStorage = solverFlags.useCompactContactStorage;
+    granData->compactTorque_convToForce = compactTorque_convToForce.data();
+    granData->compactPointGeometryA = compactPointGeometryA.data();
     // granData->contactHistory = contactHistory.data();
     // granData->contactDuration = contactDuration.data();
+    granData->useBF16ContactWildcards = solverFlags.useBF16ContactWildcards;
     for (unsigned int i = 0; i < simParams->nContactWildcards; i++) {
         granData->contactWildcards[i] = contactWildcards[i].data();
+        granData->contactWildcardsBF16[i] = contactWildcardsBF16[i].data();
     }
     for (unsigned int i = 0; i < simParams->nOwnerWildcards; i++) {
         granData->ownerWildcards[i] = ownerWildcards[i].data();
@@ -124,8 +137,13 @@ void DEMDynamicThread::packTransferPointers(DEMKinematicThread*& kT) {
 void DEMDynamicThread::changeFamily(unsigned int ID_from, unsigned int ID_to) {
     family_t ID_from_impl = ID_from;
     family_t ID_to_impl = ID_to;
-    std::replace_if(
-        familyID.begin(), familyID.end(), [ID_from_impl](family_t& i) { return i == ID_from_impl; }, ID_to_impl);
+    // Owners that change family are woken up, as the new family may move differently
+    for (size_t i = 0; i < familyID.size(); i++) {
+        if (familyID[i] == ID_from_impl) {
+            familyID[i] = ID_to_impl;
+            wakeOwner(i);
+        }
+    }
 }
 
 void DEMDynamicThread::setSimParams(unsigned char nvXp2,
@@ -219,6 +237,11 @@ void DEMDynamicThread::changeOwnerSizes(const std::vector<bodyID_t>& IDs, const
         .launch(granData, idBool, ownerFactors, (size_t)simParams->nSpheresGM);
     DEME_GPU_CALL(cudaStreamSynchronize(streamInfo.stream));
 
+    // A resized owner is woken up
+    for (const auto& ID : IDs) {
+        wakeOwner(ID);
+    }
+
     // cudaStreamDestroy(new_stream);
 }
 
@@ -252,151 +275,304 @@ void DEMDynamicThread::allocateManagedArrays(size_t nOwnerBodies,
     simParams->nDistinctClumpComponents = nClumpComponents;
     simParams->nMatTuples = nMatTuples;
 
+    // If the user instructed a capacity, the arrays are made that long first, then the resizing below is just a change
+    // of size. Otherwise, the arrays grow geometrically as they are resized.
+    reserveManagedArrays();
+
+    // In any case, in this initialization process we should not make contact arrays smaller than they used to be, or
+    // we may lose data. Also, if this is a new-boot, we allocate them for at least nSpheresGM*DEME_INIT_CNT_MULTIPLIER
+    // elements.
+    ManagedArraySizes n;
+    n.nOwnerBodies = nOwnerBodies;
+    n.nSpheresGM = nSpheresGM;
+    n.nTriGM = nTriGM;
+    n.nAnalGM = nAnalGM;
+    n.nMassProperties = nMassProperties;
+    n.nClumpComponents = nClumpComponents;
+    n.nContacts =
+        DEME_MAX(*stateOfSolver_resources.pNumContacts + nExtraContacts, nSpheresGM * DEME_INIT_CNT_MULTIPLIER);
+    n.nFullRecordContacts = fullRecordArraySize(n.nContacts, solverFlags.useForceRecordPolicy);
+    n.nContactWildcards = simParams->nContactWildcards;
+    n.nOwnerWildcards = simParams->nOwnerWildcards;
+    n.nGeoWildcards = simParams->nGeoWildcards;
+    n.isHistoryless = solverFlags.isHistoryless;
+    n.useClumpJitify = solverFlags.useClumpJitify;
+    n.useMassJitify = solverFlags.useMassJitify;
+    n.useOwnerCntAggregates = solverFlags.useOwnerCntAggregates;
+    n.useNoContactRecord = solverFlags.useNoContactRecord;
+    n.useForceRecordPolicy = solverFlags.useForceRecordPolicy;
+    n.useCompactContactStorage = solverFlags.useCompactContactStorage;
+    n.useBF16ContactWildcards = solverFlags.useBF16ContactWildcards;
+    resizeManagedArrays(n);
+
+    // You know what, let's not init dT buffers, since kT will change it when needed anyway. Besides, changing it here
+    // will cause problems in the case of a re-init-ed simulation with more clumps added to system, since we may
+    // accidentally clamp those arrays.
+    /*
+    // Transfer buffer arrays
+    // The following several arrays will have variable sizes, so here we only used an estimate.
+    // It is cudaMalloc-ed memory, not managed, because we want explicit locality control of buffers
+    buffer_size = DEME_MAX(buffer_size, nSpheresGM * DEME_INIT_CNT_MULTIPLIER);
+    DEME_DEVICE_PTR_ALLOC(granData->idGeometryA_buffer, buffer_size);
+    DEME_DEVICE_PTR_ALLOC(granData->idGeometryB_buffer, buffer_size);
+    DEME_DEVICE_PTR_ALLOC(granData->contactType_buffer, buffer_size);
+    // DEME_TRACKED_RESIZE_DEBUGPRINT(idGeometryA_buffer, nSpheresGM * DEME_INIT_CNT_MULTIPLIER, "idGeometryA_buffer",
+    // 0); DEME_TRACKED_RESIZE_DEBUGPRINT(idGeometryB_buffer, nSpheresGM * DEME_INIT_CNT_MULTIPLIER,
+    // "idGeometryB_buffer", 0); DEME_TRACKED_RESIZE_DEBUGPRINT(contactType_buffer, nSpheresGM *
+    // DEME_INIT_CNT_MULTIPLIER, "contactType_buffer", NOT_A_CONTACT);
+    // DEME_ADVISE_DEVICE(idGeometryA_buffer, streamInfo.device);
+    // DEME_ADVISE_DEVICE(idGeometryB_buffer, streamInfo.device);
+    // DEME_ADVISE_DEVICE(contactType_buffer, streamInfo.device);
+    if (!solverFlags.isHistoryless) {
+        // DEME_TRACKED_RESIZE_DEBUGPRINT(contactMapping_buffer, nSpheresGM * DEME_INIT_CNT_MULTIPLIER,
+        //                         "contactMapping_buffer", NULL_MAPPING_PARTNER);
+        // DEME_ADVISE_DEVICE(contactMapping_buffer, streamInfo.device);
+        DEME_DEVICE_PTR_ALLOC(granData->contactMapping_buffer, buffer_size);
+    }
+    */
+}
+
+void DEMDynamicThread::sizeManagedArrays(const ManagedArraySizes& n, MemoryRegistry& registry) {
+    MemorySizingScope sizing(registry);
+    resizeManagedArrays(n);
+}
+
+void DEMDynamicThread::resizeManagedArrays(const ManagedArraySizes& n) {
     // Resize to the number of clumps
-    DEME_TRACKED_RESIZE_DEBUGPRINT(familyID, nOwnerBodies, "familyID", 0);
-    DEME_TRACKED_RESIZE_DEBUGPRINT(voxelID, nOwnerBodies, "voxelID", 0);
-    DEME_TRACKED_RESIZE_DEBUGPRINT(locX, nOwnerBodies, "locX", 0);
-    DEME_TRACKED_RESIZE_DEBUGPRINT(locY, nOwnerBodies, "locY", 0);
-    DEME_TRACKED_RESIZE_DEBUGPRINT(locZ, nOwnerBodies, "locZ", 0);
-    DEME_TRACKED_RESIZE_DEBUGPRINT(oriQw, nOwnerBodies, "oriQw", 1);
-    DEME_TRACKED_RESIZE_DEBUGPRINT(oriQx, nOwnerBodies, "oriQx", 0);
-    DEME_TRACKED_RESIZE_DEBUGPRINT(oriQy, nOwnerBodies, "oriQy", 0);
-    DEME_TRACKED_RESIZE_DEBUGPRINT(oriQz, nOwnerBodies, "oriQz", 0);
-    DEME_TRACKED_RESIZE_DEBUGPRINT(vX, nOwnerBodies, "vX", 0);
-    DEME_TRACKED_RESIZE_DEBUGPRINT(vY, nOwnerBodies, "vY", 0);
-    DEME_TRACKED_RESIZE_DEBUGPRINT(vZ, nOwnerBodies, "vZ", 0);
-    DEME_TRACKED_RESIZE_DEBUGPRINT(omgBarX, nOwnerBodies, "omgBarX", 0);
-    DEME_TRACKED_RESIZE_DEBUGPRINT(omgBarY, nOwnerBodies, "omgBarY", 0);
-    DEME_TRACKED_RESIZE_DEBUGPRINT(omgBarZ, nOwnerBodies, "omgBarZ", 0);
-    DEME_TRACKED_RESIZE_DEBUGPRINT(aX, nOwnerBodies, "aX", 0);
-    DEME_TRACKED_RESIZE_DEBUGPRINT(aY, nOwnerBodies, "aY", 0);
-    DEME_TRACKED_RESIZE_DEBUGPRINT(aZ, nOwnerBodies, "aZ", 0);
-    DEME_TRACKED_RESIZE_DEBUGPRINT(alphaX, nOwnerBodies, "alphaX", 0);
-    DEME_TRACKED_RESIZE_DEBUGPRINT(alphaY, nOwnerBodies, "alphaY", 0);
-    DEME_TRACKED_RESIZE_DEBUGPRINT(alphaZ, nOwnerBodies, "alphaZ", 0);
-    DEME_TRACKED_RESIZE_DEBUGPRINT(accSpecified, nOwnerBodies, "accSpecified", 0);
-    DEME_TRACKED_RESIZE_DEBUGPRINT(angAccSpecified, nOwnerBodies, "angAccSpecified", 0);
+    DEME_TRACKED_RESIZE_DEBUGPRINT(familyID, n.nOwnerBodies, "familyID", 0);
+    DEME_TRACKED_RESIZE_DEBUGPRINT(voxelID, n.nOwnerBodies, "voxelID", 0);
+    DEME_TRACKED_RESIZE_DEBUGPRINT(locX, n.nOwnerBodies, "locX", 0);
+    DEME_TRACKED_RESIZE_DEBUGPRINT(locY, n.nOwnerBodies, "locY", 0);
+    DEME_TRACKED_RESIZE_DEBUGPRINT(locZ, n.nOwnerBodies, "locZ", 0);
+    DEME_TRACKED_RESIZE_DEBUGPRINT(oriQw, n.nOwnerBodies, "oriQw", 1);
+    DEME_TRACKED_RESIZE_DEBUGPRINT(oriQx, n.nOwnerBodies, "oriQx", 0);
+    DEME_TRACKED_RESIZE_DEBUGPRINT(oriQy, n.nOwnerBodies, "oriQy", 0);
+    DEME_TRACKED_RESIZE_DEBUGPRINT(oriQz, n.nOwnerBodies, "oriQz", 0);
+    DEME_TRACKED_RESIZE_DEBUGPRINT(vX, n.nOwnerBodies, "vX", 0);
+    DEME_TRACKED_RESIZE_DEBUGPRINT(vY, n.nOwnerBodies, "vY", 0);
+    DEME_TRACKED_RESIZE_DEBUGPRINT(vZ, n.nOwnerBodies, "vZ", 0);
+    DEME_TRACKED_RESIZE_DEBUGPRINT(omgBarX, n.nOwnerBodies, "omgBarX", 0);
+    DEME_TRACKED_RESIZE_DEBUGPRINT(omgBarY, n.nOwnerBodies, "omgBarY", 0);
+    DEME_TRACKED_RESIZE_DEBUGPRINT(omgBarZ, n.nOwnerBodies, "omgBarZ", 0);
+    DEME_TRACKED_RESIZE_DEBUGPRINT(aX, n.nOwnerBodies, "aX", 0);
+    DEME_TRACKED_RESIZE_DEBUGPRINT(aY, n.nOwnerBodies, "aY", 0);
+    DEME_TRACKED_RESIZE_DEBUGPRINT(aZ, n.nOwnerBodies, "aZ", 0);
+    DEME_TRACKED_RESIZE_DEBUGPRINT(alphaX, n.nOwnerBodies, "alphaX", 0);
+    DEME_TRACKED_RESIZE_DEBUGPRINT(alphaY, n.nOwnerBodies, "alphaY", 0);
+    DEME_TRACKED_RESIZE_DEBUGPRINT(alphaZ, n.nOwnerBodies, "alphaZ", 0);
+    DEME_TRACKED_RESIZE_DEBUGPRINT(accSpecified, n.nOwnerBodies, "accSpecified", 0);
+    DEME_TRACKED_RESIZE_DEBUGPRINT(angAccSpecified, n.nOwnerBodies, "angAccSpecified", 0);
+    DEME_TRACKED_RESIZE_DEBUGPRINT(sleepCounter, n.nOwnerBodies, "sleepCounter", 0);
+    if (n.useOwnerCntAggregates) {
+        DEME_TRACKED_RESIZE_DEBUGPRINT(ownerCntForceSum, n.nOwnerBodies, "ownerCntForceSum", make_float3(0));
+        DEME_TRACKED_RESIZE_DEBUGPRINT(ownerCntTorqueSum, n.nOwnerBodies, "ownerCntTorqueSum", make_float3(0));
+        DEME_TRACKED_RESIZE_DEBUGPRINT(ownerCntNum, n.nOwnerBodies, "ownerCntNum", 0);
+    }
 
     // Resize the family mask `matrix' (in fact it is flattened)
     DEME_TRACKED_RESIZE_DEBUGPRINT(familyMaskMatrix, (NUM_AVAL_FAMILIES + 1) * NUM_AVAL_FAMILIES / 2,
                                    "familyMaskMatrix", DONT_PREVENT_CONTACT);
 
     // Resize to the number of geometries
-    DEME_TRACKED_RESIZE_DEBUGPRINT(ownerClumpBody, nSpheresGM, "ownerClumpBody", 0);
-    DEME_TRACKED_RESIZE_DEBUGPRINT(sphereMaterialOffset, nSpheresGM, "sphereMaterialOffset", 0);
+    DEME_TRACKED_RESIZE_DEBUGPRINT(ownerClumpBody, n.nSpheresGM, "ownerClumpBody", 0);
+    DEME_TRACKED_RESIZE_DEBUGPRINT(sphereMaterialOffset, n.nSpheresGM, "sphereMaterialOffset", 0);
     // For clump component offset, it's only needed if clump components are jitified
-    if (solverFlags.useClumpJitify) {
-        DEME_TRACKED_RESIZE_DEBUGPRINT(clumpComponentOffset, nSpheresGM, "clumpComponentOffset", 0);
+    if (n.useClumpJitify) {
+        DEME_TRACKED_RESIZE_DEBUGPRINT(clumpComponentOffset, n.nSpheresGM, "clumpComponentOffset", 0);
         // This extended component offset array can hold offset numbers even for big clumps (whereas
         // clumpComponentOffset is typically uint_8, so it may not). If a sphere's component offset index falls in this
         // range then it is not jitified, and the kernel needs to look for it in the global memory.
-        DEME_TRACKED_RESIZE_DEBUGPRINT(clumpComponentOffsetExt, nSpheresGM, "clumpComponentOffsetExt", 0);
-        DEME_TRACKED_RESIZE_DEBUGPRINT(radiiSphere, nClumpComponents, "radiiSphere", 0);
-        DEME_TRACKED_RESIZE_DEBUGPRINT(relPosSphereX, nClumpComponents, "relPosSphereX", 0);
-        DEME_TRACKED_RESIZE_DEBUGPRINT(relPosSphereY, nClumpComponents, "relPosSphereY", 0);
-        DEME_TRACKED_RESIZE_DEBUGPRINT(relPosSphereZ, nClumpComponents, "relPosSphereZ", 0);
+        DEME_TRACKED_RESIZE_DEBUGPRINT(clumpComponentOffsetExt, n.nSpheresGM, "clumpComponentOffsetExt", 0);
+        DEME_TRACKED_RESIZE_DEBUGPRINT(radiiSphere, n.nClumpComponents, "radiiSphere", 0);
+        DEME_TRACKED_RESIZE_DEBUGPRINT(relPosSphereX, n.nClumpComponents, "relPosSphereX", 0);
+        DEME_TRACKED_RESIZE_DEBUGPRINT(relPosSphereY, n.nClumpComponents, "relPosSphereY", 0);
+        DEME_TRACKED_RESIZE_DEBUGPRINT(relPosSphereZ, n.nClumpComponents, "relPosSphereZ", 0);
     } else {
-        DEME_TRACKED_RESIZE_DEBUGPRINT(radiiSphere, nSpheresGM, "radiiSphere", 0);
-        DEME_TRACKED_RESIZE_DEBUGPRINT(relPosSphereX, nSpheresGM, "relPosSphereX", 0);
-        DEME_TRACKED_RESIZE_DEBUGPRINT(relPosSphereY, nSpheresGM, "relPosSphereY", 0);
-        DEME_TRACKED_RESIZE_DEBUGPRINT(relPosSphereZ, nSpheresGM, "relPosSphereZ", 0);
+        DEME_TRACKED_RESIZE_DEBUGPRINT(radiiSphere, n.nSpheresGM, "radiiSphere", 0);
+        DEME_TRACKED_RESIZE_DEBUGPRINT(relPosSphereX, n.nSpheresGM, "relPosSphereX", 0);
+        DEME_TRACKED_RESIZE_DEBUGPRINT(relPosSphereY, n.nSpheresGM, "relPosSphereY", 0);
+        DEME_TRACKED_RESIZE_DEBUGPRINT(relPosSphereZ, n.nSpheresGM, "relPosSphereZ", 0);
     }
 
     // Resize to the number of triangle facets
-    DEME_TRACKED_RESIZE_DEBUGPRINT(ownerMesh, nTriGM, "ownerMesh", 0);
-    DEME_TRACKED_RESIZE_DEBUGPRINT(relPosNode1, nTriGM, "relPosNode1", make_float3(0));
-    DEME_TRACKED_RESIZE_DEBUGPRINT(relPosNode2, nTriGM, "relPosNode2", make_float3(0));
-    DEME_TRACKED_RESIZE_DEBUGPRINT(relPosNode3, nTriGM, "relPosNode3", make_float3(0));
-    DEME_TRACKED_RESIZE_DEBUGPRINT(triMaterialOffset, nTriGM, "triMaterialOffset", 0);
+    DEME_TRACKED_RESIZE_DEBUGPRINT(ownerMesh, n.nTriGM, "ownerMesh", 0);
+    DEME_TRACKED_RESIZE_DEBUGPRINT(relPosNode1, n.nTriGM, "relPosNode1", make_float3(0));
+    DEME_TRACKED_RESIZE_DEBUGPRINT(relPosNode2, n.nTriGM, "relPosNode2", make_float3(0));
+    DEME_TRACKED_RESIZE_DEBUGPRINT(relPosNode3, n.nTriGM, "relPosNode3", make_float3(0));
+    DEME_TRACKED_RESIZE_DEBUGPRINT(triMaterialOffset, n.nTriGM, "triMaterialOffset", 0);
 
     // Resize to the number of analytical geometries
-    DEME_TRACKED_RESIZE_DEBUGPRINT(ownerAnalBody, nAnalGM, "ownerAnalBody", 0);
+    DEME_TRACKED_RESIZE_DEBUGPRINT(ownerAnalBody, n.nAnalGM, "ownerAnalBody", 0);
 
     // Resize to number of owners
-    DEME_TRACKED_RESIZE_DEBUGPRINT(ownerTypes, nOwnerBodies, "ownerTypes", 0);
-    DEME_TRACKED_RESIZE_DEBUGPRINT(inertiaPropOffsets, nOwnerBodies, "inertiaPropOffsets", 0);
+    DEME_TRACKED_RESIZE_DEBUGPRINT(ownerTypes, n.nOwnerBodies, "ownerTypes", 0);
+    DEME_TRACKED_RESIZE_DEBUGPRINT(inertiaPropOffsets, n.nOwnerBodies, "inertiaPropOffsets", 0);
     // If we jitify mass properties, then
-    if (solverFlags.useMassJitify) {
-        DEME_TRACKED_RESIZE_DEBUGPRINT(massOwnerBody, nMassProperties, "massOwnerBody", 0);
-        DEME_TRACKED_RESIZE_DEBUGPRINT(mmiXX, nMassProperties, "mmiXX", 0);
-        DEME_TRACKED_RESIZE_DEBUGPRINT(mmiYY, nMassProperties, "mmiYY", 0);
-        DEME_TRACKED_RESIZE_DEBUGPRINT(mmiZZ, nMassProperties, "mmiZZ", 0);
+    if (n.useMassJitify) {
+        DEME_TRACKED_RESIZE_DEBUGPRINT(massOwnerBody, n.nMassProperties, "massOwnerBody", 0);
+        DEME_TRACKED_RESIZE_DEBUGPRINT(mmiXX, n.nMassProperties, "mmiXX", 0);
+        DEME_TRACKED_RESIZE_DEBUGPRINT(mmiYY, n.nMassProperties, "mmiYY", 0);
+        DEME_TRACKED_RESIZE_DEBUGPRINT(mmiZZ, n.nMassProperties, "mmiZZ", 0);
     } else {
-        DEME_TRACKED_RESIZE_DEBUGPRINT(massOwnerBody, nOwnerBodies, "massOwnerBody", 0);
-        DEME_TRACKED_RESIZE_DEBUGPRINT(mmiXX, nOwnerBodies, "mmiXX", 0);
-        DEME_TRACKED_RESIZE_DEBUGPRINT(mmiYY, nOwnerBodies, "mmiYY", 0);
-        DEME_TRACKED_RESIZE_DEBUGPRINT(mmiZZ, nOwnerBodies, "mmiZZ", 0);
+        DEME_TRACKED_RESIZE_DEBUGPRINT(massOwnerBody, n.nOwnerBodies, "massOwnerBody", 0);
+        DEME_TRACKED_RESIZE_DEBUGPRINT(mmiXX, n.nOwnerBodies, "mmiXX", 0);
+        DEME_TRACKED_RESIZE_DEBUGPRINT(mmiYY, n.nOwnerBodies, "mmiYY", 0);
+        DEME_TRACKED_RESIZE_DEBUGPRINT(mmiZZ, n.nOwnerBodies, "mmiZZ", 0);
     }
     // Volume info is jitified
-    DEME_TRACKED_RESIZE_DEBUGPRINT(volumeOwnerBody, nMassProperties, "volumeOwnerBody", 0);
+    DEME_TRACKED_RESIZE_DEBUGPRINT(volumeOwnerBody, n.nMassProperties, "volumeOwnerBody", 0);
 
     // Arrays for contact info
     // The lengths of contact event-based arrays are just estimates. My estimate of total contact pairs is ~ 2n, and I
     // think the max is 6n (although I can't prove it). Note the estimate should be large enough to decrease the number
     // of reallocations in the simulation, but not too large that eats too much memory.
     {
-        // In any case, in this initialization process we should not make contact arrays smaller than it used to be, or
-        // we may lose data. Also, if this is a new-boot, we allocate this array for at least
-        // nSpheresGM*DEME_INIT_CNT_MULTIPLIER elements.
-        size_t cnt_arr_size =
-            DEME_MAX(*stateOfSolver_resources.pNumContacts + nExtraContacts, nSpheresGM * DEME_INIT_CNT_MULTIPLIER);
+        const size_t cnt_arr_size = n.nContacts;
         DEME_TRACKED_RESIZE_DEBUGPRINT(idGeometryA, cnt_arr_size, "idGeometryA", 0);
         DEME_TRACKED_RESIZE_DEBUGPRINT(idGeometryB, cnt_arr_size, "idGeometryB", 0);
         DEME_TRACKED_RESIZE_DEBUGPRINT(contactType, cnt_arr_size, "contactType", NOT_A_CONTACT);
 
-        if (!solverFlags.useNoContactRecord) {
-            DEME_TRACKED_RESIZE_DEBUGPRINT(contactForces, cnt_arr_size, "contactForces", make_float3(0));
-            DEME_TRACKED_RESIZE_DEBUGPRINT(contactTorque_convToForce, cnt_arr_size, "contactTorque_convToForce",
-                                           make_float3(0));
-            DEME_TRACKED_RESIZE_DEBUGPRINT(contactPointGeometryA, cnt_arr_size, "contactPointGeometryA",
-                                           make_float3(0));
-            DEME_TRACKED_RESIZE_DEBUGPRINT(contactPointGeometryB, cnt_arr_size, "contactPointGeometryB",
+        if (!n.useNoContactRecord) {
+            // With a force record policy, the record arrays only hold the contacts recorded in full, and each contact
+            // is mapped to its place there
+            const size_t rec_arr_size = n.nFullRecordContacts;
+            if (n.useForceRecordPolicy) {
+                DEME_TRACKED_RESIZE_DEBUGPRINT(fullRecordSlot, cnt_arr_size, "fullRecordSlot", NULL_MAPPING_PARTNER);
+            }
+            DEME_TRACKED_RESIZE_DEBUGPRINT(contactForces, rec_arr_size, "contactForces", make_float3(0));
+            if (n.useCompactContactStorage) {
+                DEME_TRACKED_RESIZE_DEBUGPRINT(compactTorque_convToForce, rec_arr_size, "compactTorque_convToForce",
+                                               compactFloat3_t());
+                DEME_TRACKED_RESIZE_DEBUGPRINT(compactPointGeometryA, rec_arr_size, "compactPointGeometryA",
+                                               compactFloat3_t());
+            } else {
+                DEME_TRACKED_RESIZE_DEBUGPRINT(contactTorque_convToForce, rec_arr_size, "contactTorque_convToForce",
+                                               make_float3(0));
+                DEME_TRACKED_RESIZE_DEBUGPRINT(contactPointGeometryA, rec_arr_size, "contactPointGeometryA",
+                                               make_float3(0));
+            }
+            // Point B may be on a mesh or analytical owner, which can be too large for the compact form
+            DEME_TRACKED_RESIZE_DEBUGPRINT(contactPointGeometryB, rec_arr_size, "contactPointGeometryB",
                                            make_float3(0));
         }
         // Allocate memory for each wildcard array
-        contactWildcards.resize(simParams->nContactWildcards);
-        ownerWildcards.resize(simParams->nOwnerWildcards);
-        sphereWildcards.resize(simParams->nGeoWildcards);
-        analWildcards.resize(simParams->nGeoWildcards);
-        triWildcards.resize(simParams->nGeoWildcards);
-        for (unsigned int i = 0; i < simParams->nContactWildcards; i++) {
-            DEME_TRACKED_RESIZE_FLOAT(contactWildcards[i], cnt_arr_size, 0);
+        if (!memSizingRegistry) {
+            contactWildcards.resize(n.nContactWildcards);
+            contactWildcardsBF16.resize(n.nContactWildcards);
+            ownerWildcards.resize(n.nOwnerWildcards);
+            sphereWildcards.resize(n.nGeoWildcards);
+            analWildcards.resize(n.nGeoWildcards);
+            triWildcards.resize(n.nGeoWildcards);
+        }
+        for (unsigned int i = 0; i < n.nContactWildcards; i++) {
+            if (n.useBF16ContactWildcards) {
+                DEME_TRACKED_RESIZE_DEBUGPRINT(contactWildcardsBF16[i], cnt_arr_size, "contactWildcardsBF16[i]", 0);
+            } else {
+                DEME_TRACKED_RESIZE_FLOAT(contactWildcards[i], cnt_arr_size, 0);
+            }
         }
-        for (unsigned int i = 0; i < simParams->nOwnerWildcards; i++) {
-            DEME_TRACKED_RESIZE_FLOAT(ownerWildcards[i], nOwnerBodies, 0);
+        for (unsigned int i = 0; i < n.nOwnerWildcards; i++) {
+            DEME_TRACKED_RESIZE_FLOAT(ownerWildcards[i], n.nOwnerBodies, 0);
+        }
+        for (unsigned int i = 0; i < n.nGeoWildcards; i++) {
+            DEME_TRACKED_RESIZE_FLOAT(sphereWildcards[i], n.nSpheresGM, 0);
+            DEME_TRACKED_RESIZE_FLOAT(analWildcards[i], n.nAnalGM, 0);
+            DEME_TRACKED_RESIZE_FLOAT(triWildcards[i], n.nTriGM, 0);
+        }
+    }
+}
+
+void DEMDynamicThread::reserveManagedArrays() {
+    // Per-owner arrays
+    DEME_TRACKED_RESERVE(familyID, reservedOwners, "familyID");
+    DEME_TRACKED_RESERVE(voxelID, reservedOwners, "voxelID");
+    DEME_TRACKED_RESERVE(locX, reservedOwners, "locX");
+    DEME_TRACKED_RESERVE(locY, reservedOwners, "locY");
+    DEME_TRACKED_RESERVE(locZ, reservedOwners, "locZ");
+    DEME_TRACKED_RESERVE(oriQw, reservedOwners, "oriQw");
+    DEME_TRACKED_RESERVE(oriQx, reservedOwners, "oriQx");
+    DEME_TRACKED_RESERVE(oriQy, reservedOwners, "oriQy");
+    DEME_TRACKED_RESERVE(oriQz, reservedOwners, "oriQz");
+    DEME_TRACKED_RESERVE(vX, reservedOwners, "vX");
+    DEME_TRACKED_RESERVE(vY, reservedOwners, "vY");
+    DEME_TRACKED_RESERVE(vZ, reservedOwners, "vZ");
+    DEME_TRACKED_RESERVE(omgBarX, reservedOwners, "omgBarX");
+    DEME_TRACKED_RESERVE(omgBarY, reservedOwners, "omgBarY");
+    DEME_TRACKED_RESERVE(omgBarZ, reservedOwners, "omgBarZ");
+    DEME_TRACKED_RESERVE(aX, reservedOwners, "aX");
+    DEME_TRACKED_RESERVE(aY, reservedOwners, "aY");
+    DEME_TRACKED_RESERVE(aZ, reservedOwners, "aZ");
+    DEME_TRACKED_RESERVE(alphaX, reservedOwners, "alphaX");
+    DEME_TRACKED_RESERVE(alphaY, reservedOwners, "alphaY");
+    DEME_TRACKED_RESERVE(alphaZ, reservedOwners, "alphaZ");
+    DEME_TRACKED_RESERVE(accSpecified, reservedOwners, "accSpecified");
+    DEME_TRACKED_RESERVE(angAccSpecified, reservedOwners, "angAccSpecified");
+    DEME_TRACKED_RESERVE(sleepCounter, reservedOwners, "sleepCounter");
+    if (solverFlags.useOwnerCntAggregates) {
+        DEME_TRACKED_RESERVE(ownerCntForceSum, reservedOwners, "ownerCntForceSum");
+        DEME_TRACKED_RESERVE(ownerCntTorqueSum, reservedOwners, "ownerCntTorqueSum");
+        DEME_TRACKED_RESERVE(ownerCntNum, reservedOwners, "ownerCntNum");
+    }
+    DEME_TRACKED_RESERVE(ownerTypes, reservedOwners, "ownerTypes");
+    DEME_TRACKED_RESERVE(inertiaPropOffsets, reservedOwners, "inertiaPropOffsets");
+    if (!solverFlags.useMassJitify) {
+        DEME_TRACKED_RESERVE(massOwnerBody, reservedOwners, "massOwnerBody");
+        DEME_TRACKED_RESERVE(mmiXX, reservedOwners, "mmiXX");
+        DEME_TRACKED_RESERVE(mmiYY, reservedOwners, "mmiYY");
+        DEME_TRACKED_RESERVE(mmiZZ, reservedOwners, "mmiZZ");
+    }
+
+    // Per-sphere arrays
+    DEME_TRACKED_RESERVE(ownerClumpBody, reservedSpheres, "ownerClumpBody");
+    DEME_TRACKED_RESERVE(sphereMaterialOffset, reservedSpheres, "sphereMaterialOffset");
+    if (solverFlags.useClumpJitify) {
+        DEME_TRACKED_RESERVE(clumpComponentOffset, reservedSpheres, "clumpComponentOffset");
+        DEME_TRACKED_RESERVE(clumpComponentOffsetExt, reservedSpheres, "clumpComponentOffsetExt");
+    } else {
+        DEME_TRACKED_RESERVE(radiiSphere, reservedSpheres, "radiiSphere");
+        DEME_TRACKED_RESERVE(relPosSphereX, reservedSpheres, "relPosSphereX");
+        DEME_TRACKED_RESERVE(relPosSphereY, reservedSpheres, "relPosSphereY");
+        DEME_TRACKED_RESERVE(relPosSphereZ, reservedSpheres, "relPosSphereZ");
+    }
+
+    // Per-contact arrays
+    DEME_TRACKED_RESERVE(idGeometryA, reservedContacts, "idGeometryA");
+    DEME_TRACKED_RESERVE(idGeometryB, reservedContacts, "idGeometryB");
+    DEME_TRACKED_RESERVE(contactType, reservedContacts, "contactType");
+    if (!solverFlags.useNoContactRecord) {
+        if (solverFlags.useForceRecordPolicy) {
+            DEME_TRACKED_RESERVE(fullRecordSlot, reservedContacts, "fullRecordSlot");
         }
-        for (unsigned int i = 0; i < simParams->nGeoWildcards; i++) {
-            DEME_TRACKED_RESIZE_FLOAT(sphereWildcards[i], nSpheresGM, 0);
-            DEME_TRACKED_RESIZE_FLOAT(analWildcards[i], nAnalGM, 0);
-            DEME_TRACKED_RESIZE_FLOAT(triWildcards[i], nTriGM, 0);
+        DEME_TRACKED_RESERVE(contactForces, reservedContacts, "contactForces");
+        if (solverFlags.useCompactContactStorage) {
+            DEME_TRACKED_RESERVE(compactTorque_convToForce, reservedContacts, "compactTorque_convToForce");
+            DEME_TRACKED_RESERVE(compactPointGeometryA, reservedContacts, "compactPointGeometryA");
+        } else {
+            DEME_TRACKED_RESERVE(contactTorque_convToForce, reservedContacts, "contactTorque_convToForce");
+            DEME_TRACKED_RESERVE(contactPointGeometryA, reservedContacts, "contactPointGeometryA");
         }
+        DEME_TRACKED_RESERVE(contactPointGeometryB, reservedContacts, "contactPointGeometryB");
     }
 
-    // You know what, let's not init dT buffers, since kT will change it when needed anyway. Besides, changing it here
-    // will cause problems in the case of a re-init-ed simulation with more clumps added to system, since we may
-    // accidentally clamp those arrays.
-    /*
-    // Transfer buffer arrays
-    // The following several arrays will have variable sizes, so here we only used an estimate.
-    // It is cudaMalloc-ed memory, not managed, because we want explicit locality control of buffers
-    buffer_size = DEME_MAX(buffer_size, nSpheresGM * DEME_INIT_CNT_MULTIPLIER);
-    DEME_DEVICE_PTR_ALLOC(granData->idGeometryA_buffer, buffer_size);
-    DEME_DEVICE_PTR_ALLOC(granData->idGeometryB_buffer, buffer_size);
-    DEME_DEVICE_PTR_ALLOC(granData->contactType_buffer, buffer_size);
-    // DEME_TRACKED_RESIZE_DEBUGPRINT(idGeometryA_buffer, nSpheresGM * DEME_INIT_CNT_MULTIPLIER, "idGeometryA_buffer",
-    // 0); DEME_TRACKED_RESIZE_DEBUGPRINT(idGeometryB_buffer, nSpheresGM * DEME_INIT_CNT_MULTIPLIER,
-    // "idGeometryB_buffer", 0); DEME_TRACKED_RESIZE_DEBUGPRINT(contactType_buffer, nSpheresGM *
-    // DEME_INIT_CNT_MULTIPLIER, "contactType_buffer", NOT_A_CONTACT);
-    // DEME_ADVISE_DEVICE(idGeometryA_buffer, streamInfo.device);
-    // DEME_ADVISE_DEVICE(idGeometryB_buffer, streamInfo.device);
-    // DEME_ADVISE_DEVICE(contactType_buffer, streamInfo.device);
-    if (!solverFlags.isHistoryless) {
-        // DEME_TRACKED_RESIZE_DEBUGPRINT(contactMapping_buffer, nSpheresGM * DEME_INIT_CNT_MULTIPLIER,
-        //                         "contactMapping_buffer", NULL_MAPPING_PARTNER);
-        // DEME_ADVISE_DEVICE(contactMapping_buffer, streamInfo.device);
-        DEME_DEVICE_PTR_ALLOC(granData->contactMapping_buffer, buffer_size);
+    // Wildcards (vectors of vectors, so their sizes are adjusted, like in DEME_TRACKED_RESIZE_FLOAT)
+    auto reserve_wildcards = [&](auto& wildcards, size_t num, size_t n, const char* name) {
+        wildcards.resize(num);
+        for (auto& arr : wildcards) {
+            size_t old_cap = arr.capacity();
+            if (n > old_cap) {
+                arr.reserve(n);
+                memRegistry.Adjust(name, (long long)sizeof(arr[0]) * ((long long)arr.capacity() - (long long)old_cap));
+            }
+        }
+    };
+    if (solverFlags.useBF16ContactWildcards) {
+        reserve_wildcards(contactWildcardsBF16, simParams->nContactWildcards, reservedContacts,
+                          "contactWildcardsBF16[i]");
+    } else {
+        reserve_wildcards(contactWildcards, simParams->nContactWildcards, reservedContacts, "contactWildcards[i]");
     }
-    */
+    reserve_wildcards(ownerWildcards, simParams->nOwnerWildcards, reservedOwners, "ownerWildcards[i]");
+    reserve_wildcards(sphereWildcards, simParams->nGeoWildcards, reservedSpheres, "sphereWildcards[i]");
 }
 
 void DEMDynamicThread::registerPolicies(const std::unordered_map<unsigned int, std::string>& template_number_name_map,
@@ -691,7 +867,7 @@ void DEMDynamicThread::populateEntityArrays(const std::vector<std::shared_ptr<DE
                 contactType.at(cnt_arr_offset) = SPHERE_SPHERE_CONTACT;  // Only sph--sph cnt for now
                 unsigned int w_num = 0;
                 for (const auto& w_name : m_contact_wildcard_names) {
-                    contactWildcards[w_num].at(cnt_arr_offset) = a_batch->contact_wildcards.at(w_name).at(jj);
+                    setContactWildcard(w_num, cnt_arr_offset, a_batch->contact_wildcards.at(w_name).at(jj));
                     w_num++;
                 }
                 cnt_arr_offset++;
@@ -974,6 +1150,7 @@ void DEMDynamicThread::updateClumpMeshArrays(const std::vector<std::shared_ptr<D
                                              const std::vector<unsigned int>& mesh_facet_owner,
                                              const std::vector<materialsOffset_t>& mesh_facet_materials,
                                              const std::vector<DEMTriangle>& mesh_facets,
+                                             const std::unordered_map<unsigned int, std::string>& template_num_name_map,
                                              const ClumpTemplateFlatten& clump_templates,
                                              const std::vector<float>& ext_obj_mass_types,
                                              const std::vector<float3>& ext_obj_moi_types,
@@ -991,7 +1168,12 @@ void DEMDynamicThread::updateClumpMeshArrays(const std::vector<std::shared_ptr<D
                                              size_t nExistingFacets,
                                              unsigned int nExistingObj,
                                              unsigned int nExistingAnalGM) {
-    // No policy changes here
+    // No policy changes here, but there may be new (flattened) clump templates. Existing templates keep their marks, so
+    // their volume info is re-written as is, and the new ones are appended.
+    templateNumNameMap = template_num_name_map;
+    for (unsigned int i = 0; i < clump_templates.volume.size(); i++) {
+        volumeOwnerBody.at(i) = clump_templates.volume.at(i);
+    }
 
     // Analytical objects-related arrays should be empty
     populateEntityArrays(input_clump_batches, input_ext_obj_xyz, input_ext_obj_rot, input_ext_obj_family,
@@ -1439,6 +1621,49 @@ inline bodyID_t DEMDynamicThread::getOwnerForContactB(const bodyID_t& geoB, cons
     }
 }
 
+inline bool DEMDynamicThread::isContactRecordedInFull(size_t i) const {
+    // The slots are those of the last force calculation, so they agree with what is recorded even if the user changed
+    // families since
+    return !solverFlags.useForceRecordPolicy || fullRecordSlot.at(i) != NULL_MAPPING_PARTNER;
+}
+
+inline size_t DEMDynamicThread::getFullRecordSlot(size_t i) const {
+    return solverFlags.useForceRecordPolicy ? fullRecordSlot.at(i) : i;
+}
+
+inline float3 DEMDynamicThread::getContactForce(size_t i) const {
+    return contactForces.at(getFullRecordSlot(i));
+}
+
+inline float3 DEMDynamicThread::getContactTorque(size_t i) const {
+    const size_t slot = getFullRecordSlot(i);
+    return solverFlags.useCompactContactStorage ? hostUnpackCompactFloat3(compactTorque_convToForce.at(slot))
+                                                : contactTorque_convToForce.at(slot);
+}
+
+inline float3 DEMDynamicThread::getContactPointA(size_t i) const {
+    const size_t slot = getFullRecordSlot(i);
+    return solverFlags.useCompactContactStorage ? hostUnpackCompactFloat3(compactPointGeometryA.at(slot))
+                                                : contactPointGeometryA.at(slot);
+}
+
+inline float3 DEMDynamicThread::getContactPointB(size_t i) const {
+    return contactPointGeometryB.at(getFullRecordSlot(i));
+}
+
+inline float DEMDynamicThread::getContactWildcard(unsigned int wc_num, size_t i) const {
+    return solverFlags.useBF16ContactWildcards ? hostUnpackBF16(contactWildcardsBF16[wc_num].at(i))
+                                               : contactWildcards[wc_num].at(i);
+}
+
+inline void DEMDynamicThread::setContactWildcard(unsigned int wc_num, size_t i, float val) {
+    if (solverFlags.useBF16ContactWildcards) {
+        contactWildcardsBF16[wc_num].at(i) = hostPackBF16(val);
+    } else {
+        contactWildcards[wc_num].at(i) = val;
+    }
+}
+
 void DEMDynamicThread::writeContactsAsCsv(std::ofstream& ptFile, float force_thres) const {
     std::ostringstream outstrstream;
 
@@ -1486,9 +1711,13 @@ void DEMDynamicThread::writeContactsAsCsv(std::ofstream& ptFile, float force_thr
         // We don't output fake contacts; but right now, no contact will be marked fake by kT, so no need to check that
         // if (type == NOT_A_CONTACT)
         //     continue;
+        // Contacts between families that are not recorded in full have nothing to output
+        if (!isContactRecordedInFull(i)) {
+            continue;
+        }
 
-        float3 forcexyz = contactForces.at(i);
-        float3 torque = contactTorque_convToForce.at(i);
+        float3 forcexyz = getContactForce(i);
+        float3 torque = getContactTorque(i);
         // If this force+torque is too small, then it's not an active contact
         if (length(forcexyz + torque) < force_thres) {
             continue;
@@ -1535,7 +1764,7 @@ void DEMDynamicThread::writeContactsAsCsv(std::ofstream& ptFile, float force_thr
             CoM.x += simParams->LBFX;
             CoM.y += simParams->LBFY;
             CoM.z += simParams->LBFZ;
-            cntPntA = contactPointGeometryA.at(i);
+            cntPntA = getContactPointA(i);
             cntPntALocal = cntPntA;
             hostApplyOriQToVector3(cntPntA.x, cntPntA.y, cntPntA.z, oriQA.w, oriQA.x, oriQA.y, oriQA.z);
             cntPntA += CoM;
@@ -1578,7 +1807,7 @@ void DEMDynamicThread::writeContactsAsCsv(std::ofstream& ptFile, float force_thr
             // The order shouldn't be an issue... the same set is being processed here and in equip_contact_wildcards,
             // see Model.h
             for (unsigned int j = 0; j < m_contact_wildcard_names.size(); j++) {
-                outstrstream << "," << contactWildcards[j][i];
+                outstrstream << "," << getContactWildcard(j, i);
             }
         }
 
@@ -1680,23 +1909,49 @@ inline void DEMDynamicThread::contactEventArraysResize(size_t nContactPairs) {
     DEME_TRACKED_RESIZE(idGeometryB, nContactPairs, 0);
     DEME_TRACKED_RESIZE(contactType, nContactPairs, NOT_A_CONTACT);
 
+    // With a force record policy, the record arrays are resized when the contacts recorded in full are counted
     if (!solverFlags.useNoContactRecord) {
-        DEME_TRACKED_RESIZE(contactForces, nContactPairs, make_float3(0));
-        DEME_TRACKED_RESIZE(contactTorque_convToForce, nContactPairs, make_float3(0));
-        DEME_TRACKED_RESIZE(contactPointGeometryA, nContactPairs, make_float3(0));
-        DEME_TRACKED_RESIZE(contactPointGeometryB, nContactPairs, make_float3(0));
+        if (solverFlags.useForceRecordPolicy) {
+            DEME_TRACKED_RESIZE(fullRecordSlot, nContactPairs, NULL_MAPPING_PARTNER);
+            granData->fullRecordSlot = fullRecordSlot.data();
+            fullRecordSlotsValid = false;
+        } else {
+            contactRecordArraysResize(nContactPairs);
+        }
     }
 
     // Re-pack pointers in case the arrays got reallocated
     granData->idGeometryA = idGeometryA.data();
     granData->idGeometryB = idGeometryB.data();
     granData->contactType = contactType.data();
+
+    // DEME_GPU_CALL(cudaStreamSynchronize(streamInfo.stream));
+}
+
+void DEMDynamicThread::contactRecordArraysResize(size_t nRecords) {
+    DEME_TRACKED_RESIZE(contactForces, nRecords, make_float3(0));
+    if (solverFlags.useCompactContactStorage) {
+        DEME_TRACKED_RESIZE(compactTorque_convToForce, nRecords, compactFloat3_t());
+        DEME_TRACKED_RESIZE(compactPointGeometryA, nRecords, compactFloat3_t());
+    } else {
+        DEME_TRACKED_RESIZE(contactTorque_convToForce, nRecords, make_float3(0));
+        DEME_TRACKED_RESIZE(contactPointGeometryA, nRecords, make_float3(0));
+    }
+    DEME_TRACKED_RESIZE(contactPointGeometryB, nRecords, make_float3(0));
+
     granData->contactForces = contactForces.data();
     granData->contactTorque_convToForce = contactTorque_convToForce.data();
     granData->contactPointGeometryA = contactPointGeometryA.data();
     granData->contactPointGeometryB = contactPointGeometryB.data();
+    granData->compactTorque_convToForce = compactTorque_convToForce.data();
+    granData->compactPointGeometryA = compactPointGeometryA.data();
+}
 
-    // DEME_GPU_CALL(cudaStreamSynchronize(streamInfo.stream));
+size_t DEMDynamicThread::fullRecordArraySize(size_t nContacts, bool withForceRecordPolicy) const {
+    if (!withForceRecordPolicy) {
+        return nContacts;
+    }
+    return (size_t)std::ceil(fullRecordRatio * nContacts);
 }
 
 inline void DEMDynamicThread::unpackMyBuffer() {
@@ -1752,8 +2007,15 @@ inline void DEMDynamicThread::sendToTheirBuffer() {
     DEME_GPU_CALL(cudaMemcpy(granData->pKTOwnedBuffer_absVel, pCycleMaxVel, simParams->nOwnerBodies * sizeof(float),
                              cudaMemcpyDeviceToDevice));
 
-    // Send simulation metrics for kT's reference.
-    DEME_GPU_CALL(cudaMemcpy(granData->pKTOwnedBuffer_ts, &(simParams->h), sizeof(float), cudaMemcpyDeviceToDevice));
+    // Send simulation metrics for kT's reference. With adaptive time stepping, kT must make the contact margin with the
+    // largest step size dT may take before the next contact list arrives.
+    if (solverFlags.isStepConst) {
+        DEME_GPU_CALL(
+            cudaMemcpy(granData->pKTOwnedBuffer_ts, &(simParams->h), sizeof(float), cudaMemcpyDeviceToDevice));
+    } else {
+        float marginTs = (float)stepController.GetStepForMargin();
+        DEME_GPU_CALL(cudaMemcpy(granData->pKTOwnedBuffer_ts, &marginTs, sizeof(float), cudaMemcpyHostToDevice));
+    }
     // Note that perhapsIdealFutureDrift is non-negative, and it will be used to determine the margin size; however, if
     // scheduleHelper is instructed to have negative future drift then perhapsIdealFutureDrift no longer affects them.
     DEME_GPU_CALL(cudaMemcpy(granData->pKTOwnedBuffer_maxDrift, &(granData->perhapsIdealFutureDrift),
@@ -1768,14 +2030,23 @@ inline void DEMDynamicThread::sendToTheirBuffer() {
 
     // May need to send updated mesh
     if (solverFlags.willMeshDeform) {
-        DEME_GPU_CALL(cudaMemcpy(granData->pKTOwnedBuffer_relPosNode1, granData->relPosNode1,
-                                 simParams->nTriGM * sizeof(float3), cudaMemcpyDeviceToDevice));
-        DEME_GPU_CALL(cudaMemcpy(granData->pKTOwnedBuffer_relPosNode2, granData->relPosNode2,
-                                 simParams->nTriGM * sizeof(float3), cudaMemcpyDeviceToDevice));
-        DEME_GPU_CALL(cudaMemcpy(granData->pKTOwnedBuffer_relPosNode3, granData->relPosNode3,
-                                 simParams->nTriGM * sizeof(float3), cudaMemcpyDeviceToDevice));
+        // Only the facets that were deformed are sent
+        for (const auto& range : meshDirtyRanges.Get()) {
+            const size_t n = range.second - range.first;
+            DEME_GPU_CALL(cudaMemcpy(granData->pKTOwnedBuffer_relPosNode1 + range.first,
+                                     granData->relPosNode1 + range.first, n * sizeof(float3),
+                                     cudaMemcpyDeviceToDevice));
+            DEME_GPU_CALL(cudaMemcpy(granData->pKTOwnedBuffer_relPosNode2 + range.first,
+                                     granData->relPosNode2 + range.first, n * sizeof(float3),
+                                     cudaMemcpyDeviceToDevice));
+            DEME_GPU_CALL(cudaMemcpy(granData->pKTOwnedBuffer_relPosNode3 + range.first,
+                                     granData->relPosNode3 + range.first, n * sizeof(float3),
+                                     cudaMemcpyDeviceToDevice));
+        }
         solverFlags.willMeshDeform = false;
         // kT can't be loading buffer when dT is sending, so it is safe
+        kT->meshDirtyRanges.Add(meshDirtyRanges);
+        meshDirtyRanges.Clear();
         kT->solverFlags.willMeshDeform = true;
     }
 
@@ -1814,7 +2085,7 @@ inline void DEMDynamicThread::migratePersistentContacts() {
                     .instantiate()
                     .configure(dim3(blocks_needed_for_rearrange), dim3(DEME_MAX_THREADS_PER_BLOCK), 0,
                                streamInfo.stream)
-                    .launch(granData->contactWildcards[simParams->nContactWildcards - 1], contactSentry,
+                    .launch(granData, simParams->nContactWildcards - 1, contactSentry,
                             *stateOfSolver_resources.pNumPrevContacts);
                 DEME_GPU_CALL(cudaStreamSynchronize(streamInfo.stream));
             }
@@ -1853,8 +2124,11 @@ inline void DEMDynamicThread::migratePersistentContacts() {
                 DEME_STEP_DEBUG_EXEC(
                     displayArray<bodyID_t>(granData->idGeometryB, *stateOfSolver_resources.pNumContacts));
                 DEME_STEP_DEBUG_PRINTF("Old version of the last contact wildcard:");
-                DEME_STEP_DEBUG_EXEC(displayArray<float>(granData->contactWildcards[simParams->nContactWildcards - 1],
-                                                         *stateOfSolver_resources.pNumPrevContacts));
+                if (!solverFlags.useBF16ContactWildcards) {
+                    DEME_STEP_DEBUG_EXEC(displayArray<float>(
+                        granData->contactWildcards[simParams->nContactWildcards - 1],
+                        *stateOfSolver_resources.pNumPrevContacts));
+                }
                 DEME_STEP_DEBUG_PRINTF("Old--new mapping:");
                 DEME_STEP_DEBUG_EXEC(
                     displayArray<contactPairs_t>(granData->contactMapping, *stateOfSolver_resources.pNumContacts));
@@ -1866,6 +2140,25 @@ inline void DEMDynamicThread::migratePersistentContacts() {
     }
 
     // Copy new history back to history array (after resizing the `main' history array)
+    if (solverFlags.useBF16ContactWildcards) {
+        // The history was rearranged as floats, and is rounded back to bfloat16 (exactly, as it came from bfloat16)
+        if (*stateOfSolver_resources.pNumContacts > contactWildcardsBF16[0].size()) {
+            for (unsigned int i = 0; i < simParams->nContactWildcards; i++) {
+                DEME_TRACKED_RESIZE_DEBUGPRINT(contactWildcardsBF16[i], *stateOfSolver_resources.pNumContacts,
+                                               "contactWildcardsBF16[i]", 0);
+                granData->contactWildcardsBF16[i] = contactWildcardsBF16[i].data();
+            }
+        }
+        if (blocks_needed_for_rearrange > 0) {
+            prep_force_kernels->kernel("storeRearrangedContactWildcards")
+                .instantiate()
+                .configure(dim3(blocks_needed_for_rearrange), dim3(DEME_MAX_THREADS_PER_BLOCK), 0, streamInfo.stream)
+                .launch(granData, newWildcards[0], simParams->nContactWildcards,
+                        *stateOfSolver_resources.pNumContacts);
+            DEME_GPU_CALL(cudaStreamSynchronize(streamInfo.stream));
+        }
+        return;
+    }
     if (*stateOfSolver_resources.pNumContacts > contactWildcards[0].size()) {
         for (unsigned int i = 0; i < simParams->nContactWildcards; i++) {
             DEME_TRACKED_RESIZE_FLOAT(contactWildcards[i], *stateOfSolver_resources.pNumContacts, 0);
@@ -1882,10 +2175,18 @@ inline void DEMDynamicThread::calculateForces() {
     // Reset force (acceleration) arrays for this time step
     size_t nContactPairs = *stateOfSolver_resources.pNumContacts;
 
-    timers.GetTimer("Clear force array").start();
+    // With a force record policy, only the contacts recorded in full have a place in the record arrays
+    size_t nRecords = nContactPairs;
+    if (solverFlags.useForceRecordPolicy && !solverFlags.useNoContactRecord) {
+        if (!fullRecordSlotsValid || contactPairArr_isFresh || solverFlags.canFamilyChange) {
+            findFullRecordContacts();
+        }
+        nRecords = nFullRecordContacts;
+    }
+
+    timers.Start(DT_CLEAR_FORCE_ARRAY);
     {
-        size_t blocks_needed_for_force_prep =
-            (nContactPairs + DEME_MAX_THREADS_PER_BLOCK - 1) / DEME_MAX_THREADS_PER_BLOCK;
+        size_t blocks_needed_for_force_prep = (nRecords + DEME_MAX_THREADS_PER_BLOCK - 1) / DEME_MAX_THREADS_PER_BLOCK;
         size_t blocks_needed_for_acc_prep =
             (simParams->nOwnerBodies + DEME_MAX_THREADS_PER_BLOCK - 1) / DEME_MAX_THREADS_PER_BLOCK;
 
@@ -1893,18 +2194,43 @@ inline void DEMDynamicThread::calculateForces() {
             .instantiate()
             .configure(dim3(blocks_needed_for_acc_prep), dim3(DEME_MAX_THREADS_PER_BLOCK), 0, streamInfo.stream)
             .launch(simParams, granData);
+        if (solverFlags.useOwnerCntAggregates) {
+            prep_force_kernels->kernel("prepareOwnerCntAggregates")
+                .instantiate()
+                .configure(dim3(blocks_needed_for_acc_prep), dim3(DEME_MAX_THREADS_PER_BLOCK), 0, streamInfo.stream)
+                .launch(simParams, granData);
+        }
 
         // prepareForceArrays needs to clear contact force arrays, only if the user asks us to record contact forces.
         // So...
-        if (!solverFlags.useNoContactRecord) {
+        if (!solverFlags.useNoContactRecord && blocks_needed_for_force_prep > 0) {
             prep_force_kernels->kernel("prepareForceArrays")
                 .instantiate()
                 .configure(dim3(blocks_needed_for_force_prep), dim3(DEME_MAX_THREADS_PER_BLOCK), 0, streamInfo.stream)
-                .launch(simParams, granData, nContactPairs);
+                .launch(simParams, granData, nRecords);
         }
         DEME_GPU_CALL(cudaStreamSynchronize(streamInfo.stream));
     }
-    timers.GetTimer("Clear force array").stop();
+    timers.Stop(DT_CLEAR_FORCE_ARRAY);
+
+    // With subcycling, find the subcycled contacts and owners, and keep the owners' non-contact accelerations for the
+    // later substeps
+    if (simParams->nSubsteps > 1) {
+        if (!subcycledListsValid || contactPairArr_isFresh || solverFlags.canFamilyChange) {
+            findSubcycledContactsAndOwners();
+        }
+        size_t nSubcycledOwners = subcycledOwnerIDs.size();
+        if (nSubcycledOwners > 0) {
+            size_t blocks_needed_for_owners =
+                (nSubcycledOwners + DEME_MAX_THREADS_PER_BLOCK - 1) / DEME_MAX_THREADS_PER_BLOCK;
+            prep_force_kernels->kernel("stashSubcycledOwnerAcc")
+                .instantiate()
+                .configure(dim3(blocks_needed_for_owners), dim3(DEME_MAX_THREADS_PER_BLOCK), 0, streamInfo.stream)
+                .launch(granData, subcycledOwnerIDs.data(), subcycledOwnerAcc.data(), subcycledOwnerAngAcc.data(),
+                        nSubcycledOwners);
+            DEME_GPU_CALL(cudaStreamSynchronize(streamInfo.stream));
+        }
+    }
 
     //// TODO: is there a better way??? Like memset?
     // DEME_GPU_CALL(cudaMemset(granData->contactForces, zeros, nContactPairs * sizeof(float3)));
@@ -1926,24 +2252,45 @@ inline void DEMDynamicThread::calculateForces() {
     // If no contact then we don't have to calculate forces. Note there might still be forces, coming from prescription
     // or other sources.
     if (blocks_needed_for_contacts > 0) {
-        timers.GetTimer("Calculate contact forces").start();
-        // a custom kernel to compute forces
-        cal_force_kernels->kernel("calculateContactForces")
-            .instantiate()
-            .configure(dim3(blocks_needed_for_contacts), dim3(DT_FORCE_CALC_NTHREADS_PER_BLOCK), 0, streamInfo.stream)
-            .launch(simParams, granData, nContactPairs);
-        DEME_GPU_CALL(cudaStreamSynchronize(streamInfo.stream));
+        timers.Start(DT_CALC_CONTACT_FORCES);
+        if (solverFlags.useTypeSpecializedForceCalc && contactPairArr_isFresh) {
+            findContactTypeRuns();
+        }
+        if (solverFlags.useTypeSpecializedForceCalc && contactTypeRunsUsable) {
+            calculateContactForcesByType();
+        } else {
+            // a custom kernel to compute forces
+            cal_force_kernels->kernel("calculateContactForces")
+                .instantiate()
+                .configure(dim3(blocks_needed_for_contacts), dim3(DT_FORCE_CALC_NTHREADS_PER_BLOCK), 0,
+                           streamInfo.stream)
+                .launch(simParams, granData, nContactPairs);
+            DEME_GPU_CALL(cudaStreamSynchronize(streamInfo.stream));
+        }
+        // The contacts that involve subcycled families were skipped above, and are calculated for the first substep
+        if (simParams->nSubsteps > 1) {
+            calculateSubcycledContactForces();
+        }
         // displayFloat3(granData->contactForces, nContactPairs);
         // displayArray<contact_t>(granData->contactType, nContactPairs);
         // std::cout << "===========================" << std::endl;
-        timers.GetTimer("Calculate contact forces").stop();
+        timers.Stop(DT_CALC_CONTACT_FORCES);
 
         if (!solverFlags.useForceCollectInPlace) {
-            timers.GetTimer("Collect contact forces").start();
+            timers.Start(DT_COLLECT_CONTACT_FORCES);
             // Reflect those body-wise forces on their owner clumps
             if (solverFlags.useCubForceCollect) {
                 collectContactForcesThruCub(collect_force_kernels, granData, nContactPairs, simParams->nOwnerBodies,
                                             contactPairArr_isFresh, streamInfo.stream, stateOfSolver_resources, timers);
+            } else if (solverFlags.useCompactForceCollect) {
+                blocks_needed_for_contacts = (nContactPairs + DEME_COMPACT_COLLECT_NTHREADS_PER_BLOCK - 1) /
+                                             DEME_COMPACT_COLLECT_NTHREADS_PER_BLOCK;
+                collect_force_kernels->kernel("forceToAccOwnerBlocked")
+                    .instantiate()
+                    .configure(dim3(blocks_needed_for_contacts), dim3(DEME_COMPACT_COLLECT_NTHREADS_PER_BLOCK), 0,
+                               streamInfo.stream)
+                    .launch(granData, nContactPairs);
+                DEME_GPU_CALL(cudaStreamSynchronize(streamInfo.stream));
             } else {
                 blocks_needed_for_contacts =
                     (nContactPairs + DEME_MAX_THREADS_PER_BLOCK - 1) / DEME_MAX_THREADS_PER_BLOCK;
@@ -1957,7 +2304,7 @@ inline void DEMDynamicThread::calculateForces() {
             // displayArray<float>(granData->aZ, simParams->nOwnerBodies);
             // displayFloat3(granData->contactForces, nContactPairs);
             // std::cout << nContactPairs << std::endl;
-            timers.GetTimer("Collect contact forces").stop();
+            timers.Stop(DT_COLLECT_CONTACT_FORCES);
         }
     }
 }
@@ -1965,13 +2312,230 @@ inline void DEMDynamicThread::calculateForces() {
 inline void DEMDynamicThread::integrateOwnerMotions() {
     size_t blocks_needed_for_clumps =
         (simParams->nOwnerBodies + DEME_NUM_BODIES_PER_BLOCK - 1) / DEME_NUM_BODIES_PER_BLOCK;
+    // With subcycling, the flagged owners take the first of their substeps in this step
+    const notStupidBool_t* ownerSubcycled = (simParams->nSubsteps > 1) ? subcycledOwnerFlags.data() : nullptr;
     integrator_kernels->kernel("integrateOwners")
         .instantiate()
         .configure(dim3(blocks_needed_for_clumps), dim3(DEME_NUM_BODIES_PER_BLOCK), 0, streamInfo.stream)
-        .launch(simParams, granData);
+        .launch(simParams, granData, ownerSubcycled);
+    DEME_GPU_CALL(cudaStreamSynchronize(streamInfo.stream));
+}
+
+inline void DEMDynamicThread::findContactTypeRuns() {
+    size_t nContactPairs = *stateOfSolver_resources.pNumContacts;
+    contactTypeRunTypes.clear();
+    contactTypeRunStarts.clear();
+    contactTypeRunCounts.clear();
+    contactTypeRunsUsable = false;
+    if (nContactPairs == 0) {
+        return;
+    }
+    contact_t* runTypes =
+        (contact_t*)stateOfSolver_resources.allocateTempVector(1, nContactPairs * sizeof(contact_t));
+    contactPairs_t* runCounts =
+        (contactPairs_t*)stateOfSolver_resources.allocateTempVector(2, nContactPairs * sizeof(contactPairs_t));
+    size_t* numRuns = (size_t*)stateOfSolver_resources.allocateTempVector(3, sizeof(size_t));
+    contactTypeRunLengthEncode(granData->contactType, runTypes, runCounts, numRuns, nContactPairs, streamInfo.stream,
+                               stateOfSolver_resources);
+    // Temp vectors are managed, so the runs can be read on host directly
+    size_t nRuns = *numRuns;
+    contactPairs_t start = 0;
+    for (size_t i = 0; i < nRuns; i++) {
+        // A type appearing in more than one run means the array is not sorted by type (such as when the contacts are
+        // loaded by the user and kT did not sort them), and we just use the generic kernel
+        if (i > 0 && runTypes[i] <= runTypes[i - 1]) {
+            contactTypeRunTypes.clear();
+            contactTypeRunStarts.clear();
+            contactTypeRunCounts.clear();
+            DEME_DEBUG_PRINTF("Contact array is not sorted by type; using the generic force kernel");
+            return;
+        }
+        contactTypeRunTypes.push_back(runTypes[i]);
+        contactTypeRunStarts.push_back(start);
+        contactTypeRunCounts.push_back(runCounts[i]);
+        start += runCounts[i];
+    }
+    contactTypeRunsUsable = true;
+}
+
+inline void DEMDynamicThread::calculateContactForcesByType() {
+    for (size_t i = 0; i < contactTypeRunTypes.size(); i++) {
+        contact_t type = contactTypeRunTypes[i];
+        size_t start = contactTypeRunStarts[i];
+        size_t n = contactTypeRunCounts[i];
+        // Only the common types get their own kernels; the rest (such as non-contacts, which kT may leave at the end
+        // of the array) go through the generic path, which reads the types from the array
+        switch (type) {
+            case (SPHERE_SPHERE_CONTACT):
+            case (SPHERE_MESH_CONTACT):
+            case (SPHERE_PLANE_CONTACT):
+            case (SPHERE_PLATE_CONTACT):
+            case (SPHERE_CYL_CONTACT):
+                break;
+            default:
+                type = NOT_A_CONTACT;
+        }
+        size_t blocks_needed = (n + DT_FORCE_CALC_NTHREADS_PER_BLOCK - 1) / DT_FORCE_CALC_NTHREADS_PER_BLOCK;
+        cal_force_kernels->kernel("calculateContactForcesOfType")
+            .instantiate(std::vector<std::string>{std::to_string(type)})
+            .configure(dim3(blocks_needed), dim3(DT_FORCE_CALC_NTHREADS_PER_BLOCK), 0, streamInfo.stream)
+            .launch(simParams, granData, start, n);
+    }
     DEME_GPU_CALL(cudaStreamSynchronize(streamInfo.stream));
 }
 
+inline void DEMDynamicThread::findFullRecordContacts() {
+    size_t nContactPairs = *stateOfSolver_resources.pNumContacts;
+    nFullRecordContacts = 0;
+    if (nContactPairs > 0) {
+        notStupidBool_t* isFullRecord = (notStupidBool_t*)stateOfSolver_resources.allocateTempVector(
+            1, nContactPairs * sizeof(notStupidBool_t));
+        size_t blocks_needed_for_contacts =
+            (nContactPairs + DEME_MAX_THREADS_PER_BLOCK - 1) / DEME_MAX_THREADS_PER_BLOCK;
+        cal_force_kernels->kernel("markFullRecordContacts")
+            .instantiate()
+            .configure(dim3(blocks_needed_for_contacts), dim3(DEME_MAX_THREADS_PER_BLOCK), 0, streamInfo.stream)
+            .launch(granData, isFullRecord, nContactPairs);
+        DEME_GPU_CALL(cudaStreamSynchronize(streamInfo.stream));
+        // The scan gives each contact recorded in full its place in the record arrays
+        contactFlagPrefixScan(isFullRecord, granData->fullRecordSlot, nContactPairs, streamInfo.stream,
+                              stateOfSolver_resources);
+        notStupidBool_t lastFlag;
+        DEME_GPU_CALL(
+            cudaMemcpy(&lastFlag, isFullRecord + nContactPairs - 1, sizeof(notStupidBool_t), cudaMemcpyDeviceToHost));
+        nFullRecordContacts = (size_t)fullRecordSlot[nContactPairs - 1] + lastFlag;
+        // The others get NULL_MAPPING_PARTNER, so nothing is written for them
+        cal_force_kernels->kernel("nullifyPartialRecordSlots")
+            .instantiate()
+            .configure(dim3(blocks_needed_for_contacts), dim3(DEME_MAX_THREADS_PER_BLOCK), 0, streamInfo.stream)
+            .launch(granData, isFullRecord, nContactPairs);
+        DEME_GPU_CALL(cudaStreamSynchronize(streamInfo.stream));
+        fullRecordRatio = (double)nFullRecordContacts / nContactPairs;
+    }
+    contactRecordArraysResize(nFullRecordContacts);
+    fullRecordSlotsValid = true;
+    DEME_DEBUG_PRINTF("%zu of %zu contacts are recorded in full", nFullRecordContacts, nContactPairs);
+}
+
+inline void DEMDynamicThread::findSubcycledContactsAndOwners() {
+    size_t nContactPairs = *stateOfSolver_resources.pNumContacts;
+    size_t nOwners = simParams->nOwnerBodies;
+    // The selected IDs go to a temp vector, then are copied to the lists (usually much shorter)
+    size_t* numSelected = (size_t*)stateOfSolver_resources.allocateTempVector(3, sizeof(size_t));
+    {
+        DEME_TRACKED_RESIZE(subcycledOwnerFlags, nOwners, 0);
+        notStupidBool_t* isSubcycled = subcycledOwnerFlags.data();
+        bodyID_t* selected = (bodyID_t*)stateOfSolver_resources.allocateTempVector(2, nOwners * sizeof(bodyID_t));
+        size_t blocks_needed_for_owners = (nOwners + DEME_MAX_THREADS_PER_BLOCK - 1) / DEME_MAX_THREADS_PER_BLOCK;
+        *numSelected = 0;
+        if (blocks_needed_for_owners > 0) {
+            prep_force_kernels->kernel("markSubcycledOwners")
+                .instantiate()
+                .configure(dim3(blocks_needed_for_owners), dim3(DEME_MAX_THREADS_PER_BLOCK), 0, streamInfo.stream)
+                .launch(simParams, granData, isSubcycled);
+            DEME_GPU_CALL(cudaStreamSynchronize(streamInfo.stream));
+            ownerIDSelectFlagged(isSubcycled, selected, numSelected, nOwners, streamInfo.stream,
+                                 stateOfSolver_resources);
+        }
+        DEME_TRACKED_RESIZE(subcycledOwnerIDs, *numSelected, 0);
+        DEME_TRACKED_RESIZE(subcycledOwnerAcc, *numSelected, make_float3(0, 0, 0));
+        DEME_TRACKED_RESIZE(subcycledOwnerAngAcc, *numSelected, make_float3(0, 0, 0));
+        DEME_GPU_CALL(cudaMemcpy(subcycledOwnerIDs.data(), selected, *numSelected * sizeof(bodyID_t),
+                                 cudaMemcpyDeviceToDevice));
+    }
+    {
+        notStupidBool_t* isSubcycled = (notStupidBool_t*)stateOfSolver_resources.allocateTempVector(
+            1, nContactPairs * sizeof(notStupidBool_t));
+        contactPairs_t* selected =
+            (contactPairs_t*)stateOfSolver_resources.allocateTempVector(2, nContactPairs * sizeof(contactPairs_t));
+        size_t blocks_needed_for_contacts =
+            (nContactPairs + DEME_MAX_THREADS_PER_BLOCK - 1) / DEME_MAX_THREADS_PER_BLOCK;
+        *numSelected = 0;
+        if (blocks_needed_for_contacts > 0) {
+            collect_force_kernels->kernel("markSubcycledContacts")
+                .instantiate()
+                .configure(dim3(blocks_needed_for_contacts), dim3(DEME_MAX_THREADS_PER_BLOCK), 0, streamInfo.stream)
+                .launch(granData, isSubcycled, nContactPairs);
+            DEME_GPU_CALL(cudaStreamSynchronize(streamInfo.stream));
+            contactIDSelectFlagged(isSubcycled, selected, numSelected, nContactPairs, streamInfo.stream,
+                                   stateOfSolver_resources);
+        }
+        DEME_TRACKED_RESIZE(subcycledContactIDs, *numSelected, 0);
+        DEME_GPU_CALL(cudaMemcpy(subcycledContactIDs.data(), selected, *numSelected * sizeof(contactPairs_t),
+                                 cudaMemcpyDeviceToDevice));
+    }
+    subcycledListsValid = true;
+    DEME_DEBUG_PRINTF("%zu owners and %zu contacts are subcycled", subcycledOwnerIDs.size(),
+                      subcycledContactIDs.size());
+}
+
+inline void DEMDynamicThread::calculateSubcycledContactForces() {
+    size_t nSubcycledContacts = subcycledContactIDs.size();
+    if (nSubcycledContacts == 0) {
+        return;
+    }
+    // The force model sees the substep size as ts
+    const float h = simParams->h;
+    simParams->h = h / simParams->nSubsteps;
+    size_t blocks_needed_for_contacts =
+        (nSubcycledContacts + DT_FORCE_CALC_NTHREADS_PER_BLOCK - 1) / DT_FORCE_CALC_NTHREADS_PER_BLOCK;
+    cal_force_kernels->kernel("calculateSubcycledContactForces")
+        .instantiate()
+        .configure(dim3(blocks_needed_for_contacts), dim3(DT_FORCE_CALC_NTHREADS_PER_BLOCK), 0, streamInfo.stream)
+        .launch(simParams, granData, subcycledContactIDs.data(), nSubcycledContacts);
+    DEME_GPU_CALL(cudaStreamSynchronize(streamInfo.stream));
+    simParams->h = h;
+}
+
+inline void DEMDynamicThread::takeSubsteps() {
+    size_t nSubcycledOwners = subcycledOwnerIDs.size();
+    size_t nSubcycledContacts = subcycledContactIDs.size();
+    if (nSubcycledOwners == 0) {
+        return;
+    }
+    size_t blocks_needed_for_owners = (nSubcycledOwners + DEME_MAX_THREADS_PER_BLOCK - 1) / DEME_MAX_THREADS_PER_BLOCK;
+    size_t blocks_needed_for_contacts =
+        (nSubcycledContacts + DEME_MAX_THREADS_PER_BLOCK - 1) / DEME_MAX_THREADS_PER_BLOCK;
+    // The other owners stay where they are at the end of this step, and their contact forces on the subcycled owners
+    // are re-calculated from there in each substep
+    const float h = simParams->h;
+    const double t = simParams->timeElapsed;
+    for (unsigned int i = 1; i < simParams->nSubsteps; i++) {
+        // Each substep starts from the non-contact accelerations, then gets the contact forces of this substep
+        prep_force_kernels->kernel("restoreSubcycledOwnerAcc")
+            .instantiate()
+            .configure(dim3(blocks_needed_for_owners), dim3(DEME_MAX_THREADS_PER_BLOCK), 0, streamInfo.stream)
+            .launch(granData, subcycledOwnerIDs.data(), subcycledOwnerAcc.data(), subcycledOwnerAngAcc.data(),
+                    nSubcycledOwners);
+        DEME_GPU_CALL(cudaStreamSynchronize(streamInfo.stream));
+        simParams->timeElapsed = t + (double)i * (double)h / simParams->nSubsteps;
+        if (nSubcycledContacts > 0) {
+            timers.Start(DT_CALC_CONTACT_FORCES);
+            calculateSubcycledContactForces();
+            timers.Stop(DT_CALC_CONTACT_FORCES);
+
+            timers.Start(DT_COLLECT_CONTACT_FORCES);
+            collect_force_kernels->kernel("subcycledForceToAcc")
+                .instantiate()
+                .configure(dim3(blocks_needed_for_contacts), dim3(DEME_MAX_THREADS_PER_BLOCK), 0, streamInfo.stream)
+                .launch(granData, subcycledOwnerFlags.data(), subcycledContactIDs.data(), nSubcycledContacts);
+            DEME_GPU_CALL(cudaStreamSynchronize(streamInfo.stream));
+            timers.Stop(DT_COLLECT_CONTACT_FORCES);
+        }
+
+        timers.Start(DT_INTEGRATION);
+        simParams->h = h / simParams->nSubsteps;
+        integrator_kernels->kernel("integrateSubcycledOwners")
+            .instantiate()
+            .configure(dim3(blocks_needed_for_owners), dim3(DEME_MAX_THREADS_PER_BLOCK), 0, streamInfo.stream)
+            .launch(simParams, granData, subcycledOwnerIDs.data(), nSubcycledOwners);
+        DEME_GPU_CALL(cudaStreamSynchronize(streamInfo.stream));
+        simParams->h = h;
+        timers.Stop(DT_INTEGRATION);
+    }
+    simParams->timeElapsed = t;
+}
+
 inline void DEMDynamicThread::routineChecks() {
     if (solverFlags.canFamilyChange) {
         size_t blocks_needed_for_clumps =
@@ -1988,6 +2552,17 @@ inline float* DEMDynamicThread::determineSysVel() {
     return approxMaxVelFunc->dT_GetValue();
 }
 
+inline void DEMDynamicThread::adaptStepSize() {
+    // pCycleMaxVel lives in temp vector 1, and is still to be sent to kT
+    float* maxVel = (float*)stateOfSolver_resources.allocateTempVector(3, sizeof(float));
+    floatMaxReduce(pCycleMaxVel, maxVel, simParams->nOwnerBodies, streamInfo.stream, stateOfSolver_resources);
+    float maxOverlapRatio = granData->maxOverlapRatio;
+    granData->maxOverlapRatio = 0;
+    simParams->h = (float)stepController.Update(*maxVel, maxOverlapRatio);
+    DEME_DEBUG_PRINTF("Max velocity %.6g and max overlap ratio %.6g give step size %.6g", *maxVel, maxOverlapRatio,
+                      simParams->h);
+}
+
 inline void DEMDynamicThread::unpack_impl() {
     {
         // Acquire lock and use the content of the dynamic-owned transfer buffer
@@ -2000,8 +2575,9 @@ inline void DEMDynamicThread::unpack_impl() {
     // dT got the produce, now mark its buffer to be no longer fresh.
     pSchedSupport->dynamicOwned_Prod2ConsBuffer_isFresh = false;
     // Used for inspecting on average how stale kT's produce is.
-    pSchedSupport->schedulingStats.accumKinematicLagSteps +=
+    latestKinematicLagSteps =
         (pSchedSupport->currentStampOfDynamic).load() - (pSchedSupport->stampLastDynamicUpdateProdDate).load();
+    pSchedSupport->schedulingStats.accumKinematicLagSteps += latestKinematicLagSteps;
     // dT needs to know how fresh the contact pair info is, and that is determined by when kT received this batch of
     // ingredients.
     pSchedSupport->stampLastDynamicUpdateProdDate = (pSchedSupport->kinematicIngredProdDateStamp).load();
@@ -2023,6 +2599,10 @@ inline void DEMDynamicThread::calibrateParams() {
     // Unpacking is done; now we can use temp arrays again to derive max velocity and send to kT
     pCycleMaxVel = determineSysVel();
 
+    if (!solverFlags.isStepConst) {
+        adaptStepSize();
+    }
+
     if (solverFlags.autoUpdateFreq) {
         unsigned int comfortable_drift;
         if (accumStepUpdater.Query(comfortable_drift)) {
@@ -2045,14 +2625,19 @@ inline void DEMDynamicThread::calibrateParams() {
 
 inline void DEMDynamicThread::ifProduceFreshThenUseItAndSendNewOrder() {
     if (pSchedSupport->dynamicOwned_Prod2ConsBuffer_isFresh) {
-        timers.GetTimer("Unpack updates from kT").start();
+        timers.Start(DT_UNPACK_FROM_KT);
         unpack_impl();
-        timers.GetTimer("Unpack updates from kT").stop();
+        timers.Stop(DT_UNPACK_FROM_KT);
+        // kT is idle until it gets the new order below, so this is when its states can be sampled
+        if (metricsEnabled)
+            recordMetrics(true);
 
-        timers.GetTimer("Send to kT buffer").start();
+        timers.Start(DT_SEND_TO_KT);
         // Acquire lock and refresh the work order for the kinematic
         {
+            timers.Start(DT_CALIBRATE_PARAMS);
             calibrateParams();
+            timers.Stop(DT_CALIBRATE_PARAMS);
             std::lock_guard<std::mutex> lock(pSchedSupport->kinematicOwnedBuffer_AccessCoordination);
             sendToTheirBuffer();
         }
@@ -2060,7 +2645,7 @@ inline void DEMDynamicThread::ifProduceFreshThenUseItAndSendNewOrder() {
         pSchedSupport->schedulingStats.nKinematicUpdates++;
         accumStepUpdater.AddUpdate();
 
-        timers.GetTimer("Send to kT buffer").stop();
+        timers.Stop(DT_SEND_TO_KT);
         // Signal the kinematic that it has data for a new work order
         pSchedSupport->cv_KinematicCanProceed.notify_all();
     }
@@ -2085,6 +2670,11 @@ void DEMDynamicThread::workerThread() {
             }
         }
 
+        // The user may have changed owners' families since the last call, so the subcycled lists and the full record
+        // slots are rebuilt
+        subcycledListsValid = false;
+        fullRecordSlotsValid = false;
+
         // There is only 2 situations where dT needs to wait for kT to provide one initial CD result...
         // Those are the `new-boot after previous sync' case, or the user significantly changed the simulation
         // environment; in any other situations, dT does not have `drift-into-future-too-much' problem here, b/c if it
@@ -2151,7 +2741,7 @@ void DEMDynamicThread::workerThread() {
             // Check if we need to wait; i.e., if dynamic drifted too much into future, then we must wait a bit before
             // the next cycle begins
             if (pSchedSupport->dynamicShouldWait()) {
-                timers.GetTimer("Wait for kT update").start();
+                timers.Start(DT_WAIT_FOR_KT);
                 // Wait for a signal from kT to indicate that kT has caught up
                 std::unique_lock<std::mutex> lock(pSchedSupport->dynamicCanProceed);
                 while (!pSchedSupport->dynamicOwned_Prod2ConsBuffer_isFresh) {
@@ -2162,7 +2752,7 @@ void DEMDynamicThread::workerThread() {
                 // If dT waits, it is penalized, since waiting means double-wait, very bad.
                 if (solverFlags.autoUpdateFreq)
                     granData->perhapsIdealFutureDrift += FUTURE_DRIFT_TWEAK_STEP_SIZE;
-                timers.GetTimer("Wait for kT update").stop();
+                timers.Stop(DT_WAIT_FOR_KT);
             }
             // NOTE: This ShouldWait check should follow the ifProduceFreshThenUseItAndSendNewOrder call. Because we
             // need to avoid a scenario where dT is waiting here, and kT is also chilling waiting for an update. But
@@ -2171,19 +2761,22 @@ void DEMDynamicThread::workerThread() {
             // dynamicOwned_Prod2ConsBuffer_isFresh is false so ifProduceFreshThenUseItAndSendNewOrder didn't run, then
             // kT has to be in the process of doing a CD, we still will not be locked here.
 
-            // If using variable ts size, only when a step is accepted can we move on
-            bool step_accepted = false;
-            do {
-                calculateForces();
+            // With adaptive time stepping, the step size only changes at kT updates (in calibrateParams), and the
+            // steps are never rejected, as the step size is picked ahead of the step
+            calculateForces();
 
-                routineChecks();
+            timers.Start(DT_ROUTINE_CHECKS);
+            routineChecks();
+            timers.Stop(DT_ROUTINE_CHECKS);
 
-                timers.GetTimer("Integration").start();
-                integrateOwnerMotions();
-                timers.GetTimer("Integration").stop();
+            timers.Start(DT_INTEGRATION);
+            integrateOwnerMotions();
+            timers.Stop(DT_INTEGRATION);
 
-                step_accepted = true;
-            } while ((!solverFlags.isStepConst) || (!step_accepted));
+            // Owners in subcycled families take the rest of their substeps
+            if (simParams->nSubsteps > 1) {
+                takeSubsteps();
+            }
 
             // CalculateForces is done, set contactPairArr_isFresh to false
             // This will be set to true next time it receives an update from kT
@@ -2199,8 +2792,10 @@ void DEMDynamicThread::workerThread() {
             nTotalSteps++;
             accumStepUpdater.AddStep();
 
-            //// TODO: make changes for variable time step size cases
             simParams->timeElapsed += (double)simParams->h;
+
+            if (metricsEnabled && metricsSampleEvery > 0 && nTotalSteps % metricsSampleEvery == 0)
+                recordMetrics(false);
         }
 
         // Unless the user did something critical, must we wait for a kT update before next step
@@ -2215,11 +2810,35 @@ void DEMDynamicThread::workerThread() {
     }
 }
 
-void DEMDynamicThread::getTiming(std::vector<std::string>& names, std::vector<double>& vals) {
-    names = timer_names;
-    for (const auto& name : timer_names) {
-        vals.push_back(timers.GetTimer(name).GetTimeSeconds());
+void DEMDynamicThread::recordMetrics(bool at_kT_update) {
+    SolverMetrics& rec = latestMetrics;
+    if (at_kT_update) {
+        rec.nContacts = *stateOfSolver_resources.pNumContacts;
+        rec.avgCntsPerSphere = kT->stateParams.avgCntsPerSphere;
+        rec.maxVel = kT->granData->maxVel;
+        rec.binSize = kT->simParams->binSize;
+        rec.numBins = kT->stateParams.numBins;
+        rec.maxSphFoundInBin = kT->stateParams.maxSphFoundInBin;
+        rec.maxTriFoundInBin = kT->stateParams.maxTriFoundInBin;
+        rec.kTLagSteps = latestKinematicLagSteps;
     }
+    rec.nSleepingOwners = getNumSleepingOwners();
+    rec.stepSize = simParams->h;
+    rec.isKTUpdate = at_kT_update ? 1 : 0;
+    rec.time = simParams->timeElapsed;
+    rec.step = nTotalSteps;
+    rec.currentDrift = granData->perhapsIdealFutureDrift;
+    rec.maxDrift = solverFlags.upperBoundFutureDrift;
+    // The wait timer may have been reset by the user since the last sample
+    double wait_total = timers.GetTimer(DT_WAIT_FOR_KT).GetTimeSeconds();
+    rec.dTWaitSeconds =
+        (wait_total >= metricsAccountedWaitSeconds) ? wait_total - metricsAccountedWaitSeconds : wait_total;
+    metricsAccountedWaitSeconds = wait_total;
+    metricsSink.Push(rec);
+}
+
+void DEMDynamicThread::getTiming(std::vector<std::string>& names, std::vector<double>& vals) {
+    timers.GetTiming(names, vals);
 }
 
 void DEMDynamicThread::startThread() {
@@ -2245,7 +2864,7 @@ void DEMDynamicThread::resetUserCallStat() {
 }
 
 size_t DEMDynamicThread::estimateMemUsage() const {
-    return m_approx_bytes_used;
+    return memRegistry.GetTotalBytes();
 }
 
 void DEMDynamicThread::jitifyKernels(const std::unordered_map<std::string, std::string>& Subs) {
@@ -2255,10 +2874,7 @@ void DEMDynamicThread::jitifyKernels(const std::unordered_map<std::string, std::
             "DEMPrepForceKernels", JitHelper::KERNEL_DIR / "DEMPrepForceKernels.cu", Subs, DEME_JITIFY_OPTIONS)));
     }
     // Then force calculation kernels
-    {
-        cal_force_kernels = std::make_shared<jitify::Program>(std::move(JitHelper::buildProgram(
-            "DEMCalcForceKernels", JitHelper::KERNEL_DIR / "DEMCalcForceKernels.cu", Subs, DEME_JITIFY_OPTIONS)));
-    }
+    jitifyForceKernels(Subs);
     // Then force accumulation kernels
     if (solverFlags.useCubForceCollect) {
         collect_force_kernels = std::make_shared<jitify::Program>(std::move(JitHelper::buildProgram(
@@ -2285,6 +2901,11 @@ void DEMDynamicThread::jitifyKernels(const std::unordered_map<std::string, std::
     }
 }
 
+void DEMDynamicThread::jitifyForceKernels(const std::unordered_map<std::string, std::string>& Subs) {
+    cal_force_kernels = std::make_shared<jitify::Program>(std::move(JitHelper::buildProgram(
+        "DEMCalcForceKernels", JitHelper::KERNEL_DIR / "DEMCalcForceKernels.cu", Subs, DEME_JITIFY_OPTIONS)));
+}
+
 float* DEMDynamicThread::inspectCall(const std::shared_ptr<jitify::Program>& inspection_kernel,
                                      const std::string& kernel_name,
                                      INSPECT_ENTITY_TYPE thing_to_insp,
@@ -2377,12 +2998,16 @@ float* DEMDynamicThread::inspectCall(const std::shared_ptr<jitify::Program>& ins
 
 void DEMDynamicThread::initAllocation() {
     DEME_TRACKED_RESIZE_DEBUGPRINT(familyExtraMarginSize, NUM_AVAL_FAMILIES, "familyExtraMarginSize", 0);
+    DEME_TRACKED_RESIZE_DEBUGPRINT(familySubcycled, NUM_AVAL_FAMILIES, "familySubcycled", 0);
+    DEME_TRACKED_RESIZE_DEBUGPRINT(familyForceRecord, (NUM_AVAL_FAMILIES + 1) * NUM_AVAL_FAMILIES / 2,
+                                   "familyForceRecord", CNT_RECORD_FULL);
 }
 
 void DEMDynamicThread::deallocateEverything() {
     for (unsigned int i = 0; i < contactWildcards.size(); i++) {
         contactWildcards.clear();
     }
+    contactWildcardsBF16.clear();
     for (unsigned int i = 0; i < ownerWildcards.size(); i++) {
         ownerWildcards.clear();
     }
@@ -2426,7 +3051,13 @@ size_t DEMDynamicThread::getOwnerContactForces(bodyID_t ownerID,
                                                std::vector<float3>& forces) {
     size_t numCnt = *stateOfSolver_resources.pNumContacts;
     size_t numUsefulCnt = 0;
+    if (solverFlags.useNoContactRecord) {
+        return numUsefulCnt;
+    }
     for (size_t i = 0; i < numCnt; i++) {
+        if (!isContactRecordedInFull(i)) {
+            continue;
+        }
         bodyID_t geoA = idGeometryA.at(i);
         bodyID_t ownerA = ownerClumpBody.at(geoA);
         bodyID_t geoB = idGeometryB.at(i);
@@ -2436,7 +3067,7 @@ size_t DEMDynamicThread::getOwnerContactForces(bodyID_t ownerID,
         if ((ownerID != ownerA) && (ownerID != ownerB)) {
             continue;
         }
-        float3 force = contactForces[i];
+        float3 force = getContactForce(i);
         if (length(force) < DEME_TINY_FLOAT) {
             continue;
         }
@@ -2446,9 +3077,9 @@ size_t DEMDynamicThread::getOwnerContactForces(bodyID_t ownerID,
         float3 CoM;
         float4 oriQ;
         if (ownerID == ownerA) {
-            cntPnt = contactPointGeometryA[i];
+            cntPnt = getContactPointA(i);
         } else {
-            cntPnt = contactPointGeometryB[i];
+            cntPnt = getContactPointB(i);
             // Force dir flipped
             force = -force;
         }
@@ -2480,7 +3111,13 @@ size_t DEMDynamicThread::getOwnerContactForces(bodyID_t ownerID,
                                                bool torque_in_local) {
     size_t numCnt = *stateOfSolver_resources.pNumContacts;
     size_t numUsefulCnt = 0;
+    if (solverFlags.useNoContactRecord) {
+        return numUsefulCnt;
+    }
     for (size_t i = 0; i < numCnt; i++) {
+        if (!isContactRecordedInFull(i)) {
+            continue;
+        }
         bodyID_t geoA = idGeometryA.at(i);
         bodyID_t ownerA = ownerClumpBody.at(geoA);
         bodyID_t geoB = idGeometryB.at(i);
@@ -2490,9 +3127,9 @@ size_t DEMDynamicThread::getOwnerContactForces(bodyID_t ownerID,
         if ((ownerID != ownerA) && (ownerID != ownerB)) {
             continue;
         }
-        float3 force = contactForces[i];
+        float3 force = getContactForce(i);
         // Note torque, like force, is in global
-        float3 torque = contactTorque_convToForce[i];
+        float3 torque = getContactTorque(i);
         if (length(force) + length(torque) < DEME_TINY_FLOAT) {
             continue;
         }
@@ -2502,9 +3139,9 @@ size_t DEMDynamicThread::getOwnerContactForces(bodyID_t ownerID,
         float3 CoM;
         float4 oriQ;
         if (ownerID == ownerA) {
-            cntPnt = contactPointGeometryA[i];
+            cntPnt = getContactPointA(i);
         } else {
-            cntPnt = contactPointGeometryB[i];
+            cntPnt = getContactPointB(i);
             // Force dir flipped
             force = -force;
             torque = -torque;
@@ -2555,7 +3192,7 @@ void DEMDynamicThread::setFamilyContactWildcardValueAny(unsigned int N, unsigned
         unsigned int famB = +(familyID.at(ownerB));
 
         if (N == famA || N == famB) {
-            contactWildcards[wc_num].at(i) = val;
+            setContactWildcard(wc_num, i, val);
         }
     }
 }
@@ -2573,7 +3210,7 @@ void DEMDynamicThread::setFamilyContactWildcardValueAll(unsigned int N, unsigned
         unsigned int famB = +(familyID.at(ownerB));
 
         if (N == famA && N == famB) {
-            contactWildcards[wc_num].at(i) = val;
+            setContactWildcard(wc_num, i, val);
         }
     }
 }
@@ -2591,7 +3228,7 @@ void DEMDynamicThread::setFamilyContactWildcardValue(unsigned int N1, unsigned i
         unsigned int famB = +(familyID.at(ownerB));
 
         if ((N1 == famA && N2 == famB) || (N2 == famA && N1 == famB)) {
-            contactWildcards[wc_num].at(i) = val;
+            setContactWildcard(wc_num, i, val);
         }
     }
 }
@@ -2599,7 +3236,7 @@ void DEMDynamicThread::setFamilyContactWildcardValue(unsigned int N1, unsigned i
 void DEMDynamicThread::setContactWildcardValue(unsigned int wc_num, float val) {
     size_t numCnt = *stateOfSolver_resources.pNumContacts;
     for (size_t i = 0; i < numCnt; i++) {
-        contactWildcards[wc_num].at(i) = val;
+        setContactWildcard(wc_num, i, val);
     }
 }
 
@@ -2720,6 +3357,18 @@ float3 DEMDynamicThread::getOwnerAngAcc(bodyID_t ownerID) const {
     return aa;
 }
 
+float3 DEMDynamicThread::getOwnerCntForceSum(bodyID_t ownerID) const {
+    return solverFlags.useOwnerCntAggregates ? ownerCntForceSum.at(ownerID) : make_float3(0);
+}
+
+float3 DEMDynamicThread::getOwnerCntTorqueSum(bodyID_t ownerID) const {
+    return solverFlags.useOwnerCntAggregates ? ownerCntTorqueSum.at(ownerID) : make_float3(0);
+}
+
+unsigned int DEMDynamicThread::getOwnerCntNum(bodyID_t ownerID) const {
+    return solverFlags.useOwnerCntAggregates ? ownerCntNum.at(ownerID) : 0;
+}
+
 float3 DEMDynamicThread::getOwnerVel(bodyID_t ownerID) const {
     float3 vel;
     vel.x = vX.at(ownerID);
@@ -2773,12 +3422,30 @@ void DEMDynamicThread::setOwnerVel(bodyID_t ownerID, float3 vel) {
     vZ.at(ownerID) = vel.z;
 }
 
+void DEMDynamicThread::wakeOwner(bodyID_t ownerID) {
+    if (simParams->sleepSteps > 0 && sleepCounter.at(ownerID) >= simParams->sleepSteps) {
+        granData->nSleepingOwners--;
+    }
+    sleepCounter.at(ownerID) = 0;
+}
+
+void DEMDynamicThread::wakeAllOwners() {
+    std::fill(sleepCounter.begin(), sleepCounter.end(), 0);
+    granData->nSleepingOwners = 0;
+}
+
+size_t DEMDynamicThread::getNumSleepingOwners() const {
+    // The integrator and the wake-up paths keep this count, so no pass over the owners is needed
+    return (simParams->sleepSteps == 0) ? 0 : granData->nSleepingOwners;
+}
+
 void DEMDynamicThread::setTriNodeRelPos(size_t start, const std::vector<DEMTriangle>& triangles) {
     for (size_t i = 0; i < triangles.size(); i++) {
         relPosNode1[start + i] = triangles[i].p1;
         relPosNode2[start + i] = triangles[i].p2;
         relPosNode3[start + i] = triangles[i].p3;
     }
+    meshDirtyRanges.Add(start, start + triangles.size());
 }
 
 void DEMDynamicThread::updateTriNodeRelPos(size_t start, const std::vector<DEMTriangle>& updates) {
@@ -2787,6 +3454,20 @@ void DEMDynamicThread::updateTriNodeRelPos(size_t start, const std::vector<DEMTr
         relPosNode2[start + i] += updates[i].p2;
         relPosNode3[start + i] += updates[i].p3;
     }
+    meshDirtyRanges.Add(start, start + updates.size());
+}
+
+void DEMDynamicThread::setTriNodeRelPos(size_t start, const MeshNodeIndex& mesh, DirtyRanges& facets) {
+    // Merged ranges may include some clean facets; rewriting them is harmless
+    for (const auto& range : facets.Get()) {
+        for (size_t i = range.first; i < range.second; i++) {
+            DEMTriangle tri = mesh.GetFacet(i);
+            relPosNode1[start + i] = tri.p1;
+            relPosNode2[start + i] = tri.p2;
+            relPosNode3[start + i] = tri.p3;
+        }
+        meshDirtyRanges.Add(start + range.first, start + range.second);
+    }
 }
 
 }  // namespace deme
@@ -61,6 +61,12 @@ class DEMDynamicThread {
     // it is allocated)
     size_t buffer_size = 0;
 
+    // Capacities reserved for the per-owner, per-sphere and per-contact arrays (from InstructNumOwners). As long as
+    // the system stays below them, adding clumps is an append to the arrays, not a re-allocation and copy.
+    size_t reservedOwners = 0;
+    size_t reservedSpheres = 0;
+    size_t reservedContacts = 0;
+
     // Object which stores the device and stream IDs for this thread
     GpuManager::StreamInfo streamInfo;
 
@@ -187,6 +193,15 @@ class DEMDynamicThread {
     std::vector<notStupidBool_t, ManagedAllocator<notStupidBool_t>> accSpecified;
     std::vector<notStupidBool_t, ManagedAllocator<notStupidBool_t>> angAccSpecified;
 
+    // Number of consecutive steps each owner has been quiescent (see simParams->sleepSteps)
+    std::vector<unsigned int, ManagedAllocator<unsigned int>> sleepCounter;
+
+    // Per-owner sums of the contacts recorded as aggregates (see familyForceRecord); only allocated if some family pair
+    // is recorded that way
+    std::vector<float3, ManagedAllocator<float3>> ownerCntForceSum;
+    std::vector<float3, ManagedAllocator<float3>> ownerCntTorqueSum;
+    std::vector<unsigned int, ManagedAllocator<unsigned int>> ownerCntNum;
+
     // Contact pair/location, for dT's personal use!!
     std::vector<bodyID_t, ManagedAllocator<bodyID_t>> idGeometryA;
     std::vector<bodyID_t, ManagedAllocator<bodyID_t>> idGeometryB;
@@ -204,10 +219,20 @@ class DEMDynamicThread {
     // Local position of contact point of contact w.r.t. the reference frame of body A and B
     std::vector<float3, ManagedAllocator<float3>> contactPointGeometryA;
     std::vector<float3, ManagedAllocator<float3>> contactPointGeometryB;
+    // With the compact contact storage policy, the torque-only forces and contact points on A are kept in these, and
+    // contactTorque_convToForce and contactPointGeometryA stay empty. A is always a clump's sphere, so the point's
+    // error is bounded by the clump's size; B can be a mesh or an analytical object of any size, so its point stays
+    // float3.
+    std::vector<compactFloat3_t, ManagedAllocator<compactFloat3_t>> compactTorque_convToForce;
+    std::vector<compactFloat3_t, ManagedAllocator<compactFloat3_t>> compactPointGeometryA;
     // Wildcard (extra property) arrays associated with contacts and owners
     std::vector<std::vector<float, ManagedAllocator<float>>,
                 ManagedAllocator<std::vector<float, ManagedAllocator<float>>>>
         contactWildcards;
+    // If contact wildcards are kept in bfloat16, they are in these, and contactWildcards stay empty
+    std::vector<std::vector<bf16_t, ManagedAllocator<bf16_t>>,
+                ManagedAllocator<std::vector<bf16_t, ManagedAllocator<bf16_t>>>>
+        contactWildcardsBF16;
     std::vector<std::vector<float, ManagedAllocator<float>>,
                 ManagedAllocator<std::vector<float, ManagedAllocator<float>>>>
         ownerWildcards;
@@ -238,7 +263,11 @@ class DEMDynamicThread {
     // The velocity of the contact points in the global frame: can be useful in determining the time step size
     // std::vector<float3, ManagedAllocator<float3>> contactPointVel;
 
-    size_t m_approx_bytes_used = 0;
+    // All arrays, buffers and scratch space this thread holds register their sizes here
+    MemoryRegistry memRegistry = MemoryRegistry("dT");
+
+    // Ranges of the flattened triangle soup that were deformed since the last time dT sent them to kT
+    DirtyRanges meshDirtyRanges;
 
     // dT's total steps run (since last time the collaboration stats cache is cleared)
     uint64_t nTotalSteps = 0;
@@ -283,14 +312,65 @@ class DEMDynamicThread {
     // that means geometries should be considered in contact when they are physically in contact.
     std::vector<float, ManagedAllocator<float>> familyExtraMarginSize;
 
+    // Whether each family is subcycled, i.e. takes simParams->nSubsteps substeps per step
+    std::vector<notStupidBool_t, ManagedAllocator<notStupidBool_t>> familySubcycled;
+    // How the contacts between each pair of families are recorded (CNT_RECORD_FULL etc.), flattened like
+    // familyMaskMatrix. Only used if solverFlags.useForceRecordPolicy.
+    std::vector<notStupidBool_t, ManagedAllocator<notStupidBool_t>> familyForceRecord;
+
     // dT's copy of "clump template and their names" map
     std::unordered_map<unsigned int, std::string> templateNumNameMap;
 
-    // dT's timers
+    // dT's timers (in the order of DT_TIMER), then the scopes that only the profiler records
     std::vector<std::string> timer_names = {"Clear force array", "Calculate contact forces", "Collect contact forces",
                                             "Integration",       "Unpack updates from kT",   "Send to kT buffer",
                                             "Wait for kT update"};
-    SolverTimers timers = SolverTimers(timer_names);
+    std::vector<std::string> scope_names = {"Routine checks", "Calibrate params"};
+    SolverTimers timers = SolverTimers("dT", timer_names, scope_names);
+
+    // Runtime metrics time series; dT is its only producer
+    MetricsSink<SolverMetrics> metricsSink;
+    bool metricsEnabled = false;
+    // Besides at each kT update, take a metrics sample every this many dT steps (0 means only at kT updates)
+    unsigned int metricsSampleEvery = 0;
+    // The latest sample, whose kT-side quantities are reused by the in-between samples
+    SolverMetrics latestMetrics;
+    // Wait-for-kT time already accounted for by the previous sample
+    double metricsAccountedWaitSeconds = 0;
+    // How many steps stale the latest kT update was when dT received it
+    int64_t latestKinematicLagSteps = 0;
+
+    // Step size controller, used in adaptive time stepping
+    TimeStepController stepController;
+
+    // For subcycling: the contacts that involve subcycled families, the owners in those families (as IDs and as
+    // per-owner flags), and the accelerations that those owners get from other than contacts (such as user-added
+    // ones) in this step. Owners that change families in a step keep being treated by their old families in it.
+    std::vector<contactPairs_t, ManagedAllocator<contactPairs_t>> subcycledContactIDs;
+    std::vector<bodyID_t, ManagedAllocator<bodyID_t>> subcycledOwnerIDs;
+    std::vector<notStupidBool_t, ManagedAllocator<notStupidBool_t>> subcycledOwnerFlags;
+    std::vector<float3, ManagedAllocator<float3>> subcycledOwnerAcc;
+    std::vector<float3, ManagedAllocator<float3>> subcycledOwnerAngAcc;
+    // If false, the lists above are rebuilt before they are used next time. Host-side changes (such as family changes
+    // made by the user) invalidate them, and so do new contact arrays from kT.
+    bool subcycledListsValid = false;
+
+    // For type-specialized force calculation: the runs of same-type contacts in the (type-sorted) contact array, as
+    // their types, starts and lengths. They are found again whenever kT sends new contact arrays.
+    std::vector<contact_t> contactTypeRunTypes;
+    std::vector<contactPairs_t> contactTypeRunStarts;
+    std::vector<contactPairs_t> contactTypeRunCounts;
+    // False if the contact array is found not sorted by type, so that the generic force kernel has to be used
+    bool contactTypeRunsUsable = false;
+
+    // With a force record policy, the contacts recorded in full are packed at the front of the record arrays
+    // (contactForces etc.), which are only that long. fullRecordSlot gives each contact's place there, or
+    // NULL_MAPPING_PARTNER. Like the subcycled lists, it is rebuilt when the contacts or the families change.
+    std::vector<contactPairs_t, ManagedAllocator<contactPairs_t>> fullRecordSlot;
+    size_t nFullRecordContacts = 0;
+    // The share of contacts recorded in full found last time, for sizing the record arrays ahead of a count
+    double fullRecordRatio = 0.;
+    bool fullRecordSlotsValid = false;
 
   public:
     friend class DEMSolver;
@@ -306,6 +386,9 @@ class DEMDynamicThread {
         // Get a device/stream ID to use from the GPU Manager
         streamInfo = pGpuDistributor->getAvailableStream();
 
+        // Scratch space and temp arrays report to this thread's memory registry
+        stateOfSolver_resources.memRegistry = &memRegistry;
+
         pPagerToMain->userCallDone = false;
         pSchedSupport->dynamicShouldJoin = false;
         pSchedSupport->dynamicStarted = false;
@@ -372,6 +455,10 @@ class DEMDynamicThread {
     float3 getOwnerAcc(bodyID_t ownerID) const;
     /// Get this owner's angular acceleration
     float3 getOwnerAngAcc(bodyID_t ownerID) const;
+    // Get the sums of the contacts of an owner that are recorded as aggregates
+    float3 getOwnerCntForceSum(bodyID_t ownerID) const;
+    float3 getOwnerCntTorqueSum(bodyID_t ownerID) const;
+    unsigned int getOwnerCntNum(bodyID_t ownerID) const;
     // Get the current auto-adjusted update freq
     float getUpdateFreq() const;
 
@@ -383,12 +470,21 @@ class DEMDynamicThread {
     void setOwnerOriQ(bodyID_t ownerID, float4 oriQ);
     /// Set this owner's velocity
     void setOwnerVel(bodyID_t ownerID, float3 vel);
+    /// Wake this owner up, if it is sleeping, and restart its count of quiescent steps
+    void wakeOwner(bodyID_t ownerID);
+    /// Wake all owners up
+    void wakeAllOwners();
+    /// Get the number of owners that are sleeping
+    size_t getNumSleepingOwners() const;
     /// Rewrite the relative positions of the flattened triangle soup, starting from `start', using triangle nodal
     /// positions in `triangles'.
     void setTriNodeRelPos(size_t start, const std::vector<DEMTriangle>& triangles);
     /// Rewrite the relative positions of the flattened triangle soup, starting from `start' by the amount stipulated in
     /// updates.
     void updateTriNodeRelPos(size_t start, const std::vector<DEMTriangle>& updates);
+    /// Rewrite the relative positions of the facets of `mesh' that are in `facets' (facet numbers are relative to
+    /// `start', the mesh's first facet in the flattened triangle soup). Only these facets are later sent to kT.
+    void setTriNodeRelPos(size_t start, const MeshNodeIndex& mesh, DirtyRanges& facets);
 
     /// @brief Globally modify a owner wildcard's value.
     void setOwnerWildcardValue(bodyID_t ownerID, unsigned int wc_num, const std::vector<float>& vals);
@@ -462,6 +558,14 @@ class DEMDynamicThread {
                                unsigned int nClumpComponents,
                                unsigned int nJitifiableClumpComponents,
                                unsigned int nMatTuples);
+    /// Resize the managed arrays to these numbers of entities. It is the one place that decides the arrays' sizes, for
+    /// both the allocation and the memory prediction.
+    void resizeManagedArrays(const ManagedArraySizes& n);
+    /// Record in registry the sizes that the managed arrays would take for these numbers of entities and solver flags,
+    /// without allocating anything
+    void sizeManagedArrays(const ManagedArraySizes& n, MemoryRegistry& registry);
+    /// Reserve the capacities in reservedOwners, reservedSpheres and reservedContacts for the arrays
+    void reserveManagedArrays();
 
     // Components of initManagedArrays
     void buildTrackedObjs(const std::vector<std::shared_ptr<DEMClumpBatch>>& input_clump_batches,
@@ -539,6 +643,7 @@ class DEMDynamicThread {
                                const std::vector<unsigned int>& mesh_facet_owner,
                                const std::vector<materialsOffset_t>& mesh_facet_materials,
                                const std::vector<DEMTriangle>& mesh_facets,
+                               const std::unordered_map<unsigned int, std::string>& template_number_name_map,
                                const ClumpTemplateFlatten& clump_templates,
                                const std::vector<float>& ext_obj_mass_types,
                                const std::vector<float3>& ext_obj_moi_types,
@@ -580,18 +685,14 @@ class DEMDynamicThread {
 
     // Reset kT--dT interaction coordinator stats
     void resetUserCallStat();
-    // Return the approximate RAM usage
+    // Return the memory usage (in bytes) of all arrays, buffers and scratch space registered by this thread
     size_t estimateMemUsage() const;
 
     /// Return timing inforation for this current run
     void getTiming(std::vector<std::string>& names, std::vector<double>& vals);
 
     /// Reset the timers
-    void resetTimers() {
-        for (const auto& name : timer_names) {
-            timers.GetTimer(name).reset();
-        }
-    }
+    void resetTimers() { timers.Reset(); }
 
     /// Get the simulation time passed since the start of simulation
     double getSimTime() const;
@@ -600,6 +701,8 @@ class DEMDynamicThread {
 
     // Jitify dT kernels (at initialization) based on existing knowledge of this run
     void jitifyKernels(const std::unordered_map<std::string, std::string>& Subs);
+    // Jitify only the force calculation kernels (they are the ones that use material properties)
+    void jitifyForceKernels(const std::unordered_map<std::string, std::string>& Subs);
 
     // Execute this kernel, then return the reduced value
     float* inspectCall(const std::shared_ptr<jitify::Program>& inspection_kernel,
@@ -639,6 +742,21 @@ class DEMDynamicThread {
     // Update clump pos/oriQ and vel/omega based on acceleration
     inline void integrateOwnerMotions();
 
+    // Find the contacts and owners that involve subcycled families
+    inline void findSubcycledContactsAndOwners();
+    // Calculate the forces of the contacts that involve subcycled families, with the substep size
+    inline void calculateSubcycledContactForces();
+    // Subcycled owners take the substeps after the first one
+    inline void takeSubsteps();
+
+    // Find the contacts recorded in full (with a force record policy), and give each its place in the record arrays
+    inline void findFullRecordContacts();
+
+    // Find the runs of same-type contacts in the contact array
+    inline void findContactTypeRuns();
+    // Calculate contact forces with a kernel specialized for each contact type run
+    inline void calculateContactForcesByType();
+
     // If kT provides fresh CD results, we unpack and use it
     inline void ifProduceFreshThenUseItAndSendNewOrder();
     inline void ifProduceFreshThenUseIt();
@@ -650,6 +768,12 @@ class DEMDynamicThread {
     // Determine the max vel for this cycle, kT needs it
     inline float* determineSysVel();
 
+    // Pick the step size for the next kT cycle (in adaptive time stepping)
+    inline void adaptStepSize();
+
+    // Take a metrics sample and push it to the metrics sink. If at a kT update, kT-side quantities are refreshed too.
+    void recordMetrics(bool at_kT_update);
+
     // Some per-step checks/modification, done before integration, but after force calculation (thus sort of in the
     // mid-step stage)
     inline void routineChecks();
@@ -660,6 +784,11 @@ class DEMDynamicThread {
     void sendToTheirBuffer();
     // Resize some work arrays based on the number of contact pairs provided by kT
     void contactEventArraysResize(size_t nContactPairs);
+    // Resize the per-contact force record arrays (contactForces etc.) to hold nRecords contacts
+    void contactRecordArraysResize(size_t nRecords);
+    // How long the record arrays should be for nContacts contacts. With a force record policy, it is estimated from the
+    // share of contacts recorded in full last time (0 before they are first counted, as they grow to the count anyway).
+    size_t fullRecordArraySize(size_t nContacts, bool withForceRecordPolicy) const;
 
     // Deallocate everything
     void deallocateEverything();
@@ -668,6 +797,19 @@ class DEMDynamicThread {
 
     // Get owner of contact geo B.
     inline bodyID_t getOwnerForContactB(const bodyID_t& geoB, const contact_t& type) const;
+    // Whether a contact's force, torque and points are recorded in the per-contact arrays
+    inline bool isContactRecordedInFull(size_t i) const;
+    // Where a contact recorded in full is in the record arrays
+    inline size_t getFullRecordSlot(size_t i) const;
+    // Get the force, the torque-only force and the contact points of a contact recorded in full, in whichever form
+    // they are stored
+    inline float3 getContactForce(size_t i) const;
+    inline float3 getContactTorque(size_t i) const;
+    inline float3 getContactPointA(size_t i) const;
+    inline float3 getContactPointB(size_t i) const;
+    // Get and set a contact wildcard value as a float, in whichever precision it is stored
+    inline float getContactWildcard(unsigned int wc_num, size_t i) const;
+    inline void setContactWildcard(unsigned int wc_num, size_t i, float val);
 
     // Just-in-time compiled kernels
     std::shared_ptr<jitify::Program> prep_force_kernels;
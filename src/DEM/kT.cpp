@@ -18,8 +18,7 @@
 
 namespace deme {
 
-inline void DEMKinematicThread::transferArraysResize(size_t nContactPairs) {
-    // TODO: This memory usage is not tracked... How can I track the size changes on my friend's end??
+inline void DEMKinematicThread::transferArraysResize(size_t nContactPairs, bool withMapping) {
     // dT->idGeometryA_buffer.resize(nContactPairs);
     // dT->idGeometryB_buffer.resize(nContactPairs);
     // dT->contactType_buffer.resize(nContactPairs);
@@ -27,20 +26,33 @@ inline void DEMKinematicThread::transferArraysResize(size_t nContactPairs) {
     // DEME_ADVISE_DEVICE(dT->idGeometryB_buffer, dT->streamInfo.device);
     // DEME_ADVISE_DEVICE(dT->contactType_buffer, dT->streamInfo.device);
 
-    // These buffers are on dT
-    DEME_GPU_CALL(cudaSetDevice(dT->streamInfo.device));
-    dT->buffer_size = nContactPairs;
-    DEME_DEVICE_PTR_ALLOC(dT->granData->idGeometryA_buffer, nContactPairs);
-    DEME_DEVICE_PTR_ALLOC(dT->granData->idGeometryB_buffer, nContactPairs);
-    DEME_DEVICE_PTR_ALLOC(dT->granData->contactType_buffer, nContactPairs);
+    // These buffers are on dT. They grow geometrically, so a contact number that creeps up does not re-allocate them at
+    // every CD step; buffer_size is the capacity, not the number of contacts. They are registered as dT's memory.
+    // While sizing (see memSizingRegistry), the sizes of fresh buffers are recorded, and nothing else is touched.
+    const bool sizing = (memSizingRegistry != nullptr);
+    if (!sizing) {
+        DEME_GPU_CALL(cudaSetDevice(dT->streamInfo.device));
+    }
+    size_t new_capacity =
+        sizing ? nContactPairs : DEME_MAX(nContactPairs, (size_t)(DEME_BUFFER_GROWTH_FACTOR * dT->buffer_size));
+    DEME_DEVICE_PTR_ALLOC(dT->granData->idGeometryA_buffer, new_capacity, dT->memRegistry, "idGeometryA_buffer");
+    DEME_DEVICE_PTR_ALLOC(dT->granData->idGeometryB_buffer, new_capacity, dT->memRegistry, "idGeometryB_buffer");
+    DEME_DEVICE_PTR_ALLOC(dT->granData->contactType_buffer, new_capacity, dT->memRegistry, "contactType_buffer");
+    if (withMapping) {
+        // dT->contactMapping_buffer.resize(nContactPairs);
+        // DEME_ADVISE_DEVICE(dT->contactMapping_buffer, dT->streamInfo.device);
+        DEME_DEVICE_PTR_ALLOC(dT->granData->contactMapping_buffer, new_capacity, dT->memRegistry,
+                              "contactMapping_buffer");
+    }
+    if (sizing) {
+        return;
+    }
+
+    dT->buffer_size = new_capacity;
     granData->pDTOwnedBuffer_idGeometryA = dT->granData->idGeometryA_buffer;
     granData->pDTOwnedBuffer_idGeometryB = dT->granData->idGeometryB_buffer;
     granData->pDTOwnedBuffer_contactType = dT->granData->contactType_buffer;
-
-    if (!solverFlags.isHistoryless) {
-        // dT->contactMapping_buffer.resize(nContactPairs);
-        // DEME_ADVISE_DEVICE(dT->contactMapping_buffer, dT->streamInfo.device);
-        DEME_DEVICE_PTR_ALLOC(dT->granData->contactMapping_buffer, nContactPairs);
+    if (withMapping) {
         granData->pDTOwnedBuffer_contactMapping = dT->granData->contactMapping_buffer;
     }
     // Unset the device change we just made
@@ -94,6 +106,7 @@ void DEMKinematicThread::calibrateParams() {
             stateParams.numBins =
                 hostCalcBinNum(simParams->nbX, simParams->nbY, simParams->nbZ, simParams->voxelSize, simParams->binSize,
                                simParams->nvXp2, simParams->nvYp2, simParams->nvZp2);
+            updateBinLevels();
 
             DEME_DEBUG_PRINTF("Bin size is now: %.7g", simParams->binSize);
             DEME_DEBUG_PRINTF("Total num of bins is now: %zu", stateParams.numBins);
@@ -102,6 +115,95 @@ void DEMKinematicThread::calibrateParams() {
     }
 }
 
+void DEMKinematicThread::updateBinLevels() {
+    simParams->nBinLevels =
+        solverFlags.useHierarchicalBinning
+            ? hostNumBinLevels(simParams->binSize, stateParams.maxSphereRadius, DEME_MAX_BIN_LEVELS)
+            : 1;
+    stateParams.numBins =
+        hostCalcBinLevels(simParams->nbXLevel, simParams->nbYLevel, simParams->nbZLevel, simParams->binLevelOffset,
+                          simParams->nbX, simParams->nbY, simParams->nbZ, simParams->nBinLevels);
+    DEME_DEBUG_PRINTF("Levels of bins: %u", simParams->nBinLevels);
+}
+
+bool DEMKinematicThread::checkContactCandidates() {
+    if (simParams->verletSkin <= 0. || !verletCandidatesValid || simParams->nOwnerBodies == 0) {
+        return false;
+    }
+    size_t* pExpired = stateOfSolver_resources.pTempSizeVar3;
+    *pExpired = 0;
+    size_t blocks_needed = (simParams->nOwnerBodies + DEME_MAX_THREADS_PER_BLOCK - 1) / DEME_MAX_THREADS_PER_BLOCK;
+    misc_kernels->kernel("checkContactCandidateExpiry")
+        .instantiate()
+        .configure(dim3(blocks_needed), dim3(DEME_MAX_THREADS_PER_BLOCK), 0, streamInfo.stream)
+        .launch(simParams, granData, pExpired, (size_t)simParams->nOwnerBodies);
+    DEME_GPU_CALL(cudaStreamSynchronize(streamInfo.stream));
+    return (*pExpired == 0);
+}
+
+void DEMKinematicThread::recordContactCandidateStates() {
+    const size_t nOwners = simParams->nOwnerBodies;
+    DEME_GPU_CALL(cudaMemcpy(granData->verletVoxelID, granData->voxelID, nOwners * sizeof(voxelID_t),
+                             cudaMemcpyDeviceToDevice));
+    DEME_GPU_CALL(
+        cudaMemcpy(granData->verletLocX, granData->locX, nOwners * sizeof(subVoxelPos_t), cudaMemcpyDeviceToDevice));
+    DEME_GPU_CALL(
+        cudaMemcpy(granData->verletLocY, granData->locY, nOwners * sizeof(subVoxelPos_t), cudaMemcpyDeviceToDevice));
+    DEME_GPU_CALL(
+        cudaMemcpy(granData->verletLocZ, granData->locZ, nOwners * sizeof(subVoxelPos_t), cudaMemcpyDeviceToDevice));
+    DEME_GPU_CALL(
+        cudaMemcpy(granData->verletOriQw, granData->oriQw, nOwners * sizeof(oriQ_t), cudaMemcpyDeviceToDevice));
+    DEME_GPU_CALL(
+        cudaMemcpy(granData->verletOriQx, granData->oriQx, nOwners * sizeof(oriQ_t), cudaMemcpyDeviceToDevice));
+    DEME_GPU_CALL(
+        cudaMemcpy(granData->verletOriQy, granData->oriQy, nOwners * sizeof(oriQ_t), cudaMemcpyDeviceToDevice));
+    DEME_GPU_CALL(
+        cudaMemcpy(granData->verletOriQz, granData->oriQz, nOwners * sizeof(oriQ_t), cudaMemcpyDeviceToDevice));
+    DEME_GPU_CALL(cudaMemcpy(granData->verletMarginSize, granData->marginSize, nOwners * sizeof(float),
+                             cudaMemcpyDeviceToDevice));
+    DEME_GPU_CALL(cudaMemcpy(granData->verletFamilyID, granData->familyID, nOwners * sizeof(family_t),
+                             cudaMemcpyDeviceToDevice));
+
+    // Owner extents, from the geometries they have now
+    DEME_GPU_CALL(cudaMemset(granData->verletOwnerExtent, 0, nOwners * sizeof(float)));
+    if (simParams->nSpheresGM > 0) {
+        size_t blocks_needed =
+            (simParams->nSpheresGM + DEME_MAX_THREADS_PER_BLOCK - 1) / DEME_MAX_THREADS_PER_BLOCK;
+        bin_sphere_kernels->kernel("computeSphereOwnerExtents")
+            .instantiate()
+            .configure(dim3(blocks_needed), dim3(DEME_MAX_THREADS_PER_BLOCK), 0, streamInfo.stream)
+            .launch(simParams, granData);
+        DEME_GPU_CALL(cudaStreamSynchronize(streamInfo.stream));
+    }
+    if (simParams->nTriGM > 0) {
+        size_t blocks_needed = (simParams->nTriGM + DEME_MAX_THREADS_PER_BLOCK - 1) / DEME_MAX_THREADS_PER_BLOCK;
+        bin_triangle_kernels->kernel("computeTriangleOwnerExtents")
+            .instantiate()
+            .configure(dim3(blocks_needed), dim3(DEME_MAX_THREADS_PER_BLOCK), 0, streamInfo.stream)
+            .launch(simParams, granData);
+        DEME_GPU_CALL(cudaStreamSynchronize(streamInfo.stream));
+    }
+    if (simParams->nAnalGM > 0) {
+        size_t blocks_needed = (simParams->nAnalGM + DEME_MAX_THREADS_PER_BLOCK - 1) / DEME_MAX_THREADS_PER_BLOCK;
+        bin_sphere_kernels->kernel("markAnalOwnerExtents")
+            .instantiate()
+            .configure(dim3(blocks_needed), dim3(DEME_MAX_THREADS_PER_BLOCK), 0, streamInfo.stream)
+            .launch(simParams, granData);
+        DEME_GPU_CALL(cudaStreamSynchronize(streamInfo.stream));
+    }
+
+    // Then the margins get the skin, so binning finds the contacts of the steps to come as well
+    if (nOwners > 0) {
+        size_t blocks_needed = (nOwners + DEME_MAX_THREADS_PER_BLOCK - 1) / DEME_MAX_THREADS_PER_BLOCK;
+        misc_kernels->kernel("addSkinToMargins")
+            .instantiate()
+            .configure(dim3(blocks_needed), dim3(DEME_MAX_THREADS_PER_BLOCK), 0, streamInfo.stream)
+            .launch(simParams, granData, nOwners);
+        DEME_GPU_CALL(cudaStreamSynchronize(streamInfo.stream));
+    }
+    verletCandidatesValid = true;
+}
+
 inline void DEMKinematicThread::unpackMyBuffer() {
     DEME_GPU_CALL(cudaMemcpy(granData->voxelID, granData->voxelID_buffer, simParams->nOwnerBodies * sizeof(voxelID_t),
                              cudaMemcpyDeviceToDevice));
@@ -179,14 +281,21 @@ inline void DEMKinematicThread::unpackMyBuffer() {
 
     // If dT received a mesh deformation request from user, then it is now passed to kT
     if (solverFlags.willMeshDeform) {
-        DEME_GPU_CALL(cudaMemcpy(granData->relPosNode1, granData->relPosNode1_buffer,
-                                 simParams->nTriGM * sizeof(float3), cudaMemcpyDeviceToDevice));
-        DEME_GPU_CALL(cudaMemcpy(granData->relPosNode2, granData->relPosNode2_buffer,
-                                 simParams->nTriGM * sizeof(float3), cudaMemcpyDeviceToDevice));
-        DEME_GPU_CALL(cudaMemcpy(granData->relPosNode3, granData->relPosNode3_buffer,
-                                 simParams->nTriGM * sizeof(float3), cudaMemcpyDeviceToDevice));
+        // Only the facets dT marked as deformed are unpacked
+        for (const auto& range : meshDirtyRanges.Get()) {
+            const size_t n = range.second - range.first;
+            DEME_GPU_CALL(cudaMemcpy(granData->relPosNode1 + range.first, granData->relPosNode1_buffer + range.first,
+                                     n * sizeof(float3), cudaMemcpyDeviceToDevice));
+            DEME_GPU_CALL(cudaMemcpy(granData->relPosNode2 + range.first, granData->relPosNode2_buffer + range.first,
+                                     n * sizeof(float3), cudaMemcpyDeviceToDevice));
+            DEME_GPU_CALL(cudaMemcpy(granData->relPosNode3 + range.first, granData->relPosNode3_buffer + range.first,
+                                     n * sizeof(float3), cudaMemcpyDeviceToDevice));
+        }
+        meshDirtyRanges.Clear();
         // dT won't be sending if kT is loading, so it is safe
         solverFlags.willMeshDeform = false;
+        // Deformed facets may reach further than the contact candidates account for
+        verletCandidatesValid = false;
     }
 }
 
@@ -195,7 +304,7 @@ inline void DEMKinematicThread::sendToTheirBuffer() {
                              sizeof(size_t), cudaMemcpyDeviceToDevice));
     // Resize dT owned buffers before usage
     if (*stateOfSolver_resources.pNumContacts > dT->buffer_size) {
-        transferArraysResize(*stateOfSolver_resources.pNumContacts);
+        transferArraysResize(*stateOfSolver_resources.pNumContacts, !solverFlags.isHistoryless);
     }
 
     DEME_GPU_CALL(cudaMemcpy(granData->pDTOwnedBuffer_idGeometryA, granData->idGeometryA,
@@ -240,7 +349,7 @@ void DEMKinematicThread::workerThread() {
         while (!pSchedSupport->dynamicDone) {
             // Before producing something, a new work order should be in place. Wait on it.
             if (!pSchedSupport->kinematicOwned_Cons2ProdBuffer_isFresh) {
-                timers.GetTimer("Wait for dT update").start();
+                timers.Start(KT_WAIT_FOR_DT);
                 pSchedSupport->schedulingStats.nTimesKinematicHeldBack++;
                 std::unique_lock<std::mutex> lock(pSchedSupport->kinematicCanProceed);
 
@@ -250,7 +359,7 @@ void DEMKinematicThread::workerThread() {
                     // Loop to avoid spurious wakeups
                     pSchedSupport->cv_KinematicCanProceed.wait(lock);
                 }
-                timers.GetTimer("Wait for dT update").stop();
+                timers.Stop(KT_WAIT_FOR_DT);
 
                 // In the case where this weak-up call is at the destructor (dT has been executing without notifying the
                 // end of user calls, aka running DoDynamics), we don't have to do CD one more time, just break
@@ -259,7 +368,7 @@ void DEMKinematicThread::workerThread() {
                 }
             }
 
-            timers.GetTimer("Unpack updates from dT").start();
+            timers.Start(KT_UNPACK_FROM_DT);
             // Getting here means that new `work order' data has been provided
             {
                 // Acquire lock and get the work order
@@ -267,7 +376,7 @@ void DEMKinematicThread::workerThread() {
                 unpackMyBuffer();
                 // pSchedSupport->schedulingStats.nKinematicReceives++;
             }
-            timers.GetTimer("Unpack updates from dT").stop();
+            timers.Stop(KT_UNPACK_FROM_DT);
 
             // Make it clear that the data for most recent work order has been used, in case there is interest in
             // updating it
@@ -278,14 +387,33 @@ void DEMKinematicThread::workerThread() {
 
             // kT's main task, contact detection.
             // For auto-adjusting bin size, this part of code is encapsuled in an accumulative timer.
-            CDAccumTimer.Begin();
-            contactDetection(bin_sphere_kernels, bin_triangle_kernels, sphere_contact_kernels, sphTri_contact_kernels,
-                             history_kernels, granData, simParams, solverFlags, verbosity, idGeometryA, idGeometryB,
-                             contactType, previous_idGeometryA, previous_idGeometryB, previous_contactType,
-                             contactMapping, streamInfo.stream, stateOfSolver_resources, timers, stateParams);
-            CDAccumTimer.End();
-
-            timers.GetTimer("Send to dT buffer").start();
+            // If the contact candidates from an earlier step are reused, there is no binning, so this step says
+            // nothing about the bin size and is left out of the accumulative timer.
+            bool reuseCandidates = checkContactCandidates();
+            if (!reuseCandidates) {
+                if (simParams->verletSkin > 0.)
+                    recordContactCandidateStates();
+                CDAccumTimer.Begin();
+            }
+            if (solverFlags.useHostContactDetection) {
+                // The owner states just unpacked from dT must have landed before host threads read them
+                DEME_GPU_CALL(cudaStreamSynchronize(streamInfo.stream));
+                hostContactDetection(granData, simParams, solverFlags, verbosity, hostAnalEntities, idGeometryA,
+                                     idGeometryB, contactType, previous_idGeometryA, previous_idGeometryB,
+                                     previous_contactType, contactMapping, stateOfSolver_resources, timers,
+                                     stateParams, hostCDWorkers);
+            } else {
+                contactDetection(bin_sphere_kernels, bin_triangle_kernels, sphere_contact_kernels,
+                                 sphTri_contact_kernels, history_kernels, granData, simParams, solverFlags, verbosity,
+                                 idGeometryA, idGeometryB, contactType, previous_idGeometryA, previous_idGeometryB,
+                                 previous_contactType, contactMapping, verletIdGeometryA, verletIdGeometryB,
+                                 verletContactType, nVerletCandidates, reuseCandidates, sphereBinningRecord,
+                                 streamInfo.stream, stateOfSolver_resources, timers, stateParams);
+            }
+            if (!reuseCandidates)
+                CDAccumTimer.End();
+
+            timers.Start(KT_SEND_TO_DT);
             {
                 // kT will reflect on how good the choice of parameters is
                 calibrateParams();
@@ -295,7 +423,7 @@ void DEMKinematicThread::workerThread() {
             }
             pSchedSupport->dynamicOwned_Prod2ConsBuffer_isFresh = true;
             pSchedSupport->schedulingStats.nDynamicUpdates++;
-            timers.GetTimer("Send to dT buffer").stop();
+            timers.Stop(KT_SEND_TO_DT);
 
             // Signal the dynamic that it has fresh produce
             pSchedSupport->cv_DynamicCanProceed.notify_all();
@@ -314,10 +442,7 @@ void DEMKinematicThread::workerThread() {
 }
 
 void DEMKinematicThread::getTiming(std::vector<std::string>& names, std::vector<double>& vals) {
-    names = timer_names;
-    for (const auto& name : timer_names) {
-        vals.push_back(timers.GetTimer(name).GetTimeSeconds());
-    }
+    timers.GetTiming(names, vals);
 }
 
 void DEMKinematicThread::changeFamily(unsigned int ID_from, unsigned int ID_to) {
@@ -325,6 +450,7 @@ void DEMKinematicThread::changeFamily(unsigned int ID_from, unsigned int ID_to)
     family_t ID_to_impl = ID_to;
     std::replace_if(
         familyID.begin(), familyID.end(), [ID_from_impl](family_t& i) { return i == ID_from_impl; }, ID_to_impl);
+    verletCandidatesValid = false;
 }
 
 void DEMKinematicThread::changeOwnerSizes(const std::vector<bodyID_t>& IDs, const std::vector<float>& factors) {
@@ -364,6 +490,7 @@ void DEMKinematicThread::changeOwnerSizes(const std::vector<bodyID_t>& IDs, cons
         .configure(dim3(blocks_needed_for_changing), dim3(DEME_MAX_THREADS_PER_BLOCK), 0, streamInfo.stream)
         .launch(granData, idBool, ownerFactors, (size_t)simParams->nSpheresGM);
     DEME_GPU_CALL(cudaStreamSynchronize(streamInfo.stream));
+    verletCandidatesValid = false;
 
     // cudaStreamDestroy(new_stream);
 }
@@ -400,7 +527,7 @@ void DEMKinematicThread::resetUserCallStat() {
 }
 
 size_t DEMKinematicThread::estimateMemUsage() const {
-    return m_approx_bytes_used;
+    return memRegistry.GetTotalBytes();
 }
 
 // Put sim data array pointers in place
@@ -422,6 +549,21 @@ void DEMKinematicThread::packDataPointers() {
     granData->previous_idGeometryB = previous_idGeometryB.data();
     granData->previous_contactType = previous_contactType.data();
     granData->contactMapping = contactMapping.data();
+    granData->verletIdGeometryA = verletIdGeometryA.data();
+    granData->verletIdGeometryB = verletIdGeometryB.data();
+    granData->verletContactType = verletContactType.data();
+    granData->verletVoxelID = verletVoxelID.data();
+    granData->verletLocX = verletLocX.data();
+    granData->verletLocY = verletLocY.data();
+    granData->verletLocZ = verletLocZ.data();
+    granData->verletOriQw = verletOriQw.data();
+    granData->verletOriQx = verletOriQx.data();
+    granData->verletOriQy = verletOriQy.data();
+    granData->verletOriQz = verletOriQz.data();
+    granData->verletMarginSize = verletMarginSize.data();
+    granData->verletFamilyID = verletFamilyID.data();
+    granData->verletOwnerExtent = verletOwnerExtent.data();
+    granData->sphereBinLevel = sphereBinLevel.data();
     granData->familyMasks = familyMaskMatrix.data();
     granData->familyExtraMarginSize = familyExtraMarginSize.data();
 
@@ -506,6 +648,8 @@ void DEMKinematicThread::setSimParams(unsigned char nvXp2,
     simParams->nbZ = nbZ;
     simParams->userBoxMin = user_box_min;
     simParams->userBoxMax = user_box_max;
+    // Solver flags and the largest sphere radius are in place by now
+    updateBinLevels();
 
     simParams->nContactWildcards = contact_wildcards.size();
     simParams->nOwnerWildcards = owner_wildcards.size();
@@ -541,36 +685,154 @@ void DEMKinematicThread::allocateManagedArrays(size_t nOwnerBodies,
     simParams->nDistinctClumpComponents = nClumpComponents;
     simParams->nMatTuples = nMatTuples;
 
+    // If the user instructed a capacity, the arrays are made that long first, then the resizing below is just a change
+    // of size. Otherwise, the arrays grow geometrically as they are resized.
+    reserveManagedArrays();
+
+    // Whatever this allocation is for (new clumps or meshes), the contact candidates found before do not have it, so
+    // they are no good
+    verletCandidatesValid = false;
+
+    ManagedArraySizes n;
+    n.nOwnerBodies = nOwnerBodies;
+    n.nSpheresGM = nSpheresGM;
+    n.nTriGM = nTriGM;
+    n.nAnalGM = nAnalGM;
+    n.nMassProperties = nMassProperties;
+    n.nClumpComponents = nClumpComponents;
+    n.nContacts = DEME_MAX(*stateOfSolver_resources.pNumPrevContacts, nSpheresGM * DEME_INIT_CNT_MULTIPLIER);
+    n.nContactWildcards = simParams->nContactWildcards;
+    n.nOwnerWildcards = simParams->nOwnerWildcards;
+    n.nGeoWildcards = simParams->nGeoWildcards;
+    n.isHistoryless = solverFlags.isHistoryless;
+    n.useVerletSkin = (simParams->verletSkin > 0.);
+    n.canFamilyChange = solverFlags.canFamilyChange;
+    n.useClumpJitify = solverFlags.useClumpJitify;
+    resizeManagedArrays(n);
+    resizeTransferBuffers(n);
+}
+
+void DEMKinematicThread::sizeManagedArrays(const ManagedArraySizes& n,
+                                           MemoryRegistry& registry,
+                                           MemoryRegistry& dT_registry) {
+    {
+        MemorySizingScope sizing(registry);
+        resizeManagedArrays(n);
+        resizeTransferBuffers(n);
+    }
+    MemorySizingScope sizing(dT_registry);
+    transferArraysResize(n.nContacts, !n.isHistoryless);
+}
+
+void DEMKinematicThread::resizeManagedArrays(const ManagedArraySizes& n) {
     // Resize the family mask `matrix' (in fact it is flattened)
     DEME_TRACKED_RESIZE_DEBUGPRINT(familyMaskMatrix, (NUM_AVAL_FAMILIES + 1) * NUM_AVAL_FAMILIES / 2,
                                    "familyMaskMatrix", DONT_PREVENT_CONTACT);
 
     // Resize to the number of clumps
-    DEME_TRACKED_RESIZE_DEBUGPRINT(familyID, nOwnerBodies, "familyID", 0);
-    DEME_TRACKED_RESIZE_DEBUGPRINT(voxelID, nOwnerBodies, "voxelID", 0);
-    DEME_TRACKED_RESIZE_DEBUGPRINT(locX, nOwnerBodies, "locX", 0);
-    DEME_TRACKED_RESIZE_DEBUGPRINT(locY, nOwnerBodies, "locY", 0);
-    DEME_TRACKED_RESIZE_DEBUGPRINT(locZ, nOwnerBodies, "locZ", 0);
-    DEME_TRACKED_RESIZE_DEBUGPRINT(oriQw, nOwnerBodies, "oriQw", 1);
-    DEME_TRACKED_RESIZE_DEBUGPRINT(oriQx, nOwnerBodies, "oriQx", 0);
-    DEME_TRACKED_RESIZE_DEBUGPRINT(oriQy, nOwnerBodies, "oriQy", 0);
-    DEME_TRACKED_RESIZE_DEBUGPRINT(oriQz, nOwnerBodies, "oriQz", 0);
-    DEME_TRACKED_RESIZE_DEBUGPRINT(marginSize, nOwnerBodies, "marginSize", 0);
+    DEME_TRACKED_RESIZE_DEBUGPRINT(familyID, n.nOwnerBodies, "familyID", 0);
+    DEME_TRACKED_RESIZE_DEBUGPRINT(voxelID, n.nOwnerBodies, "voxelID", 0);
+    DEME_TRACKED_RESIZE_DEBUGPRINT(locX, n.nOwnerBodies, "locX", 0);
+    DEME_TRACKED_RESIZE_DEBUGPRINT(locY, n.nOwnerBodies, "locY", 0);
+    DEME_TRACKED_RESIZE_DEBUGPRINT(locZ, n.nOwnerBodies, "locZ", 0);
+    DEME_TRACKED_RESIZE_DEBUGPRINT(oriQw, n.nOwnerBodies, "oriQw", 1);
+    DEME_TRACKED_RESIZE_DEBUGPRINT(oriQx, n.nOwnerBodies, "oriQx", 0);
+    DEME_TRACKED_RESIZE_DEBUGPRINT(oriQy, n.nOwnerBodies, "oriQy", 0);
+    DEME_TRACKED_RESIZE_DEBUGPRINT(oriQz, n.nOwnerBodies, "oriQz", 0);
+    DEME_TRACKED_RESIZE_DEBUGPRINT(marginSize, n.nOwnerBodies, "marginSize", 0);
+
+    // Owner states at the time the contact candidates were found, if they are to be reused
+    if (n.useVerletSkin) {
+        DEME_TRACKED_RESIZE_DEBUGPRINT(verletVoxelID, n.nOwnerBodies, "verletVoxelID", 0);
+        DEME_TRACKED_RESIZE_DEBUGPRINT(verletLocX, n.nOwnerBodies, "verletLocX", 0);
+        DEME_TRACKED_RESIZE_DEBUGPRINT(verletLocY, n.nOwnerBodies, "verletLocY", 0);
+        DEME_TRACKED_RESIZE_DEBUGPRINT(verletLocZ, n.nOwnerBodies, "verletLocZ", 0);
+        DEME_TRACKED_RESIZE_DEBUGPRINT(verletOriQw, n.nOwnerBodies, "verletOriQw", 1);
+        DEME_TRACKED_RESIZE_DEBUGPRINT(verletOriQx, n.nOwnerBodies, "verletOriQx", 0);
+        DEME_TRACKED_RESIZE_DEBUGPRINT(verletOriQy, n.nOwnerBodies, "verletOriQy", 0);
+        DEME_TRACKED_RESIZE_DEBUGPRINT(verletOriQz, n.nOwnerBodies, "verletOriQz", 0);
+        DEME_TRACKED_RESIZE_DEBUGPRINT(verletMarginSize, n.nOwnerBodies, "verletMarginSize", 0);
+        DEME_TRACKED_RESIZE_DEBUGPRINT(verletFamilyID, n.nOwnerBodies, "verletFamilyID", 0);
+        DEME_TRACKED_RESIZE_DEBUGPRINT(verletOwnerExtent, n.nOwnerBodies, "verletOwnerExtent", 0);
+    }
 
+    // Resize to the number of spheres (or plus num of triangle facets)
+    DEME_TRACKED_RESIZE_DEBUGPRINT(ownerClumpBody, n.nSpheresGM, "ownerClumpBody", 0);
+    DEME_TRACKED_RESIZE_DEBUGPRINT(sphereBinLevel, n.nSpheresGM, "sphereBinLevel", 0);
+
+    // Resize to the number of triangle facets
+    DEME_TRACKED_RESIZE_DEBUGPRINT(ownerMesh, n.nTriGM, "ownerMesh", 0);
+    DEME_TRACKED_RESIZE_DEBUGPRINT(relPosNode1, n.nTriGM, "relPosNode1", make_float3(0));
+    DEME_TRACKED_RESIZE_DEBUGPRINT(relPosNode2, n.nTriGM, "relPosNode2", make_float3(0));
+    DEME_TRACKED_RESIZE_DEBUGPRINT(relPosNode3, n.nTriGM, "relPosNode3", make_float3(0));
+
+    if (n.useClumpJitify) {
+        DEME_TRACKED_RESIZE_DEBUGPRINT(clumpComponentOffset, n.nSpheresGM, "clumpComponentOffset", 0);
+        // This extended component offset array can hold offset numbers even for big clumps (whereas
+        // clumpComponentOffset is typically uint_8, so it may not). If a sphere's component offset index falls in this
+        // range then it is not jitified, and the kernel needs to look for it in the global memory.
+        DEME_TRACKED_RESIZE_DEBUGPRINT(clumpComponentOffsetExt, n.nSpheresGM, "clumpComponentOffsetExt", 0);
+        // Resize to the length of the clump templates
+        DEME_TRACKED_RESIZE_DEBUGPRINT(radiiSphere, n.nClumpComponents, "radiiSphere", 0);
+        DEME_TRACKED_RESIZE_DEBUGPRINT(relPosSphereX, n.nClumpComponents, "relPosSphereX", 0);
+        DEME_TRACKED_RESIZE_DEBUGPRINT(relPosSphereY, n.nClumpComponents, "relPosSphereY", 0);
+        DEME_TRACKED_RESIZE_DEBUGPRINT(relPosSphereZ, n.nClumpComponents, "relPosSphereZ", 0);
+    } else {
+        DEME_TRACKED_RESIZE_DEBUGPRINT(radiiSphere, n.nSpheresGM, "radiiSphere", 0);
+        DEME_TRACKED_RESIZE_DEBUGPRINT(relPosSphereX, n.nSpheresGM, "relPosSphereX", 0);
+        DEME_TRACKED_RESIZE_DEBUGPRINT(relPosSphereY, n.nSpheresGM, "relPosSphereY", 0);
+        DEME_TRACKED_RESIZE_DEBUGPRINT(relPosSphereZ, n.nSpheresGM, "relPosSphereZ", 0);
+    }
+
+    // Arrays for kT produced contact info
+    // The following several arrays will have variable sizes, so here we only used an estimate. My estimate of total
+    // contact pairs is 2n, and I think the max is 6n (although I can't prove it). Note the estimate should be large
+    // enough to decrease the number of reallocations in the simulation, but not too large that eats too much memory.
+    {
+        const size_t cnt_arr_size = n.nContacts;
+        DEME_TRACKED_RESIZE_DEBUGPRINT(idGeometryA, cnt_arr_size, "idGeometryA", 0);
+        DEME_TRACKED_RESIZE_DEBUGPRINT(idGeometryB, cnt_arr_size, "idGeometryB", 0);
+        DEME_TRACKED_RESIZE_DEBUGPRINT(contactType, cnt_arr_size, "contactType", NOT_A_CONTACT);
+        if (!n.isHistoryless) {
+            DEME_TRACKED_RESIZE_DEBUGPRINT(previous_idGeometryA, cnt_arr_size, "previous_idGeometryA", 0);
+            DEME_TRACKED_RESIZE_DEBUGPRINT(previous_idGeometryB, cnt_arr_size, "previous_idGeometryB", 0);
+            DEME_TRACKED_RESIZE_DEBUGPRINT(previous_contactType, cnt_arr_size, "previous_contactType", NOT_A_CONTACT);
+            DEME_TRACKED_RESIZE_DEBUGPRINT(contactMapping, cnt_arr_size, "contactMapping", NULL_MAPPING_PARTNER);
+        }
+    }
+}
+
+void DEMKinematicThread::resizeTransferBuffers(const ManagedArraySizes& n) {
     // Transfer buffer arrays
-    // It is cudaMalloc-ed memory, not managed, because we want explicit locality control of buffers
+    // It is cudaMalloc-ed memory, not managed, because we want explicit locality control of buffers. Their content is
+    // re-filled by dT at each send, so they are only re-allocated when they have to grow (geometrically, or to the
+    // reserved capacity).
+    // When only sizing, the buffers are counted at exactly the requested length and the capacities stay untouched.
+    const bool sizing = (memSizingRegistry != nullptr);
+    const size_t nOwnerBodies = n.nOwnerBodies;
+    const size_t nTriGM = n.nTriGM;
     {
         // These buffers should be on dT, to save dT access time
-        DEME_GPU_CALL(cudaSetDevice(dT->streamInfo.device));
-        DEME_DEVICE_PTR_ALLOC(granData->voxelID_buffer, nOwnerBodies);
-        DEME_DEVICE_PTR_ALLOC(granData->locX_buffer, nOwnerBodies);
-        DEME_DEVICE_PTR_ALLOC(granData->locY_buffer, nOwnerBodies);
-        DEME_DEVICE_PTR_ALLOC(granData->locZ_buffer, nOwnerBodies);
-        DEME_DEVICE_PTR_ALLOC(granData->oriQ0_buffer, nOwnerBodies);
-        DEME_DEVICE_PTR_ALLOC(granData->oriQ1_buffer, nOwnerBodies);
-        DEME_DEVICE_PTR_ALLOC(granData->oriQ2_buffer, nOwnerBodies);
-        DEME_DEVICE_PTR_ALLOC(granData->oriQ3_buffer, nOwnerBodies);
-        DEME_DEVICE_PTR_ALLOC(granData->absVel_buffer, nOwnerBodies);
+        if (!sizing) {
+            DEME_GPU_CALL(cudaSetDevice(dT->streamInfo.device));
+        }
+        size_t ownerCapacity = sizing ? 0 : ownerBufferCapacity;
+        size_t facetCapacity = sizing ? 0 : facetBufferCapacity;
+        bool owner_buffers_grow = (nOwnerBodies > ownerCapacity);
+        if (owner_buffers_grow) {
+            ownerCapacity = sizing ? nOwnerBodies
+                                   : DEME_MAX(DEME_MAX(nOwnerBodies, reservedOwners),
+                                              (size_t)(DEME_BUFFER_GROWTH_FACTOR * ownerCapacity));
+            DEME_DEVICE_PTR_ALLOC(granData->voxelID_buffer, ownerCapacity, memRegistry, "voxelID_buffer");
+            DEME_DEVICE_PTR_ALLOC(granData->locX_buffer, ownerCapacity, memRegistry, "locX_buffer");
+            DEME_DEVICE_PTR_ALLOC(granData->locY_buffer, ownerCapacity, memRegistry, "locY_buffer");
+            DEME_DEVICE_PTR_ALLOC(granData->locZ_buffer, ownerCapacity, memRegistry, "locZ_buffer");
+            DEME_DEVICE_PTR_ALLOC(granData->oriQ0_buffer, ownerCapacity, memRegistry, "oriQ0_buffer");
+            DEME_DEVICE_PTR_ALLOC(granData->oriQ1_buffer, ownerCapacity, memRegistry, "oriQ1_buffer");
+            DEME_DEVICE_PTR_ALLOC(granData->oriQ2_buffer, ownerCapacity, memRegistry, "oriQ2_buffer");
+            DEME_DEVICE_PTR_ALLOC(granData->oriQ3_buffer, ownerCapacity, memRegistry, "oriQ3_buffer");
+            DEME_DEVICE_PTR_ALLOC(granData->absVel_buffer, ownerCapacity, memRegistry, "absVel_buffer");
+        }
 
         // DEME_TRACKED_RESIZE_DEBUGPRINT(voxelID_buffer, nOwnerBodies, "voxelID_buffer", 0);
         // DEME_TRACKED_RESIZE_DEBUGPRINT(locX_buffer, nOwnerBodies, "locX_buffer", 0);
@@ -588,63 +850,64 @@ void DEMKinematicThread::allocateManagedArrays(size_t nOwnerBodies,
         // DEME_ADVISE_DEVICE(oriQ1_buffer, dT->streamInfo.device);
         // DEME_ADVISE_DEVICE(oriQ2_buffer, dT->streamInfo.device);
         // DEME_ADVISE_DEVICE(oriQ3_buffer, dT->streamInfo.device);
-        if (solverFlags.canFamilyChange) {
+        if (n.canFamilyChange && (owner_buffers_grow || !granData->familyID_buffer)) {
             // DEME_TRACKED_RESIZE_DEBUGPRINT(familyID_buffer, nOwnerBodies, "familyID_buffer", 0);
             // DEME_ADVISE_DEVICE(familyID_buffer, dT->streamInfo.device);
-            DEME_DEVICE_PTR_ALLOC(granData->familyID_buffer, nOwnerBodies);
+            DEME_DEVICE_PTR_ALLOC(granData->familyID_buffer, ownerCapacity, memRegistry, "familyID_buffer");
         }
 
-        DEME_DEVICE_PTR_ALLOC(granData->relPosNode1_buffer, nTriGM);
-        DEME_DEVICE_PTR_ALLOC(granData->relPosNode2_buffer, nTriGM);
-        DEME_DEVICE_PTR_ALLOC(granData->relPosNode3_buffer, nTriGM);
+        if (nTriGM > facetCapacity) {
+            facetCapacity = sizing ? nTriGM : DEME_MAX(nTriGM, (size_t)(DEME_BUFFER_GROWTH_FACTOR * facetCapacity));
+            DEME_DEVICE_PTR_ALLOC(granData->relPosNode1_buffer, facetCapacity, memRegistry, "relPosNode1_buffer");
+            DEME_DEVICE_PTR_ALLOC(granData->relPosNode2_buffer, facetCapacity, memRegistry, "relPosNode2_buffer");
+            DEME_DEVICE_PTR_ALLOC(granData->relPosNode3_buffer, facetCapacity, memRegistry, "relPosNode3_buffer");
+        }
+        if (sizing) {
+            return;
+        }
+        ownerBufferCapacity = ownerCapacity;
+        facetBufferCapacity = facetCapacity;
 
         // Unset the device change we just did
         DEME_GPU_CALL(cudaSetDevice(streamInfo.device));
     }
+}
 
-    // Resize to the number of spheres (or plus num of triangle facets)
-    DEME_TRACKED_RESIZE_DEBUGPRINT(ownerClumpBody, nSpheresGM, "ownerClumpBody", 0);
-
-    // Resize to the number of triangle facets
-    DEME_TRACKED_RESIZE_DEBUGPRINT(ownerMesh, nTriGM, "ownerMesh", 0);
-    DEME_TRACKED_RESIZE_DEBUGPRINT(relPosNode1, nTriGM, "relPosNode1", make_float3(0));
-    DEME_TRACKED_RESIZE_DEBUGPRINT(relPosNode2, nTriGM, "relPosNode2", make_float3(0));
-    DEME_TRACKED_RESIZE_DEBUGPRINT(relPosNode3, nTriGM, "relPosNode3", make_float3(0));
-
+void DEMKinematicThread::reserveManagedArrays() {
+    // Per-owner arrays
+    DEME_TRACKED_RESERVE(familyID, reservedOwners, "familyID");
+    DEME_TRACKED_RESERVE(voxelID, reservedOwners, "voxelID");
+    DEME_TRACKED_RESERVE(locX, reservedOwners, "locX");
+    DEME_TRACKED_RESERVE(locY, reservedOwners, "locY");
+    DEME_TRACKED_RESERVE(locZ, reservedOwners, "locZ");
+    DEME_TRACKED_RESERVE(oriQw, reservedOwners, "oriQw");
+    DEME_TRACKED_RESERVE(oriQx, reservedOwners, "oriQx");
+    DEME_TRACKED_RESERVE(oriQy, reservedOwners, "oriQy");
+    DEME_TRACKED_RESERVE(oriQz, reservedOwners, "oriQz");
+    DEME_TRACKED_RESERVE(marginSize, reservedOwners, "marginSize");
+
+    // Per-sphere arrays
+    DEME_TRACKED_RESERVE(ownerClumpBody, reservedSpheres, "ownerClumpBody");
+    DEME_TRACKED_RESERVE(sphereBinLevel, reservedSpheres, "sphereBinLevel");
     if (solverFlags.useClumpJitify) {
-        DEME_TRACKED_RESIZE_DEBUGPRINT(clumpComponentOffset, nSpheresGM, "clumpComponentOffset", 0);
-        // This extended component offset array can hold offset numbers even for big clumps (whereas
-        // clumpComponentOffset is typically uint_8, so it may not). If a sphere's component offset index falls in this
-        // range then it is not jitified, and the kernel needs to look for it in the global memory.
-        DEME_TRACKED_RESIZE_DEBUGPRINT(clumpComponentOffsetExt, nSpheresGM, "clumpComponentOffsetExt", 0);
-        // Resize to the length of the clump templates
-        DEME_TRACKED_RESIZE_DEBUGPRINT(radiiSphere, nClumpComponents, "radiiSphere", 0);
-        DEME_TRACKED_RESIZE_DEBUGPRINT(relPosSphereX, nClumpComponents, "relPosSphereX", 0);
-        DEME_TRACKED_RESIZE_DEBUGPRINT(relPosSphereY, nClumpComponents, "relPosSphereY", 0);
-        DEME_TRACKED_RESIZE_DEBUGPRINT(relPosSphereZ, nClumpComponents, "relPosSphereZ", 0);
+        DEME_TRACKED_RESERVE(clumpComponentOffset, reservedSpheres, "clumpComponentOffset");
+        DEME_TRACKED_RESERVE(clumpComponentOffsetExt, reservedSpheres, "clumpComponentOffsetExt");
     } else {
-        DEME_TRACKED_RESIZE_DEBUGPRINT(radiiSphere, nSpheresGM, "radiiSphere", 0);
-        DEME_TRACKED_RESIZE_DEBUGPRINT(relPosSphereX, nSpheresGM, "relPosSphereX", 0);
-        DEME_TRACKED_RESIZE_DEBUGPRINT(relPosSphereY, nSpheresGM, "relPosSphereY", 0);
-        DEME_TRACKED_RESIZE_DEBUGPRINT(relPosSphereZ, nSpheresGM, "relPosSphereZ", 0);
+        DEME_TRACKED_RESERVE(radiiSphere, reservedSpheres, "radiiSphere");
+        DEME_TRACKED_RESERVE(relPosSphereX, reservedSpheres, "relPosSphereX");
+        DEME_TRACKED_RESERVE(relPosSphereY, reservedSpheres, "relPosSphereY");
+        DEME_TRACKED_RESERVE(relPosSphereZ, reservedSpheres, "relPosSphereZ");
     }
 
-    // Arrays for kT produced contact info
-    // The following several arrays will have variable sizes, so here we only used an estimate. My estimate of total
-    // contact pairs is 2n, and I think the max is 6n (although I can't prove it). Note the estimate should be large
-    // enough to decrease the number of reallocations in the simulation, but not too large that eats too much memory.
-    {
-        size_t cnt_arr_size =
-            DEME_MAX(*stateOfSolver_resources.pNumPrevContacts, nSpheresGM * DEME_INIT_CNT_MULTIPLIER);
-        DEME_TRACKED_RESIZE_DEBUGPRINT(idGeometryA, cnt_arr_size, "idGeometryA", 0);
-        DEME_TRACKED_RESIZE_DEBUGPRINT(idGeometryB, cnt_arr_size, "idGeometryB", 0);
-        DEME_TRACKED_RESIZE_DEBUGPRINT(contactType, cnt_arr_size, "contactType", NOT_A_CONTACT);
-        if (!solverFlags.isHistoryless) {
-            DEME_TRACKED_RESIZE_DEBUGPRINT(previous_idGeometryA, cnt_arr_size, "previous_idGeometryA", 0);
-            DEME_TRACKED_RESIZE_DEBUGPRINT(previous_idGeometryB, cnt_arr_size, "previous_idGeometryB", 0);
-            DEME_TRACKED_RESIZE_DEBUGPRINT(previous_contactType, cnt_arr_size, "previous_contactType", NOT_A_CONTACT);
-            DEME_TRACKED_RESIZE_DEBUGPRINT(contactMapping, cnt_arr_size, "contactMapping", NULL_MAPPING_PARTNER);
-        }
+    // Per-contact arrays
+    DEME_TRACKED_RESERVE(idGeometryA, reservedContacts, "idGeometryA");
+    DEME_TRACKED_RESERVE(idGeometryB, reservedContacts, "idGeometryB");
+    DEME_TRACKED_RESERVE(contactType, reservedContacts, "contactType");
+    if (!solverFlags.isHistoryless) {
+        DEME_TRACKED_RESERVE(previous_idGeometryA, reservedContacts, "previous_idGeometryA");
+        DEME_TRACKED_RESERVE(previous_idGeometryB, reservedContacts, "previous_idGeometryB");
+        DEME_TRACKED_RESERVE(previous_contactType, reservedContacts, "previous_contactType");
+        DEME_TRACKED_RESERVE(contactMapping, reservedContacts, "contactMapping");
     }
 }
 
@@ -861,26 +1124,28 @@ void DEMKinematicThread::initAllocation() {
 }
 
 void DEMKinematicThread::deallocateEverything() {
-    DEME_DEVICE_PTR_DEALLOC(dT->granData->idGeometryA_buffer);
-    DEME_DEVICE_PTR_DEALLOC(dT->granData->idGeometryB_buffer);
-    DEME_DEVICE_PTR_DEALLOC(dT->granData->contactType_buffer);
-    DEME_DEVICE_PTR_DEALLOC(dT->granData->contactMapping_buffer);
-
-    DEME_DEVICE_PTR_DEALLOC(granData->voxelID_buffer);
-    DEME_DEVICE_PTR_DEALLOC(granData->locX_buffer);
-    DEME_DEVICE_PTR_DEALLOC(granData->locY_buffer);
-    DEME_DEVICE_PTR_DEALLOC(granData->locZ_buffer);
-    DEME_DEVICE_PTR_DEALLOC(granData->oriQ0_buffer);
-    DEME_DEVICE_PTR_DEALLOC(granData->oriQ1_buffer);
-    DEME_DEVICE_PTR_DEALLOC(granData->oriQ2_buffer);
-    DEME_DEVICE_PTR_DEALLOC(granData->oriQ3_buffer);
-    DEME_DEVICE_PTR_DEALLOC(granData->absVel_buffer);
-
-    DEME_DEVICE_PTR_DEALLOC(granData->familyID_buffer);
-
-    DEME_DEVICE_PTR_DEALLOC(granData->relPosNode1_buffer);
-    DEME_DEVICE_PTR_DEALLOC(granData->relPosNode2_buffer);
-    DEME_DEVICE_PTR_DEALLOC(granData->relPosNode3_buffer);
+    DEME_DEVICE_PTR_DEALLOC(dT->granData->idGeometryA_buffer, dT->memRegistry, "idGeometryA_buffer");
+    DEME_DEVICE_PTR_DEALLOC(dT->granData->idGeometryB_buffer, dT->memRegistry, "idGeometryB_buffer");
+    DEME_DEVICE_PTR_DEALLOC(dT->granData->contactType_buffer, dT->memRegistry, "contactType_buffer");
+    DEME_DEVICE_PTR_DEALLOC(dT->granData->contactMapping_buffer, dT->memRegistry, "contactMapping_buffer");
+
+    DEME_DEVICE_PTR_DEALLOC(granData->voxelID_buffer, memRegistry, "voxelID_buffer");
+    DEME_DEVICE_PTR_DEALLOC(granData->locX_buffer, memRegistry, "locX_buffer");
+    DEME_DEVICE_PTR_DEALLOC(granData->locY_buffer, memRegistry, "locY_buffer");
+    DEME_DEVICE_PTR_DEALLOC(granData->locZ_buffer, memRegistry, "locZ_buffer");
+    DEME_DEVICE_PTR_DEALLOC(granData->oriQ0_buffer, memRegistry, "oriQ0_buffer");
+    DEME_DEVICE_PTR_DEALLOC(granData->oriQ1_buffer, memRegistry, "oriQ1_buffer");
+    DEME_DEVICE_PTR_DEALLOC(granData->oriQ2_buffer, memRegistry, "oriQ2_buffer");
+    DEME_DEVICE_PTR_DEALLOC(granData->oriQ3_buffer, memRegistry, "oriQ3_buffer");
+    DEME_DEVICE_PTR_DEALLOC(granData->absVel_buffer, memRegistry, "absVel_buffer");
+
+    DEME_DEVICE_PTR_DEALLOC(granData->familyID_buffer, memRegistry, "familyID_buffer");
+
+    DEME_DEVICE_PTR_DEALLOC(granData->relPosNode1_buffer, memRegistry, "relPosNode1_buffer");
+    DEME_DEVICE_PTR_DEALLOC(granData->relPosNode2_buffer, memRegistry, "relPosNode2_buffer");
+    DEME_DEVICE_PTR_DEALLOC(granData->relPosNode3_buffer, memRegistry, "relPosNode3_buffer");
+    ownerBufferCapacity = 0;
+    facetBufferCapacity = 0;
 }
 
 void DEMKinematicThread::setTriNodeRelPos(size_t start, const std::vector<DEMTriangle>& triangles) {
@@ -16,6 +16,7 @@
 #include <core/utils/ManagedAllocator.hpp>
 #include <core/utils/ThreadManager.h>
 #include <core/utils/GpuManager.h>
+#include <core/utils/HostWorkerPool.hpp>
 #include <nvmath/helper_math.cuh>
 #include <core/utils/GpuError.h>
 #include <core/utils/Timer.hpp>
@@ -60,9 +61,22 @@ class DEMKinematicThread {
     GpuManager::StreamInfo streamInfo;
 
     // A class that contains scratch pad and system status data (constructed with the number of temp arrays we need)
-    DEMSolverStateData stateOfSolver_resources = DEMSolverStateData(15);
+    DEMSolverStateData stateOfSolver_resources = DEMSolverStateData(17);
 
-    size_t m_approx_bytes_used = 0;
+    // All arrays, buffers and scratch space this thread holds register their sizes here
+    MemoryRegistry memRegistry = MemoryRegistry("kT");
+
+    // Capacities reserved for the per-owner, per-sphere and per-contact arrays (from InstructNumOwners). As long as
+    // the system stays below them, adding clumps is an append to the arrays, not a re-allocation and copy.
+    size_t reservedOwners = 0;
+    size_t reservedSpheres = 0;
+    size_t reservedContacts = 0;
+    // Capacities of the dT-to-kT owner and facet transfer buffers (which are device pointers, not vectors)
+    size_t ownerBufferCapacity = 0;
+    size_t facetBufferCapacity = 0;
+
+    // Ranges of the flattened triangle soup that dT sent deformed, and kT is yet to unpack
+    DirtyRanges meshDirtyRanges;
 
     // kT should break out of its inner loop and return to a state where it awaits a `start' call at the outer loop
     bool kTShouldReset = false;
@@ -173,6 +187,41 @@ class DEMKinematicThread {
     std::vector<contact_t, ManagedAllocator<contact_t>> previous_contactType;
     std::vector<contactPairs_t, ManagedAllocator<contactPairs_t>> contactMapping;
 
+    // Verlet-style contact candidates (used only if the skin is set): the pairs found with the skin added to the
+    // margins, sorted by idA. Until some owner drifts too far from where it was when they were found, kT refilters
+    // these rather than binning again.
+    std::vector<bodyID_t, ManagedAllocator<bodyID_t>> verletIdGeometryA;
+    std::vector<bodyID_t, ManagedAllocator<bodyID_t>> verletIdGeometryB;
+    std::vector<contact_t, ManagedAllocator<contact_t>> verletContactType;
+    // The owner states at the time these candidates were found
+    std::vector<voxelID_t, ManagedAllocator<voxelID_t>> verletVoxelID;
+    std::vector<subVoxelPos_t, ManagedAllocator<subVoxelPos_t>> verletLocX;
+    std::vector<subVoxelPos_t, ManagedAllocator<subVoxelPos_t>> verletLocY;
+    std::vector<subVoxelPos_t, ManagedAllocator<subVoxelPos_t>> verletLocZ;
+    std::vector<oriQ_t, ManagedAllocator<oriQ_t>> verletOriQw;
+    std::vector<oriQ_t, ManagedAllocator<oriQ_t>> verletOriQx;
+    std::vector<oriQ_t, ManagedAllocator<oriQ_t>> verletOriQy;
+    std::vector<oriQ_t, ManagedAllocator<oriQ_t>> verletOriQz;
+    std::vector<float, ManagedAllocator<float>> verletMarginSize;
+    std::vector<family_t, ManagedAllocator<family_t>> verletFamilyID;
+    // Max distance from an owner's CoM to any point of its geometries, which bounds how far a rotation moves them
+    std::vector<float, ManagedAllocator<float>> verletOwnerExtent;
+    // Number of stored candidates, and whether they are still good for the system as it is now (changing the system
+    // from the API, such as adding clumps or changing family masks, invalidates them)
+    size_t nVerletCandidates = 0;
+    bool verletCandidatesValid = false;
+
+    // The sorted bin--sphere pairs and sphere bin ranges of the last binning (used only with incremental binning)
+    SphereBinningRecord sphereBinningRecord;
+
+    // The level of bins each sphere is binned in, as decided at the last binning
+    std::vector<unsigned char, ManagedAllocator<unsigned char>> sphereBinLevel;
+
+    // The analytical entities, for contact detection on host threads (the device has them jitified)
+    HostAnalyticalEntities hostAnalEntities;
+    // The threads that run contact detection on the host, kept between runs
+    HostWorkerPool hostCDWorkers;
+
     // Sphere-related arrays in managed memory
     // Owner body ID of this component
     std::vector<bodyID_t, ManagedAllocator<bodyID_t>> ownerClumpBody;
@@ -186,10 +235,13 @@ class DEMKinematicThread {
     // The ID that maps this analytical entity component's geometry-defining parameters, when this component is jitified
     // std::vector<clumpComponentOffset_t, ManagedAllocator<clumpComponentOffset_t>> analComponentOffset;
 
-    // kT's timers
+    // kT's timers (in the order of KT_TIMER), then the sub-steps of contact detection that only the profiler records
     std::vector<std::string> timer_names = {"Discretize domain",      "Find contact pairs", "Build history map",
                                             "Unpack updates from dT", "Send to dT buffer",  "Wait for dT update"};
-    SolverTimers timers = SolverTimers(timer_names);
+    std::vector<std::string> scope_names = {"Bin spheres",            "Sort bin--sphere pairs",
+                                            "Bin triangles",          "Sort contacts by owner",
+                                            "Persistent contact map", "Sort contacts by type"};
+    SolverTimers timers = SolverTimers("kT", timer_names, scope_names);
 
     kTStateParams stateParams;
 
@@ -205,6 +257,9 @@ class DEMKinematicThread {
         // Get a device/stream ID to use from the GPU Manager
         streamInfo = pGpuDistributor->getAvailableStream();
 
+        // Scratch space and temp arrays report to this thread's memory registry
+        stateOfSolver_resources.memRegistry = &memRegistry;
+
         pPagerToMain->userCallDone = false;
         pSchedSupport->kinematicShouldJoin = false;
         pSchedSupport->kinematicStarted = false;
@@ -252,7 +307,7 @@ class DEMKinematicThread {
 
     /// Reset kT--dT interaction coordinator stats
     void resetUserCallStat();
-    /// Return the approximate RAM usage
+    /// Return the memory usage (in bytes) of all arrays, buffers and scratch space registered by this thread
     size_t estimateMemUsage() const;
 
     /// Resize managed arrays (and perhaps Instruct/Suggest their preferred residence location as well?)
@@ -269,6 +324,17 @@ class DEMKinematicThread {
                                unsigned int nClumpComponents,
                                unsigned int nJitifiableClumpComponents,
                                unsigned int nMatTuples);
+    /// Resize the managed arrays to these numbers of entities. It is the one place that decides the arrays' sizes, for
+    /// both the allocation and the memory prediction.
+    void resizeManagedArrays(const ManagedArraySizes& n);
+    /// Make the dT-to-kT transfer buffers hold at least this many owners and facets
+    void resizeTransferBuffers(const ManagedArraySizes& n);
+    /// Record in registry the sizes that the managed arrays and the dT-to-kT transfer buffers would take for these
+    /// numbers of entities and solver flags, without allocating anything. The kT-to-dT contact buffers are dT's, so
+    /// they are recorded in dT_registry.
+    void sizeManagedArrays(const ManagedArraySizes& n, MemoryRegistry& registry, MemoryRegistry& dT_registry);
+    /// Reserve the capacities in reservedOwners, reservedSpheres and reservedContacts for the arrays
+    void reserveManagedArrays();
 
     // initManagedArrays's components
     void registerPolicies(const std::vector<notStupidBool_t>& family_mask_matrix);
@@ -339,11 +405,7 @@ class DEMKinematicThread {
     void getTiming(std::vector<std::string>& names, std::vector<double>& vals);
 
     /// Reset the timers
-    void resetTimers() {
-        for (const auto& name : timer_names) {
-            timers.GetTimer(name).reset();
-        }
-    }
+    void resetTimers() { timers.Reset(); }
 
     /// Change all entities with (user-level) family number ID_from to have a new number ID_to
     void changeFamily(unsigned int ID_from, unsigned int ID_to);
@@ -364,6 +426,9 @@ class DEMKinematicThread {
     /// Update (overwrite) kT's previous contact array based on input
     void updatePrevContactArrays(DEMDataDT* dT_data, size_t nContacts);
 
+    /// Force the next contact detection to bin again, rather than reusing the Verlet-style contact candidates
+    void invalidateContactCandidates() { verletCandidatesValid = false; }
+
   private:
     const std::string Name = "kT";
 
@@ -371,10 +436,18 @@ class DEMKinematicThread {
     inline void unpackMyBuffer();
     // Send produced data to dT-owned biffers
     void sendToTheirBuffer();
-    // Resize dT's buffer arrays based on the number of contact pairs
-    inline void transferArraysResize(size_t nContactPairs);
+    // Resize dT's buffer arrays based on the number of contact pairs (and the contact mapping buffer, if withMapping)
+    inline void transferArraysResize(size_t nContactPairs, bool withMapping);
     // Automatic adjustments to sim params
     void calibrateParams();
+    // Work out the levels of bins (just 1 unless hierarchical binning is in use) for the current bin size, and the
+    // total number of bins
+    void updateBinLevels();
+    // Whether the stored contact candidates can be reused at this CD step, as no owner drifted too far since they were
+    // found
+    bool checkContactCandidates();
+    // Record the owner states at the time the contact candidates are found, then add the skin to the margins
+    void recordContactCandidateStates();
     // The kT-side allocations that can be done at initialization time
     void initAllocation();
     // Deallocate everything
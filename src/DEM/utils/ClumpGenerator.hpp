@@ -0,0 +1,316 @@
+//  Copyright (c) 2021, SBEL GPU Development Team
+//  Copyright (c) 2021, University of Wisconsin - Madison
+//
+//	SPDX-License-Identifier: BSD-3-Clause
+
+#ifndef DEME_CLUMP_GENERATOR_HPP
+#define DEME_CLUMP_GENERATOR_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <queue>
+#include <thread>
+#include <vector>
+
+#include <nvmath/helper_math.cuh>
+#include <DEM/Structs.h>
+#include <DEM/BdrsAndObjs.h>
+#include <DEM/HostSideHelpers.hpp>
+
+namespace deme {
+
+/// Settings of DEMClumpFromMesh. Sphere placement stops at whichever of max_spheres and volume_tolerance is hit first.
+struct ClumpFromMeshSettings {
+    /// The sphere budget: max number of sphere components in the generated clump template
+    unsigned int max_spheres = 16;
+    /// Stop adding spheres once the fraction of the shape's volume that is not covered by any sphere drops below this
+    float volume_tolerance = 0.02;
+    /// Number of voxels along the longest side of the mesh's bounding box
+    unsigned int resolution = 64;
+    /// No sphere smaller than this is placed (0 means the size of one voxel)
+    float min_radius = 0.f;
+    /// Density used to turn the mesh's volume and inertia into the clump's mass and MOI
+    float density = 1.f;
+    /// Number of worker threads (0 means all hardware threads). The result does not depend on it.
+    unsigned int num_threads = 0;
+};
+
+/// What DEMClumpFromMesh achieved
+struct ClumpFromMeshReport {
+    unsigned int num_spheres = 0;
+    /// Fraction of the shape's (voxelized) volume that is not covered by any sphere
+    double uncovered_volume_fraction = 1.0;
+    /// Edge length of the voxels used
+    float voxel_size = 0.f;
+    /// Centroid and principal axes of the mesh (in the mesh's own frame), which are the clump's frame. A clump placed
+    /// at center with orientation principal_Q covers the mesh as it is placed in its own frame.
+    float3 center = make_float3(0.f);
+    float4 principal_Q = host_make_float4(0, 0, 0, 1);
+};
+
+namespace clump_gen_detail {
+
+// Run fn(begin, end) on num_threads contiguous, static slices of [0, n). Every index is owned by one slice, so as
+// long as fn only writes to its own indices, the result is the same regardless of the number of threads.
+template <typename Func>
+inline void parallelFor(size_t n, unsigned int num_threads, Func&& fn) {
+    size_t n_slices = std::max<size_t>(1, std::min<size_t>(num_threads, n));
+    if (n_slices == 1) {
+        fn((size_t)0, n);
+        return;
+    }
+    std::vector<std::thread> workers;
+    for (size_t i = 0; i < n_slices; i++)
+        workers.emplace_back([&fn, i, n, n_slices]() { fn(n * i / n_slices, n * (i + 1) / n_slices); });
+    for (auto& w : workers)
+        w.join();
+}
+
+// 1D squared Euclidean distance transform of a sampled function (Felzenszwalb and Huttenlocher), with stride
+inline void distTransform1D(double* f, size_t n, size_t stride, std::vector<double>& buf_f, std::vector<int>& v,
+                            std::vector<double>& z) {
+    const double INF = 1e20;
+    for (size_t q = 0; q < n; q++)
+        buf_f[q] = f[q * stride];
+    int k = 0;
+    v[0] = 0;
+    z[0] = -INF;
+    z[1] = INF;
+    for (int q = 1; q < (int)n; q++) {
+        double s = ((buf_f[q] + (double)q * q) - (buf_f[v[k]] + (double)v[k] * v[k])) / (2.0 * q - 2.0 * v[k]);
+        while (s <= z[k]) {
+            k--;
+            s = ((buf_f[q] + (double)q * q) - (buf_f[v[k]] + (double)v[k] * v[k])) / (2.0 * q - 2.0 * v[k]);
+        }
+        k++;
+        v[k] = q;
+        z[k] = s;
+        z[k + 1] = INF;
+    }
+    k = 0;
+    for (int q = 0; q < (int)n; q++) {
+        while (z[k + 1] < q)
+            k++;
+        f[q * stride] = (double)(q - v[k]) * (q - v[k]) + buf_f[v[k]];
+    }
+}
+
+}  // namespace clump_gen_detail
+
+/// Generate a clump template that approximates a closed triangle mesh with spheres. The mesh is voxelized (inside
+/// test by ray parity, so the facet orientation does not matter), a Euclidean distance transform gives each inner
+/// voxel the radius of the largest sphere centered there that stays inside the shape, and spheres are then picked
+/// greedily from the medial (ridge) voxels of that field, each time choosing the one that covers the most of the
+/// not-yet-covered volume. Mass, principal MOI and volume come from ComputeMassProperties of the mesh, and the sphere
+/// positions are given in the mesh's centroid and principal frame, so the mesh need not be in its principal axes. That
+/// frame is reported in report->center and report->principal_Q. The voxelization and the distance transform run on
+/// settings.num_threads threads, and the output is deterministic.
+inline DEMClumpTemplate DEMClumpFromMesh(const DEMMeshConnected& mesh,
+                                         const std::shared_ptr<DEMMaterial>& material,
+                                         const ClumpFromMeshSettings& settings = ClumpFromMeshSettings(),
+                                         ClumpFromMeshReport* report = nullptr) {
+    using namespace clump_gen_detail;
+    if (mesh.GetNumTriangles() == 0) {
+        throw std::runtime_error("DEMClumpFromMesh is given a mesh with no triangles.");
+    }
+    unsigned int num_threads = settings.num_threads;
+    if (num_threads == 0)
+        num_threads = std::max(1u, std::thread::hardware_concurrency());
+    const std::vector<float3>& nodes = mesh.m_vertices;
+    const std::vector<int3>& faces = mesh.m_face_v_indices;
+
+    // Voxel grid around the mesh, with one layer of (outside) padding on each side
+    float3 lo = nodes[0], hi = nodes[0];
+    for (const auto& p : nodes) {
+        lo = fminf(lo, p);
+        hi = fmaxf(hi, p);
+    }
+    float3 ext = hi - lo;
+    const double h = std::max(ext.x, std::max(ext.y, ext.z)) / std::max(1u, settings.resolution);
+    const int nx = (int)std::ceil(ext.x / h) + 2;
+    const int ny = (int)std::ceil(ext.y / h) + 2;
+    const int nz = (int)std::ceil(ext.z / h) + 2;
+    const double ox = lo.x - h, oy = lo.y - h, oz = lo.z - h;
+    const size_t n_voxels = (size_t)nx * ny * nz;
+    auto vid = [nx, ny](int i, int j, int k) { return (size_t)i + (size_t)nx * ((size_t)j + (size_t)ny * k); };
+
+    // Bucket triangles by the y-rows of voxel centers they span
+    std::vector<std::vector<size_t>> row_tris(ny);
+    for (size_t t = 0; t < faces.size(); t++) {
+        double y0 = nodes[faces[t].x].y, y1 = nodes[faces[t].y].y, y2 = nodes[faces[t].z].y;
+        int jlo = std::max(0, (int)std::floor((std::min(y0, std::min(y1, y2)) - oy) / h - 0.5));
+        int jhi = std::min(ny - 1, (int)std::ceil((std::max(y0, std::max(y1, y2)) - oy) / h - 0.5));
+        for (int j = jlo; j <= jhi; j++)
+            row_tris[j].push_back(t);
+    }
+
+    // Inside test: cast a ray along x through each row of voxel centers and count crossings. The ray is nudged off the
+    // voxel centers by a tiny amount, so it does not hit mesh edges/nodes that lie exactly on the grid.
+    std::vector<double> dist2(n_voxels);
+    const double INF = 1e20;
+    parallelFor((size_t)ny * nz, num_threads, [&](size_t begin, size_t end) {
+        std::vector<double> hits;
+        for (size_t r = begin; r < end; r++) {
+            int j = (int)(r % ny), k = (int)(r / ny);
+            double y = oy + (j + 0.5) * h + 1.234567e-5 * h;
+            double z = oz + (k + 0.5) * h + 2.345678e-5 * h;
+            hits.clear();
+            for (size_t t : row_tris[j]) {
+                const float3& a = nodes[faces[t].x];
+                const float3& b = nodes[faces[t].y];
+                const float3& c = nodes[faces[t].z];
+                // Barycentric coordinates of (y, z) in the triangle projected to the yz plane
+                double det = ((double)b.y - a.y) * ((double)c.z - a.z) - ((double)c.y - a.y) * ((double)b.z - a.z);
+                if (det == 0.)
+                    continue;
+                double u = ((y - a.y) * ((double)c.z - a.z) - ((double)c.y - a.y) * (z - a.z)) / det;
+                double v = (((double)b.y - a.y) * (z - a.z) - (y - a.y) * ((double)b.z - a.z)) / det;
+                if (u < 0. || v < 0. || u + v > 1.)
+                    continue;
+                hits.push_back(a.x + u * ((double)b.x - a.x) + v * ((double)c.x - a.x));
+            }
+            std::sort(hits.begin(), hits.end());
+            size_t n_passed = 0;
+            for (int i = 0; i < nx; i++) {
+                double x = ox + (i + 0.5) * h;
+                while (n_passed < hits.size() && hits[n_passed] < x)
+                    n_passed++;
+                // Outside voxels are the seeds of the distance transform
+                dist2[vid(i, j, k)] = (n_passed % 2 == 1) ? INF : 0.;
+            }
+        }
+    });
+
+    // Squared distance (in voxels) from each voxel center to the nearest outside voxel center, one axis at a time
+    auto transform_axis = [&](int n_line, size_t n_lines, size_t stride, auto line_start) {
+        parallelFor(n_lines, num_threads, [&](size_t begin, size_t end) {
+            std::vector<double> buf_f(n_line), z(n_line + 1);
+            std::vector<int> v(n_line);
+            for (size_t l = begin; l < end; l++)
+                distTransform1D(dist2.data() + line_start(l), n_line, stride, buf_f, v, z);
+        });
+    };
+    transform_axis(nx, (size_t)ny * nz, 1, [&](size_t l) { return vid(0, (int)(l % ny), (int)(l / ny)); });
+    transform_axis(ny, (size_t)nx * nz, (size_t)nx, [&](size_t l) { return vid((int)(l % nx), 0, (int)(l / nx)); });
+    transform_axis(nz, (size_t)nx * ny, (size_t)nx * ny, [&](size_t l) { return l; });
+
+    // The inscribed radius (in voxels) at an inner voxel: distance to the nearest outside center, less half a voxel
+    auto inscribed_r = [&](size_t id) { return std::sqrt(dist2[id]) - 0.5; };
+    const double min_r = std::max(0.5, settings.min_radius / h);
+    std::vector<char> uncovered(n_voxels, 0);
+    size_t n_inside = 0;
+    for (size_t id = 0; id < n_voxels; id++) {
+        if (dist2[id] > 0.) {
+            uncovered[id] = 1;
+            n_inside++;
+        }
+    }
+    if (n_inside == 0) {
+        throw std::runtime_error(
+            "DEMClumpFromMesh found no voxel inside the mesh. Is it closed, and is the resolution high enough?");
+    }
+
+    // Candidate centers: inner voxels on the ridge of the distance field (no 6-neighbor is further from the surface)
+    std::vector<size_t> candidates;
+    for (int k = 1; k < nz - 1; k++) {
+        for (int j = 1; j < ny - 1; j++) {
+            for (int i = 1; i < nx - 1; i++) {
+                size_t id = vid(i, j, k);
+                double d = dist2[id];
+                if (d == 0. || inscribed_r(id) < min_r)
+                    continue;
+                if (d >= dist2[id - 1] && d >= dist2[id + 1] && d >= dist2[vid(i, j - 1, k)] &&
+                    d >= dist2[vid(i, j + 1, k)] && d >= dist2[vid(i, j, k - 1)] && d >= dist2[vid(i, j, k + 1)])
+                    candidates.push_back(id);
+            }
+        }
+    }
+
+    // Number of still uncovered voxels that the sphere centered at voxel id covers (if mark, also cover them)
+    auto cover = [&](size_t id, bool mark) {
+        int ci = (int)(id % nx), cj = (int)((id / nx) % ny), ck = (int)(id / ((size_t)nx * ny));
+        double r = inscribed_r(id);
+        int ri = (int)std::floor(r);
+        size_t count = 0;
+        for (int k = std::max(0, ck - ri); k <= std::min(nz - 1, ck + ri); k++) {
+            for (int j = std::max(0, cj - ri); j <= std::min(ny - 1, cj + ri); j++) {
+                for (int i = std::max(0, ci - ri); i <= std::min(nx - 1, ci + ri); i++) {
+                    double d2 = (double)(i - ci) * (i - ci) + (double)(j - cj) * (j - cj) + (double)(k - ck) * (k - ck);
+                    size_t other = vid(i, j, k);
+                    if (d2 <= r * r && uncovered[other]) {
+                        count++;
+                        if (mark)
+                            uncovered[other] = 0;
+                    }
+                }
+            }
+        }
+        return count;
+    };
+
+    // Greedy max coverage. Gains only drop as more gets covered, so a stale gain is an upper bound and a lazy
+    // priority queue only needs to re-evaluate the top entry. Ties go to the lower voxel index.
+    std::vector<size_t> gains(candidates.size());
+    parallelFor(candidates.size(), num_threads, [&](size_t begin, size_t end) {
+        for (size_t c = begin; c < end; c++)
+            gains[c] = cover(candidates[c], false);
+    });
+    auto lower_priority = [](const std::pair<size_t, size_t>& a, const std::pair<size_t, size_t>& b) {
+        return (a.first != b.first) ? (a.first < b.first) : (a.second > b.second);
+    };
+    std::priority_queue<std::pair<size_t, size_t>, std::vector<std::pair<size_t, size_t>>, decltype(lower_priority)>
+        queue(lower_priority);
+    for (size_t c = 0; c < candidates.size(); c++)
+        queue.emplace(gains[c], candidates[c]);
+
+    DEMClumpTemplate clump;
+    size_t n_uncovered = n_inside;
+    while (!queue.empty() && clump.nComp < settings.max_spheres &&
+           (double)n_uncovered / n_inside > settings.volume_tolerance) {
+        auto top = queue.top();
+        queue.pop();
+        size_t gain = cover(top.second, false);
+        if (gain == 0)
+            continue;
+        if (!queue.empty() && lower_priority(std::make_pair(gain, top.second), queue.top())) {
+            queue.emplace(gain, top.second);
+            continue;
+        }
+        cover(top.second, true);
+        n_uncovered -= gain;
+        size_t id = top.second;
+        int ci = (int)(id % nx), cj = (int)((id / nx) % ny), ck = (int)(id / ((size_t)nx * ny));
+        clump.relPos.push_back(host_make_float3(ox + (ci + 0.5) * h, oy + (cj + 0.5) * h, oz + (ck + 0.5) * h));
+        clump.radii.push_back(inscribed_r(id) * h);
+        clump.nComp++;
+    }
+    if (clump.nComp == 0) {
+        throw std::runtime_error("DEMClumpFromMesh could not place any sphere. Consider a smaller min_radius or a "
+                                 "higher resolution.");
+    }
+
+    // Mass properties. Inside-out shells are counted flipped, so the volume and the moments are positive.
+    MeshMassProperties props = mesh.ComputeMassProperties(num_threads);
+    // The clump's own frame is the centroid and principal frame of the mesh
+    for (auto& pos : clump.relPos)
+        applyFrameTransformGlobalToLocal(pos, props.center, props.principal_Q);
+    clump.SetMass(props.volume * settings.density);
+    clump.SetMOI(props.principal_inertia * settings.density);
+    clump.SetVolume(props.volume);
+    clump.SetMaterial(material);
+
+    if (report) {
+        report->num_spheres = clump.nComp;
+        report->uncovered_volume_fraction = (double)n_uncovered / n_inside;
+        report->voxel_size = h;
+        report->center = props.center;
+        report->principal_Q = props.principal_Q;
+    }
+    return clump;
+}
+
+}  // namespace deme
+
+#endif
@@ -0,0 +1,603 @@
+//  Copyright (c) 2021, SBEL GPU Development Team
+//  Copyright (c) 2021, University of Wisconsin - Madison
+//
+//	SPDX-License-Identifier: BSD-3-Clause
+
+#ifndef DEME_CLUMP_SIMPLIFIER_HPP
+#define DEME_CLUMP_SIMPLIFIER_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <memory>
+#include <vector>
+
+#include <nvmath/helper_math.cuh>
+#include <DEM/Defines.h>
+#include <DEM/Structs.h>
+#include <DEM/HostSideHelpers.hpp>
+
+namespace deme {
+
+/// Settings of DEMSimplifyClumpTemplate(s). Both deviations are measured against the original clump, not the previous
+/// simplification step, so they do not accumulate.
+struct ClumpSimplifySettings {
+    /// Max distance between the surfaces of the simplified and the original clump, as a fraction of the radius of the
+    /// original clump's bounding sphere (about its CoM)
+    float surface_tolerance = 0.02;
+    /// Max volume of the symmetric difference between the simplified and the original clump, as a fraction of the
+    /// original clump's volume (the volume of the union of its spheres)
+    float volume_tolerance = 0.02;
+    /// Whether two heavily overlapping spheres may be replaced by one sphere that encloses both
+    bool allow_merge = true;
+    /// Number of points sampled on each sphere's surface to measure the surface deviation
+    unsigned int surface_samples = 64;
+    /// Number of grid points along the longest side of the clump's bounding box to measure the volume deviation
+    unsigned int volume_resolution = 32;
+};
+
+/// What a clump template simplification achieved
+struct ClumpSimplifyReport {
+    unsigned int original_num_spheres = 0;
+    unsigned int num_spheres = 0;
+    /// Surface deviation from the original clump, relative to the bounding sphere radius
+    double surface_deviation = 0.;
+    /// Volume deviation from the original clump, relative to its volume
+    double volume_deviation = 0.;
+    /// Expected ratio of the sphere-bin touches after/before. They scale with the number of spheres.
+    double bin_touch_ratio = 1.;
+    /// Expected ratio of the sphere-sphere contacts after/before. Two clumps touch only through the spheres on their
+    /// surfaces, so this is the ratio of the numbers of spheres that are not enclosed by the other spheres.
+    double contact_ratio = 1.;
+};
+
+namespace clump_simp_detail {
+
+// Points evenly distributed on a unit sphere (Fibonacci lattice)
+inline std::vector<float3> unitSpherePoints(unsigned int n) {
+    std::vector<float3> pts(n);
+    const double golden = 3.14159265358979323846 * (3. - std::sqrt(5.));
+    for (unsigned int i = 0; i < n; i++) {
+        double z = 1. - 2. * (i + 0.5) / n;
+        double rho = std::sqrt(std::max(0., 1. - z * z));
+        pts[i] = host_make_float3(rho * std::cos(golden * i), rho * std::sin(golden * i), z);
+    }
+    return pts;
+}
+
+inline double sphereDist(const float3& p, const float3& c, float r) {
+    return length(p - c) - r;
+}
+
+// A removal (j < 0) or a merge of current spheres i and j into the sphere (c, r)
+struct SimplifyOp {
+    int i = -1, j = -1;
+    float3 c;
+    float r = 0.f;
+    double surface = 0., volume = 0., cost = std::numeric_limits<double>::infinity();
+    bool valid() const { return i >= 0; }
+};
+
+// Greedy simplification state of one clump. Spheres are never re-indexed: removed ones are marked dead and merged ones
+// are appended. Inward surface deviation is tracked on sample points of the original exposed surface, each keeping its
+// three closest current spheres; outward deviation is computed once per new sphere. Volume deviation is tracked on a
+// grid, where each point keeps how many current spheres cover it.
+class Simplifier {
+  public:
+    Simplifier(const DEMClumpTemplate& clump, const ClumpSimplifySettings& settings)
+        : m_settings(settings), m_unit_pts(unitSpherePoints(std::max(8u, settings.surface_samples))) {
+        m_orig_pos = clump.relPos;
+        m_orig_rad = clump.radii;
+        m_pos = clump.relPos;
+        m_rad = clump.radii;
+        m_mat = clump.materials;
+        m_has_mat = (clump.materials.size() == clump.nComp);
+        m_alive.assign(m_pos.size(), 1);
+        m_outward.assign(m_pos.size(), 0.);
+        m_num_alive = m_pos.size();
+
+        m_scale = 0.;
+        float3 lo = m_orig_pos[0] - m_orig_rad[0], hi = m_orig_pos[0] + m_orig_rad[0];
+        for (size_t i = 0; i < m_orig_pos.size(); i++) {
+            m_scale = std::max(m_scale, (double)length(m_orig_pos[i]) + m_orig_rad[i]);
+            lo = fminf(lo, m_orig_pos[i] - m_orig_rad[i]);
+            hi = fmaxf(hi, m_orig_pos[i] + m_orig_rad[i]);
+        }
+
+        // Sample points on the exposed part of the original surface
+        for (size_t i = 0; i < m_orig_pos.size(); i++) {
+            for (const auto& u : m_unit_pts) {
+                float3 p = m_orig_pos[i] + m_orig_rad[i] * u;
+                if (origDist(p, (int)i) >= -1e-6 * m_scale)
+                    m_samples.push_back(p);
+            }
+        }
+        m_best.resize(m_samples.size());
+        for (size_t s = 0; s < m_samples.size(); s++)
+            rankSample(s);
+
+        // Volume grid
+        float3 ext = hi - lo;
+        m_h = std::max(ext.x, std::max(ext.y, ext.z)) / std::max(1u, settings.volume_resolution);
+        m_lo = lo;
+        m_nx = (int)std::ceil(ext.x / m_h) + 1;
+        m_ny = (int)std::ceil(ext.y / m_h) + 1;
+        m_nz = (int)std::ceil(ext.z / m_h) + 1;
+        size_t n_pts = (size_t)m_nx * m_ny * m_nz;
+        m_in_orig.assign(n_pts, 0);
+        m_cnt.assign(n_pts, 0);
+        for (size_t i = 0; i < m_pos.size(); i++)
+            cover((int)i, 1);
+        m_orig_vol = 0;
+        for (size_t g = 0; g < n_pts; g++) {
+            if (m_cnt[g] > 0) {
+                m_in_orig[g] = 1;
+                m_orig_vol++;
+            }
+        }
+        m_sym_diff = 0;
+        m_orig_exposed = numExposed();
+    }
+
+    unsigned int NumSpheres() const { return m_num_alive; }
+    double SurfaceDeviation() const { return std::max(inwardDeviation(), maxOutward(-1, -1)) / m_scale; }
+    double VolumeDeviation() const { return (double)m_sym_diff / std::max<size_t>(1, m_orig_vol); }
+
+    // The cheapest removal or merge of the current state
+    SimplifyOp BestOp() const {
+        SimplifyOp best;
+        if (m_num_alive <= 1)
+            return best;
+
+        // Removals. For each sphere, the inward deviation without it comes from the samples it is the closest to
+        // (they fall back to the runner-up) and the samples that are closest to other spheres.
+        size_t n = m_pos.size();
+        std::vector<double> own_max(n, 0.), fallback_max(n, 0.);
+        for (size_t s = 0; s < m_samples.size(); s++) {
+            int b = m_best[s].idx[0];
+            own_max[b] = std::max(own_max[b], m_best[s].val[0]);
+            fallback_max[b] = std::max(fallback_max[b], m_best[s].val[1]);
+        }
+        double top1 = 0., top2 = 0.;
+        int top1_idx = -1;
+        for (size_t i = 0; i < n; i++) {
+            if (own_max[i] > top1) {
+                top2 = top1;
+                top1 = own_max[i];
+                top1_idx = (int)i;
+            } else if (own_max[i] > top2) {
+                top2 = own_max[i];
+            }
+        }
+        for (size_t i = 0; i < n; i++) {
+            if (!m_alive[i])
+                continue;
+            SimplifyOp op;
+            op.i = (int)i;
+            op.c = m_pos[i];
+            double others = ((int)i == top1_idx) ? top2 : top1;
+            op.surface = std::max(std::max(others, fallback_max[i]), maxOutward((int)i, -1)) / m_scale;
+            op.volume = (double)(m_sym_diff + volumeDelta((int)i, -1, op.c, 0.f)) / std::max<size_t>(1, m_orig_vol);
+            pick(best, op);
+        }
+
+        // Merges of each sphere with its heavily overlapping neighbors. Only the samples that have i or j among their
+        // three closest spheres are re-evaluated; the others keep their current deviation, which can only be an
+        // overestimate since the merged sphere encloses both.
+        if (m_settings.allow_merge) {
+            std::vector<std::vector<size_t>> touching(n);
+            for (size_t s = 0; s < m_samples.size(); s++) {
+                for (int k = 0; k < 3; k++) {
+                    if (m_best[s].idx[k] >= 0)
+                        touching[m_best[s].idx[k]].push_back(s);
+                }
+            }
+            std::vector<size_t> by_dev(m_samples.size());
+            for (size_t s = 0; s < by_dev.size(); s++)
+                by_dev[s] = s;
+            std::sort(by_dev.begin(), by_dev.end(), [&](size_t a, size_t b) {
+                return (m_best[a].val[0] != m_best[b].val[0]) ? (m_best[a].val[0] > m_best[b].val[0]) : (a < b);
+            });
+            auto involves = [&](size_t s, int i, int j) {
+                for (int k = 0; k < 3; k++) {
+                    if (m_best[s].idx[k] == i || m_best[s].idx[k] == j)
+                        return true;
+                }
+                return false;
+            };
+
+            for (size_t i = 0; i < n; i++) {
+                if (!m_alive[i])
+                    continue;
+                for (size_t j = i + 1; j < n; j++) {
+                    if (!m_alive[j])
+                        continue;
+                    double d = length(m_pos[j] - m_pos[i]);
+                    if (d >= std::max(m_rad[i], m_rad[j]))
+                        continue;
+                    SimplifyOp op;
+                    op.i = (int)i;
+                    op.j = (int)j;
+                    enclosingSphere((int)i, (int)j, op.c, op.r);
+                    double inward = 0.;
+                    for (size_t s : by_dev) {
+                        if (!involves(s, (int)i, (int)j)) {
+                            inward = m_best[s].val[0];
+                            break;
+                        }
+                    }
+                    for (const auto& list : {&touching[i], &touching[j]}) {
+                        for (size_t s : *list) {
+                            double v =
+                                std::min(firstExcluding(s, (int)i, (int)j), sphereDist(m_samples[s], op.c, op.r));
+                            inward = std::max(inward, v);
+                        }
+                    }
+                    double outward = std::max(maxOutward((int)i, (int)j), outwardOf(op.c, op.r));
+                    op.surface = std::max(inward, outward) / m_scale;
+                    op.volume = (double)(m_sym_diff + volumeDelta((int)i, (int)j, op.c, op.r)) /
+                                std::max<size_t>(1, m_orig_vol);
+                    pick(best, op);
+                }
+            }
+        }
+        return best;
+    }
+
+    void Apply(const SimplifyOp& op) {
+        m_sym_diff += volumeDelta(op.i, op.j, op.c, op.r);
+        int new_idx = -1;
+        if (op.j >= 0) {
+            new_idx = (int)m_pos.size();
+            m_pos.push_back(op.c);
+            m_rad.push_back(op.r);
+            // The merged sphere takes the material of the larger one
+            if (m_has_mat)
+                m_mat.push_back(m_rad[op.i] >= m_rad[op.j] ? m_mat[op.i] : m_mat[op.j]);
+            m_alive.push_back(1);
+            m_outward.push_back(outwardOf(op.c, op.r));
+        }
+        kill(op.i);
+        if (op.j >= 0) {
+            kill(op.j);
+            cover(new_idx, 1);
+            m_num_alive++;
+        }
+        for (size_t s = 0; s < m_samples.size(); s++) {
+            const auto& b = m_best[s];
+            if (b.idx[0] == op.i || b.idx[1] == op.i || b.idx[2] == op.i || b.idx[0] == op.j || b.idx[1] == op.j ||
+                b.idx[2] == op.j || new_idx >= 0)
+                rankSample(s);
+        }
+    }
+
+    // Write the current spheres back into a clump template; mass properties are those of the original shape
+    void WriteTo(DEMClumpTemplate& clump) const {
+        clump.radii.clear();
+        clump.relPos.clear();
+        clump.materials.clear();
+        for (size_t i = 0; i < m_pos.size(); i++) {
+            if (!m_alive[i])
+                continue;
+            clump.radii.push_back(m_rad[i]);
+            clump.relPos.push_back(m_pos[i]);
+            if (m_has_mat)
+                clump.materials.push_back(m_mat[i]);
+        }
+        clump.nComp = clump.radii.size();
+    }
+
+    void Report(ClumpSimplifyReport& report) const {
+        report.original_num_spheres = m_orig_pos.size();
+        report.num_spheres = m_num_alive;
+        report.surface_deviation = SurfaceDeviation();
+        report.volume_deviation = VolumeDeviation();
+        report.bin_touch_ratio = (double)m_num_alive / m_orig_pos.size();
+        report.contact_ratio = (double)numExposed() / std::max(1u, m_orig_exposed);
+    }
+
+  private:
+    // The three current spheres closest to a sample point (signed distances)
+    struct Ranking {
+        double val[3];
+        int idx[3];
+    };
+
+    ClumpSimplifySettings m_settings;
+    std::vector<float3> m_unit_pts;
+    std::vector<float3> m_orig_pos;
+    std::vector<float> m_orig_rad;
+    std::vector<float3> m_pos;
+    std::vector<float> m_rad;
+    std::vector<std::shared_ptr<DEMMaterial>> m_mat;
+    bool m_has_mat;
+    std::vector<char> m_alive;
+    // How far each current sphere pokes out of the original shape (0 for the original ones)
+    std::vector<double> m_outward;
+    unsigned int m_num_alive;
+    double m_scale;
+    unsigned int m_orig_exposed;
+
+    std::vector<float3> m_samples;
+    std::vector<Ranking> m_best;
+
+    float m_h;
+    float3 m_lo;
+    int m_nx, m_ny, m_nz;
+    std::vector<char> m_in_orig;
+    std::vector<unsigned int> m_cnt;
+    size_t m_orig_vol;
+    long long m_sym_diff;
+
+    void pick(SimplifyOp& best, SimplifyOp& op) const {
+        const double eps = 1e-12;
+        op.cost = std::max(op.surface / std::max((double)m_settings.surface_tolerance, eps),
+                           op.volume / std::max((double)m_settings.volume_tolerance, eps));
+        if (op.cost < best.cost)
+            best = op;
+    }
+
+    double origDist(const float3& p, int exclude) const {
+        double d = std::numeric_limits<double>::infinity();
+        for (size_t k = 0; k < m_orig_pos.size(); k++) {
+            if ((int)k != exclude)
+                d = std::min(d, sphereDist(p, m_orig_pos[k], m_orig_rad[k]));
+        }
+        return d;
+    }
+
+    void rankSample(size_t s) {
+        Ranking& b = m_best[s];
+        for (int k = 0; k < 3; k++) {
+            b.val[k] = std::numeric_limits<double>::infinity();
+            b.idx[k] = -1;
+        }
+        for (size_t i = 0; i < m_pos.size(); i++) {
+            if (!m_alive[i])
+                continue;
+            double d = sphereDist(m_samples[s], m_pos[i], m_rad[i]);
+            for (int k = 0; k < 3; k++) {
+                if (d < b.val[k]) {
+                    for (int m = 2; m > k; m--) {
+                        b.val[m] = b.val[m - 1];
+                        b.idx[m] = b.idx[m - 1];
+                    }
+                    b.val[k] = d;
+                    b.idx[k] = (int)i;
+                    break;
+                }
+            }
+        }
+        // A sample inside some sphere deviates by 0; keep the values clamped so they can be maxed directly
+        for (int k = 0; k < 3; k++)
+            b.val[k] = std::max(0., b.val[k]);
+    }
+
+    // Distance from sample s to the current spheres other than i and j
+    double firstExcluding(size_t s, int i, int j) const {
+        const Ranking& b = m_best[s];
+        for (int k = 0; k < 3; k++) {
+            if (b.idx[k] != i && b.idx[k] != j)
+                return b.val[k];
+        }
+        // All of the three closest are excluded, so search the rest
+        double d = std::numeric_limits<double>::infinity();
+        for (size_t k = 0; k < m_pos.size(); k++) {
+            if (m_alive[k] && (int)k != i && (int)k != j)
+                d = std::min(d, sphereDist(m_samples[s], m_pos[k], m_rad[k]));
+        }
+        return std::max(0., d);
+    }
+
+    double inwardDeviation() const {
+        double d = 0.;
+        for (const auto& b : m_best)
+            d = std::max(d, b.val[0]);
+        return d;
+    }
+
+    double maxOutward(int i, int j) const {
+        double d = 0.;
+        for (size_t k = 0; k < m_pos.size(); k++) {
+            if (m_alive[k] && (int)k != i && (int)k != j)
+                d = std::max(d, m_outward[k]);
+        }
+        return d;
+    }
+
+    // How far a sphere pokes out of the original shape. Only the original spheres that intersect it are looked at,
+    // so a point that is outside all of them may get an overestimated distance.
+    double outwardOf(const float3& c, float r) const {
+        std::vector<size_t> near;
+        for (size_t k = 0; k < m_orig_pos.size(); k++) {
+            if (length(m_orig_pos[k] - c) < r + m_orig_rad[k])
+                near.push_back(k);
+        }
+        double d = 0.;
+        for (const auto& u : m_unit_pts) {
+            float3 p = c + r * u;
+            double p_dist = std::numeric_limits<double>::infinity();
+            for (size_t k : near)
+                p_dist = std::min(p_dist, sphereDist(p, m_orig_pos[k], m_orig_rad[k]));
+            d = std::max(d, p_dist);
+        }
+        return d;
+    }
+
+    // The smallest sphere enclosing spheres i and j
+    void enclosingSphere(int i, int j, float3& c, float& r) const {
+        float3 dir = m_pos[j] - m_pos[i];
+        double d = length(dir);
+        if (d + m_rad[j] <= m_rad[i]) {
+            c = m_pos[i];
+            r = m_rad[i];
+            return;
+        }
+        if (d + m_rad[i] <= m_rad[j]) {
+            c = m_pos[j];
+            r = m_rad[j];
+            return;
+        }
+        r = (d + m_rad[i] + m_rad[j]) / 2.;
+        c = m_pos[i] + (float)((r - m_rad[i]) / d) * dir;
+    }
+
+    template <typename Func>
+    void forGridPointsIn(const float3& c, float r, Func&& fn) const {
+        int x0 = std::max(0, (int)std::floor((c.x - r - m_lo.x) / m_h));
+        int y0 = std::max(0, (int)std::floor((c.y - r - m_lo.y) / m_h));
+        int z0 = std::max(0, (int)std::floor((c.z - r - m_lo.z) / m_h));
+        int x1 = std::min(m_nx - 1, (int)std::ceil((c.x + r - m_lo.x) / m_h));
+        int y1 = std::min(m_ny - 1, (int)std::ceil((c.y + r - m_lo.y) / m_h));
+        int z1 = std::min(m_nz - 1, (int)std::ceil((c.z + r - m_lo.z) / m_h));
+        for (int z = z0; z <= z1; z++) {
+            for (int y = y0; y <= y1; y++) {
+                for (int x = x0; x <= x1; x++) {
+                    float3 p = host_make_float3(m_lo.x + x * m_h, m_lo.y + y * m_h, m_lo.z + z * m_h);
+                    fn((size_t)x + (size_t)m_nx * ((size_t)y + (size_t)m_ny * z), p);
+                }
+            }
+        }
+    }
+
+    void cover(int i, int sign) {
+        forGridPointsIn(m_pos[i], m_rad[i], [&](size_t g, const float3& p) {
+            if (sphereDist(p, m_pos[i], m_rad[i]) <= 0.)
+                m_cnt[g] += sign;
+        });
+    }
+
+    void kill(int i) {
+        cover(i, -1);
+        m_alive[i] = 0;
+        m_num_alive--;
+    }
+
+    // Change of the symmetric difference volume (in grid points) if spheres i and j (j < 0 for a removal) are replaced
+    // by the sphere (c, r)
+    long long volumeDelta(int i, int j, const float3& c, float r) const {
+        long long delta = 0;
+        float3 box_c = (j >= 0) ? c : m_pos[i];
+        float box_r = (j >= 0) ? r : m_rad[i];
+        forGridPointsIn(box_c, box_r, [&](size_t g, const float3& p) {
+            bool in_i = sphereDist(p, m_pos[i], m_rad[i]) <= 0.;
+            bool in_j = (j >= 0) && sphereDist(p, m_pos[j], m_rad[j]) <= 0.;
+            bool before = m_cnt[g] > 0;
+            bool after = (m_cnt[g] > (unsigned int)in_i + (unsigned int)in_j) || (j >= 0 && sphereDist(p, c, r) <= 0.);
+            if (before != after)
+                delta += (after != (bool)m_in_orig[g]) ? 1 : -1;
+        });
+        return delta;
+    }
+
+    // Number of current spheres that have some surface not covered by the other current spheres
+    unsigned int numExposed() const {
+        unsigned int count = 0;
+        for (size_t i = 0; i < m_pos.size(); i++) {
+            if (!m_alive[i])
+                continue;
+            for (const auto& u : m_unit_pts) {
+                float3 p = m_pos[i] + m_rad[i] * u;
+                bool inside_other = false;
+                for (size_t k = 0; k < m_pos.size() && !inside_other; k++) {
+                    if (k != i && m_alive[k] && sphereDist(p, m_pos[k], m_rad[k]) < -1e-6 * m_scale)
+                        inside_other = true;
+                }
+                if (!inside_other) {
+                    count++;
+                    break;
+                }
+            }
+        }
+        return count;
+    }
+};
+
+}  // namespace clump_simp_detail
+
+/// Remove or merge the sphere components of a clump template while the simplified clump stays within the surface and
+/// volume deviation bounds of settings (if max_spheres is non-zero, keep simplifying past the bounds until at most
+/// max_spheres are left). Each step greedily takes the removal, or the merge of two heavily overlapping spheres into
+/// their enclosing sphere, that deviates the least from the original clump. Mass, MOI and volume are left as they are.
+inline ClumpSimplifyReport DEMSimplifyClumpTemplate(DEMClumpTemplate& clump,
+                                                    const ClumpSimplifySettings& settings = ClumpSimplifySettings(),
+                                                    unsigned int max_spheres = 0) {
+    using namespace clump_simp_detail;
+    ClumpSimplifyReport report;
+    report.original_num_spheres = report.num_spheres = clump.nComp;
+    if (clump.nComp <= 1)
+        return report;
+    Simplifier simp(clump, settings);
+    while (simp.NumSpheres() > 1) {
+        SimplifyOp op = simp.BestOp();
+        bool must = max_spheres > 0 && simp.NumSpheres() > max_spheres;
+        if (!op.valid() || (!must && op.cost > 1.))
+            break;
+        simp.Apply(op);
+    }
+    simp.WriteTo(clump);
+    simp.Report(report);
+    return report;
+}
+
+/// Simplify a set of clump templates within the deviation bounds of settings, then, if their total number of sphere
+/// components is still over component_budget, keep simplifying whichever template deviates the least by doing so until
+/// the total fits. The default budget is the number of components that can all be jitified (see
+/// DEME_THRESHOLD_TOO_MANY_SPHERE_COMP and DEME_THRESHOLD_BIG_CLUMP), so that no template has to stay in global
+/// memory. The reports, if given, are filled in the order of the templates. Returns the total number of components.
+inline unsigned int DEMSimplifyClumpTemplates(std::vector<std::shared_ptr<DEMClumpTemplate>>& templates,
+                                              const ClumpSimplifySettings& settings = ClumpSimplifySettings(),
+                                              unsigned int component_budget = THRESHOLD_CANT_JITIFY_ALL_COMP,
+                                              std::vector<ClumpSimplifyReport>* reports = nullptr) {
+    using namespace clump_simp_detail;
+    std::vector<std::unique_ptr<Simplifier>> simps;
+    std::vector<SimplifyOp> next_ops(templates.size());
+    unsigned int total = 0;
+    for (size_t t = 0; t < templates.size(); t++) {
+        simps.emplace_back(templates[t]->nComp > 1 ? new Simplifier(*templates[t], settings) : nullptr);
+        if (simps[t]) {
+            while (simps[t]->NumSpheres() > 1) {
+                next_ops[t] = simps[t]->BestOp();
+                if (!next_ops[t].valid() || next_ops[t].cost > 1.)
+                    break;
+                simps[t]->Apply(next_ops[t]);
+                next_ops[t] = SimplifyOp();
+            }
+            total += simps[t]->NumSpheres();
+        } else {
+            total += templates[t]->nComp;
+        }
+    }
+
+    // Over budget: spend the extra reductions where they cost the least deviation
+    while (total > component_budget) {
+        int pick = -1;
+        for (size_t t = 0; t < templates.size(); t++) {
+            if (next_ops[t].valid() && (pick < 0 || next_ops[t].cost < next_ops[pick].cost))
+                pick = (int)t;
+        }
+        if (pick < 0)
+            break;
+        simps[pick]->Apply(next_ops[pick]);
+        total--;
+        next_ops[pick] = (simps[pick]->NumSpheres() > 1) ? simps[pick]->BestOp() : SimplifyOp();
+    }
+
+    if (reports)
+        reports->assign(templates.size(), ClumpSimplifyReport());
+    for (size_t t = 0; t < templates.size(); t++) {
+        if (!simps[t]) {
+            if (reports)
+                (*reports)[t].original_num_spheres = (*reports)[t].num_spheres = templates[t]->nComp;
+            continue;
+        }
+        simps[t]->WriteTo(*templates[t]);
+        if (reports)
+            simps[t]->Report((*reports)[t]);
+    }
+    return total;
+}
+
+}  // namespace deme
+
+#endif
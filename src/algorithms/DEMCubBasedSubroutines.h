@@ -7,6 +7,7 @@
 #include <DEM/Defines.h>
 #include <core/utils/GpuManager.h>
 #include <core/utils/ManagedAllocator.hpp>
+#include <core/utils/HostWorkerPool.hpp>
 
 namespace deme {
 
@@ -97,6 +98,36 @@ void doubleSortByKey(notStupidBool_t* d_keys_in,
                      cudaStream_t& this_stream,
                      DEMSolverStateData& scratchPad);
 
+// Select the indices of the flagged items
+void contactIDSelectFlagged(notStupidBool_t* d_flags,
+                            contactPairs_t* d_out,
+                            size_t* d_num_out,
+                            size_t n,
+                            cudaStream_t& this_stream,
+                            DEMSolverStateData& scratchPad);
+void ownerIDSelectFlagged(notStupidBool_t* d_flags,
+                          bodyID_t* d_out,
+                          size_t* d_num_out,
+                          size_t n,
+                          cudaStream_t& this_stream,
+                          DEMSolverStateData& scratchPad);
+
+// Exclusive prefix sum of per-contact flags, which gives each flagged contact its place among the flagged ones
+void contactFlagPrefixScan(notStupidBool_t* d_flags,
+                           contactPairs_t* d_out,
+                           size_t n,
+                           cudaStream_t& this_stream,
+                           DEMSolverStateData& scratchPad);
+
+// Find the runs of same-type contacts in a contact type array
+void contactTypeRunLengthEncode(contact_t* d_in,
+                                contact_t* d_unique_out,
+                                contactPairs_t* d_counts_out,
+                                size_t* d_num_out,
+                                size_t n,
+                                cudaStream_t& this_stream,
+                                DEMSolverStateData& scratchPad);
+
 ////////////////////////////////////////////////////////////////////////////////
 // For kT and dT's private usage
 ////////////////////////////////////////////////////////////////////////////////
@@ -118,11 +149,37 @@ void contactDetection(std::shared_ptr<jitify::Program>& bin_sphere_kernels,
                       std::vector<bodyID_t, ManagedAllocator<bodyID_t>>& previous_idGeometryB,
                       std::vector<contact_t, ManagedAllocator<contact_t>>& previous_contactType,
                       std::vector<contactPairs_t, ManagedAllocator<contactPairs_t>>& contactMapping,
+                      std::vector<bodyID_t, ManagedAllocator<bodyID_t>>& verletIdGeometryA,
+                      std::vector<bodyID_t, ManagedAllocator<bodyID_t>>& verletIdGeometryB,
+                      std::vector<contact_t, ManagedAllocator<contact_t>>& verletContactType,
+                      size_t& nVerletCandidates,
+                      // If true, the stored Verlet-style candidates are refiltered, rather than binning again
+                      bool reuseCandidates,
+                      SphereBinningRecord& sphereBinningRecord,
                       cudaStream_t& this_stream,
                       DEMSolverStateData& scratchPad,
                       SolverTimers& timers,
                       kTStateParams& stateParams);
 
+// The same contact detection as contactDetection, but run on host threads. Meshes and contact candidate reuse are not
+// supported.
+void hostContactDetection(DEMDataKT* granData,
+                          DEMSimParams* simParams,
+                          SolverFlags& solverFlags,
+                          VERBOSITY& verbosity,
+                          const HostAnalyticalEntities& analEntities,
+                          std::vector<bodyID_t, ManagedAllocator<bodyID_t>>& idGeometryA,
+                          std::vector<bodyID_t, ManagedAllocator<bodyID_t>>& idGeometryB,
+                          std::vector<contact_t, ManagedAllocator<contact_t>>& contactType,
+                          std::vector<bodyID_t, ManagedAllocator<bodyID_t>>& previous_idGeometryA,
+                          std::vector<bodyID_t, ManagedAllocator<bodyID_t>>& previous_idGeometryB,
+                          std::vector<contact_t, ManagedAllocator<contact_t>>& previous_contactType,
+                          std::vector<contactPairs_t, ManagedAllocator<contactPairs_t>>& contactMapping,
+                          DEMSolverStateData& scratchPad,
+                          SolverTimers& timers,
+                          kTStateParams& stateParams,
+                          HostWorkerPool& workers);
+
 void collectContactForcesThruCub(std::shared_ptr<jitify::Program>& collect_force_kernels,
                                  DEMDataDT* granData,
                                  const size_t nContactPairs,
@@ -17,18 +17,31 @@
 
 namespace deme {
 
+// Register the current size of a contact array that gets resized in this file with kT's memory registry
+template <typename T>
+inline void registerContactArraySize(DEMSolverStateData& scratchPad,
+                                     const char* name,
+                                     const std::vector<T, ManagedAllocator<T>>& vec) {
+    if (scratchPad.memRegistry)
+        scratchPad.memRegistry->Set(name, vec.capacity() * sizeof(T));
+}
+
 inline void contactEventArraysResize(size_t nContactPairs,
                                      std::vector<bodyID_t, ManagedAllocator<bodyID_t>>& idGeometryA,
                                      std::vector<bodyID_t, ManagedAllocator<bodyID_t>>& idGeometryB,
                                      std::vector<contact_t, ManagedAllocator<contact_t>>& contactType,
-                                     DEMDataKT* granData) {
-    //// TODO: not tracked? Gotta do something on it
-    // DEME_TRACKED_RESIZE(idGeometryA, nContactPairs);
-    // DEME_TRACKED_RESIZE(idGeometryB, nContactPairs);
-    // DEME_TRACKED_RESIZE(contactType, nContactPairs);
+                                     DEMDataKT* granData,
+                                     DEMSolverStateData& scratchPad) {
+    // Grow geometrically, so a contact number that creeps up does not re-allocate these arrays at every CD step
+    reserveGeometric(idGeometryA, nContactPairs);
+    reserveGeometric(idGeometryB, nContactPairs);
+    reserveGeometric(contactType, nContactPairs);
     idGeometryA.resize(nContactPairs);
     idGeometryB.resize(nContactPairs);
     contactType.resize(nContactPairs);
+    registerContactArraySize(scratchPad, "idGeometryA", idGeometryA);
+    registerContactArraySize(scratchPad, "idGeometryB", idGeometryB);
+    registerContactArraySize(scratchPad, "contactType", contactType);
 
     // Re-pack pointers in case the arrays got reallocated
     granData->idGeometryA = idGeometryA.data();
@@ -36,6 +49,27 @@ inline void contactEventArraysResize(size_t nContactPairs,
     granData->contactType = contactType.data();
 }
 
+inline void contactCandidateArraysResize(size_t nCandidates,
+                                         std::vector<bodyID_t, ManagedAllocator<bodyID_t>>& verletIdGeometryA,
+                                         std::vector<bodyID_t, ManagedAllocator<bodyID_t>>& verletIdGeometryB,
+                                         std::vector<contact_t, ManagedAllocator<contact_t>>& verletContactType,
+                                         DEMDataKT* granData,
+                                         DEMSolverStateData& scratchPad) {
+    reserveGeometric(verletIdGeometryA, nCandidates);
+    reserveGeometric(verletIdGeometryB, nCandidates);
+    reserveGeometric(verletContactType, nCandidates);
+    verletIdGeometryA.resize(nCandidates);
+    verletIdGeometryB.resize(nCandidates);
+    verletContactType.resize(nCandidates);
+    registerContactArraySize(scratchPad, "verletIdGeometryA", verletIdGeometryA);
+    registerContactArraySize(scratchPad, "verletIdGeometryB", verletIdGeometryB);
+    registerContactArraySize(scratchPad, "verletContactType", verletContactType);
+
+    granData->verletIdGeometryA = verletIdGeometryA.data();
+    granData->verletIdGeometryB = verletIdGeometryB.data();
+    granData->verletContactType = verletContactType.data();
+}
+
 void contactDetection(std::shared_ptr<jitify::Program>& bin_sphere_kernels,
                       std::shared_ptr<jitify::Program>& bin_triangle_kernels,
                       std::shared_ptr<jitify::Program>& sphere_contact_kernels,
@@ -52,6 +86,12 @@ void contactDetection(std::shared_ptr<jitify::Program>& bin_sphere_kernels,
                       std::vector<bodyID_t, ManagedAllocator<bodyID_t>>& previous_idGeometryB,
                       std::vector<contact_t, ManagedAllocator<contact_t>>& previous_contactType,
                       std::vector<contactPairs_t, ManagedAllocator<contactPairs_t>>& contactMapping,
+                      std::vector<bodyID_t, ManagedAllocator<bodyID_t>>& verletIdGeometryA,
+                      std::vector<bodyID_t, ManagedAllocator<bodyID_t>>& verletIdGeometryB,
+                      std::vector<contact_t, ManagedAllocator<contact_t>>& verletContactType,
+                      size_t& nVerletCandidates,
+                      bool reuseCandidates,
+                      SphereBinningRecord& sphereBinningRecord,
                       cudaStream_t& this_stream,
                       DEMSolverStateData& scratchPad,
                       SolverTimers& timers,
@@ -64,16 +104,20 @@ void contactDetection(std::shared_ptr<jitify::Program>& bin_sphere_kernels,
         return;
     }
     // These are needed for the solver to keep tab... But you know, we may have no triangles or no contacts, so
-    // initializing them is needed.
-    stateParams.maxSphFoundInBin = 0;
-    stateParams.maxTriFoundInBin = 0;
+    // initializing them is needed. If the contact candidates are reused, the bin stats are still those of the last
+    // binning.
+    if (!reuseCandidates) {
+        stateParams.maxSphFoundInBin = 0;
+        stateParams.maxTriFoundInBin = 0;
+    }
     stateParams.avgCntsPerSphere = 0;
 
     // total bytes needed for temp arrays in contact detection
     size_t CD_temp_arr_bytes = 0;
 
-    {
-        timers.GetTimer("Discretize domain").start();
+    if (!reuseCandidates) {
+        timers.Start(KT_DISCRETIZE_DOMAIN);
+        timers.Start(KT_BIN_SPHERES);
         ////////////////////////////////////////////////////////////////////////////////
         // Sphere-related discretization & sphere--analytical contact detection
         ////////////////////////////////////////////////////////////////////////////////
@@ -95,17 +139,52 @@ void contactDetection(std::shared_ptr<jitify::Program>& bin_sphere_kernels,
             .launch(simParams, granData, numBinsSphereTouches, numAnalGeoSphereTouches);
         DEME_GPU_CALL(cudaStreamSynchronize(this_stream));
 
-        // 2nd step: prefix scan sphere--bin touching pairs
+        // With incremental binning, find the spheres that now touch a different range of bins than at the last
+        // binning. Only they get re-binned, unless the record is of no use or too many of them moved: then merging is
+        // no cheaper than sorting all pairs, and all spheres are re-binned.
+        bool rebinAll = true;
+        binsSphereTouches_t* numBinsRebinnedSphereTouches = numBinsSphereTouches;
+        if (solverFlags.useIncrementalBinning) {
+            if (sphereBinningRecord.sphereBinLo.size() != simParams->nSpheresGM ||
+                sphereBinningRecord.binSize != simParams->binSize) {
+                sphereBinningRecord.sphereBinLo.resize(simParams->nSpheresGM);
+                sphereBinningRecord.sphereBinHi.resize(simParams->nSpheresGM);
+                registerContactArraySize(scratchPad, "sphereBinLo", sphereBinningRecord.sphereBinLo);
+                registerContactArraySize(scratchPad, "sphereBinHi", sphereBinningRecord.sphereBinHi);
+                sphereBinningRecord.valid = false;
+            }
+            // Vector 5 is not used until contact pairs are populated
+            CD_temp_arr_bytes = simParams->nSpheresGM * sizeof(binsSphereTouches_t);
+            numBinsRebinnedSphereTouches = (binsSphereTouches_t*)scratchPad.allocateTempVector(5, CD_temp_arr_bytes);
+            size_t* pNumRebinned = scratchPad.pTempSizeVar3;
+            *pNumRebinned = 0;
+            bin_sphere_kernels->kernel("markSpheresToRebin")
+                .instantiate()
+                .configure(dim3(blocks_needed_for_bodies), dim3(DEME_NUM_BODIES_PER_BLOCK), 0, this_stream)
+                .launch(simParams, granData, numBinsSphereTouches, numBinsRebinnedSphereTouches,
+                        sphereBinningRecord.sphereBinLo.data(), sphereBinningRecord.sphereBinHi.data(), pNumRebinned);
+            DEME_GPU_CALL(cudaStreamSynchronize(this_stream));
+            rebinAll = !sphereBinningRecord.valid || *pNumRebinned * 2 > simParams->nSpheresGM;
+            stateParams.numSpheresRebinned = *pNumRebinned;
+            DEME_STEP_DEBUG_PRINTF("Spheres that touch a different range of bins than at the last binning: %zu",
+                                   *pNumRebinned);
+        }
+        if (rebinAll) {
+            numBinsRebinnedSphereTouches = numBinsSphereTouches;
+            stateParams.numSpheresRebinned = simParams->nSpheresGM;
+        }
+
+        // 2nd step: prefix scan sphere--bin touching pairs (of the re-binned spheres, if binning incrementally)
         // The last element of this scanned array is useful: it can be used to check if the 2 sweeps reach the same
         // conclusion on bin--sph touch pairs
         CD_temp_arr_bytes = (simParams->nSpheresGM + 1) * sizeof(binSphereTouchPairs_t);
         binSphereTouchPairs_t* numBinsSphereTouchesScan =
             (binSphereTouchPairs_t*)scratchPad.allocateTempVector(1, CD_temp_arr_bytes);
         cubDEMPrefixScan<binsSphereTouches_t, binSphereTouchPairs_t, DEMSolverStateData>(
-            numBinsSphereTouches, numBinsSphereTouchesScan, simParams->nSpheresGM, this_stream, scratchPad);
+            numBinsRebinnedSphereTouches, numBinsSphereTouchesScan, simParams->nSpheresGM, this_stream, scratchPad);
         size_t* pNumBinSphereTouchPairs = scratchPad.pTempSizeVar1;
         *pNumBinSphereTouchPairs = (size_t)numBinsSphereTouchesScan[simParams->nSpheresGM - 1] +
-                                   (size_t)numBinsSphereTouches[simParams->nSpheresGM - 1];
+                                   (size_t)numBinsRebinnedSphereTouches[simParams->nSpheresGM - 1];
         numBinsSphereTouchesScan[simParams->nSpheresGM] = *pNumBinSphereTouchPairs;
         // The same process is done for sphere--analytical geometry pairs as well. Use vector 3 for this.
         // One extra elem is used for storing the final elem in scan result.
@@ -118,7 +197,8 @@ void contactDetection(std::shared_ptr<jitify::Program>& bin_sphere_kernels,
                                      (size_t)numAnalGeoSphereTouchesScan[simParams->nSpheresGM - 1];
         numAnalGeoSphereTouchesScan[simParams->nSpheresGM] = *(scratchPad.pNumContacts);
         if (*scratchPad.pNumContacts > idGeometryA.size()) {
-            contactEventArraysResize(*scratchPad.pNumContacts, idGeometryA, idGeometryB, contactType, granData);
+            contactEventArraysResize(*scratchPad.pNumContacts, idGeometryA, idGeometryB, contactType, granData,
+                                     scratchPad);
         }
         // std::cout << *pNumBinSphereTouchPairs << std::endl;
         // displayArray<binsSphereTouches_t>(numBinsSphereTouches, simParams->nSpheresGM);
@@ -142,18 +222,91 @@ void contactDetection(std::shared_ptr<jitify::Program>& bin_sphere_kernels,
         // std::cout << "Corresponding sphere IDs: ";
         // displayArray<bodyID_t>(sphereIDsEachBinTouches, *pNumBinSphereTouchPairs);
 
+        timers.Stop(KT_BIN_SPHERES);
+        timers.Start(KT_SORT_BIN_SPHERE_PAIRS);
+
         // 4th step: allocate and populate SORTED binIDsEachSphereTouches and sphereIDsEachBinTouches. Note
         // numBinsSphereTouchesScan can retire now so we re-use vector 1 and 3 (analytical contacts have been
         // processed).
-        CD_temp_arr_bytes = (*pNumBinSphereTouchPairs) * sizeof(bodyID_t);
-        bodyID_t* sphereIDsEachBinTouches_sorted = (bodyID_t*)scratchPad.allocateTempVector(1, CD_temp_arr_bytes);
-        CD_temp_arr_bytes = (*pNumBinSphereTouchPairs) * sizeof(binID_t);
-        binID_t* binIDsEachSphereTouches_sorted = (binID_t*)scratchPad.allocateTempVector(3, CD_temp_arr_bytes);
-        // hostSortByKey<binID_t, bodyID_t>(granData->binIDsEachSphereTouches, granData->sphereIDsEachBinTouches,
-        //                                  *pNumBinSphereTouchPairs);
-        cubDEMSortByKeys<binID_t, bodyID_t, DEMSolverStateData>(binIDsEachSphereTouches, binIDsEachSphereTouches_sorted,
-                                                                sphereIDsEachBinTouches, sphereIDsEachBinTouches_sorted,
-                                                                *pNumBinSphereTouchPairs, this_stream, scratchPad);
+        bodyID_t* sphereIDsEachBinTouches_sorted;
+        binID_t* binIDsEachSphereTouches_sorted;
+        if (rebinAll) {
+            CD_temp_arr_bytes = (*pNumBinSphereTouchPairs) * sizeof(bodyID_t);
+            sphereIDsEachBinTouches_sorted = (bodyID_t*)scratchPad.allocateTempVector(1, CD_temp_arr_bytes);
+            CD_temp_arr_bytes = (*pNumBinSphereTouchPairs) * sizeof(binID_t);
+            binIDsEachSphereTouches_sorted = (binID_t*)scratchPad.allocateTempVector(3, CD_temp_arr_bytes);
+            // hostSortByKey<binID_t, bodyID_t>(granData->binIDsEachSphereTouches, granData->sphereIDsEachBinTouches,
+            //                                  *pNumBinSphereTouchPairs);
+            cubDEMSortByKeys<binID_t, bodyID_t, DEMSolverStateData>(
+                binIDsEachSphereTouches, binIDsEachSphereTouches_sorted, sphereIDsEachBinTouches,
+                sphereIDsEachBinTouches_sorted, *pNumBinSphereTouchPairs, this_stream, scratchPad);
+        } else {
+            // Incremental binning: sort only the pairs of the re-binned spheres (vectors 4 and 6 are not in use yet),
+            // then merge them into the recorded pairs of the other spheres. Sorting is stable and the pairs were made
+            // in the order of sphere IDs, so both lists are sorted by bin ID then sphere ID, just like the result of
+            // sorting all pairs; merging them gives exactly that result.
+            const size_t numNewPairs = *pNumBinSphereTouchPairs;
+            const size_t numOldPairs = sphereBinningRecord.binIDs.size();
+            CD_temp_arr_bytes = numNewPairs * sizeof(bodyID_t);
+            bodyID_t* newSphereIDs_sorted = (bodyID_t*)scratchPad.allocateTempVector(4, CD_temp_arr_bytes);
+            CD_temp_arr_bytes = numNewPairs * sizeof(binID_t);
+            binID_t* newBinIDs_sorted = (binID_t*)scratchPad.allocateTempVector(6, CD_temp_arr_bytes);
+            if (numNewPairs > 0) {
+                cubDEMSortByKeys<binID_t, bodyID_t, DEMSolverStateData>(binIDsEachSphereTouches, newBinIDs_sorted,
+                                                                        sphereIDsEachBinTouches, newSphereIDs_sorted,
+                                                                        numNewPairs, this_stream, scratchPad);
+            }
+
+            // Which recorded pairs are kept, and how many kept ones come before each (vectors 7 and 8)
+            CD_temp_arr_bytes = numOldPairs * sizeof(notStupidBool_t);
+            notStupidBool_t* keep = (notStupidBool_t*)scratchPad.allocateTempVector(7, CD_temp_arr_bytes);
+            CD_temp_arr_bytes = (numOldPairs + 1) * sizeof(binSphereTouchPairs_t);
+            binSphereTouchPairs_t* keptScan =
+                (binSphereTouchPairs_t*)scratchPad.allocateTempVector(8, CD_temp_arr_bytes);
+            size_t blocks_needed_for_old = (numOldPairs + DEME_MAX_THREADS_PER_BLOCK - 1) / DEME_MAX_THREADS_PER_BLOCK;
+            bin_sphere_kernels->kernel("markKeptBinSpherePairs")
+                .instantiate()
+                .configure(dim3(blocks_needed_for_old), dim3(DEME_MAX_THREADS_PER_BLOCK), 0, this_stream)
+                .launch(sphereBinningRecord.sphereIDs.data(), numBinsRebinnedSphereTouches, keep, numOldPairs);
+            DEME_GPU_CALL(cudaStreamSynchronize(this_stream));
+            cubDEMPrefixScan<notStupidBool_t, binSphereTouchPairs_t, DEMSolverStateData>(keep, keptScan, numOldPairs,
+                                                                                         this_stream, scratchPad);
+            keptScan[numOldPairs] = keptScan[numOldPairs - 1] + keep[numOldPairs - 1];
+            *pNumBinSphereTouchPairs = (size_t)keptScan[numOldPairs] + numNewPairs;
+
+            CD_temp_arr_bytes = (*pNumBinSphereTouchPairs) * sizeof(bodyID_t);
+            sphereIDsEachBinTouches_sorted = (bodyID_t*)scratchPad.allocateTempVector(1, CD_temp_arr_bytes);
+            CD_temp_arr_bytes = (*pNumBinSphereTouchPairs) * sizeof(binID_t);
+            binIDsEachSphereTouches_sorted = (binID_t*)scratchPad.allocateTempVector(3, CD_temp_arr_bytes);
+            size_t blocks_needed_for_merge =
+                (numOldPairs + numNewPairs + DEME_MAX_THREADS_PER_BLOCK - 1) / DEME_MAX_THREADS_PER_BLOCK;
+            bin_sphere_kernels->kernel("mergeBinSpherePairs")
+                .instantiate()
+                .configure(dim3(blocks_needed_for_merge), dim3(DEME_MAX_THREADS_PER_BLOCK), 0, this_stream)
+                .launch(sphereBinningRecord.binIDs.data(), sphereBinningRecord.sphereIDs.data(), keep, keptScan,
+                        numOldPairs, newBinIDs_sorted, newSphereIDs_sorted, numNewPairs,
+                        binIDsEachSphereTouches_sorted, sphereIDsEachBinTouches_sorted);
+            DEME_GPU_CALL(cudaStreamSynchronize(this_stream));
+
+            // binIDsEachSphereTouches gets used for the unique bin IDs below, so it must now be as long as all pairs
+            CD_temp_arr_bytes = (*pNumBinSphereTouchPairs) * sizeof(binID_t);
+            binIDsEachSphereTouches = (binID_t*)scratchPad.allocateTempVector(0, CD_temp_arr_bytes);
+        }
+        // Record the sorted pairs for the next incremental binning
+        if (solverFlags.useIncrementalBinning) {
+            reserveGeometric(sphereBinningRecord.binIDs, *pNumBinSphereTouchPairs);
+            reserveGeometric(sphereBinningRecord.sphereIDs, *pNumBinSphereTouchPairs);
+            sphereBinningRecord.binIDs.resize(*pNumBinSphereTouchPairs);
+            sphereBinningRecord.sphereIDs.resize(*pNumBinSphereTouchPairs);
+            registerContactArraySize(scratchPad, "sphereBinningRecordBinIDs", sphereBinningRecord.binIDs);
+            registerContactArraySize(scratchPad, "sphereBinningRecordSphereIDs", sphereBinningRecord.sphereIDs);
+            DEME_GPU_CALL(cudaMemcpy(sphereBinningRecord.binIDs.data(), binIDsEachSphereTouches_sorted,
+                                     (*pNumBinSphereTouchPairs) * sizeof(binID_t), cudaMemcpyDeviceToDevice));
+            DEME_GPU_CALL(cudaMemcpy(sphereBinningRecord.sphereIDs.data(), sphereIDsEachBinTouches_sorted,
+                                     (*pNumBinSphereTouchPairs) * sizeof(bodyID_t), cudaMemcpyDeviceToDevice));
+            sphereBinningRecord.binSize = simParams->binSize;
+            sphereBinningRecord.valid = true;
+        }
         // std::cout << "Sorted bin IDs: ";
         // displayArray<binID_t>(binIDsEachSphereTouches_sorted, *pNumBinSphereTouchPairs);
         // std::cout << "Corresponding sphere IDs: ";
@@ -199,6 +352,7 @@ void contactDetection(std::shared_ptr<jitify::Program>& bin_sphere_kernels,
             numSpheresBinTouches, sphereIDsLookUpTable, *pNumActiveBins, this_stream, scratchPad);
         // std::cout << "sphereIDsLookUpTable: ";
         // displayArray<binSphereTouchPairs_t>(sphereIDsLookUpTable, *pNumActiveBins);
+        timers.Stop(KT_SORT_BIN_SPHERE_PAIRS);
 
         ////////////////////////////////////////////////////////////////////////////////
         // Triangle-related discretization
@@ -213,6 +367,7 @@ void contactDetection(std::shared_ptr<jitify::Program>& bin_sphere_kernels,
         binsTriangleTouchPairs_t* triIDsLookUpTable;
         float3 *sandwichANode1, *sandwichANode2, *sandwichANode3, *sandwichBNode1, *sandwichBNode2, *sandwichBNode3;
         if (simParams->nTriGM > 0) {
+            timers.Start(KT_BIN_TRIANGLES);
             // 0-th step: Make `sandwich' for each triangle (or say, create a prism out of each triangle). This is
             // obviously for our delayed contact detection safety. And finally, if a sphere's distance away from one of
             // the 2 prism surfaces is smaller than its radius, it has contact with this prism, hence potentially with
@@ -349,14 +504,15 @@ void contactDetection(std::shared_ptr<jitify::Program>& bin_sphere_kernels,
             triIDsLookUpTable = (binsTriangleTouchPairs_t*)scratchPad.allocateTempVector(11, CD_temp_arr_bytes);
             cubDEMPrefixScan<trianglesBinTouches_t, binsTriangleTouchPairs_t, DEMSolverStateData>(
                 numTrianglesBinTouches, triIDsLookUpTable, *pNumActiveBinsForTri, this_stream, scratchPad);
+            timers.Stop(KT_BIN_TRIANGLES);
         }
-        timers.GetTimer("Discretize domain").stop();
+        timers.Stop(KT_DISCRETIZE_DOMAIN);
 
         ////////////////////////////////////////////////////////////////////////////////
         // Populating contact pairs
         ////////////////////////////////////////////////////////////////////////////////
 
-        timers.GetTimer("Find contact pairs").start();
+        timers.Start(KT_FIND_CONTACT_PAIRS);
         // Final step: find the contact pairs. One-two punch: first find num of contacts in each bin, then prescan, then
         // find the actual pair names. A new temp array is needed for this numSphContactsInEachBin. Note we assume the
         // number of contact in each bin is the same level as the number of spheres in each bin (capped by the same data
@@ -397,6 +553,31 @@ void contactDetection(std::shared_ptr<jitify::Program>& bin_sphere_kernels,
                 // displayArray<binContactPairs_t>(numTriSphContactsInEachBin, *pNumActiveBinsForTri);
             }
 
+            // With hierarchical binning, the pairs of spheres binned in different levels are not found by the bin-wise
+            // sweep: each sphere looks for them in the coarser levels, using vectors 15 and 16
+            size_t nCrossLevelContact = 0;
+            contactPairs_t* crossLevelReportOffsets;
+            if (simParams->nBinLevels > 1 && simParams->nSpheresGM > 0) {
+                CD_temp_arr_bytes = simParams->nSpheresGM * sizeof(contactPairs_t);
+                contactPairs_t* numCrossLevelContacts =
+                    (contactPairs_t*)scratchPad.allocateTempVector(15, CD_temp_arr_bytes);
+                size_t blocks_needed_for_spheres =
+                    (simParams->nSpheresGM + DEME_NUM_BODIES_PER_BLOCK - 1) / DEME_NUM_BODIES_PER_BLOCK;
+                sphere_contact_kernels->kernel("getNumberOfCrossLevelSphereContacts")
+                    .instantiate()
+                    .configure(dim3(blocks_needed_for_spheres), dim3(DEME_NUM_BODIES_PER_BLOCK), 0, this_stream)
+                    .launch(simParams, granData, sphereIDsEachBinTouches_sorted, activeBinIDs, numSpheresBinTouches,
+                            sphereIDsLookUpTable, numCrossLevelContacts, *pNumActiveBins);
+                DEME_GPU_CALL_WATCH_BETA(cudaStreamSynchronize(this_stream));
+                CD_temp_arr_bytes = (simParams->nSpheresGM + 1) * sizeof(contactPairs_t);
+                crossLevelReportOffsets = (contactPairs_t*)scratchPad.allocateTempVector(16, CD_temp_arr_bytes);
+                cubDEMPrefixScan<contactPairs_t, contactPairs_t, DEMSolverStateData>(
+                    numCrossLevelContacts, crossLevelReportOffsets, simParams->nSpheresGM, this_stream, scratchPad);
+                nCrossLevelContact = (size_t)numCrossLevelContacts[simParams->nSpheresGM - 1] +
+                                     (size_t)crossLevelReportOffsets[simParams->nSpheresGM - 1];
+                crossLevelReportOffsets[simParams->nSpheresGM] = nCrossLevelContact;
+            }
+
             //// TODO: sphere should have jitified and non-jitified part. Use a component ID > max_comp_id to signal
             /// bringing data from global memory. / TODO: Add tri--sphere CD kernel (if mesh support is to be added).
             /// This kernel integrates tri--boundary CD. Note triangle facets can have jitified (many bodies of the same
@@ -444,9 +625,11 @@ void contactDetection(std::shared_ptr<jitify::Program>& bin_sphere_kernels,
             // std::cout << "nSphereGeoContact: " << nSphereGeoContact << std::endl;
             // std::cout << "nSphereSphereContact: " << nSphereSphereContact << std::endl;
 
-            *scratchPad.pNumContacts = nSphereSphereContact + nSphereGeoContact + nTriSphereContact;
+            *scratchPad.pNumContacts =
+                nSphereSphereContact + nCrossLevelContact + nSphereGeoContact + nTriSphereContact;
             if (*scratchPad.pNumContacts > idGeometryA.size()) {
-                contactEventArraysResize(*scratchPad.pNumContacts, idGeometryA, idGeometryB, contactType, granData);
+                contactEventArraysResize(*scratchPad.pNumContacts, idGeometryA, idGeometryB, contactType, granData,
+                                         scratchPad);
             }
 
             // Sphere--sphere contact pairs go after sphere--anal-geo contacts
@@ -461,11 +644,27 @@ void contactDetection(std::shared_ptr<jitify::Program>& bin_sphere_kernels,
                         sphereIDsLookUpTable, sphSphContactReportOffsets, idSphA, idSphB, dType, *pNumActiveBins);
             DEME_GPU_CALL(cudaStreamSynchronize(this_stream));
 
-            // Triangle--sphere contact pairs go after sphere--sphere contacts. Remember to mark their type.
-            if (blocks_needed_for_bins_tri > 0) {
+            // Cross-level sphere--sphere contact pairs go after the bin-wise ones
+            if (nCrossLevelContact > 0) {
                 idSphA = (granData->idGeometryA + nSphereGeoContact + nSphereSphereContact);
-                bodyID_t* idTriB = (granData->idGeometryB + nSphereGeoContact + nSphereSphereContact);
+                idSphB = (granData->idGeometryB + nSphereGeoContact + nSphereSphereContact);
                 dType = (granData->contactType + nSphereGeoContact + nSphereSphereContact);
+                size_t blocks_needed_for_spheres =
+                    (simParams->nSpheresGM + DEME_NUM_BODIES_PER_BLOCK - 1) / DEME_NUM_BODIES_PER_BLOCK;
+                sphere_contact_kernels->kernel("populateCrossLevelSphereContacts")
+                    .instantiate()
+                    .configure(dim3(blocks_needed_for_spheres), dim3(DEME_NUM_BODIES_PER_BLOCK), 0, this_stream)
+                    .launch(simParams, granData, sphereIDsEachBinTouches_sorted, activeBinIDs, numSpheresBinTouches,
+                            sphereIDsLookUpTable, crossLevelReportOffsets, idSphA, idSphB, dType, *pNumActiveBins);
+                DEME_GPU_CALL(cudaStreamSynchronize(this_stream));
+            }
+
+            // Triangle--sphere contact pairs go after sphere--sphere contacts. Remember to mark their type.
+            if (blocks_needed_for_bins_tri > 0) {
+                const size_t nSphereContact = nSphereGeoContact + nSphereSphereContact + nCrossLevelContact;
+                idSphA = (granData->idGeometryA + nSphereContact);
+                bodyID_t* idTriB = (granData->idGeometryB + nSphereContact);
+                dType = (granData->contactType + nSphereContact);
                 sphTri_contact_kernels->kernel("populateTriSphContactsEachBin")
                     .instantiate()
                     .configure(dim3(blocks_needed_for_bins_tri), dim3(DEME_KT_CD_NTHREADS_PER_BLOCK), 0, this_stream)
@@ -481,16 +680,18 @@ void contactDetection(std::shared_ptr<jitify::Program>& bin_sphere_kernels,
                 // displayArray<contact_t>(granData->contactType, *scratchPad.pNumContacts);
             }
         }  // End of bin-wise contact detection subroutine
-        timers.GetTimer("Find contact pairs").stop();
+        timers.Stop(KT_FIND_CONTACT_PAIRS);
     }
 
     ////////////////////////////////////////////////////////////////////////////////
     // Constructing contact history
     ////////////////////////////////////////////////////////////////////////////////
 
-    timers.GetTimer("Build history map").start();
+    timers.Start(KT_BUILD_HISTORY_MAP);
     // Now, sort idGeometryAB by their owners. Needed for identifying persistent contacts in history-based models.
-    if (*scratchPad.pNumContacts > 0) {
+    // Reused contact candidates were stored sorted, and stay sorted when refiltered.
+    if (!reuseCandidates && *scratchPad.pNumContacts > 0) {
+        timers.Start(KT_SORT_CONTACTS_BY_OWNER);
         // All temp vectors are free now, and all of them are fairly long...
         size_t type_arr_bytes = (*scratchPad.pNumContacts) * sizeof(contact_t);
         contact_t* contactType_sorted = (contact_t*)scratchPad.allocateTempVector(0, type_arr_bytes);
@@ -511,6 +712,63 @@ void contactDetection(std::shared_ptr<jitify::Program>& bin_sphere_kernels,
         DEME_GPU_CALL(cudaMemcpy(granData->idGeometryA, idA_sorted, id_arr_bytes, cudaMemcpyDeviceToDevice));
         DEME_GPU_CALL(cudaMemcpy(granData->idGeometryB, idB_sorted, id_arr_bytes, cudaMemcpyDeviceToDevice));
         DEME_GPU_CALL(cudaMemcpy(granData->contactType, contactType_sorted, type_arr_bytes, cudaMemcpyDeviceToDevice));
+        timers.Stop(KT_SORT_CONTACTS_BY_OWNER);
+    }
+    timers.Stop(KT_BUILD_HISTORY_MAP);
+
+    // With a Verlet skin, what binning found are contact candidates: store them, then (and at the CD steps that reuse
+    // them) refilter them to get the contacts at this step
+    if (simParams->verletSkin > 0.) {
+        timers.Start(KT_FIND_CONTACT_PAIRS);
+        if (!reuseCandidates) {
+            nVerletCandidates = *scratchPad.pNumContacts;
+            if (nVerletCandidates > verletIdGeometryA.size()) {
+                contactCandidateArraysResize(nVerletCandidates, verletIdGeometryA, verletIdGeometryB,
+                                             verletContactType, granData, scratchPad);
+            }
+            DEME_GPU_CALL(cudaMemcpy(granData->verletIdGeometryA, granData->idGeometryA,
+                                     nVerletCandidates * sizeof(bodyID_t), cudaMemcpyDeviceToDevice));
+            DEME_GPU_CALL(cudaMemcpy(granData->verletIdGeometryB, granData->idGeometryB,
+                                     nVerletCandidates * sizeof(bodyID_t), cudaMemcpyDeviceToDevice));
+            DEME_GPU_CALL(cudaMemcpy(granData->verletContactType, granData->contactType,
+                                     nVerletCandidates * sizeof(contact_t), cudaMemcpyDeviceToDevice));
+        }
+        *scratchPad.pNumContacts = 0;
+        if (nVerletCandidates > 0) {
+            // Right after binning, the margins still have the skin in them
+            float skinInMargin = reuseCandidates ? 0.f : simParams->verletSkin / 2.f;
+            size_t flag_arr_bytes = nVerletCandidates * sizeof(notStupidBool_t);
+            notStupidBool_t* keep = (notStupidBool_t*)scratchPad.allocateTempVector(0, flag_arr_bytes);
+            size_t offset_arr_bytes = nVerletCandidates * sizeof(contactPairs_t);
+            contactPairs_t* keepOffsets = (contactPairs_t*)scratchPad.allocateTempVector(1, offset_arr_bytes);
+            size_t blocks_needed_for_candidates =
+                (nVerletCandidates + DEME_MAX_THREADS_PER_BLOCK - 1) / DEME_MAX_THREADS_PER_BLOCK;
+            sphere_contact_kernels->kernel("markContactCandidatesToKeep")
+                .instantiate()
+                .configure(dim3(blocks_needed_for_candidates), dim3(DEME_MAX_THREADS_PER_BLOCK), 0, this_stream)
+                .launch(simParams, granData, skinInMargin, keep, nVerletCandidates);
+            DEME_GPU_CALL(cudaStreamSynchronize(this_stream));
+            cubDEMPrefixScan<notStupidBool_t, contactPairs_t, DEMSolverStateData>(keep, keepOffsets, nVerletCandidates,
+                                                                                  this_stream, scratchPad);
+            *scratchPad.pNumContacts =
+                (size_t)keepOffsets[nVerletCandidates - 1] + (size_t)keep[nVerletCandidates - 1];
+            if (*scratchPad.pNumContacts > idGeometryA.size()) {
+                contactEventArraysResize(*scratchPad.pNumContacts, idGeometryA, idGeometryB, contactType, granData,
+                                         scratchPad);
+            }
+            sphere_contact_kernels->kernel("gatherKeptContactCandidates")
+                .instantiate()
+                .configure(dim3(blocks_needed_for_candidates), dim3(DEME_MAX_THREADS_PER_BLOCK), 0, this_stream)
+                .launch(granData, keep, keepOffsets, nVerletCandidates);
+            DEME_GPU_CALL(cudaStreamSynchronize(this_stream));
+        }
+        DEME_STEP_DEBUG_PRINTF("%zu of %zu contact candidates are kept (candidates %s)", *scratchPad.pNumContacts,
+                               nVerletCandidates, reuseCandidates ? "reused" : "just found");
+        timers.Stop(KT_FIND_CONTACT_PAIRS);
+    }
+
+    timers.Start(KT_BUILD_HISTORY_MAP);
+    if (*scratchPad.pNumContacts > 0) {
         // DEME_DEBUG_PRINTF("New contact IDs (A):");
         // DEME_DEBUG_EXEC(displayArray<bodyID_t>(granData->idGeometryA, *scratchPad.pNumContacts));
         // DEME_DEBUG_PRINTF("New contact IDs (B):");
@@ -561,6 +819,7 @@ void contactDetection(std::shared_ptr<jitify::Program>& bin_sphere_kernels,
 
         // Only need to proceed if history-based
         if (!solverFlags.isHistoryless) {
+            timers.Start(KT_PERSISTENT_CONTACT_MAP);
             geoSphereTouches_t* old_idA_runlength =
                 (geoSphereTouches_t*)scratchPad.allocateTempVector(2, run_length_bytes);
             bodyID_t* unique_old_idA = (bodyID_t*)scratchPad.allocateTempVector(3, unique_id_bytes);
@@ -615,7 +874,9 @@ void contactDetection(std::shared_ptr<jitify::Program>& bin_sphere_kernels,
             // manually store the mapping. This mapping's elemental values are the indices of the corresponding
             // contacts in the previous contact array.
             if (*scratchPad.pNumContacts > contactMapping.size()) {
+                reserveGeometric(contactMapping, *scratchPad.pNumContacts);
                 contactMapping.resize(*scratchPad.pNumContacts);
+                registerContactArraySize(scratchPad, "contactMapping", contactMapping);
                 granData->contactMapping = contactMapping.data();
             }
             blocks_needed_for_mapping = (nSpheresSafe + DEME_NUM_BODIES_PER_BLOCK - 1) / DEME_NUM_BODIES_PER_BLOCK;
@@ -667,9 +928,15 @@ void contactDetection(std::shared_ptr<jitify::Program>& bin_sphere_kernels,
             // Finally, copy new contact array to old contact array for the record. Note we register old contact pairs
             // with the array sorted by A, but when supplying dT, it was sorted by contact type.
             if (*scratchPad.pNumContacts > previous_idGeometryA.size()) {
+                reserveGeometric(previous_idGeometryA, *scratchPad.pNumContacts);
+                reserveGeometric(previous_idGeometryB, *scratchPad.pNumContacts);
+                reserveGeometric(previous_contactType, *scratchPad.pNumContacts);
                 previous_idGeometryA.resize(*scratchPad.pNumContacts);
                 previous_idGeometryB.resize(*scratchPad.pNumContacts);
                 previous_contactType.resize(*scratchPad.pNumContacts);
+                registerContactArraySize(scratchPad, "previous_idGeometryA", previous_idGeometryA);
+                registerContactArraySize(scratchPad, "previous_idGeometryB", previous_idGeometryB);
+                registerContactArraySize(scratchPad, "previous_contactType", previous_contactType);
 
                 granData->previous_idGeometryA = previous_idGeometryA.data();
                 granData->previous_idGeometryB = previous_idGeometryB.data();
@@ -681,9 +948,11 @@ void contactDetection(std::shared_ptr<jitify::Program>& bin_sphere_kernels,
                                      cudaMemcpyDeviceToDevice));
             DEME_GPU_CALL(cudaMemcpy(granData->previous_contactType, granData->contactType, type_arr_bytes,
                                      cudaMemcpyDeviceToDevice));
+            timers.Stop(KT_PERSISTENT_CONTACT_MAP);
 
             // dT potentially benefits from type-sorted contact array
             if (solverFlags.should_sort_pairs) {
+                timers.Start(KT_SORT_CONTACTS_BY_TYPE);
                 size_t type_arr_bytes = (*scratchPad.pNumContacts) * sizeof(contact_t);
                 contact_t* contactType_sorted = (contact_t*)scratchPad.allocateTempVector(1, type_arr_bytes);
                 size_t id_arr_bytes = (*scratchPad.pNumContacts) * sizeof(bodyID_t);
@@ -720,9 +989,11 @@ void contactDetection(std::shared_ptr<jitify::Program>& bin_sphere_kernels,
                     cudaMemcpy(granData->contactType, contactType_sorted, type_arr_bytes, cudaMemcpyDeviceToDevice));
                 DEME_GPU_CALL(
                     cudaMemcpy(granData->contactMapping, map_sorted, cnt_arr_bytes, cudaMemcpyDeviceToDevice));
+                timers.Stop(KT_SORT_CONTACTS_BY_TYPE);
             }
         } else {  // If historyless, might still want to sort based on type
             if (solverFlags.should_sort_pairs) {
+                timers.Start(KT_SORT_CONTACTS_BY_TYPE);
                 size_t type_arr_bytes = (*scratchPad.pNumContacts) * sizeof(contact_t);
                 contact_t* contactType_sorted = (contact_t*)scratchPad.allocateTempVector(1, type_arr_bytes);
                 size_t id_arr_bytes = (*scratchPad.pNumContacts) * sizeof(bodyID_t);
@@ -741,10 +1012,11 @@ void contactDetection(std::shared_ptr<jitify::Program>& bin_sphere_kernels,
                 DEME_GPU_CALL(cudaMemcpy(granData->idGeometryB, idB_sorted, id_arr_bytes, cudaMemcpyDeviceToDevice));
                 DEME_GPU_CALL(
                     cudaMemcpy(granData->contactType, contactType_sorted, type_arr_bytes, cudaMemcpyDeviceToDevice));
+                timers.Stop(KT_SORT_CONTACTS_BY_TYPE);
             }
         }
     }  // End of contact sorting--mapping subroutine
-    timers.GetTimer("Build history map").stop();
+    timers.Stop(KT_BUILD_HISTORY_MAP);
 
     // Finally, don't forget to store the number of contacts for the next iteration, even if there is 0 contacts (in
     // that case, mapping will not be constructed, but we don't have to worry b/c in the next iteration, simply no work
@@ -788,9 +1060,15 @@ void overwritePrevContactArrays(DEMDataKT* kT_data,
 
     // Finally, copy sorted user contact array to the storage
     if (nContacts > previous_idGeometryA.size()) {
+        reserveGeometric(previous_idGeometryA, nContacts);
+        reserveGeometric(previous_idGeometryB, nContacts);
+        reserveGeometric(previous_contactType, nContacts);
         previous_idGeometryA.resize(nContacts);
         previous_idGeometryB.resize(nContacts);
         previous_contactType.resize(nContacts);
+        registerContactArraySize(scratchPad, "previous_idGeometryA", previous_idGeometryA);
+        registerContactArraySize(scratchPad, "previous_idGeometryB", previous_idGeometryB);
+        registerContactArraySize(scratchPad, "previous_contactType", previous_contactType);
 
         kT_data->previous_idGeometryA = previous_idGeometryA.data();
         kT_data->previous_idGeometryB = previous_idGeometryB.data();
@@ -166,4 +166,56 @@ void doubleSortByKey(notStupidBool_t* d_keys_in,
                                                                   this_stream, scratchPad);
 }
 
+////////////////////////////////////////////////////////////////////////////////
+// Select
+////////////////////////////////////////////////////////////////////////////////
+
+void contactIDSelectFlagged(notStupidBool_t* d_flags,
+                            contactPairs_t* d_out,
+                            size_t* d_num_out,
+                            size_t n,
+                            cudaStream_t& this_stream,
+                            DEMSolverStateData& scratchPad) {
+    cub::CountingInputIterator<contactPairs_t> ids(0);
+    cubDEMSelectFlagged<cub::CountingInputIterator<contactPairs_t>, notStupidBool_t, contactPairs_t,
+                        DEMSolverStateData>(ids, d_flags, d_out, d_num_out, n, this_stream, scratchPad);
+}
+void ownerIDSelectFlagged(notStupidBool_t* d_flags,
+                          bodyID_t* d_out,
+                          size_t* d_num_out,
+                          size_t n,
+                          cudaStream_t& this_stream,
+                          DEMSolverStateData& scratchPad) {
+    cub::CountingInputIterator<bodyID_t> ids(0);
+    cubDEMSelectFlagged<cub::CountingInputIterator<bodyID_t>, notStupidBool_t, bodyID_t, DEMSolverStateData>(
+        ids, d_flags, d_out, d_num_out, n, this_stream, scratchPad);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Scan
+////////////////////////////////////////////////////////////////////////////////
+
+void contactFlagPrefixScan(notStupidBool_t* d_flags,
+                           contactPairs_t* d_out,
+                           size_t n,
+                           cudaStream_t& this_stream,
+                           DEMSolverStateData& scratchPad) {
+    cubDEMPrefixScan<notStupidBool_t, contactPairs_t, DEMSolverStateData>(d_flags, d_out, n, this_stream, scratchPad);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// RunLengthEncode
+////////////////////////////////////////////////////////////////////////////////
+
+void contactTypeRunLengthEncode(contact_t* d_in,
+                                contact_t* d_unique_out,
+                                contactPairs_t* d_counts_out,
+                                size_t* d_num_out,
+                                size_t n,
+                                cudaStream_t& this_stream,
+                                DEMSolverStateData& scratchPad) {
+    cubDEMRunLengthEncode<contact_t, contactPairs_t, DEMSolverStateData>(d_in, d_unique_out, d_counts_out, d_num_out,
+                                                                         n, this_stream, scratchPad);
+}
+
 }  // namespace deme
@@ -79,6 +79,23 @@ inline void cubDEMUnique(T1* d_in, T1* d_out, size_t* d_num_out, size_t n, cudaS
     DEME_GPU_CALL(cudaStreamSynchronize(this_stream));
 }
 
+// d_in can be an iterator (such as a counting iterator, to select the indices of the flagged items)
+template <typename T1, typename T2, typename T3, typename T4>
+inline void cubDEMSelectFlagged(T1 d_in,
+                                T2* d_flags,
+                                T3* d_out,
+                                size_t* d_num_out,
+                                size_t n,
+                                cudaStream_t& this_stream,
+                                T4& scratchPad) {
+    size_t cub_scratch_bytes = 0;
+    cub::DeviceSelect::Flagged(NULL, cub_scratch_bytes, d_in, d_flags, d_out, d_num_out, n, this_stream);
+    DEME_GPU_CALL(cudaStreamSynchronize(this_stream));
+    void* d_scratch_space = (void*)scratchPad.allocateScratchSpace(cub_scratch_bytes);
+    cub::DeviceSelect::Flagged(d_scratch_space, cub_scratch_bytes, d_in, d_flags, d_out, d_num_out, n, this_stream);
+    DEME_GPU_CALL(cudaStreamSynchronize(this_stream));
+}
+
 template <typename T1, typename T2, typename T3>
 inline void cubDEMRunLengthEncode(T1* d_in,
                                   T1* d_unique_out,
@@ -0,0 +1,499 @@
+//  Copyright (c) 2021, SBEL GPU Development Team
+//  Copyright (c) 2021, University of Wisconsin - Madison
+//
+//	SPDX-License-Identifier: BSD-3-Clause
+
+// kT's contact detection, run on host threads rather than on the device. It works on the same DEMSimParams and
+// DEMDataKT (all managed memory), and produces the same contact pair arrays and persistent contact map as
+// contactDetection, so dT cannot tell the difference.
+
+#include <algorithm>
+#include <limits>
+#include <numeric>
+#include <thread>
+#include <vector>
+
+#include <core/utils/HostWorkerPool.hpp>
+#include <core/utils/JitHelper.h>
+#include <nvmath/helper_math.cuh>
+
+#include <algorithms/DEMCubBasedSubroutines.h>
+#include <DEM/HostSideHelpers.hpp>
+
+namespace deme {
+
+// Run fn(slice, begin, end) on nSlices static slices of [0, n), using the worker pool
+template <typename Func>
+static void hostParallelFor(HostWorkerPool& workers, size_t n, size_t nSlices, Func&& fn) {
+    nSlices = std::max<size_t>(1, std::min<size_t>(nSlices, n));
+    workers.Run(nSlices, [&](size_t i) { fn(i, n * i / nSlices, n * (i + 1) / nSlices); });
+}
+
+// A sphere, as contact detection sees it: its radius has the owner's margin in it
+struct HostCDSphere {
+    double X, Y, Z;
+    float radius;
+    bodyID_t owner;
+    family_t family;
+};
+
+// The bin index of a coordinate in units of bin size, as the device's float-to-unsigned conversion gives it
+static inline binID_t hostPointBinIndex(const double& x) {
+    if (x <= 0.)
+        return 0;
+    if (x >= (double)std::numeric_limits<binID_t>::max())
+        return std::numeric_limits<binID_t>::max();
+    return (binID_t)x;
+}
+
+// Host version of checkSpheresOverlap followed by the bin of the contact point, as calcContactPoint does it: in
+// periodic directions, A is in contact with the closest image of B, and the contact point is wrapped into the period
+static inline bool hostCalcContactPoint(const DEMSimParams* simParams,
+                                        const HostCDSphere& A,
+                                        HostCDSphere B,
+                                        binID_t& binID,
+                                        float artificialMarginA,
+                                        float artificialMarginB) {
+    B.X += hostPeriodicImageShift(B.X - A.X, simParams->periodicX, simParams->periodX);
+    B.Y += hostPeriodicImageShift(B.Y - A.Y, simParams->periodicY, simParams->periodY);
+    B.Z += hostPeriodicImageShift(B.Z - A.Z, simParams->periodicZ, simParams->periodZ);
+    const double radA = A.radius, radB = B.radius;
+    const double centerDist2 = (A.X - B.X) * (A.X - B.X) + (A.Y - B.Y) * (A.Y - B.Y) + (A.Z - B.Z) * (A.Z - B.Z);
+    bool in_contact = centerDist2 <= (radA + radB) * (radA + radB);
+    float normX = A.X - B.X, normY = A.Y - B.Y, normZ = A.Z - B.Z;
+    float normLen = std::sqrt(normX * normX + normY * normY + normZ * normZ);
+    if (normLen > 0.f) {
+        normX /= normLen;
+        normY /= normLen;
+        normZ /= normLen;
+    }
+    const double overlapDepth = radA + radB - std::sqrt(centerDist2);
+    double CPX = B.X + (radB - overlapDepth / 2.) * normX;
+    double CPY = B.Y + (radB - overlapDepth / 2.) * normY;
+    double CPZ = B.Z + (radB - overlapDepth / 2.) * normZ;
+    hostWrapIntoPeriod(CPX, simParams->periodicX, simParams->periodStartX, simParams->periodX);
+    hostWrapIntoPeriod(CPY, simParams->periodicY, simParams->periodStartY, simParams->periodY);
+    hostWrapIntoPeriod(CPZ, simParams->periodicZ, simParams->periodStartZ, simParams->periodZ);
+
+    float artificialMargin = (artificialMarginA < artificialMarginB) ? artificialMarginA : artificialMarginB;
+    in_contact = in_contact && (overlapDepth > (double)artificialMargin);
+    binID = hostPointBinIndex(CPX / simParams->binSize) + hostPointBinIndex(CPY / simParams->binSize) * simParams->nbX +
+            hostPointBinIndex(CPZ / simParams->binSize) * simParams->nbX * simParams->nbY;
+    return in_contact;
+}
+
+// Host version of checkSphereEntityOverlap, giving only the contact type and the overlap depth
+static inline contact_t hostCheckSphereEntityOverlap(const double3& A,
+                                                     const double& radA,
+                                                     const objType_t& typeB,
+                                                     const double3& B,
+                                                     const float3& dirB,
+                                                     const float& size1B,
+                                                     const float& beta4Entity,
+                                                     double& overlapDepth) {
+    switch (typeB) {
+        case (ANAL_OBJ_TYPE_PLANE): {
+            const double dist = (A.x - B.x) * dirB.x + (A.y - B.y) * dirB.y + (A.z - B.z) * dirB.z;
+            overlapDepth = radA + beta4Entity - dist;
+            return (overlapDepth < 0.0) ? NOT_A_CONTACT : SPHERE_PLANE_CONTACT;
+        }
+        case (ANAL_OBJ_TYPE_CYL_INF): {
+            double3 sph2cyl = make_double3(B.x - A.x, B.y - A.y, B.z - A.z);
+            const double proj_dist = sph2cyl.x * dirB.x + sph2cyl.y * dirB.y + sph2cyl.z * dirB.z;
+            sph2cyl.x -= proj_dist * dirB.x;
+            sph2cyl.y -= proj_dist * dirB.y;
+            sph2cyl.z -= proj_dist * dirB.z;
+            const double dist_delta_r =
+                std::sqrt(sph2cyl.x * sph2cyl.x + sph2cyl.y * sph2cyl.y + sph2cyl.z * sph2cyl.z);
+            overlapDepth = radA - std::abs(size1B - dist_delta_r - beta4Entity);
+            return (overlapDepth <= DEME_TINY_FLOAT) ? NOT_A_CONTACT : SPHERE_CYL_CONTACT;
+        }
+        default:
+            // Plates never make contacts, in the device version either
+            return NOT_A_CONTACT;
+    }
+}
+
+template <typename T>
+static inline void hostCDArrayResize(DEMSolverStateData& scratchPad,
+                                     const char* name,
+                                     std::vector<T, ManagedAllocator<T>>& vec,
+                                     size_t n) {
+    reserveGeometric(vec, n);
+    vec.resize(n);
+    if (scratchPad.memRegistry)
+        scratchPad.memRegistry->Set(name, vec.capacity() * sizeof(T));
+}
+
+void hostContactDetection(DEMDataKT* granData,
+                          DEMSimParams* simParams,
+                          SolverFlags& solverFlags,
+                          VERBOSITY& verbosity,
+                          const HostAnalyticalEntities& analEntities,
+                          std::vector<bodyID_t, ManagedAllocator<bodyID_t>>& idGeometryA,
+                          std::vector<bodyID_t, ManagedAllocator<bodyID_t>>& idGeometryB,
+                          std::vector<contact_t, ManagedAllocator<contact_t>>& contactType,
+                          std::vector<bodyID_t, ManagedAllocator<bodyID_t>>& previous_idGeometryA,
+                          std::vector<bodyID_t, ManagedAllocator<bodyID_t>>& previous_idGeometryB,
+                          std::vector<contact_t, ManagedAllocator<contact_t>>& previous_contactType,
+                          std::vector<contactPairs_t, ManagedAllocator<contactPairs_t>>& contactMapping,
+                          DEMSolverStateData& scratchPad,
+                          SolverTimers& timers,
+                          kTStateParams& stateParams,
+                          HostWorkerPool& workers) {
+    if (simParams->nSpheresGM == 0) {
+        *scratchPad.pNumContacts = 0;
+        *scratchPad.pNumPrevContacts = 0;
+        *scratchPad.pNumPrevSpheres = 0;
+        return;
+    }
+    if (simParams->nTriGM > 0) {
+        DEME_ERROR("Contact detection on the host does not support meshed objects yet, but %zu triangles are loaded.",
+                   (size_t)simParams->nTriGM);
+    }
+    const unsigned int nThreads = (solverFlags.hostCDNumThreads > 0)
+                                      ? solverFlags.hostCDNumThreads
+                                      : std::max(1u, std::thread::hardware_concurrency());
+    // The workers stay alive between contact detection runs; this only re-creates them if nThreads changed
+    workers.SetNumThreads(nThreads);
+    const size_t nSpheres = simParams->nSpheresGM;
+    stateParams.maxTriFoundInBin = 0;
+    stateParams.avgCntsPerSphere = 0;
+    stateParams.numSpheresRebinned = nSpheres;
+
+    timers.Start(KT_DISCRETIZE_DOMAIN);
+    timers.Start(KT_BIN_SPHERES);
+    // Where the spheres are, and how many bins and analytical entities each touches
+    std::vector<HostCDSphere> spheres(nSpheres);
+    std::vector<size_t> numBinsSphereTouches(nSpheres + 1), numAnalGeoSphereTouches(nSpheres + 1);
+    // The ranges of bins each sphere touches in X, Y and Z: up to 2 of them in a periodic direction, if the sphere's
+    // image at the other end of the period touches bins too
+    std::vector<binID_t> binLo(6 * nSpheres), binHi(6 * nSpheres);
+    std::vector<unsigned int> numBinRanges(3 * nSpheres);
+    // The analytical entities in the global frame
+    const size_t nAnal = simParams->nAnalGM;
+    std::vector<double3> analPos(nAnal);
+    std::vector<float3> analRot(nAnal);
+    for (size_t objB = 0; objB < nAnal; objB++) {
+        const bodyID_t owner = analEntities.owner[objB];
+        double3 ownerXYZ;
+        hostVoxelIDToPosition<double, voxelID_t, subVoxelPos_t>(
+            ownerXYZ.x, ownerXYZ.y, ownerXYZ.z, granData->voxelID[owner], granData->locX[owner], granData->locY[owner],
+            granData->locZ[owner], simParams->nvXp2, simParams->nvYp2, simParams->voxelSize, simParams->l);
+        float3 relPos = analEntities.relPos[objB];
+        float3 rot = analEntities.rot[objB];
+        hostApplyOriQToVector3<float, oriQ_t>(relPos.x, relPos.y, relPos.z, granData->oriQw[owner],
+                                              granData->oriQx[owner], granData->oriQy[owner], granData->oriQz[owner]);
+        hostApplyOriQToVector3<float, oriQ_t>(rot.x, rot.y, rot.z, granData->oriQw[owner], granData->oriQx[owner],
+                                              granData->oriQy[owner], granData->oriQz[owner]);
+        analPos[objB] = make_double3(ownerXYZ.x + relPos.x, ownerXYZ.y + relPos.y, ownerXYZ.z + relPos.z);
+        analRot[objB] = rot;
+    }
+    // Whether a sphere and an analytical entity are in contact, and the contact type
+    auto sphereAnalContact = [&](const HostCDSphere& sph, size_t objB) -> contact_t {
+        const bodyID_t objBOwner = analEntities.owner[objB];
+        const family_t objFamily = granData->familyID[objBOwner];
+        if (granData->familyMasks[locateMaskPair<unsigned int>(sph.family, objFamily)] != DONT_PREVENT_CONTACT)
+            return NOT_A_CONTACT;
+        double overlapDepth;
+        contact_t type = hostCheckSphereEntityOverlap(make_double3(sph.X, sph.Y, sph.Z), (double)sph.radius,
+                                                      analEntities.type[objB], analPos[objB], analRot[objB],
+                                                      analEntities.size1[objB], granData->marginSize[objBOwner],
+                                                      overlapDepth);
+        double marginThres = std::min(granData->familyExtraMarginSize[sph.family],
+                                      granData->familyExtraMarginSize[objFamily]);
+        return (type != NOT_A_CONTACT && overlapDepth > marginThres) ? type : NOT_A_CONTACT;
+    };
+
+    hostParallelFor(workers, nSpheres, nThreads, [&](size_t, size_t begin, size_t end) {
+        for (size_t sphereID = begin; sphereID < end; sphereID++) {
+            HostCDSphere& sph = spheres[sphereID];
+            sph.owner = granData->ownerClumpBody[sphereID];
+            sph.family = granData->familyID[sph.owner];
+            // Template info lives in the global arrays either way; with jitified templates, it is per component
+            const size_t compID = solverFlags.useClumpJitify ? granData->clumpComponentOffsetExt[sphereID] : sphereID;
+            float3 relPos = host_make_float3(granData->relPosSphereX[compID], granData->relPosSphereY[compID],
+                                             granData->relPosSphereZ[compID]);
+            sph.radius = granData->radiiSphere[compID] + granData->marginSize[sph.owner];
+            double ownerX, ownerY, ownerZ;
+            hostVoxelIDToPosition<double, voxelID_t, subVoxelPos_t>(
+                ownerX, ownerY, ownerZ, granData->voxelID[sph.owner], granData->locX[sph.owner],
+                granData->locY[sph.owner], granData->locZ[sph.owner], simParams->nvXp2, simParams->nvYp2,
+                simParams->voxelSize, simParams->l);
+            hostApplyOriQToVector3<float, oriQ_t>(relPos.x, relPos.y, relPos.z, granData->oriQw[sph.owner],
+                                                  granData->oriQx[sph.owner], granData->oriQy[sph.owner],
+                                                  granData->oriQz[sph.owner]);
+            sph.X = ownerX + (double)relPos.x;
+            sph.Y = ownerY + (double)relPos.y;
+            sph.Z = ownerZ + (double)relPos.z;
+
+            const double binSize = simParams->binSize;
+            const double radiusSpan = sph.radius / binSize;
+            numBinRanges[3 * sphereID] = hostPeriodicSphereBinRanges1D(
+                &binLo[6 * sphereID], &binHi[6 * sphereID], sph.X / binSize, radiusSpan, simParams->nbX,
+                simParams->periodicX, simParams->periodStartX / binSize, simParams->periodX / binSize);
+            numBinRanges[3 * sphereID + 1] = hostPeriodicSphereBinRanges1D(
+                &binLo[6 * sphereID + 2], &binHi[6 * sphereID + 2], sph.Y / binSize, radiusSpan, simParams->nbY,
+                simParams->periodicY, simParams->periodStartY / binSize, simParams->periodY / binSize);
+            numBinRanges[3 * sphereID + 2] = hostPeriodicSphereBinRanges1D(
+                &binLo[6 * sphereID + 4], &binHi[6 * sphereID + 4], sph.Z / binSize, radiusSpan, simParams->nbZ,
+                simParams->periodicZ, simParams->periodStartZ / binSize, simParams->periodZ / binSize);
+            size_t numBins = 1;
+            for (unsigned int dir = 0; dir < 3; dir++) {
+                size_t numInDir = 0;
+                for (unsigned int r = 0; r < numBinRanges[3 * sphereID + dir]; r++) {
+                    numInDir += binHi[6 * sphereID + 2 * dir + r] - binLo[6 * sphereID + 2 * dir + r] + 1;
+                }
+                numBins *= numInDir;
+            }
+            numBinsSphereTouches[sphereID] = numBins;
+
+            size_t nAnalContacts = 0;
+            for (size_t objB = 0; objB < nAnal; objB++) {
+                if (sphereAnalContact(sph, objB) != NOT_A_CONTACT)
+                    nAnalContacts++;
+            }
+            numAnalGeoSphereTouches[sphereID] = nAnalContacts;
+        }
+    });
+    // Offsets, then all bin--sphere pairs and sphere--analytical contacts, in the order of sphere IDs
+    std::exclusive_scan(numBinsSphereTouches.begin(), numBinsSphereTouches.end(), numBinsSphereTouches.begin(),
+                        (size_t)0);
+    std::exclusive_scan(numAnalGeoSphereTouches.begin(), numAnalGeoSphereTouches.end(),
+                        numAnalGeoSphereTouches.begin(), (size_t)0);
+    const size_t nBinSpherePairs = numBinsSphereTouches[nSpheres];
+    const size_t nSphereGeoContact = numAnalGeoSphereTouches[nSpheres];
+    std::vector<std::pair<binID_t, bodyID_t>> binSpherePairs(nBinSpherePairs);
+    std::vector<bodyID_t> geoIdA(nSphereGeoContact), geoIdB(nSphereGeoContact);
+    std::vector<contact_t> geoType(nSphereGeoContact);
+    hostParallelFor(workers, nSpheres, nThreads, [&](size_t, size_t begin, size_t end) {
+        for (size_t sphereID = begin; sphereID < end; sphereID++) {
+            size_t offset = numBinsSphereTouches[sphereID];
+            const binID_t* lo = &binLo[6 * sphereID];
+            const binID_t* hi = &binHi[6 * sphereID];
+            const unsigned int* nRanges = &numBinRanges[3 * sphereID];
+            for (unsigned int rz = 0; rz < nRanges[2]; rz++)
+                for (binID_t k = lo[4 + rz]; k <= hi[4 + rz]; k++)
+                    for (unsigned int ry = 0; ry < nRanges[1]; ry++)
+                        for (binID_t j = lo[2 + ry]; j <= hi[2 + ry]; j++)
+                            for (unsigned int rx = 0; rx < nRanges[0]; rx++)
+                                for (binID_t i = lo[rx]; i <= hi[rx]; i++) {
+                                    binSpherePairs[offset++] =
+                                        std::make_pair(i + j * simParams->nbX + k * simParams->nbX * simParams->nbY,
+                                                       (bodyID_t)sphereID);
+                                }
+            offset = numAnalGeoSphereTouches[sphereID];
+            for (size_t objB = 0; objB < nAnal && offset < numAnalGeoSphereTouches[sphereID + 1]; objB++) {
+                contact_t type = sphereAnalContact(spheres[sphereID], objB);
+                if (type != NOT_A_CONTACT) {
+                    geoIdA[offset] = sphereID;
+                    geoIdB[offset] = objB;
+                    geoType[offset] = type;
+                    offset++;
+                }
+            }
+        }
+    });
+    timers.Stop(KT_BIN_SPHERES);
+
+    // Sort the pairs by bin ID then sphere ID, and find where each active bin's spheres start
+    timers.Start(KT_SORT_BIN_SPHERE_PAIRS);
+    std::sort(binSpherePairs.begin(), binSpherePairs.end());
+    std::vector<size_t> binStarts;
+    for (size_t n = 0; n < nBinSpherePairs; n++) {
+        if (n == 0 || binSpherePairs[n].first != binSpherePairs[n - 1].first)
+            binStarts.push_back(n);
+    }
+    binStarts.push_back(nBinSpherePairs);
+    const size_t nActiveBins = binStarts.size() - 1;
+    size_t maxSphInBin = 0;
+    for (size_t b = 0; b < nActiveBins; b++)
+        maxSphInBin = std::max(maxSphInBin, binStarts[b + 1] - binStarts[b]);
+    stateParams.maxSphFoundInBin = maxSphInBin;
+    timers.Stop(KT_SORT_BIN_SPHERE_PAIRS);
+    timers.Stop(KT_DISCRETIZE_DOMAIN);
+
+    // Sphere--sphere contacts, bin by bin. Each is taken only from the bin its contact point is in, so it is found
+    // once. Each slice of bins keeps its own list, and the lists are joined in slice order, so the result does not
+    // depend on timing.
+    timers.Start(KT_FIND_CONTACT_PAIRS);
+    const unsigned int nSlices = (unsigned int)std::max<size_t>(1, std::min<size_t>(nThreads, nActiveBins));
+    std::vector<std::vector<std::pair<bodyID_t, bodyID_t>>> slicePairs(nSlices);
+    hostParallelFor(workers, nActiveBins, nSlices, [&](size_t slice, size_t begin, size_t end) {
+        auto& pairs = slicePairs[slice];
+        for (size_t b = begin; b < end; b++) {
+            const binID_t binID = binSpherePairs[binStarts[b]].first;
+            for (size_t m = binStarts[b]; m < binStarts[b + 1]; m++) {
+                const HostCDSphere& A = spheres[binSpherePairs[m].second];
+                for (size_t n = m + 1; n < binStarts[b + 1]; n++) {
+                    const HostCDSphere& B = spheres[binSpherePairs[n].second];
+                    if (A.owner == B.owner)
+                        continue;
+                    if (granData->familyMasks[locateMaskPair<unsigned int>(A.family, B.family)] !=
+                        DONT_PREVENT_CONTACT)
+                        continue;
+                    binID_t contactPntBin;
+                    bool in_contact = hostCalcContactPoint(simParams, A, B, contactPntBin,
+                                                           granData->familyExtraMarginSize[A.family],
+                                                           granData->familyExtraMarginSize[B.family]);
+                    if (in_contact && contactPntBin == binID) {
+                        const bodyID_t idA = binSpherePairs[m].second, idB = binSpherePairs[n].second;
+                        pairs.emplace_back(std::min(idA, idB), std::max(idA, idB));
+                    }
+                }
+            }
+        }
+    });
+    size_t nSphereSphereContact = 0;
+    for (const auto& pairs : slicePairs)
+        nSphereSphereContact += pairs.size();
+
+    // Sphere--analytical contacts go first, like the device version puts them
+    const size_t nContacts = nSphereGeoContact + nSphereSphereContact;
+    *scratchPad.pNumContacts = nContacts;
+    if (nContacts > idGeometryA.size()) {
+        hostCDArrayResize(scratchPad, "idGeometryA", idGeometryA, nContacts);
+        hostCDArrayResize(scratchPad, "idGeometryB", idGeometryB, nContacts);
+        hostCDArrayResize(scratchPad, "contactType", contactType, nContacts);
+        granData->idGeometryA = idGeometryA.data();
+        granData->idGeometryB = idGeometryB.data();
+        granData->contactType = contactType.data();
+    }
+    // All contacts, sorted by idA; stable, like the device radix sort is
+    std::vector<bodyID_t> allIdA(nContacts), allIdB(nContacts);
+    std::vector<contact_t> allType(nContacts);
+    std::copy(geoIdA.begin(), geoIdA.end(), allIdA.begin());
+    std::copy(geoIdB.begin(), geoIdB.end(), allIdB.begin());
+    std::copy(geoType.begin(), geoType.end(), allType.begin());
+    {
+        size_t offset = nSphereGeoContact;
+        for (const auto& pairs : slicePairs) {
+            for (const auto& p : pairs) {
+                allIdA[offset] = p.first;
+                allIdB[offset] = p.second;
+                allType[offset] = SPHERE_SPHERE_CONTACT;
+                offset++;
+            }
+        }
+    }
+    timers.Stop(KT_FIND_CONTACT_PAIRS);
+
+    timers.Start(KT_BUILD_HISTORY_MAP);
+    timers.Start(KT_SORT_CONTACTS_BY_OWNER);
+    std::vector<size_t> order(nContacts);
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) { return allIdA[a] < allIdA[b]; });
+    for (size_t n = 0; n < nContacts; n++) {
+        granData->idGeometryA[n] = allIdA[order[n]];
+        granData->idGeometryB[n] = allIdB[order[n]];
+        granData->contactType[n] = allType[order[n]];
+    }
+    timers.Stop(KT_SORT_CONTACTS_BY_OWNER);
+
+    if (nContacts > 0) {
+        size_t nUniqueA = 1;
+        for (size_t n = 1; n < nContacts; n++) {
+            if (granData->idGeometryA[n] != granData->idGeometryA[n - 1])
+                nUniqueA++;
+        }
+        stateParams.avgCntsPerSphere = (float)nContacts / (float)nUniqueA;
+        DEME_STEP_DEBUG_PRINTF("Average number of contacts for each geometry: %.7g", stateParams.avgCntsPerSphere);
+        if (stateParams.avgCntsPerSphere > solverFlags.errOutAvgSphCnts) {
+            DEME_ERROR(
+                "On average a sphere has %.7g contacts, more than the max allowance (%.7g).\nIf you believe "
+                "this is not abnormal, set the allowance high using SetErrorOutAvgContacts before "
+                "initialization.\nIf you think this is because dT drifting too much ahead of kT so the contact "
+                "margin added is too big, use SetCDMaxUpdateFreq to limit the max dT future drift.\nOtherwise, the "
+                "simulation may have diverged and relaxing the physics may help, such as decreasing the step size "
+                "and modifying material properties.",
+                stateParams.avgCntsPerSphere, solverFlags.errOutAvgSphCnts);
+        }
+
+        // The order dT got the contacts in: sorted by type (stably), if they are shipped that way
+        std::vector<size_t> typeOrder(nContacts);
+        std::iota(typeOrder.begin(), typeOrder.end(), 0);
+        if (solverFlags.should_sort_pairs) {
+            std::stable_sort(typeOrder.begin(), typeOrder.end(), [&](size_t a, size_t b) {
+                return granData->contactType[a] < granData->contactType[b];
+            });
+        }
+
+        if (!solverFlags.isHistoryless) {
+            timers.Start(KT_PERSISTENT_CONTACT_MAP);
+            // Where each of the previous contacts (stored sorted by idA) went in the array shipped to dT
+            const size_t nPrev = *scratchPad.pNumPrevContacts;
+            std::vector<contactPairs_t> prevShippedPos(nPrev);
+            {
+                std::vector<size_t> prevOrder(nPrev);
+                std::iota(prevOrder.begin(), prevOrder.end(), 0);
+                if (solverFlags.should_sort_pairs) {
+                    std::stable_sort(prevOrder.begin(), prevOrder.end(), [&](size_t a, size_t b) {
+                        return granData->previous_contactType[a] < granData->previous_contactType[b];
+                    });
+                }
+                for (size_t n = 0; n < nPrev; n++)
+                    prevShippedPos[prevOrder[n]] = n;
+            }
+            // A contact persists if the previous contacts have one with the same idA, idB and type
+            if (nContacts > contactMapping.size()) {
+                hostCDArrayResize(scratchPad, "contactMapping", contactMapping, nContacts);
+                granData->contactMapping = contactMapping.data();
+            }
+            std::vector<contactPairs_t> mapping(nContacts);
+            hostParallelFor(workers, nContacts, nThreads, [&](size_t, size_t begin, size_t end) {
+                for (size_t n = begin; n < end; n++) {
+                    contactPairs_t partner = NULL_MAPPING_PARTNER;
+                    if (granData->contactType[n] != NOT_A_CONTACT) {
+                        const bodyID_t* prevA = granData->previous_idGeometryA;
+                        auto range = std::equal_range(prevA, prevA + nPrev, granData->idGeometryA[n]);
+                        for (auto it = range.first; it != range.second; it++) {
+                            size_t m = it - prevA;
+                            if (granData->previous_idGeometryB[m] == granData->idGeometryB[n] &&
+                                granData->previous_contactType[m] == granData->contactType[n]) {
+                                partner = prevShippedPos[m];
+                                break;
+                            }
+                        }
+                    }
+                    mapping[n] = partner;
+                }
+            });
+
+            // Record the contacts, sorted by idA, for the next time
+            if (nContacts > previous_idGeometryA.size()) {
+                hostCDArrayResize(scratchPad, "previous_idGeometryA", previous_idGeometryA, nContacts);
+                hostCDArrayResize(scratchPad, "previous_idGeometryB", previous_idGeometryB, nContacts);
+                hostCDArrayResize(scratchPad, "previous_contactType", previous_contactType, nContacts);
+                granData->previous_idGeometryA = previous_idGeometryA.data();
+                granData->previous_idGeometryB = previous_idGeometryB.data();
+                granData->previous_contactType = previous_contactType.data();
+            }
+            std::copy(granData->idGeometryA, granData->idGeometryA + nContacts, granData->previous_idGeometryA);
+            std::copy(granData->idGeometryB, granData->idGeometryB + nContacts, granData->previous_idGeometryB);
+            std::copy(granData->contactType, granData->contactType + nContacts, granData->previous_contactType);
+            for (size_t n = 0; n < nContacts; n++)
+                granData->contactMapping[n] = mapping[typeOrder[n]];
+            timers.Stop(KT_PERSISTENT_CONTACT_MAP);
+        }
+
+        // dT potentially benefits from type-sorted contact array
+        if (solverFlags.should_sort_pairs) {
+            timers.Start(KT_SORT_CONTACTS_BY_TYPE);
+            for (size_t n = 0; n < nContacts; n++) {
+                allIdA[n] = granData->idGeometryA[typeOrder[n]];
+                allIdB[n] = granData->idGeometryB[typeOrder[n]];
+                allType[n] = granData->contactType[typeOrder[n]];
+            }
+            std::copy(allIdA.begin(), allIdA.end(), granData->idGeometryA);
+            std::copy(allIdB.begin(), allIdB.end(), granData->idGeometryB);
+            std::copy(allType.begin(), allType.end(), granData->contactType);
+            timers.Stop(KT_SORT_CONTACTS_BY_TYPE);
+        }
+    }
+    timers.Stop(KT_BUILD_HISTORY_MAP);
+
+    *scratchPad.pNumPrevContacts = nContacts;
+    *scratchPad.pNumPrevSpheres = nSpheres;
+}
+
+}  // namespace deme
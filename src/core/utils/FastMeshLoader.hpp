@@ -0,0 +1,511 @@
+//  Copyright (c) 2021, SBEL GPU Development Team
+//  Copyright (c) 2021, University of Wisconsin - Madison
+//
+//	SPDX-License-Identifier: BSD-3-Clause
+
+#ifndef DEME_FAST_MESH_LOADER_HPP
+#define DEME_FAST_MESH_LOADER_HPP
+
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#if defined(_WIN32) || defined(_WIN64)
+    #include <fstream>
+#else
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+namespace deme {
+
+/// Read-only view of a whole file. It is memory-mapped where mmap is available; elsewhere the file is read into memory
+/// in one go.
+class MappedFile {
+  public:
+    explicit MappedFile(const std::string& filename) {
+#if defined(_WIN32) || defined(_WIN64)
+        std::ifstream file(filename, std::ios::binary | std::ios::ate);
+        if (!file.is_open())
+            return;
+        m_buffer.resize((size_t)file.tellg());
+        file.seekg(0);
+        if (!file.read(m_buffer.data(), m_buffer.size()))
+            return;
+        m_data = m_buffer.data();
+        m_size = m_buffer.size();
+        m_open = true;
+#else
+        m_fd = ::open(filename.c_str(), O_RDONLY);
+        if (m_fd < 0)
+            return;
+        struct stat st;
+        if (::fstat(m_fd, &st) != 0)
+            return;
+        m_size = (size_t)st.st_size;
+        m_open = true;
+        // An empty file cannot be mapped, but it is still a (valid) empty view
+        if (m_size == 0)
+            return;
+        void* addr = ::mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, m_fd, 0);
+        if (addr == MAP_FAILED) {
+            m_size = 0;
+            m_open = false;
+            return;
+        }
+        // We read it front to back (per chunk)
+        ::madvise(addr, m_size, MADV_SEQUENTIAL);
+        m_data = static_cast<const char*>(addr);
+#endif
+    }
+    ~MappedFile() {
+#if !(defined(_WIN32) || defined(_WIN64))
+        if (m_data)
+            ::munmap(const_cast<char*>(m_data), m_size);
+        if (m_fd >= 0)
+            ::close(m_fd);
+#endif
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool IsOpen() const { return m_open; }
+    const char* Data() const { return m_data; }
+    size_t Size() const { return m_size; }
+
+  private:
+    const char* m_data = nullptr;
+    size_t m_size = 0;
+    bool m_open = false;
+#if defined(_WIN32) || defined(_WIN64)
+    std::vector<char> m_buffer;
+#else
+    int m_fd = -1;
+#endif
+};
+
+/// What a mesh file loader produces. F3 and I3 are 3-vectors with x, y, z members (float3 and int3, typically). All
+/// indices are 0-based; a face corner without a UV reference has -1 there. If any face references normals, every face
+/// corner has one (the loader computes the normals the file leaves out).
+template <typename F3, typename I3>
+struct MeshFileData {
+    std::vector<F3> vertices;
+    std::vector<F3> normals;
+    // Only x and y are used; z is 0
+    std::vector<F3> UV;
+    std::vector<I3> faceVIndices;
+    std::vector<I3> faceNIndices;
+    std::vector<I3> faceUVIndices;
+    // Whether any face referenced a normal/UV; if not, faceNIndices/faceUVIndices are left empty
+    bool hasFaceNormals = false;
+    bool hasFaceUV = false;
+    // Why the load failed, if it did
+    std::string error;
+};
+
+namespace mesh_loader_detail {
+
+// Files smaller than this are not worth splitting for one more thread
+constexpr size_t MIN_CHUNK_BYTES = (size_t)1 << 20;
+
+inline bool isBlank(char c) {
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+inline const char* skipBlanks(const char* p, const char* end) {
+    while (p < end && isBlank(*p))
+        p++;
+    return p;
+}
+
+inline const char* lineEnd(const char* p, const char* end) {
+    const char* nl = static_cast<const char*>(std::memchr(p, '\n', end - p));
+    return nl ? nl : end;
+}
+
+// Read one float (from_chars does not take a leading `+'). Returns nullptr on failure.
+inline const char* parseFloat(const char* p, const char* end, float& val) {
+    p = skipBlanks(p, end);
+    if (p < end && *p == '+')
+        p++;
+    auto res = std::from_chars(p, end, val);
+    return (res.ec == std::errc()) ? res.ptr : nullptr;
+}
+
+inline const char* parseInt(const char* p, const char* end, long long& val) {
+    if (p < end && *p == '+')
+        p++;
+    auto res = std::from_chars(p, end, val);
+    return (res.ec == std::errc()) ? res.ptr : nullptr;
+}
+
+// The kinds of OBJ lines we care about
+enum class OBJ_LINE { OTHER, VERTEX, NORMAL, TEXEL, FACE };
+
+// Classify the line at p (leading blanks skipped), and set p past the keyword
+inline OBJ_LINE classifyObjLine(const char*& p, const char* end) {
+    p = skipBlanks(p, end);
+    if (p >= end)
+        return OBJ_LINE::OTHER;
+    auto keyword_is = [&](const char* kw, size_t len) {
+        return (size_t)(end - p) > len && std::memcmp(p, kw, len) == 0 && isBlank(p[len]);
+    };
+    if (*p == 'v') {
+        if (keyword_is("v", 1)) {
+            p += 1;
+            return OBJ_LINE::VERTEX;
+        } else if (keyword_is("vn", 2)) {
+            p += 2;
+            return OBJ_LINE::NORMAL;
+        } else if (keyword_is("vt", 2)) {
+            p += 2;
+            return OBJ_LINE::TEXEL;
+        }
+    } else if (*p == 'f' && keyword_is("f", 1)) {
+        p += 1;
+        return OBJ_LINE::FACE;
+    }
+    return OBJ_LINE::OTHER;
+}
+
+// Number of corner tokens in the rest of a face line
+inline size_t countFaceCorners(const char* p, const char* end) {
+    size_t n = 0;
+    while (true) {
+        p = skipBlanks(p, end);
+        if (p >= end || *p == '#')
+            return n;
+        n++;
+        while (p < end && !isBlank(*p))
+            p++;
+    }
+}
+
+// Per-chunk element counts (first pass), which turn into per-chunk write offsets
+struct ObjChunkCounts {
+    size_t nV = 0;
+    size_t nN = 0;
+    size_t nT = 0;
+    size_t nTri = 0;
+};
+
+inline void countObjChunk(const char* p, const char* end, ObjChunkCounts& counts) {
+    while (p < end) {
+        const char* eol = lineEnd(p, end);
+        const char* q = p;
+        switch (classifyObjLine(q, eol)) {
+            case OBJ_LINE::VERTEX:
+                counts.nV++;
+                break;
+            case OBJ_LINE::NORMAL:
+                counts.nN++;
+                break;
+            case OBJ_LINE::TEXEL:
+                counts.nT++;
+                break;
+            case OBJ_LINE::FACE: {
+                size_t corners = countFaceCorners(q, eol);
+                if (corners >= 3)
+                    counts.nTri += corners - 2;
+                break;
+            }
+            default:
+                break;
+        }
+        p = eol + 1;
+    }
+}
+
+// Turn an OBJ index (1-based, or negative meaning relative to the elements defined so far) into a 0-based one. Returns
+// false if it is 0 or out of range. Positive indices are checked against the whole file, as some exporters write faces
+// before the vertices they use.
+inline bool resolveObjIndex(long long idx, size_t n_defined, size_t n_total, int& res) {
+    if (idx > 0 && (size_t)idx <= n_total) {
+        res = (int)(idx - 1);
+        return true;
+    } else if (idx < 0 && (size_t)(-idx) <= n_defined) {
+        res = (int)((long long)n_defined + idx);
+        return true;
+    }
+    return false;
+}
+
+// Second pass: parse a chunk, writing into the output arrays from the offsets given in `base' (the element counts of
+// all previous chunks; `total' is the counts of the whole file). Returns an empty string on success, or a description
+// of the first problem.
+template <typename F3, typename I3>
+std::string parseObjChunk(const char* p,
+                          const char* end,
+                          ObjChunkCounts base,
+                          const ObjChunkCounts& total,
+                          MeshFileData<F3, I3>& out,
+                          bool& has_normals,
+                          bool& has_uv) {
+    struct Corner {
+        int v, t, n;
+    };
+    std::vector<Corner> corners;
+    while (p < end) {
+        const char* eol = lineEnd(p, end);
+        const char* q = p;
+        OBJ_LINE type = classifyObjLine(q, eol);
+        if (type == OBJ_LINE::VERTEX || type == OBJ_LINE::NORMAL) {
+            // Anything past x y z (such as vertex colors, or w) is ignored
+            F3 val{0, 0, 0};
+            if (!(q = parseFloat(q, eol, val.x)) || !(q = parseFloat(q, eol, val.y)) ||
+                !(q = parseFloat(q, eol, val.z)))
+                return "Malformed line: " + std::string(p, eol);
+            if (type == OBJ_LINE::VERTEX)
+                out.vertices[base.nV++] = val;
+            else
+                out.normals[base.nN++] = val;
+        } else if (type == OBJ_LINE::TEXEL) {
+            // Ignore 3rd component if present
+            F3 val{0, 0, 0};
+            if (!(q = parseFloat(q, eol, val.x)) || !(q = parseFloat(q, eol, val.y)))
+                return "Malformed line: " + std::string(p, eol);
+            out.UV[base.nT++] = val;
+        } else if (type == OBJ_LINE::FACE) {
+            corners.clear();
+            while (true) {
+                q = skipBlanks(q, eol);
+                if (q >= eol || *q == '#')
+                    break;
+                // Corner is v, v/t, v//n or v/t/n
+                Corner c{-1, -1, -1};
+                long long idx;
+                if (!(q = parseInt(q, eol, idx)) || !resolveObjIndex(idx, base.nV, total.nV, c.v))
+                    return "Bad vertex reference in line: " + std::string(p, eol);
+                if (q < eol && *q == '/') {
+                    q++;
+                    if (q < eol && *q != '/') {
+                        if (!(q = parseInt(q, eol, idx)) || !resolveObjIndex(idx, base.nT, total.nT, c.t))
+                            return "Bad texel reference in line: " + std::string(p, eol);
+                        has_uv = true;
+                    }
+                    if (q < eol && *q == '/') {
+                        q++;
+                        if (!(q = parseInt(q, eol, idx)) || !resolveObjIndex(idx, base.nN, total.nN, c.n))
+                            return "Bad normal reference in line: " + std::string(p, eol);
+                        has_normals = true;
+                    }
+                }
+                if (q < eol && !isBlank(*q))
+                    return "Malformed face in line: " + std::string(p, eol);
+                corners.push_back(c);
+            }
+            // Polygons are triangulated as a fan around the first corner
+            for (size_t i = 2; i < corners.size(); i++) {
+                const Corner& a = corners[0];
+                const Corner& b = corners[i - 1];
+                const Corner& c = corners[i];
+                out.faceVIndices[base.nTri] = I3{a.v, b.v, c.v};
+                out.faceNIndices[base.nTri] = I3{a.n, b.n, c.n};
+                out.faceUVIndices[base.nTri] = I3{a.t, b.t, c.t};
+                base.nTri++;
+            }
+        }
+        p = eol + 1;
+    }
+    return std::string();
+}
+
+// Give the face corners without a normal reference the face normal of their triangle (right-hand rule), appended to
+// the normal array. One face normal is added per triangle that needs it.
+template <typename F3, typename I3>
+void fillMissingNormals(MeshFileData<F3, I3>& data) {
+    for (size_t i = 0; i < data.faceNIndices.size(); i++) {
+        I3& n_ids = data.faceNIndices[i];
+        if (n_ids.x >= 0 && n_ids.y >= 0 && n_ids.z >= 0)
+            continue;
+        const I3& v_ids = data.faceVIndices[i];
+        const F3& a = data.vertices[v_ids.x];
+        const F3& b = data.vertices[v_ids.y];
+        const F3& c = data.vertices[v_ids.z];
+        const float e1[3] = {b.x - a.x, b.y - a.y, b.z - a.z};
+        const float e2[3] = {c.x - a.x, c.y - a.y, c.z - a.z};
+        F3 normal{e1[1] * e2[2] - e1[2] * e2[1], e1[2] * e2[0] - e1[0] * e2[2], e1[0] * e2[1] - e1[1] * e2[0]};
+        const float len = std::sqrt(normal.x * normal.x + normal.y * normal.y + normal.z * normal.z);
+        // A degenerate triangle keeps a zero normal
+        if (len > 0.f) {
+            normal.x /= len;
+            normal.y /= len;
+            normal.z /= len;
+        }
+        const int n_id = (int)data.normals.size();
+        data.normals.push_back(normal);
+        if (n_ids.x < 0)
+            n_ids.x = n_id;
+        if (n_ids.y < 0)
+            n_ids.y = n_id;
+        if (n_ids.z < 0)
+            n_ids.z = n_id;
+    }
+}
+
+}  // namespace mesh_loader_detail
+
+/// Load a Wavefront .obj file. The file is memory-mapped and split into line-aligned chunks that are parsed in
+/// parallel: a first pass counts the elements of each chunk, so that every chunk then writes straight into its slice
+/// of the (pre-sized) output arrays. Polygons are fan-triangulated; negative (relative) indices are supported. Only
+/// geometry (v, vn, vt, f) is read. If only some face corners reference normals, the others get their face normal.
+/// Returns false and sets data.error on failure.
+template <typename F3, typename I3>
+bool LoadObjFile(const std::string& filename, MeshFileData<F3, I3>& data, unsigned int num_threads = 0) {
+    using namespace mesh_loader_detail;
+    data = MeshFileData<F3, I3>();
+    MappedFile file(filename);
+    if (!file.IsOpen()) {
+        data.error = "Cannot open " + filename;
+        return false;
+    }
+    const char* begin = file.Data();
+    const char* end = begin + file.Size();
+
+    if (num_threads == 0)
+        num_threads = std::max(1u, std::thread::hardware_concurrency());
+    size_t n_chunks = std::min<size_t>(num_threads, file.Size() / MIN_CHUNK_BYTES + 1);
+    // Chunk boundaries are moved forward to the next line start
+    std::vector<const char*> bounds(n_chunks + 1, end);
+    bounds[0] = begin;
+    for (size_t i = 1; i < n_chunks; i++) {
+        const char* p = std::max(begin + file.Size() / n_chunks * i, bounds[i - 1]);
+        p = lineEnd(p, end);
+        bounds[i] = (p < end) ? p + 1 : end;
+    }
+
+    auto run_chunks = [&](auto&& work) {
+        if (n_chunks == 1) {
+            work(0);
+            return;
+        }
+        std::vector<std::thread> workers;
+        for (size_t i = 0; i < n_chunks; i++)
+            workers.emplace_back(work, i);
+        for (auto& w : workers)
+            w.join();
+    };
+
+    // First pass: count, then turn counts into offsets
+    std::vector<ObjChunkCounts> offsets(n_chunks + 1);
+    run_chunks([&](size_t i) { countObjChunk(bounds[i], bounds[i + 1], offsets[i + 1]); });
+    for (size_t i = 1; i <= n_chunks; i++) {
+        offsets[i].nV += offsets[i - 1].nV;
+        offsets[i].nN += offsets[i - 1].nN;
+        offsets[i].nT += offsets[i - 1].nT;
+        offsets[i].nTri += offsets[i - 1].nTri;
+    }
+    const ObjChunkCounts& total = offsets[n_chunks];
+    data.vertices.resize(total.nV);
+    data.normals.resize(total.nN);
+    data.UV.resize(total.nT);
+    data.faceVIndices.resize(total.nTri);
+    data.faceNIndices.resize(total.nTri);
+    data.faceUVIndices.resize(total.nTri);
+
+    // Second pass: parse
+    std::vector<std::string> errors(n_chunks);
+    std::vector<char> has_normals(n_chunks, 0), has_uv(n_chunks, 0);
+    run_chunks([&](size_t i) {
+        bool n_flag = false, uv_flag = false;
+        errors[i] = parseObjChunk(bounds[i], bounds[i + 1], offsets[i], total, data, n_flag, uv_flag);
+        has_normals[i] = n_flag;
+        has_uv[i] = uv_flag;
+    });
+    for (const auto& err : errors) {
+        if (!err.empty()) {
+            data.error = err;
+            return false;
+        }
+    }
+    data.hasFaceNormals = std::any_of(has_normals.begin(), has_normals.end(), [](char f) { return f != 0; });
+    data.hasFaceUV = std::any_of(has_uv.begin(), has_uv.end(), [](char f) { return f != 0; });
+    if (data.hasFaceNormals)
+        fillMissingNormals(data);
+    else
+        data.faceNIndices.clear();
+    if (!data.hasFaceUV)
+        data.faceUVIndices.clear();
+    return true;
+}
+
+/// Load a binary STL file. STL stores each facet with its own copy of the vertices, so vertices with identical
+/// coordinates are merged here to recover the connectivity. Facet normals are stored as one normal per face. Bytes
+/// past the last facet (some exporters pad the file) are ignored.
+template <typename F3, typename I3>
+bool LoadBinaryStlFile(const std::string& filename, MeshFileData<F3, I3>& data) {
+    data = MeshFileData<F3, I3>();
+    MappedFile file(filename);
+    if (!file.IsOpen()) {
+        data.error = "Cannot open " + filename;
+        return false;
+    }
+    constexpr size_t HEADER_BYTES = 80 + sizeof(uint32_t);
+    constexpr size_t FACET_BYTES = 12 * sizeof(float) + sizeof(uint16_t);
+    uint32_t n_facets = 0;
+    if (file.Size() >= HEADER_BYTES)
+        std::memcpy(&n_facets, file.Data() + 80, sizeof(uint32_t));
+    if (file.Size() < HEADER_BYTES || file.Size() < HEADER_BYTES + (size_t)n_facets * FACET_BYTES) {
+        data.error = filename + " is not a binary STL file (ASCII STL is not supported)";
+        return false;
+    }
+
+    // Identical coordinates map to the same vertex; +0 and -0 are the same coordinate
+    struct Key {
+        uint32_t bits[3];
+        bool operator==(const Key& other) const { return std::memcmp(bits, other.bits, sizeof(bits)) == 0; }
+    };
+    struct KeyHash {
+        size_t operator()(const Key& k) const {
+            uint64_t h = k.bits[0];
+            h = h * 0x9E3779B97F4A7C15ull ^ k.bits[1];
+            h = h * 0x9E3779B97F4A7C15ull ^ k.bits[2];
+            return (size_t)(h ^ (h >> 29));
+        }
+    };
+    std::unordered_map<Key, int, KeyHash> vertex_ids;
+    vertex_ids.reserve(n_facets);
+    data.vertices.reserve(n_facets);
+    data.normals.resize(n_facets);
+    data.faceVIndices.resize(n_facets);
+    data.faceNIndices.resize(n_facets);
+
+    const char* p = file.Data() + HEADER_BYTES;
+    for (uint32_t i = 0; i < n_facets; i++, p += FACET_BYTES) {
+        float vals[12];
+        std::memcpy(vals, p, sizeof(vals));
+        data.normals[i] = F3{vals[0], vals[1], vals[2]};
+        int ids[3];
+        for (int j = 0; j < 3; j++) {
+            F3 v{vals[3 + 3 * j] + 0.f, vals[4 + 3 * j] + 0.f, vals[5 + 3 * j] + 0.f};
+            Key key;
+            std::memcpy(&key.bits[0], &v.x, sizeof(float));
+            std::memcpy(&key.bits[1], &v.y, sizeof(float));
+            std::memcpy(&key.bits[2], &v.z, sizeof(float));
+            auto it = vertex_ids.emplace(key, (int)data.vertices.size());
+            if (it.second)
+                data.vertices.push_back(v);
+            ids[j] = it.first->second;
+        }
+        data.faceVIndices[i] = I3{ids[0], ids[1], ids[2]};
+        data.faceNIndices[i] = I3{(int)i, (int)i, (int)i};
+    }
+    data.hasFaceNormals = n_facets > 0;
+    if (!data.hasFaceNormals)
+        data.faceNIndices.clear();
+    return true;
+}
+
+}  // namespace deme
+
+#endif
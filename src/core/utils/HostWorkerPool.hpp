@@ -0,0 +1,139 @@
+//  Copyright (c) 2021, SBEL GPU Development Team
+//  Copyright (c) 2021, University of Wisconsin - Madison
+//
+//	SPDX-License-Identifier: BSD-3-Clause
+
+#ifndef DEME_HOST_WORKER_POOL_HPP
+#define DEME_HOST_WORKER_POOL_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace deme {
+
+/// A fixed set of host threads that stay alive between parallel loops, so a loop does not pay for creating and joining
+/// threads. The thread that calls Run works on the tasks too, so a pool of N threads has N - 1 workers. Run is meant to
+/// be called from one thread at a time (the pool's owner).
+class HostWorkerPool {
+  public:
+    HostWorkerPool() = default;
+    ~HostWorkerPool() { stopWorkers(); }
+
+    HostWorkerPool(const HostWorkerPool&) = delete;
+    HostWorkerPool& operator=(const HostWorkerPool&) = delete;
+
+    /// Have nThreads threads in all, counting the calling thread. The workers are only re-created if the number
+    /// changes.
+    void SetNumThreads(unsigned int nThreads) {
+        const size_t nWorkers = (nThreads > 1) ? nThreads - 1 : 0;
+        if (nWorkers == m_workers.size())
+            return;
+        stopWorkers();
+        // The workers are told the current generation, rather than reading it when they start: one that starts after
+        // the next Run began would take that Run for an old one, and never finish it
+        for (size_t i = 0; i < nWorkers; i++)
+            m_workers.emplace_back(&HostWorkerPool::workerLoop, this, m_generation);
+    }
+
+    unsigned int GetNumThreads() const { return (unsigned int)m_workers.size() + 1; }
+
+    /// Run fn(i) for every i in [0, nTasks), spread over the workers and the calling thread, and return when all are
+    /// done. Which thread runs which task is up to timing, so fn(i) should only write to what task i owns. The first
+    /// exception thrown by a task is re-thrown here.
+    template <typename Func>
+    void Run(size_t nTasks, Func&& fn) {
+        if (nTasks == 0)
+            return;
+        if (m_workers.empty() || nTasks == 1) {
+            for (size_t i = 0; i < nTasks; i++)
+                fn(i);
+            return;
+        }
+        std::function<void(size_t)> task = [&fn](size_t i) { fn(i); };
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_task = &task;
+            m_nTasks = nTasks;
+            m_nextTask = 0;
+            m_nBusy = m_workers.size();
+            m_error = nullptr;
+            m_generation++;
+        }
+        m_cvStart.notify_all();
+        work();
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_cvDone.wait(lock, [this]() { return m_nBusy == 0; });
+        m_task = nullptr;
+        if (m_error)
+            std::rethrow_exception(m_error);
+    }
+
+  private:
+    std::vector<std::thread> m_workers;
+    std::mutex m_mutex;
+    std::condition_variable m_cvStart;
+    std::condition_variable m_cvDone;
+    // The loop being run, and how far it got
+    const std::function<void(size_t)>* m_task = nullptr;
+    size_t m_nTasks = 0;
+    std::atomic<size_t> m_nextTask{0};
+    // Workers that have not finished the current loop yet
+    size_t m_nBusy = 0;
+    // Bumped at each Run, so the workers know there is a new loop
+    size_t m_generation = 0;
+    bool m_stop = false;
+    std::exception_ptr m_error;
+
+    // Take tasks until there is none left
+    void work() {
+        while (true) {
+            const size_t i = m_nextTask.fetch_add(1);
+            if (i >= m_nTasks)
+                return;
+            try {
+                (*m_task)(i);
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                if (!m_error)
+                    m_error = std::current_exception();
+            }
+        }
+    }
+
+    void workerLoop(size_t seen) {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        while (true) {
+            m_cvStart.wait(lock, [&]() { return m_stop || m_generation != seen; });
+            if (m_stop)
+                return;
+            seen = m_generation;
+            lock.unlock();
+            work();
+            lock.lock();
+            if (--m_nBusy == 0)
+                m_cvDone.notify_one();
+        }
+    }
+
+    void stopWorkers() {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stop = true;
+        }
+        m_cvStart.notify_all();
+        for (auto& w : m_workers)
+            w.join();
+        m_workers.clear();
+        m_stop = false;
+    }
+};
+
+}  // namespace deme
+
+#endif
@@ -7,9 +7,13 @@
 #define CUDALLOC_HPP
 
 #include <core/ApiVersion.h>
+#include <core/utils/MemoryPool.hpp>
+#include <core/utils/GpuError.h>
 
 #include <cuda_runtime_api.h>
 #include <climits>
+#include <mutex>
+#include <vector>
 #include <iostream>
 #include <memory>
 #include <new>
@@ -18,6 +22,92 @@
 
 namespace deme {
 
+// Pool backend for unified memory
+class CudaManagedBackend {
+  public:
+    void* Allocate(size_t bytes) {
+        void* vptr = nullptr;
+        cudaError_t err = cudaMallocManaged(&vptr, bytes, cudaMemAttachGlobal);
+        if (err == cudaErrorMemoryAllocation || err == cudaErrorNotSupported) {
+            // Clear the error state so that the retry after trimming starts clean
+            cudaGetLastError();
+            throw std::bad_alloc();
+        }
+        // Any other error is not something trimming the pool can fix
+        DEME_GPU_CALL(err);
+        return vptr;
+    }
+    void Free(void* ptr) { cudaFree(ptr); }
+};
+
+// Pool backend for plain device memory on a given device
+class CudaDeviceBackend {
+  public:
+    explicit CudaDeviceBackend(int device = 0) : m_device(device) {}
+    void* Allocate(size_t bytes) {
+        int prev_device;
+        cudaGetDevice(&prev_device);
+        cudaSetDevice(m_device);
+        void* vptr = nullptr;
+        cudaError_t err = cudaMalloc(&vptr, bytes);
+        cudaSetDevice(prev_device);
+        if (err == cudaErrorMemoryAllocation) {
+            cudaGetLastError();
+            throw std::bad_alloc();
+        }
+        DEME_GPU_CALL(err);
+        return vptr;
+    }
+    void Free(void* ptr) {
+        int prev_device;
+        cudaGetDevice(&prev_device);
+        cudaSetDevice(m_device);
+        cudaFree(ptr);
+        cudaSetDevice(prev_device);
+    }
+
+  private:
+    int m_device;
+};
+
+// The process-wide pools. They are intentionally never destroyed, so that containers that are destructed during static
+// tear-down can still hand their blocks back.
+inline MemoryPool<CudaManagedBackend>& ManagedMemoryPool() {
+    static MemoryPool<CudaManagedBackend>* pool = new MemoryPool<CudaManagedBackend>();
+    return *pool;
+}
+
+inline MemoryPool<CudaDeviceBackend>& DeviceMemoryPool(int device) {
+    static std::mutex pools_mutex;
+    static std::vector<MemoryPool<CudaDeviceBackend>*> pools;
+    std::lock_guard<std::mutex> lock(pools_mutex);
+    if (device >= (int)pools.size())
+        pools.resize(device + 1, nullptr);
+    if (!pools[device])
+        pools[device] = new MemoryPool<CudaDeviceBackend>(CudaDeviceBackend(device));
+    return *pools[device];
+}
+
+inline MemoryPool<CudaDeviceBackend>& DeviceMemoryPool() {
+    int device = 0;
+    cudaGetDevice(&device);
+    return DeviceMemoryPool(device);
+}
+
+// Hand a device block back to the pool of the device it lives on. Returns false if that pool does not own it.
+inline bool DeviceMemoryPoolsRelease(void* ptr) {
+    cudaPointerAttributes attrib;
+    if (cudaPointerGetAttributes(&attrib, ptr) != cudaSuccess) {
+        cudaGetLastError();
+        return false;
+    }
+    if (attrib.type != cudaMemoryType::cudaMemoryTypeDevice)
+        return false;
+    return DeviceMemoryPool(attrib.device).Deallocate(ptr);
+}
+
+// Managed memory used by DEME containers is served by ManagedMemoryPool, so resizing them back and forth does not go to
+// cudaMallocManaged/cudaFree every time.
 template <class T>
 struct ManagedAllocator {
   public:
@@ -94,9 +184,9 @@ struct ManagedAllocator {
     // #endif
 
 #if CXX_OLDER(STD_CXX20)
-    void deallocate(T* p, std::size_t n) { cudaFree(p); }
+    void deallocate(T* p, std::size_t n) { this->__dealloc_impl(p); }
 #else  // CXX_EQ_NEWER(STD_CXX20)
-    constexpr void deallocate(T* p, std::size_t n) { cudaFree(p); }
+    constexpr void deallocate(T* p, std::size_t n) { this->__dealloc_impl(p); }
 #endif
 
 #if CXX_OLDER(STD_CXX20)
@@ -118,13 +208,12 @@ struct ManagedAllocator {
 #endif
 
   private:
-    constexpr T* __alloc_impl(std::size_t n) {
-        void* vptr = nullptr;
-        cudaError_t err = cudaMallocManaged(&vptr, n * sizeof(T), cudaMemAttachGlobal);
-        if (err == cudaErrorMemoryAllocation || err == cudaErrorNotSupported) {
-            throw std::bad_alloc();
+    constexpr T* __alloc_impl(std::size_t n) { return (T*)ManagedMemoryPool().Allocate(n * sizeof(T)); }
+
+    constexpr void __dealloc_impl(T* p) {
+        if (!ManagedMemoryPool().Deallocate(p)) {
+            cudaFree(p);
         }
-        return (T*)vptr;
     }
 };
 
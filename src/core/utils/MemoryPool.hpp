@@ -0,0 +1,222 @@
+//  Copyright (c) 2021, SBEL GPU Development Team
+//  Copyright (c) 2021, University of Wisconsin - Madison
+//
+//	SPDX-License-Identifier: BSD-3-Clause
+
+#ifndef DEME_MEMORY_POOL_HPP
+#define DEME_MEMORY_POOL_HPP
+
+#include <cstddef>
+#include <cstdlib>
+#include <iterator>
+#include <map>
+#include <mutex>
+#include <new>
+#include <unordered_map>
+#include <vector>
+
+namespace deme {
+
+/// Counters describing the state of a MemoryPool. All byte counts are in size-class-rounded bytes.
+struct MemoryPoolStats {
+    // Bytes currently handed out to users
+    size_t bytesInUse = 0;
+    // Bytes held in the free lists, ready for reuse
+    size_t bytesCached = 0;
+    // High-water mark of bytesInUse
+    size_t peakBytesInUse = 0;
+    // High-water mark of bytesInUse + bytesCached, i.e. what the backend actually had to give us
+    size_t peakBytesReserved = 0;
+    // Number of allocation requests, and how many of them were served from the free lists
+    size_t numRequests = 0;
+    size_t numCacheHits = 0;
+    // Number of times the pool had to go to the backend
+    size_t numBackendAllocs = 0;
+    size_t numBackendFrees = 0;
+
+    size_t bytesReserved() const { return bytesInUse + bytesCached; }
+};
+
+/// Backend that takes memory from the host heap. It is what the pool policy is exercised with when no device is
+/// around, and it is a valid backend for host-side scratch buffers, too.
+class HostMemoryBackend {
+  public:
+    void* Allocate(size_t bytes) {
+        void* ptr = std::malloc(bytes);
+        if (!ptr) {
+            throw std::bad_alloc();
+        }
+        return ptr;
+    }
+    void Free(void* ptr) { std::free(ptr); }
+};
+
+/// A caching allocator that serves blocks by size class. Freed blocks are kept in per-class free lists and handed out
+/// again on the next request of that class, so a container that shrinks and grows back (contact arrays, temp arrays,
+/// CUB scratch...) does not hit the backend (and for CUDA backends, does not cause a device-wide sync) again.
+/// The pool retains cached blocks up to the high-water mark of its in-use bytes (times a retention factor); anything
+/// above that is released back to the backend right away. Trim() can be used to release cached blocks explicitly.
+/// Backend needs to provide void* Allocate(size_t) (throwing std::bad_alloc on failure) and void Free(void*).
+template <class Backend>
+class MemoryPool {
+  public:
+    // Smallest block the pool hands out. Also the alignment granularity of size classes.
+    static constexpr size_t MIN_BLOCK_BYTES = 256;
+    // Each power-of-two interval is split into 2^SUB_CLASS_BITS classes, so the rounding waste is at most 25%
+    static constexpr unsigned int SUB_CLASS_BITS = 2;
+    // A cached block of a larger class can serve a request if it is no larger than this multiple of the request class
+    static constexpr size_t MAX_REUSE_OVERSIZE = 2;
+
+    explicit MemoryPool(Backend backend = Backend(), double retain_factor = 1.0)
+        : m_backend(backend), m_retainFactor(retain_factor) {}
+    ~MemoryPool() { Trim(0); }
+
+    MemoryPool(const MemoryPool&) = delete;
+    MemoryPool& operator=(const MemoryPool&) = delete;
+
+    /// Round a byte count up to the size class that will serve it.
+    static size_t SizeClassOf(size_t bytes) {
+        if (bytes <= MIN_BLOCK_BYTES)
+            return MIN_BLOCK_BYTES;
+        // Position of the highest set bit
+        unsigned int msb = 0;
+        for (size_t b = bytes - 1; b > 1; b >>= 1)
+            msb++;
+        // Step between two neighboring classes in this power-of-two interval
+        size_t step = ((size_t)1 << msb) >> SUB_CLASS_BITS;
+        if (step < MIN_BLOCK_BYTES)
+            step = MIN_BLOCK_BYTES;
+        return (bytes + step - 1) / step * step;
+    }
+
+    /// Get a block of at least `bytes' bytes.
+    void* Allocate(size_t bytes) {
+        const size_t cls = SizeClassOf(bytes);
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stats.numRequests++;
+
+        void* ptr = nullptr;
+        size_t blk_size = cls;
+        // Best fit among the cached blocks, as long as it is not too wasteful
+        auto it = m_freeBlocks.lower_bound(cls);
+        if (it != m_freeBlocks.end() && it->first <= cls * MAX_REUSE_OVERSIZE) {
+            blk_size = it->first;
+            ptr = it->second.back();
+            it->second.pop_back();
+            if (it->second.empty())
+                m_freeBlocks.erase(it);
+            m_stats.bytesCached -= blk_size;
+            m_stats.numCacheHits++;
+        } else {
+            try {
+                ptr = m_backend.Allocate(cls);
+            } catch (const std::bad_alloc&) {
+                // Backend is out of memory: give everything cached back, then try one more time
+                releaseCached_impl(0);
+                ptr = m_backend.Allocate(cls);
+            }
+            m_stats.numBackendAllocs++;
+        }
+
+        m_liveBlocks[ptr] = blk_size;
+        m_stats.bytesInUse += blk_size;
+        if (m_stats.bytesInUse > m_stats.peakBytesInUse)
+            m_stats.peakBytesInUse = m_stats.bytesInUse;
+        if (m_stats.bytesReserved() > m_stats.peakBytesReserved)
+            m_stats.peakBytesReserved = m_stats.bytesReserved();
+        return ptr;
+    }
+
+    /// Return a block to the pool. Returns false (and does nothing) if this block was not allocated by this pool.
+    bool Deallocate(void* ptr) {
+        if (!ptr)
+            return true;
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = m_liveBlocks.find(ptr);
+        if (it == m_liveBlocks.end())
+            return false;
+        const size_t blk_size = it->second;
+        m_liveBlocks.erase(it);
+        m_stats.bytesInUse -= blk_size;
+        m_freeBlocks[blk_size].push_back(ptr);
+        m_stats.bytesCached += blk_size;
+        enforceRetention_impl();
+        return true;
+    }
+
+    /// Whether this block is currently handed out by this pool.
+    bool Owns(void* ptr) const {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_liveBlocks.find(ptr) != m_liveBlocks.end();
+    }
+
+    /// The usable size of a block handed out by this pool (0 if not owned by this pool).
+    size_t BlockSize(void* ptr) const {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = m_liveBlocks.find(ptr);
+        return (it == m_liveBlocks.end()) ? 0 : it->second;
+    }
+
+    /// Release cached blocks back to the backend, until at most `keep_bytes' bytes remain cached. Returns the number
+    /// of bytes released.
+    size_t Trim(size_t keep_bytes = 0) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return releaseCached_impl(keep_bytes);
+    }
+
+    /// Cached bytes are capped at retain_factor * (high-water mark of in-use bytes) - (in-use bytes).
+    void SetRetainFactor(double retain_factor) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_retainFactor = retain_factor;
+        enforceRetention_impl();
+    }
+
+    /// Forget the high-water marks, so that they are measured from now on. Useful after a known transient.
+    void ResetPeak() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stats.peakBytesInUse = m_stats.bytesInUse;
+        m_stats.peakBytesReserved = m_stats.bytesReserved();
+        enforceRetention_impl();
+    }
+
+    MemoryPoolStats GetStats() const {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_stats;
+    }
+
+  private:
+    Backend m_backend;
+    double m_retainFactor;
+    MemoryPoolStats m_stats;
+    // Size class -> cached blocks of that class
+    std::map<size_t, std::vector<void*>> m_freeBlocks;
+    // Block -> its size class
+    std::unordered_map<void*, size_t> m_liveBlocks;
+    mutable std::mutex m_mutex;
+
+    // Free the largest cached blocks first, until at most keep_bytes are cached. Caller holds the lock.
+    size_t releaseCached_impl(size_t keep_bytes) {
+        size_t released = 0;
+        while (m_stats.bytesCached > keep_bytes && !m_freeBlocks.empty()) {
+            auto it = std::prev(m_freeBlocks.end());
+            m_backend.Free(it->second.back());
+            it->second.pop_back();
+            m_stats.bytesCached -= it->first;
+            m_stats.numBackendFrees++;
+            released += it->first;
+            if (it->second.empty())
+                m_freeBlocks.erase(it);
+        }
+        return released;
+    }
+
+    void enforceRetention_impl() {
+        size_t cap = (size_t)(m_retainFactor * (double)m_stats.peakBytesInUse);
+        size_t keep = (cap > m_stats.bytesInUse) ? cap - m_stats.bytesInUse : 0;
+        releaseCached_impl(keep);
+    }
+};
+
+}  // namespace deme
+
+#endif
@@ -0,0 +1,217 @@
+//  Copyright (c) 2021, SBEL GPU Development Team
+//  Copyright (c) 2021, University of Wisconsin - Madison
+//
+//	SPDX-License-Identifier: BSD-3-Clause
+
+#ifndef DEME_METRICS_SINK_HPP
+#define DEME_METRICS_SINK_HPP
+
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace deme {
+
+/// One field of a MetricsSink record: its name (also its CSV column name), its type (f32, f64, i32, i64, u32 or u64)
+/// and where it sits in the record.
+struct MetricsField {
+    std::string name;
+    std::string type;
+    uint32_t offset;
+    uint32_t size;
+};
+
+template <typename T>
+inline MetricsField MakeMetricsField(const std::string& name, size_t offset) {
+    static_assert(std::is_arithmetic<T>::value, "MetricsSink record fields must be of arithmetic types");
+    const std::string kind = std::is_floating_point<T>::value ? "f" : (std::is_signed<T>::value ? "i" : "u");
+    return MetricsField{name, kind + std::to_string(8 * sizeof(T)), (uint32_t)offset, (uint32_t)sizeof(T)};
+}
+
+/// A time series of fixed-layout records. The producer pushes records in its hot loop at the cost of a lock and a copy;
+/// the latest records are kept in a ring buffer for in-process queries, and, if a file is attached, a background
+/// thread appends them to it so the producer never waits on disk I/O.
+/// Record needs to be trivially copyable and provide
+///     static std::vector<MetricsField> GetFields() (its fields, in CSV column order), and
+///     void WriteCsvRow(std::ostream&) const (the comma-separated values, no line break).
+/// A binary file is the 8-byte tag DEMETS02, then uint32 sizeof(Record), uint32 length of the layout line, the layout
+/// line (comma-separated name:type:offset of each field, e.g. time:f64:0), and then the records, sizeof(Record) bytes
+/// each. Records are written field by field, so any padding between fields is zero.
+template <class Record>
+class MetricsSink {
+    static_assert(std::is_trivially_copyable<Record>::value, "MetricsSink records must be trivially copyable");
+
+  public:
+    static constexpr size_t DEFAULT_CAPACITY = 4096;
+
+    MetricsSink() = default;
+    ~MetricsSink() { Close(); }
+
+    MetricsSink(const MetricsSink&) = delete;
+    MetricsSink& operator=(const MetricsSink&) = delete;
+
+    /// Keep (at most) the latest `capacity' records in memory. Records in memory are discarded.
+    void SetCapacity(size_t capacity) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_ring.assign(capacity > 0 ? capacity : 1, Record());
+        m_numPushed = 0;
+    }
+
+    /// Start streaming records to this file (overwritten). A file that is already attached is closed first. Returns
+    /// false if the file cannot be opened.
+    bool Open(const std::string& filename, bool binary) {
+        Close();
+        m_file.open(filename, binary ? (std::ios::out | std::ios::binary | std::ios::trunc) : std::ios::out);
+        if (!m_file.is_open())
+            return false;
+        m_fields = Record::GetFields();
+        std::ostringstream header;
+        for (size_t i = 0; i < m_fields.size(); i++) {
+            header << (i > 0 ? "," : "") << m_fields[i].name;
+            if (binary)
+                header << ":" << m_fields[i].type << ":" << m_fields[i].offset;
+        }
+        if (binary) {
+            const std::string layout = header.str();
+            const uint32_t rec_size = sizeof(Record), layout_len = layout.size();
+            m_file.write("DEMETS02", 8);
+            m_file.write(reinterpret_cast<const char*>(&rec_size), sizeof(rec_size));
+            m_file.write(reinterpret_cast<const char*>(&layout_len), sizeof(layout_len));
+            m_file.write(layout.data(), layout_len);
+        } else {
+            m_file << header.str() << "\n";
+        }
+        m_binary = binary;
+        m_stopWriter = false;
+        m_writer = std::thread(&MetricsSink::writerLoop, this);
+        return true;
+    }
+
+    /// Finish writing whatever is queued, then detach the file.
+    void Close() {
+        if (!m_writer.joinable())
+            return;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stopWriter = true;
+        }
+        m_cvQueued.notify_one();
+        m_writer.join();
+        m_file.close();
+    }
+
+    bool IsStreaming() const { return m_writer.joinable(); }
+
+    /// Add one record. Called by the producer thread.
+    void Push(const Record& rec) {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (m_ring.empty())
+                m_ring.assign(DEFAULT_CAPACITY, Record());
+            m_ring[m_numPushed % m_ring.size()] = rec;
+            m_numPushed++;
+            if (!m_writer.joinable())
+                return;
+            m_queue.push_back(rec);
+        }
+        m_cvQueued.notify_one();
+    }
+
+    /// Block until every record pushed so far is handed to the file.
+    void Flush() {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        while (m_writer.joinable() && !(m_queue.empty() && !m_writing)) {
+            m_cvDrained.wait(lock);
+        }
+    }
+
+    /// The latest `n' records that are still in memory (all of them, if n is 0), oldest first.
+    std::vector<Record> GetRecent(size_t n = 0) const {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        std::vector<Record> res;
+        size_t avail = (m_numPushed < m_ring.size()) ? m_numPushed : m_ring.size();
+        if (n > 0 && n < avail)
+            avail = n;
+        res.reserve(avail);
+        for (size_t i = m_numPushed - avail; i < m_numPushed; i++)
+            res.push_back(m_ring[i % m_ring.size()]);
+        return res;
+    }
+
+    /// Total number of records pushed since the last SetCapacity or Clear.
+    size_t GetNumPushed() const {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_numPushed;
+    }
+
+    /// Forget the records in memory (the file, if any, is not affected).
+    void Clear() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_numPushed = 0;
+    }
+
+  private:
+    mutable std::mutex m_mutex;
+    std::vector<Record> m_ring;
+    size_t m_numPushed = 0;
+
+    // Records waiting for the writer thread
+    std::vector<Record> m_queue;
+    std::condition_variable m_cvQueued;
+    std::condition_variable m_cvDrained;
+    bool m_writing = false;
+    bool m_stopWriter = false;
+    std::thread m_writer;
+    std::ofstream m_file;
+    bool m_binary = false;
+    std::vector<MetricsField> m_fields;
+
+    void writerLoop() {
+        std::vector<Record> batch;
+        std::vector<char> bytes;
+        std::unique_lock<std::mutex> lock(m_mutex);
+        while (true) {
+            while (m_queue.empty() && !m_stopWriter) {
+                m_cvQueued.wait(lock);
+            }
+            if (m_queue.empty() && m_stopWriter)
+                break;
+            // Take the whole queue, and write it without holding the lock
+            batch.swap(m_queue);
+            m_writing = true;
+            lock.unlock();
+            if (m_binary) {
+                // Copy the fields over a zeroed buffer, so no uninitialized padding byte ends up in the file
+                bytes.assign(batch.size() * sizeof(Record), 0);
+                for (size_t i = 0; i < batch.size(); i++) {
+                    const char* src = reinterpret_cast<const char*>(&batch[i]);
+                    for (const auto& field : m_fields)
+                        std::memcpy(bytes.data() + i * sizeof(Record) + field.offset, src + field.offset, field.size);
+                }
+                m_file.write(bytes.data(), bytes.size());
+            } else {
+                for (const auto& rec : batch) {
+                    rec.WriteCsvRow(m_file);
+                    m_file << "\n";
+                }
+            }
+            m_file.flush();
+            batch.clear();
+            lock.lock();
+            m_writing = false;
+            m_cvDrained.notify_all();
+        }
+        m_cvDrained.notify_all();
+    }
+};
+
+}  // namespace deme
+
+#endif
@@ -0,0 +1,137 @@
+//  Copyright (c) 2021, SBEL GPU Development Team
+//  Copyright (c) 2021, University of Wisconsin - Madison
+//
+//	SPDX-License-Identifier: BSD-3-Clause
+
+#ifndef DEME_PROFILER_HPP
+#define DEME_PROFILER_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <ios>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace deme {
+
+/// One closed scope recorded by a Profiler: which scope it was, when it began and how long it lasted. Times are in
+/// nanoseconds since Profiler::Epoch(), which all profilers share, so events of different threads line up.
+struct ProfileEvent {
+    unsigned int id;
+    int64_t beginNs;
+    int64_t durationNs;
+};
+
+/// A low-overhead scope recorder for one worker thread. Scopes are pre-registered by name and then referred to by
+/// their integer ID. Closed scopes go into a fixed-size ring buffer (the oldest events are overwritten when it is
+/// full). When disabled, Begin/End cost one branch. Only the owning thread may call Begin/End; the getters should be
+/// called when the owning thread is idle (e.g. after a DoDynamicsThenSync call).
+class Profiler {
+  public:
+    static constexpr size_t DEFAULT_CAPACITY = 1 << 16;
+
+    Profiler(const std::string& thread_name, const std::vector<std::string>& scope_names)
+        : m_threadName(thread_name), m_scopeNames(scope_names), m_openBegins(scope_names.size(), 0) {}
+
+    /// The time point that all profilers measure from.
+    static std::chrono::steady_clock::time_point Epoch() {
+        static const std::chrono::steady_clock::time_point epoch = std::chrono::steady_clock::now();
+        return epoch;
+    }
+    static int64_t NowNs() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - Epoch())
+            .count();
+    }
+
+    /// Start recording, keeping (at most) the latest `capacity' events. Previously recorded events are discarded.
+    void Enable(size_t capacity = DEFAULT_CAPACITY) {
+        Epoch();
+        m_events.assign(capacity > 0 ? capacity : 1, ProfileEvent{0, 0, 0});
+        m_numWritten = 0;
+        m_enabled.store(true, std::memory_order_relaxed);
+    }
+    /// Stop recording. Recorded events are kept until the next Enable or Clear.
+    void Disable() { m_enabled.store(false, std::memory_order_relaxed); }
+    bool IsEnabled() const { return m_enabled.load(std::memory_order_relaxed); }
+
+    inline void Begin(unsigned int id) {
+        if (!m_enabled.load(std::memory_order_relaxed))
+            return;
+        m_openBegins[id] = NowNs();
+    }
+    inline void End(unsigned int id) {
+        if (!m_enabled.load(std::memory_order_relaxed))
+            return;
+        const int64_t now = NowNs();
+        m_events[m_numWritten % m_events.size()] = ProfileEvent{id, m_openBegins[id], now - m_openBegins[id]};
+        m_numWritten++;
+    }
+
+    /// Forget the recorded events (the recording state is not changed).
+    void Clear() { m_numWritten = 0; }
+
+    /// The recorded events that are still in the ring buffer, oldest first.
+    std::vector<ProfileEvent> GetEvents() const {
+        std::vector<ProfileEvent> res;
+        if (m_events.empty())
+            return res;
+        const size_t n = (m_numWritten < m_events.size()) ? m_numWritten : m_events.size();
+        res.reserve(n);
+        for (size_t i = m_numWritten - n; i < m_numWritten; i++)
+            res.push_back(m_events[i % m_events.size()]);
+        return res;
+    }
+    /// Number of events that were overwritten because the ring buffer was full.
+    size_t GetNumDropped() const { return (m_numWritten > m_events.size()) ? m_numWritten - m_events.size() : 0; }
+
+    const std::string& GetThreadName() const { return m_threadName; }
+    const std::vector<std::string>& GetScopeNames() const { return m_scopeNames; }
+
+    /// Write the events of these profilers as a Chrome trace (JSON object format), which can be opened in
+    /// chrome://tracing or ui.perfetto.dev. Each profiler shows up as one thread of one process.
+    static void WriteChromeTrace(std::ostream& out, const std::vector<const Profiler*>& profilers) {
+        const std::ios_base::fmtflags old_flags = out.flags();
+        const std::streamsize old_precision = out.precision();
+        // Chrome trace timestamps are in microseconds; keep ns resolution
+        out << std::fixed;
+        out.precision(3);
+        out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+        bool first = true;
+        auto sep = [&]() {
+            if (!first)
+                out << ",\n";
+            first = false;
+        };
+        for (size_t tid = 0; tid < profilers.size(); tid++) {
+            const Profiler* prof = profilers[tid];
+            sep();
+            out << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":" << tid << ",\"args\":{\"name\":\""
+                << prof->m_threadName << "\"}}";
+            for (const auto& ev : prof->GetEvents()) {
+                sep();
+                out << "{\"name\":\"" << prof->m_scopeNames.at(ev.id) << "\",\"cat\":\"" << prof->m_threadName
+                    << "\",\"ph\":\"X\",\"pid\":0,\"tid\":" << tid << ",\"ts\":" << (double)ev.beginNs * 1e-3
+                    << ",\"dur\":" << (double)ev.durationNs * 1e-3 << "}";
+            }
+        }
+        out << "\n]}\n";
+        out.flags(old_flags);
+        out.precision(old_precision);
+    }
+
+  private:
+    const std::string m_threadName;
+    const std::vector<std::string> m_scopeNames;
+    std::atomic<bool> m_enabled{false};
+    // Begin time of the currently open scope of each ID
+    std::vector<int64_t> m_openBegins;
+    // The ring buffer, and how many events were ever written to it
+    std::vector<ProfileEvent> m_events;
+    size_t m_numWritten = 0;
+};
+
+}  // namespace deme
+
+#endif
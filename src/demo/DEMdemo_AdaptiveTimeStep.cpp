@@ -0,0 +1,128 @@
+//  Copyright (c) 2021, SBEL GPU Development Team
+//  Copyright (c) 2021, University of Wisconsin - Madison
+//
+//	SPDX-License-Identifier: BSD-3-Clause
+
+// =============================================================================
+// A demo of adaptive time stepping. First, the step size controller is driven
+// on the host through an impact followed by settling, and checked: the step
+// shrinks right away, grows by a bounded factor, stays within its bounds, and
+// the step size kT makes contact margins with covers the steps dT takes. Then
+// a batch of spheres is dropped into a box with adaptive time stepping, and
+// the step size is reported as the spheres hit the floor and settle.
+// =============================================================================
+
+#include <core/ApiVersion.h>
+#include <core/utils/ThreadManager.h>
+#include <DEM/API.h>
+#include <DEM/HostSideHelpers.hpp>
+#include <DEM/utils/Samplers.hpp>
+
+#include "DemoChecks.hpp"
+
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+#include <vector>
+
+using namespace deme;
+
+void checkController(DemoChecks& checks) {
+    TimeStepController controller;
+    controller.strat = VAR_TS_STRAT::MAX_VEL;
+    controller.minRadius = 0.005;
+    controller.maxTravelRatio = 0.01;
+    controller.maxGrowth = 1.1;
+    controller.minStep = 1e-7;
+    controller.maxStep = 1e-4;
+    controller.Reset(1e-5);
+
+    // Max velocity at each kT update: free fall, impact, then settling
+    std::vector<double> max_vel;
+    for (int i = 0; i < 20; i++)
+        max_vel.push_back(0.5 + 0.1 * i);
+    for (int i = 0; i < 5; i++)
+        max_vel.push_back(50.);
+    for (int i = 0; i < 100; i++)
+        max_vel.push_back(2.5 * std::pow(0.9, i));
+
+    std::vector<double> steps, margin_steps;
+    for (double v : max_vel) {
+        double h = controller.Update(v, 0.);
+        steps.push_back(h);
+        margin_steps.push_back(controller.GetStepForMargin());
+        checks.Check(h >= controller.minStep && h <= controller.maxStep, "Step size within bounds");
+        checks.Check(h * v <= controller.maxTravelRatio * controller.minRadius * (1. + 1e-9) || h == controller.minStep,
+                     "Travel per step within the limit");
+    }
+    for (size_t i = 1; i < steps.size(); i++) {
+        checks.Check(steps[i] <= steps[i - 1] * controller.maxGrowth * (1. + 1e-9),
+                     "Step size grows by a bounded factor");
+        // The contact list made at update i-1 is used until update i+1: the steps in between are steps[i-1], steps[i]
+        checks.Check(margin_steps[i - 1] >= steps[i - 1] && margin_steps[i - 1] >= steps[i],
+                     "Contact margin covers the steps taken with the contact list");
+    }
+    // The step shrinks at the first update of the impact, rather than one update late
+    checks.Check(steps[20] <= controller.maxTravelRatio * controller.minRadius / 50. * (1. + 1e-9),
+                 "Step size shrinks right away");
+    checks.Check(steps.back() > 10. * steps[24], "Step size grows back as the system settles");
+    printf("Step size: %g before impact, %g at impact, %g after settling\n", steps[19], steps[20], steps.back());
+
+    // An overlap deeper than the target shrinks the step in proportion
+    controller.strat = VAR_TS_STRAT::INT_GAP;
+    controller.maxOverlapRatio = 0.01;
+    controller.Reset(1e-5);
+    double h = controller.Update(0.1, 0.05);
+    checks.Check(std::abs(h - 2e-6) < 1e-12, "Deep overlap shrinks the step size");
+
+    // The Rayleigh time step scales with the radius
+    double rayleigh_1 = TimeStepController::RayleighTimeStep(0.001, 2500., 7e10, 0.22);
+    double rayleigh_2 = TimeStepController::RayleighTimeStep(0.002, 2500., 7e10, 0.22);
+    checks.Check(rayleigh_1 > 0. && std::abs(rayleigh_2 / rayleigh_1 - 2.) < 1e-9, "Rayleigh time step");
+    printf("Rayleigh time step of a 1 mm glass sphere: %g\n", rayleigh_1);
+}
+
+int main() {
+    DemoChecks checks;
+    checkController(checks);
+
+    DEMSolver DEMSim;
+    DEMSim.SetVerbosity(INFO);
+    DEMSim.SetOutputFormat(OUTPUT_FORMAT::CSV);
+    DEMSim.SetOutputContent({"ABSV"});
+
+    auto mat_type = DEMSim.LoadMaterial({{"E", 1e8}, {"nu", 0.3}, {"CoR", 0.5}, {"mu", 0.4}, {"Crr", 0.01}});
+
+    float world_size = 0.2;
+    DEMSim.InstructBoxDomainDimension(world_size, world_size, world_size);
+    DEMSim.InstructBoxDomainBoundingBC("all", mat_type);
+
+    float radius = 0.005;
+    float mass = 2.6e3 * 4. / 3. * PI * radius * radius * radius;
+    auto sph_type = DEMSim.LoadSphereType(mass, radius, mat_type);
+    HCPSampler sampler(2.2 * radius);
+    auto input_xyz = sampler.SampleBox(make_float3(0, 0, world_size / 4.),
+                                       make_float3(world_size / 2. - 2 * radius, world_size / 2. - 2 * radius,
+                                                   world_size / 4. - 2 * radius));
+    DEMSim.AddClumps(sph_type, input_xyz);
+    std::cout << "Total num of particles: " << input_xyz.size() << std::endl;
+
+    DEMSim.SetInitTimeStep(1e-5);
+    DEMSim.SetAdaptiveTimeStepType("max_vel");
+    DEMSim.SetAdaptiveTimeStepLimits(1e-7, 1e-4);
+    DEMSim.SetAdaptiveTimeStepCriteria(0.01);
+    DEMSim.SetGravitationalAcceleration(make_float3(0, 0, -9.81));
+    DEMSim.SetMaxVelocity(10.);
+    DEMSim.Initialize();
+
+    float frame_time = 0.05;
+    auto max_v_finder = DEMSim.CreateInspector("clump_max_absv");
+    for (int i = 0; i < 40; i++) {
+        DEMSim.DoDynamics(frame_time);
+        printf("Time %.3f, max velocity %.4g, step size %.4g\n", DEMSim.GetSimTime(), max_v_finder->GetValue(),
+               DEMSim.GetTimeStepSize());
+    }
+    DEMSim.ShowTimingStats();
+
+    return checks.Finish("AdaptiveTimeStep");
+}
@@ -0,0 +1,241 @@
+//  Copyright (c) 2021, SBEL GPU Development Team
+//  Copyright (c) 2021, University of Wisconsin - Madison
+//
+//	SPDX-License-Identifier: BSD-3-Clause
+
+// =============================================================================
+// A check of the logic behind SetCDVerletSkin, using the host versions of the
+// expiry test and the sphere--sphere refilter that kT runs. Clumps move and
+// spin about at random, their margins change, and one of them changes family.
+// At each step, the contact candidates found with the skin are either reused
+// and refiltered, or found again if some owner drifted too far; either way, the
+// contacts obtained must be exactly the ones a brute-force search finds.
+// =============================================================================
+
+#include <DEM/API.h>
+#include <DEM/HostSideHelpers.hpp>
+
+#include "DemoChecks.hpp"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <utility>
+#include <vector>
+
+using namespace deme;
+
+struct Owner {
+    double3 pos;
+    float4 oriQ;
+    double3 vel;
+    float3 angVel;
+    float margin;
+    family_t family;
+};
+
+struct Sphere {
+    unsigned int owner;
+    float3 relPos;
+    float radius;
+};
+
+// Sphere pairs, by sphere ID
+using PairList = std::vector<std::pair<unsigned int, unsigned int>>;
+
+// The owner states recorded when the contact candidates are found
+struct OwnerRecord {
+    double3 pos;
+    float4 oriQ;
+    float margin;
+    family_t family;
+    float extent;
+};
+
+double3 spherePos(const Owner& owner, const Sphere& sph) {
+    float3 rel = sph.relPos;
+    hostApplyOriQToVector3<float, float>(rel.x, rel.y, rel.z, owner.oriQ.w, owner.oriQ.x, owner.oriQ.y, owner.oriQ.z);
+    return make_double3(owner.pos.x + rel.x, owner.pos.y + rel.y, owner.pos.z + rel.z);
+}
+
+// Brute-force search of the sphere pairs in contact, with each owner's margin (plus the extra amount) added to its
+// spheres' radii
+PairList findContacts(const std::vector<Owner>& owners,
+                      const std::vector<Sphere>& spheres,
+                      const std::vector<float>& familyExtraMargin,
+                      float extra) {
+    PairList pairs;
+    std::vector<double3> pos(spheres.size());
+    for (size_t i = 0; i < spheres.size(); i++)
+        pos[i] = spherePos(owners[spheres[i].owner], spheres[i]);
+    for (unsigned int i = 0; i < spheres.size(); i++) {
+        const Owner& ownerA = owners[spheres[i].owner];
+        for (unsigned int j = i + 1; j < spheres.size(); j++) {
+            if (spheres[i].owner == spheres[j].owner)
+                continue;
+            const Owner& ownerB = owners[spheres[j].owner];
+            if (hostIsSphSphInContact<double>(pos[i].x, pos[i].y, pos[i].z, spheres[i].radius + ownerA.margin + extra,
+                                              pos[j].x, pos[j].y, pos[j].z, spheres[j].radius + ownerB.margin + extra,
+                                              familyExtraMargin[ownerA.family], familyExtraMargin[ownerB.family])) {
+                pairs.emplace_back(i, j);
+            }
+        }
+    }
+    return pairs;
+}
+
+// Keep those candidates that are contacts now, which is what kT does when it reuses them
+PairList refilter(const PairList& cand,
+                  const std::vector<Owner>& owners,
+                  const std::vector<Sphere>& spheres,
+                  const std::vector<float>& familyExtraMargin) {
+    PairList pairs;
+    for (const auto& c : cand) {
+        const Sphere& A = spheres[c.first];
+        const Sphere& B = spheres[c.second];
+        const Owner& ownerA = owners[A.owner];
+        const Owner& ownerB = owners[B.owner];
+        double3 pA = spherePos(ownerA, A);
+        double3 pB = spherePos(ownerB, B);
+        if (hostIsSphSphInContact<double>(pA.x, pA.y, pA.z, A.radius + ownerA.margin, pB.x, pB.y, pB.z,
+                                          B.radius + ownerB.margin, familyExtraMargin[ownerA.family],
+                                          familyExtraMargin[ownerB.family])) {
+            pairs.push_back(c);
+        }
+    }
+    return pairs;
+}
+
+int main() {
+    const unsigned int num_owners = 1500;
+    const float box = 1.5;
+    const float skin = 0.02;
+    const unsigned int num_steps = 200;
+    const double dt = 2e-4;
+    std::vector<float> familyExtraMargin = {0.f, 0.002f};
+
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<float> uni(0.f, 1.f);
+    auto rand_unit = [&]() { return normalize(host_make_float3(uni(rng) - 0.5f, uni(rng) - 0.5f, uni(rng) - 0.5f)); };
+
+    // Clumps of 1 to 3 spheres, at random places and orientations, moving and spinning at random
+    std::vector<Owner> owners(num_owners);
+    std::vector<Sphere> spheres;
+    std::vector<float> extents(num_owners, 0.f);
+    for (unsigned int i = 0; i < num_owners; i++) {
+        Owner& o = owners[i];
+        o.pos = make_double3(box * uni(rng), box * uni(rng), box * uni(rng));
+        o.oriQ = QuatFromAxisAngle(rand_unit(), 2. * PI * uni(rng));
+        float3 v = rand_unit() * (5.f * uni(rng));
+        o.vel = make_double3(v.x, v.y, v.z);
+        o.angVel = rand_unit() * (40.f * uni(rng));
+        o.margin = 0.002f + 0.003f * uni(rng);
+        o.family = (uni(rng) < 0.5f) ? 0 : 1;
+        unsigned int n = 1 + (unsigned int)(3 * uni(rng)) % 3;
+        for (unsigned int k = 0; k < n; k++) {
+            Sphere s;
+            s.owner = i;
+            s.radius = 0.02f + 0.02f * uni(rng);
+            s.relPos = (n == 1) ? host_make_float3(0, 0, 0) : rand_unit() * (0.02f * uni(rng));
+            extents[i] = std::max(extents[i], length(s.relPos) + s.radius);
+            spheres.push_back(s);
+        }
+    }
+    printf("%u clumps, %zu spheres, skin %g\n", num_owners, spheres.size(), skin);
+
+    std::vector<OwnerRecord> records(num_owners);
+    PairList candidates;
+    DemoChecks checks;
+    unsigned int num_rebuilds = 0, num_reuses = 0;
+    size_t total_contacts = 0, total_candidates = 0;
+    double brute_time = 0., refilter_time = 0.;
+    bool need_rebuild = true;
+    for (unsigned int step = 0; step < num_steps; step++) {
+        // Advance the clumps, and have the margins wobble
+        for (auto& o : owners) {
+            o.pos.x += o.vel.x * dt;
+            o.pos.y += o.vel.y * dt;
+            o.pos.z += o.vel.z * dt;
+            float omega = length(o.angVel);
+            if (omega > 0.f) {
+                o.oriQ = hostHamiltonProduct(QuatFromAxisAngle(o.angVel / omega, omega * dt), o.oriQ);
+                o.oriQ = o.oriQ / length(o.oriQ);
+            }
+            o.margin = hostClampBetween(o.margin + 0.0004f * (uni(rng) - 0.5f), 0.001f, 0.006f);
+        }
+        // At some point, a clump changes family, and that should always call for finding the candidates again
+        bool family_changed = false;
+        if (step == num_steps / 2) {
+            owners[7].family = 1 - owners[7].family;
+            family_changed = true;
+        }
+
+        // The expiry test kT runs for each owner
+        if (!need_rebuild) {
+            for (unsigned int i = 0; i < num_owners; i++) {
+                const Owner& o = owners[i];
+                const OwnerRecord& r = records[i];
+                double drift = hostOwnerDriftBound<double, float>(
+                    o.pos.x - r.pos.x, o.pos.y - r.pos.y, o.pos.z - r.pos.z, o.oriQ.w, o.oriQ.x, o.oriQ.y, o.oriQ.z,
+                    r.oriQ.w, r.oriQ.x, r.oriQ.y, r.oriQ.z, r.extent);
+                if (hostIsContactCandidateExpired<double>(drift, o.margin, r.margin, o.family, r.family, skin)) {
+                    need_rebuild = true;
+                    break;
+                }
+            }
+        }
+        checks.Check(!family_changed || need_rebuild,
+                     "  step %u: a family change did not expire the contact candidates", step);
+
+        auto start = std::chrono::high_resolution_clock::now();
+        if (need_rebuild) {
+            for (unsigned int i = 0; i < num_owners; i++) {
+                records[i] = {owners[i].pos, owners[i].oriQ, owners[i].margin, owners[i].family, extents[i]};
+            }
+            candidates = findContacts(owners, spheres, familyExtraMargin, skin / 2.f);
+            need_rebuild = false;
+            num_rebuilds++;
+        } else {
+            num_reuses++;
+        }
+        auto contacts = refilter(candidates, owners, spheres, familyExtraMargin);
+        refilter_time += std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+
+        start = std::chrono::high_resolution_clock::now();
+        auto reference = findContacts(owners, spheres, familyExtraMargin, 0.f);
+        brute_time += std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+
+        total_contacts += reference.size();
+        total_candidates += candidates.size();
+        checks.Check(contacts == reference, "  step %u: %zu contacts from the candidates, %zu from brute force", step,
+                     contacts.size(), reference.size());
+
+        // The drift bound must bound how far each sphere really moved
+        for (const auto& s : spheres) {
+            const OwnerRecord& r = records[s.owner];
+            const Owner& o = owners[s.owner];
+            Owner then = o;
+            then.pos = r.pos;
+            then.oriQ = r.oriQ;
+            double3 p0 = spherePos(then, s), p1 = spherePos(o, s);
+            double moved = std::sqrt((p1.x - p0.x) * (p1.x - p0.x) + (p1.y - p0.y) * (p1.y - p0.y) +
+                                     (p1.z - p0.z) * (p1.z - p0.z));
+            double bound = hostOwnerDriftBound<double, float>(o.pos.x - r.pos.x, o.pos.y - r.pos.y, o.pos.z - r.pos.z,
+                                                              o.oriQ.w, o.oriQ.x, o.oriQ.y, o.oriQ.z, r.oriQ.w,
+                                                              r.oriQ.x, r.oriQ.y, r.oriQ.z, r.extent);
+            if (!checks.Check(moved <= bound + 1e-6, "  step %u: a sphere moved %g, more than the drift bound %g", step,
+                              moved, bound)) {
+                break;
+            }
+        }
+    }
+
+    printf("%u steps: %u found the candidates, %u reused them\n", num_steps, num_rebuilds, num_reuses);
+    printf("On average %.1f contacts, out of %.1f candidates\n", (double)total_contacts / num_steps,
+           (double)total_candidates / num_steps);
+    printf("Brute force at each step: %.3f s; with the candidates: %.3f s\n", brute_time, refilter_time);
+    checks.Check(num_reuses > 0, "The candidates were never reused");
+
+    return checks.Finish("CDVerletSkin");
+}
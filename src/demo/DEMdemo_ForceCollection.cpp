@@ -0,0 +1,128 @@
+//  Copyright (c) 2021, SBEL GPU Development Team
+//  Copyright (c) 2021, University of Wisconsin - Madison
+//
+//	SPDX-License-Identifier: BSD-3-Clause
+
+// =============================================================================
+// A benchmark of the force collection strategies. A bed of spheres (or of
+// 3-sphere clumps, toggled by the first command line argument) is settled in a
+// box, then the time spent collecting contact forces to owners is measured with
+// atomic operations per contact, with CUB reduce-by-key, and with the
+// owner-blocked (shared memory) kernel, and the accelerations they give are
+// compared.
+// =============================================================================
+
+#include <core/ApiVersion.h>
+#include <core/utils/ThreadManager.h>
+#include <DEM/API.h>
+#include <DEM/HostSideHelpers.hpp>
+#include <DEM/utils/Samplers.hpp>
+
+#include "DemoChecks.hpp"
+
+#include <cmath>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+using namespace deme;
+
+enum class COLLECT_STRAT { ATOMIC, CUB, OWNER_BLOCKED };
+
+// Settle a bed, then return the time spent collecting contact forces per step; the owners' accelerations at the end go
+// to acc
+double runBenchmark(COLLECT_STRAT strat, bool use_clumps, unsigned int num_steps, std::vector<float3>& acc) {
+    DEMSolver DEMSim;
+    DEMSim.SetVerbosity("ERROR");
+    DEMSim.SetOutputFormat(OUTPUT_FORMAT::CSV);
+
+    auto mat_type = DEMSim.LoadMaterial({{"E", 1e8}, {"nu", 0.3}, {"CoR", 0.5}, {"mu", 0.4}, {"Crr", 0.01}});
+
+    float world_size = 0.3;
+    DEMSim.InstructBoxDomainDimension(world_size, world_size, world_size);
+    DEMSim.InstructBoxDomainBoundingBC("all", mat_type);
+
+    float radius = 0.004;
+    float mass = 2.6e3 * 4. / 3. * PI * radius * radius * radius;
+    std::shared_ptr<DEMClumpTemplate> particle_type;
+    if (use_clumps) {
+        std::vector<float> radii = {radius, radius, radius};
+        std::vector<float3> rel_pos = {make_float3(-radius, 0, 0), make_float3(radius, 0, 0),
+                                       make_float3(0, radius, 0)};
+        particle_type =
+            DEMSim.LoadClumpType(3 * mass, make_float3(3 * mass * radius * radius), radii, rel_pos, mat_type);
+    } else {
+        particle_type = DEMSim.LoadSphereType(mass, radius, mat_type);
+    }
+    HCPSampler sampler((use_clumps ? 4.2 : 2.01) * radius);
+    auto input_xyz = sampler.SampleBox(make_float3(0, 0, -world_size / 4.),
+                                       make_float3(world_size / 2. - 3 * radius, world_size / 2. - 3 * radius,
+                                                   world_size / 4. - 3 * radius));
+    DEMSim.AddClumps(particle_type, input_xyz);
+
+    DEMSim.UseCubForceCollection(strat == COLLECT_STRAT::CUB);
+    DEMSim.UseCompactForceKernel(strat == COLLECT_STRAT::OWNER_BLOCKED);
+    DEMSim.SetInitTimeStep(2e-6);
+    DEMSim.SetGravitationalAcceleration(make_float3(0, 0, -9.81));
+    DEMSim.SetMaxVelocity(5.);
+    DEMSim.Initialize();
+
+    // Settle, so the contacts are mostly the steady ones
+    DEMSim.DoDynamicsThenSync(0.1);
+    size_t num_contacts = DEMSim.GetNumContacts();
+    DEMSim.ClearTimingStats();
+    DEMSim.DoDynamicsThenSync(num_steps * 2e-6);
+
+    std::vector<std::string> names;
+    std::vector<double> vals;
+    DEMSim.GetTimingStats(names, vals);
+    double collect_time = 0.;
+    for (size_t i = 0; i < names.size(); i++) {
+        if (names[i] == "Collect contact forces") {
+            collect_time = vals[i];
+        }
+    }
+    acc.clear();
+    for (bodyID_t i = 0; i < input_xyz.size(); i++) {
+        acc.push_back(DEMSim.GetOwnerAcc(i));
+    }
+    printf("%zu %s, %zu contacts: %.4g contacts collected per second\n", input_xyz.size(),
+           use_clumps ? "clumps" : "spheres", num_contacts,
+           (collect_time > 0.) ? (double)num_contacts * num_steps / collect_time : 0.);
+    return collect_time / num_steps;
+}
+
+int main(int argc, char* argv[]) {
+    // Use 3-sphere clumps, rather than spheres, if the first argument is `clump'
+    bool use_clumps = (argc > 1 && std::string(argv[1]) == "clump");
+    const unsigned int num_steps = 5000;
+    DemoChecks checks;
+
+    const std::vector<std::pair<COLLECT_STRAT, std::string>> strats = {{COLLECT_STRAT::ATOMIC, "Atomic per contact"},
+                                                                       {COLLECT_STRAT::CUB, "CUB reduce-by-key"},
+                                                                       {COLLECT_STRAT::OWNER_BLOCKED, "Owner-blocked"}};
+    std::vector<float3> ref_acc;
+    for (const auto& strat : strats) {
+        std::vector<float3> acc;
+        printf("%s: ", strat.second.c_str());
+        double t = runBenchmark(strat.first, use_clumps, num_steps, acc);
+        printf("%s: %.4g seconds per step\n", strat.second.c_str(), t);
+        if (strat.first == COLLECT_STRAT::ATOMIC) {
+            ref_acc = acc;
+            continue;
+        }
+        // The runs differ in the order floating-point sums are made in, so only a loose agreement is expected after the
+        // settling; still, a strategy that misses or doubles contacts is far off
+        double max_diff = 0., max_acc = 0.;
+        for (size_t i = 0; i < acc.size() && i < ref_acc.size(); i++) {
+            max_diff = std::max(max_diff, (double)length(acc[i] - ref_acc[i]));
+            max_acc = std::max(max_acc, (double)length(ref_acc[i]));
+        }
+        printf("%s: largest difference in acceleration from atomic collection %g (largest acceleration %g)\n",
+               strat.second.c_str(), max_diff, max_acc);
+        checks.Check(acc.size() == ref_acc.size() && max_diff <= 0.5 * max_acc,
+                     "%s does not agree with atomic collection", strat.second.c_str());
+    }
+
+    return checks.Finish("ForceCollection");
+}
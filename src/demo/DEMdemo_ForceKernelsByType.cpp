@@ -0,0 +1,92 @@
+//  Copyright (c) 2021, SBEL GPU Development Team
+//  Copyright (c) 2021, University of Wisconsin - Madison
+//
+//	SPDX-License-Identifier: BSD-3-Clause
+
+// =============================================================================
+// A benchmark of the contact type-specialized force kernels. Spheres are settled
+// in a box, either as a deep pile (mostly sphere--sphere contacts) or as a thin
+// layer (many sphere--plane contacts), then the force calculation is timed with
+// the generic force kernel and with the type-specialized ones, and the number of
+// contacts processed per second is reported for each type mix.
+// =============================================================================
+
+#include <core/ApiVersion.h>
+#include <core/utils/ThreadManager.h>
+#include <DEM/API.h>
+#include <DEM/HostSideHelpers.hpp>
+#include <DEM/utils/Samplers.hpp>
+
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace deme;
+
+// Settle a bed of spheres num_layers deep, then return the contacts processed per second in the force calculation
+double runBenchmark(unsigned int num_layers, bool type_specialized, unsigned int num_steps) {
+    DEMSolver DEMSim;
+    DEMSim.SetVerbosity("ERROR");
+    DEMSim.SetOutputFormat(OUTPUT_FORMAT::CSV);
+
+    auto mat_type = DEMSim.LoadMaterial({{"E", 1e8}, {"nu", 0.3}, {"CoR", 0.5}, {"mu", 0.4}, {"Crr", 0.01}});
+
+    float world_size = 0.4;
+    DEMSim.InstructBoxDomainDimension(world_size, world_size, world_size);
+    DEMSim.InstructBoxDomainBoundingBC("all", mat_type);
+
+    float radius = 0.004;
+    float mass = 2.6e3 * 4. / 3. * PI * radius * radius * radius;
+    auto sph_type = DEMSim.LoadSphereType(mass, radius, mat_type);
+    HCPSampler sampler(2.01 * radius);
+    float layer_height = num_layers * 2. * radius;
+    auto input_xyz = sampler.SampleBox(
+        make_float3(0, 0, -world_size / 2. + layer_height / 2. + radius),
+        make_float3(world_size / 2. - 2 * radius, world_size / 2. - 2 * radius, layer_height / 2.));
+    DEMSim.AddClumps(sph_type, input_xyz);
+
+    DEMSim.UseContactTypeSpecializedForceKernels(type_specialized);
+    DEMSim.SetInitTimeStep(2e-6);
+    DEMSim.SetGravitationalAcceleration(make_float3(0, 0, -9.81));
+    DEMSim.SetMaxVelocity(5.);
+    DEMSim.Initialize();
+
+    // Settle, so the contacts are mostly the steady ones
+    DEMSim.DoDynamicsThenSync(0.1);
+
+    size_t num_contacts = DEMSim.GetNumContacts();
+    size_t num_sph_sph = DEMSim.GetClumpContacts().size();
+    DEMSim.ClearTimingStats();
+    DEMSim.DoDynamicsThenSync(num_steps * 2e-6);
+
+    std::vector<std::string> names;
+    std::vector<double> vals;
+    DEMSim.GetTimingStats(names, vals);
+    double force_time = 0.;
+    for (size_t i = 0; i < names.size(); i++) {
+        if (names[i] == "Calculate contact forces") {
+            force_time = vals[i];
+        }
+    }
+    double cnt_per_sec = (force_time > 0.) ? (double)num_contacts * num_steps / force_time : 0.;
+    printf("%u layer(s), %zu spheres, %zu contacts (%.1f%% sphere--sphere), %s kernels: %.4g contacts/sec\n",
+           num_layers, input_xyz.size(), num_contacts,
+           (num_contacts > 0) ? 100. * num_sph_sph / num_contacts : 0., type_specialized ? "specialized" : "generic",
+           cnt_per_sec);
+    return cnt_per_sec;
+}
+
+int main() {
+    const unsigned int num_steps = 5000;
+    for (unsigned int num_layers : {1, 20}) {
+        double generic = runBenchmark(num_layers, false, num_steps);
+        double specialized = runBenchmark(num_layers, true, num_steps);
+        if (generic > 0.) {
+            printf("%u layer(s): type-specialized kernels are %.3fx as fast\n", num_layers, specialized / generic);
+        }
+    }
+
+    std::cout << "ForceKernelsByType demo exiting..." << std::endl;
+    return 0;
+}
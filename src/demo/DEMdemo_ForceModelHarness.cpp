@@ -0,0 +1,98 @@
+//  Copyright (c) 2021, SBEL GPU Development Team
+//  Copyright (c) 2021, University of Wisconsin - Madison
+//
+//	SPDX-License-Identifier: BSD-3-Clause
+
+// =============================================================================
+// A demo of the force model harness. The on-shelf frictionless Hertzian model is
+// compiled for the host, driven over a batch of synthetic contacts, and checked
+// against a hand-written reference implementation; then the number of contacts
+// per second the frictionless and the full Hertzian models process on one host
+// thread is reported.
+// =============================================================================
+
+#include <DEM/API.h>
+#include <DEM/HostSideHelpers.hpp>
+#include <DEM/ForceModelHarness.h>
+
+#include "DemoChecks.hpp"
+
+#include <cmath>
+#include <cstdio>
+
+using namespace deme;
+
+// The frictionless Hertzian model, in double precision
+void frictionlessHertzian(const HostContactBatch& batch,
+                          size_t i,
+                          float3& force,
+                          float3& torque_only_force,
+                          double E,
+                          double nu,
+                          double CoR) {
+    const size_t A = 2 * i, B = 2 * i + 1;
+    const double E_eff = E / (2. * (1. - nu * nu));
+    const double R_eff = (double)batch.radius[A] * batch.radius[B] / ((double)batch.radius[A] + batch.radius[B]);
+    const double m_eff = (double)batch.mass[A] * batch.mass[B] / ((double)batch.mass[A] + batch.mass[B]);
+    const double overlap = batch.overlap[i];
+    const double Sn = 2. * E_eff * std::sqrt(R_eff * overlap);
+    const double loge = std::log(CoR);
+    const double beta = loge / std::sqrt(loge * loge + PI * PI);
+    const double k_n = 2. / 3. * Sn;
+    const double gamma_n = 2. * std::sqrt(5. / 6.) * beta * std::sqrt(Sn * m_eff);
+    // Velocity of the contact point, as a point of a body; the angular velocity is in the body's local frame
+    auto contactPointVel = [&](size_t body) {
+        const double3 r = make_double3(batch.contactPnt[i].x - batch.pos[body].x,
+                                       batch.contactPnt[i].y - batch.pos[body].y,
+                                       batch.contactPnt[i].z - batch.pos[body].z);
+        float3 w = host_make_float3(batch.omgBarX[body], batch.omgBarY[body], batch.omgBarZ[body]);
+        hostApplyOriQToVector3<float, oriQ_t>(w.x, w.y, w.z, batch.oriQw[body], batch.oriQx[body], batch.oriQy[body],
+                                              batch.oriQz[body]);
+        return make_double3(batch.vX[body] + w.y * r.z - w.z * r.y, batch.vY[body] + w.z * r.x - w.x * r.z,
+                            batch.vZ[body] + w.x * r.y - w.y * r.x);
+    };
+    const double3 vA = contactPointVel(A), vB = contactPointVel(B);
+    const float3 n = batch.normal[i];
+    const double projection = (vA.x - vB.x) * n.x + (vA.y - vB.y) * n.y + (vA.z - vB.z) * n.z;
+    const double f_n = k_n * overlap + gamma_n * projection;
+    force = host_make_float3(f_n * n.x, f_n * n.y, f_n * n.z);
+    torque_only_force = host_make_float3(0, 0, 0);
+}
+
+int main() {
+    const size_t num_contacts = 500000;
+    DemoChecks checks;
+
+    {
+        auto model = std::make_shared<DEMForceModel>(FORCE_MODEL::HERTZIAN_FRICTIONLESS);
+        DEMForceModelHarness harness(model);
+        harness.LoadMaterial({{"E", 1e9}, {"nu", 0.3}, {"CoR", 0.6}});
+        harness.Compile();
+
+        HostContactBatch batch = harness.MakeSyntheticBatch(num_contacts, SyntheticContactRanges(), 1);
+        double err = harness.CompareWith(batch, [](const HostContactBatch& b, size_t i, float3& f, float3& t) {
+            frictionlessHertzian(b, i, f, t, 1e9, 0.3, 0.6);
+        });
+        printf("Frictionless Hertzian: largest relative difference from the reference %g\n", err);
+        checks.Check(err <= 1e-3, "The force model does not agree with the reference");
+        harness.Benchmark(batch, 10);
+    }
+
+    {
+        auto model = std::make_shared<DEMForceModel>(FORCE_MODEL::HERTZIAN);
+        DEMForceModelHarness harness(model);
+        auto mat_1 = harness.LoadMaterial({{"E", 1e9}, {"nu", 0.3}, {"CoR", 0.6}, {"mu", 0.5}, {"Crr", 0.01}});
+        auto mat_2 = harness.LoadMaterial({{"E", 2e9}, {"nu", 0.3}, {"CoR", 0.4}, {"mu", 0.3}, {"Crr", 0.01}});
+        harness.SetMaterialPropertyPair("mu", mat_1, mat_2, 0.7);
+        harness.SetTimeStepSize(1e-5);
+        harness.Compile();
+
+        SyntheticContactRanges ranges;
+        ranges.planeFraction = 0.2;
+        HostContactBatch batch = harness.MakeSyntheticBatch(num_contacts, ranges, 2);
+        printf("Full Hertzian, with 20%% sphere--plane contacts:\n");
+        harness.Benchmark(batch, 10);
+    }
+
+    return checks.Finish("ForceModelHarness");
+}
@@ -0,0 +1,105 @@
+//  Copyright (c) 2021, SBEL GPU Development Team
+//  Copyright (c) 2021, University of Wisconsin - Madison
+//
+//	SPDX-License-Identifier: BSD-3-Clause
+
+// =============================================================================
+// A demo of the force record policies. Spheres of two families are settled in a
+// box. The contacts between the two families are recorded in full and all other
+// contacts are recorded as per-owner aggregates; the aggregated forces, together
+// with the fully recorded ones, are then checked against the accelerations the
+// solver computed. The contact count and the contact output reflect that only the
+// cross-family contacts are recorded in full.
+// =============================================================================
+
+#include <core/ApiVersion.h>
+#include <core/utils/ThreadManager.h>
+#include <DEM/API.h>
+#include <DEM/HostSideHelpers.hpp>
+#include <DEM/utils/Samplers.hpp>
+
+#include "DemoChecks.hpp"
+
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+#include <iostream>
+#include <vector>
+
+using namespace deme;
+using namespace std::filesystem;
+
+int main() {
+    DEMSolver DEMSim;
+    DEMSim.SetVerbosity(INFO);
+    DEMSim.SetOutputFormat(OUTPUT_FORMAT::CSV);
+
+    auto mat_type = DEMSim.LoadMaterial({{"E", 1e8}, {"nu", 0.3}, {"CoR", 0.5}, {"mu", 0.4}, {"Crr", 0.01}});
+
+    float world_size = 0.2;
+    DEMSim.InstructBoxDomainDimension(world_size, world_size, world_size);
+    DEMSim.InstructBoxDomainBoundingBC("all", mat_type);
+
+    float radius = 0.005;
+    float mass = 2.6e3 * 4. / 3. * PI * radius * radius * radius;
+    auto sph_type = DEMSim.LoadSphereType(mass, radius, mat_type);
+    HCPSampler sampler(2.01 * radius);
+    auto input_xyz = sampler.SampleBox(make_float3(0, 0, -world_size / 4.),
+                                       make_float3(world_size / 2. - 2 * radius, world_size / 2. - 2 * radius,
+                                                   world_size / 4. - 2 * radius));
+    auto particles = DEMSim.AddClumps(sph_type, input_xyz);
+    // Alternate the family of the spheres, so there are many cross-family contacts
+    std::vector<unsigned int> families(input_xyz.size());
+    for (size_t i = 0; i < families.size(); i++) {
+        families[i] = i % 2;
+    }
+    particles->SetFamilies(families);
+    auto tracker = DEMSim.Track(particles);
+    std::cout << "Total num of particles: " << input_xyz.size() << std::endl;
+
+    // Contacts between family 0 and 1 are recorded in full, the rest only as per-owner sums
+    DEMSim.SetDefaultForceRecord("aggregate");
+    DEMSim.SetFamilyPairForceRecord(0, 1, "full");
+
+    DEMSim.SetInitTimeStep(2e-6);
+    DEMSim.SetGravitationalAcceleration(make_float3(0, 0, -9.81));
+    DEMSim.SetMaxVelocity(5.);
+    DEMSim.Initialize();
+
+    DEMSim.DoDynamicsThenSync(0.2);
+
+    // Accumulate the fully recorded contact forces on each owner
+    std::vector<float3> full_force(input_xyz.size(), make_float3(0, 0, 0));
+    std::vector<float3> cnt_points, cnt_forces;
+    for (size_t i = 0; i < input_xyz.size(); i++) {
+        DEMSim.GetOwnerContactForces(tracker->GetOwnerID(i), cnt_points, cnt_forces);
+        for (const auto& f : cnt_forces) {
+            full_force[i] += f;
+        }
+    }
+
+    // Aggregated plus fully recorded forces should give the contact acceleration of each owner
+    double max_err = 0., max_acc = 0.;
+    unsigned int num_aggregated = 0;
+    for (size_t i = 0; i < input_xyz.size(); i++) {
+        bodyID_t owner = tracker->GetOwnerID(i);
+        float3 acc = DEMSim.GetOwnerAcc(owner);
+        float3 recorded_acc = (DEMSim.GetOwnerContactForceSum(owner) + full_force[i]) / mass;
+        max_err = std::max(max_err, (double)length(acc - recorded_acc));
+        max_acc = std::max(max_acc, (double)length(acc));
+        num_aggregated += DEMSim.GetOwnerNumAggregatedContacts(owner);
+    }
+    printf("%zu contacts recorded in full, %u owner-contact pairs aggregated\n", DEMSim.GetNumContacts(),
+           num_aggregated);
+    printf("Largest difference between the recorded and the solver's acceleration: %g (largest acceleration %g)\n",
+           max_err, max_acc);
+
+    path out_dir = current_path();
+    out_dir += "/DemoOutput_ForceRecordPolicy";
+    create_directory(out_dir);
+    DEMSim.WriteContactFile(std::string(out_dir) + "/contacts.csv");
+
+    DemoChecks checks;
+    checks.Check(max_err <= 1e-3 * max_acc + 1e-6, "Recorded forces do not add up to the accelerations");
+    return checks.Finish("ForceRecordPolicy");
+}
@@ -0,0 +1,232 @@
+//  Copyright (c) 2021, SBEL GPU Development Team
+//  Copyright (c) 2021, University of Wisconsin - Madison
+//
+//	SPDX-License-Identifier: BSD-3-Clause
+
+// =============================================================================
+// A check of the logic behind UseHierarchicalBinning, using the host versions
+// of the level routines kT runs. In a polydisperse system (radius ratio 50:1),
+// each sphere is binned only at its own level; contacts between spheres of the
+// same level are found bin by bin, each reported by the bin its contact point
+// is in; those between levels are found by having the finer sphere look into
+// the bins of the coarser levels, each reported by the lowest bin both spheres
+// touch. Together they must be exactly the contacts a brute-force search finds.
+// The numbers of bins touched per sphere with one grid and with the levels are
+// reported.
+// =============================================================================
+
+#include <DEM/API.h>
+#include <DEM/HostSideHelpers.hpp>
+
+#include "DemoChecks.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+using namespace deme;
+
+#define MAX_LEVELS 8
+
+struct Levels {
+    double binSize;
+    unsigned int nLevels;
+    binID_t nbX[MAX_LEVELS], nbY[MAX_LEVELS], nbZ[MAX_LEVELS], offset[MAX_LEVELS];
+};
+
+using PairList = std::vector<std::pair<unsigned int, unsigned int>>;
+
+double levelBinSize(const Levels& g, unsigned int lvl) {
+    return g.binSize * (double)((size_t)1 << lvl);
+}
+
+// The bin range of a sphere at a level
+void sphereBinRange(const Levels& g,
+                    unsigned int lvl,
+                    const double3& pos,
+                    double radius,
+                    binID_t lo[3],
+                    binID_t hi[3]) {
+    double size = levelBinSize(g, lvl);
+    hostSphereBinRange1D(lo[0], hi[0], pos.x / size, radius / size, g.nbX[lvl]);
+    hostSphereBinRange1D(lo[1], hi[1], pos.y / size, radius / size, g.nbY[lvl]);
+    hostSphereBinRange1D(lo[2], hi[2], pos.z / size, radius / size, g.nbZ[lvl]);
+}
+
+binID_t binID(const Levels& g, unsigned int lvl, binID_t i, binID_t j, binID_t k) {
+    return g.offset[lvl] + i + j * g.nbX[lvl] + k * g.nbX[lvl] * g.nbY[lvl];
+}
+
+// What calcContactPoint does: whether the 2 spheres are in contact, and the bin (of a level) of the contact point
+bool contactPointBin(const Levels& g,
+                     unsigned int lvl,
+                     const double3& A,
+                     double rA,
+                     const double3& B,
+                     double rB,
+                     binID_t& bin) {
+    double3 B2A = make_double3(A.x - B.x, A.y - B.y, A.z - B.z);
+    double dist = std::sqrt(B2A.x * B2A.x + B2A.y * B2A.y + B2A.z * B2A.z);
+    if (dist > rA + rB)
+        return false;
+    double halfOverlap = (rA + rB - dist) / 2.;
+    double size = levelBinSize(g, lvl);
+    double3 cp = make_double3(B.x + (rB - halfOverlap) * B2A.x / dist, B.y + (rB - halfOverlap) * B2A.y / dist,
+                              B.z + (rB - halfOverlap) * B2A.z / dist);
+    binID_t i = (binID_t)hostClampBetween<double>(cp.x / size, 0., (double)(g.nbX[lvl] - 1));
+    binID_t j = (binID_t)hostClampBetween<double>(cp.y / size, 0., (double)(g.nbY[lvl] - 1));
+    binID_t k = (binID_t)hostClampBetween<double>(cp.z / size, 0., (double)(g.nbZ[lvl] - 1));
+    bin = binID(g, lvl, i, j, k);
+    return true;
+}
+
+// Contacts found with the levels of bins
+PairList findContactsHierarchical(const Levels& g,
+                                  const std::vector<double3>& pos,
+                                  const std::vector<double>& radius,
+                                  size_t& bins_touched) {
+    // Each sphere goes into the bins of its own level
+    std::vector<unsigned int> level(pos.size());
+    std::unordered_map<binID_t, std::vector<unsigned int>> bins;
+    bins_touched = 0;
+    for (unsigned int s = 0; s < pos.size(); s++) {
+        level[s] = hostSphereBinLevel(radius[s], g.binSize, g.nLevels);
+        binID_t lo[3], hi[3];
+        sphereBinRange(g, level[s], pos[s], radius[s], lo, hi);
+        for (binID_t k = lo[2]; k <= hi[2]; k++)
+            for (binID_t j = lo[1]; j <= hi[1]; j++)
+                for (binID_t i = lo[0]; i <= hi[0]; i++) {
+                    bins[binID(g, level[s], i, j, k)].push_back(s);
+                    bins_touched++;
+                }
+    }
+    PairList pairs;
+    // Same level: bin by bin
+    for (const auto& bin : bins) {
+        const std::vector<unsigned int>& res = bin.second;
+        unsigned int lvl = level[res[0]];
+        for (size_t a = 0; a < res.size(); a++) {
+            for (size_t b = a + 1; b < res.size(); b++) {
+                unsigned int A = res[a], B = res[b];
+                binID_t cpBin;
+                if (contactPointBin(g, lvl, pos[A], radius[A], pos[B], radius[B], cpBin) && cpBin == bin.first)
+                    pairs.emplace_back(std::min(A, B), std::max(A, B));
+            }
+        }
+    }
+    // Across levels: each sphere looks into the coarser levels
+    for (unsigned int A = 0; A < pos.size(); A++) {
+        for (unsigned int lvl = level[A] + 1; lvl < g.nLevels; lvl++) {
+            binID_t lo[3], hi[3];
+            sphereBinRange(g, lvl, pos[A], radius[A], lo, hi);
+            for (binID_t k = lo[2]; k <= hi[2]; k++)
+                for (binID_t j = lo[1]; j <= hi[1]; j++)
+                    for (binID_t i = lo[0]; i <= hi[0]; i++) {
+                        binID_t id = binID(g, lvl, i, j, k);
+                        auto it = bins.find(id);
+                        if (it == bins.end())
+                            continue;
+                        for (unsigned int B : it->second) {
+                            // Taken only from the lowest bin both touch
+                            binID_t loB[3], hiB[3];
+                            sphereBinRange(g, lvl, pos[B], radius[B], loB, hiB);
+                            if (i != std::max(lo[0], loB[0]) || j != std::max(lo[1], loB[1]) ||
+                                k != std::max(lo[2], loB[2]))
+                                continue;
+                            binID_t cpBin;
+                            if (contactPointBin(g, lvl, pos[A], radius[A], pos[B], radius[B], cpBin))
+                                pairs.emplace_back(std::min(A, B), std::max(A, B));
+                        }
+                    }
+        }
+    }
+    std::sort(pairs.begin(), pairs.end());
+    return pairs;
+}
+
+PairList findContactsBruteForce(const std::vector<double3>& pos, const std::vector<double>& radius) {
+    PairList pairs;
+    for (unsigned int i = 0; i < pos.size(); i++) {
+        for (unsigned int j = i + 1; j < pos.size(); j++) {
+            if (hostIsSphSphInContact<double>(pos[i].x, pos[i].y, pos[i].z, radius[i], pos[j].x, pos[j].y, pos[j].z,
+                                              radius[j], 0.f, 0.f))
+                pairs.emplace_back(i, j);
+        }
+    }
+    return pairs;
+}
+
+int main() {
+    const unsigned int num_small = 20000;
+    const unsigned int num_large = 40;
+    const double box = 1.;
+    const double small_r = 0.004, large_r = 0.2;
+    Levels g;
+    g.binSize = 4. * small_r;
+    binID_t nb = (binID_t)(box / g.binSize) + 1;
+    g.nLevels = hostNumBinLevels(g.binSize, large_r, MAX_LEVELS);
+    size_t num_bins = hostCalcBinLevels(g.nbX, g.nbY, g.nbZ, g.offset, nb, nb, nb, g.nLevels);
+
+    std::mt19937 rng(11);
+    std::uniform_real_distribution<double> uni(0., 1.);
+    std::vector<double3> pos;
+    std::vector<double> radius;
+    for (unsigned int s = 0; s < num_small + num_large; s++) {
+        pos.push_back(make_double3(box * uni(rng), box * uni(rng), box * uni(rng)));
+        // Mostly small spheres, and a few up to 50 times larger; some in between, so every level has spheres in it
+        if (s < num_small)
+            radius.push_back(small_r * (0.5 + 0.5 * uni(rng)));
+        else
+            radius.push_back(small_r + (large_r - small_r) * uni(rng));
+    }
+    printf("%zu spheres, radius ratio %g, base bin size %g, %u levels, %zu bins in all\n", pos.size(),
+           large_r / small_r, g.binSize, g.nLevels, num_bins);
+
+    DemoChecks checks;
+    checks.Check(g.nLevels >= 2, "Only 1 level of bins");
+
+    // Bins touched per sphere, with one grid of the base bin size
+    Levels single = g;
+    single.nLevels = 1;
+    size_t single_total = 0, single_max = 0;
+    for (unsigned int s = 0; s < pos.size(); s++) {
+        binID_t lo[3], hi[3];
+        sphereBinRange(single, 0, pos[s], radius[s], lo, hi);
+        size_t n = (size_t)(hi[0] - lo[0] + 1) * (hi[1] - lo[1] + 1) * (hi[2] - lo[2] + 1);
+        single_total += n;
+        single_max = std::max(single_max, n);
+    }
+    size_t hier_max = 0;
+    for (unsigned int s = 0; s < pos.size(); s++) {
+        unsigned int lvl = hostSphereBinLevel(radius[s], g.binSize, g.nLevels);
+        if (!checks.Check(2. * radius[s] <= levelBinSize(g, lvl),
+                          "  sphere %u of radius %g is put at level %u, whose bins are too small", s, radius[s], lvl)) {
+            break;
+        }
+        binID_t lo[3], hi[3];
+        sphereBinRange(g, lvl, pos[s], radius[s], lo, hi);
+        hier_max = std::max(hier_max, (size_t)(hi[0] - lo[0] + 1) * (hi[1] - lo[1] + 1) * (hi[2] - lo[2] + 1));
+    }
+
+    auto start = std::chrono::high_resolution_clock::now();
+    size_t hier_total;
+    PairList hier = findContactsHierarchical(g, pos, radius, hier_total);
+    double hier_time = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+    start = std::chrono::high_resolution_clock::now();
+    PairList brute = findContactsBruteForce(pos, radius);
+    double brute_time = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+
+    printf("Bins per sphere, one grid: %.2f on average, %zu at most\n", (double)single_total / pos.size(), single_max);
+    printf("Bins per sphere, levels:   %.2f on average, %zu at most\n", (double)hier_total / pos.size(), hier_max);
+    printf("%zu contacts with the levels (%.3f s), %zu from brute force (%.3f s)\n", hier.size(), hier_time,
+           brute.size(), brute_time);
+    checks.Check(hier == brute, "The contacts found with the levels are not the brute-force ones");
+    checks.Check(hier_max <= 8, "A sphere touches more than 8 bins of its level");
+
+    return checks.Finish("HierarchicalBinning");
+}
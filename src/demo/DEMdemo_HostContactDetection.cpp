@@ -0,0 +1,142 @@
+//  Copyright (c) 2021, SBEL GPU Development Team
+//  Copyright (c) 2021, University of Wisconsin - Madison
+//
+//	SPDX-License-Identifier: BSD-3-Clause
+
+// =============================================================================
+// A check of UseHostContactDetection. The same packing of clumps (one-sphere
+// ones, then three-sphere ones of mixed sizes) is loaded into two solvers, one
+// detecting contacts on its GPU and one on host threads. After the first
+// contact detection, both must have found exactly the same clump contact
+// pairs, and those pairs must include every pair of clumps whose spheres
+// overlap, as a brute-force search finds them.
+// =============================================================================
+
+#include <DEM/API.h>
+#include <DEM/HostSideHelpers.hpp>
+
+#include "DemoChecks.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <set>
+#include <utility>
+#include <vector>
+
+using namespace deme;
+
+using PairSet = std::set<std::pair<bodyID_t, bodyID_t>>;
+
+struct Packing {
+    std::vector<float3> pos;
+    // Index into the templates, and the template spheres (relative positions and radii)
+    std::vector<unsigned int> type;
+    std::vector<std::vector<float3>> relPos;
+    std::vector<std::vector<float>> radii;
+};
+
+// Clumps on a jittered grid, spaced so that a fair share of neighbors overlap
+Packing makePacking(unsigned int n_per_dim, bool multi_sphere, std::mt19937& rng) {
+    std::uniform_real_distribution<float> uni(0.f, 1.f);
+    Packing p;
+    const unsigned int n_types = 4;
+    for (unsigned int t = 0; t < n_types; t++) {
+        const float r = 0.01f + 0.004f * t;
+        if (multi_sphere) {
+            p.relPos.push_back({host_make_float3(-r, 0, 0), host_make_float3(0, 0, 0), host_make_float3(r, 0, r)});
+            p.radii.push_back({r, 0.8f * r, 0.6f * r});
+        } else {
+            p.relPos.push_back({host_make_float3(0, 0, 0)});
+            p.radii.push_back({r});
+        }
+    }
+    const float spacing = 0.04f;
+    for (unsigned int i = 0; i < n_per_dim; i++)
+        for (unsigned int j = 0; j < n_per_dim; j++)
+            for (unsigned int k = 0; k < n_per_dim; k++) {
+                p.pos.push_back(host_make_float3(spacing * (i + 0.5f + 0.3f * (uni(rng) - 0.5f)) - 0.5f,
+                                                 spacing * (j + 0.5f + 0.3f * (uni(rng) - 0.5f)) - 0.5f,
+                                                 spacing * (k + 0.5f + 0.3f * (uni(rng) - 0.5f)) - 0.5f));
+                p.type.push_back((unsigned int)(n_types * uni(rng)) % n_types);
+            }
+    return p;
+}
+
+// Pairs of clumps (by owner ID, which is the order they are added in) that have overlapping spheres
+PairSet bruteForceContacts(const Packing& p) {
+    PairSet pairs;
+    for (size_t a = 0; a < p.pos.size(); a++) {
+        for (size_t b = a + 1; b < p.pos.size(); b++) {
+            const auto& relA = p.relPos[p.type[a]];
+            const auto& relB = p.relPos[p.type[b]];
+            bool overlap = false;
+            for (size_t i = 0; i < relA.size() && !overlap; i++) {
+                for (size_t j = 0; j < relB.size() && !overlap; j++) {
+                    float3 d = (p.pos[a] + relA[i]) - (p.pos[b] + relB[j]);
+                    float r = p.radii[p.type[a]][i] + p.radii[p.type[b]][j];
+                    overlap = dot(d, d) < r * r;
+                }
+            }
+            if (overlap)
+                pairs.emplace(a, b);
+        }
+    }
+    return pairs;
+}
+
+// Load the packing, run one step, and return the clump contact pairs found at the first contact detection
+PairSet solverContacts(const Packing& p, bool on_host) {
+    DEMSolver DEMSim;
+    DEMSim.SetVerbosity("ERROR");
+    DEMSim.InstructBoxDomainDimension(1.2, 1.2, 1.2);
+    DEMSim.SetGravitationalAcceleration(host_make_float3(0, 0, 0));
+    DEMSim.SetCDUpdateFreq(0);
+    DEMSim.UseAdaptiveUpdateFreq(false);
+    DEMSim.SetMaxVelocity(1.);
+    DEMSim.UseHostContactDetection(on_host);
+
+    auto mat = DEMSim.LoadMaterial({{"E", 1e8}, {"nu", 0.3}, {"CoR", 0.5}, {"mu", 0.3}, {"Crr", 0.0}});
+    std::vector<std::shared_ptr<DEMClumpTemplate>> templates;
+    for (size_t t = 0; t < p.radii.size(); t++)
+        templates.push_back(
+            DEMSim.LoadClumpType(1.f, host_make_float3(1e-4, 1e-4, 1e-4), p.radii[t], p.relPos[t], mat));
+    std::vector<std::shared_ptr<DEMClumpTemplate>> types;
+    for (auto t : p.type)
+        types.push_back(templates[t]);
+    DEMSim.AddClumps(types, p.pos);
+
+    DEMSim.SetInitTimeStep(1e-6);
+    DEMSim.Initialize();
+    DEMSim.DoDynamicsThenSync(1e-6);
+
+    PairSet pairs;
+    for (const auto& c : DEMSim.GetClumpContacts())
+        pairs.emplace(std::min(c.first, c.second), std::max(c.first, c.second));
+    return pairs;
+}
+
+int main() {
+    std::mt19937 rng(7);
+    DemoChecks checks;
+    for (bool multi_sphere : {false, true}) {
+        Packing p = makePacking(20, multi_sphere, rng);
+        PairSet reference = bruteForceContacts(p);
+        PairSet on_gpu = solverContacts(p, false);
+        PairSet on_host = solverContacts(p, true);
+        printf("%s clumps: %zu clumps, %zu overlapping pairs, %zu pairs found on GPU, %zu on host\n",
+               multi_sphere ? "Three-sphere" : "One-sphere", p.pos.size(), reference.size(), on_gpu.size(),
+               on_host.size());
+        size_t only_host = 0, only_gpu = 0;
+        for (const auto& c : on_host)
+            only_host += on_gpu.count(c) ? 0 : 1;
+        for (const auto& c : on_gpu)
+            only_gpu += on_host.count(c) ? 0 : 1;
+        checks.Check(on_host == on_gpu, "  %zu pairs found only on host, %zu only on GPU", only_host, only_gpu);
+        checks.Check(std::includes(on_host.begin(), on_host.end(), reference.begin(), reference.end()),
+                     "  Host contact detection missed overlapping pairs");
+    }
+
+    return checks.Finish("HostContactDetection");
+}
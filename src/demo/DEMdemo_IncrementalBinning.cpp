@@ -0,0 +1,182 @@
+//  Copyright (c) 2021, SBEL GPU Development Team
+//  Copyright (c) 2021, University of Wisconsin - Madison
+//
+//	SPDX-License-Identifier: BSD-3-Clause
+
+// =============================================================================
+// A check and a benchmark of the logic behind UseIncrementalBinning, using the
+// host versions of the bin range and merge routines kT runs. Spheres drift
+// slowly through the bins; at each step, re-binning only the spheres whose bin
+// range changed and merging their pairs into the recorded ones must give
+// exactly the sorted bin--sphere pairs that binning all spheres gives.
+// =============================================================================
+
+#include <DEM/API.h>
+#include <DEM/HostSideHelpers.hpp>
+
+#include "DemoChecks.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+using namespace deme;
+
+struct Grid {
+    double binSize;
+    binID_t nbX, nbY, nbZ;
+};
+
+// The bin range of a sphere, as the IDs of its lowest and highest bins
+void sphereBinRange(const Grid& g, const double3& pos, double radius, binID_t lo[3], binID_t hi[3]) {
+    double span = radius / g.binSize;
+    hostSphereBinRange1D(lo[0], hi[0], pos.x / g.binSize, span, g.nbX);
+    hostSphereBinRange1D(lo[1], hi[1], pos.y / g.binSize, span, g.nbY);
+    hostSphereBinRange1D(lo[2], hi[2], pos.z / g.binSize, span, g.nbZ);
+}
+
+binID_t binID(const Grid& g, binID_t i, binID_t j, binID_t k) {
+    return i + j * g.nbX + k * g.nbX * g.nbY;
+}
+
+// The bin--sphere pairs of the spheres that are flagged, made in the order of sphere IDs (like
+// populateBinSphereTouchingPairs does), then stably sorted by bin ID (like the radix sort does)
+void binSpheres(const Grid& g,
+                const std::vector<double3>& pos,
+                const std::vector<double>& radius,
+                const std::vector<binsSphereTouches_t>& flags,
+                std::vector<binID_t>& bins,
+                std::vector<bodyID_t>& spheres) {
+    bins.clear();
+    spheres.clear();
+    for (bodyID_t s = 0; s < pos.size(); s++) {
+        if (flags[s] == 0)
+            continue;
+        binID_t lo[3], hi[3];
+        sphereBinRange(g, pos[s], radius[s], lo, hi);
+        for (binID_t k = lo[2]; k <= hi[2]; k++)
+            for (binID_t j = lo[1]; j <= hi[1]; j++)
+                for (binID_t i = lo[0]; i <= hi[0]; i++) {
+                    bins.push_back(binID(g, i, j, k));
+                    spheres.push_back(s);
+                }
+    }
+    std::vector<size_t> order = hostSortIndices(bins);
+    std::vector<binID_t> sorted_bins(bins.size());
+    std::vector<bodyID_t> sorted_spheres(bins.size());
+    for (size_t n = 0; n < order.size(); n++) {
+        sorted_bins[n] = bins[order[n]];
+        sorted_spheres[n] = spheres[order[n]];
+    }
+    bins.swap(sorted_bins);
+    spheres.swap(sorted_spheres);
+}
+
+int main() {
+    const unsigned int num_spheres = 200000;
+    const double box = 1.;
+    const unsigned int num_steps = 40;
+    Grid grid;
+    grid.binSize = 0.02;
+    grid.nbX = grid.nbY = grid.nbZ = (binID_t)(box / grid.binSize) + 1;
+
+    std::mt19937 rng(7);
+    std::uniform_real_distribution<double> uni(0., 1.);
+    std::vector<double3> pos(num_spheres), vel(num_spheres);
+    std::vector<double> radius(num_spheres);
+    for (unsigned int s = 0; s < num_spheres; s++) {
+        pos[s] = make_double3(box * uni(rng), box * uni(rng), box * uni(rng));
+        vel[s] = make_double3(uni(rng) - 0.5, uni(rng) - 0.5, uni(rng) - 0.5);
+        radius[s] = 0.002 + 0.004 * uni(rng);
+    }
+    printf("%u spheres, %u bins per direction\n", num_spheres, (unsigned int)grid.nbX);
+
+    // The record kT keeps
+    std::vector<binID_t> rec_lo(num_spheres), rec_hi(num_spheres);
+    std::vector<binID_t> rec_bins;
+    std::vector<bodyID_t> rec_spheres;
+    bool rec_valid = false;
+    double rec_bin_size = 0.;
+
+    const std::vector<binsSphereTouches_t> all(num_spheres, 1);
+    std::vector<binsSphereTouches_t> rebinned(num_spheres);
+    std::vector<binID_t> full_bins, new_bins, merged_bins;
+    std::vector<bodyID_t> full_spheres, new_spheres, merged_spheres;
+    DemoChecks checks;
+    unsigned int num_incremental = 0;
+    size_t total_rebinned = 0;
+    double full_time = 0., incr_time = 0.;
+    for (unsigned int step = 0; step < num_steps; step++) {
+        // Slow drift: a few percent of a bin size per step
+        const double dt = 1e-3;
+        for (unsigned int s = 0; s < num_spheres; s++) {
+            pos[s].x = hostClampBetween(pos[s].x + vel[s].x * dt, 0., box);
+            pos[s].y = hostClampBetween(pos[s].y + vel[s].y * dt, 0., box);
+            pos[s].z = hostClampBetween(pos[s].z + vel[s].z * dt, 0., box);
+        }
+        // Once, the bin size changes, and then all spheres must be binned again
+        if (step == num_steps / 2) {
+            grid.binSize *= 1.05;
+            grid.nbX = grid.nbY = grid.nbZ = (binID_t)(box / grid.binSize) + 1;
+        }
+
+        auto start = std::chrono::high_resolution_clock::now();
+        binSpheres(grid, pos, radius, all, full_bins, full_spheres);
+        full_time += std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+
+        // What markSpheresToRebin does
+        start = std::chrono::high_resolution_clock::now();
+        if (rec_bin_size != grid.binSize)
+            rec_valid = false;
+        size_t num_rebinned = 0;
+        for (unsigned int s = 0; s < num_spheres; s++) {
+            binID_t lo[3], hi[3];
+            sphereBinRange(grid, pos[s], radius[s], lo, hi);
+            binID_t lo_id = binID(grid, lo[0], lo[1], lo[2]), hi_id = binID(grid, hi[0], hi[1], hi[2]);
+            if (lo_id != rec_lo[s] || hi_id != rec_hi[s]) {
+                rec_lo[s] = lo_id;
+                rec_hi[s] = hi_id;
+                rebinned[s] = (hi[0] - lo[0] + 1) * (hi[1] - lo[1] + 1) * (hi[2] - lo[2] + 1);
+                num_rebinned++;
+            } else {
+                rebinned[s] = 0;
+            }
+        }
+        bool rebin_all = !rec_valid || num_rebinned * 2 > num_spheres;
+        if (rebin_all) {
+            binSpheres(grid, pos, radius, all, merged_bins, merged_spheres);
+            total_rebinned += num_spheres;
+        } else {
+            binSpheres(grid, pos, radius, rebinned, new_bins, new_spheres);
+            merged_bins.resize(rec_bins.size() + new_bins.size());
+            merged_spheres.resize(rec_bins.size() + new_bins.size());
+            size_t n = hostMergeBinSpherePairs(rec_bins.data(), rec_spheres.data(), rec_bins.size(), rebinned.data(),
+                                               new_bins.data(), new_spheres.data(), new_bins.size(),
+                                               merged_bins.data(), merged_spheres.data());
+            merged_bins.resize(n);
+            merged_spheres.resize(n);
+            total_rebinned += num_rebinned;
+            num_incremental++;
+        }
+        rec_bins = merged_bins;
+        rec_spheres = merged_spheres;
+        rec_bin_size = grid.binSize;
+        rec_valid = true;
+        incr_time += std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+
+        checks.Check(step != num_steps / 2 || rebin_all,
+                     "  step %u: the bin size changed, but not all spheres were re-binned", step);
+        checks.Check(merged_bins == full_bins && merged_spheres == full_spheres,
+                     "  step %u: %zu pairs incrementally, %zu from binning all spheres, or in another order", step,
+                     merged_bins.size(), full_bins.size());
+    }
+
+    printf("%u steps: %u binned incrementally, re-binning %.2f%% of the spheres on average\n", num_steps,
+           num_incremental, 100. * total_rebinned / ((double)num_spheres * num_steps));
+    printf("Binning all spheres: %.3f s; incrementally: %.3f s\n", full_time, incr_time);
+    checks.Check(num_incremental > 0, "Never binned incrementally");
+
+    return checks.Finish("IncrementalBinning");
+}
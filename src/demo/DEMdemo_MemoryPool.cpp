@@ -0,0 +1,128 @@
+//  Copyright (c) 2021, SBEL GPU Development Team
+//  Copyright (c) 2021, University of Wisconsin - Madison
+//
+//	SPDX-License-Identifier: BSD-3-Clause
+
+// =============================================================================
+// A check of the caching memory pool policy, run on the host backend so it does
+// not need a GPU. Size classes, reuse of cached blocks, retention up to the
+// high-water mark, explicit trimming and the trim-then-retry path taken when the
+// backend runs out of memory are all checked.
+// =============================================================================
+
+#include <core/utils/MemoryPool.hpp>
+
+#include "DemoChecks.hpp"
+
+#include <memory>
+#include <new>
+#include <unordered_map>
+
+using namespace deme;
+
+// Host backend that runs out of memory past a byte limit. The pool keeps its own copy of the backend, so the counters
+// are shared through a pointer.
+class LimitedHostBackend {
+  public:
+    struct Usage {
+        size_t limit = 0;
+        size_t bytesUsed = 0;
+        std::unordered_map<void*, size_t> blocks;
+    };
+
+    explicit LimitedHostBackend(std::shared_ptr<Usage> usage) : m_usage(usage) {}
+    void* Allocate(size_t bytes) {
+        if (m_usage->bytesUsed + bytes > m_usage->limit) {
+            throw std::bad_alloc();
+        }
+        void* ptr = m_host.Allocate(bytes);
+        m_usage->bytesUsed += bytes;
+        m_usage->blocks[ptr] = bytes;
+        return ptr;
+    }
+    void Free(void* ptr) {
+        m_usage->bytesUsed -= m_usage->blocks.at(ptr);
+        m_usage->blocks.erase(ptr);
+        m_host.Free(ptr);
+    }
+
+  private:
+    HostMemoryBackend m_host;
+    std::shared_ptr<Usage> m_usage;
+};
+
+int main() {
+    DemoChecks checks;
+    const size_t MB = 1024 * 1024;
+
+    // Size classes: at least the request, at most 25% rounding waste past the smallest blocks
+    using HostPool = MemoryPool<HostMemoryBackend>;
+    checks.Check(HostPool::SizeClassOf(1) == HostPool::MIN_BLOCK_BYTES, "Small requests get the smallest block");
+    bool classes_ok = true;
+    for (size_t bytes = 1; bytes < 64 * MB; bytes = bytes * 3 / 2 + 7) {
+        const size_t cls = HostPool::SizeClassOf(bytes);
+        classes_ok = classes_ok && cls >= bytes && cls % HostPool::MIN_BLOCK_BYTES == 0;
+        if (bytes > 4 * HostPool::MIN_BLOCK_BYTES)
+            classes_ok = classes_ok && (cls - bytes) * 4 <= bytes;
+        // A request of exactly a class size is served by that class
+        classes_ok = classes_ok && HostPool::SizeClassOf(cls) == cls;
+    }
+    checks.Check(classes_ok, "Size classes cover the request with bounded waste");
+
+    {
+        HostPool pool;
+        // A freed block is reused by the next request of its class
+        void* a = pool.Allocate(MB);
+        pool.Deallocate(a);
+        void* b = pool.Allocate(MB - 100);
+        MemoryPoolStats stats = pool.GetStats();
+        checks.Check(a == b && stats.numCacheHits == 1 && stats.numBackendAllocs == 1, "Cached block is reused");
+        checks.Check(!pool.Deallocate((void*)&stats), "Foreign pointers are not taken");
+        pool.Deallocate(b);
+
+        // Cached blocks are retained up to the high-water mark of in-use bytes
+        void* blocks[4];
+        for (auto& blk : blocks)
+            blk = pool.Allocate(MB);
+        for (auto& blk : blocks)
+            pool.Deallocate(blk);
+        stats = pool.GetStats();
+        checks.Check(stats.bytesInUse == 0 && stats.bytesCached == 4 * MB,
+                     "Blocks up to the high-water mark are retained");
+        pool.SetRetainFactor(0.5);
+        checks.Check(pool.GetStats().bytesCached == 2 * MB, "Retention follows the retain factor");
+
+        // Trim releases what is cached
+        size_t released = pool.Trim(0);
+        stats = pool.GetStats();
+        checks.Check(released == 2 * MB && stats.bytesCached == 0 && stats.numBackendFrees == 4,
+                     "Trim releases cached blocks");
+    }
+
+    {
+        auto usage = std::make_shared<LimitedHostBackend::Usage>();
+        usage->limit = 3 * MB;
+        MemoryPool<LimitedHostBackend> pool(LimitedHostBackend(usage), 1.0);
+        // Leave a block in the cache that is too large to serve the next request
+        void* big = pool.Allocate(5 * MB / 2);
+        pool.Deallocate(big);
+        checks.Check(pool.GetStats().bytesCached == 5 * MB / 2, "Big block is cached");
+        // Backend is full: the pool gives its cache back, then retries
+        void* small = pool.Allocate(MB);
+        MemoryPoolStats stats = pool.GetStats();
+        checks.Check(small != nullptr && stats.bytesCached == 0 && stats.bytesInUse == MB && usage->bytesUsed == MB,
+                     "Out-of-memory backend is retried after trimming");
+        // If trimming does not help, the error goes to the caller
+        bool threw = false;
+        try {
+            pool.Allocate(4 * MB);
+        } catch (const std::bad_alloc&) {
+            threw = true;
+        }
+        checks.Check(threw && pool.GetStats().bytesInUse == MB,
+                     "Out-of-memory error surfaces when trimming cannot help");
+        pool.Deallocate(small);
+    }
+
+    return checks.Finish("MemoryPool");
+}
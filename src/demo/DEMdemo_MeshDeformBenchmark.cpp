@@ -0,0 +1,150 @@
+//  Copyright (c) 2021, SBEL GPU Development Team
+//  Copyright (c) 2021, University of Wisconsin - Madison
+//
+//	SPDX-License-Identifier: BSD-3-Clause
+
+// =============================================================================
+// A benchmark of the cost of deforming a large mesh, versus the fraction of its
+// nodes that are moved in each update. A fine plate mesh rests under a layer of
+// particles; in each round, a patch of nodes is moved (UpdateMeshNodes), and we
+// time the host-side update and the following steps, which carry the transfer
+// of the deformed facets to the kT thread. A full-mesh UpdateMesh call is timed
+// for reference.
+// =============================================================================
+
+#include <DEM/API.h>
+#include <DEM/HostSideHelpers.hpp>
+#include <DEM/utils/Samplers.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+#include <vector>
+
+using namespace deme;
+
+// Build a flat, square, z-up plate mesh with n by n nodes
+DEMMeshConnected makePlateMesh(unsigned int n, float size) {
+    DEMMeshConnected mesh;
+    float spacing = size / (n - 1);
+    for (unsigned int j = 0; j < n; j++) {
+        for (unsigned int i = 0; i < n; i++) {
+            mesh.m_vertices.push_back(make_float3(-size / 2 + i * spacing, -size / 2 + j * spacing, 0));
+        }
+    }
+    for (unsigned int j = 0; j < n - 1; j++) {
+        for (unsigned int i = 0; i < n - 1; i++) {
+            int a = j * n + i;
+            mesh.m_face_v_indices.push_back(make_int3(a, a + 1, a + n + 1));
+            mesh.m_face_v_indices.push_back(make_int3(a, a + n + 1, a + n));
+        }
+    }
+    mesh.nTri = mesh.m_face_v_indices.size();
+    return mesh;
+}
+
+int main() {
+    DEMSolver DEMSim;
+    DEMSim.SetVerbosity(WARNING);
+    DEMSim.SetNoForceRecord();
+
+    auto mat_type = DEMSim.LoadMaterial({{"E", 1e8}, {"nu", 0.3}, {"CoR", 0.5}, {"mu", 0.5}, {"Crr", 0.0}});
+
+    float world_size = 2.;
+    DEMSim.InstructBoxDomainDimension(world_size, world_size, world_size);
+    DEMSim.InstructBoxDomainBoundingBC("top_open", mat_type);
+
+    // A 400 by 400 node plate, that is about 320k facets
+    unsigned int n_side = 400;
+    DEMMeshConnected plate_mesh = makePlateMesh(n_side, world_size * 0.9);
+    plate_mesh.SetMaterial(mat_type);
+    auto plate = DEMSim.AddWavefrontMeshObject(plate_mesh);
+    plate->SetInitPos(make_float3(0, 0, -world_size / 4));
+    plate->SetFamily(1);
+    DEMSim.SetFamilyFixed(1);
+    auto plate_tracker = DEMSim.Track(plate);
+
+    // A layer of particles on top of it
+    float radius = 0.02;
+    auto sph_type = DEMSim.LoadSphereType(2.6e3 * 4. / 3. * 3.1415927 * radius * radius * radius, radius, mat_type);
+    HCPSampler sampler(2.2 * radius);
+    auto input_xyz = sampler.SampleBox(make_float3(0, 0, -world_size / 4 + 0.1),
+                                       make_float3(world_size * 0.4, world_size * 0.4, 0.05));
+    DEMSim.AddClumps(sph_type, input_xyz);
+    std::cout << "Num of particles: " << input_xyz.size() << ", num of mesh facets: " << plate_mesh.GetNumTriangles()
+              << std::endl;
+
+    float step_size = 1e-5;
+    DEMSim.SetInitTimeStep(step_size);
+    DEMSim.SetGravitationalAcceleration(make_float3(0, 0, -9.81));
+    DEMSim.SetCDUpdateFreq(10);
+    DEMSim.SetExpandSafetyAdder(0.5);
+    DEMSim.Initialize();
+    DEMSim.DoDynamicsThenSync(0.01);
+
+    const std::vector<float3> rest_nodes(plate->GetCoordsVertices());
+    const size_t n_nodes = rest_nodes.size();
+    const unsigned int rounds = 20;
+    const unsigned int steps_per_round = 10;
+
+    // Baseline: steps without any mesh update
+    auto time_steps = [&]() {
+        auto start = std::chrono::high_resolution_clock::now();
+        for (unsigned int s = 0; s < steps_per_round; s++)
+            DEMSim.DoStepDynamics();
+        DEMSim.DoDynamicsThenSync(0.);
+        return std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+    };
+    double baseline = 0;
+    for (unsigned int r = 0; r < rounds; r++)
+        baseline += time_steps();
+    baseline /= rounds;
+    printf("Baseline: %.3f ms per %u steps\n", baseline * 1e3, steps_per_round);
+    printf("%12s %12s %16s %20s\n", "fraction", "nodes", "update (ms)", "steps overhead (ms)");
+
+    // A patch of consecutive nodes (rows of the plate) moves a bit up and down, in each round
+    for (double fraction : {0.0001, 0.001, 0.01, 0.1, 0.5, 1.0}) {
+        size_t n_moved = std::max<size_t>(1, (size_t)(fraction * n_nodes));
+        size_t first = (n_nodes - n_moved) / 2;
+        std::vector<size_t> node_ids(n_moved);
+        std::vector<float3> new_nodes(n_moved);
+        for (size_t i = 0; i < n_moved; i++)
+            node_ids[i] = first + i;
+        double update_time = 0, step_time = 0;
+        for (unsigned int r = 0; r < rounds; r++) {
+            float amp = 0.005 * std::sin(0.7 * (r + 1));
+            for (size_t i = 0; i < n_moved; i++) {
+                const float3& rest = rest_nodes[node_ids[i]];
+                new_nodes[i] = make_float3(rest.x, rest.y, rest.z + amp);
+            }
+            auto start = std::chrono::high_resolution_clock::now();
+            plate_tracker->UpdateMeshNodes(node_ids, new_nodes);
+            update_time += std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+            step_time += time_steps();
+        }
+        printf("%12g %12zu %16.3f %20.3f\n", fraction, n_moved, update_time / rounds * 1e3,
+               (step_time / rounds - baseline) * 1e3);
+    }
+
+    // Reference: handing over the full node array
+    {
+        std::vector<float3> all_nodes(rest_nodes);
+        double update_time = 0, step_time = 0;
+        for (unsigned int r = 0; r < rounds; r++) {
+            float amp = 0.005 * std::sin(0.3 * (r + 1));
+            for (size_t i = 0; i < n_nodes; i++)
+                all_nodes[i] = make_float3(rest_nodes[i].x, rest_nodes[i].y, rest_nodes[i].z + amp);
+            auto start = std::chrono::high_resolution_clock::now();
+            plate_tracker->UpdateMesh(all_nodes);
+            update_time += std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+            step_time += time_steps();
+        }
+        printf("%12s %12zu %16.3f %20.3f\n", "full array", n_nodes, update_time / rounds * 1e3,
+               (step_time / rounds - baseline) * 1e3);
+    }
+
+    std::cout << "MeshDeformBenchmark demo exiting..." << std::endl;
+    return 0;
+}
@@ -0,0 +1,228 @@
+//  Copyright (c) 2021, SBEL GPU Development Team
+//  Copyright (c) 2021, University of Wisconsin - Madison
+//
+//	SPDX-License-Identifier: BSD-3-Clause
+
+// =============================================================================
+// A check and a benchmark of DEMMeshConnected::ComputeMassProperties. The mass
+// properties of box, cylinder and sphere meshes are compared against the
+// analytic ones, also after the meshes are moved around, broken (open, badly
+// wound, inside out, with nodes repeated per facet), and brought to their
+// principal frame. Then a fine sphere mesh is timed with 1 and all threads.
+// =============================================================================
+
+#include <DEM/API.h>
+#include <DEM/HostSideHelpers.hpp>
+
+#include "DemoChecks.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+using namespace deme;
+
+// A box with half sizes hx, hy, hz, centered at the origin
+DEMMeshConnected makeBoxMesh(float hx, float hy, float hz) {
+    DEMMeshConnected mesh;
+    for (int i = 0; i < 8; i++) {
+        mesh.m_vertices.push_back(make_float3((i & 1) ? hx : -hx, (i & 2) ? hy : -hy, (i & 4) ? hz : -hz));
+    }
+    const int faces[12][3] = {{0, 2, 1}, {1, 2, 3}, {4, 5, 6}, {5, 7, 6}, {0, 1, 4}, {1, 5, 4},
+                              {2, 6, 3}, {3, 6, 7}, {0, 4, 2}, {2, 4, 6}, {1, 3, 5}, {3, 7, 5}};
+    for (const auto& f : faces) {
+        mesh.m_face_v_indices.push_back(make_int3(f[0], f[1], f[2]));
+    }
+    mesh.nTri = mesh.m_face_v_indices.size();
+    return mesh;
+}
+
+// A closed cylinder along z, centered at the origin, with n facets around
+DEMMeshConnected makeCylinderMesh(unsigned int n, float radius, float height) {
+    DEMMeshConnected mesh;
+    for (unsigned int i = 0; i < n; i++) {
+        double theta = 2. * PI * i / n;
+        mesh.m_vertices.push_back(make_float3(radius * std::cos(theta), radius * std::sin(theta), -height / 2));
+        mesh.m_vertices.push_back(make_float3(radius * std::cos(theta), radius * std::sin(theta), height / 2));
+    }
+    int bottom = 2 * n, top = 2 * n + 1;
+    mesh.m_vertices.push_back(make_float3(0, 0, -height / 2));
+    mesh.m_vertices.push_back(make_float3(0, 0, height / 2));
+    for (unsigned int i = 0; i < n; i++) {
+        int a = 2 * i, b = 2 * ((i + 1) % n);
+        mesh.m_face_v_indices.push_back(make_int3(a, b, a + 1));
+        mesh.m_face_v_indices.push_back(make_int3(b, b + 1, a + 1));
+        mesh.m_face_v_indices.push_back(make_int3(bottom, b, a));
+        mesh.m_face_v_indices.push_back(make_int3(top, a + 1, b + 1));
+    }
+    mesh.nTri = mesh.m_face_v_indices.size();
+    return mesh;
+}
+
+// A latitude-longitude sphere centered at the origin, with n rings
+DEMMeshConnected makeSphereMesh(unsigned int n, float radius) {
+    DEMMeshConnected mesh;
+    // The poles, then 2n nodes on each of the n - 1 inner rings
+    mesh.m_vertices.push_back(make_float3(0, 0, radius));
+    mesh.m_vertices.push_back(make_float3(0, 0, -radius));
+    for (unsigned int j = 1; j < n; j++) {
+        for (unsigned int i = 0; i < 2 * n; i++) {
+            double theta = PI * j / n, phi = PI * i / n;
+            mesh.m_vertices.push_back(make_float3(radius * std::sin(theta) * std::cos(phi),
+                                                  radius * std::sin(theta) * std::sin(phi),
+                                                  radius * std::cos(theta)));
+        }
+    }
+    auto id = [n](unsigned int j, unsigned int i) { return (int)(2 + (j - 1) * 2 * n + i % (2 * n)); };
+    for (unsigned int i = 0; i < 2 * n; i++) {
+        mesh.m_face_v_indices.push_back(make_int3(0, id(1, i), id(1, i + 1)));
+        mesh.m_face_v_indices.push_back(make_int3(1, id(n - 1, i + 1), id(n - 1, i)));
+    }
+    for (unsigned int j = 1; j < n - 1; j++) {
+        for (unsigned int i = 0; i < 2 * n; i++) {
+            mesh.m_face_v_indices.push_back(make_int3(id(j, i), id(j + 1, i), id(j, i + 1)));
+            mesh.m_face_v_indices.push_back(make_int3(id(j, i + 1), id(j + 1, i), id(j + 1, i + 1)));
+        }
+    }
+    mesh.nTri = mesh.m_face_v_indices.size();
+    return mesh;
+}
+
+// Give each facet its own copy of its nodes, like an STL file does
+DEMMeshConnected unweld(const DEMMeshConnected& mesh) {
+    DEMMeshConnected out;
+    for (const auto& f : mesh.m_face_v_indices) {
+        int base = out.m_vertices.size();
+        out.m_vertices.push_back(mesh.m_vertices[f.x]);
+        out.m_vertices.push_back(mesh.m_vertices[f.y]);
+        out.m_vertices.push_back(mesh.m_vertices[f.z]);
+        out.m_face_v_indices.push_back(make_int3(base, base + 1, base + 2));
+    }
+    out.nTri = out.m_face_v_indices.size();
+    return out;
+}
+
+DemoChecks checks;
+
+// Relative error, or absolute error if the expected value is 0
+void check(const char* what, double value, double expected, double tol) {
+    double err = std::abs(value - expected) / (expected == 0. ? 1. : std::abs(expected));
+    bool ok = checks.Record(err <= tol);
+    printf("  %-34s %14.7g %14.7g   err %9.2e  %s\n", what, value, expected, err, ok ? "ok" : "FAILED");
+}
+
+void checkCount(const char* what, size_t value, size_t expected) {
+    bool ok = checks.Record(value == expected);
+    printf("  %-34s %14zu %14zu   %s\n", what, value, expected, ok ? "ok" : "FAILED");
+}
+
+// Compare the mass properties of a mesh against the analytic volume and principal moments (ascending) of the shape
+// it approximates, placed at the origin
+void checkShape(const char* name,
+                const DEMMeshConnected& mesh,
+                double volume,
+                const float3& moments,
+                double rel_tol) {
+    printf("%s (%zu facets):\n", name, mesh.GetNumTriangles());
+    MeshMassProperties props = mesh.ComputeMassProperties();
+    check("volume", props.volume, volume, rel_tol);
+    check("center distance to origin", length(props.center), 0., 1e-5);
+    check("principal moment 1", props.principal_inertia.x, moments.x, rel_tol);
+    check("principal moment 2", props.principal_inertia.y, moments.y, rel_tol);
+    check("principal moment 3", props.principal_inertia.z, moments.z, rel_tol);
+    checkCount("watertight", props.watertight, 1);
+
+    // Moved and rotated, then brought back to its principal frame, it should have the same properties, a centroid at
+    // the origin and a diagonal inertia tensor
+    DEMMeshConnected moved = mesh;
+    moved.Move(make_float3(1.5, -2., 0.7), QuatFromAxisAngle(normalize(make_float3(1, 2, 3)), 0.9));
+    MeshMassProperties moved_props = moved.ComputeMassProperties();
+    check("volume, moved", moved_props.volume, volume, rel_tol);
+    moved.InformCentroidPrincipal(moved_props.center, moved_props.principal_Q);
+    MeshMassProperties prin_props = moved.ComputeMassProperties();
+    double scale = moments.z;
+    check("center distance, principal frame", length(prin_props.center), 0., 1e-4);
+    check("Ixx, principal frame", prin_props.inertia[0], moments.x, rel_tol);
+    check("Iyy, principal frame", prin_props.inertia[1], moments.y, rel_tol);
+    check("Izz, principal frame", prin_props.inertia[2], moments.z, rel_tol);
+    check("|Ixy|+|Iyz|+|Izx| / Izz, principal",
+          (std::abs(prin_props.inertia[3]) + std::abs(prin_props.inertia[4]) + std::abs(prin_props.inertia[5])) / scale,
+          0., 1e-4);
+}
+
+int main() {
+    // Box: exact up to round-off
+    float hx = 0.5, hy = 1., hz = 1.5;
+    double box_vol = 8. * hx * hy * hz;
+    float3 box_moments = make_float3(box_vol / 3. * (hy * hy + hz * hz), box_vol / 3. * (hx * hx + hz * hz),
+                                     box_vol / 3. * (hx * hx + hy * hy));
+    std::sort(&box_moments.x, &box_moments.x + 3);
+    DEMMeshConnected box = makeBoxMesh(hx, hy, hz);
+    checkShape("Box", box, box_vol, box_moments, 1e-5);
+
+    // Cylinder with 1024 sides: the polygon area differs from the disk's by about (2 pi / 1024)^2 / 6
+    float radius = 0.8, height = 2.5;
+    double cyl_vol = PI * radius * radius * height;
+    float3 cyl_moments =
+        make_float3(cyl_vol * radius * radius / 2., cyl_vol * (3. * radius * radius + height * height) / 12.,
+                    cyl_vol * (3. * radius * radius + height * height) / 12.);
+    std::sort(&cyl_moments.x, &cyl_moments.x + 3);
+    checkShape("Cylinder", makeCylinderMesh(1024, radius, height), cyl_vol, cyl_moments, 2e-5);
+
+    // Sphere with 256 rings: all three moments are the same, so any principal frame is fine
+    double sph_vol = 4. / 3. * PI * radius * radius * radius;
+    double sph_moment = 0.4 * sph_vol * radius * radius;
+    checkShape("Sphere", makeSphereMesh(256, radius), sph_vol, make_float3(sph_moment), 2e-4);
+
+    // Broken boxes should give the exact box properties, and report the fix-ups
+    printf("Box, broken:\n");
+    {
+        DEMMeshConnected broken = unweld(box);
+        // Flip a facet, drop another (a hole), and make a degenerate one
+        std::swap(broken.m_face_v_indices[3].y, broken.m_face_v_indices[3].z);
+        broken.m_face_v_indices.erase(broken.m_face_v_indices.begin() + 7);
+        broken.m_face_v_indices.push_back(make_int3(0, 0, 1));
+        broken.nTri = broken.m_face_v_indices.size();
+        MeshMassProperties props = broken.ComputeMassProperties();
+        check("volume", props.volume, box_vol, 1e-5);
+        check("Ixx", props.inertia[0], box_vol / 3. * (hy * hy + hz * hz), 1e-5);
+        checkCount("watertight", props.watertight, 0);
+        checkCount("boundary edges", props.num_boundary_edges, 3);
+        checkCount("holes closed", props.num_holes_closed, 1);
+        checkCount("flipped facets", props.num_flipped_facets, 1);
+        checkCount("degenerate facets", props.num_degenerate_facets, 1);
+        checkCount("inverted shells", props.num_inverted_shells, 0);
+
+        // Inside out, as a whole
+        DEMMeshConnected inverted = box;
+        for (auto& f : inverted.m_face_v_indices)
+            std::swap(f.y, f.z);
+        props = inverted.ComputeMassProperties();
+        check("volume, inside out", props.volume, box_vol, 1e-5);
+        checkCount("inverted shells", props.num_inverted_shells, 1);
+    }
+
+    // Benchmark: a sphere of about 2M facets
+    printf("Benchmark:\n");
+    {
+        DEMMeshConnected fine = makeSphereMesh(1024, radius);
+        unsigned int max_threads = std::max(1u, std::thread::hardware_concurrency());
+        double ref_vol = 0.;
+        for (unsigned int threads : {1u, max_threads}) {
+            auto start = std::chrono::high_resolution_clock::now();
+            MeshMassProperties props = fine.ComputeMassProperties(threads);
+            double elapsed = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+            printf("  %zu facets, %2u threads: %8.3f ms, volume %.15g\n", fine.GetNumTriangles(), threads,
+                   elapsed * 1e3, props.volume);
+            if (threads == 1)
+                ref_vol = props.volume;
+        }
+        // Chunked summation: the same bits whatever the number of threads
+        checkCount("same result with all threads", fine.ComputeMassProperties(max_threads).volume == ref_vol, 1);
+    }
+
+    return checks.Finish("MeshMassProperties");
+}
@@ -0,0 +1,270 @@
+//  Copyright (c) 2021, SBEL GPU Development Team
+//  Copyright (c) 2021, University of Wisconsin - Madison
+//
+//	SPDX-License-Identifier: BSD-3-Clause
+
+// =============================================================================
+// A check of periodic boundaries. First, on the host, the periodic binning
+// helpers are checked against brute force: the bin ranges of a sphere sticking
+// out of a small period must list every bin it (or its image) needs, once, and
+// the bin a wrapped contact point falls in must be a bin both spheres of the
+// contact are listed in. Then a packing crowding the faces of a fully periodic
+// box is loaded into two solvers, detecting contacts on the GPU and on host
+// threads: both must report each pair of overlapping spheres (closest images
+// counted) exactly once. Last, two touching spheres are carried across the
+// period, and their contact must keep its history.
+// =============================================================================
+
+#include <DEM/API.h>
+#include <DEM/HostSideHelpers.hpp>
+
+#include "DemoChecks.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+#include <random>
+#include <set>
+#include <utility>
+#include <vector>
+
+using namespace deme;
+using namespace std::filesystem;
+
+using PairSet = std::set<std::pair<bodyID_t, bodyID_t>>;
+
+// Whether bin b (the interval [b, b + 1) in units of bin size) meets the interval [x0, x1], which may be empty
+bool binMeets(binID_t b, double x0, double x1) {
+    return x0 <= x1 && x1 >= (double)b && x0 < (double)b + 1.;
+}
+
+// The bins (as hostPeriodicSphereBinRanges1D gives them) a sphere is listed in, one entry per listing
+std::vector<binID_t> listedBins(double c, double r, binID_t nb, double start, double length) {
+    binID_t lo[2], hi[2];
+    unsigned int nRanges = hostPeriodicSphereBinRanges1D(lo, hi, c, r, nb, true, start, length);
+    std::vector<binID_t> bins;
+    for (unsigned int n = 0; n < nRanges; n++) {
+        for (binID_t b = lo[n]; b <= hi[n]; b++) {
+            bins.push_back(b);
+        }
+    }
+    return bins;
+}
+
+// Check the bin ranges of spheres near the ends of small periods (in units of bin size) against brute force
+void checkBinRanges(DemoChecks& checks, std::mt19937& rng) {
+    std::uniform_real_distribution<double> uni(0., 1.);
+    unsigned int num_merged = 0, num_split = 0, num_bad = 0;
+    for (unsigned int trial = 0; trial < 100000; trial++) {
+        // Periods from just over 4 radii up, starting anywhere in the first bin, not lined up with bins
+        const double r = 0.2 + 1.5 * uni(rng);
+        const double length = 4. * r * (1.01 + 1.5 * uni(rng));
+        const double start = uni(rng);
+        const binID_t nb = (binID_t)std::ceil(start + length);
+        const double c = start + length * uni(rng);
+        // Tell the cases where the image's range is merged into the sphere's own from those where it is kept apart
+        binID_t lo[2], hi[2], ownLo, ownHi;
+        unsigned int nRanges = hostPeriodicSphereBinRanges1D(lo, hi, c, r, nb, true, start, length);
+        hostSphereBinRange1D(ownLo, ownHi, c, r, nb);
+        if (nRanges == 2) {
+            num_split++;
+        } else if (lo[0] != ownLo || hi[0] != ownHi) {
+            num_merged++;
+        }
+        std::vector<binID_t> bins = listedBins(c, r, nb, start, length);
+        std::vector<binID_t> sorted = bins;
+        std::sort(sorted.begin(), sorted.end());
+        bool ok = std::adjacent_find(sorted.begin(), sorted.end()) == sorted.end();
+        for (binID_t b = 0; b < nb; b++) {
+            bool listed = std::binary_search(sorted.begin(), sorted.end(), b);
+            // Needed: the part of the bin inside the period meets the sphere or one of its images
+            bool needed = false, touched = false;
+            for (int k = -1; k <= 1; k++) {
+                const double x0 = c + k * length - r, x1 = c + k * length + r;
+                touched = touched || binMeets(b, x0, x1);
+                needed = needed || binMeets(b, std::max(x0, start), std::min(x1, start + length));
+            }
+            ok = ok && (!needed || listed) && (!listed || touched);
+        }
+        if (!ok) {
+            num_bad++;
+        }
+    }
+    printf("Bin ranges near small periods: %u merged, %u split in two, %u wrong\n", num_merged, num_split, num_bad);
+    checks.Check(num_bad == 0, "%u spheres near the ends of a period got wrong bin ranges", num_bad);
+    checks.Check(num_merged > 0 && num_split > 0, "The bin range checks did not cover both merged and split ranges");
+}
+
+// Check that the bin a contact across the period is reported from (that of its contact point, wrapped into the
+// period) is one both of its spheres are listed in, so the contact is found there, and only there
+void checkContactPointBins(DemoChecks& checks, std::mt19937& rng) {
+    std::uniform_real_distribution<double> uni(0., 1.);
+    unsigned int num_across = 0, num_bad = 0;
+    for (unsigned int trial = 0; trial < 100000; trial++) {
+        const double rA = 0.2 + 1.5 * uni(rng), rB = 0.2 + 1.5 * uni(rng);
+        const double length = 4. * std::max(rA, rB) * (1.01 + 1.5 * uni(rng));
+        const double start = uni(rng);
+        const binID_t nb = (binID_t)std::ceil(start + length);
+        // A anywhere in the period, and B touching it, wrapped into the period. The overlap goes up to the smaller
+        // radius, far deeper than a DEM contact gets, but not so deep that the contact point leaves the smaller sphere.
+        double A = start + length * uni(rng);
+        double B = A + ((uni(rng) < 0.5) ? 1. : -1.) * (rA + rB - std::min(rA, rB) * uni(rng));
+        hostWrapIntoPeriod(B, true, start, length);
+        // What the contact kernel does: B's closest image, the contact point, wrapped into the period
+        const double imageB = B + hostPeriodicImageShift(B - A, true, length);
+        if (imageB != B) {
+            num_across++;
+        }
+        const double dir = (A >= imageB) ? 1. : -1.;
+        const double overlap = rA + rB - std::abs(A - imageB);
+        double contactPnt = imageB + dir * (rB - overlap / 2.);
+        hostWrapIntoPeriod(contactPnt, true, start, length);
+        const binID_t bin = (binID_t)contactPnt;
+        std::vector<binID_t> binsA = listedBins(A, rA, nb, start, length);
+        std::vector<binID_t> binsB = listedBins(B, rB, nb, start, length);
+        if (std::count(binsA.begin(), binsA.end(), bin) != 1 || std::count(binsB.begin(), binsB.end(), bin) != 1) {
+            num_bad++;
+        }
+    }
+    printf("Contact points: %u of the contacts are across the period, %u in a wrong bin\n", num_across, num_bad);
+    checks.Check(num_bad == 0, "%u contact points fell in a bin their spheres are not both listed in", num_bad);
+}
+
+// Pairs of spheres whose closest images overlap, found by brute force
+PairSet bruteForceContacts(const std::vector<float3>& pos, float radius, float3 period) {
+    PairSet pairs;
+    for (size_t a = 0; a < pos.size(); a++) {
+        for (size_t b = a + 1; b < pos.size(); b++) {
+            float3 d = pos[a] - pos[b];
+            d.x -= period.x * std::round(d.x / period.x);
+            d.y -= period.y * std::round(d.y / period.y);
+            d.z -= period.z * std::round(d.z / period.z);
+            if (dot(d, d) < 4. * radius * radius)
+                pairs.emplace(a, b);
+        }
+    }
+    return pairs;
+}
+
+// Load the packing into a fully periodic box, run one step, and return the sphere contact pairs found at the first
+// contact detection, as many times as they are reported
+std::vector<std::pair<bodyID_t, bodyID_t>> solverContacts(const std::vector<float3>& pos,
+                                                          float radius,
+                                                          float3 period,
+                                                          bool on_host) {
+    DEMSolver DEMSim;
+    DEMSim.SetVerbosity("ERROR");
+    DEMSim.InstructBoxDomainDimension(period.x, period.y, period.z);
+    DEMSim.InstructBoxDomainPeriodic("XYZ");
+    DEMSim.SetGravitationalAcceleration(host_make_float3(0, 0, 0));
+    DEMSim.SetCDUpdateFreq(0);
+    DEMSim.UseAdaptiveUpdateFreq(false);
+    DEMSim.SetMaxVelocity(1.);
+    DEMSim.UseHostContactDetection(on_host);
+
+    auto mat = DEMSim.LoadMaterial({{"E", 1e8}, {"nu", 0.3}, {"CoR", 0.5}, {"mu", 0.3}, {"Crr", 0.0}});
+    auto sphere_type = DEMSim.LoadSphereType(1.f, radius, mat);
+    DEMSim.AddClumps(sphere_type, pos);
+
+    DEMSim.SetInitTimeStep(1e-6);
+    DEMSim.Initialize();
+    DEMSim.DoDynamicsThenSync(1e-6);
+
+    std::vector<std::pair<bodyID_t, bodyID_t>> pairs;
+    for (const auto& c : DEMSim.GetClumpContacts())
+        pairs.emplace_back(std::min(c.first, c.second), std::max(c.first, c.second));
+    return pairs;
+}
+
+void checkSolverContacts(DemoChecks& checks, std::mt19937& rng) {
+    // A small box, so that a good share of the spheres stick out of its faces, edges and corners
+    const float radius = 0.01;
+    const float3 period = host_make_float3(0.1, 0.12, 0.09);
+    std::uniform_real_distribution<float> uni(0.f, 1.f);
+    std::vector<float3> pos;
+    for (unsigned int n = 0; n < 120; n++) {
+        float3 p;
+        p.x = period.x * (uni(rng) - 0.5f);
+        p.y = period.y * (uni(rng) - 0.5f);
+        p.z = period.z * (uni(rng) - 0.5f);
+        pos.push_back(p);
+    }
+    PairSet reference = bruteForceContacts(pos, radius, period);
+    size_t num_across = 0;
+    for (const auto& c : reference) {
+        float3 d = pos[c.first] - pos[c.second];
+        num_across += (std::abs(d.x) > period.x / 2. || std::abs(d.y) > period.y / 2. || std::abs(d.z) > period.z / 2.);
+    }
+    for (bool on_host : {false, true}) {
+        auto pairs = solverContacts(pos, radius, period, on_host);
+        std::sort(pairs.begin(), pairs.end());
+        size_t num_duplicated = 0;
+        for (size_t n = 1; n < pairs.size(); n++)
+            num_duplicated += (pairs[n] == pairs[n - 1]);
+        PairSet found(pairs.begin(), pairs.end());
+        size_t num_missed = 0;
+        for (const auto& c : reference)
+            num_missed += found.count(c) ? 0 : 1;
+        printf("%s: %zu overlapping pairs (%zu across the period), %zu pairs found, %zu missed, %zu duplicated\n",
+               on_host ? "Host contact detection" : "GPU contact detection", reference.size(), num_across,
+               found.size(), num_missed, num_duplicated);
+        checks.Check(num_missed == 0, "  Overlapping pairs were missed");
+        checks.Check(num_duplicated == 0, "  Pairs were reported more than once");
+    }
+}
+
+// Two touching spheres carried across the period at a constant velocity must keep their contact, and its history
+void checkContactHistory(DemoChecks& checks) {
+    DEMSolver DEMSim;
+    DEMSim.SetVerbosity("ERROR");
+    DEMSim.InstructBoxDomainDimension(0.2, 0.2, 0.2);
+    DEMSim.InstructBoxDomainPeriodic("X");
+    DEMSim.SetGravitationalAcceleration(host_make_float3(0, 0, 0));
+    DEMSim.EnableContactWildcardOutput();
+
+    const float radius = 0.01;
+    auto mat = DEMSim.LoadMaterial({{"E", 1e8}, {"nu", 0.3}, {"CoR", 0.5}, {"mu", 0.3}, {"Crr", 0.0}});
+    auto sphere_type = DEMSim.LoadSphereType(1e-2, radius, mat);
+    // Slightly overlapping, and close to the end of the period
+    std::vector<float3> pos = {host_make_float3(0.07, 0, 0), host_make_float3(0.07 + 1.9 * radius, 0, 0)};
+    auto pair = DEMSim.AddClumps(sphere_type, pos);
+    pair->SetFamily(1);
+    DEMSim.SetFamilyPrescribedLinVel(1, "0.5", "0", "0");
+    DEMSim.SetFamilyPrescribedAngVel(1, "0", "0", "0");
+    auto tracker = DEMSim.Track(pair);
+
+    DEMSim.SetInitTimeStep(1e-5);
+    DEMSim.SetMaxVelocity(1.);
+    DEMSim.Initialize();
+
+    // At 0.5 m/s, they cross the 0.2 m period about every 0.4 s
+    const double duration = 1.;
+    unsigned int num_lost = 0;
+    for (unsigned int i = 0; i < 100; i++) {
+        DEMSim.DoDynamicsThenSync(duration / 100.);
+        num_lost += DEMSim.GetClumpContacts().size() != 1;
+    }
+    float3 lead = tracker->Pos(1);
+    path out_dir = current_path();
+    out_dir += "/DemoOutput_PeriodicBoundary";
+    create_directory(out_dir);
+    std::string cnt_file = std::string(out_dir) + "/contacts.csv";
+    DEMSim.WriteContactFile(cnt_file);
+    auto wildcards = DEMSolver::ReadContactWildcardsFromCsv(cnt_file);
+    const float contact_time = (wildcards["delta_time"].size() == 1) ? wildcards["delta_time"][0] : 0.f;
+    printf("After %g s, the leading sphere is at x = %g; the contact was lost %u times, and has lasted %g s\n",
+           DEMSim.GetSimTime(), lead.x, num_lost, contact_time);
+    checks.Check(num_lost == 0, "  The contact of the spheres was lost while they crossed the period");
+    checks.Check(std::abs(contact_time - duration) < 0.05 * duration, "  The contact history was not kept");
+}
+
+int main() {
+    std::mt19937 rng(11);
+    DemoChecks checks;
+    checkBinRanges(checks, rng);
+    checkContactPointBins(checks, rng);
+    checkSolverContacts(checks, rng);
+    checkContactHistory(checks);
+    return checks.Finish("PeriodicBoundary");
+}
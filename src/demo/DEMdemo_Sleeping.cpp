@@ -0,0 +1,115 @@
+//  Copyright (c) 2021, SBEL GPU Development Team
+//  Copyright (c) 2021, University of Wisconsin - Madison
+//
+//	SPDX-License-Identifier: BSD-3-Clause
+
+// =============================================================================
+// A demo of sleeping owners. A bed of spheres resting on the floor is checked to
+// fall asleep. Setting an owner's velocity or family through the API is checked
+// to wake that owner up, and only that owner. Then a sphere is dropped onto one
+// sphere of the bed, and the rest of the bed is checked to have stayed asleep
+// (not moved at all) while the sphere that was hit woke up.
+// =============================================================================
+
+#include <core/ApiVersion.h>
+#include <core/utils/ThreadManager.h>
+#include <DEM/API.h>
+#include <DEM/HostSideHelpers.hpp>
+
+#include "DemoChecks.hpp"
+
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+using namespace deme;
+
+int main() {
+    DEMSolver DEMSim;
+    DEMSim.SetVerbosity(INFO);
+
+    auto mat = DEMSim.LoadMaterial({{"E", 1e7}, {"nu", 0.3}, {"CoR", 0.2}, {"mu", 0.5}, {"Crr", 0.01}});
+
+    float world_size = 0.4;
+    DEMSim.InstructBoxDomainDimension(world_size, world_size, world_size);
+    DEMSim.InstructBoxDomainBoundingBC("all", mat);
+    float floor_z = -world_size / 2.;
+
+    float radius = 0.01;
+    auto sphere_type = DEMSim.LoadSphereType(2.6e3 * 4. / 3. * PI * std::pow(radius, 3), radius, mat);
+
+    // A single layer of spheres resting on the floor, with gaps between them so each one only touches the floor
+    const int n_side = 8;
+    const float spacing = 3. * radius;
+    std::vector<float3> bed_xyz;
+    for (int i = 0; i < n_side; i++) {
+        for (int j = 0; j < n_side; j++) {
+            bed_xyz.push_back(make_float3((i - n_side / 2) * spacing, (j - n_side / 2) * spacing, floor_z + radius));
+        }
+    }
+    const size_t n_bed = bed_xyz.size();
+    auto bed = DEMSim.AddClumps(sphere_type, bed_xyz);
+    auto bed_tracker = DEMSim.Track(bed);
+
+    // The impactor is held still above one sphere of the bed until it is released
+    const size_t hit = (n_side / 2) * n_side + n_side / 2;
+    float3 impactor_xyz = bed_xyz[hit];
+    impactor_xyz.z += 5. * radius;
+    auto impactor = DEMSim.AddClumps(sphere_type, impactor_xyz);
+    impactor->SetFamily(1);
+    DEMSim.SetFamilyFixed(1);
+
+    DEMSim.SetInitTimeStep(1e-5);
+    DEMSim.SetGravitationalAcceleration(make_float3(0, 0, -9.81));
+    DEMSim.SetMaxVelocity(5.);
+    // Asleep after 1000 quiescent steps, that is 0.01 s
+    DEMSim.EnableSleeping(1e-3, 1e-2, 1000);
+    DEMSim.Initialize();
+
+    DemoChecks checks;
+
+    // The bed settles and falls asleep; the impactor never sleeps, as its family is fixed
+    DEMSim.DoDynamics(0.5);
+    printf("After settling, %zu of %zu bed spheres are asleep\n", DEMSim.GetNumSleepingOwners(), n_bed);
+    checks.Check(DEMSim.GetNumSleepingOwners() == n_bed, "The settled bed did not fall asleep");
+
+    // Setting a velocity wakes that owner up, even if the velocity is zero
+    size_t n_asleep = DEMSim.GetNumSleepingOwners();
+    DEMSim.SetOwnerVelocity(bed_tracker->GetOwnerID(0), make_float3(0, 0, 0));
+    checks.Check(DEMSim.GetNumSleepingOwners() == n_asleep - 1, "SetOwnerVelocity left %zu of %zu owners asleep",
+                 DEMSim.GetNumSleepingOwners(), n_asleep);
+
+    // So does changing its family
+    n_asleep = DEMSim.GetNumSleepingOwners();
+    DEMSim.SetOwnerFamily(bed_tracker->GetOwnerID(n_bed - 1), 2);
+    checks.Check(DEMSim.GetNumSleepingOwners() == n_asleep - 1, "SetOwnerFamily left %zu of %zu owners asleep",
+                 DEMSim.GetNumSleepingOwners(), n_asleep);
+
+    // Still at rest, the owners that were woken up fall asleep again
+    DEMSim.DoDynamics(0.1);
+    checks.Check(DEMSim.GetNumSleepingOwners() == n_bed, "Woken owners did not fall asleep again: %zu of %zu asleep",
+                 DEMSim.GetNumSleepingOwners(), n_bed);
+
+    // Drop the impactor. The sphere it hits wakes up; the rest of the bed does not move at all.
+    std::vector<float3> bed_pos_before(n_bed);
+    for (size_t i = 0; i < n_bed; i++) {
+        bed_pos_before[i] = bed_tracker->Pos(i);
+    }
+    DEMSim.ChangeFamily(1, 0);
+    DEMSim.DoDynamics(0.15);
+    printf("After the impact, %zu of %zu bed spheres are asleep\n", DEMSim.GetNumSleepingOwners(), n_bed);
+    unsigned int num_moved = 0;
+    for (size_t i = 0; i < n_bed; i++) {
+        float3 pos = bed_tracker->Pos(i);
+        bool moved = (pos.x != bed_pos_before[i].x || pos.y != bed_pos_before[i].y || pos.z != bed_pos_before[i].z);
+        if (i == hit) {
+            checks.Check(moved, "The sphere that was hit did not wake up");
+        } else if (moved) {
+            num_moved++;
+        }
+    }
+    checks.Check(num_moved == 0, "%u bed spheres the impactor did not touch moved", num_moved);
+
+    DEMSim.ShowTimingStats();
+    return checks.Finish("Sleeping");
+}
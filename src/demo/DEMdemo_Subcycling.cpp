@@ -0,0 +1,83 @@
+//  Copyright (c) 2021, SBEL GPU Development Team
+//  Copyright (c) 2021, University of Wisconsin - Madison
+//
+//	SPDX-License-Identifier: BSD-3-Clause
+
+// =============================================================================
+// A demo of subcycling. Large, soft spheres and small, stiff spheres are dropped
+// into a box together. The time step size suits the large spheres, and the small
+// spheres (in their own family) take 8 substeps per time step. The simulation
+// is checked to stay stable: nothing escapes through the floor and the spheres
+// come to rest.
+// =============================================================================
+
+#include <core/ApiVersion.h>
+#include <core/utils/ThreadManager.h>
+#include <DEM/API.h>
+#include <DEM/HostSideHelpers.hpp>
+#include <DEM/utils/Samplers.hpp>
+
+#include "DemoChecks.hpp"
+
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+#include <vector>
+
+using namespace deme;
+
+int main() {
+    DEMSolver DEMSim;
+    DEMSim.SetVerbosity(INFO);
+    DEMSim.SetOutputFormat(OUTPUT_FORMAT::CSV);
+    DEMSim.SetOutputContent({"ABSV"});
+
+    auto mat_soft = DEMSim.LoadMaterial({{"E", 1e7}, {"nu", 0.3}, {"CoR", 0.5}, {"mu", 0.4}, {"Crr", 0.01}});
+    auto mat_stiff = DEMSim.LoadMaterial({{"E", 1e9}, {"nu", 0.3}, {"CoR", 0.5}, {"mu", 0.4}, {"Crr", 0.01}});
+
+    float world_size = 0.2;
+    DEMSim.InstructBoxDomainDimension(world_size, world_size, world_size);
+    DEMSim.InstructBoxDomainBoundingBC("all", mat_stiff);
+
+    float large_radius = 0.01, small_radius = 0.003;
+    auto large_type = DEMSim.LoadSphereType(2.6e3 * 4. / 3. * PI * std::pow(large_radius, 3), large_radius, mat_soft);
+    auto small_type = DEMSim.LoadSphereType(2.6e3 * 4. / 3. * PI * std::pow(small_radius, 3), small_radius, mat_stiff);
+
+    // Small spheres in a layer under the large ones
+    HCPSampler small_sampler(2.2 * small_radius);
+    auto small_xyz = small_sampler.SampleBox(
+        make_float3(0, 0, -world_size / 4.),
+        make_float3(world_size / 2. - 2 * small_radius, world_size / 2. - 2 * small_radius, world_size / 16.));
+    auto small_particles = DEMSim.AddClumps(small_type, small_xyz);
+    small_particles->SetFamily(1);
+    HCPSampler large_sampler(2.2 * large_radius);
+    auto large_xyz = large_sampler.SampleBox(
+        make_float3(0, 0, world_size / 8.),
+        make_float3(world_size / 2. - 2 * large_radius, world_size / 2. - 2 * large_radius, world_size / 8.));
+    DEMSim.AddClumps(large_type, large_xyz);
+    std::cout << "Total num of particles: " << small_xyz.size() + large_xyz.size() << " (" << small_xyz.size()
+              << " subcycled)" << std::endl;
+
+    // Without subcycling, the stiff spheres would need a time step size about 8 times smaller
+    DEMSim.SetFamilySubsteps(1, 8);
+    DEMSim.SetInitTimeStep(2e-5);
+    DEMSim.SetGravitationalAcceleration(make_float3(0, 0, -9.81));
+    DEMSim.SetMaxVelocity(10.);
+    DEMSim.Initialize();
+
+    float frame_time = 0.05;
+    auto max_v_finder = DEMSim.CreateInspector("clump_max_absv");
+    auto min_z_finder = DEMSim.CreateInspector("clump_min_z");
+    for (int i = 0; i < 30; i++) {
+        DEMSim.DoDynamics(frame_time);
+        printf("Time %.3f, max velocity %.4g, lowest sphere at %.4g\n", DEMSim.GetSimTime(), max_v_finder->GetValue(),
+               min_z_finder->GetValue());
+    }
+    DEMSim.ShowTimingStats();
+
+    DemoChecks checks;
+    checks.Check(min_z_finder->GetValue() >= -world_size / 2. - small_radius, "Spheres escaped through the floor");
+    checks.Check(max_v_finder->GetValue() <= 0.1, "Spheres did not come to rest");
+
+    return checks.Finish("Subcycling");
+}
@@ -0,0 +1,62 @@
+//  Copyright (c) 2021, SBEL GPU Development Team
+//  Copyright (c) 2021, University of Wisconsin - Madison
+//
+//	SPDX-License-Identifier: BSD-3-Clause
+
+// =============================================================================
+// Bookkeeping shared by the demos that check their own results: failed checks
+// are printed as they happen and counted, and the demo exits with an error if
+// any of them failed.
+// =============================================================================
+
+#ifndef DEME_DEMO_CHECKS_HPP
+#define DEME_DEMO_CHECKS_HPP
+
+#include <cstdarg>
+#include <cstdio>
+#include <iostream>
+#include <string>
+
+namespace deme {
+
+class DemoChecks {
+  public:
+    /// Count one check. If it failed, print the message (printf-style), marked as FAILED. Returns ok.
+    bool Check(bool ok, const char* fmt, ...) {
+        if (!ok) {
+            va_list args;
+            va_start(args, fmt);
+            vprintf(fmt, args);
+            va_end(args);
+            printf("  FAILED\n");
+            m_num_failed++;
+        }
+        return ok;
+    }
+
+    /// Count one check whose outcome the caller has printed already. Returns ok.
+    bool Record(bool ok) {
+        if (!ok) {
+            m_num_failed++;
+        }
+        return ok;
+    }
+
+    unsigned int NumFailed() const { return m_num_failed; }
+
+    /// Report the failed checks, and return the exit code of the demo
+    int Finish(const std::string& demo_name) const {
+        if (m_num_failed > 0) {
+            std::cout << m_num_failed << " checks FAILED" << std::endl;
+        }
+        std::cout << demo_name << " demo exiting..." << std::endl;
+        return m_num_failed > 0;
+    }
+
+  private:
+    unsigned int m_num_failed = 0;
+};
+
+}  // namespace deme
+
+#endif
@@ -47,25 +47,47 @@ __global__ void getNumberOfBinsEachSphereTouches(deme::DEMSimParams* simParams,
                 myPosXYZ = ownerXYZ + to_double3(myRelPos);
             }
 
+            // With hierarchical binning, a sphere is binned in the level that suits its size. The level is recorded
+            // so the other binning kernels need not work it out again.
+            const unsigned int myLevel = sphereBinLevel(simParams, myRadius);
+            granData->sphereBinLevel[sphereID] = myLevel;
+            const double myBinSize = binSizeAtLevel(simParams, myLevel);
             deme::binsSphereTouches_t numX, numY, numZ;
             {
                 // The bin number that I live in (with fractions)?
-                double myBinX = myPosXYZ.x / simParams->binSize;
-                double myBinY = myPosXYZ.y / simParams->binSize;
-                double myBinZ = myPosXYZ.z / simParams->binSize;
+                double myBinX = myPosXYZ.x / myBinSize;
+                double myBinY = myPosXYZ.y / myBinSize;
+                double myBinZ = myPosXYZ.z / myBinSize;
                 // How many bins my radius spans (with fractions)?
-                double myRadiusSpan = myRadius / simParams->binSize;
+                double myRadiusSpan = myRadius / myBinSize;
                 // printf("myRadius: %f\n", myRadiusSpan);
                 // Now, figure out how many bins I touch in each direction
-                numX = ((myBinX + myRadiusSpan < (double)simParams->nbX) ? (unsigned int)(myBinX + myRadiusSpan)
-                                                                         : (unsigned int)simParams->nbX - 1) -
-                       (unsigned int)((myBinX - myRadiusSpan > 0.0) ? myBinX - myRadiusSpan : 0.0) + 1;
-                numY = ((myBinY + myRadiusSpan < (double)simParams->nbY) ? (unsigned int)(myBinY + myRadiusSpan)
-                                                                         : (unsigned int)simParams->nbY - 1) -
-                       (unsigned int)((myBinY - myRadiusSpan > 0.0) ? myBinY - myRadiusSpan : 0.0) + 1;
-                numZ = ((myBinZ + myRadiusSpan < (double)simParams->nbZ) ? (unsigned int)(myBinZ + myRadiusSpan)
-                                                                         : (unsigned int)simParams->nbZ - 1) -
-                       (unsigned int)((myBinZ - myRadiusSpan > 0.0) ? myBinZ - myRadiusSpan : 0.0) + 1;
+                const deme::binID_t nbX = simParams->nbXLevel[myLevel];
+                const deme::binID_t nbY = simParams->nbYLevel[myLevel];
+                const deme::binID_t nbZ = simParams->nbZLevel[myLevel];
+                // In a periodic direction, the bins my image at the other end of the period touches count too
+                deme::binID_t lo[2], hi[2];
+                unsigned int nRanges = periodicSphereBinRanges1D<deme::binID_t>(
+                    lo, hi, myBinX, myRadiusSpan, nbX, simParams->periodicX, simParams->periodStartX / myBinSize,
+                    simParams->periodX / myBinSize);
+                numX = 0;
+                for (unsigned int r = 0; r < nRanges; r++) {
+                    numX += hi[r] - lo[r] + 1;
+                }
+                nRanges = periodicSphereBinRanges1D<deme::binID_t>(
+                    lo, hi, myBinY, myRadiusSpan, nbY, simParams->periodicY, simParams->periodStartY / myBinSize,
+                    simParams->periodY / myBinSize);
+                numY = 0;
+                for (unsigned int r = 0; r < nRanges; r++) {
+                    numY += hi[r] - lo[r] + 1;
+                }
+                nRanges = periodicSphereBinRanges1D<deme::binID_t>(
+                    lo, hi, myBinZ, myRadiusSpan, nbZ, simParams->periodicZ, simParams->periodStartZ / myBinSize,
+                    simParams->periodZ / myBinSize);
+                numZ = 0;
+                for (unsigned int r = 0; r < nRanges; r++) {
+                    numZ += hi[r] - lo[r] + 1;
+                }
                 //// TODO: Add an error message if numX * numY * numZ > MAX(binsSphereTouches_t)
             }
 
@@ -177,28 +199,48 @@ __global__ void populateBinSphereTouchingPairs(deme::DEMSimParams* simParams,
                 myPosXYZ = ownerXYZ + to_double3(myRelPos);
             }
 
+            // The level of bins I am binned in, as getNumberOfBinsEachSphereTouches decided
+            const unsigned int myLevel = granData->sphereBinLevel[sphereID];
+            const double myBinSize = binSizeAtLevel(simParams, myLevel);
+            const deme::binID_t nbX = simParams->nbXLevel[myLevel];
+            const deme::binID_t nbY = simParams->nbYLevel[myLevel];
+            const deme::binID_t nbZ = simParams->nbZLevel[myLevel];
             // The bin number that I live in (with fractions)?
-            double myBinX = myPosXYZ.x / simParams->binSize;
-            double myBinY = myPosXYZ.y / simParams->binSize;
-            double myBinZ = myPosXYZ.z / simParams->binSize;
+            double myBinX = myPosXYZ.x / myBinSize;
+            double myBinY = myPosXYZ.y / myBinSize;
+            double myBinZ = myPosXYZ.z / myBinSize;
             // How many bins my radius spans (with fractions)?
-            double myRadiusSpan = myRadius / simParams->binSize;
+            double myRadiusSpan = myRadius / myBinSize;
+            // The ranges of bins I touch in each direction (2 of them if my periodic image touches bins too)
+            deme::binID_t loX[2], hiX[2], loY[2], hiY[2], loZ[2], hiZ[2];
+            const unsigned int nRangesX = periodicSphereBinRanges1D<deme::binID_t>(
+                loX, hiX, myBinX, myRadiusSpan, nbX, simParams->periodicX, simParams->periodStartX / myBinSize,
+                simParams->periodX / myBinSize);
+            const unsigned int nRangesY = periodicSphereBinRanges1D<deme::binID_t>(
+                loY, hiY, myBinY, myRadiusSpan, nbY, simParams->periodicY, simParams->periodStartY / myBinSize,
+                simParams->periodY / myBinSize);
+            const unsigned int nRangesZ = periodicSphereBinRanges1D<deme::binID_t>(
+                loZ, hiZ, myBinZ, myRadiusSpan, nbZ, simParams->periodicZ, simParams->periodStartZ / myBinSize,
+                simParams->periodZ / myBinSize);
             // Now, write the IDs of those bins that I touch, back to the global memory
             deme::binID_t thisBinID;
-            for (deme::binID_t k = (deme::binID_t)((myBinZ - myRadiusSpan > 0.0) ? myBinZ - myRadiusSpan : 0.0);
-                 (k <= (deme::binID_t)(myBinZ + myRadiusSpan)) && (k < simParams->nbZ); k++) {
-                for (deme::binID_t j = (deme::binID_t)((myBinY - myRadiusSpan > 0.0) ? myBinY - myRadiusSpan : 0.0);
-                     (j <= (deme::binID_t)(myBinY + myRadiusSpan)) && (j < simParams->nbY); j++) {
-                    for (deme::binID_t i = (deme::binID_t)((myBinX - myRadiusSpan > 0.0) ? myBinX - myRadiusSpan : 0.0);
-                         (i <= (deme::binID_t)(myBinX + myRadiusSpan)) && (i < simParams->nbX); i++) {
-                        if (myReportOffset >= myReportOffset_end) {
-                            continue;  // No stepping on the next one's domain
+            for (unsigned int rz = 0; rz < nRangesZ; rz++) {
+                for (deme::binID_t k = loZ[rz]; k <= hiZ[rz]; k++) {
+                    for (unsigned int ry = 0; ry < nRangesY; ry++) {
+                        for (deme::binID_t j = loY[ry]; j <= hiY[ry]; j++) {
+                            for (unsigned int rx = 0; rx < nRangesX; rx++) {
+                                for (deme::binID_t i = loX[rx]; i <= hiX[rx]; i++) {
+                                    if (myReportOffset >= myReportOffset_end) {
+                                        continue;  // No stepping on the next one's domain
+                                    }
+                                    thisBinID = simParams->binLevelOffset[myLevel] +
+                                                binIDFrom3Indices<deme::binID_t>(i, j, k, nbX, nbY, nbZ);
+                                    binIDsEachSphereTouches[myReportOffset] = thisBinID;
+                                    sphereIDsEachBinTouches[myReportOffset] = sphereID;
+                                    myReportOffset++;
+                                }
+                            }
                         }
-                        thisBinID =
-                            binIDFrom3Indices<deme::binID_t>(i, j, k, simParams->nbX, simParams->nbY, simParams->nbZ);
-                        binIDsEachSphereTouches[myReportOffset] = thisBinID;
-                        sphereIDsEachBinTouches[myReportOffset] = sphereID;
-                        myReportOffset++;
                     }
                 }
             }
@@ -275,3 +317,135 @@ __global__ void populateBinSphereTouchingPairs(deme::DEMSimParams* simParams,
         }
     }
 }
+
+// For incremental binning: find the lowest and highest bins each sphere touches now, and compare them against the ones
+// recorded at the last binning. A sphere whose range of bins changed is to be re-binned, and its entry in
+// numBinsRebinnedSphereTouches is the number of bins it touches (at least 1); for the other spheres it is 0. Then the
+// new ranges are recorded.
+__global__ void markSpheresToRebin(deme::DEMSimParams* simParams,
+                                   deme::DEMDataKT* granData,
+                                   deme::binsSphereTouches_t* numBinsSphereTouches,
+                                   deme::binsSphereTouches_t* numBinsRebinnedSphereTouches,
+                                   deme::binID_t* sphereBinLo,
+                                   deme::binID_t* sphereBinHi,
+                                   size_t* pNumRebinned) {
+    deme::bodyID_t sphereID = blockIdx.x * blockDim.x + threadIdx.x;
+    if (sphereID < simParams->nSpheresGM) {
+        double3 myPosXYZ;
+        double myRadius;
+        {
+            deme::bodyID_t myOwnerID = granData->ownerClumpBody[sphereID];
+            float3 myRelPos;
+            double3 ownerXYZ;
+            // Outputs myRelPos, myRadius (in CD kernels, radius needs to be expanded)
+            {
+                _componentAcqStrat_;
+                myRadius += granData->marginSize[myOwnerID];
+            }
+            voxelIDToPosition<double, deme::voxelID_t, deme::subVoxelPos_t>(
+                ownerXYZ.x, ownerXYZ.y, ownerXYZ.z, granData->voxelID[myOwnerID], granData->locX[myOwnerID],
+                granData->locY[myOwnerID], granData->locZ[myOwnerID], _nvXp2_, _nvYp2_, _voxelSize_, _l_);
+            const float myOriQw = granData->oriQw[myOwnerID];
+            const float myOriQx = granData->oriQx[myOwnerID];
+            const float myOriQy = granData->oriQy[myOwnerID];
+            const float myOriQz = granData->oriQz[myOwnerID];
+            applyOriQToVector3<float, deme::oriQ_t>(myRelPos.x, myRelPos.y, myRelPos.z, myOriQw, myOriQx, myOriQy,
+                                                    myOriQz);
+            myPosXYZ = ownerXYZ + to_double3(myRelPos);
+        }
+        // The range is taken in the level the sphere is binned in, and a change of level changes the bin IDs too
+        const unsigned int myLevel = granData->sphereBinLevel[sphereID];
+        const double myBinSize = binSizeAtLevel(simParams, myLevel);
+        const deme::binID_t nbX = simParams->nbXLevel[myLevel];
+        const deme::binID_t nbY = simParams->nbYLevel[myLevel];
+        const deme::binID_t nbZ = simParams->nbZLevel[myLevel];
+        double myRadiusSpan = myRadius / myBinSize;
+        deme::binID_t loX, hiX, loY, hiY, loZ, hiZ;
+        sphereBinRange1D<deme::binID_t>(loX, hiX, myPosXYZ.x / myBinSize, myRadiusSpan, nbX);
+        sphereBinRange1D<deme::binID_t>(loY, hiY, myPosXYZ.y / myBinSize, myRadiusSpan, nbY);
+        sphereBinRange1D<deme::binID_t>(loZ, hiZ, myPosXYZ.z / myBinSize, myRadiusSpan, nbZ);
+        deme::binID_t myBinLo =
+            simParams->binLevelOffset[myLevel] + binIDFrom3Indices<deme::binID_t>(loX, loY, loZ, nbX, nbY, nbZ);
+        deme::binID_t myBinHi =
+            simParams->binLevelOffset[myLevel] + binIDFrom3Indices<deme::binID_t>(hiX, hiY, hiZ, nbX, nbY, nbZ);
+
+        if (myBinLo != sphereBinLo[sphereID] || myBinHi != sphereBinHi[sphereID]) {
+            sphereBinLo[sphereID] = myBinLo;
+            sphereBinHi[sphereID] = myBinHi;
+            numBinsRebinnedSphereTouches[sphereID] = numBinsSphereTouches[sphereID];
+            atomicAdd((unsigned long long*)pNumRebinned, 1ULL);
+        } else {
+            numBinsRebinnedSphereTouches[sphereID] = 0;
+        }
+    }
+}
+
+// For incremental binning: a recorded bin--sphere pair is kept if its sphere is not re-binned
+__global__ void markKeptBinSpherePairs(deme::bodyID_t* sphereIDs,
+                                       deme::binsSphereTouches_t* numBinsRebinnedSphereTouches,
+                                       deme::notStupidBool_t* keep,
+                                       size_t n) {
+    size_t myID = blockIdx.x * blockDim.x + threadIdx.x;
+    if (myID < n) {
+        keep[myID] = (numBinsRebinnedSphereTouches[sphereIDs[myID]] == 0) ? 1 : 0;
+    }
+}
+
+// For incremental binning: merge the kept recorded pairs and the (sorted) pairs of the re-binned spheres into one list
+// sorted by bin ID then sphere ID. Each pair finds its place by counting the pairs of the other list that come before
+// it, so no two pairs land on the same spot: a sphere's pairs are all in one list or all in the other.
+__global__ void mergeBinSpherePairs(deme::binID_t* oldBinIDs,
+                                    deme::bodyID_t* oldSphereIDs,
+                                    deme::notStupidBool_t* keep,
+                                    deme::binSphereTouchPairs_t* keptScan,
+                                    size_t nOld,
+                                    deme::binID_t* newBinIDs,
+                                    deme::bodyID_t* newSphereIDs,
+                                    size_t nNew,
+                                    deme::binID_t* binIDs,
+                                    deme::bodyID_t* sphereIDs) {
+    size_t myID = blockIdx.x * blockDim.x + threadIdx.x;
+    if (myID < nOld) {
+        if (keep[myID]) {
+            const deme::binID_t myBin = oldBinIDs[myID];
+            const deme::bodyID_t mySphere = oldSphereIDs[myID];
+            size_t myPlace = keptScan[myID] + countBinSpherePairsBefore<deme::binID_t, deme::bodyID_t>(
+                                                  newBinIDs, newSphereIDs, nNew, myBin, mySphere);
+            binIDs[myPlace] = myBin;
+            sphereIDs[myPlace] = mySphere;
+        }
+    } else if (myID < nOld + nNew) {
+        const size_t myNewID = myID - nOld;
+        const deme::binID_t myBin = newBinIDs[myNewID];
+        const deme::bodyID_t mySphere = newSphereIDs[myNewID];
+        // keptScan has nOld + 1 entries, so the count of the kept ones before any spot in the old list is there
+        size_t myPlace = myNewID + keptScan[countBinSpherePairsBefore<deme::binID_t, deme::bodyID_t>(
+                                       oldBinIDs, oldSphereIDs, nOld, myBin, mySphere)];
+        binIDs[myPlace] = myBin;
+        sphereIDs[myPlace] = mySphere;
+    }
+}
+
+// Extent of each owner (max distance from its CoM to any point of its geometries), for checking how far an owner's
+// spheres may have moved since the contact candidates were found. The extent array must be zeroed before this.
+__global__ void computeSphereOwnerExtents(deme::DEMSimParams* simParams, deme::DEMDataKT* granData) {
+    deme::bodyID_t sphereID = blockIdx.x * blockDim.x + threadIdx.x;
+    if (sphereID < simParams->nSpheresGM) {
+        deme::bodyID_t myOwnerID = granData->ownerClumpBody[sphereID];
+        float3 myRelPos;
+        float myRadius;
+        // Outputs myRelPos, myRadius (not expanded by the margin here)
+        { _componentAcqStrat_; }
+        float myExtent = length(myRelPos) + myRadius;
+        // For non-negative floats, the order of their bit patterns as ints is their order
+        atomicMax((int*)(granData->verletOwnerExtent + myOwnerID), __float_as_int(myExtent));
+    }
+}
+
+// An analytical object can be infinitely large, so any rotation of its owner may move it by any amount
+__global__ void markAnalOwnerExtents(deme::DEMSimParams* simParams, deme::DEMDataKT* granData) {
+    deme::objID_t objID = blockIdx.x * blockDim.x + threadIdx.x;
+    if (objID < simParams->nAnalGM) {
+        granData->verletOwnerExtent[objOwner[objID]] = DEME_HUGE_FLOAT;
+    }
+}
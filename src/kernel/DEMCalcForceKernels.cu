@@ -38,227 +38,358 @@ inline __device__ void equipOwnerPosRot(deme::DEMSimParams* simParams,
     bodyPos.z = ownerPos.z + (double)relPos.z;
 }
 
-__global__ void calculateContactForces(deme::DEMSimParams* simParams, deme::DEMDataDT* granData, size_t nContactPairs) {
-    deme::contactPairs_t myContactID = blockIdx.x * blockDim.x + threadIdx.x;
-    if (myContactID < nContactPairs) {
-        // Identify contact type first
-        deme::contact_t myContactType = granData->contactType[myContactID];
-        // The following quantities are always calculated, regardless of force model
-        double3 contactPnt;
-        float3 B2A;  // Unit vector pointing from body B to body A (contact normal)
-        double overlapDepth;
-        double3 AOwnerPos, bodyAPos, BOwnerPos, bodyBPos;
-        float AOwnerMass, ARadius, BOwnerMass, BRadius;
-        float4 AOriQ, BOriQ;
-        deme::materialsOffset_t bodyAMatType, bodyBMatType;
-        // The user-specified extra margin size (how much we should be lenient in determining `in-contact')
-        float extraMarginSize = 0.;
-        // Then allocate the optional quantities that will be needed in the force model (note: this one can't be in a
-        // curly bracket, obviously...)
-        _forceModelIngredientDefinition_;
-        // Take care of 2 bodies in order, bodyA first, grab location and velocity to local cache
-        // We know in this kernel, bodyA will be a sphere; B can be something else
+// Calculate the force of one contact. With subcycling, the contacts that involve subcycled families are calculated
+// only in the subcycled pass (subcycledPass is true), whose simParams->h is the substep size.
+// If CNT_TYPE is not NOT_A_CONTACT, it is the type of all contacts this is called for. Then the type is known at
+// compile time, and the branches on it below are resolved by the compiler.
+template <deme::contact_t CNT_TYPE = deme::NOT_A_CONTACT>
+inline __device__ void calculateContactForce(deme::DEMSimParams* simParams,
+                                             deme::DEMDataDT* granData,
+                                             deme::contactPairs_t myContactID,
+                                             bool subcycledPass) {
+    // Identify contact type first
+    const deme::contact_t listedContactType =
+        (CNT_TYPE == deme::NOT_A_CONTACT) ? granData->contactType[myContactID] : CNT_TYPE;
+    deme::contact_t myContactType = listedContactType;
+    // With subcycling, the contacts that involve subcycled families are left to their own pass, with the substep size.
+    // Only the owners' families are needed to tell, so this is done before any geometry is loaded.
+    if (!subcycledPass && simParams->nSubsteps > 1 && listedContactType != deme::NOT_A_CONTACT) {
+        const deme::bodyID_t ownerA = granData->ownerClumpBody[granData->idGeometryA[myContactID]];
+        const deme::bodyID_t idGeoB = granData->idGeometryB[myContactID];
+        deme::bodyID_t ownerB;
+        if (listedContactType == deme::SPHERE_SPHERE_CONTACT) {
+            ownerB = granData->ownerClumpBody[idGeoB];
+        } else if (listedContactType == deme::SPHERE_MESH_CONTACT) {
+            ownerB = granData->ownerMesh[idGeoB];
+        } else {
+            ownerB = objOwner[idGeoB];
+        }
+        if (granData->familySubcycled[granData->familyID[ownerA]] ||
+            granData->familySubcycled[granData->familyID[ownerB]]) {
+            return;
+        }
+    }
+    // The following quantities are always calculated, regardless of force model
+    double3 contactPnt;
+    float3 B2A;  // Unit vector pointing from body B to body A (contact normal)
+    double overlapDepth;
+    double3 AOwnerPos, bodyAPos, BOwnerPos, bodyBPos;
+    float AOwnerMass, ARadius, BOwnerMass, BRadius;
+    float4 AOriQ, BOriQ;
+    deme::materialsOffset_t bodyAMatType, bodyBMatType;
+    // The user-specified extra margin size (how much we should be lenient in determining `in-contact')
+    float extraMarginSize = 0.;
+    // Owners of A and B, for the sleeping logic
+    deme::bodyID_t ownerOfA = 0, ownerOfB = 0;
+    // Then allocate the optional quantities that will be needed in the force model (note: this one can't be in a
+    // curly bracket, obviously...)
+    _forceModelIngredientDefinition_;
+    // Take care of 2 bodies in order, bodyA first, grab location and velocity to local cache
+    // We know in this kernel, bodyA will be a sphere; B can be something else
+    {
+        deme::bodyID_t sphereID = granData->idGeometryA[myContactID];
+        deme::bodyID_t myOwner = granData->ownerClumpBody[sphereID];
+        ownerOfA = myOwner;
+
+        float3 myRelPos;
+        float myRadius;
+        // Get my component offset info from either jitified arrays or global memory
+        // Outputs myRelPos, myRadius
+        // Use an input named exactly `sphereID' which is the id of this sphere component
+        { _componentAcqStrat_; }
+
+        // Get my mass info from either jitified arrays or global memory
+        // Outputs myMass
+        // Use an input named exactly `myOwner' which is the id of this owner
         {
-            deme::bodyID_t sphereID = granData->idGeometryA[myContactID];
-            deme::bodyID_t myOwner = granData->ownerClumpBody[sphereID];
-
-            float3 myRelPos;
-            float myRadius;
-            // Get my component offset info from either jitified arrays or global memory
-            // Outputs myRelPos, myRadius
-            // Use an input named exactly `sphereID' which is the id of this sphere component
-            { _componentAcqStrat_; }
-
-            // Get my mass info from either jitified arrays or global memory
-            // Outputs myMass
-            // Use an input named exactly `myOwner' which is the id of this owner
-            {
-                float myMass;
-                _massAcqStrat_;
-                AOwnerMass = myMass;
-            }
+            float myMass;
+            _massAcqStrat_;
+            AOwnerMass = myMass;
+        }
+
+        // Optional force model ingredients are loaded here...
+        _forceModelIngredientAcqForA_;
+
+        equipOwnerPosRot(simParams, granData, myOwner, myRelPos, AOwnerPos, bodyAPos, AOriQ);
 
-            // Optional force model ingredients are loaded here...
-            _forceModelIngredientAcqForA_;
+        ARadius = myRadius;
+        bodyAMatType = granData->sphereMaterialOffset[sphereID];
+        extraMarginSize = granData->familyExtraMarginSize[AOwnerFamily];
+    }
+
+    // Then B, location and velocity
+    if (myContactType == deme::SPHERE_SPHERE_CONTACT) {
+        deme::bodyID_t sphereID = granData->idGeometryB[myContactID];
+        deme::bodyID_t myOwner = granData->ownerClumpBody[sphereID];
+        ownerOfB = myOwner;
 
-            equipOwnerPosRot(simParams, granData, myOwner, myRelPos, AOwnerPos, bodyAPos, AOriQ);
+        float3 myRelPos;
+        float myRadius;
+        // Get my component offset info from either jitified arrays or global memory
+        // Outputs myRelPos, myRadius
+        // Use an input named exactly `sphereID' which is the id of this sphere component
+        { _componentAcqStrat_; }
 
-            ARadius = myRadius;
-            bodyAMatType = granData->sphereMaterialOffset[sphereID];
-            extraMarginSize = granData->familyExtraMarginSize[AOwnerFamily];
+        // Get my mass info from either jitified arrays or global memory
+        // Outputs myMass
+        // Use an input named exactly `myOwner' which is the id of this owner
+        {
+            float myMass;
+            _massAcqStrat_;
+            BOwnerMass = myMass;
         }
+        _forceModelIngredientAcqForB_;
+        _forceModelGeoWildcardAcqForSph_;
 
-        // Then B, location and velocity
-        if (myContactType == deme::SPHERE_SPHERE_CONTACT) {
-            deme::bodyID_t sphereID = granData->idGeometryB[myContactID];
-            deme::bodyID_t myOwner = granData->ownerClumpBody[sphereID];
-
-            float3 myRelPos;
-            float myRadius;
-            // Get my component offset info from either jitified arrays or global memory
-            // Outputs myRelPos, myRadius
-            // Use an input named exactly `sphereID' which is the id of this sphere component
-            { _componentAcqStrat_; }
-
-            // Get my mass info from either jitified arrays or global memory
-            // Outputs myMass
-            // Use an input named exactly `myOwner' which is the id of this owner
-            {
-                float myMass;
-                _massAcqStrat_;
-                BOwnerMass = myMass;
-            }
-            _forceModelIngredientAcqForB_;
-            _forceModelGeoWildcardAcqForSph_;
-
-            equipOwnerPosRot(simParams, granData, myOwner, myRelPos, BOwnerPos, bodyBPos, BOriQ);
-
-            BRadius = myRadius;
-            bodyBMatType = granData->sphereMaterialOffset[sphereID];
-
-            // As the grace margin, the distance (negative overlap) just needs to be within the grace margin. So we pick
-            // the larger of the 2 familyExtraMarginSize.
-            extraMarginSize = (extraMarginSize > granData->familyExtraMarginSize[BOwnerFamily])
-                                  ? extraMarginSize
-                                  : granData->familyExtraMarginSize[BOwnerFamily];
-
-            checkSpheresOverlap<double, float>(bodyAPos.x, bodyAPos.y, bodyAPos.z, ARadius, bodyBPos.x, bodyBPos.y,
-                                               bodyBPos.z, BRadius, contactPnt.x, contactPnt.y, contactPnt.z, B2A.x,
-                                               B2A.y, B2A.z, overlapDepth);
-            // If overlapDepth is negative then it might still be considered in contact, if the extra margins of A and B
-            // combined is larger than abs(overlapDepth)
-            if (overlapDepth < -extraMarginSize) {
-                myContactType = deme::NOT_A_CONTACT;
-            }
+        equipOwnerPosRot(simParams, granData, myOwner, myRelPos, BOwnerPos, bodyBPos, BOriQ);
 
-        } else if (myContactType == deme::SPHERE_MESH_CONTACT) {
-            // Geometry ID here is called sphereID, although it is not a sphere, it's more like triID. But naming it
-            // sphereID makes the acquisition process cleaner.
-            deme::bodyID_t sphereID = granData->idGeometryB[myContactID];
-            deme::bodyID_t myOwner = granData->ownerMesh[sphereID];
-            //// TODO: Is this OK?
-            BRadius = DEME_HUGE_FLOAT;
-            bodyBMatType = granData->triMaterialOffset[sphereID];
-
-            // As the grace margin, the distance (negative overlap) just needs to be within the grace margin. So we pick
-            // the larger of the 2 familyExtraMarginSize.
-            extraMarginSize = (extraMarginSize > granData->familyExtraMarginSize[BOwnerFamily])
-                                  ? extraMarginSize
-                                  : granData->familyExtraMarginSize[BOwnerFamily];
-
-            double3 triNode1 = to_double3(granData->relPosNode1[sphereID]);
-            double3 triNode2 = to_double3(granData->relPosNode2[sphereID]);
-            double3 triNode3 = to_double3(granData->relPosNode3[sphereID]);
-
-            // Get my mass info from either jitified arrays or global memory
-            // Outputs myMass
-            // Use an input named exactly `myOwner' which is the id of this owner
-            {
-                float myMass;
-                _massAcqStrat_;
-                BOwnerMass = myMass;
-            }
-            _forceModelIngredientAcqForB_;
-            _forceModelGeoWildcardAcqForTri_;
-
-            // bodyBPos is for a place holder for the outcome triNode1 position
-            equipOwnerPosRot(simParams, granData, myOwner, triNode1, BOwnerPos, bodyBPos, BOriQ);
-            triNode1 = bodyBPos;
-            // Do this to node 2 and 3 as well
-            applyOriQToVector3(triNode2.x, triNode2.y, triNode2.z, BOriQ.w, BOriQ.x, BOriQ.y, BOriQ.z);
-            triNode2 += BOwnerPos;
-            applyOriQToVector3(triNode3.x, triNode3.y, triNode3.z, BOriQ.w, BOriQ.x, BOriQ.y, BOriQ.z);
-            triNode3 += BOwnerPos;
-            // Assign the correct bodyBPos
-            bodyBPos = triangleCentroid<double3>(triNode1, triNode2, triNode3);
-
-            double3 contact_normal;
-            bool in_contact = triangle_sphere_CD<double3, double>(triNode1, triNode2, triNode3, bodyAPos, ARadius,
-                                                                  contact_normal, overlapDepth, contactPnt);
-            B2A = to_float3(contact_normal);
-
-            // Sphere--triangle is a bit tricky. Extra margin should only take effect when it comes from the positive
-            // direction of the mesh facet. If not, sphere-setting-on-needle case will give huge penetration since in
-            // that case, overlapDepth is very negative and this will be considered in-contact. So the cases we exclude
-            // are: too far away while at the positive direction; not in contact while at the negative side.
-            if ((overlapDepth > extraMarginSize) || (!in_contact && overlapDepth < 0.)) {
-                myContactType = deme::NOT_A_CONTACT;
+        BRadius = myRadius;
+        bodyBMatType = granData->sphereMaterialOffset[sphereID];
+
+        // As the grace margin, the distance (negative overlap) just needs to be within the grace margin. So we pick
+        // the larger of the 2 familyExtraMarginSize.
+        extraMarginSize = (extraMarginSize > granData->familyExtraMarginSize[BOwnerFamily])
+                              ? extraMarginSize
+                              : granData->familyExtraMarginSize[BOwnerFamily];
+
+        // In periodic directions, B is taken as its image closest to A (its owner moves with it, so the contact
+        // point's location in B's frame is right)
+        {
+            double3 imageBPos = bodyBPos;
+            toClosestPeriodicImage(simParams, bodyAPos.x, bodyAPos.y, bodyAPos.z, imageBPos.x, imageBPos.y,
+                                   imageBPos.z);
+            BOwnerPos += imageBPos - bodyBPos;
+            bodyBPos = imageBPos;
+        }
+        checkSpheresOverlap<double, float>(bodyAPos.x, bodyAPos.y, bodyAPos.z, ARadius, bodyBPos.x, bodyBPos.y,
+                                           bodyBPos.z, BRadius, contactPnt.x, contactPnt.y, contactPnt.z, B2A.x,
+                                           B2A.y, B2A.z, overlapDepth);
+        // If overlapDepth is negative then it might still be considered in contact, if the extra margins of A and B
+        // combined is larger than abs(overlapDepth)
+        if (overlapDepth < -extraMarginSize) {
+            myContactType = deme::NOT_A_CONTACT;
+        }
+
+    } else if (myContactType == deme::SPHERE_MESH_CONTACT) {
+        // Geometry ID here is called sphereID, although it is not a sphere, it's more like triID. But naming it
+        // sphereID makes the acquisition process cleaner.
+        deme::bodyID_t sphereID = granData->idGeometryB[myContactID];
+        deme::bodyID_t myOwner = granData->ownerMesh[sphereID];
+        ownerOfB = myOwner;
+        //// TODO: Is this OK?
+        BRadius = DEME_HUGE_FLOAT;
+        bodyBMatType = granData->triMaterialOffset[sphereID];
+
+        // As the grace margin, the distance (negative overlap) just needs to be within the grace margin. So we pick
+        // the larger of the 2 familyExtraMarginSize.
+        extraMarginSize = (extraMarginSize > granData->familyExtraMarginSize[BOwnerFamily])
+                              ? extraMarginSize
+                              : granData->familyExtraMarginSize[BOwnerFamily];
+
+        double3 triNode1 = to_double3(granData->relPosNode1[sphereID]);
+        double3 triNode2 = to_double3(granData->relPosNode2[sphereID]);
+        double3 triNode3 = to_double3(granData->relPosNode3[sphereID]);
+
+        // Get my mass info from either jitified arrays or global memory
+        // Outputs myMass
+        // Use an input named exactly `myOwner' which is the id of this owner
+        {
+            float myMass;
+            _massAcqStrat_;
+            BOwnerMass = myMass;
+        }
+        _forceModelIngredientAcqForB_;
+        _forceModelGeoWildcardAcqForTri_;
+
+        // bodyBPos is for a place holder for the outcome triNode1 position
+        equipOwnerPosRot(simParams, granData, myOwner, triNode1, BOwnerPos, bodyBPos, BOriQ);
+        triNode1 = bodyBPos;
+        // Do this to node 2 and 3 as well
+        applyOriQToVector3(triNode2.x, triNode2.y, triNode2.z, BOriQ.w, BOriQ.x, BOriQ.y, BOriQ.z);
+        triNode2 += BOwnerPos;
+        applyOriQToVector3(triNode3.x, triNode3.y, triNode3.z, BOriQ.w, BOriQ.x, BOriQ.y, BOriQ.z);
+        triNode3 += BOwnerPos;
+        // Assign the correct bodyBPos
+        bodyBPos = triangleCentroid<double3>(triNode1, triNode2, triNode3);
+
+        double3 contact_normal;
+        bool in_contact = triangle_sphere_CD<double3, double>(triNode1, triNode2, triNode3, bodyAPos, ARadius,
+                                                              contact_normal, overlapDepth, contactPnt);
+        B2A = to_float3(contact_normal);
+
+        // Sphere--triangle is a bit tricky. Extra margin should only take effect when it comes from the positive
+        // direction of the mesh facet. If not, sphere-setting-on-needle case will give huge penetration since in
+        // that case, overlapDepth is very negative and this will be considered in-contact. So the cases we exclude
+        // are: too far away while at the positive direction; not in contact while at the negative side.
+        if ((overlapDepth > extraMarginSize) || (!in_contact && overlapDepth < 0.)) {
+            myContactType = deme::NOT_A_CONTACT;
+        }
+        overlapDepth = -overlapDepth;  // triangle_sphere_CD gives neg. number for overlapping cases
+    } else if (myContactType > deme::SPHERE_ANALYTICAL_CONTACT) {
+        // Geometry ID here is called sphereID, although it is not a sphere, it's more like analyticalID. But naming
+        // it sphereID makes the acquisition process cleaner.
+        deme::objID_t sphereID = granData->idGeometryB[myContactID];
+        deme::bodyID_t myOwner = objOwner[sphereID];
+        ownerOfB = myOwner;
+        // If B is analytical entity, its owner, relative location, material info is jitified.
+        bodyBMatType = objMaterial[sphereID];
+        BOwnerMass = objMass[sphereID];
+        //// TODO: Is this OK?
+        BRadius = DEME_HUGE_FLOAT;
+        float3 myRelPos;
+        float3 bodyBRot;
+        myRelPos.x = objRelPosX[sphereID];
+        myRelPos.y = objRelPosY[sphereID];
+        myRelPos.z = objRelPosZ[sphereID];
+        _forceModelIngredientAcqForB_;
+        _forceModelGeoWildcardAcqForAnal_;
+
+        equipOwnerPosRot(simParams, granData, myOwner, myRelPos, BOwnerPos, bodyBPos, BOriQ);
+
+        // As the grace margin, the distance (negative overlap) just needs to be within the grace margin. So we pick
+        // the larger of the 2 familyExtraMarginSize.
+        extraMarginSize = (extraMarginSize > granData->familyExtraMarginSize[BOwnerFamily])
+                              ? extraMarginSize
+                              : granData->familyExtraMarginSize[BOwnerFamily];
+
+        // B's orientation (such as plane normal) is rotated with its owner too
+        bodyBRot.x = objRotX[sphereID];
+        bodyBRot.y = objRotY[sphereID];
+        bodyBRot.z = objRotZ[sphereID];
+        applyOriQToVector3<float, deme::oriQ_t>(bodyBRot.x, bodyBRot.y, bodyBRot.z, BOriQ.w, BOriQ.x, BOriQ.y,
+                                                BOriQ.z);
+
+        // Note for this test on dT side we don't enlarge entities
+        // The sphere--analytical contact types are in the same order as the analytical object types
+        const deme::objType_t typeB = (CNT_TYPE == deme::NOT_A_CONTACT)
+                                          ? objType[sphereID]
+                                          : (deme::objType_t)(CNT_TYPE - deme::SPHERE_PLANE_CONTACT);
+        checkSphereEntityOverlap<double3, float, double>(bodyAPos, ARadius, typeB, bodyBPos, bodyBRot,
+                                                         objSize1[sphereID], objSize2[sphereID], objSize3[sphereID],
+                                                         objNormal[sphereID], 0.0, contactPnt, B2A, overlapDepth);
+        // Fix myContactType if needed
+        if (overlapDepth < -extraMarginSize) {
+            myContactType = deme::NOT_A_CONTACT;
+        }
+    }  // else it must be NOT_A_CONTACT
+
+    _forceModelContactWildcardAcq_;
+    const bool AAsleep = isOwnerAsleep(simParams, granData, ownerOfA);
+    const bool BAsleep = isOwnerAsleep(simParams, granData, ownerOfB);
+    if (myContactType != deme::NOT_A_CONTACT && AAsleep && BAsleep) {
+        // Two sleeping owners exert no force on each other, but the contact history is kept for when they wake up
+    } else if (myContactType != deme::NOT_A_CONTACT) {
+        float3 force = make_float3(0, 0, 0);
+        float3 torque_only_force = make_float3(0, 0, 0);
+        // Local position of the contact point is always a piece of info we require... regardless of force model
+        float3 locCPA = to_float3(contactPnt - AOwnerPos);
+        float3 locCPB = to_float3(contactPnt - BOwnerPos);
+        // Now map this contact point location to bodies' local ref
+        applyOriQToVector3<float, deme::oriQ_t>(locCPA.x, locCPA.y, locCPA.z, AOriQ.w, -AOriQ.x, -AOriQ.y,
+                                                -AOriQ.z);
+        applyOriQToVector3<float, deme::oriQ_t>(locCPB.x, locCPB.y, locCPB.z, BOriQ.w, -BOriQ.x, -BOriQ.y,
+                                                -BOriQ.z);
+        // The following part, the force model, is user-specifiable
+        // NOTE!! "force" and all wildcards must be properly set by this piece of code
+        { _DEMForceModel_; }
+
+        // Write contact location values back to global memory
+        _contactInfoWrite_;
+
+        // If force model modifies owner wildcards, write them back here
+        _forceModelOwnerWildcardWrite_;
+
+        // Optionally, the forces can be reduced to acc right here (may be faster)
+        _forceCollectInPlaceStrat_;
+
+        // Adaptive time stepping may need the deepest overlap. Non-negative floats compare like their bit patterns
+        // as ints, and the check before the atomic spares most threads from it.
+        if (simParams->trackMaxOverlap) {
+            float overlapRatio = overlapDepth / fminf(ARadius, BRadius);
+            if (overlapRatio > granData->maxOverlapRatio) {
+                atomicMax((int*)&(granData->maxOverlapRatio), __float_as_int(overlapRatio));
             }
-            overlapDepth = -overlapDepth;  // triangle_sphere_CD gives neg. number for overlapping cases
-        } else if (myContactType > deme::SPHERE_ANALYTICAL_CONTACT) {
-            // Geometry ID here is called sphereID, although it is not a sphere, it's more like analyticalID. But naming
-            // it sphereID makes the acquisition process cleaner.
-            deme::objID_t sphereID = granData->idGeometryB[myContactID];
-            deme::bodyID_t myOwner = objOwner[sphereID];
-            // If B is analytical entity, its owner, relative location, material info is jitified.
-            bodyBMatType = objMaterial[sphereID];
-            BOwnerMass = objMass[sphereID];
-            //// TODO: Is this OK?
-            BRadius = DEME_HUGE_FLOAT;
-            float3 myRelPos;
-            float3 bodyBRot;
-            myRelPos.x = objRelPosX[sphereID];
-            myRelPos.y = objRelPosY[sphereID];
-            myRelPos.z = objRelPosZ[sphereID];
-            _forceModelIngredientAcqForB_;
-            _forceModelGeoWildcardAcqForAnal_;
-
-            equipOwnerPosRot(simParams, granData, myOwner, myRelPos, BOwnerPos, bodyBPos, BOriQ);
-
-            // As the grace margin, the distance (negative overlap) just needs to be within the grace margin. So we pick
-            // the larger of the 2 familyExtraMarginSize.
-            extraMarginSize = (extraMarginSize > granData->familyExtraMarginSize[BOwnerFamily])
-                                  ? extraMarginSize
-                                  : granData->familyExtraMarginSize[BOwnerFamily];
-
-            // B's orientation (such as plane normal) is rotated with its owner too
-            bodyBRot.x = objRotX[sphereID];
-            bodyBRot.y = objRotY[sphereID];
-            bodyBRot.z = objRotZ[sphereID];
-            applyOriQToVector3<float, deme::oriQ_t>(bodyBRot.x, bodyBRot.y, bodyBRot.z, BOriQ.w, BOriQ.x, BOriQ.y,
-                                                    BOriQ.z);
-
-            // Note for this test on dT side we don't enlarge entities
-            checkSphereEntityOverlap<double3, float, double>(bodyAPos, ARadius, objType[sphereID], bodyBPos, bodyBRot,
-                                                             objSize1[sphereID], objSize2[sphereID], objSize3[sphereID],
-                                                             objNormal[sphereID], 0.0, contactPnt, B2A, overlapDepth);
-            // Fix myContactType if needed
-            if (overlapDepth < -extraMarginSize) {
-                myContactType = deme::NOT_A_CONTACT;
+        }
+
+        // A sleeping owner is woken up by an awake partner that moves, or by a large enough contact force
+        if (AAsleep != BAsleep) {
+            const deme::bodyID_t sleeper = AAsleep ? ownerOfA : ownerOfB;
+            const deme::bodyID_t waker = AAsleep ? ownerOfB : ownerOfA;
+            if (!isOwnerQuiescent(simParams, granData, waker) || length(force) > simParams->wakeForce) {
+                wakeOwnerUp(simParams, granData, sleeper);
             }
-        }  // else it must be NOT_A_CONTACT
-
-        _forceModelContactWildcardAcq_;
-        if (myContactType != deme::NOT_A_CONTACT) {
-            float3 force = make_float3(0, 0, 0);
-            float3 torque_only_force = make_float3(0, 0, 0);
-            // Local position of the contact point is always a piece of info we require... regardless of force model
-            float3 locCPA = to_float3(contactPnt - AOwnerPos);
-            float3 locCPB = to_float3(contactPnt - BOwnerPos);
-            // Now map this contact point location to bodies' local ref
-            applyOriQToVector3<float, deme::oriQ_t>(locCPA.x, locCPA.y, locCPA.z, AOriQ.w, -AOriQ.x, -AOriQ.y,
-                                                    -AOriQ.z);
-            applyOriQToVector3<float, deme::oriQ_t>(locCPB.x, locCPB.y, locCPB.z, BOriQ.w, -BOriQ.x, -BOriQ.y,
-                                                    -BOriQ.z);
-            // The following part, the force model, is user-specifiable
-            // NOTE!! "force" and all wildcards must be properly set by this piece of code
-            { _DEMForceModel_; }
-
-            // Write contact location values back to global memory
-            _contactInfoWrite_;
-
-            // If force model modifies owner wildcards, write them back here
-            _forceModelOwnerWildcardWrite_;
-
-            // Optionally, the forces can be reduced to acc right here (may be faster)
-            _forceCollectInPlaceStrat_;
+        }
+    } else {
+        // The contact is no longer active, so we need to destroy its contact history recording
+        _forceModelContactWildcardDestroy_;
+    }
+
+    // Updated contact wildcards need to be write back to global mem. It is here because contact wildcard may need
+    // to be destroyed for non-contact, so it has to go last.
+    _forceModelContactWildcardWrite_;
+}
+
+__global__ void calculateContactForces(deme::DEMSimParams* simParams, deme::DEMDataDT* granData, size_t nContactPairs) {
+    deme::contactPairs_t myContactID = blockIdx.x * blockDim.x + threadIdx.x;
+    if (myContactID < nContactPairs) {
+        calculateContactForce(simParams, granData, myContactID, false);
+    }
+}
+
+// All contacts in [start, start + n) are of type CNT_TYPE (the contact array is sorted by type)
+template <deme::contact_t CNT_TYPE>
+__global__ void calculateContactForcesOfType(deme::DEMSimParams* simParams,
+                                             deme::DEMDataDT* granData,
+                                             size_t start,
+                                             size_t n) {
+    size_t myEntry = blockIdx.x * blockDim.x + threadIdx.x;
+    if (myEntry < n) {
+        calculateContactForce<CNT_TYPE>(simParams, granData, start + myEntry, false);
+    }
+}
+
+// The contacts in contactIDs are those that involve subcycled families
+__global__ void calculateSubcycledContactForces(deme::DEMSimParams* simParams,
+                                                deme::DEMDataDT* granData,
+                                                const deme::contactPairs_t* contactIDs,
+                                                size_t n) {
+    size_t myEntry = blockIdx.x * blockDim.x + threadIdx.x;
+    if (myEntry < n) {
+        calculateContactForce(simParams, granData, contactIDs[myEntry], true);
+    }
+}
+
+// Flag the contacts between family pairs that are recorded in full (with a force record policy)
+__global__ void markFullRecordContacts(deme::DEMDataDT* granData, deme::notStupidBool_t* isFullRecord, size_t n) {
+    deme::contactPairs_t myID = blockIdx.x * blockDim.x + threadIdx.x;
+    if (myID < n) {
+        const deme::contact_t thisCntType = granData->contactType[myID];
+        if (thisCntType == deme::NOT_A_CONTACT) {
+            isFullRecord[myID] = 0;
         } else {
-            // The contact is no longer active, so we need to destroy its contact history recording
-            _forceModelContactWildcardDestroy_;
+            const deme::bodyID_t ownerA = granData->ownerClumpBody[granData->idGeometryA[myID]];
+            const deme::bodyID_t idGeoB = granData->idGeometryB[myID];
+            deme::bodyID_t ownerB;
+            if (thisCntType == deme::SPHERE_SPHERE_CONTACT) {
+                ownerB = granData->ownerClumpBody[idGeoB];
+            } else if (thisCntType == deme::SPHERE_MESH_CONTACT) {
+                ownerB = granData->ownerMesh[idGeoB];
+            } else {
+                ownerB = objOwner[idGeoB];
+            }
+            const unsigned int posInMat =
+                locateMaskPair<unsigned int>(granData->familyID[ownerA], granData->familyID[ownerB]);
+            isFullRecord[myID] = (granData->familyForceRecord[posInMat] == deme::CNT_RECORD_FULL);
         }
+    }
+}
 
-        // Updated contact wildcards need to be write back to global mem. It is here because contact wildcard may need
-        // to be destroyed for non-contact, so it has to go last.
-        _forceModelContactWildcardWrite_;
+// After the scan of the flags above, the contacts not recorded in full are given no place in the record arrays
+__global__ void nullifyPartialRecordSlots(deme::DEMDataDT* granData,
+                                          const deme::notStupidBool_t* isFullRecord,
+                                          size_t n) {
+    deme::contactPairs_t myID = blockIdx.x * blockDim.x + threadIdx.x;
+    if (myID < n && !isFullRecord[myID]) {
+        granData->fullRecordSlot[myID] = deme::NULL_MAPPING_PARTNER;
     }
 }
@@ -0,0 +1,116 @@
+// DEM force computation, compiled for the host by DEMForceModelHarness. It runs the same force model body with the
+// same ingredient acquisition as calculateContactForces, but takes the contact geometry as given, so that a force
+// model can be driven by synthetic contacts.
+#include <cmath>
+#include <cstring>
+#include <cuda_runtime.h>
+
+// Device intrinsics used by the helpers and possibly by force models, in their host form
+#define rsqrtf(x) (1.f / sqrtf(x))
+inline unsigned int __float_as_uint(float x) {
+    unsigned int u;
+    std::memcpy(&u, &x, sizeof(u));
+    return u;
+}
+inline float __uint_as_float(unsigned int u) {
+    float x;
+    std::memcpy(&x, &u, sizeof(x));
+    return x;
+}
+template <typename T1>
+inline T1 atomicAdd(T1* address, T1 val) {
+    T1 old = *address;
+    *address += val;
+    return old;
+}
+template <typename T1>
+inline T1 atomicSub(T1* address, T1 val) {
+    T1 old = *address;
+    *address -= val;
+    return old;
+}
+template <typename T1>
+inline T1 atomicExch(T1* address, T1 val) {
+    T1 old = *address;
+    *address = val;
+    return old;
+}
+
+#include <DEM/Defines.h>
+#include <DEMHelperKernels.cu>
+
+// Material properties are below
+_materialDefs_;
+
+extern "C" void calculateContactForcesHost(deme::DEMSimParams* simParams,
+                                           deme::DEMDataDT* granData,
+                                           const double3* ownerPos,
+                                           const double3* contactPnts,
+                                           const float3* contactNormals,
+                                           const double* overlapDepths,
+                                           size_t nContactPairs) {
+    for (deme::contactPairs_t myContactID = 0; myContactID < nContactPairs; myContactID++) {
+        deme::contact_t myContactType = granData->contactType[myContactID];
+        // The geometric quantities calculateContactForces would have derived
+        double3 contactPnt = contactPnts[myContactID];
+        float3 B2A = contactNormals[myContactID];
+        double overlapDepth = overlapDepths[myContactID];
+        double3 AOwnerPos, BOwnerPos;
+        float AOwnerMass, ARadius, BOwnerMass, BRadius;
+        float4 AOriQ, BOriQ;
+        deme::materialsOffset_t bodyAMatType, bodyBMatType;
+        _forceModelIngredientDefinition_;
+        {
+            deme::bodyID_t sphereID = granData->idGeometryA[myContactID];
+            deme::bodyID_t myOwner = granData->ownerClumpBody[sphereID];
+            {
+                float myMass;
+                _massAcqStrat_;
+                AOwnerMass = myMass;
+            }
+            _forceModelIngredientAcqForA_;
+            AOwnerPos = ownerPos[myOwner];
+            AOriQ = make_float4(granData->oriQx[myOwner], granData->oriQy[myOwner], granData->oriQz[myOwner],
+                                granData->oriQw[myOwner]);
+            ARadius = granData->radiiSphere[sphereID];
+            bodyAMatType = granData->sphereMaterialOffset[sphereID];
+        }
+        // B is always acquired like a sphere; for a mesh or analytical B, only the radius is treated differently
+        {
+            deme::bodyID_t sphereID = granData->idGeometryB[myContactID];
+            deme::bodyID_t myOwner = granData->ownerClumpBody[sphereID];
+            {
+                float myMass;
+                _massAcqStrat_;
+                BOwnerMass = myMass;
+            }
+            _forceModelIngredientAcqForB_;
+            _forceModelGeoWildcardAcqForSph_;
+            BOwnerPos = ownerPos[myOwner];
+            BOriQ = make_float4(granData->oriQx[myOwner], granData->oriQy[myOwner], granData->oriQz[myOwner],
+                                granData->oriQw[myOwner]);
+            BRadius = (myContactType == deme::SPHERE_SPHERE_CONTACT) ? granData->radiiSphere[sphereID]
+                                                                     : DEME_HUGE_FLOAT;
+            bodyBMatType = granData->sphereMaterialOffset[sphereID];
+        }
+
+        _forceModelContactWildcardAcq_;
+        if (myContactType != deme::NOT_A_CONTACT) {
+            float3 force = make_float3(0, 0, 0);
+            float3 torque_only_force = make_float3(0, 0, 0);
+            float3 locCPA = to_float3(contactPnt - AOwnerPos);
+            float3 locCPB = to_float3(contactPnt - BOwnerPos);
+            applyOriQToVector3<float, deme::oriQ_t>(locCPA.x, locCPA.y, locCPA.z, AOriQ.w, -AOriQ.x, -AOriQ.y,
+                                                    -AOriQ.z);
+            applyOriQToVector3<float, deme::oriQ_t>(locCPB.x, locCPB.y, locCPB.z, BOriQ.w, -BOriQ.x, -BOriQ.y,
+                                                    -BOriQ.z);
+            { _DEMForceModel_; }
+
+            _contactInfoWrite_;
+            _forceModelOwnerWildcardWrite_;
+        } else {
+            _forceModelContactWildcardDestroy_;
+        }
+        _forceModelContactWildcardWrite_;
+    }
+}
@@ -8,94 +8,200 @@ __constant__ __device__ deme::bodyID_t objOwner[] = {_objOwner_};
 _massDefs_;
 _moiDefs_;
 
-// computes a ./ b
+inline __device__ deme::bodyID_t getContactOwnerA(deme::DEMDataDT* granData, deme::contactPairs_t myID) {
+    return granData->ownerClumpBody[granData->idGeometryA[myID]];
+}
+
+inline __device__ deme::bodyID_t getContactOwnerB(deme::DEMDataDT* granData,
+                                                  deme::contactPairs_t myID,
+                                                  deme::contact_t thisCntType) {
+    const deme::bodyID_t idGeo = granData->idGeometryB[myID];
+    if (thisCntType == deme::SPHERE_SPHERE_CONTACT) {
+        return granData->ownerClumpBody[idGeo];
+    } else if (thisCntType == deme::SPHERE_MESH_CONTACT) {
+        return granData->ownerMesh[idGeo];
+    } else {
+        // This is a sphere--analytical geometry contact, its owner is jitified
+        return objOwner[idGeo];
+    }
+}
+
+// The acceleration and angular acceleration that force F, and torque-only force torqueOnlyF, at myCntPnt (in myOwner's
+// local frame) give myOwner
+inline __device__ void forceToOwnerAccContrib(deme::DEMDataDT* granData,
+                                              const deme::bodyID_t myOwner,
+                                              const float3& F,
+                                              const float3& torqueOnlyF,
+                                              const float3& myCntPnt,
+                                              float3& acc,
+                                              float3& angAcc) {
+    float myMass;
+    float3 myMOI;
+    // Get my mass info from either jitified arrays or global memory
+    // Outputs myMass
+    // Use an input named exactly `myOwner' which is the id of this owner
+    {
+        _massAcqStrat_;
+        _moiAcqStrat_;
+    }
+    acc = F / myMass;
+
+    // Then ang acc
+    const deme::oriQ_t myOriQw = granData->oriQw[myOwner];
+    const deme::oriQ_t myOriQx = granData->oriQx[myOwner];
+    const deme::oriQ_t myOriQy = granData->oriQy[myOwner];
+    const deme::oriQ_t myOriQz = granData->oriQz[myOwner];
+
+    // torque_inForceForm is usually the contribution of rolling resistance and it contributes to torque only, not
+    // linear velocity
+    float3 myF = F + torqueOnlyF;
+    // F is in global frame, but it needs to be in local to coordinate with moi and cntPnt
+    applyOriQToVector3<float, deme::oriQ_t>(myF.x, myF.y, myF.z, myOriQw, -myOriQx, -myOriQy, -myOriQz);
+    angAcc = cross(myCntPnt, myF) / myMOI;
+}
+
+inline __device__ void addToOwnerAcc(deme::DEMDataDT* granData,
+                                     const deme::bodyID_t myOwner,
+                                     const float3& acc,
+                                     const float3& angAcc) {
+    atomicAdd(granData->aX + myOwner, acc.x);
+    atomicAdd(granData->aY + myOwner, acc.y);
+    atomicAdd(granData->aZ + myOwner, acc.z);
+    atomicAdd(granData->alphaX + myOwner, angAcc.x);
+    atomicAdd(granData->alphaY + myOwner, angAcc.y);
+    atomicAdd(granData->alphaZ + myOwner, angAcc.z);
+}
+
+// Apply force F, and torque-only force torqueOnlyF, at myCntPnt (in myOwner's local frame) to myOwner
+inline __device__ void forceToOwnerAcc(deme::DEMDataDT* granData,
+                                       const deme::bodyID_t myOwner,
+                                       const float3& F,
+                                       const float3& torqueOnlyF,
+                                       const float3& myCntPnt) {
+    float3 acc, angAcc;
+    forceToOwnerAccContrib(granData, myOwner, F, torqueOnlyF, myCntPnt, acc, angAcc);
+    addToOwnerAcc(granData, myOwner, acc, angAcc);
+}
+
 __global__ void forceToAcc(deme::DEMDataDT* granData, size_t n) {
     deme::contactPairs_t myID = blockIdx.x * blockDim.x + threadIdx.x;
     if (myID < n) {
         deme::contact_t thisCntType = granData->contactType[myID];
         const float3 F = granData->contactForces[myID];
+        const float3 torqueOnlyF = loadContactTorque(granData, myID);
+
+        // A gets the force, and B gets the opposite
+        forceToOwnerAcc(granData, getContactOwnerA(granData, myID), F, torqueOnlyF, loadContactPointA(granData, myID));
+        forceToOwnerAcc(granData, getContactOwnerB(granData, myID, thisCntType), -1.f * F, -1.f * torqueOnlyF,
+                        loadContactPointB(granData, myID));
+    }
+}
+
+// Each thread puts its contribution to an owner in shared memory; then, for each run of threads that have the same
+// owner, the first thread of the run sums the run and adds it to the owner, so that there is one set of atomic
+// operations per run rather than per contact. Threads with owner NULL_BODYID contribute nothing.
+inline __device__ void addToOwnerAccByRuns(deme::DEMDataDT* granData,
+                                           deme::bodyID_t* owners,
+                                           float3* accs,
+                                           float3* angAccs,
+                                           const deme::bodyID_t myOwner,
+                                           const float3& acc,
+                                           const float3& angAcc,
+                                           unsigned int nThreads) {
+    const unsigned int myTh = threadIdx.x;
+    owners[myTh] = myOwner;
+    accs[myTh] = acc;
+    angAccs[myTh] = angAcc;
+    __syncthreads();
+    if (myOwner != deme::NULL_BODYID && (myTh == 0 || owners[myTh - 1] != myOwner)) {
+        float3 runAcc = acc, runAngAcc = angAcc;
+        for (unsigned int i = myTh + 1; i < nThreads && owners[i] == myOwner; i++) {
+            runAcc += accs[i];
+            runAngAcc += angAccs[i];
+        }
+        addToOwnerAcc(granData, myOwner, runAcc, runAngAcc);
+    }
+    // The shared memory is reused after this
+    __syncthreads();
+}
+
+// The same as forceToAcc, but the contributions of a block's contacts are summed per owner in shared memory before
+// they are added to the owners. kT sorts the contact array by geometry A (within each contact type, if contacts are
+// sorted by type), and a clump's spheres are numbered consecutively, so a clump's contacts tend to be next to each
+// other and are collected with one set of atomic operations per block; the same goes for B-side owners such as a wall
+// that the spheres next to each other touch. It is correct in any order, just not as fast if contacts are not sorted.
+// Must be launched with DEME_COMPACT_COLLECT_NTHREADS_PER_BLOCK threads per block.
+__global__ void forceToAccOwnerBlocked(deme::DEMDataDT* granData, size_t n) {
+    __shared__ deme::bodyID_t owners[DEME_COMPACT_COLLECT_NTHREADS_PER_BLOCK];
+    __shared__ float3 accs[DEME_COMPACT_COLLECT_NTHREADS_PER_BLOCK];
+    __shared__ float3 angAccs[DEME_COMPACT_COLLECT_NTHREADS_PER_BLOCK];
+
+    const size_t blockStart = (size_t)blockIdx.x * blockDim.x;
+    const unsigned int nThreads = (n - blockStart < blockDim.x) ? (unsigned int)(n - blockStart) : blockDim.x;
+    const deme::contactPairs_t myID = blockStart + threadIdx.x;
+    // Threads past the end still take part in the reductions, with no owner
+    deme::bodyID_t ownerA = deme::NULL_BODYID, ownerB = deme::NULL_BODYID;
+    float3 F, torqueOnlyF;
+    deme::contact_t thisCntType = deme::NOT_A_CONTACT;
+    if (threadIdx.x < nThreads) {
+        thisCntType = granData->contactType[myID];
+        if (thisCntType != deme::NOT_A_CONTACT) {
+            F = granData->contactForces[myID];
+            torqueOnlyF = loadContactTorque(granData, myID);
+            ownerA = getContactOwnerA(granData, myID);
+            ownerB = getContactOwnerB(granData, myID, thisCntType);
+        }
+    }
+
+    // A gets the force, and B gets the opposite
+    float3 acc = make_float3(0, 0, 0), angAcc = make_float3(0, 0, 0);
+    if (ownerA != deme::NULL_BODYID) {
+        forceToOwnerAccContrib(granData, ownerA, F, torqueOnlyF, loadContactPointA(granData, myID), acc, angAcc);
+    }
+    addToOwnerAccByRuns(granData, owners, accs, angAccs, ownerA, acc, angAcc, nThreads);
+    if (ownerB != deme::NULL_BODYID) {
+        forceToOwnerAccContrib(granData, ownerB, -1.f * F, -1.f * torqueOnlyF, loadContactPointB(granData, myID),
+                               acc, angAcc);
+    }
+    addToOwnerAccByRuns(granData, owners, accs, angAccs, ownerB, acc, angAcc, nThreads);
+}
+
+// In a substep, the forces of the contacts that involve subcycled families are collected only into the owners flagged
+// in ownerSubcycled, as the other owners do not move in a substep
+__global__ void subcycledForceToAcc(deme::DEMDataDT* granData,
+                                    const deme::notStupidBool_t* ownerSubcycled,
+                                    const deme::contactPairs_t* contactIDs,
+                                    size_t n) {
+    size_t myEntry = blockIdx.x * blockDim.x + threadIdx.x;
+    if (myEntry < n) {
+        const deme::contactPairs_t myID = contactIDs[myEntry];
+        deme::contact_t thisCntType = granData->contactType[myID];
+        const float3 F = granData->contactForces[myID];
+        const float3 torqueOnlyF = loadContactTorque(granData, myID);
 
-        // Take care of A
-        {
-            float myMass;
-            float3 myMOI;
-            const deme::bodyID_t idGeo = granData->idGeometryA[myID];
-            const float3 myCntPnt = granData->contactPointGeometryA[myID];
-
-            const deme::bodyID_t myOwner = granData->ownerClumpBody[idGeo];
-            // Get my mass info from either jitified arrays or global memory
-            // Outputs myMass
-            // Use an input named exactly `myOwner' which is the id of this owner
-            {
-                _massAcqStrat_;
-                _moiAcqStrat_;
-            }
-
-            atomicAdd(granData->aX + myOwner, F.x / myMass);
-            atomicAdd(granData->aY + myOwner, F.y / myMass);
-            atomicAdd(granData->aZ + myOwner, F.z / myMass);
-
-            // Then ang acc
-            const deme::oriQ_t myOriQw = granData->oriQw[myOwner];
-            const deme::oriQ_t myOriQx = granData->oriQx[myOwner];
-            const deme::oriQ_t myOriQy = granData->oriQy[myOwner];
-            const deme::oriQ_t myOriQz = granData->oriQz[myOwner];
-
-            // torque_inForceForm is usually the contribution of rolling resistance and it contributes to torque only,
-            // not linear velocity
-            float3 myF = (F + granData->contactTorque_convToForce[myID]);
-            // F is in global frame, but it needs to be in local to coordinate with moi and cntPnt
-            applyOriQToVector3<float, deme::oriQ_t>(myF.x, myF.y, myF.z, myOriQw, -myOriQx, -myOriQy, -myOriQz);
-            const float3 angAcc = cross(myCntPnt, myF) / myMOI;
-            atomicAdd(granData->alphaX + myOwner, angAcc.x);
-            atomicAdd(granData->alphaY + myOwner, angAcc.y);
-            atomicAdd(granData->alphaZ + myOwner, angAcc.z);
+        const deme::bodyID_t ownerA = getContactOwnerA(granData, myID);
+        if (ownerSubcycled[ownerA]) {
+            forceToOwnerAcc(granData, ownerA, F, torqueOnlyF, loadContactPointA(granData, myID));
         }
+        const deme::bodyID_t ownerB = getContactOwnerB(granData, myID, thisCntType);
+        if (ownerSubcycled[ownerB]) {
+            forceToOwnerAcc(granData, ownerB, -1.f * F, -1.f * torqueOnlyF, loadContactPointB(granData, myID));
+        }
+    }
+}
 
-        // Take care of B
-        {
-            float myMass;
-            float3 myMOI;
-            const deme::bodyID_t idGeo = granData->idGeometryB[myID];
-            const float3 myCntPnt = granData->contactPointGeometryB[myID];
-
-            deme::bodyID_t myOwner;
-            if (thisCntType == deme::SPHERE_SPHERE_CONTACT) {
-                myOwner = granData->ownerClumpBody[idGeo];
-            } else if (thisCntType == deme::SPHERE_MESH_CONTACT) {
-                myOwner = granData->ownerMesh[idGeo];
-            } else {
-                // This is a sphere--analytical geometry contact, its owner is jitified
-                myOwner = objOwner[idGeo];
-            }
-
-            // Get my mass info from either jitified arrays or global memory
-            // Outputs myMass
-            // Use an input named exactly `myOwner' which is the id of this owner
-            {
-                _massAcqStrat_;
-                _moiAcqStrat_;
-            }
-
-            atomicAdd(granData->aX + myOwner, -F.x / myMass);
-            atomicAdd(granData->aY + myOwner, -F.y / myMass);
-            atomicAdd(granData->aZ + myOwner, -F.z / myMass);
-
-            // Then ang acc
-            const deme::oriQ_t myOriQw = granData->oriQw[myOwner];
-            const deme::oriQ_t myOriQx = granData->oriQx[myOwner];
-            const deme::oriQ_t myOriQy = granData->oriQy[myOwner];
-            const deme::oriQ_t myOriQz = granData->oriQz[myOwner];
-
-            // torque_inForceForm is usually the contribution of rolling resistance and it contributes to torque only,
-            // not linear velocity
-            float3 myF = -1.f * (F + granData->contactTorque_convToForce[myID]);
-            // F is in global frame, but it needs to be in local to coordinate with moi and cntPnt
-            applyOriQToVector3<float, deme::oriQ_t>(myF.x, myF.y, myF.z, myOriQw, -myOriQx, -myOriQy, -myOriQz);
-            const float3 angAcc = cross(myCntPnt, myF) / myMOI;
-            atomicAdd(granData->alphaX + myOwner, angAcc.x);
-            atomicAdd(granData->alphaY + myOwner, angAcc.y);
-            atomicAdd(granData->alphaZ + myOwner, angAcc.z);
+// Flag the contacts that involve an owner in a subcycled family
+__global__ void markSubcycledContacts(deme::DEMDataDT* granData, deme::notStupidBool_t* isSubcycled, size_t n) {
+    deme::contactPairs_t myID = blockIdx.x * blockDim.x + threadIdx.x;
+    if (myID < n) {
+        deme::contact_t thisCntType = granData->contactType[myID];
+        if (thisCntType == deme::NOT_A_CONTACT) {
+            isSubcycled[myID] = 0;
+        } else {
+            const deme::bodyID_t ownerA = getContactOwnerA(granData, myID);
+            const deme::bodyID_t ownerB = getContactOwnerB(granData, myID, thisCntType);
+            isSubcycled[myID] = (granData->familySubcycled[granData->familyID[ownerA]] ||
+                                 granData->familySubcycled[granData->familyID[ownerB]]);
         }
     }
 }
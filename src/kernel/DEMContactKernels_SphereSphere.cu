@@ -62,6 +62,7 @@ inline __device__ bool calcContactPoint(deme::DEMSimParams* simParams,
                                         const double& YB,
                                         const double& ZB,
                                         const float& rB,
+                                        const unsigned int& binLevel,
                                         deme::binID_t& binID,
                                         float artificialMarginA,
                                         float artificialMarginB) {
@@ -74,16 +75,21 @@ inline __device__ bool calcContactPoint(deme::DEMSimParams* simParams,
     float normZ;
     double overlapDepth;  // overlapDepth is needed for making artificial contacts not too loose.
 
+    // In periodic directions, A is in contact with the closest image of B
+    double imageXB = XB, imageYB = YB, imageZB = ZB;
+    toClosestPeriodicImage(simParams, XA, YA, ZA, imageXB, imageYB, imageZB);
     //// TODO: I guess <float, float> is fine too.
-    in_contact = checkSpheresOverlap<double, float>(XA, YA, ZA, rA, XB, YB, ZB, rB, contactPntX, contactPntY,
-                                                    contactPntZ, normX, normY, normZ, overlapDepth);
+    in_contact = checkSpheresOverlap<double, float>(XA, YA, ZA, rA, imageXB, imageYB, imageZB, rB, contactPntX,
+                                                    contactPntY, contactPntZ, normX, normY, normZ, overlapDepth);
 
     // The contact needs to be larger than the smaller articifical margin so that we don't double count the artificially
     // added margin. This is a design choice, to avoid having too many contact pairs when adding artificial margins.
     float artificialMargin = (artificialMarginA < artificialMarginB) ? artificialMarginA : artificialMarginB;
     in_contact = in_contact && (overlapDepth > (double)artificialMargin);
-    binID = getPointBinID<deme::binID_t>(contactPntX, contactPntY, contactPntZ, simParams->binSize, simParams->nbX,
-                                         simParams->nbY);
+    // The bin (of the given level) the contact point is in. A contact point out of the period is wrapped into it, so
+    // that of all the bins where A and (an image of) B meet, exactly one reports the contact.
+    wrapPointIntoPeriod(simParams, contactPntX, contactPntY, contactPntZ);
+    binID = getPointBinIDAtLevel<deme::binID_t>(contactPntX, contactPntY, contactPntZ, simParams, binLevel);
     return in_contact;
 }
 
@@ -117,6 +123,8 @@ __global__ void getNumberOfSphereContactsEachBin(deme::DEMSimParams* simParams,
         }
         return;
     }
+    // With hierarchical binning, the spheres in this bin are all binned in its level, and so are contact points
+    const unsigned int binLevel = binLevelOf(simParams, binID);
     if (threadIdx.x == 0 && nBodiesInBin > simParams->errOutBinSphNum) {
         DEME_ABORT_KERNEL(
             "Bin %u contains %u sphere components, exceeding maximum allowance (%u).\nIf you want the solver to run "
@@ -183,7 +191,8 @@ __global__ void getNumberOfSphereContactsEachBin(deme::DEMSimParams* simParams,
                 deme::binID_t contactPntBin;
                 bool in_contact = calcContactPoint(simParams, bodyX[bodyA], bodyY[bodyA], bodyZ[bodyA], radii[bodyA],
                                                    bodyX[bodyB], bodyY[bodyB], bodyZ[bodyB], radii[bodyB],
-                                                   contactPntBin, granData->familyExtraMarginSize[bodyAFamily],
+                                                   binLevel, contactPntBin,
+                                                   granData->familyExtraMarginSize[bodyAFamily],
                                                    granData->familyExtraMarginSize[bodyBFamily]);
                 /*
                 if (in_contact) {
@@ -248,7 +257,8 @@ __global__ void getNumberOfSphereContactsEachBin(deme::DEMSimParams* simParams,
                 deme::binID_t contactPntBin;
                 bool in_contact = calcContactPoint(simParams, bodyX[myThreadID], bodyY[myThreadID], bodyZ[myThreadID],
                                                    radii[myThreadID], cur_bodyX, cur_bodyY, cur_bodyZ, cur_radii,
-                                                   contactPntBin, granData->familyExtraMarginSize[bodyAFamily],
+                                                   binLevel, contactPntBin,
+                                                   granData->familyExtraMarginSize[bodyAFamily],
                                                    granData->familyExtraMarginSize[cur_ownerFamily]);
 
                 if (in_contact && (contactPntBin == binID)) {
@@ -290,6 +300,7 @@ __global__ void populateSphSphContactPairsEachBin(deme::DEMSimParams* simParams,
     if (nBodiesInBin <= 1 || binID == deme::NULL_BINID) {
         return;
     }
+    const unsigned int binLevel = binLevelOf(simParams, binID);
     // No need to check max spheres one more time
 
     const deme::spheresBinTouches_t myThreadID = threadIdx.x;
@@ -355,7 +366,8 @@ __global__ void populateSphSphContactPairsEachBin(deme::DEMSimParams* simParams,
                 deme::binID_t contactPntBin;
                 bool in_contact = calcContactPoint(simParams, bodyX[bodyA], bodyY[bodyA], bodyZ[bodyA], radii[bodyA],
                                                    bodyX[bodyB], bodyY[bodyB], bodyZ[bodyB], radii[bodyB],
-                                                   contactPntBin, granData->familyExtraMarginSize[bodyAFamily],
+                                                   binLevel, contactPntBin,
+                                                   granData->familyExtraMarginSize[bodyAFamily],
                                                    granData->familyExtraMarginSize[bodyBFamily]);
 
                 if (in_contact && (contactPntBin == binID)) {
@@ -405,7 +417,8 @@ __global__ void populateSphSphContactPairsEachBin(deme::DEMSimParams* simParams,
                 deme::binID_t contactPntBin;
                 bool in_contact = calcContactPoint(simParams, bodyX[myThreadID], bodyY[myThreadID], bodyZ[myThreadID],
                                                    radii[myThreadID], cur_bodyX, cur_bodyY, cur_bodyZ, cur_radii,
-                                                   contactPntBin, granData->familyExtraMarginSize[bodyAFamily],
+                                                   binLevel, contactPntBin,
+                                                   granData->familyExtraMarginSize[bodyAFamily],
                                                    granData->familyExtraMarginSize[cur_ownerFamily]);
 
                 if (in_contact && (contactPntBin == binID)) {
@@ -434,3 +447,193 @@ __global__ void populateSphSphContactPairsEachBin(deme::DEMSimParams* simParams,
         }
     }
 }
+
+// Hierarchical binning: a sphere looks for contacts with the spheres binned in the coarser levels, in the bins of those
+// levels it touches. A contact is taken only from the lowest bin both spheres touch, so it is found once. (Not from the
+// bin of the contact point like in the bin-wise sweeps: a small sphere deep in a large one may not touch that bin.)
+// Returns the number of contacts found; if idSphA is not NULL, they are also written from myReportOffset on.
+inline __device__ deme::contactPairs_t findCoarserLevelSphereContacts(deme::DEMSimParams* simParams,
+                                                                      deme::DEMDataKT* granData,
+                                                                      const deme::bodyID_t& sphereID,
+                                                                      deme::bodyID_t* sphereIDsEachBinTouches_sorted,
+                                                                      deme::binID_t* activeBinIDs,
+                                                                      deme::spheresBinTouches_t* numSpheresBinTouches,
+                                                                      deme::binSphereTouchPairs_t* sphereIDsLookUpTable,
+                                                                      size_t nActiveBins,
+                                                                      const deme::contactPairs_t& myReportOffset,
+                                                                      const deme::contactPairs_t& myReportOffset_end,
+                                                                      deme::bodyID_t* idSphA,
+                                                                      deme::bodyID_t* idSphB,
+                                                                      deme::contact_t* dType) {
+    deme::contactPairs_t contact_count = 0;
+    const unsigned int myLevel = granData->sphereBinLevel[sphereID];
+    if (myLevel + 1 >= simParams->nBinLevels) {
+        return contact_count;
+    }
+    deme::bodyID_t myOwnerID, myBodyID;
+    deme::family_t myFamily;
+    float myRadius;
+    double myX, myY, myZ;
+    fillSharedMemSpheres<float, double>(simParams, granData, 0, sphereID, &myOwnerID, &myBodyID, &myFamily, &myRadius,
+                                        &myX, &myY, &myZ);
+    for (unsigned int lvl = myLevel + 1; lvl < simParams->nBinLevels; lvl++) {
+        const double binSize = binSizeAtLevel(simParams, lvl);
+        const double myRadiusSpan = myRadius / binSize;
+        const deme::binID_t nbX = simParams->nbXLevel[lvl];
+        const deme::binID_t nbY = simParams->nbYLevel[lvl];
+        const deme::binID_t nbZ = simParams->nbZLevel[lvl];
+        deme::binID_t loX, hiX, loY, hiY, loZ, hiZ;
+        sphereBinRange1D<deme::binID_t>(loX, hiX, myX / binSize, myRadiusSpan, nbX);
+        sphereBinRange1D<deme::binID_t>(loY, hiY, myY / binSize, myRadiusSpan, nbY);
+        sphereBinRange1D<deme::binID_t>(loZ, hiZ, myZ / binSize, myRadiusSpan, nbZ);
+        for (deme::binID_t k = loZ; k <= hiZ; k++) {
+            for (deme::binID_t j = loY; j <= hiY; j++) {
+                for (deme::binID_t i = loX; i <= hiX; i++) {
+                    const deme::binID_t binID =
+                        simParams->binLevelOffset[lvl] + binIDFrom3Indices<deme::binID_t>(i, j, k, nbX, nbY, nbZ);
+                    // Does any sphere live in this bin? (Signed indices, so the search can step below 0.)
+                    long long binInd;
+                    if (!cuda_binary_search<deme::binID_t, long long>(activeBinIDs, binID, 0,
+                                                                      (long long)nActiveBins - 1, binInd)) {
+                        continue;
+                    }
+                    const deme::binSphereTouchPairs_t thisBodiesTableEntry = sphereIDsLookUpTable[binInd];
+                    for (deme::spheresBinTouches_t n = 0; n < numSpheresBinTouches[binInd]; n++) {
+                        deme::bodyID_t otherOwnerID, otherBodyID;
+                        deme::family_t otherFamily;
+                        float otherRadius;
+                        double otherX, otherY, otherZ;
+                        fillSharedMemSpheres<float, double>(
+                            simParams, granData, 0, sphereIDsEachBinTouches_sorted[thisBodiesTableEntry + n],
+                            &otherOwnerID, &otherBodyID, &otherFamily, &otherRadius, &otherX, &otherY, &otherZ);
+                        if (myOwnerID == otherOwnerID)
+                            continue;
+                        unsigned int maskMatID = locateMaskPair<unsigned int>(myFamily, otherFamily);
+                        if (granData->familyMasks[maskMatID] != deme::DONT_PREVENT_CONTACT) {
+                            continue;
+                        }
+
+                        // The lowest bin the 2 spheres both touch is where the lower ends of their ranges meet
+                        const double otherRadiusSpan = otherRadius / binSize;
+                        deme::binID_t otherLo, otherHi;
+                        sphereBinRange1D<deme::binID_t>(otherLo, otherHi, otherX / binSize, otherRadiusSpan, nbX);
+                        if (i != DEME_MAX(loX, otherLo))
+                            continue;
+                        sphereBinRange1D<deme::binID_t>(otherLo, otherHi, otherY / binSize, otherRadiusSpan, nbY);
+                        if (j != DEME_MAX(loY, otherLo))
+                            continue;
+                        sphereBinRange1D<deme::binID_t>(otherLo, otherHi, otherZ / binSize, otherRadiusSpan, nbZ);
+                        if (k != DEME_MAX(loZ, otherLo))
+                            continue;
+
+                        deme::binID_t contactPntBin;
+                        bool in_contact = calcContactPoint(simParams, myX, myY, myZ, myRadius, otherX, otherY, otherZ,
+                                                           otherRadius, lvl, contactPntBin,
+                                                           granData->familyExtraMarginSize[myFamily],
+                                                           granData->familyExtraMarginSize[otherFamily]);
+                        if (in_contact) {
+                            const deme::contactPairs_t inSphereOffset = myReportOffset + contact_count;
+                            if (idSphA != NULL && inSphereOffset < myReportOffset_end) {
+                                // Like in the bin-wise sweeps, the smaller sphere ID goes first
+                                idSphA[inSphereOffset] = DEME_MIN(myBodyID, otherBodyID);
+                                idSphB[inSphereOffset] = DEME_MAX(myBodyID, otherBodyID);
+                                dType[inSphereOffset] = deme::SPHERE_SPHERE_CONTACT;
+                            }
+                            contact_count++;
+                        }
+                    }
+                }
+            }
+        }
+    }
+    return contact_count;
+}
+
+__global__ void getNumberOfCrossLevelSphereContacts(deme::DEMSimParams* simParams,
+                                                    deme::DEMDataKT* granData,
+                                                    deme::bodyID_t* sphereIDsEachBinTouches_sorted,
+                                                    deme::binID_t* activeBinIDs,
+                                                    deme::spheresBinTouches_t* numSpheresBinTouches,
+                                                    deme::binSphereTouchPairs_t* sphereIDsLookUpTable,
+                                                    deme::contactPairs_t* numCrossLevelContacts,
+                                                    size_t nActiveBins) {
+    deme::bodyID_t sphereID = blockIdx.x * blockDim.x + threadIdx.x;
+    if (sphereID < simParams->nSpheresGM) {
+        numCrossLevelContacts[sphereID] = findCoarserLevelSphereContacts(
+            simParams, granData, sphereID, sphereIDsEachBinTouches_sorted, activeBinIDs, numSpheresBinTouches,
+            sphereIDsLookUpTable, nActiveBins, 0, 0, NULL, NULL, NULL);
+    }
+}
+
+__global__ void populateCrossLevelSphereContacts(deme::DEMSimParams* simParams,
+                                                 deme::DEMDataKT* granData,
+                                                 deme::bodyID_t* sphereIDsEachBinTouches_sorted,
+                                                 deme::binID_t* activeBinIDs,
+                                                 deme::spheresBinTouches_t* numSpheresBinTouches,
+                                                 deme::binSphereTouchPairs_t* sphereIDsLookUpTable,
+                                                 deme::contactPairs_t* crossLevelReportOffsets,
+                                                 deme::bodyID_t* idSphA,
+                                                 deme::bodyID_t* idSphB,
+                                                 deme::contact_t* dType,
+                                                 size_t nActiveBins) {
+    deme::bodyID_t sphereID = blockIdx.x * blockDim.x + threadIdx.x;
+    if (sphereID < simParams->nSpheresGM) {
+        const deme::contactPairs_t myReportOffset = crossLevelReportOffsets[sphereID];
+        const deme::contactPairs_t myReportOffset_end = crossLevelReportOffsets[sphereID + 1];
+        deme::contactPairs_t nFound = findCoarserLevelSphereContacts(
+            simParams, granData, sphereID, sphereIDsEachBinTouches_sorted, activeBinIDs, numSpheresBinTouches,
+            sphereIDsLookUpTable, nActiveBins, myReportOffset, myReportOffset_end, idSphA, idSphB, dType);
+        // Purely for safety, in case the 2 sweeps do not agree
+        for (deme::contactPairs_t inSphereOffset = myReportOffset + nFound; inSphereOffset < myReportOffset_end;
+             inSphereOffset++) {
+            dType[inSphereOffset] = deme::NOT_A_CONTACT;
+        }
+    }
+}
+
+// Mark which of the stored contact candidates are contacts at this CD step. Sphere--sphere candidates are tested again
+// with the margins as they are now (minus the skin, if the margins still have it), like in the binned CD; the other
+// candidates are kept, and dT tells whether they are in contact as it does for any contact pair kT hands over.
+__global__ void markContactCandidatesToKeep(deme::DEMSimParams* simParams,
+                                            deme::DEMDataKT* granData,
+                                            float skinInMargin,
+                                            deme::notStupidBool_t* keep,
+                                            size_t nCandidates) {
+    size_t myID = blockIdx.x * blockDim.x + threadIdx.x;
+    if (myID < nCandidates) {
+        const deme::contact_t myType = granData->verletContactType[myID];
+        deme::notStupidBool_t keepThis = (myType != deme::NOT_A_CONTACT);
+        if (myType == deme::SPHERE_SPHERE_CONTACT) {
+            deme::bodyID_t ownerA, ownerB, sphereA, sphereB;
+            deme::family_t familyA, familyB;
+            float radA, radB;
+            double XA, YA, ZA, XB, YB, ZB;
+            fillSharedMemSpheres<float, double>(simParams, granData, 0, granData->verletIdGeometryA[myID], &ownerA,
+                                                &sphereA, &familyA, &radA, &XA, &YA, &ZA);
+            fillSharedMemSpheres<float, double>(simParams, granData, 0, granData->verletIdGeometryB[myID], &ownerB,
+                                                &sphereB, &familyB, &radB, &XB, &YB, &ZB);
+            radA -= skinInMargin;
+            radB -= skinInMargin;
+            // A candidate is stored once, so which bin its contact point is in does not matter here
+            deme::binID_t contactPntBin;
+            keepThis = calcContactPoint(simParams, XA, YA, ZA, radA, XB, YB, ZB, radB, 0, contactPntBin,
+                                        granData->familyExtraMarginSize[familyA],
+                                        granData->familyExtraMarginSize[familyB]);
+        }
+        keep[myID] = keepThis;
+    }
+}
+
+// Gather the kept contact candidates into the contact arrays, which stay sorted by idA
+__global__ void gatherKeptContactCandidates(deme::DEMDataKT* granData,
+                                            deme::notStupidBool_t* keep,
+                                            deme::contactPairs_t* keepOffsets,
+                                            size_t nCandidates) {
+    size_t myID = blockIdx.x * blockDim.x + threadIdx.x;
+    if (myID < nCandidates && keep[myID]) {
+        const deme::contactPairs_t myOffset = keepOffsets[myID];
+        granData->idGeometryA[myOffset] = granData->verletIdGeometryA[myID];
+        granData->idGeometryB[myOffset] = granData->verletIdGeometryB[myID];
+        granData->contactType[myOffset] = granData->verletContactType[myID];
+    }
+}
@@ -148,6 +148,8 @@ __global__ void getNumberOfSphTriContactsEachBin(deme::DEMSimParams* simParams,
 
     const deme::trianglesBinTouches_t nTriInBin = numTrianglesBinTouches[blockIdx.x];
     const deme::binID_t binID = activeBinIDsForTri[blockIdx.x];
+    // The level of this bin, in which contact points are located (see hierarchical binning)
+    const unsigned int binLevel = binLevelOf(simParams, binID);
     if (threadIdx.x == 0 && nTriInBin > simParams->errOutBinTriNum) {
         DEME_ABORT_KERNEL(
             "Bin %u contains %u triangular mesh facets, exceeding maximum allowance (%u).\nIf you want the solver to "
@@ -249,8 +251,8 @@ __global__ void getNumberOfSphTriContactsEachBin(deme::DEMSimParams* simParams,
                     // triangles; or we will have double count problems. Use the first triangle as standard.
                     if (in_contact_A || in_contact_B) {
                         snap_to_face(triANode1[ind], triANode2[ind], triANode3[ind], sphXYZ, cntPnt);
-                        deme::binID_t contactPntBin = getPointBinID<deme::binID_t>(
-                            cntPnt.x, cntPnt.y, cntPnt.z, simParams->binSize, simParams->nbX, simParams->nbY);
+                        deme::binID_t contactPntBin =
+                            getPointBinIDAtLevel<deme::binID_t>(cntPnt.x, cntPnt.y, cntPnt.z, simParams, binLevel);
                         if (contactPntBin == binID) {
                             atomicAdd(&blockPairCnt, 1);
                         }
@@ -305,6 +307,8 @@ __global__ void populateTriSphContactsEachBin(deme::DEMSimParams* simParams,
     const deme::trianglesBinTouches_t nTriInBin = numTrianglesBinTouches[blockIdx.x];
     const deme::spheresBinTouches_t myThreadID = threadIdx.x;
     const deme::binID_t binID = activeBinIDsForTri[blockIdx.x];
+    // The level of this bin, in which contact points are located (see hierarchical binning)
+    const unsigned int binLevel = binLevelOf(simParams, binID);
     // But what is the index of the same binID in array activeBinIDs? Well, mapTriActBinToSphActBin comes to rescure.
     const deme::binID_t indForAcqSphInfo = mapTriActBinToSphActBin[blockIdx.x];
     // If it is not an active bin from the perspective of the spheres, then we can move on
@@ -397,8 +401,8 @@ __global__ void populateTriSphContactsEachBin(deme::DEMSimParams* simParams,
                     // triangles; or we will have double count problems. Use the first triangle as standard.
                     if (in_contact_A || in_contact_B) {
                         snap_to_face(triANode1[ind], triANode2[ind], triANode3[ind], sphXYZ, cntPnt);
-                        deme::binID_t contactPntBin = getPointBinID<deme::binID_t>(
-                            cntPnt.x, cntPnt.y, cntPnt.z, simParams->binSize, simParams->nbX, simParams->nbY);
+                        deme::binID_t contactPntBin =
+                            getPointBinIDAtLevel<deme::binID_t>(cntPnt.x, cntPnt.y, cntPnt.z, simParams, binLevel);
                         if (contactPntBin == binID) {
                             deme::contactPairs_t inBlockOffset = myReportOffset + atomicAdd(&blockPairCnt, 1);
                             if (inBlockOffset < myReportOffset_end) {
@@ -1,4 +1 @@
-granData->contactPointGeometryA[myContactID] = locCPA;
-granData->contactPointGeometryB[myContactID] = locCPB;
-granData->contactForces[myContactID] = force;
-granData->contactTorque_convToForce[myContactID] = torque_only_force;
+storeContactInfo(granData, myContactID, locCPA, locCPB, force, torque_only_force);
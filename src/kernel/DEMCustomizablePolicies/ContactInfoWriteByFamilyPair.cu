@@ -0,0 +1,18 @@
+// How this contact is recorded depends on the families of its owners
+{
+    const deme::notStupidBool_t recordPolicy =
+        granData->familyForceRecord[locateMaskPair<unsigned int>(AOwnerFamily, BOwnerFamily)];
+    if (recordPolicy == deme::CNT_RECORD_FULL) {
+        // The record arrays only hold the contacts recorded in full, at the places found before this step
+        const deme::contactPairs_t recordSlot = granData->fullRecordSlot[myContactID];
+        if (recordSlot != deme::NULL_MAPPING_PARTNER) {
+            storeContactInfo(granData, recordSlot, locCPA, locCPB, force, torque_only_force);
+        }
+    } else if (recordPolicy == deme::CNT_RECORD_AGGREGATE) {
+        // The torque-only force, like the force, acts at the contact point
+        const float3 totalForce = force + torque_only_force;
+        addToOwnerCntAggregates(granData, ownerOfA, force, cross(to_float3(contactPnt - AOwnerPos), totalForce));
+        addToOwnerCntAggregates(granData, ownerOfB, -1.f * force,
+                                cross(to_float3(contactPnt - BOwnerPos), -1.f * totalForce));
+    }
+}
@@ -161,6 +161,74 @@ inline __device__ void applyOriQToVector3(T1& X, T1& Y, T1& Z, const T2& Qw, con
         ((T2)2.0 * (Qw * Qw + Qz * Qz) - (T2)1.0) * oldZ;
 }
 
+// An upper bound on how far any point of an owner has moved since a reference state, given the displacement of its CoM,
+// its orientation now and at the reference state, and its extent (max distance from the CoM to any of its points). A
+// rotation by theta moves a point at distance r by 2 r sin(theta / 2), which is no more than 2 r |Q - Q_ref| taking the
+// closer one of Q_ref and -Q_ref.
+template <typename T1, typename T2>
+inline __device__ T1 ownerDriftBound(const T1& dX,
+                                     const T1& dY,
+                                     const T1& dZ,
+                                     const T2& Qw,
+                                     const T2& Qx,
+                                     const T2& Qy,
+                                     const T2& Qz,
+                                     const T2& refQw,
+                                     const T2& refQx,
+                                     const T2& refQy,
+                                     const T2& refQz,
+                                     const float& extent) {
+    T2 dQ2 = (Qw - refQw) * (Qw - refQw) + (Qx - refQx) * (Qx - refQx) + (Qy - refQy) * (Qy - refQy) +
+             (Qz - refQz) * (Qz - refQz);
+    T2 dQ2Flip = (Qw + refQw) * (Qw + refQw) + (Qx + refQx) * (Qx + refQx) + (Qy + refQy) * (Qy + refQy) +
+                 (Qz + refQz) * (Qz + refQz);
+    T2 dQ = sqrt((dQ2 < dQ2Flip) ? dQ2 : dQ2Flip);
+    return sqrt(dX * dX + dY * dY + dZ * dZ) + (T1)2 * (T1)extent * (T1)dQ;
+}
+
+// Whether an owner may now be in contact with something that is not among the contact candidates found with a skin:
+// either it changed family, or its drift plus the growth of its margin is more than half the skin
+template <typename T1>
+inline __device__ bool isContactCandidateExpired(const T1& drift,
+                                                 const float& margin,
+                                                 const float& refMargin,
+                                                 const deme::family_t& family,
+                                                 const deme::family_t& refFamily,
+                                                 const float& skin) {
+    T1 marginGrowth = (margin > refMargin) ? (T1)(margin - refMargin) : (T1)0;
+    return (family != refFamily) || (drift + marginGrowth > (T1)skin / (T1)2);
+}
+
+// Whether an owner is sleeping: sleeping is enabled, and the owner has been quiescent for long enough
+inline __device__ bool isOwnerAsleep(deme::DEMSimParams* simParams,
+                                     deme::DEMDataDT* granData,
+                                     const deme::bodyID_t& owner) {
+    return (simParams->sleepSteps > 0) && (granData->sleepCounter[owner] >= simParams->sleepSteps);
+}
+
+// Wake an owner up and restart its count of quiescent steps. Several threads may wake the same owner at once, so only
+// the one that finds it asleep takes it off the count of sleeping owners.
+inline __device__ void wakeOwnerUp(deme::DEMSimParams* simParams,
+                                   deme::DEMDataDT* granData,
+                                   const deme::bodyID_t& owner) {
+    unsigned int count = atomicExch(granData->sleepCounter + owner, 0u);
+    if ((simParams->sleepSteps > 0) && (count >= simParams->sleepSteps)) {
+        atomicSub(&(granData->nSleepingOwners), 1u);
+    }
+}
+
+// Whether an owner's speed and angular speed are both below the sleeping thresholds
+inline __device__ bool isOwnerQuiescent(deme::DEMSimParams* simParams,
+                                        deme::DEMDataDT* granData,
+                                        const deme::bodyID_t& owner) {
+    float v2 = dot3<float>(granData->vX[owner], granData->vY[owner], granData->vZ[owner], granData->vX[owner],
+                           granData->vY[owner], granData->vZ[owner]);
+    float omg2 = dot3<float>(granData->omgBarX[owner], granData->omgBarY[owner], granData->omgBarZ[owner],
+                             granData->omgBarX[owner], granData->omgBarY[owner], granData->omgBarZ[owner]);
+    return (v2 < simParams->sleepLinVel * simParams->sleepLinVel) &&
+           (omg2 < simParams->sleepAngVel * simParams->sleepAngVel);
+}
+
 template <typename T1>
 inline __device__ T1 distSquared(const T1& x1, const T1& y1, const T1& z1, const T1& x2, const T1& y2, const T1& z2) {
     return (x1 - x2) * (x1 - x2) + (y1 - y2) * (y1 - y2) + (z1 - z2) * (z1 - z2);
@@ -169,7 +237,7 @@ inline __device__ T1 distSquared(const T1& x1, const T1& y1, const T1& z1, const
 // Get the maginitude of a 3-component vector
 template <typename T1>
 inline __device__ T1 magVector3(T1& x, T1& y, T1& z) {
-    return magnitude = sqrt(x * x + y * y + z * z);
+    return sqrt(x * x + y * y + z * z);
 }
 
 // Normalize a 3-component vector
@@ -326,6 +394,140 @@ binIDFrom3Indices(const T1& X, const T1& Y, const T1& Z, const T1& nbX, const T1
     }
 }
 
+// The lowest and highest indices of the bins a sphere touches along one direction, given its center and radius in units
+// of bin size. This is the range getNumberOfBinsEachSphereTouches counts.
+template <typename T1>
+inline __device__ void sphereBinRange1D(T1& lo, T1& hi, const double& myBin, const double& myRadiusSpan, const T1& nb) {
+    lo = (T1)((myBin - myRadiusSpan > 0.0) ? myBin - myRadiusSpan : 0.0);
+    hi = (myBin + myRadiusSpan < (double)nb) ? (T1)(myBin + myRadiusSpan) : nb - 1;
+}
+
+// Wrap a coordinate into the period [start, start + length) of a direction, if that direction is periodic
+template <typename T1>
+inline __device__ void wrapIntoPeriod(T1& X, const bool& periodic, const double& start, const double& length) {
+    if (periodic) {
+        X -= (T1)(length * floor(((double)X - start) / length));
+    }
+}
+
+// The shift to add to coordinate difference dX (along a direction) to make it that of the closest periodic images
+template <typename T1>
+inline __device__ T1 periodicImageShift(const T1& dX, const bool& periodic, const double& length) {
+    return periodic ? (T1)(-length * round((double)dX / length)) : (T1)0;
+}
+
+// Wrap a point into the periodic box, in the periodic directions
+inline __device__ void wrapPointIntoPeriod(deme::DEMSimParams* simParams, double& X, double& Y, double& Z) {
+    wrapIntoPeriod<double>(X, simParams->periodicX, simParams->periodStartX, simParams->periodX);
+    wrapIntoPeriod<double>(Y, simParams->periodicY, simParams->periodStartY, simParams->periodY);
+    wrapIntoPeriod<double>(Z, simParams->periodicZ, simParams->periodStartZ, simParams->periodZ);
+}
+
+// Move point B to its periodic image closest to point A
+inline __device__ void toClosestPeriodicImage(deme::DEMSimParams* simParams,
+                                              const double& XA,
+                                              const double& YA,
+                                              const double& ZA,
+                                              double& XB,
+                                              double& YB,
+                                              double& ZB) {
+    XB += periodicImageShift<double>(XB - XA, simParams->periodicX, simParams->periodX);
+    YB += periodicImageShift<double>(YB - YA, simParams->periodicY, simParams->periodY);
+    ZB += periodicImageShift<double>(ZB - ZA, simParams->periodicZ, simParams->periodZ);
+}
+
+// The ranges of bin indices a sphere touches along one direction, with its center and radius in units of bin size. In
+// a periodic direction, a sphere sticking out of one end of the period also touches the bins its image at the other end
+// touches. Returns the number of ranges (1 or 2); ranges that overlap or abut are merged, so no bin is listed twice.
+template <typename T1>
+inline __device__ unsigned int periodicSphereBinRanges1D(T1* lo,
+                                                         T1* hi,
+                                                         const double& myBin,
+                                                         const double& myRadiusSpan,
+                                                         const T1& nb,
+                                                         const bool& periodic,
+                                                         const double& startSpan,
+                                                         const double& lengthSpan) {
+    sphereBinRange1D<T1>(lo[0], hi[0], myBin, myRadiusSpan, nb);
+    if (!periodic) {
+        return 1;
+    }
+    double imageBin;
+    if (myBin - myRadiusSpan < startSpan) {
+        imageBin = myBin + lengthSpan;
+    } else if (myBin + myRadiusSpan >= startSpan + lengthSpan) {
+        imageBin = myBin - lengthSpan;
+    } else {
+        return 1;
+    }
+    T1 imageLo, imageHi;
+    sphereBinRange1D<T1>(imageLo, imageHi, imageBin, myRadiusSpan, nb);
+    if (imageLo > imageHi) {
+        // The image is out of the bins altogether
+        return 1;
+    }
+    if (imageLo > hi[0] + 1 || imageHi + 1 < lo[0]) {
+        lo[1] = imageLo;
+        hi[1] = imageHi;
+        return 2;
+    }
+    lo[0] = (imageLo < lo[0]) ? imageLo : lo[0];
+    hi[0] = (imageHi > hi[0]) ? imageHi : hi[0];
+    return 1;
+}
+
+// Number of the bin--sphere pairs in bins and spheres (n of them, sorted by bin ID then sphere ID) that come before the
+// pair (bin, sphere)
+template <typename T1, typename T2>
+inline __device__ size_t
+countBinSpherePairsBefore(const T1* bins, const T2* spheres, size_t n, const T1& bin, const T2& sphere) {
+    size_t lo = 0, hi = n;
+    while (lo < hi) {
+        size_t mid = (lo + hi) / 2;
+        if (bins[mid] < bin || (bins[mid] == bin && spheres[mid] < sphere)) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+// Edge length of the bins of a level (see hierarchical binning)
+inline __device__ double binSizeAtLevel(deme::DEMSimParams* simParams, const unsigned int& lvl) {
+    return simParams->binSize * (double)(1u << lvl);
+}
+
+// The level of bins a sphere is binned in: the finest one whose bins are no smaller than the sphere's diameter, so it
+// touches at most 2 bins in each direction there (unless it is too large even for the coarsest level)
+inline __device__ unsigned int sphereBinLevel(deme::DEMSimParams* simParams, const double& radius) {
+    unsigned int lvl = 0;
+    while (lvl + 1 < simParams->nBinLevels && 2. * radius > binSizeAtLevel(simParams, lvl)) {
+        lvl++;
+    }
+    return lvl;
+}
+
+// The level a bin belongs to, by its ID
+inline __device__ unsigned int binLevelOf(deme::DEMSimParams* simParams, const deme::binID_t& binID) {
+    unsigned int lvl = 0;
+    while (lvl + 1 < simParams->nBinLevels && binID >= simParams->binLevelOffset[lvl + 1]) {
+        lvl++;
+    }
+    return lvl;
+}
+
+// ID of the bin of a level that a point is in
+template <typename T1>
+inline __device__ T1 getPointBinIDAtLevel(const double& X,
+                                          const double& Y,
+                                          const double& Z,
+                                          deme::DEMSimParams* simParams,
+                                          const unsigned int& lvl) {
+    return simParams->binLevelOffset[lvl] + getPointBinID<T1>(X, Y, Z, binSizeAtLevel(simParams, lvl),
+                                                              simParams->nbXLevel[lvl], simParams->nbYLevel[lvl]);
+}
+
 // This utility function returns the normal to the triangular face defined by
 // the vertices A, B, and C. The face is assumed to be non-degenerate.
 // Note that order of vertices is important!
@@ -524,34 +726,40 @@ inline __device__ deme::contact_t checkSphereEntityOverlap(const T1& A,
 // Triangle-specific helper kernels
 ////////////////////////////////////////////////////////////////////////////////
 
-/// Takes in a triangle ID and figures out an SD AABB for broadphase use
+/// Takes in a triangle ID and figures out an SD AABB for broadphase use, at a level of bins
 __inline__ __device__ void boundingBoxIntersectBin(deme::binID_t* L,
                                                    deme::binID_t* U,
                                                    const float3& vA,
                                                    const float3& vB,
                                                    const float3& vC,
-                                                   deme::DEMSimParams* simParams) {
+                                                   deme::DEMSimParams* simParams,
+                                                   const unsigned int& lvl = 0) {
+    const float binSize = binSizeAtLevel(simParams, lvl);
     float3 min_pt;
     min_pt.x = DEME_MIN(vA.x, DEME_MIN(vB.x, vC.x));
     min_pt.y = DEME_MIN(vA.y, DEME_MIN(vB.y, vC.y));
     min_pt.z = DEME_MIN(vA.z, DEME_MIN(vB.z, vC.z));
 
     // Enlarge bounding box, so that no triangle lies right between 2 layers of bins
-    min_pt -= DEME_BIN_ENLARGE_RATIO_FOR_FACETS * simParams->binSize;
+    min_pt -= DEME_BIN_ENLARGE_RATIO_FOR_FACETS * binSize;
     // A point on a mesh can be out of the simulation world. In this case, becasue we only need to detect their contact
     // with spheres, and spheres are all in the simulation world, so we just clamp out the bins that are outside the
     // simulation world.
-    int3 min_bin = clampBetween<float3, int3>(min_pt / simParams->binSize, make_int3(0, 0, 0),
-                                              make_int3(simParams->nbX - 1, simParams->nbY - 1, simParams->nbZ - 1));
+    int3 min_bin =
+        clampBetween<float3, int3>(min_pt / binSize, make_int3(0, 0, 0),
+                                   make_int3(simParams->nbXLevel[lvl] - 1, simParams->nbYLevel[lvl] - 1,
+                                             simParams->nbZLevel[lvl] - 1));
 
     float3 max_pt;
     max_pt.x = DEME_MAX(vA.x, DEME_MAX(vB.x, vC.x));
     max_pt.y = DEME_MAX(vA.y, DEME_MAX(vB.y, vC.y));
     max_pt.z = DEME_MAX(vA.z, DEME_MAX(vB.z, vC.z));
 
-    max_pt += DEME_BIN_ENLARGE_RATIO_FOR_FACETS * simParams->binSize;
-    int3 max_bin = clampBetween<float3, int3>(max_pt / simParams->binSize, make_int3(0, 0, 0),
-                                              make_int3(simParams->nbX - 1, simParams->nbY - 1, simParams->nbZ - 1));
+    max_pt += DEME_BIN_ENLARGE_RATIO_FOR_FACETS * binSize;
+    int3 max_bin =
+        clampBetween<float3, int3>(max_pt / binSize, make_int3(0, 0, 0),
+                                   make_int3(simParams->nbXLevel[lvl] - 1, simParams->nbYLevel[lvl] - 1,
+                                             simParams->nbZLevel[lvl] - 1));
 
     L[0] = min_bin.x;
     L[1] = min_bin.y;
@@ -562,4 +770,120 @@ __inline__ __device__ void boundingBoxIntersectBin(deme::binID_t* L,
     U[2] = max_bin.z;
 }
 
+////////////////////////////////////////////////////////////////////////////////
+// Contact info storage
+////////////////////////////////////////////////////////////////////////////////
+
+// Pack a vector into 16-bit mantissas with a shared exponent: the largest component maps to [2^14, 2^15). Each
+// component is rounded to a multiple of 2^(e-15), so its error is at most 2^-15 (about 3e-5) of the largest component.
+inline __device__ deme::compactFloat3_t packCompactFloat3(const float3& v) {
+    const float maxComp = DEME_MAX(fabsf(v.x), DEME_MAX(fabsf(v.y), fabsf(v.z)));
+    int e = 0;
+    if (maxComp > 0.f) {
+        frexpf(maxComp, &e);
+    }
+    deme::compactFloat3_t c;
+    c.x = (int16_t)DEME_MIN(DEME_MAX(rintf(ldexpf(v.x, 15 - e)), -32767.f), 32767.f);
+    c.y = (int16_t)DEME_MIN(DEME_MAX(rintf(ldexpf(v.y, 15 - e)), -32767.f), 32767.f);
+    c.z = (int16_t)DEME_MIN(DEME_MAX(rintf(ldexpf(v.z, 15 - e)), -32767.f), 32767.f);
+    c.exp = (int16_t)e;
+    return c;
+}
+
+inline __device__ float3 unpackCompactFloat3(const deme::compactFloat3_t& c) {
+    return make_float3(ldexpf((float)c.x, c.exp - 15), ldexpf((float)c.y, c.exp - 15),
+                       ldexpf((float)c.z, c.exp - 15));
+}
+
+// The following load and store a contact's info in the form the contact storage policy keeps it in. The force and
+// the contact point on B are always kept as float3.
+inline __device__ void storeContactInfo(deme::DEMDataDT* granData,
+                                        deme::contactPairs_t myContactID,
+                                        const float3& locCPA,
+                                        const float3& locCPB,
+                                        const float3& force,
+                                        const float3& torqueOnlyF) {
+    granData->contactForces[myContactID] = force;
+    if (granData->useCompactContactStorage) {
+        granData->compactPointGeometryA[myContactID] = packCompactFloat3(locCPA);
+        granData->compactTorque_convToForce[myContactID] = packCompactFloat3(torqueOnlyF);
+    } else {
+        granData->contactPointGeometryA[myContactID] = locCPA;
+        granData->contactTorque_convToForce[myContactID] = torqueOnlyF;
+    }
+    granData->contactPointGeometryB[myContactID] = locCPB;
+}
+
+inline __device__ void storeContactTorque(deme::DEMDataDT* granData,
+                                          deme::contactPairs_t myContactID,
+                                          const float3& torqueOnlyF) {
+    if (granData->useCompactContactStorage) {
+        granData->compactTorque_convToForce[myContactID] = packCompactFloat3(torqueOnlyF);
+    } else {
+        granData->contactTorque_convToForce[myContactID] = torqueOnlyF;
+    }
+}
+
+inline __device__ float3 loadContactTorque(deme::DEMDataDT* granData, deme::contactPairs_t myContactID) {
+    return granData->useCompactContactStorage ? unpackCompactFloat3(granData->compactTorque_convToForce[myContactID])
+                                              : granData->contactTorque_convToForce[myContactID];
+}
+
+inline __device__ float3 loadContactPointA(deme::DEMDataDT* granData, deme::contactPairs_t myContactID) {
+    return granData->useCompactContactStorage ? unpackCompactFloat3(granData->compactPointGeometryA[myContactID])
+                                              : granData->contactPointGeometryA[myContactID];
+}
+
+inline __device__ float3 loadContactPointB(deme::DEMDataDT* granData, deme::contactPairs_t myContactID) {
+    return granData->contactPointGeometryB[myContactID];
+}
+
+// Round a float to bfloat16 (its top 16 bits), to nearest even. NaN stays NaN, and too large a number becomes inf.
+inline __device__ deme::bf16_t packBF16(float v) {
+    unsigned int bits = __float_as_uint(v);
+    if ((bits & 0x7fffffffu) > 0x7f800000u) {
+        return (deme::bf16_t)((bits >> 16) | 0x40u);
+    }
+    bits += 0x7fffu + ((bits >> 16) & 1u);
+    return (deme::bf16_t)(bits >> 16);
+}
+
+inline __device__ float unpackBF16(deme::bf16_t b) {
+    return __uint_as_float(((unsigned int)b) << 16);
+}
+
+// The following load and store a contact wildcard in the precision it is kept in. The force model works on floats
+// either way.
+inline __device__ float loadContactWildcard(deme::DEMDataDT* granData,
+                                            unsigned int wcNum,
+                                            deme::contactPairs_t myContactID) {
+    return granData->useBF16ContactWildcards ? unpackBF16(granData->contactWildcardsBF16[wcNum][myContactID])
+                                             : granData->contactWildcards[wcNum][myContactID];
+}
+
+inline __device__ void storeContactWildcard(deme::DEMDataDT* granData,
+                                            unsigned int wcNum,
+                                            deme::contactPairs_t myContactID,
+                                            float val) {
+    if (granData->useBF16ContactWildcards) {
+        granData->contactWildcardsBF16[wcNum][myContactID] = packBF16(val);
+    } else {
+        granData->contactWildcards[wcNum][myContactID] = val;
+    }
+}
+
+// Add a contact's force and torque (about the owner's CoM, in global) to an owner's contact aggregates
+inline __device__ void addToOwnerCntAggregates(deme::DEMDataDT* granData,
+                                               deme::bodyID_t myOwner,
+                                               const float3& force,
+                                               const float3& torque) {
+    atomicAdd(&(granData->ownerCntForceSum[myOwner].x), force.x);
+    atomicAdd(&(granData->ownerCntForceSum[myOwner].y), force.y);
+    atomicAdd(&(granData->ownerCntForceSum[myOwner].z), force.z);
+    atomicAdd(&(granData->ownerCntTorqueSum[myOwner].x), torque.x);
+    atomicAdd(&(granData->ownerCntTorqueSum[myOwner].y), torque.y);
+    atomicAdd(&(granData->ownerCntTorqueSum[myOwner].z), torque.z);
+    atomicAdd(granData->ownerCntNum + myOwner, 1u);
+}
+
 #endif
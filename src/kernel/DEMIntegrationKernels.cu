@@ -2,6 +2,15 @@
 #include <DEMHelperKernels.cu>
 #include <DEM/Defines.h>
 
+// Whether the motion of a family is prescribed (or has accelerations added to it); owners of such families never sleep
+inline __device__ bool isFamilyMotionPrescribed(const deme::family_t& family) {
+    switch (family) {
+        _prescribedFamilyCases_;
+        default:
+            return false;
+    }
+}
+
 // Apply presecibed velocity and report whether the `true' physics should be skipped, rather than added on top of that
 template <typename T1, typename T2>
 inline __device__ void applyPrescribedVel(bool& LinXPrescribed,
@@ -158,6 +167,7 @@ inline __device__ void integrateVel(deme::bodyID_t thisClump,
 // }
 
 inline __device__ void integratePos(deme::bodyID_t thisClump,
+                                    deme::DEMSimParams* simParams,
                                     deme::DEMDataDT* granData,
                                     float3 v,
                                     float3 omgBar,
@@ -190,6 +200,8 @@ inline __device__ void integratePos(deme::bodyID_t thisClump,
         Y += (double)v.y * h;
         Z += (double)v.z * h;
     }
+    // An owner leaving the period in a periodic direction re-enters from the other end
+    wrapPointIntoPeriod(simParams, X, Y, Z);
     positionToVoxelID<deme::voxelID_t, deme::subVoxelPos_t, double>(
         granData->voxelID[thisClump], granData->locX[thisClump], granData->locY[thisClump], granData->locZ[thisClump],
         X, Y, Z, _nvXp2_, _nvYp2_, _voxelSize_, _l_);
@@ -213,13 +225,72 @@ inline __device__ void integratePos(deme::bodyID_t thisClump,
     }
 }
 
-__global__ void integrateOwners(deme::DEMSimParams* simParams, deme::DEMDataDT* granData) {
+// Count the steps an owner has been quiescent in a row. When the count reaches the number of steps required, the owner
+// goes to sleep, and its velocities are zeroed so it is at rest.
+inline __device__ void updateSleepCounter(deme::bodyID_t thisClump,
+                                          deme::DEMSimParams* simParams,
+                                          deme::DEMDataDT* granData) {
+    if (isFamilyMotionPrescribed(granData->familyID[thisClump]) || !isOwnerQuiescent(simParams, granData, thisClump)) {
+        granData->sleepCounter[thisClump] = 0;
+        return;
+    }
+    // An owner gets here awake, so its count is below sleepSteps, and it reaches sleepSteps at most once
+    unsigned int count = granData->sleepCounter[thisClump] + 1;
+    granData->sleepCounter[thisClump] = count;
+    if (count >= simParams->sleepSteps) {
+        atomicAdd(&(granData->nSleepingOwners), 1u);
+        granData->vX[thisClump] = 0;
+        granData->vY[thisClump] = 0;
+        granData->vZ[thisClump] = 0;
+        granData->omgBarX[thisClump] = 0;
+        granData->omgBarY[thisClump] = 0;
+        granData->omgBarZ[thisClump] = 0;
+    }
+}
+
+inline __device__ void integrateOwner(deme::bodyID_t thisClump,
+                                      deme::DEMSimParams* simParams,
+                                      deme::DEMDataDT* granData,
+                                      float h) {
+    // A sleeping owner does not move, unless its family's motion is prescribed, which wakes it up
+    if (isOwnerAsleep(simParams, granData, thisClump)) {
+        if (!isFamilyMotionPrescribed(granData->familyID[thisClump])) {
+            return;
+        }
+        wakeOwnerUp(simParams, granData, thisClump);
+    }
+    // These 2 quantities mean the velocity and ang vel used for updating position/quaternion for this step.
+    // Depending on the integration scheme in use, they can be different.
+    float3 v, omgBar;
+    integrateVel(thisClump, simParams, granData, v, omgBar, h, simParams->timeElapsed);
+    integratePos(thisClump, simParams, granData, v, omgBar, h, simParams->timeElapsed);
+    if (simParams->sleepSteps > 0) {
+        updateSleepCounter(thisClump, simParams, granData);
+    }
+}
+
+// ownerSubcycled flags the owners that take substeps (null if none does); they take the first substep here
+__global__ void integrateOwners(deme::DEMSimParams* simParams,
+                                deme::DEMDataDT* granData,
+                                const deme::notStupidBool_t* ownerSubcycled) {
     deme::bodyID_t thisClump = blockIdx.x * blockDim.x + threadIdx.x;
     if (thisClump < simParams->nOwnerBodies) {
-        // These 2 quantities mean the velocity and ang vel used for updating position/quaternion for this step.
-        // Depending on the integration scheme in use, they can be different.
-        float3 v, omgBar;
-        integrateVel(thisClump, simParams, granData, v, omgBar, simParams->h, simParams->timeElapsed);
-        integratePos(thisClump, granData, v, omgBar, simParams->h, simParams->timeElapsed);
+        float h = simParams->h;
+        if (ownerSubcycled && ownerSubcycled[thisClump]) {
+            h /= simParams->nSubsteps;
+        }
+        integrateOwner(thisClump, simParams, granData, h);
+    }
+}
+
+// The substeps (after the first one) of the owners in subcycled families. simParams->h and simParams->timeElapsed are
+// those of the substep.
+__global__ void integrateSubcycledOwners(deme::DEMSimParams* simParams,
+                                         deme::DEMDataDT* granData,
+                                         const deme::bodyID_t* ownerIDs,
+                                         size_t n) {
+    size_t myEntry = blockIdx.x * blockDim.x + threadIdx.x;
+    if (myEntry < n) {
+        integrateOwner(ownerIDs[myEntry], simParams, granData, simParams->h);
     }
 }
@@ -1,5 +1,6 @@
 // DEM misc. kernels
 #include <DEM/Defines.h>
+#include <DEMHelperKernels.cu>
 
 __global__ void markOwnerToChange(deme::notStupidBool_t* idBool,
                                   float* ownerFactors,
@@ -74,3 +75,41 @@ __global__ void fillMarginValues(deme::DEMSimParams* simParams, deme::DEMDataKT*
         granData->marginSize[ownerID] = simParams->beta + granData->familyExtraMarginSize[my_family];
     }
 }
+
+// Flag if any owner has drifted, or grown its margin, or changed family enough since the contact candidates were found,
+// that they may now miss a contact
+__global__ void checkContactCandidateExpiry(deme::DEMSimParams* simParams,
+                                            deme::DEMDataKT* granData,
+                                            size_t* pExpired,
+                                            size_t n) {
+    size_t ownerID = blockIdx.x * blockDim.x + threadIdx.x;
+    if (ownerID < n) {
+        double X, Y, Z, refX, refY, refZ;
+        voxelIDToPosition<double, deme::voxelID_t, deme::subVoxelPos_t>(
+            X, Y, Z, granData->voxelID[ownerID], granData->locX[ownerID], granData->locY[ownerID],
+            granData->locZ[ownerID], simParams->nvXp2, simParams->nvYp2, simParams->voxelSize, simParams->l);
+        voxelIDToPosition<double, deme::voxelID_t, deme::subVoxelPos_t>(
+            refX, refY, refZ, granData->verletVoxelID[ownerID], granData->verletLocX[ownerID],
+            granData->verletLocY[ownerID], granData->verletLocZ[ownerID], simParams->nvXp2, simParams->nvYp2,
+            simParams->voxelSize, simParams->l);
+        // An owner that was wrapped in a periodic direction did not drift by a whole period
+        toClosestPeriodicImage(simParams, X, Y, Z, refX, refY, refZ);
+        double drift = ownerDriftBound<double, float>(
+            X - refX, Y - refY, Z - refZ, granData->oriQw[ownerID], granData->oriQx[ownerID], granData->oriQy[ownerID],
+            granData->oriQz[ownerID], granData->verletOriQw[ownerID], granData->verletOriQx[ownerID],
+            granData->verletOriQy[ownerID], granData->verletOriQz[ownerID], granData->verletOwnerExtent[ownerID]);
+        if (isContactCandidateExpired<double>(drift, granData->marginSize[ownerID], granData->verletMarginSize[ownerID],
+                                              granData->familyID[ownerID], granData->verletFamilyID[ownerID],
+                                              simParams->verletSkin)) {
+            *pExpired = 1;
+        }
+    }
+}
+
+// Contact candidates that are to be reused are found with half the skin added to each owner's margin
+__global__ void addSkinToMargins(deme::DEMSimParams* simParams, deme::DEMDataKT* granData, size_t n) {
+    size_t ownerID = blockIdx.x * blockDim.x + threadIdx.x;
+    if (ownerID < n) {
+        granData->marginSize[ownerID] += simParams->verletSkin / 2.f;
+    }
+}
@@ -37,5 +37,10 @@ __global__ void applyFamilyChanges(deme::DEMSimParams* simParams, deme::DEMDataD
 
         // Carry out user's instructions
         { _familyChangeRules_; }
+
+        // An owner that changed family is woken up, as the new family may move differently
+        if (granData->familyID[myOwner] != family_code) {
+            wakeOwnerUp(simParams, granData, myOwner);
+        }
     }
 }
@@ -7,7 +7,7 @@ inline __device__ void cleanUpContactForces(size_t thisContact,
                                             deme::DEMDataDT* granData) {
     const float3 zeros = make_float3(0, 0, 0);
     granData->contactForces[thisContact] = zeros;
-    granData->contactTorque_convToForce[thisContact] = zeros;
+    storeContactTorque(granData, thisContact, zeros);
 }
 
 inline __device__ void cleanUpAcc(size_t thisClump, deme::DEMSimParams* simParams, deme::DEMDataDT* granData) {
@@ -35,6 +35,57 @@ __global__ void prepareAccArrays(deme::DEMSimParams* simParams, deme::DEMDataDT*
     }
 }
 
+__global__ void prepareOwnerCntAggregates(deme::DEMSimParams* simParams, deme::DEMDataDT* granData) {
+    size_t myID = blockIdx.x * blockDim.x + threadIdx.x;
+    if (myID < simParams->nOwnerBodies) {
+        granData->ownerCntForceSum[myID] = make_float3(0, 0, 0);
+        granData->ownerCntTorqueSum[myID] = make_float3(0, 0, 0);
+        granData->ownerCntNum[myID] = 0;
+    }
+}
+
+// Flag the owners in subcycled families
+__global__ void markSubcycledOwners(deme::DEMSimParams* simParams,
+                                    deme::DEMDataDT* granData,
+                                    deme::notStupidBool_t* isSubcycled) {
+    size_t myID = blockIdx.x * blockDim.x + threadIdx.x;
+    if (myID < simParams->nOwnerBodies) {
+        isSubcycled[myID] = granData->familySubcycled[granData->familyID[myID]];
+    }
+}
+
+// Keep the accelerations that subcycled owners have before contact forces are collected (such as user-added ones), so
+// that each substep can start from them
+__global__ void stashSubcycledOwnerAcc(deme::DEMDataDT* granData,
+                                       const deme::bodyID_t* ownerIDs,
+                                       float3* acc,
+                                       float3* angAcc,
+                                       size_t n) {
+    size_t myEntry = blockIdx.x * blockDim.x + threadIdx.x;
+    if (myEntry < n) {
+        const deme::bodyID_t myOwner = ownerIDs[myEntry];
+        acc[myEntry] = make_float3(granData->aX[myOwner], granData->aY[myOwner], granData->aZ[myOwner]);
+        angAcc[myEntry] = make_float3(granData->alphaX[myOwner], granData->alphaY[myOwner], granData->alphaZ[myOwner]);
+    }
+}
+
+__global__ void restoreSubcycledOwnerAcc(deme::DEMDataDT* granData,
+                                         const deme::bodyID_t* ownerIDs,
+                                         const float3* acc,
+                                         const float3* angAcc,
+                                         size_t n) {
+    size_t myEntry = blockIdx.x * blockDim.x + threadIdx.x;
+    if (myEntry < n) {
+        const deme::bodyID_t myOwner = ownerIDs[myEntry];
+        granData->aX[myOwner] = acc[myEntry].x;
+        granData->aY[myOwner] = acc[myEntry].y;
+        granData->aZ[myOwner] = acc[myEntry].z;
+        granData->alphaX[myOwner] = angAcc[myEntry].x;
+        granData->alphaY[myOwner] = angAcc[myEntry].y;
+        granData->alphaZ[myOwner] = angAcc[myEntry].z;
+    }
+}
+
 __global__ void prepareForceArrays(deme::DEMSimParams* simParams, deme::DEMDataDT* granData, size_t nContactPairs) {
     size_t myID = blockIdx.x * blockDim.x + threadIdx.x;
     if (myID < nContactPairs) {
@@ -58,7 +109,7 @@ __global__ void rearrangeContactWildcards(deme::DEMDataDT* granData,
         } else {
             // Not a new contact, need to map it from somewhere in the old history array
             for (size_t i = 0; i < nWildcards; i++) {
-                newWildcards[nContactPairs * i + myID] = granData->contactWildcards[i][map_from];
+                newWildcards[nContactPairs * i + myID] = loadContactWildcard(granData, i, map_from);
             }
             // This sentry trys to make sure that all `alive' contacts got mapped to some place
             sentry[map_from] = 0;
@@ -66,10 +117,25 @@ __global__ void rearrangeContactWildcards(deme::DEMDataDT* granData,
     }
 }
 
-__global__ void markAliveContacts(float* wildcard, deme::notStupidBool_t* sentry, size_t nContactPairs) {
+__global__ void storeRearrangedContactWildcards(deme::DEMDataDT* granData,
+                                               float* newWildcards,
+                                               unsigned int nWildcards,
+                                               size_t nContactPairs) {
+    size_t myID = blockIdx.x * blockDim.x + threadIdx.x;
+    if (myID < nContactPairs) {
+        for (unsigned int i = 0; i < nWildcards; i++) {
+            storeContactWildcard(granData, i, myID, newWildcards[nContactPairs * i + myID]);
+        }
+    }
+}
+
+__global__ void markAliveContacts(deme::DEMDataDT* granData,
+                                  unsigned int wcNum,
+                                  deme::notStupidBool_t* sentry,
+                                  size_t nContactPairs) {
     size_t myID = blockIdx.x * blockDim.x + threadIdx.x;
     if (myID < nContactPairs) {
-        float myEntry = abs(wildcard[myID]);
+        float myEntry = abs(loadContactWildcard(granData, wcNum, myID));
         // If this is alive then mark it
         if (myEntry > DEME_TINY_FLOAT) {
             sentry[myID] = 1;